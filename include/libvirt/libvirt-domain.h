@@ -2740,6 +2740,7 @@ typedef enum {
     VIR_DOMAIN_STATS_MEMORY = (1 << 8), /* return domain memory info (Since: 6.0.0) */
     VIR_DOMAIN_STATS_DIRTYRATE = (1 << 9), /* return domain dirty rate info (Since: 7.2.0) */
     VIR_DOMAIN_STATS_VM = (1 << 10), /* return vm info (Since: 8.9.0) */
+    VIR_DOMAIN_STATS_XML = (1 << 11), /* return domain XML (Since: 10.2.0) */
 } virDomainStatsTypes;
 
 /**
@@ -5593,6 +5594,17 @@ typedef void (*virConnectDomainEventJobCompletedCallback)(virConnectPtr conn,
  */
 # define VIR_DOMAIN_TUNABLE_BLKDEV_WRITE_IOPS_SEC_MAX_LENGTH "blkdeviotune.write_iops_sec_max_length"
 
+/**
+ * VIR_DOMAIN_TUNABLE_NUMA_NODESET:
+ *
+ * Macro represents the host NUMA nodes the domain memory is allowed to be
+ * allocated from, as VIR_TYPED_PARAM_STRING. It is reported when the nodes
+ * of a domain with automatic NUMA placement change at runtime.
+ *
+ * Since: 10.2.0
+ */
+# define VIR_DOMAIN_TUNABLE_NUMA_NODESET "numatune.nodeset"
+
 /**
  * virConnectDomainEventTunableCallback:
  * @conn: connection object
@@ -453,6 +453,39 @@ struct _virNodeMemoryStats {
  */
 # define VIR_NODE_MEMORY_SHARED_MERGE_ACROSS_NODES "shm_merge_across_nodes"
 
+/*
+ * VIR_NODE_MEMORY_HUGEPAGES_RESERVED:
+ *
+ * Macro for typed parameter that represents the amount of huge page
+ * memory, in KiB, reserved for domains which are being started. The
+ * parameter has type unsigned long long. Read-only.
+ *
+ * Since: 10.2.0
+ */
+# define VIR_NODE_MEMORY_HUGEPAGES_RESERVED        "hugepages_reserved"
+
+/*
+ * VIR_NODE_MEMORY_HUGEPAGES_RESERVATIONS:
+ *
+ * Macro for typed parameter that represents the number of domains
+ * being started which hold a huge page reservation. The parameter
+ * has type unsigned int. Read-only.
+ *
+ * Since: 10.2.0
+ */
+# define VIR_NODE_MEMORY_HUGEPAGES_RESERVATIONS    "hugepages_reservations"
+
+/*
+ * VIR_NODE_MEMORY_HUGEPAGES_GROWN:
+ *
+ * Macro for typed parameter that represents the amount of memory, in
+ * KiB, added to the host huge page pools to satisfy reservations. The
+ * parameter has type unsigned long long. Read-only.
+ *
+ * Since: 10.2.0
+ */
+# define VIR_NODE_MEMORY_HUGEPAGES_GROWN           "hugepages_grown"
+
 
 int virNodeGetMemoryParameters(virConnectPtr conn,
                                virTypedParameterPtr params,
@@ -1431,6 +1431,197 @@ virCapabilitiesHostNUMAGetMaxNode(virCapsHostNUMA *caps)
 }
 
 
+static unsigned int
+virCapabilitiesHostNUMACellDistance(virCapsHostNUMACell *cell,
+                                    int node)
+{
+    size_t i;
+
+    for (i = 0; i < cell->ndistances; i++) {
+        if (cell->distances[i].cellid == node)
+            return cell->distances[i].value;
+    }
+
+    /* Same defaults as the kernel uses when ACPI SLIT is missing */
+    return cell->num == node ? 10 : 20;
+}
+
+
+typedef struct _virCapsHostNUMAPlacement virCapsHostNUMAPlacement;
+struct _virCapsHostNUMAPlacement {
+    unsigned int maxDistance;
+    size_t nnodes;
+    unsigned long long memFree;
+    unsigned long long ncpus;
+    unsigned long long load; /* vCPUs after placing the domain */
+};
+
+
+/* Returns true if @a is a better placement than @b */
+static bool
+virCapabilitiesHostNUMAPlacementIsBetter(const virCapsHostNUMAPlacement *a,
+                                         const virCapsHostNUMAPlacement *b)
+{
+    if (a->maxDistance != b->maxDistance)
+        return a->maxDistance < b->maxDistance;
+
+    if (a->nnodes != b->nnodes)
+        return a->nnodes < b->nnodes;
+
+    /* Compare a->load / a->ncpus and b->load / b->ncpus */
+    if (a->load * b->ncpus != b->load * a->ncpus)
+        return a->load * b->ncpus < b->load * a->ncpus;
+
+    return a->memFree > b->memFree;
+}
+
+
+/**
+ * virCapabilitiesHostNUMAPlace:
+ * @caps: host NUMA topology
+ * @status: per node state, indexed by NUMA node number
+ * @nstatus: number of items in @status
+ * @vcpus: number of vCPUs of the domain
+ * @memory: memory of the domain in KiB
+ *
+ * Select host NUMA nodes for a domain with automatic placement. For each
+ * node that has free memory, a group is formed by adding the nearest nodes
+ * (according to the distances reported by the host) until the group has
+ * enough free memory and enough CPUs for all vCPUs of the domain. Of all
+ * groups the one with the shortest distance between its members wins; ties
+ * are broken by the number of nodes in the group and then by the vCPU load
+ * of the group once the domain is placed there.
+ *
+ * If no group can hold the vCPUs without overcommitting host CPUs, only
+ * memory is considered. If the memory does not fit into any group either,
+ * all nodes are returned.
+ *
+ * Returns: the selected nodeset on success,
+ *          NULL on error.
+ */
+virBitmap *
+virCapabilitiesHostNUMAPlace(virCapsHostNUMA *caps,
+                             const virCapsHostNUMANodeStatus *status,
+                             size_t nstatus,
+                             unsigned int vcpus,
+                             unsigned long long memory)
+{
+    size_t ncells = caps->cells->len;
+    int maxnode;
+    g_autofree virCapsHostNUMACell **group = NULL;
+    g_autofree bool *used = NULL;
+    g_autoptr(virBitmap) best = NULL;
+    virCapsHostNUMAPlacement bestPlacement = { 0 };
+    size_t pass;
+    size_t i;
+
+    if (ncells == 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Host NUMA topology is not available"));
+        return NULL;
+    }
+
+    maxnode = virCapabilitiesHostNUMAGetMaxNode(caps);
+    group = g_new0(virCapsHostNUMACell *, ncells);
+    used = g_new0(bool, ncells);
+
+    /* The first pass requires enough CPUs for all vCPUs, the second one
+     * considers memory only. */
+    for (pass = 0; pass < 2 && !best; pass++) {
+        for (i = 0; i < ncells; i++) {
+            virCapsHostNUMACell *seed = g_ptr_array_index(caps->cells, i);
+            virCapsHostNUMAPlacement placement = { 0 };
+            size_t ngroup = 0;
+            size_t j;
+
+            if (seed->num < 0 || (size_t) seed->num >= nstatus ||
+                status[seed->num].memFree == 0)
+                continue;
+
+            memset(used, 0, sizeof(*used) * ncells);
+            placement.load = vcpus;
+
+            while (ngroup < ncells) {
+                virCapsHostNUMACell *next = NULL;
+                size_t nextIdx = 0;
+                unsigned int nextDistance = 0;
+                size_t k;
+
+                /* Pick the nearest node not in the group yet */
+                for (j = 0; j < ncells; j++) {
+                    virCapsHostNUMACell *cell = g_ptr_array_index(caps->cells, j);
+                    unsigned int distance;
+
+                    if (used[j])
+                        continue;
+
+                    distance = virCapabilitiesHostNUMACellDistance(seed, cell->num);
+                    if (cell == seed)
+                        distance = 0;
+
+                    if (!next || distance < nextDistance) {
+                        next = cell;
+                        nextIdx = j;
+                        nextDistance = distance;
+                    }
+                }
+
+                used[nextIdx] = true;
+
+                for (k = 0; k < ngroup; k++) {
+                    unsigned int distance;
+
+                    distance = virCapabilitiesHostNUMACellDistance(group[k], next->num);
+                    placement.maxDistance = MAX(placement.maxDistance, distance);
+                }
+
+                group[ngroup++] = next;
+                placement.ncpus += next->ncpus;
+                if (next->num >= 0 && (size_t) next->num < nstatus) {
+                    placement.memFree += status[next->num].memFree;
+                    placement.load += status[next->num].vcpus;
+                }
+
+                if (placement.memFree >= memory &&
+                    (pass > 0 || placement.ncpus >= vcpus))
+                    break;
+            }
+
+            if (placement.memFree < memory ||
+                (pass == 0 && placement.ncpus < vcpus))
+                continue;
+
+            placement.nnodes = ngroup;
+
+            if (best &&
+                !virCapabilitiesHostNUMAPlacementIsBetter(&placement,
+                                                          &bestPlacement))
+                continue;
+
+            g_clear_pointer(&best, virBitmapFree);
+            best = virBitmapNew(maxnode + 1);
+            for (j = 0; j < ngroup; j++)
+                ignore_value(virBitmapSetBit(best, group[j]->num));
+            bestPlacement = placement;
+        }
+    }
+
+    if (!best) {
+        VIR_WARN("Not enough free memory on any group of host NUMA nodes, "
+                 "placing domain on all nodes");
+
+        best = virBitmapNew(maxnode + 1);
+        for (i = 0; i < ncells; i++) {
+            virCapsHostNUMACell *cell = g_ptr_array_index(caps->cells, i);
+
+            ignore_value(virBitmapSetBit(best, cell->num));
+        }
+    }
+
+    return g_steal_pointer(&best);
+}
+
+
 int
 virCapabilitiesGetNodeInfo(virNodeInfoPtr nodeinfo)
 {
@@ -332,6 +332,19 @@ virBitmap *virCapabilitiesHostNUMAGetCpus(virCapsHostNUMA *caps,
 
 int virCapabilitiesHostNUMAGetMaxNode(virCapsHostNUMA *caps);
 
+typedef struct _virCapsHostNUMANodeStatus virCapsHostNUMANodeStatus;
+struct _virCapsHostNUMANodeStatus {
+    unsigned long long memFree; /* free memory of the kind the domain will
+                                   use (regular or huge pages) in KiB */
+    unsigned int vcpus; /* vCPUs of other domains placed on the node */
+};
+
+virBitmap *virCapabilitiesHostNUMAPlace(virCapsHostNUMA *caps,
+                                        const virCapsHostNUMANodeStatus *status,
+                                        size_t nstatus,
+                                        unsigned int vcpus,
+                                        unsigned long long memory);
+
 int virCapabilitiesGetNodeInfo(virNodeInfoPtr nodeinfo);
 
 int virCapabilitiesInitPages(virCaps *caps);
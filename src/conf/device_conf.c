@@ -141,6 +141,24 @@ virDomainDeviceInfoClear(virDomainDeviceInfo *info)
     info->isolationGroupLocked = false;
 }
 
+/**
+ * virDomainDeviceInfoCopy:
+ * @dst: device info to fill
+ * @src: device info to copy
+ *
+ * Deep-copies @src into @dst. Any previous contents of @dst are
+ * overwritten without being freed.
+ */
+void
+virDomainDeviceInfoCopy(virDomainDeviceInfo *dst,
+                        const virDomainDeviceInfo *src)
+{
+    *dst = *src;
+    dst->alias = g_strdup(src->alias);
+    dst->romfile = g_strdup(src->romfile);
+    dst->loadparm = g_strdup(src->loadparm);
+}
+
 void
 virDomainDeviceInfoFree(virDomainDeviceInfo *info)
 {
@@ -197,6 +197,8 @@ void virDeviceHostdevPCIDriverInfoPostParse(virDeviceHostdevPCIDriverInfo *drive
 void virDeviceHostdevPCIDriverInfoClear(virDeviceHostdevPCIDriverInfo *driver);
 
 void virDomainDeviceInfoClear(virDomainDeviceInfo *info);
+void virDomainDeviceInfoCopy(virDomainDeviceInfo *dst,
+                             const virDomainDeviceInfo *src);
 void virDomainDeviceInfoFree(virDomainDeviceInfo *info);
 
 bool virDomainDeviceInfoAddressIsEqual(const virDomainDeviceInfo *a,
@@ -1543,8 +1543,10 @@ VIR_ENUM_IMPL(virDomainChrSourceMode,
 
 
 static virClass *virDomainObjClass;
+static virClass *virDomainObjViewClass;
 static virClass *virDomainXMLOptionClass;
 static void virDomainObjDispose(void *obj);
+static void virDomainObjViewDispose(void *obj);
 static void virDomainXMLOptionDispose(void *obj);
 
 
@@ -1556,15 +1558,11 @@ virDomainChrSourceDefFormat(virBuffer *buf,
 
 static int
 virDomainChrSourceReconnectDefParseXML(virDomainChrSourceReconnectDef *def,
-                                       xmlNodePtr node,
-                                       xmlXPathContextPtr ctxt)
+                                       xmlNodePtr node)
 {
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     xmlNodePtr cur;
 
-    ctxt->node = node;
-
-    if ((cur = virXPathNode("./reconnect", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "reconnect"))) {
         if (virXMLPropTristateBool(cur, "enabled", VIR_XML_PROP_NONE,
                                    &def->enabled) < 0)
             return -1;
@@ -1585,6 +1583,9 @@ static int virDomainObjOnceInit(void)
     if (!VIR_CLASS_NEW(virDomainObj, virClassForObjectLockable()))
         return -1;
 
+    if (!VIR_CLASS_NEW(virDomainObjView, virClassForObject()))
+        return -1;
+
     if (!VIR_CLASS_NEW(virDomainXMLOption, virClassForObject()))
         return -1;
 
@@ -1801,6 +1802,24 @@ virDomainXMLOptionSetCloseCallbackAlloc(virDomainXMLOption *xmlopt,
 }
 
 
+/**
+ * virDomainXMLOptionSetObjViews:
+ * @xmlopt: XML parser configuration
+ * @enable: whether to publish views
+ *
+ * Makes domain objects created with @xmlopt publish read-only views of
+ * their definition and state, see virDomainObjGetView. Drivers which don't
+ * serve any API from views shouldn't enable them as publishing a view
+ * copies the definition.
+ */
+void
+virDomainXMLOptionSetObjViews(virDomainXMLOption *xmlopt,
+                              bool enable)
+{
+    xmlopt->objViews = enable;
+}
+
+
 void
 virDomainXMLOptionSetMomentPostParse(virDomainXMLOption *xmlopt,
                                      virDomainMomentPostParseCallback cb)
@@ -2960,8 +2979,8 @@ virDomainChrSourceDefClear(virDomainChrSourceDef *def)
     VIR_FREE(def->logfile);
 }
 
-/* Almost deep copies the contents of src into dest. Some parts are not copied
- * though. */
+/* Deep copies the contents of src into dest. The private data and security
+ * labels are not copied though. */
 void
 virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
                           const virDomainChrSourceDef *src)
@@ -2992,7 +3011,10 @@ virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
     case VIR_DOMAIN_CHR_TYPE_TCP:
         dest->data.tcp.host = g_strdup(src->data.tcp.host);
         dest->data.tcp.service = g_strdup(src->data.tcp.service);
+        dest->data.tcp.listen = src->data.tcp.listen;
+        dest->data.tcp.protocol = src->data.tcp.protocol;
 
+        dest->data.tcp.tlscreds = src->data.tcp.tlscreds;
         dest->data.tcp.haveTLS = src->data.tcp.haveTLS;
         dest->data.tcp.tlsFromConfig = src->data.tcp.tlsFromConfig;
 
@@ -3002,6 +3024,7 @@ virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
 
     case VIR_DOMAIN_CHR_TYPE_UNIX:
         dest->data.nix.path = g_strdup(src->data.nix.path);
+        dest->data.nix.listen = src->data.nix.listen;
 
         dest->data.nix.reconnect.enabled = src->data.nix.reconnect.enabled;
         dest->data.nix.reconnect.timeout = src->data.nix.reconnect.timeout;
@@ -4086,6 +4109,9 @@ static void virDomainObjDispose(void *obj)
     virDomainCheckpointObjListFree(dom->checkpoints);
     virDomainJobObjFree(dom->job);
     virObjectUnref(dom->closecallbacks);
+    virObjectUnref(dom->view);
+    virObjectUnref(dom->xmlopt);
+    virMutexDestroy(&dom->viewLock);
 }
 
 virDomainObj *
@@ -4105,6 +4131,15 @@ virDomainObjNew(virDomainXMLOption *xmlopt)
         goto error;
     }
 
+    if (virMutexInit(&domain->viewLock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("failed to initialize domain view mutex"));
+        goto error;
+    }
+
+    if (xmlopt->objViews)
+        domain->xmlopt = virObjectRef(xmlopt);
+
     if (xmlopt->privateData.alloc) {
         domain->privateData = (xmlopt->privateData.alloc)(xmlopt->config.priv);
         if (!domain->privateData)
@@ -4169,6 +4204,8 @@ void virDomainObjAssignDef(virDomainObj *domain,
                            bool live,
                            virDomainDef **oldDef)
 {
+    virDomainObjInvalidateView(domain);
+
     if (oldDef)
         *oldDef = NULL;
     if (virDomainObjIsActive(domain)) {
@@ -4215,6 +4252,10 @@ virDomainObjEndAPI(virDomainObj **vm)
     if (!*vm)
         return;
 
+    /* republish the view dropped by changes made since the last job */
+    if (!(*vm)->view)
+        virDomainObjPublishView(*vm);
+
     virObjectUnlock(*vm);
     g_clear_pointer(vm, virObjectUnref);
 }
@@ -4309,6 +4350,8 @@ virDomainObjRemoveTransientDef(virDomainObj *domain)
     if (!domain->newDef)
         return;
 
+    virDomainObjInvalidateView(domain);
+
     virDomainDefFree(domain->def);
     domain->def = g_steal_pointer(&domain->newDef);
     domain->def->id = -1;
@@ -5663,10 +5706,21 @@ virDomainDeviceAliasIsUserAlias(const char *aliasStr)
 }
 
 
+/* Whether the inactive XML parser keeps @aliasStr */
+static bool
+virDomainDeviceAliasIsValidUserAlias(virDomainXMLOption *xmlopt,
+                                     const char *aliasStr)
+{
+    return xmlopt->config.features & VIR_DOMAIN_DEF_FEATURE_USER_ALIAS &&
+           virDomainDeviceAliasIsUserAlias(aliasStr) &&
+           strspn(aliasStr, USER_ALIAS_CHARS) == strlen(aliasStr);
+}
+
+
 static int
 virDomainDeviceInfoParseXML(virDomainXMLOption *xmlopt,
                             xmlNodePtr node,
-                            xmlXPathContextPtr ctxt,
+                            xmlXPathContextPtr ctxt G_GNUC_UNUSED,
                             virDomainDeviceInfo *info,
                             unsigned int flags)
 {
@@ -5677,32 +5731,28 @@ virDomainDeviceInfoParseXML(virDomainXMLOption *xmlopt,
     xmlNodePtr rom = NULL;
     int ret = -1;
     g_autofree char *aliasStr = NULL;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
 
     virDomainDeviceInfoClear(info);
-    ctxt->node = node;
 
-    if ((aliasStr = virXPathString("string(./alias/@name)", ctxt)))
+    if ((aliasStr = virXMLNodeGetSubelementProp(node, "alias", "name")))
         if (!(flags & VIR_DOMAIN_DEF_PARSE_INACTIVE) ||
-            (xmlopt->config.features & VIR_DOMAIN_DEF_FEATURE_USER_ALIAS &&
-             virDomainDeviceAliasIsUserAlias(aliasStr) &&
-             strspn(aliasStr, USER_ALIAS_CHARS) == strlen(aliasStr)))
+            virDomainDeviceAliasIsValidUserAlias(xmlopt, aliasStr))
             info->alias = g_steal_pointer(&aliasStr);
 
-    if ((master = virXPathNode("./master", ctxt))) {
+    if ((master = virXMLNodeGetSubelement(node, "master"))) {
         info->mastertype = VIR_DOMAIN_CONTROLLER_MASTER_USB;
         if (virDomainDeviceUSBMasterParseXML(master, &info->master.usb) < 0)
             goto cleanup;
     }
 
     if (flags & VIR_DOMAIN_DEF_PARSE_ALLOW_BOOT &&
-        (boot = virXPathNode("./boot", ctxt))) {
+        (boot = virXMLNodeGetSubelement(node, "boot"))) {
         if (virDomainDeviceBootParseXML(boot, info))
             goto cleanup;
     }
 
     if ((flags & VIR_DOMAIN_DEF_PARSE_ALLOW_ROM) &&
-        (rom = virXPathNode("./rom", ctxt))) {
+        (rom = virXMLNodeGetSubelement(node, "rom"))) {
         if (virXMLPropTristateBool(rom, "enabled", VIR_XML_PROP_NONE,
                                    &info->romenabled) < 0)
             goto cleanup;
@@ -5721,13 +5771,13 @@ virDomainDeviceInfoParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if ((acpi = virXPathNode("./acpi", ctxt))) {
+    if ((acpi = virXMLNodeGetSubelement(node, "acpi"))) {
         if (virXMLPropUInt(acpi, "index", 10, VIR_XML_PROP_NONZERO,
                            &info->acpiIndex) < 0)
             goto cleanup;
     }
 
-    if ((address = virXPathNode("./address", ctxt)) &&
+    if ((address = virXMLNodeGetSubelement(node, "address")) &&
         virDomainDeviceAddressParseXML(address, info) < 0)
         goto cleanup;
 
@@ -5741,7 +5791,6 @@ virDomainDeviceInfoParseXML(virDomainXMLOption *xmlopt,
 
 static int
 virDomainHostdevSubsysUSBDefParseXML(xmlNodePtr node,
-                                     xmlXPathContextPtr ctxt,
                                      virDomainHostdevDef *def)
 {
     virDomainHostdevSubsysUSB *usbsrc = &def->source.subsys.u.usb;
@@ -5749,9 +5798,6 @@ virDomainHostdevSubsysUSBDefParseXML(xmlNodePtr node,
     xmlNodePtr productNode;
     xmlNodePtr addressNode;
     virTristateBool autoAddress;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = node;
 
     if (virXMLPropEnum(node, "startupPolicy",
                        virDomainStartupPolicyTypeFromString,
@@ -5770,8 +5816,8 @@ virDomainHostdevSubsysUSBDefParseXML(xmlNodePtr node,
 
     /* Product can validly be 0, so we need some extra help to determine
      * if it is uninitialized */
-    vendorNode = virXPathNode("./vendor", ctxt);
-    productNode = virXPathNode("./product", ctxt);
+    vendorNode = virXMLNodeGetSubelement(node, "vendor");
+    productNode = virXMLNodeGetSubelement(node, "product");
 
     if (vendorNode) {
         if (virXMLPropUInt(vendorNode, "id", 0,
@@ -5798,7 +5844,7 @@ virDomainHostdevSubsysUSBDefParseXML(xmlNodePtr node,
         }
     }
 
-    if ((addressNode = virXPathNode("./address", ctxt))) {
+    if ((addressNode = virXMLNodeGetSubelement(node, "address"))) {
         if (virXMLPropUInt(addressNode, "bus", 0,
                            VIR_XML_PROP_REQUIRED, &usbsrc->bus) < 0)
             return -1;
@@ -5814,46 +5860,43 @@ virDomainHostdevSubsysUSBDefParseXML(xmlNodePtr node,
 
 static int
 virDomainHostdevSubsysPCIDefParseXML(xmlNodePtr node,
-                                     xmlXPathContextPtr ctxt,
                                      virDomainHostdevDef *def,
                                      unsigned int flags)
 {
     xmlNodePtr address = NULL;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = node;
 
     if (virXMLPropTristateBool(node, "writeFiltering",
                                VIR_XML_PROP_NONE,
                                &def->writeFiltering) < 0)
         return -1;
 
-    if ((address = virXPathNode("./address", ctxt)) &&
+    if ((address = virXMLNodeGetSubelement(node, "address")) &&
         virPCIDeviceAddressParseXML(address, &def->source.subsys.u.pci.addr) < 0)
         return -1;
 
     if ((flags & VIR_DOMAIN_DEF_PARSE_PCI_ORIG_STATES)) {
         virDomainHostdevSubsysPCI *pcisrc = &def->source.subsys.u.pci;
-        g_autofree xmlNodePtr *nodes = NULL;
-        ssize_t nnodes;
+        xmlNodePtr origstates = virXMLNodeGetSubelement(node, "origstates");
+        g_autoptr(GPtrArray) nodes = NULL;
         size_t i;
 
-        if ((nnodes = virXPathNodeSet("./origstates/*", ctxt, &nodes)) < 0)
-            return -1;
+        if (origstates)
+            nodes = virXMLNodeGetSubelementList(origstates, NULL);
 
-        if (nnodes > 0) {
+        if (nodes && nodes->len > 0) {
             if (!pcisrc->origstates)
                 pcisrc->origstates = virBitmapNew(VIR_DOMAIN_HOSTDEV_PCI_ORIGSTATE_LAST);
             else
                 virBitmapClearAll(pcisrc->origstates);
 
-            for (i = 0; i < nnodes; i++) {
+            for (i = 0; i < nodes->len; i++) {
+                xmlNodePtr cur = g_ptr_array_index(nodes, i);
                 int state;
 
-                if ((state = virDomainHostdevPCIOrigstateTypeFromString((const char *) nodes[i]->name)) < 0) {
+                if ((state = virDomainHostdevPCIOrigstateTypeFromString((const char *) cur->name)) < 0) {
                     virReportError(VIR_ERR_INTERNAL_ERROR,
                                    _("unsupported element '%1$s' of 'origstates'"),
-                                   (const char *) nodes[i]->name);
+                                   (const char *) cur->name);
                     return -1;
                 }
 
@@ -5979,9 +6022,7 @@ virDomainHostdevSubsysSCSIHostDefParseXML(xmlNodePtr sourcenode,
     xmlNodePtr addressnode = NULL;
     VIR_XPATH_NODE_AUTORESTORE(ctxt)
 
-    ctxt->node = sourcenode;
-
-    if (!(addressnode = virXPathNode("./address", ctxt))) {
+    if (!(addressnode = virXMLNodeGetSubelement(sourcenode, "address"))) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("'address' must be specified for scsi hostdev source"));
         return -1;
@@ -5999,7 +6040,7 @@ virDomainHostdevSubsysSCSIHostDefParseXML(xmlNodePtr sourcenode,
                             &scsihostsrc->unit) < 0)
         return -1;
 
-    if (!(scsihostsrc->adapter = virXPathString("string(./adapter/@name)", ctxt))) {
+    if (!(scsihostsrc->adapter = virXMLNodeGetSubelementProp(sourcenode, "adapter", "name"))) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("'adapter' name must be specified for scsi hostdev source"));
         return -1;
@@ -6007,7 +6048,7 @@ virDomainHostdevSubsysSCSIHostDefParseXML(xmlNodePtr sourcenode,
 
     if (flags & VIR_DOMAIN_DEF_PARSE_STATUS &&
         xmlopt && xmlopt->privateData.storageParse) {
-        if ((ctxt->node = virXPathNode("./privateData", ctxt))) {
+        if ((ctxt->node = virXMLNodeGetSubelement(sourcenode, "privateData"))) {
             if (!scsihostsrc->src)
                 scsihostsrc->src = virStorageSourceNew();
             if (xmlopt->privateData.storageParse(ctxt, scsihostsrc->src) < 0)
@@ -6060,7 +6101,7 @@ virDomainHostdevSubsysSCSIiSCSIDefParseXML(xmlNodePtr sourcenode,
         return -1;
     }
 
-    if ((node = virXPathNode("./auth", ctxt))) {
+    if ((node = virXMLNodeGetSubelement(sourcenode, "auth"))) {
         if (!(authdef = virStorageAuthDefParse(node, ctxt)))
             return -1;
         if ((auth_secret_usage = virSecretUsageTypeFromString(authdef->secrettype)) < 0) {
@@ -6082,7 +6123,7 @@ virDomainHostdevSubsysSCSIiSCSIDefParseXML(xmlNodePtr sourcenode,
 
     if (flags & VIR_DOMAIN_DEF_PARSE_STATUS &&
         xmlopt && xmlopt->privateData.storageParse) {
-        if ((ctxt->node = virXPathNode("./privateData", ctxt)) &&
+        if ((ctxt->node = virXMLNodeGetSubelement(sourcenode, "privateData")) &&
             xmlopt->privateData.storageParse(ctxt, iscsisrc->src) < 0)
             return -1;
     }
@@ -6165,14 +6206,14 @@ virDomainHostdevSubsysSCSIVHostDefParseXML(xmlNodePtr sourcenode,
 
 static int
 virDomainHostdevSubsysMediatedDevDefParseXML(virDomainHostdevDef *def,
-                                             xmlXPathContextPtr ctxt)
+                                             xmlNodePtr sourcenode)
 {
     unsigned char uuid[VIR_UUID_BUFLEN] = {0};
     xmlNodePtr node = NULL;
     virDomainHostdevSubsysMediatedDev *mdevsrc = &def->source.subsys.u.mdev;
     g_autofree char *uuidxml = NULL;
 
-    if (!(node = virXPathNode("./source/address", ctxt))) {
+    if (!(node = virXMLNodeGetSubelement(sourcenode, "address"))) {
         virReportError(VIR_ERR_CONFIG_UNSUPPORTED, "%s",
                        _("Missing <address> element"));
         return -1;
@@ -6211,6 +6252,7 @@ virDomainHostdevDefParseXMLSubsys(xmlNodePtr node,
     virDomainHostdevSubsysMediatedDev *mdevsrc = &def->source.subsys.u.mdev;
     virTristateBool managed;
     g_autofree char *model = NULL;
+    g_autofree char *startupPolicy = NULL;
     int rv;
 
     /* @managed can be read from the xml document - it is always an
@@ -6234,14 +6276,14 @@ virDomainHostdevDefParseXMLSubsys(xmlNodePtr node,
      */
     def->source.subsys.type = type;
 
-    if (!(sourcenode = virXPathNode("./source", ctxt))) {
+    if (!(sourcenode = virXMLNodeGetSubelement(node, "source"))) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("Missing <source> element in hostdev device"));
         return -1;
     }
 
     if (def->source.subsys.type != VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_USB &&
-        virXPathBoolean("boolean(./source/@startupPolicy)", ctxt)) {
+        (startupPolicy = virXMLPropString(sourcenode, "startupPolicy"))) {
         virReportError(VIR_ERR_CONFIG_UNSUPPORTED, "%s",
                        _("Setting startupPolicy is only allowed for USB devices"));
         return -1;
@@ -6310,17 +6352,17 @@ virDomainHostdevDefParseXMLSubsys(xmlNodePtr node,
 
     switch (def->source.subsys.type) {
     case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_PCI:
-        if (virDomainHostdevSubsysPCIDefParseXML(sourcenode, ctxt, def, flags) < 0)
+        if (virDomainHostdevSubsysPCIDefParseXML(sourcenode, def, flags) < 0)
             return -1;
 
-        if ((driver_node = virXPathNode("./driver", ctxt)) &&
+        if ((driver_node = virXMLNodeGetSubelement(node, "driver")) &&
             virDeviceHostdevPCIDriverInfoParseXML(driver_node, &pcisrc->driver) < 0) {
             return -1;
         }
         break;
 
     case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_USB:
-        if (virDomainHostdevSubsysUSBDefParseXML(sourcenode, ctxt, def) < 0)
+        if (virDomainHostdevSubsysUSBDefParseXML(sourcenode, def) < 0)
             return -1;
         break;
 
@@ -6334,7 +6376,7 @@ virDomainHostdevDefParseXMLSubsys(xmlNodePtr node,
             return -1;
         break;
     case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_MDEV:
-        if (virDomainHostdevSubsysMediatedDevDefParseXML(def, ctxt) < 0)
+        if (virDomainHostdevSubsysMediatedDevDefParseXML(def, sourcenode) < 0)
             return -1;
         break;
 
@@ -6517,11 +6559,13 @@ virDomainNetDefCoalesceFormatXML(virBuffer *buf,
 
 
 static int
-virDomainHostdevDefParseXMLCaps(xmlNodePtr node G_GNUC_UNUSED,
+virDomainHostdevDefParseXMLCaps(xmlNodePtr node,
                                 xmlXPathContextPtr ctxt,
                                 virDomainHostdevCapsType type,
                                 virDomainHostdevDef *def)
 {
+    xmlNodePtr sourcenode;
+
     /* @type is passed in from the caller rather than read from the
      * xml document, because it is specified in different places for
      * different kinds of defs - it is an attribute of
@@ -6532,7 +6576,7 @@ virDomainHostdevDefParseXMLCaps(xmlNodePtr node G_GNUC_UNUSED,
      */
     def->source.caps.type = type;
 
-    if (!virXPathNode("./source", ctxt)) {
+    if (!(sourcenode = virXMLNodeGetSubelement(node, "source"))) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("Missing <source> element in hostdev device"));
         return -1;
@@ -6541,7 +6585,7 @@ virDomainHostdevDefParseXMLCaps(xmlNodePtr node G_GNUC_UNUSED,
     switch (def->source.caps.type) {
     case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_STORAGE:
         if (!(def->source.caps.u.storage.block =
-              virXPathString("string(./source/block[1])", ctxt))) {
+              virXMLNodeGetSubelementContent(sourcenode, "block"))) {
             virReportError(VIR_ERR_XML_ERROR, "%s",
                            _("Missing <block> element in hostdev storage device"));
             return -1;
@@ -6549,7 +6593,7 @@ virDomainHostdevDefParseXMLCaps(xmlNodePtr node G_GNUC_UNUSED,
         break;
     case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_MISC:
         if (!(def->source.caps.u.misc.chardev =
-              virXPathString("string(./source/char[1])", ctxt))) {
+              virXMLNodeGetSubelementContent(sourcenode, "char"))) {
             virReportError(VIR_ERR_XML_ERROR, "%s",
                            _("Missing <char> element in hostdev character device"));
             return -1;
@@ -6557,12 +6601,12 @@ virDomainHostdevDefParseXMLCaps(xmlNodePtr node G_GNUC_UNUSED,
         break;
     case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_NET:
         if (!(def->source.caps.u.net.ifname =
-              virXPathString("string(./source/interface[1])", ctxt))) {
+              virXMLNodeGetSubelementContent(sourcenode, "interface"))) {
             virReportError(VIR_ERR_XML_ERROR, "%s",
                            _("Missing <interface> element in hostdev net device"));
             return -1;
         }
-        if (virDomainNetIPInfoParseXML(_("Domain hostdev device"), NULL,
+        if (virDomainNetIPInfoParseXML(_("Domain hostdev device"), node,
                                        ctxt, &def->source.caps.u.net.ip) < 0)
             return -1;
         break;
@@ -7325,8 +7369,7 @@ virDomainDiskSourceNVMeParse(xmlNodePtr node,
 static int
 virDomainDiskSourceVHostUserParse(xmlNodePtr node,
                                   virStorageSource *src,
-                                  virDomainXMLOption *xmlopt,
-                                  xmlXPathContextPtr ctxt)
+                                  virDomainXMLOption *xmlopt)
 {
     g_autofree char *type = virXMLPropString(node, "type");
     g_autofree char *path = virXMLPropString(node, "path");
@@ -7356,8 +7399,7 @@ virDomainDiskSourceVHostUserParse(xmlNodePtr node,
     src->vhostuser->data.nix.path = g_steal_pointer(&path);
 
     if (virDomainChrSourceReconnectDefParseXML(&src->vhostuser->data.nix.reconnect,
-                                               node,
-                                               ctxt) < 0) {
+                                               node) < 0) {
         return -1;
     }
 
@@ -7531,7 +7573,7 @@ virDomainStorageSourceParse(xmlNodePtr node,
             return -1;
         break;
     case VIR_STORAGE_TYPE_VHOST_USER:
-        if (virDomainDiskSourceVHostUserParse(node, src, xmlopt, ctxt) < 0)
+        if (virDomainDiskSourceVHostUserParse(node, src, xmlopt) < 0)
             return -1;
         break;
     case VIR_STORAGE_TYPE_VHOST_VDPA:
@@ -8077,7 +8119,7 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
                        VIR_XML_PROP_NONZERO, &def->sgio) < 0)
         return NULL;
 
-    if ((sourceNode = virXPathNode("./source", ctxt))) {
+    if ((sourceNode = virXMLNodeGetSubelement(node, "source"))) {
         if (virXMLPropEnum(sourceNode, "startupPolicy",
                            virDomainStartupPolicyTypeFromString,
                            VIR_XML_PROP_NONZERO,
@@ -8085,7 +8127,7 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((targetNode = virXPathNode("./target", ctxt))) {
+    if ((targetNode = virXMLNodeGetSubelement(node, "target"))) {
         def->dst = virXMLPropString(targetNode, "dev");
 
         if (virXMLPropEnum(targetNode, "bus",
@@ -8107,12 +8149,12 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((geometryNode = virXPathNode("./geometry", ctxt))) {
+    if ((geometryNode = virXMLNodeGetSubelement(node, "geometry"))) {
         if (virDomainDiskDefGeometryParse(def, geometryNode) < 0)
             return NULL;
     }
 
-    if ((blockioNode = virXPathNode("./blockio", ctxt))) {
+    if ((blockioNode = virXMLNodeGetSubelement(node, "blockio"))) {
         if (virXMLPropUInt(blockioNode, "logical_block_size", 10, VIR_XML_PROP_NONE,
                            &def->blockio.logical_block_size) < 0)
             return NULL;
@@ -8126,7 +8168,7 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((driverNode = virXPathNode("./driver", ctxt))) {
+    if ((driverNode = virXMLNodeGetSubelement(node, "driver"))) {
         if (virDomainVirtioOptionsParseXML(driverNode, &def->virtio) < 0)
             return NULL;
 
@@ -8137,23 +8179,23 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((mirrorNode = virXPathNode("./mirror", ctxt))) {
+    if ((mirrorNode = virXMLNodeGetSubelement(node, "mirror"))) {
         if (!(flags & VIR_DOMAIN_DEF_PARSE_INACTIVE)) {
             if (virDomainDiskDefMirrorParse(def, mirrorNode, ctxt, flags, xmlopt) < 0)
                 return NULL;
         }
     }
 
-    if (virXPathNode("./auth", ctxt))
+    if (virXMLNodeGetSubelement(node, "auth"))
         def->diskElementAuth = true;
 
-    if (virXPathNode("./encryption", ctxt))
+    if (virXMLNodeGetSubelement(node, "encryption"))
         def->diskElementEnc = true;
 
     if (flags & VIR_DOMAIN_DEF_PARSE_STATUS) {
         xmlNodePtr diskSecretsPlacementNode;
 
-        if ((diskSecretsPlacementNode = virXPathNode("./diskSecretsPlacement", ctxt))) {
+        if ((diskSecretsPlacementNode = virXMLNodeGetSubelement(node, "diskSecretsPlacement"))) {
             g_autofree char *secretAuth = virXMLPropString(diskSecretsPlacementNode, "auth");
             g_autofree char *secretEnc = virXMLPropString(diskSecretsPlacementNode, "enc");
 
@@ -8162,7 +8204,7 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if ((transientNode = virXPathNode("./transient", ctxt))) {
+    if ((transientNode = virXMLNodeGetSubelement(node, "transient"))) {
         def->transient = true;
 
         if (virXMLPropTristateBool(transientNode, "shareBacking",
@@ -8174,11 +8216,11 @@ virDomainDiskDefParseXML(virDomainXMLOption *xmlopt,
     if (virDomainDiskDefIotuneParse(def, ctxt) < 0)
         return NULL;
 
-    def->domain_name = virXPathString("string(./backenddomain/@name)", ctxt);
-    def->serial = virXPathString("string(./serial)", ctxt);
-    def->wwn = virXPathString("string(./wwn)", ctxt);
-    def->vendor = virXPathString("string(./vendor)", ctxt);
-    def->product = virXPathString("string(./product)", ctxt);
+    def->domain_name = virXMLNodeGetSubelementProp(node, "backenddomain", "name");
+    def->serial = virXMLNodeGetSubelementContent(node, "serial");
+    def->wwn = virXMLNodeGetSubelementContent(node, "wwn");
+    def->vendor = virXMLNodeGetSubelementContent(node, "vendor");
+    def->product = virXMLNodeGetSubelementContent(node, "product");
 
     if (virDomainDeviceInfoParseXML(xmlopt, node, ctxt, &def->info,
                                     flags | VIR_DOMAIN_DEF_PARSE_ALLOW_BOOT) < 0) {
@@ -8408,17 +8450,14 @@ virDomainControllerDefParseXML(virDomainXMLOption *xmlopt,
     g_autoptr(virDomainControllerDef) def = NULL;
     virDomainControllerType type = VIR_DOMAIN_CONTROLLER_TYPE_IDE;
     xmlNodePtr driver = NULL;
-    g_autofree xmlNodePtr *targetNodes = NULL;
-    int ntargetNodes = 0;
-    g_autofree xmlNodePtr *modelNodes = NULL;
-    int nmodelNodes = 0;
+    g_autoptr(GPtrArray) targetNodes = virXMLNodeGetSubelementList(node, "target");
+    g_autoptr(GPtrArray) modelNodes = virXMLNodeGetSubelementList(node, "model");
     int numaNode = -1;
     int ports;
     VIR_XPATH_NODE_AUTORESTORE(ctxt)
     int rc;
     g_autofree char *model = NULL;
-
-    ctxt->node = node;
+    g_autofree char *numaNodeStr = NULL;
 
     if (virXMLPropEnum(node, "type", virDomainControllerTypeFromString,
                        VIR_XML_PROP_NONE, &type) < 0)
@@ -8439,7 +8478,7 @@ virDomainControllerDefParseXML(virDomainXMLOption *xmlopt,
                       &def->idx, def->idx) < 0)
         return NULL;
 
-    if ((driver = virXPathNode("./driver", ctxt))) {
+    if ((driver = virXMLNodeGetSubelement(node, "driver"))) {
         if (virXMLPropUInt(driver, "queues", 10, VIR_XML_PROP_NONE,
                            &def->queues) < 0)
             return NULL;
@@ -8465,15 +8504,15 @@ virDomainControllerDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((nmodelNodes = virXPathNodeSet("./model", ctxt, &modelNodes)) > 1) {
+    if (modelNodes->len > 1) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("Multiple <model> elements in controller definition not allowed"));
         return NULL;
     }
 
-    if (nmodelNodes == 1) {
+    if (modelNodes->len == 1) {
         if (def->type == VIR_DOMAIN_CONTROLLER_TYPE_PCI) {
-            if (virXMLPropEnum(modelNodes[0], "name",
+            if (virXMLPropEnum(g_ptr_array_index(modelNodes, 0), "name",
                                virDomainControllerPCIModelNameTypeFromString,
                                VIR_XML_PROP_NONE,
                                &def->opts.pciopts.modelName) < 0)
@@ -8481,54 +8520,58 @@ virDomainControllerDefParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if ((ntargetNodes = virXPathNodeSet("./target", ctxt, &targetNodes)) > 1) {
+    if (targetNodes->len > 1) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("Multiple <target> elements in controller definition not allowed"));
         return NULL;
     }
 
-    if (ntargetNodes == 1) {
+    if (targetNodes->len == 1) {
+        xmlNodePtr target = g_ptr_array_index(targetNodes, 0);
+
         if (def->type == VIR_DOMAIN_CONTROLLER_TYPE_PCI) {
-            if (virXMLPropInt(targetNodes[0], "chassisNr", 0, VIR_XML_PROP_NONNEGATIVE,
+            if (virXMLPropInt(target, "chassisNr", 0, VIR_XML_PROP_NONNEGATIVE,
                               &def->opts.pciopts.chassisNr,
                               def->opts.pciopts.chassisNr) < 0)
                 return NULL;
 
-            if (virXMLPropInt(targetNodes[0], "chassis", 0, VIR_XML_PROP_NONNEGATIVE,
+            if (virXMLPropInt(target, "chassis", 0, VIR_XML_PROP_NONNEGATIVE,
                               &def->opts.pciopts.chassis,
                               def->opts.pciopts.chassis) < 0)
                 return NULL;
 
-            if (virXMLPropInt(targetNodes[0], "port", 0, VIR_XML_PROP_NONNEGATIVE,
+            if (virXMLPropInt(target, "port", 0, VIR_XML_PROP_NONNEGATIVE,
                               &def->opts.pciopts.port,
                               def->opts.pciopts.port) < 0)
                 return NULL;
 
-            if (virXMLPropInt(targetNodes[0], "busNr", 0, VIR_XML_PROP_NONNEGATIVE,
+            if (virXMLPropInt(target, "busNr", 0, VIR_XML_PROP_NONNEGATIVE,
                               &def->opts.pciopts.busNr,
                               def->opts.pciopts.busNr) < 0)
                 return NULL;
 
-            if (virXMLPropTristateSwitch(targetNodes[0], "hotplug",
+            if (virXMLPropTristateSwitch(target, "hotplug",
                                          VIR_XML_PROP_NONE,
                                          &def->opts.pciopts.hotplug) < 0)
                 return NULL;
 
-            if (virXMLPropInt(targetNodes[0], "index", 0, VIR_XML_PROP_NONNEGATIVE,
+            if (virXMLPropInt(target, "index", 0, VIR_XML_PROP_NONNEGATIVE,
                               &def->opts.pciopts.targetIndex,
                               def->opts.pciopts.targetIndex) < 0)
                 return NULL;
         }
-    }
 
-    /* node is parsed differently from target attributes because
-     * someone thought it should be a subelement instead...
-     */
-    rc = virXPathInt("string(./target/node)", ctxt, &numaNode);
-    if (rc == -2 || (rc == 0 && numaNode < 0)) {
-        virReportError(VIR_ERR_XML_ERROR, "%s",
-                       _("invalid NUMA node in target"));
-        return NULL;
+        /* node is parsed differently from target attributes because
+         * someone thought it should be a subelement instead...
+         */
+        numaNodeStr = virXMLNodeGetSubelementContent(target, "node");
+        if (numaNodeStr &&
+            (virStrToLong_i(numaNodeStr, NULL, 10, &numaNode) < 0 ||
+             numaNode < 0)) {
+            virReportError(VIR_ERR_XML_ERROR, "%s",
+                           _("invalid NUMA node in target"));
+            return NULL;
+        }
     }
 
     if (def->type == VIR_DOMAIN_CONTROLLER_TYPE_USB &&
@@ -8581,6 +8624,8 @@ virDomainControllerDefParseXML(virDomainXMLOption *xmlopt,
         case VIR_DOMAIN_CONTROLLER_MODEL_PCI_ROOT:
         case VIR_DOMAIN_CONTROLLER_MODEL_PCIE_ROOT: {
             unsigned long long bytes;
+
+            ctxt->node = node;
             if ((rc = virParseScaledValue("./pcihole64", NULL,
                                           ctxt, &bytes, 1024,
                                           ULLONG_MAX, false)) < 0)
@@ -9136,11 +9181,11 @@ virDomainNetAppendIPAddress(virDomainNetDef *def,
 
 
 static int
-virDomainNetTeamingInfoParseXML(xmlXPathContextPtr ctxt,
+virDomainNetTeamingInfoParseXML(xmlNodePtr node,
                                 virDomainNetTeamingInfo **teaming)
 {
-    g_autofree char *typeStr = virXPathString("string(./teaming/@type)", ctxt);
-    g_autofree char *persistentStr = virXPathString("string(./teaming/@persistent)", ctxt);
+    g_autofree char *typeStr = virXMLNodeGetSubelementProp(node, "teaming", "type");
+    g_autofree char *persistentStr = virXMLNodeGetSubelementProp(node, "teaming", "persistent");
     g_autoptr(virDomainNetTeamingInfo) tmpTeaming = NULL;
     int tmpType;
 
@@ -9505,11 +9550,11 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
                                &def->trustGuestRxFilters) < 0)
         return NULL;
 
-    if ((model = virXPathString("string(./model/@type)", ctxt)) &&
+    if ((model = virXMLNodeGetSubelementProp(node, "model", "type")) &&
         virDomainNetSetModelString(def, model) < 0)
         return NULL;
 
-    if ((source_node = virXPathNode("./source", ctxt))) {
+    if ((source_node = virXMLNodeGetSubelement(node, "source"))) {
         if (virDomainNetIPInfoParseXML(_("interface host IP"), source_node, ctxt, &def->hostIP) < 0)
             return NULL;
     }
@@ -9533,7 +9578,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         if ((flags & VIR_DOMAIN_DEF_PARSE_ACTUAL_NET)) {
             xmlNodePtr actual_node = NULL;
 
-            if ((actual_node = virXPathNode("./actual", ctxt)) &&
+            if ((actual_node = virXMLNodeGetSubelement(node, "actual")) &&
                 (virDomainActualNetDefParseXML(actual_node, ctxt, def,
                                                &def->data.network.actual,
                                                flags, xmlopt) < 0))
@@ -9655,7 +9700,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         }
 
         if (virDomainChrSourceReconnectDefParseXML(&def->data.vhostuser->data.nix.reconnect,
-                                                   source_node, ctxt) < 0)
+                                                   source_node) < 0)
             return NULL;
     }
         break;
@@ -9750,7 +9795,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         break;
     }
 
-    if ((virtualport_node = virXPathNode("./virtualport", ctxt))) {
+    if ((virtualport_node = virXMLNodeGetSubelement(node, "virtualport"))) {
         if (virtualport_flags == 0) {
             virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
                            _("<virtualport> element unsupported for <interface type='%1$s'>"),
@@ -9763,7 +9808,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    if ((target_node = virXPathNode("./target", ctxt))) {
+    if ((target_node = virXMLNodeGetSubelement(node, "target"))) {
         def->ifname = virXMLPropString(target_node, "dev");
 
         if (virXMLPropTristateBool(target_node, "managed", VIR_XML_PROP_NONE,
@@ -9771,16 +9816,16 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
             return NULL;
     }
 
-    def->ifname_guest = virXPathString("string(./guest/@dev)", ctxt);
-    def->ifname_guest_actual = virXPathString("string(./guest/@actual)", ctxt);
+    def->ifname_guest = virXMLNodeGetSubelementProp(node, "guest", "dev");
+    def->ifname_guest_actual = virXMLNodeGetSubelementProp(node, "guest", "actual");
 
-    linkstate = virXPathString("string(./link/@state)", ctxt);
-    def->script = virXPathString("string(./script/@path)", ctxt);
-    def->downscript = virXPathString("string(./downscript/@path)", ctxt);
-    def->domain_name = virXPathString("string(./backenddomain/@name)", ctxt);
+    linkstate = virXMLNodeGetSubelementProp(node, "link", "state");
+    def->script = virXMLNodeGetSubelementProp(node, "script", "path");
+    def->downscript = virXMLNodeGetSubelementProp(node, "downscript", "path");
+    def->domain_name = virXMLNodeGetSubelementProp(node, "backenddomain", "name");
 
     if (parse_filterref) {
-        xmlNodePtr filterref_node = virXPathNode("./filterref", ctxt);
+        xmlNodePtr filterref_node = virXMLNodeGetSubelement(node, "filterref");
 
         if (filterref_node) {
             def->filter = virXMLPropString(filterref_node, "filter");
@@ -9788,16 +9833,16 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if ((bandwidth_node = virXPathNode("./bandwidth", ctxt)) &&
+    if ((bandwidth_node = virXMLNodeGetSubelement(node, "bandwidth")) &&
         (virNetDevBandwidthParse(&def->bandwidth, NULL, bandwidth_node,
                                  def->type == VIR_DOMAIN_NET_TYPE_NETWORK) < 0))
         return NULL;
 
-    if ((vlan_node = virXPathNode("./vlan", ctxt)) &&
+    if ((vlan_node = virXMLNodeGetSubelement(node, "vlan")) &&
         (virNetDevVlanParse(vlan_node, ctxt, &def->vlan) < 0))
         return NULL;
 
-    if ((mac_node = virXPathNode("./mac", ctxt))) {
+    if ((mac_node = virXMLNodeGetSubelement(node, "mac"))) {
         if ((macaddr = virXMLPropString(mac_node, "address"))) {
             if (virMacAddrParse((const char *)macaddr, &def->mac) < 0) {
                 virReportError(VIR_ERR_XML_ERROR,
@@ -9854,7 +9899,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
     if (virDomainNetDefParseXMLDriver(def, ctxt) < 0)
         return NULL;
 
-    if ((backend_node = virXPathNode("./backend", ctxt)) &&
+    if ((backend_node = virXMLNodeGetSubelement(node, "backend")) &&
         virDomainNetBackendParseXML(backend_node, def) < 0) {
         return NULL;
     }
@@ -9869,7 +9914,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if (virDomainNetTeamingInfoParseXML(ctxt, &def->teaming) < 0)
+    if (virDomainNetTeamingInfoParseXML(node, &def->teaming) < 0)
         return NULL;
 
     rv = virXPathULongLong("string(./tune/sndbuf)", ctxt, &def->tune.sndbuf);
@@ -9887,7 +9932,7 @@ virDomainNetDefParseXML(virDomainXMLOption *xmlopt,
         return NULL;
     }
 
-    if ((coalesce_node = virXPathNode("./coalesce", ctxt))) {
+    if ((coalesce_node = virXMLNodeGetSubelement(node, "coalesce"))) {
         if (virDomainNetDefCoalesceParseXML(coalesce_node, ctxt, &def->coalesce) < 0)
             return NULL;
     }
@@ -9988,7 +10033,6 @@ virDomainChrTargetModelFromString(int devtype,
 static int
 virDomainChrDefParseTargetXML(virDomainChrDef *def,
                               xmlNodePtr cur,
-                              xmlXPathContextPtr ctxt,
                               unsigned int flags)
 {
     unsigned int port;
@@ -9996,9 +10040,6 @@ virDomainChrDefParseTargetXML(virDomainChrDef *def,
     g_autofree char *targetModel = NULL;
     g_autofree char *addrStr = NULL;
     g_autofree char *portStr = NULL;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = cur;
 
     if ((def->targetType =
          virDomainChrTargetTypeFromString(def->deviceType,
@@ -10009,7 +10050,7 @@ virDomainChrDefParseTargetXML(virDomainChrDef *def,
         return -1;
     }
 
-    targetModel = virXPathString("string(./model/@name)", ctxt);
+    targetModel = virXMLNodeGetSubelementProp(cur, "model", "name");
 
     if ((def->targetModel =
          virDomainChrTargetModelFromString(def->deviceType,
@@ -10090,7 +10131,6 @@ virDomainChrDefParseTargetXML(virDomainChrDef *def,
 static int
 virDomainChrSourceDefParseTCP(virDomainChrSourceDef *def,
                               xmlNodePtr source,
-                              xmlXPathContextPtr ctxt,
                               unsigned int flags)
 {
     virDomainChrSourceMode mode;
@@ -10118,8 +10158,7 @@ virDomainChrSourceDefParseTCP(virDomainChrSourceDef *def,
     }
 
     if (virDomainChrSourceReconnectDefParseXML(&def->data.tcp.reconnect,
-                                               source,
-                                               ctxt) < 0) {
+                                               source) < 0) {
         return -1;
     }
 
@@ -10154,8 +10193,7 @@ virDomainChrSourceDefParseUDP(virDomainChrSourceDef *def,
 
 static int
 virDomainChrSourceDefParseUnix(virDomainChrSourceDef *def,
-                               xmlNodePtr source,
-                               xmlXPathContextPtr ctxt)
+                               xmlNodePtr source)
 {
     virDomainChrSourceMode mode;
 
@@ -10168,8 +10206,7 @@ virDomainChrSourceDefParseUnix(virDomainChrSourceDef *def,
     def->data.nix.path = virXMLPropString(source, "path");
 
     if (virDomainChrSourceReconnectDefParseXML(&def->data.nix.reconnect,
-                                               source,
-                                               ctxt) < 0) {
+                                               source) < 0) {
         return -1;
     }
 
@@ -10228,20 +10265,17 @@ virDomainChrSourceDefParseLog(virDomainChrSourceDef *def,
 
 static int
 virDomainChrSourceDefParseQemuVdagent(virDomainChrSourceDef *def,
-                                      xmlNodePtr source,
-                                      xmlXPathContextPtr ctxt)
+                                      xmlNodePtr source)
 {
     xmlNodePtr cur;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
 
-    ctxt->node = source;
-    if ((cur = virXPathNode("./clipboard", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(source, "clipboard"))) {
         if (virXMLPropTristateBool(cur, "copypaste",
                                    VIR_XML_PROP_REQUIRED,
                                    &def->data.qemuVdagent.clipboard) < 0)
             return -1;
     }
-    if ((cur = virXPathNode("./mouse", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(source, "mouse"))) {
         if (virXMLPropEnum(cur, "mode",
                            virDomainMouseModeTypeFromString,
                            VIR_XML_PROP_REQUIRED | VIR_XML_PROP_NONZERO,
@@ -10264,19 +10298,13 @@ virDomainChrSourceDefParseXML(virDomainChrSourceDef *def,
                               virDomainChrDef *chr_def,
                               xmlXPathContextPtr ctxt)
 {
-    g_autofree xmlNodePtr *logs = NULL;
-    int nlogs = 0;
-    g_autofree xmlNodePtr *protocols = NULL;
-    int nprotocols = 0;
-    g_autofree xmlNodePtr *sources = NULL;
-    int nsources = 0;
+    g_autoptr(GPtrArray) logs = virXMLNodeGetSubelementList(cur, "log");
+    g_autoptr(GPtrArray) protocols = virXMLNodeGetSubelementList(cur, "protocol");
+    g_autoptr(GPtrArray) sourceList = virXMLNodeGetSubelementList(cur, "source");
+    xmlNodePtr *sources = (xmlNodePtr *) sourceList->pdata;
+    size_t nsources = sourceList->len;
     VIR_XPATH_NODE_AUTORESTORE(ctxt)
 
-    ctxt->node = cur;
-
-    if ((nsources = virXPathNodeSet("./source", ctxt, &sources)) < 0)
-        goto error;
-
     if (nsources > 0) {
         /* Parse only the first source element since only one is used
          * for chardev devices, the only exception is UDP type, where
@@ -10310,7 +10338,7 @@ virDomainChrSourceDefParseXML(virDomainChrSourceDef *def,
             break;
 
         case VIR_DOMAIN_CHR_TYPE_UNIX:
-            if (virDomainChrSourceDefParseUnix(def, sources[0], ctxt) < 0)
+            if (virDomainChrSourceDefParseUnix(def, sources[0]) < 0)
                 goto error;
             break;
 
@@ -10321,7 +10349,7 @@ virDomainChrSourceDefParseXML(virDomainChrSourceDef *def,
             break;
 
         case VIR_DOMAIN_CHR_TYPE_TCP:
-            if (virDomainChrSourceDefParseTCP(def, sources[0], ctxt, flags) < 0)
+            if (virDomainChrSourceDefParseTCP(def, sources[0], flags) < 0)
                 goto error;
             break;
 
@@ -10339,7 +10367,7 @@ virDomainChrSourceDefParseXML(virDomainChrSourceDef *def,
             break;
 
         case VIR_DOMAIN_CHR_TYPE_QEMU_VDAGENT:
-            if (virDomainChrSourceDefParseQemuVdagent(def, sources[0], ctxt) < 0)
+            if (virDomainChrSourceDefParseQemuVdagent(def, sources[0]) < 0)
                 goto error;
 
             break;
@@ -10354,36 +10382,27 @@ virDomainChrSourceDefParseXML(virDomainChrSourceDef *def,
 
         /* Check for an optional seclabel override in <source/>. */
         if (chr_def) {
-            xmlNodePtr tmp = ctxt->node;
-
             ctxt->node = sources[0];
             if (virSecurityDeviceLabelDefParseXML(&def->seclabels, &def->nseclabels,
                                                   ctxt, flags) < 0) {
                 goto error;
             }
-            ctxt->node = tmp;
         }
     }
 
-    if ((nlogs = virXPathNodeSet("./log", ctxt, &logs)) < 0)
-        goto error;
-
-    if (nlogs == 1) {
-        if (virDomainChrSourceDefParseLog(def, logs[0]) < 0)
+    if (logs->len == 1) {
+        if (virDomainChrSourceDefParseLog(def, g_ptr_array_index(logs, 0)) < 0)
             goto error;
-    } else if (nlogs > 1) {
+    } else if (logs->len > 1) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("only one log element is allowed for character device"));
         goto error;
     }
 
-    if ((nprotocols = virXPathNodeSet("./protocol", ctxt, &protocols)) < 0)
-        goto error;
-
-    if (nprotocols == 1) {
-        if (virDomainChrSourceDefParseProtocol(def, protocols[0]) < 0)
+    if (protocols->len == 1) {
+        if (virDomainChrSourceDefParseProtocol(def, g_ptr_array_index(protocols, 0)) < 0)
             goto error;
-    } else if (nprotocols > 1) {
+    } else if (protocols->len > 1) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("only one protocol element is allowed for character device"));
         goto error;
@@ -10500,9 +10519,6 @@ virDomainChrDefParseXML(virDomainXMLOption *xmlopt,
     const char *nodeName;
     virDomainChrDef *def;
     g_autofree char *type = NULL;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = node;
 
     if (!(def = virDomainChrDefNew(xmlopt)))
         return NULL;
@@ -10525,8 +10541,8 @@ virDomainChrDefParseXML(virDomainXMLOption *xmlopt,
         goto error;
     }
 
-    if ((target = virXPathNode("./target", ctxt))) {
-        if (virDomainChrDefParseTargetXML(def, target, ctxt, flags) < 0)
+    if ((target = virXMLNodeGetSubelement(node, "target"))) {
+        if (virDomainChrDefParseTargetXML(def, target, flags) < 0)
             goto error;
     } else if ((def->targetType = virDomainChrDefaultTargetType(def->deviceType)) < 0) {
         goto error;
@@ -11251,31 +11267,22 @@ virDomainGraphicsListenDefParseXML(virDomainGraphicsListenDef *def,
 static int
 virDomainGraphicsListensParseXML(virDomainGraphicsDef *def,
                                  xmlNodePtr node,
-                                 xmlXPathContextPtr ctxt,
                                  unsigned int flags)
 {
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     virDomainGraphicsListenDef newListen = {0};
-    int nListens;
     int ret = -1;
-    g_autofree xmlNodePtr *listenNodes = NULL;
+    g_autoptr(GPtrArray) listenNodes = virXMLNodeGetSubelementList(node, "listen");
     g_autofree char *socketPath = NULL;
 
-    ctxt->node = node;
-
     /* parse the <listen> subelements for graphics types that support it */
-    nListens = virXPathNodeSet("./listen", ctxt, &listenNodes);
-    if (nListens < 0)
-        goto cleanup;
-
-    if (nListens > 0) {
+    if (listenNodes->len > 0) {
         size_t i;
 
-        def->listens = g_new0(virDomainGraphicsListenDef, nListens);
+        def->listens = g_new0(virDomainGraphicsListenDef, listenNodes->len);
 
-        for (i = 0; i < nListens; i++) {
+        for (i = 0; i < listenNodes->len; i++) {
             if (virDomainGraphicsListenDefParseXML(&def->listens[i],
-                                                   listenNodes[i],
+                                                   g_ptr_array_index(listenNodes, i),
                                                    i == 0 ? node : NULL,
                                                    flags) < 0)
                 goto cleanup;
@@ -11330,16 +11337,14 @@ virDomainGraphicsListensParseXML(virDomainGraphicsDef *def,
 static int
 virDomainGraphicsDefParseXMLVNC(virDomainGraphicsDef *def,
                                 xmlNodePtr node,
-                                xmlXPathContextPtr ctxt,
                                 unsigned int flags)
 {
     g_autofree char *port = virXMLPropString(node, "port");
     g_autofree char *websocketGenerated = virXMLPropString(node, "websocketGenerated");
     g_autofree char *autoport = virXMLPropString(node, "autoport");
     xmlNodePtr audioNode;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
 
-    if (virDomainGraphicsListensParseXML(def, node, ctxt, flags) < 0)
+    if (virDomainGraphicsListensParseXML(def, node, flags) < 0)
         return -1;
 
     if (port) {
@@ -11385,8 +11390,7 @@ virDomainGraphicsDefParseXMLVNC(virDomainGraphicsDef *def,
 
     def->data.vnc.keymap = virXMLPropString(node, "keymap");
 
-    ctxt->node = node;
-    audioNode = virXPathNode("./audio", ctxt);
+    audioNode = virXMLNodeGetSubelement(node, "audio");
     if (audioNode) {
         if (virXMLPropUInt(audioNode, "id", 10,
                            VIR_XML_PROP_REQUIRED | VIR_XML_PROP_NONZERO,
@@ -11404,15 +11408,11 @@ virDomainGraphicsDefParseXMLVNC(virDomainGraphicsDef *def,
 
 static int
 virDomainGraphicsDefParseXMLSDL(virDomainGraphicsDef *def,
-                                xmlNodePtr node,
-                                xmlXPathContextPtr ctxt)
+                                xmlNodePtr node)
 {
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     xmlNodePtr glNode;
     virTristateBool fullscreen;
 
-    ctxt->node = node;
-
     if (virXMLPropTristateBool(node, "fullscreen", VIR_XML_PROP_NONE,
                                &fullscreen) < 0)
         return -1;
@@ -11421,7 +11421,7 @@ virDomainGraphicsDefParseXMLSDL(virDomainGraphicsDef *def,
     def->data.sdl.xauth = virXMLPropString(node, "xauth");
     def->data.sdl.display = virXMLPropString(node, "display");
 
-    if ((glNode = virXPathNode("./gl", ctxt))) {
+    if ((glNode = virXMLNodeGetSubelement(node, "gl"))) {
         if (virXMLPropTristateBool(glNode, "enable", VIR_XML_PROP_REQUIRED,
                                    &def->data.sdl.gl) < 0)
             return -1;
@@ -11434,7 +11434,6 @@ virDomainGraphicsDefParseXMLSDL(virDomainGraphicsDef *def,
 static int
 virDomainGraphicsDefParseXMLRDP(virDomainGraphicsDef *def,
                                 xmlNodePtr node,
-                                xmlXPathContextPtr ctxt,
                                 unsigned int flags)
 {
     g_autofree char *port = virXMLPropString(node, "port");
@@ -11442,7 +11441,7 @@ virDomainGraphicsDefParseXMLRDP(virDomainGraphicsDef *def,
     g_autofree char *replaceUser = virXMLPropString(node, "replaceUser");
     g_autofree char *multiUser = virXMLPropString(node, "multiUser");
 
-    if (virDomainGraphicsListensParseXML(def, node, ctxt, flags) < 0)
+    if (virDomainGraphicsListensParseXML(def, node, flags) < 0)
         return -1;
 
     if (port) {
@@ -11496,19 +11495,14 @@ virDomainGraphicsDefParseXMLDesktop(virDomainGraphicsDef *def,
 static int
 virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
                                   xmlNodePtr node,
-                                  xmlXPathContextPtr ctxt,
                                   unsigned int flags)
 {
-    g_autofree xmlNodePtr *node_list = NULL;
-    int n = 0;
+    g_autoptr(GPtrArray) channels = virXMLNodeGetSubelementList(node, "channel");
     size_t i = 0;
     virTristateBool autoport;
     xmlNodePtr cur;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = node;
 
-    if (virDomainGraphicsListensParseXML(def, node, ctxt, flags) < 0)
+    if (virDomainGraphicsListensParseXML(def, node, flags) < 0)
         return -1;
 
     if (virXMLPropInt(node, "port", 10, VIR_XML_PROP_NONE,
@@ -11546,19 +11540,17 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
                                          def->type) < 0)
         return -1;
 
-    if ((n = virXPathNodeSet("./channel", ctxt, &node_list)) < 0)
-        return -1;
-
-    for (i = 0; i < n; i++) {
+    for (i = 0; i < channels->len; i++) {
+        xmlNodePtr channel = g_ptr_array_index(channels, i);
         virDomainGraphicsSpiceChannelName name;
         virDomainGraphicsSpiceChannelMode mode;
 
-        if (virXMLPropEnum(node_list[i], "name",
+        if (virXMLPropEnum(channel, "name",
                            virDomainGraphicsSpiceChannelNameTypeFromString,
                            VIR_XML_PROP_REQUIRED, &name) < 0)
             return -1;
 
-        if (virXMLPropEnum(node_list[i], "mode",
+        if (virXMLPropEnum(channel, "mode",
                            virDomainGraphicsSpiceChannelModeTypeFromString,
                            VIR_XML_PROP_REQUIRED, &mode) < 0)
             return -1;
@@ -11566,7 +11558,7 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
         def->data.spice.channels[name] = mode;
     }
 
-    if ((cur = virXPathNode("./image", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "image"))) {
         virDomainGraphicsSpiceImageCompression compression;
 
         if (virXMLPropEnum(cur, "compression",
@@ -11578,7 +11570,7 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
         def->data.spice.image = compression;
     }
 
-    if ((cur = virXPathNode("./jpeg", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "jpeg"))) {
         virDomainGraphicsSpiceJpegCompression compression;
 
         if (virXMLPropEnum(cur, "compression",
@@ -11590,7 +11582,7 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
         def->data.spice.jpeg = compression;
     }
 
-    if ((cur = virXPathNode("./zlib", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "zlib"))) {
         virDomainGraphicsSpiceZlibCompression compression;
 
         if (virXMLPropEnum(cur, "compression",
@@ -11602,14 +11594,14 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
         def->data.spice.zlib = compression;
     }
 
-    if ((cur = virXPathNode("./playback", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "playback"))) {
         if (virXMLPropTristateSwitch(cur, "compression",
                                      VIR_XML_PROP_REQUIRED,
                                      &def->data.spice.playback) < 0)
             return -1;
     }
 
-    if ((cur = virXPathNode("./streaming", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "streaming"))) {
         virDomainGraphicsSpiceStreamingMode mode;
 
         if (virXMLPropEnum(cur, "mode",
@@ -11621,21 +11613,21 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
         def->data.spice.streaming = mode;
     }
 
-    if ((cur = virXPathNode("./clipboard", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "clipboard"))) {
         if (virXMLPropTristateBool(cur, "copypaste",
                                    VIR_XML_PROP_REQUIRED,
                                    &def->data.spice.copypaste) < 0)
             return -1;
     }
 
-    if ((cur = virXPathNode("./filetransfer", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "filetransfer"))) {
         if (virXMLPropTristateBool(cur, "enable",
                                    VIR_XML_PROP_REQUIRED,
                                    &def->data.spice.filetransfer) < 0)
             return -1;
     }
 
-    if ((cur = virXPathNode("./gl", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "gl"))) {
         def->data.spice.rendernode = virXMLPropString(cur, "rendernode");
 
         if (virXMLPropTristateBool(cur, "enable",
@@ -11644,7 +11636,7 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
             return -1;
     }
 
-    if ((cur = virXPathNode("./mouse", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "mouse"))) {
         if (virXMLPropEnum(cur, "mode",
                            virDomainMouseModeTypeFromString,
                            VIR_XML_PROP_REQUIRED | VIR_XML_PROP_NONZERO,
@@ -11658,15 +11650,11 @@ virDomainGraphicsDefParseXMLSpice(virDomainGraphicsDef *def,
 
 static void
 virDomainGraphicsDefParseXMLEGLHeadless(virDomainGraphicsDef *def,
-                                        xmlNodePtr node,
-                                        xmlXPathContextPtr ctxt)
+                                        xmlNodePtr node)
 {
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     xmlNodePtr glNode;
 
-    ctxt->node = node;
-
-    if ((glNode = virXPathNode("./gl", ctxt)))
+    if ((glNode = virXMLNodeGetSubelement(node, "gl")))
         def->data.egl_headless.rendernode = virXMLPropString(glNode,
                                                              "rendernode");
 }
@@ -11674,10 +11662,8 @@ virDomainGraphicsDefParseXMLEGLHeadless(virDomainGraphicsDef *def,
 
 static int
 virDomainGraphicsDefParseXMLDBus(virDomainGraphicsDef *def,
-                                 xmlNodePtr node,
-                                 xmlXPathContextPtr ctxt)
+                                 xmlNodePtr node)
 {
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     xmlNodePtr cur;
     virTristateBool p2p;
 
@@ -11689,9 +11675,7 @@ virDomainGraphicsDefParseXMLDBus(virDomainGraphicsDef *def,
     def->data.dbus.address = virXMLPropString(node, "address");
     def->data.dbus.fromConfig = def->data.dbus.address != NULL;
 
-    ctxt->node = node;
-
-    if ((cur = virXPathNode("./gl", ctxt))) {
+    if ((cur = virXMLNodeGetSubelement(node, "gl"))) {
         def->data.dbus.rendernode = virXMLPropString(cur,
                                                      "rendernode");
 
@@ -11701,7 +11685,7 @@ virDomainGraphicsDefParseXMLDBus(virDomainGraphicsDef *def,
             return -1;
     }
 
-    cur = virXPathNode("./audio", ctxt);
+    cur = virXMLNodeGetSubelement(node, "audio");
     if (cur) {
         if (virXMLPropUInt(cur, "id", 10,
                            VIR_XML_PROP_REQUIRED | VIR_XML_PROP_NONZERO,
@@ -11749,7 +11733,6 @@ virDomainNetDefNew(virDomainXMLOption *xmlopt)
 static virDomainGraphicsDef *
 virDomainGraphicsDefParseXML(virDomainXMLOption *xmlopt,
                              xmlNodePtr node,
-                             xmlXPathContextPtr ctxt,
                              unsigned int flags)
 {
     virDomainGraphicsDef *def;
@@ -11763,15 +11746,15 @@ virDomainGraphicsDefParseXML(virDomainXMLOption *xmlopt,
 
     switch (def->type) {
     case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
-        if (virDomainGraphicsDefParseXMLVNC(def, node, ctxt, flags) < 0)
+        if (virDomainGraphicsDefParseXMLVNC(def, node, flags) < 0)
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
-        if (virDomainGraphicsDefParseXMLSDL(def, node, ctxt) < 0)
+        if (virDomainGraphicsDefParseXMLSDL(def, node) < 0)
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
-        if (virDomainGraphicsDefParseXMLRDP(def, node, ctxt, flags) < 0)
+        if (virDomainGraphicsDefParseXMLRDP(def, node, flags) < 0)
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
@@ -11779,14 +11762,14 @@ virDomainGraphicsDefParseXML(virDomainXMLOption *xmlopt,
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
-        if (virDomainGraphicsDefParseXMLSpice(def, node, ctxt, flags) < 0)
+        if (virDomainGraphicsDefParseXMLSpice(def, node, flags) < 0)
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
-        virDomainGraphicsDefParseXMLEGLHeadless(def, node, ctxt);
+        virDomainGraphicsDefParseXMLEGLHeadless(def, node);
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_DBUS:
-        if (virDomainGraphicsDefParseXMLDBus(def, node, ctxt) < 0)
+        if (virDomainGraphicsDefParseXMLDBus(def, node) < 0)
             goto error;
         break;
     case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
@@ -12285,10 +12268,11 @@ virDomainRNGDefParseXML(virDomainXMLOption *xmlopt,
                         unsigned int flags)
 {
     virDomainRNGDef *def;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-    int nbackends;
-    g_autofree xmlNodePtr *backends = NULL;
+    g_autoptr(GPtrArray) backends = virXMLNodeGetSubelementList(node, "backend");
+    xmlNodePtr backend;
     g_autofree char *type = NULL;
+    g_autofree char *rate = NULL;
+    g_autofree char *period = NULL;
 
     def = g_new0(virDomainRNGDef, 1);
 
@@ -12298,31 +12282,30 @@ virDomainRNGDefParseXML(virDomainXMLOption *xmlopt,
                        &def->model) < 0)
         goto error;
 
-    ctxt->node = node;
-
-    if (virXPathUInt("string(./rate/@bytes)", ctxt, &def->rate) < -1) {
+    if ((rate = virXMLNodeGetSubelementProp(node, "rate", "bytes")) &&
+        virStrToLong_ui(rate, NULL, 10, &def->rate) < 0) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("invalid RNG rate bytes value"));
         goto error;
     }
 
     if (def->rate > 0 &&
-        virXPathUInt("string(./rate/@period)", ctxt, &def->period) < -1) {
+        (period = virXMLNodeGetSubelementProp(node, "rate", "period")) &&
+        virStrToLong_ui(period, NULL, 10, &def->period) < 0) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("invalid RNG rate period value"));
         goto error;
     }
 
-    if ((nbackends = virXPathNodeSet("./backend", ctxt, &backends)) < 0)
-        goto error;
-
-    if (nbackends != 1) {
+    if (backends->len != 1) {
         virReportError(VIR_ERR_XML_ERROR, "%s",
                        _("only one RNG backend is supported"));
         goto error;
     }
 
-    if (virXMLPropEnum(backends[0], "model",
+    backend = g_ptr_array_index(backends, 0);
+
+    if (virXMLPropEnum(backend, "model",
                        virDomainRNGBackendTypeFromString,
                        VIR_XML_PROP_REQUIRED,
                        &def->backend) < 0) {
@@ -12331,11 +12314,11 @@ virDomainRNGDefParseXML(virDomainXMLOption *xmlopt,
 
     switch (def->backend) {
     case VIR_DOMAIN_RNG_BACKEND_RANDOM:
-        def->source.file = virXPathString("string(./backend)", ctxt);
+        def->source.file = virXMLNodeGetSubelementContent(node, "backend");
         break;
 
     case VIR_DOMAIN_RNG_BACKEND_EGD:
-        if (!(type = virXMLPropString(backends[0], "type"))) {
+        if (!(type = virXMLPropString(backend, "type"))) {
             virReportError(VIR_ERR_XML_ERROR, "%s",
                            _("missing EGD backend type"));
             goto error;
@@ -12353,7 +12336,7 @@ virDomainRNGDefParseXML(virDomainXMLOption *xmlopt,
         }
 
         if (virDomainChrSourceDefParseXML(def->source.chardev,
-                                          backends[0], flags,
+                                          backend, flags,
                                           NULL, ctxt) < 0)
             goto error;
         break;
@@ -12366,7 +12349,7 @@ virDomainRNGDefParseXML(virDomainXMLOption *xmlopt,
     if (virDomainDeviceInfoParseXML(xmlopt, node, ctxt, &def->info, flags) < 0)
         goto error;
 
-    if (virDomainVirtioOptionsParseXML(virXPathNode("./driver", ctxt),
+    if (virDomainVirtioOptionsParseXML(virXMLNodeGetSubelement(node, "driver"),
                                        &def->virtio) < 0)
         goto error;
 
@@ -12385,11 +12368,8 @@ virDomainMemballoonDefParseXML(virDomainXMLOption *xmlopt,
                                unsigned int flags)
 {
     virDomainMemballoonDef *def;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     xmlNodePtr stats;
 
-    ctxt->node = node;
-
     def = g_new0(virDomainMemballoonDef, 1);
 
     if (virXMLPropEnum(node, "model", virDomainMemballoonModelTypeFromString,
@@ -12405,7 +12385,7 @@ virDomainMemballoonDefParseXML(virDomainXMLOption *xmlopt,
                                  &def->free_page_reporting) < 0)
         goto error;
 
-    if ((stats = virXPathNode("./stats", ctxt))) {
+    if ((stats = virXMLNodeGetSubelement(node, "stats"))) {
         if (virXMLPropInt(stats, "period", 0, VIR_XML_PROP_NONE,
                           &def->period, 0) < 0)
             goto error;
@@ -12420,7 +12400,7 @@ virDomainMemballoonDefParseXML(virDomainXMLOption *xmlopt,
                                          &def->info, flags) < 0)
         goto error;
 
-    if (virDomainVirtioOptionsParseXML(virXPathNode("./driver", ctxt),
+    if (virDomainVirtioOptionsParseXML(virXMLNodeGetSubelement(node, "driver"),
                                        &def->virtio) < 0)
         goto error;
 
@@ -12966,16 +12946,12 @@ virDomainVideoResolutionDefParseXML(xmlNodePtr node)
 }
 
 static virDomainVideoDriverDef *
-virDomainVideoDriverDefParseXML(xmlNodePtr node,
-                                xmlXPathContextPtr ctxt)
+virDomainVideoDriverDefParseXML(xmlNodePtr node)
 {
     g_autofree virDomainVideoDriverDef *def = NULL;
     xmlNodePtr driver = NULL;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
-    ctxt->node = node;
 
-    if (!(driver = virXPathNode("./driver", ctxt)))
+    if (!(driver = virXMLNodeGetSubelement(node, "driver")))
         return NULL;
 
     def = g_new0(virDomainVideoDriverDef, 1);
@@ -12990,24 +12966,20 @@ virDomainVideoDriverDefParseXML(xmlNodePtr node,
 
 static int
 virDomainVideoModelDefParseXML(virDomainVideoDef *def,
-                               xmlNodePtr node,
-                               xmlXPathContextPtr ctxt)
+                               xmlNodePtr node)
 {
     xmlNodePtr accel_node;
     xmlNodePtr res_node;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     virTristateBool primary;
 
-    ctxt->node = node;
-
     if (virXMLPropTristateBool(node, "primary", VIR_XML_PROP_NONE, &primary) >= 0)
         def->primary = (primary == VIR_TRISTATE_BOOL_YES);
 
-    if ((accel_node = virXPathNode("./acceleration", ctxt)) &&
+    if ((accel_node = virXMLNodeGetSubelement(node, "acceleration")) &&
         (def->accel = virDomainVideoAccelDefParseXML(accel_node)) == NULL)
         return -1;
 
-    if ((res_node = virXPathNode("./resolution", ctxt)) &&
+    if ((res_node = virXMLNodeGetSubelement(node, "resolution")) &&
         (def->res = virDomainVideoResolutionDefParseXML(res_node)) == NULL)
         return -1;
 
@@ -13048,19 +13020,15 @@ virDomainVideoDefParseXML(virDomainXMLOption *xmlopt,
     xmlNodePtr driver;
     xmlNodePtr model;
 
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
-
     if (!(def = virDomainVideoDefNew(xmlopt)))
         return NULL;
 
-    ctxt->node = node;
-
-    if ((model = virXPathNode("./model", ctxt))) {
-        if (virDomainVideoModelDefParseXML(def, model, ctxt) < 0)
+    if ((model = virXMLNodeGetSubelement(node, "model"))) {
+        if (virDomainVideoModelDefParseXML(def, model) < 0)
             return NULL;
     }
 
-    if ((driver = virXPathNode("./driver", ctxt))) {
+    if ((driver = virXMLNodeGetSubelement(node, "driver"))) {
         if (virXMLPropEnum(driver, "name",
                            virDomainVideoBackendTypeFromString,
                            VIR_XML_PROP_NONZERO, &def->backend) < 0)
@@ -13072,7 +13040,7 @@ virDomainVideoDefParseXML(virDomainXMLOption *xmlopt,
     if (virDomainDeviceInfoParseXML(xmlopt, node, ctxt, &def->info, flags) < 0)
         return NULL;
 
-    def->driver = virDomainVideoDriverDefParseXML(node, ctxt);
+    def->driver = virDomainVideoDriverDefParseXML(node);
 
     return g_steal_pointer(&def);
 }
@@ -13084,11 +13052,8 @@ virDomainHostdevDefParseXML(virDomainXMLOption *xmlopt,
                             unsigned int flags)
 {
     virDomainHostdevDef *def;
-    VIR_XPATH_NODE_AUTORESTORE(ctxt)
     unsigned int type;
 
-    ctxt->node = node;
-
     if (!(def = virDomainHostdevDefNew()))
         goto error;
 
@@ -13134,9 +13099,9 @@ virDomainHostdevDefParseXML(virDomainXMLOption *xmlopt,
     if (def->mode == VIR_DOMAIN_HOSTDEV_MODE_SUBSYS) {
         switch (def->source.subsys.type) {
         case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_SCSI:
-            if (virXPathBoolean("boolean(./readonly)", ctxt))
+            if (virXMLNodeGetSubelement(node, "readonly"))
                 def->readonly = true;
-            if (virXPathBoolean("boolean(./shareable)", ctxt))
+            if (virXMLNodeGetSubelement(node, "shareable"))
                 def->shareable = true;
             break;
 
@@ -13149,7 +13114,7 @@ virDomainHostdevDefParseXML(virDomainXMLOption *xmlopt,
         }
     }
 
-    if (virDomainNetTeamingInfoParseXML(ctxt, &def->teaming) < 0)
+    if (virDomainNetTeamingInfoParseXML(node, &def->teaming) < 0)
         goto error;
 
     return def;
@@ -13996,7 +13961,7 @@ virDomainDeviceDefParse(const char *xmlStr,
         break;
     case VIR_DOMAIN_DEVICE_GRAPHICS:
         if (!(dev->data.graphics = virDomainGraphicsDefParseXML(xmlopt, node,
-                                                                ctxt, flags)))
+                                                                flags)))
             return NULL;
         break;
     case VIR_DOMAIN_DEVICE_HUB:
@@ -18680,6 +18645,7 @@ virDomainDefClockParse(virDomainDef *def,
 
 static int
 virDomainDefControllersParse(virDomainDef *def,
+                             virXMLChildIndex *devices,
                              xmlXPathContextPtr ctxt,
                              virDomainXMLOption *xmlopt,
                              unsigned int flags,
@@ -18691,7 +18657,7 @@ virDomainDefControllersParse(virDomainDef *def,
     size_t i;
     int n;
 
-    if ((n = virXPathNodeSet("./devices/controller", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "controller", &nodes)) < 0)
         return -1;
 
     if (n)
@@ -18753,6 +18719,8 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     g_autofree xmlNodePtr *nodes = NULL;
     g_autofree char *tmp = NULL;
     g_autoptr(virDomainDef) def = NULL;
+    g_autoptr(virXMLChildIndex) devices = virXMLChildIndexNew(NULL);
+    xmlNodePtr cur;
 
     if (!(def = virDomainDefNew(xmlopt)))
         return NULL;
@@ -18847,8 +18815,16 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     if (virDomainDefParseBootOptions(def, ctxt, xmlopt, flags) < 0)
         return NULL;
 
+    /* Devices are looked up by their element name in a single pass over
+     * <devices> rather than by an XPath expression per device type. */
+    for (cur = ctxt->node->children; cur; cur = cur->next) {
+        if (cur->type == XML_ELEMENT_NODE && !cur->ns &&
+            virXMLNodeNameEqual(cur, "devices"))
+            virXMLChildIndexAdd(devices, cur);
+    }
+
     /* analysis of the disk devices */
-    if ((n = virXPathNodeSet("./devices/disk", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "disk", &nodes)) < 0)
         return NULL;
 
     for (i = 0; i < n; i++) {
@@ -18863,11 +18839,12 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if (virDomainDefControllersParse(def, ctxt, xmlopt, flags, &usb_none) < 0)
+    if (virDomainDefControllersParse(def, devices, ctxt, xmlopt, flags,
+                                     &usb_none) < 0)
         return NULL;
 
     /* analysis of the resource leases */
-    if ((n = virXPathNodeSet("./devices/lease", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "lease", &nodes)) < 0)
         return NULL;
 
     if (n)
@@ -18882,7 +18859,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the filesystems */
-    if ((n = virXPathNodeSet("./devices/filesystem", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "filesystem", &nodes)) < 0)
         return NULL;
     if (n)
         def->fss = g_new0(virDomainFSDef *, n);
@@ -18899,7 +18876,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the network devices */
-    if ((n = virXPathNodeSet("./devices/interface", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "interface", &nodes)) < 0)
         return NULL;
     if (n)
         def->nets = g_new0(virDomainNetDef *, n);
@@ -18926,7 +18903,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
 
 
     /* analysis of the smartcard devices */
-    if ((n = virXPathNodeSet("./devices/smartcard", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "smartcard", &nodes)) < 0)
         return NULL;
     if (n)
         def->smartcards = g_new0(virDomainSmartcardDef *, n);
@@ -18945,7 +18922,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
 
 
     /* analysis of the character devices */
-    if ((n = virXPathNodeSet("./devices/parallel", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "parallel", &nodes)) < 0)
         return NULL;
     if (n)
         def->parallels = g_new0(virDomainChrDef *, n);
@@ -18970,7 +18947,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/serial", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "serial", &nodes)) < 0)
         return NULL;
 
     if (n)
@@ -18988,7 +18965,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/console", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "console", &nodes)) < 0)
         return NULL;
 
     if (n)
@@ -19007,7 +18984,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/channel", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "channel", &nodes)) < 0)
         return NULL;
     if (n)
         def->channels = g_new0(virDomainChrDef *, n);
@@ -19026,7 +19003,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
 
 
     /* analysis of the input devices */
-    if ((n = virXPathNodeSet("./devices/input", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "input", &nodes)) < 0)
         return NULL;
     if (n)
         def->inputs = g_new0(virDomainInputDef *, n);
@@ -19052,14 +19029,13 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the graphics devices */
-    if ((n = virXPathNodeSet("./devices/graphics", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "graphics", &nodes)) < 0)
         return NULL;
     if (n)
         def->graphics = g_new0(virDomainGraphicsDef *, n);
     for (i = 0; i < n; i++) {
         virDomainGraphicsDef *graphics = virDomainGraphicsDefParseXML(xmlopt,
                                                                       nodes[i],
-                                                                      ctxt,
                                                                       flags);
         if (!graphics)
             return NULL;
@@ -19069,7 +19045,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the sound devices */
-    if ((n = virXPathNodeSet("./devices/sound", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "sound", &nodes)) < 0)
         return NULL;
     if (n)
         def->sounds = g_new0(virDomainSoundDef *, n);
@@ -19086,7 +19062,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the audio devices */
-    if ((n = virXPathNodeSet("./devices/audio", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "audio", &nodes)) < 0)
         return NULL;
     if (n)
         def->audios = g_new0(virDomainAudioDef *, n);
@@ -19102,7 +19078,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the video devices */
-    if ((n = virXPathNodeSet("./devices/video", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "video", &nodes)) < 0)
         return NULL;
     if (n)
         def->videos = g_new0(virDomainVideoDef *, n);
@@ -19129,7 +19105,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the host devices */
-    if ((n = virXPathNodeSet("./devices/hostdev", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "hostdev", &nodes)) < 0)
         return NULL;
     if (n > 0)
         VIR_REALLOC_N(def->hostdevs, def->nhostdevs + n);
@@ -19164,7 +19140,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the watchdog devices */
-    n = virXPathNodeSet("./devices/watchdog", ctxt, &nodes);
+    n = virXMLChildIndexGetNodeSet(devices, "watchdog", &nodes);
     if (n < 0)
         return NULL;
     if (n)
@@ -19182,7 +19158,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
 
     /* analysis of the memballoon devices */
     def->memballoon = NULL;
-    if ((n = virXPathNodeSet("./devices/memballoon", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "memballoon", &nodes)) < 0)
         return NULL;
     if (n > 1) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
@@ -19201,7 +19177,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
 
     /* Parse the RNG devices */
-    if ((n = virXPathNodeSet("./devices/rng", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "rng", &nodes)) < 0)
         return NULL;
     if (n)
         def->rngs = g_new0(virDomainRNGDef *, n);
@@ -19216,7 +19192,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* Parse the crypto devices */
-    if ((n = virXPathNodeSet("./devices/crypto", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "crypto", &nodes)) < 0)
         return NULL;
     if (n)
         def->cryptos = g_new0(virDomainCryptoDef *, n);
@@ -19231,7 +19207,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* Parse the TPM devices */
-    if ((n = virXPathNodeSet("./devices/tpm", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "tpm", &nodes)) < 0)
         return NULL;
 
     if (n > 2) {
@@ -19253,7 +19229,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/nvram", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "nvram", &nodes)) < 0)
         return NULL;
 
     if (n > 1) {
@@ -19270,7 +19246,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
 
     /* analysis of the hub devices */
-    if ((n = virXPathNodeSet("./devices/hub", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "hub", &nodes)) < 0)
         return NULL;
     if (n)
         def->hubs = g_new0(virDomainHubDef *, n);
@@ -19293,7 +19269,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the redirected devices */
-    if ((n = virXPathNodeSet("./devices/redirdev", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "redirdev", &nodes)) < 0)
         return NULL;
     if (n)
         def->redirdevs = g_new0(virDomainRedirdevDef *, n);
@@ -19308,7 +19284,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the redirection filter rules */
-    if ((n = virXPathNodeSet("./devices/redirfilter", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "redirfilter", &nodes)) < 0)
         return NULL;
     if (n > 1) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
@@ -19327,7 +19303,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the panic devices */
-    if ((n = virXPathNodeSet("./devices/panic", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "panic", &nodes)) < 0)
         return NULL;
     if (n)
         def->panics = g_new0(virDomainPanicDef *, n);
@@ -19343,7 +19319,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     VIR_FREE(nodes);
 
     /* analysis of the shmem devices */
-    if ((n = virXPathNodeSet("./devices/shmem", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "shmem", &nodes)) < 0)
         return NULL;
     if (n)
         def->shmems = g_new0(virDomainShmemDef *, n);
@@ -19369,7 +19345,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
 
     /* analysis of memory devices */
-    if ((n = virXPathNodeSet("./devices/memory", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "memory", &nodes)) < 0)
         return NULL;
     if (n)
         def->mems = g_new0(virDomainMemoryDef *, n);
@@ -19386,7 +19362,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/iommu", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "iommu", &nodes)) < 0)
         return NULL;
 
     if (n > 1) {
@@ -19402,7 +19378,7 @@ virDomainDefParseXML(xmlXPathContextPtr ctxt,
     }
     VIR_FREE(nodes);
 
-    if ((n = virXPathNodeSet("./devices/vsock", ctxt, &nodes)) < 0)
+    if ((n = virXMLChildIndexGetNodeSet(devices, "vsock", &nodes)) < 0)
         return NULL;
 
     if (n > 1) {
@@ -28168,6 +28144,93 @@ virDomainDefFormatInternalSetRootName(virDomainDef *def,
 }
 
 
+/**
+ * virDomainDeviceDefFormat:
+ * @buf: buffer to format the device into
+ * @dev: device to format
+ * @xmlopt: XML parser configuration
+ * @flags: bitwise-OR of virDomainDefFormatFlags
+ *
+ * Formats @dev the same way as it appears in <devices> of the domain XML.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virDomainDeviceDefFormat(virBuffer *buf,
+                         virDomainDeviceDef *dev,
+                         virDomainXMLOption *xmlopt,
+                         unsigned int flags)
+{
+    switch ((virDomainDeviceType) dev->type) {
+    case VIR_DOMAIN_DEVICE_DISK:
+        return virDomainDiskDefFormat(buf, dev->data.disk, flags, xmlopt);
+    case VIR_DOMAIN_DEVICE_LEASE:
+        virDomainLeaseDefFormat(buf, dev->data.lease);
+        return 0;
+    case VIR_DOMAIN_DEVICE_FS:
+        return virDomainFSDefFormat(buf, dev->data.fs, flags);
+    case VIR_DOMAIN_DEVICE_NET:
+        return virDomainNetDefFormat(buf, dev->data.net, xmlopt, flags);
+    case VIR_DOMAIN_DEVICE_INPUT:
+        return virDomainInputDefFormat(buf, dev->data.input, flags);
+    case VIR_DOMAIN_DEVICE_SOUND:
+        return virDomainSoundDefFormat(buf, dev->data.sound, flags);
+    case VIR_DOMAIN_DEVICE_VIDEO:
+        return virDomainVideoDefFormat(buf, dev->data.video, flags);
+    case VIR_DOMAIN_DEVICE_HOSTDEV:
+        return virDomainHostdevDefFormat(buf, dev->data.hostdev, flags, xmlopt);
+    case VIR_DOMAIN_DEVICE_WATCHDOG:
+        return virDomainWatchdogDefFormat(buf, dev->data.watchdog, flags);
+    case VIR_DOMAIN_DEVICE_CONTROLLER:
+        return virDomainControllerDefFormat(buf, dev->data.controller, flags);
+    case VIR_DOMAIN_DEVICE_GRAPHICS:
+        return virDomainGraphicsDefFormat(buf, dev->data.graphics, flags);
+    case VIR_DOMAIN_DEVICE_HUB:
+        return virDomainHubDefFormat(buf, dev->data.hub, flags);
+    case VIR_DOMAIN_DEVICE_REDIRDEV:
+        return virDomainRedirdevDefFormat(buf, dev->data.redirdev, flags);
+    case VIR_DOMAIN_DEVICE_SMARTCARD:
+        return virDomainSmartcardDefFormat(buf, dev->data.smartcard, flags);
+    case VIR_DOMAIN_DEVICE_CHR:
+        return virDomainChrDefFormat(buf, dev->data.chr, flags);
+    case VIR_DOMAIN_DEVICE_MEMBALLOON:
+        return virDomainMemballoonDefFormat(buf, dev->data.memballoon, flags);
+    case VIR_DOMAIN_DEVICE_NVRAM:
+        virDomainNVRAMDefFormat(buf, dev->data.nvram, flags);
+        return 0;
+    case VIR_DOMAIN_DEVICE_RNG:
+        return virDomainRNGDefFormat(buf, dev->data.rng, flags);
+    case VIR_DOMAIN_DEVICE_SHMEM:
+        virDomainShmemDefFormat(buf, dev->data.shmem, flags);
+        return 0;
+    case VIR_DOMAIN_DEVICE_TPM:
+        return virDomainTPMDefFormat(buf, dev->data.tpm, flags, xmlopt);
+    case VIR_DOMAIN_DEVICE_PANIC:
+        virDomainPanicDefFormat(buf, dev->data.panic);
+        return 0;
+    case VIR_DOMAIN_DEVICE_MEMORY:
+        return virDomainMemoryDefFormat(buf, dev->data.memory, flags);
+    case VIR_DOMAIN_DEVICE_IOMMU:
+        virDomainIOMMUDefFormat(buf, dev->data.iommu);
+        return 0;
+    case VIR_DOMAIN_DEVICE_VSOCK:
+        virDomainVsockDefFormat(buf, dev->data.vsock);
+        return 0;
+    case VIR_DOMAIN_DEVICE_AUDIO:
+        return virDomainAudioDefFormat(buf, dev->data.audio);
+    case VIR_DOMAIN_DEVICE_CRYPTO:
+        virDomainCryptoDefFormat(buf, dev->data.crypto, flags);
+        return 0;
+    case VIR_DOMAIN_DEVICE_NONE:
+    case VIR_DOMAIN_DEVICE_LAST:
+        break;
+    }
+
+    virReportEnumRangeError(virDomainDeviceType, dev->type);
+    return -1;
+}
+
+
 /* Converts VIR_DOMAIN_XML_COMMON_FLAGS into VIR_DOMAIN_DEF_FORMAT_*
  * flags, and silently ignores any other flags.  Note that the caller
  * should validate the set of flags it is willing to accept; see also
@@ -28738,60 +28801,1423 @@ virDomainUSBDeviceDefForeach(virDomainDef *def,
 }
 
 
-/* Copy src into a new definition; with the quality of the copy
- * depending on the migratable flag (false for transitions between
- * persistent and active, true for transitions across save files or
- * snapshots).  */
-virDomainDef *
-virDomainDefCopy(virDomainDef *src,
-                 virDomainXMLOption *xmlopt,
-                 void *parseOpaque,
-                 bool migratable)
-{
-    unsigned int format_flags = VIR_DOMAIN_DEF_FORMAT_SECURE;
-    unsigned int parse_flags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
-                               VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
-    g_autofree char *xml = NULL;
-
-    if (migratable)
-        format_flags |= VIR_DOMAIN_DEF_FORMAT_INACTIVE | VIR_DOMAIN_DEF_FORMAT_MIGRATABLE;
+/*
+ * Native deep copy of domain definitions
+ *
+ * The functions below copy the parsed structures directly, which is much
+ * cheaper than formatting the definition into XML and parsing it back.
+ * Every copy function returns NULL on failure with an error reported.
+ * The private data are allocated fresh using @xmlopt and not copied, just
+ * like when the XML is parsed.
+ */
 
-    /* Easiest to clone via a round-trip through XML.  */
-    if (!(xml = virDomainDefFormat(src, xmlopt, format_flags)))
+static virDomainVirtioOptions *
+virDomainVirtioOptionsCopy(const virDomainVirtioOptions *src)
+{
+    if (!src)
         return NULL;
 
-    return virDomainDefParseString(xml, xmlopt, parseOpaque, parse_flags);
+    return g_memdup(src, sizeof(*src));
 }
 
-virDomainDef *
-virDomainObjCopyPersistentDef(virDomainObj *dom,
-                              virDomainXMLOption *xmlopt,
-                              void *parseOpaque)
+
+static void
+virDomainChrSourceDefCopySeclabels(virDomainChrSourceDef *dest,
+                                   const virDomainChrSourceDef *src)
 {
-    virDomainDef *cur;
+    size_t i;
 
-    cur = virDomainObjGetPersistentDef(xmlopt, dom, parseOpaque);
-    if (!cur) {
-        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
-                       _("failed to get persistent definition object"));
-        return NULL;
-    }
+    dest->seclabels = g_new0(virSecurityDeviceLabelDef *, src->nseclabels);
+    dest->nseclabels = src->nseclabels;
 
-    return virDomainDefCopy(cur, xmlopt, parseOpaque, false);
+    for (i = 0; i < src->nseclabels; i++)
+        dest->seclabels[i] = virSecurityDeviceLabelDefCopy(src->seclabels[i]);
 }
 
 
-virDomainState
-virDomainObjGetState(virDomainObj *dom, int *reason)
+static virDomainChrSourceDef *
+virDomainChrSourceDefCopyNew(const virDomainChrSourceDef *src,
+                             virDomainXMLOption *xmlopt)
 {
-    if (reason)
-        *reason = dom->state.reason;
+    virDomainChrSourceDef *ret;
 
-    return dom->state.state;
+    if (!src)
+        return NULL;
+
+    if (!(ret = virDomainChrSourceDefNew(xmlopt)))
+        return NULL;
+
+    virDomainChrSourceDefCopy(ret, src);
+    virDomainChrSourceDefCopySeclabels(ret, src);
+
+    return ret;
 }
 
 
-bool
+static virDomainDiskDef *
+virDomainDiskDefCopy(const virDomainDiskDef *src,
+                     virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virStorageSource) srcCopy = NULL;
+    g_autoptr(virStorageSource) mirror = NULL;
+    virDomainDiskDef *def;
+    virStorageSource *source;
+    virObject *privateData;
+    GSList *n;
+
+    if (!(srcCopy = virStorageSourceCopy(src->src, true)))
+        return NULL;
+
+    /* not handled by virStorageSourceCopy */
+    if (src->src->vhostuser &&
+        !(srcCopy->vhostuser = virDomainChrSourceDefCopyNew(src->src->vhostuser,
+                                                            xmlopt)))
+        return NULL;
+
+    if (src->mirror &&
+        !(mirror = virStorageSourceCopy(src->mirror, true)))
+        return NULL;
+
+    if (!(def = virDomainDiskDefNewSource(xmlopt, &srcCopy)))
+        return NULL;
+
+    source = def->src;
+    privateData = def->privateData;
+
+    *def = *src;
+
+    def->src = source;
+    def->privateData = privateData;
+    def->mirror = g_steal_pointer(&mirror);
+
+    def->dst = g_strdup(src->dst);
+    def->driverName = g_strdup(src->driverName);
+    def->serial = g_strdup(src->serial);
+    def->wwn = g_strdup(src->wwn);
+    def->vendor = g_strdup(src->vendor);
+    def->product = g_strdup(src->product);
+    def->domain_name = g_strdup(src->domain_name);
+    virDomainBlockIoTuneInfoCopy(&src->blkdeviotune, &def->blkdeviotune);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    def->iothreads = NULL;
+    for (n = src->iothreads; n; n = n->next) {
+        virDomainDiskIothreadDef *iothread = n->data;
+        virDomainDiskIothreadDef *copy = g_new0(virDomainDiskIothreadDef, 1);
+
+        copy->id = iothread->id;
+        copy->queues = g_memdup(iothread->queues,
+                                iothread->nqueues * sizeof(*iothread->queues));
+        copy->nqueues = iothread->nqueues;
+
+        def->iothreads = g_slist_prepend(def->iothreads, copy);
+    }
+    def->iothreads = g_slist_reverse(def->iothreads);
+
+    return def;
+}
+
+
+static virDomainControllerDef *
+virDomainControllerDefCopy(const virDomainControllerDef *src,
+                           virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainControllerDef *def = g_new0(virDomainControllerDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static virDomainNetDef *
+virDomainNetDefCopy(const virDomainNetDef *src,
+                    virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrSourceDef) vhostuser = NULL;
+    g_autoptr(virDomainNetDef) def = NULL;
+    virObject *privateData;
+    size_t i;
+
+    if (src->type == VIR_DOMAIN_NET_TYPE_VHOSTUSER &&
+        src->data.vhostuser &&
+        !(vhostuser = virDomainChrSourceDefCopyNew(src->data.vhostuser, xmlopt)))
+        return NULL;
+
+    if (!(def = virDomainNetDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+    *def = *src;
+    def->privateData = privateData;
+
+    def->modelstr = g_strdup(src->modelstr);
+
+    switch (src->type) {
+    case VIR_DOMAIN_NET_TYPE_VHOSTUSER:
+        def->data.vhostuser = g_steal_pointer(&vhostuser);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_VDPA:
+        def->data.vdpa.devicepath = g_strdup(src->data.vdpa.devicepath);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_SERVER:
+    case VIR_DOMAIN_NET_TYPE_CLIENT:
+    case VIR_DOMAIN_NET_TYPE_MCAST:
+    case VIR_DOMAIN_NET_TYPE_UDP:
+        def->data.socket.address = g_strdup(src->data.socket.address);
+        def->data.socket.localaddr = g_strdup(src->data.socket.localaddr);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_NETWORK:
+        def->data.network.name = g_strdup(src->data.network.name);
+        def->data.network.portgroup = g_strdup(src->data.network.portgroup);
+        /* the actual network device is runtime state which the XML parser
+         * ignores for inactive definitions as well */
+        def->data.network.actual = NULL;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_BRIDGE:
+        def->data.bridge.brname = g_strdup(src->data.bridge.brname);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_INTERNAL:
+        def->data.internal.name = g_strdup(src->data.internal.name);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_DIRECT:
+        def->data.direct.linkdev = g_strdup(src->data.direct.linkdev);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_VDS:
+        def->data.vds.portgroup_id = g_strdup(src->data.vds.portgroup_id);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+        /* rejected by virDomainDefCopyIsSupported */
+    case VIR_DOMAIN_NET_TYPE_ETHERNET:
+    case VIR_DOMAIN_NET_TYPE_USER:
+    case VIR_DOMAIN_NET_TYPE_NULL:
+    case VIR_DOMAIN_NET_TYPE_LAST:
+        break;
+    }
+
+    def->backend.tap = g_strdup(src->backend.tap);
+    def->backend.vhost = g_strdup(src->backend.vhost);
+    def->backend.logFile = g_strdup(src->backend.logFile);
+
+    if (src->teaming) {
+        def->teaming = g_new0(virDomainNetTeamingInfo, 1);
+        def->teaming->type = src->teaming->type;
+        def->teaming->persistent = g_strdup(src->teaming->persistent);
+    }
+
+    def->virtPortProfile = virNetDevVPortProfileCopy(src->virtPortProfile);
+    def->script = g_strdup(src->script);
+    def->downscript = g_strdup(src->downscript);
+    def->domain_name = g_strdup(src->domain_name);
+    def->ifname = g_strdup(src->ifname);
+    def->ifname_guest_actual = g_strdup(src->ifname_guest_actual);
+    def->ifname_guest = g_strdup(src->ifname_guest);
+    def->sourceDev = g_strdup(src->sourceDev);
+
+    memset(&def->hostIP, 0, sizeof(def->hostIP));
+    virNetDevIPInfoCopy(&def->hostIP, &src->hostIP);
+    memset(&def->guestIP, 0, sizeof(def->guestIP));
+    virNetDevIPInfoCopy(&def->guestIP, &src->guestIP);
+
+    def->portForwards = g_new0(virDomainNetPortForward *, src->nPortForwards);
+    for (i = 0; i < src->nPortForwards; i++) {
+        const virDomainNetPortForward *pf = src->portForwards[i];
+        virDomainNetPortForward *copy = g_new0(virDomainNetPortForward, 1);
+        size_t j;
+
+        *copy = *pf;
+        copy->dev = g_strdup(pf->dev);
+        copy->ranges = g_new0(virDomainNetPortForwardRange *, pf->nRanges);
+        for (j = 0; j < pf->nRanges; j++)
+            copy->ranges[j] = g_memdup(pf->ranges[j], sizeof(*pf->ranges[j]));
+
+        def->portForwards[i] = copy;
+    }
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    virNetDevBandwidthCopy(&def->bandwidth, src->bandwidth);
+    memset(&def->vlan, 0, sizeof(def->vlan));
+    virNetDevVlanCopy(&def->vlan, &src->vlan);
+
+    def->coalesce = NULL;
+    if (src->coalesce)
+        def->coalesce = g_memdup(src->coalesce, sizeof(*src->coalesce));
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    def->filter = g_strdup(src->filter);
+    def->filterparams = NULL;
+    if (src->filterparams) {
+        def->filterparams = virHashNew(virNWFilterVarValueHashFree);
+        if (virNWFilterHashTablePutAll(src->filterparams, def->filterparams) < 0)
+            return NULL;
+    }
+
+    return g_steal_pointer(&def);
+}
+
+
+static virDomainInputDef *
+virDomainInputDefCopy(const virDomainInputDef *src,
+                      virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainInputDef *def = g_new0(virDomainInputDef, 1);
+
+    *def = *src;
+    def->source.evdev = g_strdup(src->source.evdev);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static virDomainSoundDef *
+virDomainSoundDefCopy(const virDomainSoundDef *src,
+                      virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainSoundDef *def = g_new0(virDomainSoundDef, 1);
+    size_t i;
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    def->codecs = g_new0(virDomainSoundCodecDef *, src->ncodecs);
+    for (i = 0; i < src->ncodecs; i++)
+        def->codecs[i] = g_memdup(src->codecs[i], sizeof(*src->codecs[i]));
+
+    return def;
+}
+
+
+static virDomainAudioDef *
+virDomainAudioDefCopy(const virDomainAudioDef *src,
+                      virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainAudioDef *def = g_new0(virDomainAudioDef, 1);
+
+    *def = *src;
+
+    switch (src->type) {
+    case VIR_DOMAIN_AUDIO_TYPE_ALSA:
+        def->backend.alsa.input.dev = g_strdup(src->backend.alsa.input.dev);
+        def->backend.alsa.output.dev = g_strdup(src->backend.alsa.output.dev);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_JACK:
+        def->backend.jack.input.serverName = g_strdup(src->backend.jack.input.serverName);
+        def->backend.jack.input.clientName = g_strdup(src->backend.jack.input.clientName);
+        def->backend.jack.input.connectPorts = g_strdup(src->backend.jack.input.connectPorts);
+        def->backend.jack.output.serverName = g_strdup(src->backend.jack.output.serverName);
+        def->backend.jack.output.clientName = g_strdup(src->backend.jack.output.clientName);
+        def->backend.jack.output.connectPorts = g_strdup(src->backend.jack.output.connectPorts);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_OSS:
+        def->backend.oss.input.dev = g_strdup(src->backend.oss.input.dev);
+        def->backend.oss.output.dev = g_strdup(src->backend.oss.output.dev);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_PULSEAUDIO:
+        def->backend.pulseaudio.input.name = g_strdup(src->backend.pulseaudio.input.name);
+        def->backend.pulseaudio.input.streamName = g_strdup(src->backend.pulseaudio.input.streamName);
+        def->backend.pulseaudio.output.name = g_strdup(src->backend.pulseaudio.output.name);
+        def->backend.pulseaudio.output.streamName = g_strdup(src->backend.pulseaudio.output.streamName);
+        def->backend.pulseaudio.serverName = g_strdup(src->backend.pulseaudio.serverName);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_FILE:
+        def->backend.file.path = g_strdup(src->backend.file.path);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_PIPEWIRE:
+        def->backend.pipewire.input.name = g_strdup(src->backend.pipewire.input.name);
+        def->backend.pipewire.input.streamName = g_strdup(src->backend.pipewire.input.streamName);
+        def->backend.pipewire.output.name = g_strdup(src->backend.pipewire.output.name);
+        def->backend.pipewire.output.streamName = g_strdup(src->backend.pipewire.output.streamName);
+        def->backend.pipewire.runtimeDir = g_strdup(src->backend.pipewire.runtimeDir);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_NONE:
+    case VIR_DOMAIN_AUDIO_TYPE_COREAUDIO:
+    case VIR_DOMAIN_AUDIO_TYPE_SDL:
+    case VIR_DOMAIN_AUDIO_TYPE_SPICE:
+    case VIR_DOMAIN_AUDIO_TYPE_DBUS:
+    case VIR_DOMAIN_AUDIO_TYPE_LAST:
+        break;
+    }
+
+    return def;
+}
+
+
+static virDomainVideoDef *
+virDomainVideoDefCopy(const virDomainVideoDef *src,
+                      virDomainXMLOption *xmlopt)
+{
+    virDomainVideoDef *def;
+    virObject *privateData;
+
+    if (!(def = virDomainVideoDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+    *def = *src;
+    def->privateData = privateData;
+
+    if (src->accel) {
+        def->accel = g_memdup(src->accel, sizeof(*src->accel));
+        def->accel->rendernode = g_strdup(src->accel->rendernode);
+    }
+
+    if (src->res)
+        def->res = g_memdup(src->res, sizeof(*src->res));
+
+    if (src->driver) {
+        def->driver = g_memdup(src->driver, sizeof(*src->driver));
+        def->driver->vhost_user_binary = g_strdup(src->driver->vhost_user_binary);
+    }
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static void
+virDomainGraphicsAuthDefCopy(virDomainGraphicsAuthDef *dst,
+                             const virDomainGraphicsAuthDef *src)
+{
+    *dst = *src;
+    dst->passwd = g_strdup(src->passwd);
+}
+
+
+static virDomainGraphicsDef *
+virDomainGraphicsDefCopy(const virDomainGraphicsDef *src,
+                         virDomainXMLOption *xmlopt)
+{
+    virDomainGraphicsDef *def;
+    virObject *privateData;
+    size_t i;
+
+    if (!(def = virDomainGraphicsDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+    *def = *src;
+    def->privateData = privateData;
+
+    switch (src->type) {
+    case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
+        def->data.vnc.keymap = g_strdup(src->data.vnc.keymap);
+        virDomainGraphicsAuthDefCopy(&def->data.vnc.auth, &src->data.vnc.auth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
+        def->data.sdl.display = g_strdup(src->data.sdl.display);
+        def->data.sdl.xauth = g_strdup(src->data.sdl.xauth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
+        def->data.desktop.display = g_strdup(src->data.desktop.display);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
+        def->data.spice.keymap = g_strdup(src->data.spice.keymap);
+        def->data.spice.rendernode = g_strdup(src->data.spice.rendernode);
+        virDomainGraphicsAuthDefCopy(&def->data.spice.auth, &src->data.spice.auth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
+        def->data.egl_headless.rendernode = g_strdup(src->data.egl_headless.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DBUS:
+        def->data.dbus.address = g_strdup(src->data.dbus.address);
+        def->data.dbus.rendernode = g_strdup(src->data.dbus.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
+    case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
+        break;
+    }
+
+    def->listens = g_new0(virDomainGraphicsListenDef, src->nListens);
+    for (i = 0; i < src->nListens; i++) {
+        def->listens[i] = src->listens[i];
+        def->listens[i].address = g_strdup(src->listens[i].address);
+        def->listens[i].network = g_strdup(src->listens[i].network);
+        def->listens[i].socket = g_strdup(src->listens[i].socket);
+    }
+
+    return def;
+}
+
+
+static virDomainChrDef *
+virDomainChrDefCopy(const virDomainChrDef *src,
+                    virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrDef) def = NULL;
+    virDomainChrSourceDef *source;
+
+    if (!(def = virDomainChrDefNew(xmlopt)))
+        return NULL;
+
+    source = def->source;
+    *def = *src;
+    def->source = source;
+
+    virDomainChrSourceDefCopy(def->source, src->source);
+    virDomainChrSourceDefCopySeclabels(def->source, src->source);
+
+    if (src->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL) {
+        switch (src->targetType) {
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_GUESTFWD:
+            if (src->target.addr)
+                def->target.addr = g_memdup(src->target.addr,
+                                            sizeof(*src->target.addr));
+            break;
+
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_XEN:
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_VIRTIO:
+            def->target.name = g_strdup(src->target.name);
+            break;
+        }
+    }
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return g_steal_pointer(&def);
+}
+
+
+static virDomainHubDef *
+virDomainHubDefCopy(const virDomainHubDef *src,
+                    virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainHubDef *def = g_new0(virDomainHubDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainRedirdevDef *
+virDomainRedirdevDefCopy(const virDomainRedirdevDef *src,
+                         virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrSourceDef) source = NULL;
+    virDomainRedirdevDef *def;
+
+    if (src->source &&
+        !(source = virDomainChrSourceDefCopyNew(src->source, xmlopt)))
+        return NULL;
+
+    def = g_new0(virDomainRedirdevDef, 1);
+    *def = *src;
+    def->source = g_steal_pointer(&source);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainRNGDef *
+virDomainRNGDefCopy(const virDomainRNGDef *src,
+                    virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrSourceDef) chardev = NULL;
+    virDomainRNGDef *def;
+
+    if (src->backend == VIR_DOMAIN_RNG_BACKEND_EGD &&
+        src->source.chardev &&
+        !(chardev = virDomainChrSourceDefCopyNew(src->source.chardev, xmlopt)))
+        return NULL;
+
+    def = g_new0(virDomainRNGDef, 1);
+    *def = *src;
+
+    switch (src->backend) {
+    case VIR_DOMAIN_RNG_BACKEND_RANDOM:
+        def->source.file = g_strdup(src->source.file);
+        break;
+    case VIR_DOMAIN_RNG_BACKEND_EGD:
+        def->source.chardev = g_steal_pointer(&chardev);
+        break;
+    case VIR_DOMAIN_RNG_BACKEND_BUILTIN:
+    case VIR_DOMAIN_RNG_BACKEND_LAST:
+        break;
+    }
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static virDomainTPMDef *
+virDomainTPMDefCopy(const virDomainTPMDef *src,
+                    virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrSourceDef) source = NULL;
+    const virDomainChrSourceDef *srcSource = NULL;
+    virDomainTPMDef *def;
+    virObject *privateData;
+
+    switch (src->type) {
+    case VIR_DOMAIN_TPM_TYPE_PASSTHROUGH:
+        srcSource = src->data.passthrough.source;
+        break;
+    case VIR_DOMAIN_TPM_TYPE_EMULATOR:
+        srcSource = src->data.emulator.source;
+        break;
+    case VIR_DOMAIN_TPM_TYPE_EXTERNAL:
+        srcSource = src->data.external.source;
+        break;
+    case VIR_DOMAIN_TPM_TYPE_LAST:
+        break;
+    }
+
+    if (srcSource &&
+        !(source = virDomainChrSourceDefCopyNew(srcSource, xmlopt)))
+        return NULL;
+
+    if (!(def = virDomainTPMDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+    *def = *src;
+    def->privateData = privateData;
+
+    switch (src->type) {
+    case VIR_DOMAIN_TPM_TYPE_PASSTHROUGH:
+        def->data.passthrough.source = g_steal_pointer(&source);
+        break;
+    case VIR_DOMAIN_TPM_TYPE_EMULATOR:
+        def->data.emulator.source = g_steal_pointer(&source);
+        def->data.emulator.storagepath = g_strdup(src->data.emulator.storagepath);
+        def->data.emulator.logfile = g_strdup(src->data.emulator.logfile);
+        if (src->data.emulator.activePcrBanks)
+            def->data.emulator.activePcrBanks = virBitmapNewCopy(src->data.emulator.activePcrBanks);
+        break;
+    case VIR_DOMAIN_TPM_TYPE_EXTERNAL:
+        def->data.external.source = g_steal_pointer(&source);
+        break;
+    case VIR_DOMAIN_TPM_TYPE_LAST:
+        break;
+    }
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainPanicDef *
+virDomainPanicDefCopy(const virDomainPanicDef *src,
+                      virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainPanicDef *def = g_new0(virDomainPanicDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainWatchdogDef *
+virDomainWatchdogDefCopy(const virDomainWatchdogDef *src,
+                         virDomainXMLOption *xmlopt G_GNUC_UNUSED)
+{
+    virDomainWatchdogDef *def = g_new0(virDomainWatchdogDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainMemballoonDef *
+virDomainMemballoonDefCopy(const virDomainMemballoonDef *src)
+{
+    virDomainMemballoonDef *def = g_new0(virDomainMemballoonDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static virDomainNVRAMDef *
+virDomainNVRAMDefCopy(const virDomainNVRAMDef *src)
+{
+    virDomainNVRAMDef *def = g_new0(virDomainNVRAMDef, 1);
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainIOMMUDef *
+virDomainIOMMUDefCopy(const virDomainIOMMUDef *src)
+{
+    virDomainIOMMUDef *def = g_new0(virDomainIOMMUDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainVsockDef *
+virDomainVsockDefCopy(const virDomainVsockDef *src,
+                      virDomainXMLOption *xmlopt)
+{
+    virDomainVsockDef *def;
+    virObject *privateData;
+
+    if (!(def = virDomainVsockDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+    *def = *src;
+    def->privateData = privateData;
+
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    return def;
+}
+
+
+static virDomainRedirFilterDef *
+virDomainRedirFilterDefCopy(const virDomainRedirFilterDef *src)
+{
+    virDomainRedirFilterDef *def = g_new0(virDomainRedirFilterDef, 1);
+    size_t i;
+
+    def->usbdevs = g_new0(virDomainRedirFilterUSBDevDef *, src->nusbdevs);
+    def->nusbdevs = src->nusbdevs;
+
+    for (i = 0; i < src->nusbdevs; i++)
+        def->usbdevs[i] = g_memdup(src->usbdevs[i], sizeof(*src->usbdevs[i]));
+
+    return def;
+}
+
+
+static int
+virDomainOSDefCopy(virDomainOSDef *dst,
+                   const virDomainOSDef *src)
+{
+    g_autoptr(virStorageSource) nvram = NULL;
+    size_t i;
+
+    if (src->loader && src->loader->nvram &&
+        !(nvram = virStorageSourceCopy(src->loader->nvram, true)))
+        return -1;
+
+    *dst = *src;
+
+    if (src->firmwareFeatures)
+        dst->firmwareFeatures = g_memdup(src->firmwareFeatures,
+                                         VIR_DOMAIN_OS_DEF_FIRMWARE_FEATURE_LAST *
+                                         sizeof(*src->firmwareFeatures));
+
+    dst->machine = g_strdup(src->machine);
+    dst->init = g_strdup(src->init);
+    dst->initargv = g_strdupv(src->initargv);
+
+    dst->initenv = NULL;
+    if (src->initenv) {
+        size_t n = 0;
+
+        while (src->initenv[n])
+            n++;
+
+        dst->initenv = g_new0(virDomainOSEnv *, n + 1);
+        for (i = 0; i < n; i++) {
+            dst->initenv[i] = g_new0(virDomainOSEnv, 1);
+            dst->initenv[i]->name = g_strdup(src->initenv[i]->name);
+            dst->initenv[i]->value = g_strdup(src->initenv[i]->value);
+        }
+    }
+
+    dst->initdir = g_strdup(src->initdir);
+    dst->inituser = g_strdup(src->inituser);
+    dst->initgroup = g_strdup(src->initgroup);
+    dst->kernel = g_strdup(src->kernel);
+    dst->initrd = g_strdup(src->initrd);
+    dst->cmdline = g_strdup(src->cmdline);
+    dst->dtb = g_strdup(src->dtb);
+    dst->root = g_strdup(src->root);
+    dst->slic_table = g_strdup(src->slic_table);
+
+    if (src->loader) {
+        dst->loader = g_memdup(src->loader, sizeof(*src->loader));
+        dst->loader->path = g_strdup(src->loader->path);
+        dst->loader->nvram = g_steal_pointer(&nvram);
+        dst->loader->nvramTemplate = g_strdup(src->loader->nvramTemplate);
+    }
+
+    dst->bootloader = g_strdup(src->bootloader);
+    dst->bootloaderArgs = g_strdup(src->bootloaderArgs);
+
+    return 0;
+}
+
+
+static void
+virDomainClockDefCopy(virDomainClockDef *dst,
+                      const virDomainClockDef *src)
+{
+    size_t i;
+
+    *dst = *src;
+
+    if (src->offset == VIR_DOMAIN_CLOCK_OFFSET_TIMEZONE)
+        dst->data.timezone = g_strdup(src->data.timezone);
+
+    dst->timers = g_new0(virDomainTimerDef *, src->ntimers);
+    for (i = 0; i < src->ntimers; i++)
+        dst->timers[i] = g_memdup(src->timers[i], sizeof(*src->timers[i]));
+}
+
+
+/**
+ * virDomainDefCopyIsSupported:
+ * @def: domain definition
+ *
+ * Returns true if all parts of @def can be copied by virDomainDefCopyNative,
+ * false if the definition has to be copied through XML.
+ */
+static bool
+virDomainDefCopyIsSupported(const virDomainDef *def)
+{
+    if (def->namespaceData) {
+        VIR_DEBUG("domain '%s': XML namespace data can't be copied", def->name);
+        return false;
+    }
+
+    /* Devices which are rarely used or own state shared with other parts
+     * of the definition (e.g. hostdevs of network interfaces) are copied
+     * through XML. */
+    if (def->nresctrls || def->nsysinfo || def->sec ||
+        def->nfss || def->nhostdevs || def->nsmartcards || def->nleases ||
+        def->nshmems || def->nmems || def->ncryptos) {
+        VIR_DEBUG("domain '%s' has devices which are copied through XML",
+                  def->name);
+        return false;
+    }
+
+    return true;
+}
+
+
+#define VIR_DOMAIN_DEF_COPY_DEVICES(dst, src, xmlopt, field, nfield, copyFunc) \
+    do { \
+        size_t _i; \
+        (dst)->field = g_new0(typeof(*(dst)->field), (src)->nfield); \
+        for (_i = 0; _i < (src)->nfield; _i++) { \
+            if (!((dst)->field[_i] = copyFunc((src)->field[_i], xmlopt))) \
+                return NULL; \
+            (dst)->nfield++; \
+        } \
+    } while (0)
+
+
+/**
+ * virDomainDefCopyNative:
+ * @src: domain definition to copy
+ * @xmlopt: XML parser configuration
+ *
+ * Deep-copies @src without going through the XML formatter and parser.
+ * Callers must check virDomainDefCopyIsSupported first.
+ *
+ * Returns the copy on success, NULL on error.
+ */
+static virDomainDef *
+virDomainDefCopyNative(const virDomainDef *src,
+                       virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainDef) def = NULL;
+    size_t i;
+
+    if (!(def = virDomainDefNew(xmlopt)))
+        return NULL;
+
+    def->virtType = src->virtType;
+    def->id = src->id;
+    memcpy(def->uuid, src->uuid, VIR_UUID_BUFLEN);
+    memcpy(def->genid, src->genid, VIR_UUID_BUFLEN);
+    def->genidRequested = src->genidRequested;
+    def->genidGenerated = src->genidGenerated;
+
+    def->name = g_strdup(src->name);
+    def->title = g_strdup(src->title);
+    def->description = g_strdup(src->description);
+
+    def->blkio.weight = src->blkio.weight;
+    def->blkio.devices = g_new0(virBlkioDevice, src->blkio.ndevices);
+    def->blkio.ndevices = src->blkio.ndevices;
+    for (i = 0; i < src->blkio.ndevices; i++) {
+        def->blkio.devices[i] = src->blkio.devices[i];
+        def->blkio.devices[i].path = g_strdup(src->blkio.devices[i].path);
+    }
+
+    def->mem = src->mem;
+    def->mem.hugepages = g_new0(virDomainHugePage, src->mem.nhugepages);
+    for (i = 0; i < src->mem.nhugepages; i++) {
+        def->mem.hugepages[i].size = src->mem.hugepages[i].size;
+        if (src->mem.hugepages[i].nodemask)
+            def->mem.hugepages[i].nodemask = virBitmapNewCopy(src->mem.hugepages[i].nodemask);
+    }
+
+    if (virDomainDefSetVcpusMax(def, src->maxvcpus, xmlopt) < 0)
+        return NULL;
+
+    for (i = 0; i < src->maxvcpus; i++) {
+        virDomainVcpuDef *vcpu = def->vcpus[i];
+
+        vcpu->online = src->vcpus[i]->online;
+        vcpu->hotpluggable = src->vcpus[i]->hotpluggable;
+        vcpu->order = src->vcpus[i]->order;
+        vcpu->sched = src->vcpus[i]->sched;
+        if (src->vcpus[i]->cpumask)
+            vcpu->cpumask = virBitmapNewCopy(src->vcpus[i]->cpumask);
+    }
+
+    def->individualvcpus = src->individualvcpus;
+    def->placement_mode = src->placement_mode;
+    if (src->cpumask)
+        def->cpumask = virBitmapNewCopy(src->cpumask);
+
+    def->iothreadids = g_new0(virDomainIOThreadIDDef *, src->niothreadids);
+    def->niothreadids = src->niothreadids;
+    for (i = 0; i < src->niothreadids; i++) {
+        def->iothreadids[i] = g_memdup(src->iothreadids[i],
+                                       sizeof(*src->iothreadids[i]));
+        if (src->iothreadids[i]->cpumask)
+            def->iothreadids[i]->cpumask = virBitmapNewCopy(src->iothreadids[i]->cpumask);
+    }
+
+    if (src->defaultIOThread)
+        def->defaultIOThread = g_memdup(src->defaultIOThread,
+                                        sizeof(*src->defaultIOThread));
+
+    def->cputune = src->cputune;
+    def->cputune.emulatorpin = NULL;
+    def->cputune.emulatorsched = NULL;
+    if (src->cputune.emulatorpin)
+        def->cputune.emulatorpin = virBitmapNewCopy(src->cputune.emulatorpin);
+    if (src->cputune.emulatorsched)
+        def->cputune.emulatorsched = g_memdup(src->cputune.emulatorsched,
+                                              sizeof(*src->cputune.emulatorsched));
+
+    virDomainNumaFree(def->numa);
+    def->numa = virDomainNumaCopy(src->numa);
+
+    if (src->resource) {
+        def->resource = g_new0(virDomainResourceDef, 1);
+        def->resource->partition = g_strdup(src->resource->partition);
+        def->resource->appid = g_strdup(src->resource->appid);
+    }
+
+    def->idmap.uidmap = g_memdup(src->idmap.uidmap,
+                                 src->idmap.nuidmap * sizeof(*src->idmap.uidmap));
+    def->idmap.nuidmap = src->idmap.nuidmap;
+    def->idmap.gidmap = g_memdup(src->idmap.gidmap,
+                                 src->idmap.ngidmap * sizeof(*src->idmap.gidmap));
+    def->idmap.ngidmap = src->idmap.ngidmap;
+
+    def->onReboot = src->onReboot;
+    def->onPoweroff = src->onPoweroff;
+    def->onCrash = src->onCrash;
+    def->onLockFailure = src->onLockFailure;
+    def->pm = src->pm;
+    def->perf = src->perf;
+
+    if (virDomainOSDefCopy(&def->os, &src->os) < 0)
+        return NULL;
+
+    def->emulator = g_strdup(src->emulator);
+
+    memcpy(def->features, src->features, sizeof(src->features));
+    memcpy(def->caps_features, src->caps_features, sizeof(src->caps_features));
+    memcpy(def->hyperv_features, src->hyperv_features, sizeof(src->hyperv_features));
+    if (src->kvm_features)
+        def->kvm_features = g_memdup(src->kvm_features, sizeof(*src->kvm_features));
+    memcpy(def->msrs_features, src->msrs_features, sizeof(src->msrs_features));
+    memcpy(def->xen_features, src->xen_features, sizeof(src->xen_features));
+    def->xen_passthrough_mode = src->xen_passthrough_mode;
+    def->hyperv_spinlocks = src->hyperv_spinlocks;
+    def->hyperv_stimer_direct = src->hyperv_stimer_direct;
+    def->gic_version = src->gic_version;
+    def->hpt_resizing = src->hpt_resizing;
+    def->hpt_maxpagesize = src->hpt_maxpagesize;
+    def->hyperv_vendor_id = g_strdup(src->hyperv_vendor_id);
+    def->apic_eoi = src->apic_eoi;
+    if (src->tcg_features)
+        def->tcg_features = g_memdup(src->tcg_features, sizeof(*src->tcg_features));
+    def->tseg_specified = src->tseg_specified;
+    def->tseg_size = src->tseg_size;
+
+    virDomainClockDefCopy(&def->clock, &src->clock);
+
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, graphics, ngraphics, virDomainGraphicsDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, disks, ndisks, virDomainDiskDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, controllers, ncontrollers, virDomainControllerDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, nets, nnets, virDomainNetDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, inputs, ninputs, virDomainInputDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, sounds, nsounds, virDomainSoundDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, audios, naudios, virDomainAudioDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, videos, nvideos, virDomainVideoDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, redirdevs, nredirdevs, virDomainRedirdevDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, serials, nserials, virDomainChrDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, parallels, nparallels, virDomainChrDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, channels, nchannels, virDomainChrDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, consoles, nconsoles, virDomainChrDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, hubs, nhubs, virDomainHubDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, rngs, nrngs, virDomainRNGDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, panics, npanics, virDomainPanicDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, watchdogs, nwatchdogs, virDomainWatchdogDefCopy);
+    VIR_DOMAIN_DEF_COPY_DEVICES(def, src, xmlopt, tpms, ntpms, virDomainTPMDefCopy);
+
+    def->seclabels = g_new0(virSecurityLabelDef *, src->nseclabels);
+    def->nseclabels = src->nseclabels;
+    for (i = 0; i < src->nseclabels; i++)
+        def->seclabels[i] = virSecurityLabelDefCopy(src->seclabels[i]);
+
+    if (src->memballoon)
+        def->memballoon = virDomainMemballoonDefCopy(src->memballoon);
+    if (src->nvram)
+        def->nvram = virDomainNVRAMDefCopy(src->nvram);
+    if (src->cpu)
+        def->cpu = virCPUDefCopy(src->cpu);
+    if (src->redirfilter)
+        def->redirfilter = virDomainRedirFilterDefCopy(src->redirfilter);
+    if (src->iommu)
+        def->iommu = virDomainIOMMUDefCopy(src->iommu);
+    if (src->vsock &&
+        !(def->vsock = virDomainVsockDefCopy(src->vsock, xmlopt)))
+        return NULL;
+
+    def->ns = src->ns;
+
+    if (src->keywrap)
+        def->keywrap = g_memdup(src->keywrap, sizeof(*src->keywrap));
+
+    if (src->metadata)
+        def->metadata = xmlCopyNode(src->metadata, 1);
+
+    def->postParseFailed = src->postParseFailed;
+    def->scsiBusMaxUnit = src->scsiBusMaxUnit;
+
+    return g_steal_pointer(&def);
+}
+
+#undef VIR_DOMAIN_DEF_COPY_DEVICES
+
+
+static void
+virDomainChrSourceDefClearRuntime(virDomainChrSourceDef *src)
+{
+    if (!src)
+        return;
+
+    if (src->type == VIR_DOMAIN_CHR_TYPE_PTY)
+        g_clear_pointer(&src->data.file.path, g_free);
+    else if (src->type == VIR_DOMAIN_CHR_TYPE_TCP)
+        src->data.tcp.tlsFromConfig = false;
+}
+
+
+static void
+virDomainDiskDefClearRuntime(virDomainDiskDef *disk)
+{
+    virStorageSource *n;
+    size_t i;
+
+    g_clear_pointer(&disk->mirror, virObjectUnref);
+    disk->mirrorState = VIR_DOMAIN_DISK_MIRROR_STATE_NONE;
+    disk->mirrorJob = VIR_DOMAIN_BLOCK_JOB_TYPE_UNKNOWN;
+
+    for (n = disk->src; virStorageSourceIsBacking(n); n = n->backingStore) {
+        n->id = 0;
+        n->tlsFromConfig = false;
+
+        for (i = 0; i < n->nseclabels; i++)
+            n->seclabels[i]->labelskip = false;
+    }
+}
+
+
+static void
+virDomainNetDefClearRuntime(virDomainNetDef *net,
+                            virDomainXMLOption *xmlopt)
+{
+    const char *prefix = xmlopt ? xmlopt->config.netPrefix : NULL;
+
+    if (net->type == VIR_DOMAIN_NET_TYPE_NETWORK)
+        memset(net->data.network.portid, 0, VIR_UUID_BUFLEN);
+
+    if (net->managed_tap != VIR_TRISTATE_BOOL_NO && net->ifname &&
+        (STRPREFIX(net->ifname, VIR_NET_GENERATED_VNET_PREFIX) ||
+         STRPREFIX(net->ifname, VIR_NET_GENERATED_MACVTAP_PREFIX) ||
+         STRPREFIX(net->ifname, VIR_NET_GENERATED_MACVLAN_PREFIX) ||
+         (prefix && STRPREFIX(net->ifname, prefix))))
+        g_clear_pointer(&net->ifname, g_free);
+}
+
+
+static void
+virDomainGraphicsDefClearRuntime(virDomainGraphicsDef *graphics)
+{
+    size_t i;
+
+    switch (graphics->type) {
+    case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
+        if (graphics->data.vnc.autoport)
+            graphics->data.vnc.port = 0;
+        break;
+    case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
+        if (graphics->data.rdp.autoport)
+            graphics->data.rdp.port = 0;
+        break;
+    case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
+        if (graphics->data.spice.autoport) {
+            graphics->data.spice.port = 0;
+            graphics->data.spice.tlsPort = 0;
+        }
+        break;
+    case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
+    case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
+    case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
+    case VIR_DOMAIN_GRAPHICS_TYPE_DBUS:
+    case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
+        break;
+    }
+
+    for (i = 0; i < graphics->nListens; i++) {
+        virDomainGraphicsListenDef *listen = &graphics->listens[i];
+
+        if (listen->type == VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_NETWORK)
+            g_clear_pointer(&listen->address, g_free);
+
+        listen->fromConfig = false;
+        listen->autoGenerated = false;
+    }
+}
+
+
+static int
+virDomainDefClearRuntimeDevice(virDomainDef *def G_GNUC_UNUSED,
+                               virDomainDeviceDef *dev,
+                               virDomainDeviceInfo *info,
+                               void *opaque)
+{
+    virDomainXMLOption *xmlopt = opaque;
+
+    if (info && info->alias &&
+        !virDomainDeviceAliasIsValidUserAlias(xmlopt, info->alias))
+        g_clear_pointer(&info->alias, g_free);
+
+    switch ((virDomainDeviceType) dev->type) {
+    case VIR_DOMAIN_DEVICE_DISK:
+        virDomainDiskDefClearRuntime(dev->data.disk);
+        break;
+    case VIR_DOMAIN_DEVICE_NET:
+        virDomainNetDefClearRuntime(dev->data.net, xmlopt);
+        break;
+    case VIR_DOMAIN_DEVICE_GRAPHICS:
+        virDomainGraphicsDefClearRuntime(dev->data.graphics);
+        break;
+    case VIR_DOMAIN_DEVICE_CHR:
+        if (dev->data.chr->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL &&
+            dev->data.chr->targetType == VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_VIRTIO)
+            dev->data.chr->state = VIR_DOMAIN_CHR_DEVICE_STATE_DEFAULT;
+        virDomainChrSourceDefClearRuntime(dev->data.chr->source);
+        break;
+    case VIR_DOMAIN_DEVICE_REDIRDEV:
+        virDomainChrSourceDefClearRuntime(dev->data.redirdev->source);
+        break;
+    case VIR_DOMAIN_DEVICE_RNG:
+        if (dev->data.rng->backend == VIR_DOMAIN_RNG_BACKEND_EGD)
+            virDomainChrSourceDefClearRuntime(dev->data.rng->source.chardev);
+        break;
+    case VIR_DOMAIN_DEVICE_LEASE:
+    case VIR_DOMAIN_DEVICE_FS:
+    case VIR_DOMAIN_DEVICE_INPUT:
+    case VIR_DOMAIN_DEVICE_SOUND:
+    case VIR_DOMAIN_DEVICE_VIDEO:
+    case VIR_DOMAIN_DEVICE_HOSTDEV:
+    case VIR_DOMAIN_DEVICE_WATCHDOG:
+    case VIR_DOMAIN_DEVICE_CONTROLLER:
+    case VIR_DOMAIN_DEVICE_HUB:
+    case VIR_DOMAIN_DEVICE_SMARTCARD:
+    case VIR_DOMAIN_DEVICE_MEMBALLOON:
+    case VIR_DOMAIN_DEVICE_NVRAM:
+    case VIR_DOMAIN_DEVICE_SHMEM:
+    case VIR_DOMAIN_DEVICE_TPM:
+    case VIR_DOMAIN_DEVICE_PANIC:
+    case VIR_DOMAIN_DEVICE_MEMORY:
+    case VIR_DOMAIN_DEVICE_IOMMU:
+    case VIR_DOMAIN_DEVICE_VSOCK:
+    case VIR_DOMAIN_DEVICE_AUDIO:
+    case VIR_DOMAIN_DEVICE_CRYPTO:
+    case VIR_DOMAIN_DEVICE_NONE:
+    case VIR_DOMAIN_DEVICE_LAST:
+        break;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virDomainDefClearRuntime:
+ * @def: domain definition
+ * @xmlopt: XML parser configuration
+ *
+ * Drops the runtime state from a native copy of a live definition, i.e.
+ * everything the parser ignores in inactive XML: the domain ID, device
+ * aliases not set by the user, generated labels and interface names,
+ * automatically allocated ports, PTY paths and the like.
+ */
+static void
+virDomainDefClearRuntime(virDomainDef *def,
+                         virDomainXMLOption *xmlopt)
+{
+    size_t i;
+
+    def->id = -1;
+
+    for (i = 0; i < def->nseclabels; i++) {
+        virSecurityLabelDef *seclabel = def->seclabels[i];
+
+        if (STREQ_NULLABLE(seclabel->model, "none")) {
+            seclabel->type = VIR_DOMAIN_SECLABEL_NONE;
+            seclabel->relabel = false;
+        }
+
+        if (seclabel->type != VIR_DOMAIN_SECLABEL_STATIC)
+            g_clear_pointer(&seclabel->label, g_free);
+        g_clear_pointer(&seclabel->imagelabel, g_free);
+        seclabel->implicit = false;
+    }
+
+    ignore_value(virDomainDeviceInfoIterateFlags(def,
+                                                 virDomainDefClearRuntimeDevice,
+                                                 DOMAIN_DEVICE_ITERATE_ALL_CONSOLES |
+                                                 DOMAIN_DEVICE_ITERATE_MISSING_INFO,
+                                                 xmlopt));
+}
+
+
+/* Copy src into a new definition; with the quality of the copy
+ * depending on the migratable flag (false for transitions between
+ * persistent and active, true for transitions across save files or
+ * snapshots).  */
+virDomainDef *
+virDomainDefCopy(virDomainDef *src,
+                 virDomainXMLOption *xmlopt,
+                 void *parseOpaque,
+                 bool migratable)
+{
+    unsigned int format_flags = VIR_DOMAIN_DEF_FORMAT_SECURE;
+    unsigned int parse_flags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
+                               VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
+    g_autofree char *xml = NULL;
+
+    /* Migratable copies rely on the formatter to leave out the parts which
+     * must not be transferred, everything else is copied directly unless
+     * the definition contains something the native copy doesn't handle.
+     * The copy is then treated like a freshly parsed inactive definition. */
+    if (!migratable && virDomainDefCopyIsSupported(src)) {
+        g_autoptr(virDomainDef) def = NULL;
+
+        if (!(def = virDomainDefCopyNative(src, xmlopt)))
+            return NULL;
+
+        virDomainDefClearRuntime(def, xmlopt);
+
+        if (virDomainDefPostParse(def, parse_flags, xmlopt, parseOpaque) < 0)
+            return NULL;
+
+        return g_steal_pointer(&def);
+    }
+
+    if (migratable)
+        format_flags |= VIR_DOMAIN_DEF_FORMAT_INACTIVE | VIR_DOMAIN_DEF_FORMAT_MIGRATABLE;
+
+    /* Easiest to clone via a round-trip through XML.  */
+    if (!(xml = virDomainDefFormat(src, xmlopt, format_flags)))
+        return NULL;
+
+    return virDomainDefParseString(xml, xmlopt, parseOpaque, parse_flags);
+}
+
+virDomainDef *
+virDomainObjCopyPersistentDef(virDomainObj *dom,
+                              virDomainXMLOption *xmlopt,
+                              void *parseOpaque)
+{
+    virDomainDef *cur;
+
+    cur = virDomainObjGetPersistentDef(xmlopt, dom, parseOpaque);
+    if (!cur) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("failed to get persistent definition object"));
+        return NULL;
+    }
+
+    return virDomainDefCopy(cur, xmlopt, parseOpaque, false);
+}
+
+
+static void
+virDomainObjViewDispose(void *obj)
+{
+    virDomainObjView *view = obj;
+
+    virDomainDefFree(view->def);
+}
+
+
+static void
+virDomainObjSetView(virDomainObj *vm,
+                    virDomainObjView *view)
+{
+    virDomainObjView *old;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&vm->viewLock) {
+        old = vm->view;
+        vm->view = view;
+    }
+
+    virObjectUnref(old);
+}
+
+
+/**
+ * virDomainObjPublishView:
+ * @vm: locked domain object
+ *
+ * Replaces the read-only view of @vm with a copy of its current definition
+ * and state. Called when a job finishes so that readers see the changes it
+ * made. Does nothing unless the driver enabled views. If the definition
+ * can't be copied the view is dropped and readers have to lock @vm.
+ */
+void
+virDomainObjPublishView(virDomainObj *vm)
+{
+    g_autoptr(virDomainObjView) view = NULL;
+    virErrorPtr orig_err;
+
+    if (!vm->xmlopt)
+        return;
+
+    /* Definitions using anything the native copy doesn't handle would have
+     * to go through XML, which costs more than readers locking @vm. */
+    if (!vm->def || !virDomainDefCopyIsSupported(vm->def)) {
+        virDomainObjSetView(vm, NULL);
+        return;
+    }
+
+    if (!(view = virObjectNew(virDomainObjViewClass)))
+        return;
+
+    /* this is called on cleanup paths, keep the error of the caller */
+    virErrorPreserveLast(&orig_err);
+    view->def = virDomainDefCopyNative(vm->def, vm->xmlopt);
+    virErrorRestore(&orig_err);
+
+    if (!view->def) {
+        VIR_WARN("Unable to publish view of domain '%s'", vm->def->name);
+        virDomainObjSetView(vm, NULL);
+        return;
+    }
+
+    view->state = vm->state;
+    view->pid = vm->pid;
+
+    virDomainObjSetView(vm, g_steal_pointer(&view));
+}
+
+
+/**
+ * virDomainObjInvalidateView:
+ * @vm: locked domain object
+ *
+ * Drops the read-only view of @vm after changing its definition or state
+ * outside of a job. Readers lock @vm until a new view is published when
+ * the current job or API finishes.
+ */
+void
+virDomainObjInvalidateView(virDomainObj *vm)
+{
+    if (vm->view)
+        virDomainObjSetView(vm, NULL);
+}
+
+
+/**
+ * virDomainObjGetView:
+ * @vm: domain object, doesn't need to be locked
+ *
+ * Returns a reference to the read-only view of the definition and state of
+ * @vm, which stays consistent regardless of jobs running on @vm. The caller
+ * has to unref it when done. Returns NULL if no view is published, in which
+ * case the caller has to lock @vm and use it directly.
+ */
+virDomainObjView *
+virDomainObjGetView(virDomainObj *vm)
+{
+    virDomainObjView *view = NULL;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&vm->viewLock) {
+        if (vm->view)
+            view = virObjectRef(vm->view);
+    }
+
+    return view;
+}
+
+
+virDomainState
+virDomainObjGetState(virDomainObj *dom, int *reason)
+{
+    if (reason)
+        *reason = dom->state.reason;
+
+    return dom->state.state;
+}
+
+
+bool
 virDomainObjIsFailedPostcopy(virDomainObj *dom,
                              virDomainJobObj *job)
 {
@@ -28862,6 +30288,8 @@ virDomainObjSetState(virDomainObj *dom, virDomainState state, int reason)
         dom->state.reason = reason;
     else
         dom->state.reason = 0;
+
+    virDomainObjInvalidateView(dom);
 }
 
 
@@ -3192,6 +3192,18 @@ struct _virDomainStateReason {
     int reason;
 };
 
+/* Immutable copy of the definition and state of a domain object, see
+ * virDomainObjGetView */
+typedef struct _virDomainObjView virDomainObjView;
+struct _virDomainObjView {
+    virObject parent;
+
+    virDomainDef *def;
+    virDomainStateReason state;
+    pid_t pid;
+};
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainObjView, virObjectUnref);
+
 struct _virDomainObj {
     virObjectLockable parent;
     virCond cond;
@@ -3238,6 +3250,14 @@ struct _virDomainObj {
     int taint;
     size_t ndeprecations;
     char **deprecations;
+
+    /* Read-only view for readers which must not wait for the object lock.
+     * It is replaced with both the object lock and @viewLock held, so
+     * holding either of them is enough to read the pointer. @xmlopt is set
+     * only if the driver enabled views. */
+    virMutex viewLock;
+    virDomainObjView *view;
+    virDomainXMLOption *xmlopt;
 };
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainObj, virObjectUnref);
@@ -3428,6 +3448,9 @@ typedef virObject *(*virDomainCloseCallbackDataAlloc)(void);
 void virDomainXMLOptionSetCloseCallbackAlloc(virDomainXMLOption *xmlopt,
                                              virDomainCloseCallbackDataAlloc cb);
 
+void virDomainXMLOptionSetObjViews(virDomainXMLOption *xmlopt,
+                                   bool enable);
+
 virDomainXMLOption *virDomainXMLOptionNew(virDomainDefParserConfig *config,
                                           virDomainXMLPrivateDataCallbacks *priv,
                                           virXMLNamespace *xmlns,
@@ -3479,6 +3502,9 @@ struct _virDomainXMLOption {
 
     /* closecallback allocation callback */
     virDomainCloseCallbackDataAlloc closecallbackAlloc;
+
+    /* publish read-only views of domain objects */
+    bool objViews;
 };
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainXMLOption, virObjectUnref);
 
@@ -3517,6 +3543,19 @@ virDomainObj *virDomainObjNew(virDomainXMLOption *caps)
 
 void virDomainObjEndAPI(virDomainObj **vm);
 
+void virDomainObjPublishView(virDomainObj *vm)
+    ATTRIBUTE_NONNULL(1);
+void virDomainObjInvalidateView(virDomainObj *vm)
+    ATTRIBUTE_NONNULL(1);
+virDomainObjView *virDomainObjGetView(virDomainObj *vm)
+    ATTRIBUTE_NONNULL(1);
+
+static inline bool
+virDomainObjViewIsActive(virDomainObjView *view)
+{
+    return view->def->id != -1;
+}
+
 bool virDomainObjTaint(virDomainObj *obj,
                        virDomainTaintFlags taint);
 void virDomainObjDeprecation(virDomainObj *obj,
@@ -3815,6 +3854,11 @@ int virDomainDefFormatInternal(virDomainDef *def,
                                unsigned int flags)
     ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2)
     ATTRIBUTE_NONNULL(3);
+int virDomainDeviceDefFormat(virBuffer *buf,
+                             virDomainDeviceDef *dev,
+                             virDomainXMLOption *xmlopt,
+                             unsigned int flags)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2);
 int virDomainDefFormatInternalSetRootName(virDomainDef *def,
                                           virDomainXMLOption *xmlopt,
                                           virBuffer *buf,
@@ -0,0 +1,5207 @@
+/*
+ * domain_diff.c: structural comparison of domain definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The definitions are compared struct by struct. Every top-level section
+ * and every device type has a comparator listing its fields, much like
+ * the ABI stability checks in domain_conf.c, and each change is reported
+ * at the attribute or text node holding the value. Devices are matched by
+ * their identity taken from the device structs (target, MAC address,
+ * alias, address, or position among devices without any of them), so
+ * that reordering them isn't reported as a change.
+ *
+ * A few elements of interfaces are compared by their equality helpers and
+ * reported as a whole: <vlan>, <virtualport> and the parameters of
+ * <filterref>. The content of <metadata> and the driver specific namespace
+ * data are opaque to libvirt and compared in their XML form. Internal state
+ * which is never formatted, e.g. private data of drivers, thread IDs or
+ * effective boot indexes, is ignored.
+ *
+ * NB: when adding a field to the structs in domain_conf.h, the matching
+ * comparator needs an update.
+ */
+
+#include <config.h>
+
+#include "domain_diff.h"
+#include "domain_addr.h"
+#include "network_conf.h"
+#include "viralloc.h"
+#include "virbuffer.h"
+#include "virlog.h"
+#include "virmacaddr.h"
+#include "virmdev.h"
+#include "virnetdev.h"
+#include "virnetdevmacvlan.h"
+#include "virnetdevbandwidth.h"
+#include "virnetdevvlan.h"
+#include "virnetdevvportprofile.h"
+#include "virresctrl.h"
+#include "viruuid.h"
+#include "virxml.h"
+#include "nwfilter_params.h"
+
+#define VIR_FROM_THIS VIR_FROM_DOMAIN
+
+VIR_LOG_INIT("conf.domain_diff");
+
+VIR_ENUM_IMPL(virDomainDefChange,
+              VIR_DOMAIN_DEF_CHANGE_LAST,
+              "added",
+              "removed",
+              "modified",
+);
+
+void
+virDomainDefDiffFree(virDomainDefDiff *diff)
+{
+    size_t i;
+
+    if (!diff)
+        return;
+
+    for (i = 0; i < diff->nchanges; i++) {
+        g_free(diff->changes[i].path);
+        g_free(diff->changes[i].oldValue);
+        g_free(diff->changes[i].newValue);
+    }
+
+    g_free(diff->changes);
+    g_free(diff);
+}
+
+
+typedef struct _virDomainDefDiffCtx virDomainDefDiffCtx;
+struct _virDomainDefDiffCtx {
+    virDomainDefDiff *diff;
+    virDomainDeviceType devtype; /* device the compared structs belong to */
+    unsigned int flags; /* bitwise-OR of virDomainDefDiffFlags */
+};
+
+static void
+virDomainDefDiffAdd(virDomainDefDiffCtx *ctx,
+                    virDomainDefChangeType type,
+                    char *path,
+                    char *oldValue,
+                    char *newValue,
+                    bool element)
+{
+    virDomainDefChange change = {
+        .type = type,
+        .devtype = ctx->devtype,
+        .path = path,
+        .oldValue = oldValue,
+        .newValue = newValue,
+        .element = element,
+    };
+
+    VIR_APPEND_ELEMENT(ctx->diff->changes, ctx->diff->nchanges, change);
+}
+
+
+static char *
+virDomainDefDiffPath(const char *path,
+                     const char *fmt,
+                     ...)
+    G_GNUC_PRINTF(2, 3);
+
+static char *
+virDomainDefDiffPath(const char *path,
+                     const char *fmt,
+                     ...)
+{
+    g_autofree char *suffix = NULL;
+    va_list ap;
+
+    va_start(ap, fmt);
+    suffix = g_strdup_vprintf(fmt, ap);
+    va_end(ap);
+
+    return g_strconcat(path, suffix, NULL);
+}
+
+
+/**
+ * virDomainDefDiffValue:
+ * @ctx: diff context
+ * @path: location of the compared element
+ * @suffix: location of the value within @path
+ * @oldValue: original value, consumed
+ * @newValue: updated value, consumed
+ *
+ * Reports a value which differs in the definitions. Values missing in
+ * one of them are reported as added or removed.
+ */
+static void
+virDomainDefDiffValue(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      const char *suffix,
+                      char *oldValue,
+                      char *newValue)
+{
+    virDomainDefChangeType type = VIR_DOMAIN_DEF_CHANGE_MODIFIED;
+
+    if (!oldValue)
+        type = VIR_DOMAIN_DEF_CHANGE_ADDED;
+    else if (!newValue)
+        type = VIR_DOMAIN_DEF_CHANGE_REMOVED;
+
+    virDomainDefDiffAdd(ctx, type, g_strconcat(path, suffix, NULL),
+                        oldValue, newValue, false);
+}
+
+
+static void
+virDomainDefDiffString(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       const char *suffix,
+                       const char *oldValue,
+                       const char *newValue)
+{
+    if (STREQ_NULLABLE(oldValue, newValue))
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup(oldValue), g_strdup(newValue));
+}
+
+
+static void
+virDomainDefDiffUnsigned(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         const char *suffix,
+                         unsigned long long oldValue,
+                         unsigned long long newValue)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup_printf("%llu", oldValue),
+                          g_strdup_printf("%llu", newValue));
+}
+
+
+static void
+virDomainDefDiffSigned(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       const char *suffix,
+                       long long oldValue,
+                       long long newValue)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup_printf("%lld", oldValue),
+                          g_strdup_printf("%lld", newValue));
+}
+
+
+static void
+virDomainDefDiffHex(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    const char *suffix,
+                    unsigned long long oldValue,
+                    unsigned long long newValue)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup_printf("0x%llx", oldValue),
+                          g_strdup_printf("0x%llx", newValue));
+}
+
+
+static void
+virDomainDefDiffBool(virDomainDefDiffCtx *ctx,
+                     const char *path,
+                     const char *suffix,
+                     bool oldValue,
+                     bool newValue)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup(oldValue ? "yes" : "no"),
+                          g_strdup(newValue ? "yes" : "no"));
+}
+
+
+typedef const char *(*virDomainDefDiffEnumToString)(int value);
+
+static char *
+virDomainDefDiffEnumFormat(int value,
+                           virDomainDefDiffEnumToString toString)
+{
+    const char *str = toString(value);
+
+    if (!str)
+        return g_strdup_printf("%d", value);
+
+    return g_strdup(str);
+}
+
+
+static void
+virDomainDefDiffEnum(virDomainDefDiffCtx *ctx,
+                     const char *path,
+                     const char *suffix,
+                     int oldValue,
+                     int newValue,
+                     virDomainDefDiffEnumToString toString)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          virDomainDefDiffEnumFormat(oldValue, toString),
+                          virDomainDefDiffEnumFormat(newValue, toString));
+}
+
+
+/* Values of 0 are the defaults of attributes which aren't formatted. */
+static void
+virDomainDefDiffOptionalEnum(virDomainDefDiffCtx *ctx,
+                             const char *path,
+                             const char *suffix,
+                             int oldValue,
+                             int newValue,
+                             virDomainDefDiffEnumToString toString)
+{
+    if (oldValue == newValue)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          oldValue ? virDomainDefDiffEnumFormat(oldValue, toString) : NULL,
+                          newValue ? virDomainDefDiffEnumFormat(newValue, toString) : NULL);
+}
+
+
+static void
+virDomainDefDiffBitmap(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       const char *suffix,
+                       virBitmap *oldValue,
+                       virBitmap *newValue)
+{
+    if (virBitmapEqual(oldValue, newValue))
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          oldValue ? virBitmapFormat(oldValue) : NULL,
+                          newValue ? virBitmapFormat(newValue) : NULL);
+}
+
+
+static void
+virDomainDefDiffUUID(virDomainDefDiffCtx *ctx,
+                     const char *path,
+                     const char *suffix,
+                     const unsigned char *oldValue,
+                     const unsigned char *newValue)
+{
+    char oldstr[VIR_UUID_STRING_BUFLEN];
+    char newstr[VIR_UUID_STRING_BUFLEN];
+
+    if (memcmp(oldValue, newValue, VIR_UUID_BUFLEN) == 0)
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          g_strdup(virUUIDFormat(oldValue, oldstr)),
+                          g_strdup(virUUIDFormat(newValue, newstr)));
+}
+
+
+static void
+virDomainDefDiffSocketAddr(virDomainDefDiffCtx *ctx,
+                           const char *path,
+                           const char *suffix,
+                           const virSocketAddr *oldValue,
+                           const virSocketAddr *newValue)
+{
+    bool oldSet = oldValue && VIR_SOCKET_ADDR_VALID(oldValue);
+    bool newSet = newValue && VIR_SOCKET_ADDR_VALID(newValue);
+
+    if (!oldSet && !newSet)
+        return;
+
+    if (oldSet && newSet && virSocketAddrEqual(oldValue, newValue))
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          oldSet ? virSocketAddrFormat(oldValue) : NULL,
+                          newSet ? virSocketAddrFormat(newValue) : NULL);
+}
+
+
+/**
+ * virDomainDefDiffElement:
+ * @ctx: diff context
+ * @path: location of the parent element
+ * @suffix: location of the element within @path
+ * @oldPresent: whether the original definition has the element
+ * @newPresent: whether the updated definition has the element
+ *
+ * Reports an element which is present in only one of the definitions, or
+ * which differs as a whole if it's present in both.
+ */
+static void
+virDomainDefDiffElement(virDomainDefDiffCtx *ctx,
+                        const char *path,
+                        const char *suffix,
+                        bool oldPresent,
+                        bool newPresent)
+{
+    virDomainDefChangeType type = VIR_DOMAIN_DEF_CHANGE_MODIFIED;
+
+    if (!oldPresent && !newPresent)
+        return;
+
+    if (!oldPresent)
+        type = VIR_DOMAIN_DEF_CHANGE_ADDED;
+    else if (!newPresent)
+        type = VIR_DOMAIN_DEF_CHANGE_REMOVED;
+
+    virDomainDefDiffAdd(ctx, type, g_strconcat(path, suffix, NULL),
+                        NULL, NULL, true);
+}
+
+
+/* Returns true if both @oldValue and @newValue are present, otherwise
+ * reports the added or removed element. */
+static bool
+virDomainDefDiffBoth(virDomainDefDiffCtx *ctx,
+                     const char *path,
+                     const char *suffix,
+                     const void *oldValue,
+                     const void *newValue)
+{
+    if (oldValue && newValue)
+        return true;
+
+    virDomainDefDiffElement(ctx, path, suffix, !!oldValue, !!newValue);
+    return false;
+}
+
+
+/* The comparators below name the compared structs @a and @b, the location
+ * of the element they describe @path and the diff context @ctx. */
+#define DIFF_STRING(suffix, field) \
+    virDomainDefDiffString(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_UNSIGNED(suffix, field) \
+    virDomainDefDiffUnsigned(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_SIGNED(suffix, field) \
+    virDomainDefDiffSigned(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_HEX(suffix, field) \
+    virDomainDefDiffHex(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_BOOL(suffix, field) \
+    virDomainDefDiffBool(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_ENUM(suffix, field, name) \
+    virDomainDefDiffEnum(ctx, path, suffix, a->field, b->field, \
+                         name##TypeToString)
+
+#define DIFF_TRISTATE_BOOL(suffix, field) \
+    virDomainDefDiffOptionalEnum(ctx, path, suffix, a->field, b->field, \
+                                 virTristateBoolTypeToString)
+
+#define DIFF_TRISTATE_SWITCH(suffix, field) \
+    virDomainDefDiffOptionalEnum(ctx, path, suffix, a->field, b->field, \
+                                 virTristateSwitchTypeToString)
+
+#define DIFF_BITMAP(suffix, field) \
+    virDomainDefDiffBitmap(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_UUID(suffix, field) \
+    virDomainDefDiffUUID(ctx, path, suffix, a->field, b->field)
+
+#define DIFF_SOCKET_ADDR(suffix, field) \
+    virDomainDefDiffSocketAddr(ctx, path, suffix, &a->field, &b->field)
+
+#define DIFF_BOTH(suffix, field) \
+    virDomainDefDiffBoth(ctx, path, suffix, a->field, b->field)
+
+static void
+virDomainDefDiffAddressPCI(virDomainDefDiffCtx *ctx,
+                           const char *path,
+                           virPCIDeviceAddress *a,
+                           virPCIDeviceAddress *b)
+{
+    DIFF_HEX("/@domain", domain);
+    DIFF_HEX("/@bus", bus);
+    DIFF_HEX("/@slot", slot);
+    DIFF_HEX("/@function", function);
+    DIFF_TRISTATE_SWITCH("/@multifunction", multi);
+
+    if (a->zpci.uid.isSet != b->zpci.uid.isSet ||
+        a->zpci.fid.isSet != b->zpci.fid.isSet) {
+        virDomainDefDiffElement(ctx, path, "/zpci",
+                                a->zpci.uid.isSet || a->zpci.fid.isSet,
+                                b->zpci.uid.isSet || b->zpci.fid.isSet);
+        return;
+    }
+
+    DIFF_HEX("/zpci/@uid", zpci.uid.value);
+    DIFF_HEX("/zpci/@fid", zpci.fid.value);
+}
+
+
+static void
+virDomainDefDiffAddressUSBPort(virDomainDefDiffCtx *ctx,
+                               const char *path,
+                               const unsigned int *oldPort,
+                               const unsigned int *newPort)
+{
+    g_auto(virBuffer) oldBuf = VIR_BUFFER_INITIALIZER;
+    g_auto(virBuffer) newBuf = VIR_BUFFER_INITIALIZER;
+
+    if (memcmp(oldPort, newPort,
+               sizeof(*oldPort) * VIR_DOMAIN_DEVICE_USB_MAX_PORT_DEPTH) == 0)
+        return;
+
+    virDomainUSBAddressPortFormatBuf(&oldBuf, oldPort);
+    virDomainUSBAddressPortFormatBuf(&newBuf, newPort);
+
+    virDomainDefDiffValue(ctx, path, "/@port",
+                          virBufferContentAndReset(&oldBuf),
+                          virBufferContentAndReset(&newBuf));
+}
+
+
+static void
+virDomainDefDiffAddress(virDomainDefDiffCtx *ctx,
+                        const char *devpath,
+                        virDomainDeviceInfo *a,
+                        virDomainDeviceInfo *b)
+{
+    g_autofree char *path = g_strconcat(devpath, "/address", NULL);
+
+    if (a->type != b->type) {
+        if (a->type == VIR_DOMAIN_DEVICE_ADDRESS_TYPE_NONE ||
+            b->type == VIR_DOMAIN_DEVICE_ADDRESS_TYPE_NONE) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    a->type != VIR_DOMAIN_DEVICE_ADDRESS_TYPE_NONE,
+                                    b->type != VIR_DOMAIN_DEVICE_ADDRESS_TYPE_NONE);
+        } else {
+            DIFF_ENUM("/@type", type, virDomainDeviceAddress);
+        }
+        return;
+    }
+
+    switch (a->type) {
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_PCI:
+        virDomainDefDiffAddressPCI(ctx, path, &a->addr.pci, &b->addr.pci);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_DRIVE:
+        DIFF_UNSIGNED("/@controller", addr.drive.controller);
+        DIFF_UNSIGNED("/@bus", addr.drive.bus);
+        DIFF_UNSIGNED("/@target", addr.drive.target);
+        DIFF_UNSIGNED("/@unit", addr.drive.unit);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_VIRTIO_SERIAL:
+        DIFF_UNSIGNED("/@controller", addr.vioserial.controller);
+        DIFF_UNSIGNED("/@bus", addr.vioserial.bus);
+        DIFF_UNSIGNED("/@port", addr.vioserial.port);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_CCID:
+        DIFF_UNSIGNED("/@controller", addr.ccid.controller);
+        DIFF_UNSIGNED("/@slot", addr.ccid.slot);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_USB:
+        DIFF_UNSIGNED("/@bus", addr.usb.bus);
+        virDomainDefDiffAddressUSBPort(ctx, path, a->addr.usb.port,
+                                       b->addr.usb.port);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_SPAPRVIO:
+        if (a->addr.spaprvio.has_reg != b->addr.spaprvio.has_reg ||
+            a->addr.spaprvio.reg != b->addr.spaprvio.reg) {
+            virDomainDefDiffValue(ctx, path, "/@reg",
+                                  a->addr.spaprvio.has_reg ?
+                                  g_strdup_printf("0x%llx", a->addr.spaprvio.reg) : NULL,
+                                  b->addr.spaprvio.has_reg ?
+                                  g_strdup_printf("0x%llx", b->addr.spaprvio.reg) : NULL);
+        }
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_CCW:
+        DIFF_HEX("/@cssid", addr.ccw.cssid);
+        DIFF_HEX("/@ssid", addr.ccw.ssid);
+        DIFF_HEX("/@devno", addr.ccw.devno);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_ISA:
+        DIFF_HEX("/@iobase", addr.isa.iobase);
+        DIFF_HEX("/@irq", addr.isa.irq);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_DIMM:
+        DIFF_UNSIGNED("/@slot", addr.dimm.slot);
+        DIFF_HEX("/@base", addr.dimm.base);
+        break;
+
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_VIRTIO_S390:
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_VIRTIO_MMIO:
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_UNASSIGNED:
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_NONE:
+    case VIR_DOMAIN_DEVICE_ADDRESS_TYPE_LAST:
+        break;
+    }
+}
+
+
+/**
+ * virDomainDefDiffDeviceInfo:
+ * @ctx: diff context
+ * @path: location of the device
+ * @a: original device info
+ * @b: updated device info
+ *
+ * Compares the alias, guest address, boot order and the other data which
+ * all devices share.
+ */
+static void
+virDomainDefDiffDeviceInfo(virDomainDefDiffCtx *ctx,
+                           const char *path,
+                           virDomainDeviceInfo *a,
+                           virDomainDeviceInfo *b)
+{
+    const char *oldAlias = a->alias;
+    const char *newAlias = b->alias;
+
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_NO_DEVICE_INFO)
+        return;
+
+    /* inactive definitions keep only aliases set by the user */
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE) {
+        if (oldAlias && !virDomainDeviceAliasIsUserAlias(oldAlias))
+            oldAlias = NULL;
+        if (newAlias && !virDomainDeviceAliasIsUserAlias(newAlias))
+            newAlias = NULL;
+    }
+
+    virDomainDefDiffString(ctx, path, "/alias/@name", oldAlias, newAlias);
+
+    DIFF_UNSIGNED("/boot/@order", bootIndex);
+    DIFF_STRING("/boot/@loadparm", loadparm);
+    DIFF_UNSIGNED("/acpi/@index", acpiIndex);
+    DIFF_TRISTATE_SWITCH("/rom/@bar", rombar);
+    DIFF_STRING("/rom/@file", romfile);
+    DIFF_TRISTATE_BOOL("/rom/@enabled", romenabled);
+
+    if (a->mastertype != b->mastertype) {
+        virDomainDefDiffElement(ctx, path, "/master",
+                                a->mastertype != VIR_DOMAIN_CONTROLLER_MASTER_NONE,
+                                b->mastertype != VIR_DOMAIN_CONTROLLER_MASTER_NONE);
+    } else if (a->mastertype == VIR_DOMAIN_CONTROLLER_MASTER_USB) {
+        DIFF_UNSIGNED("/master/@startport", master.usb.startport);
+    }
+
+    virDomainDefDiffAddress(ctx, path, a, b);
+}
+
+
+/* Devices without <driver> options equal devices with all of them unset. */
+static void
+virDomainDefDiffVirtioOptions(virDomainDefDiffCtx *ctx,
+                              const char *devpath,
+                              virDomainVirtioOptions *oldOpts,
+                              virDomainVirtioOptions *newOpts)
+{
+    virDomainVirtioOptions empty = { 0 };
+    virDomainVirtioOptions *a = oldOpts ? oldOpts : &empty;
+    virDomainVirtioOptions *b = newOpts ? newOpts : &empty;
+    g_autofree char *path = g_strconcat(devpath, "/driver", NULL);
+
+    DIFF_TRISTATE_SWITCH("/@iommu", iommu);
+    DIFF_TRISTATE_SWITCH("/@ats", ats);
+    DIFF_TRISTATE_SWITCH("/@packed", packed);
+    DIFF_TRISTATE_SWITCH("/@page_per_vq", page_per_vq);
+}
+
+
+static virSecurityDeviceLabelDef *
+virDomainDefDiffFindDeviceSeclabel(virSecurityDeviceLabelDef **seclabels,
+                                   size_t nseclabels,
+                                   const char *model)
+{
+    size_t i;
+
+    for (i = 0; i < nseclabels; i++) {
+        if (STREQ_NULLABLE(seclabels[i]->model, model))
+            return seclabels[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffDeviceSeclabels(virDomainDefDiffCtx *ctx,
+                                const char *parent,
+                                virSecurityDeviceLabelDef **oldLabels,
+                                size_t noldLabels,
+                                virSecurityDeviceLabelDef **newLabels,
+                                size_t nnewLabels)
+{
+    size_t i;
+
+    for (i = 0; i < noldLabels; i++) {
+        virSecurityDeviceLabelDef *a = oldLabels[i];
+        virSecurityDeviceLabelDef *b;
+        g_autofree char *path = virDomainDefDiffPath(parent, "/seclabel[@model='%s']",
+                                                     NULLSTR_EMPTY(a->model));
+
+        if (!(b = virDomainDefDiffFindDeviceSeclabel(newLabels, nnewLabels,
+                                                     a->model))) {
+            virDomainDefDiffElement(ctx, path, "", true, false);
+            continue;
+        }
+
+        DIFF_BOOL("/@relabel", relabel);
+        DIFF_STRING("/label", label);
+        if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE))
+            DIFF_BOOL("/@labelskip", labelskip);
+    }
+
+    for (i = 0; i < nnewLabels; i++) {
+        g_autofree char *path = NULL;
+
+        if (virDomainDefDiffFindDeviceSeclabel(oldLabels, noldLabels,
+                                               newLabels[i]->model))
+            continue;
+
+        path = virDomainDefDiffPath(parent, "/seclabel[@model='%s']",
+                                    NULLSTR_EMPTY(newLabels[i]->model));
+        virDomainDefDiffElement(ctx, path, "", false, true);
+    }
+}
+
+
+static void
+virDomainDefDiffChrSourceReconnect(virDomainDefDiffCtx *ctx,
+                                   const char *path,
+                                   virDomainChrSourceReconnectDef *a,
+                                   virDomainChrSourceReconnectDef *b)
+{
+    DIFF_TRISTATE_BOOL("/reconnect/@enabled", enabled);
+    DIFF_UNSIGNED("/reconnect/@timeout", timeout);
+}
+
+
+static void
+virDomainDefDiffChrSourceMode(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              bool oldListen,
+                              bool newListen)
+{
+    virDomainDefDiffString(ctx, path, "/@mode",
+                           oldListen ? "bind" : "connect",
+                           newListen ? "bind" : "connect");
+}
+
+
+/**
+ * virDomainDefDiffChrSource:
+ * @ctx: diff context
+ * @typepath: location of the element with the 'type' attribute
+ * @path: location of the <source> element
+ * @a: original character device source
+ * @b: updated character device source
+ *
+ * Compares the host side of character devices, which is shared by serial
+ * ports, channels, smartcards, redirected USB devices, RNG backends and
+ * others.
+ */
+static void
+virDomainDefDiffChrSource(virDomainDefDiffCtx *ctx,
+                          const char *typepath,
+                          const char *path,
+                          virDomainChrSourceDef *a,
+                          virDomainChrSourceDef *b)
+{
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    if (a->type != b->type) {
+        virDomainDefDiffEnum(ctx, typepath, "/@type", a->type, b->type,
+                             virDomainChrTypeToString);
+        return;
+    }
+
+    switch ((virDomainChrType) a->type) {
+    case VIR_DOMAIN_CHR_TYPE_PTY:
+        /* allocated when the domain is started */
+        if (ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE)
+            break;
+        G_GNUC_FALLTHROUGH;
+    case VIR_DOMAIN_CHR_TYPE_DEV:
+    case VIR_DOMAIN_CHR_TYPE_FILE:
+    case VIR_DOMAIN_CHR_TYPE_PIPE:
+        DIFF_STRING("/@path", data.file.path);
+        DIFF_TRISTATE_SWITCH("/@append", data.file.append);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_NMDM:
+        DIFF_STRING("/@master", data.nmdm.master);
+        DIFF_STRING("/@slave", data.nmdm.slave);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_UDP:
+        DIFF_STRING("[@mode='bind']/@host", data.udp.bindHost);
+        DIFF_STRING("[@mode='bind']/@service", data.udp.bindService);
+        DIFF_STRING("[@mode='connect']/@host", data.udp.connectHost);
+        DIFF_STRING("[@mode='connect']/@service", data.udp.connectService);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_TCP:
+        virDomainDefDiffChrSourceMode(ctx, path, a->data.tcp.listen,
+                                      b->data.tcp.listen);
+        DIFF_STRING("/@host", data.tcp.host);
+        DIFF_STRING("/@service", data.tcp.service);
+        DIFF_TRISTATE_BOOL("/@tls", data.tcp.haveTLS);
+        virDomainDefDiffEnum(ctx, typepath, "/protocol/@type",
+                             a->data.tcp.protocol, b->data.tcp.protocol,
+                             virDomainChrTcpProtocolTypeToString);
+        virDomainDefDiffChrSourceReconnect(ctx, path, &a->data.tcp.reconnect,
+                                           &b->data.tcp.reconnect);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_UNIX:
+        virDomainDefDiffChrSourceMode(ctx, path, a->data.nix.listen,
+                                      b->data.nix.listen);
+        DIFF_STRING("/@path", data.nix.path);
+        virDomainDefDiffChrSourceReconnect(ctx, path, &a->data.nix.reconnect,
+                                           &b->data.nix.reconnect);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_SPICEVMC:
+        virDomainDefDiffEnum(ctx, typepath, "/@name",
+                             a->data.spicevmc, b->data.spicevmc,
+                             virDomainChrSpicevmcTypeToString);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_SPICEPORT:
+        DIFF_STRING("/@channel", data.spiceport.channel);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_QEMU_VDAGENT:
+        DIFF_ENUM("/mouse/@mode", data.qemuVdagent.mouse, virDomainMouseMode);
+        DIFF_TRISTATE_BOOL("/clipboard/@copypaste", data.qemuVdagent.clipboard);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_DBUS:
+        DIFF_STRING("/@channel", data.dbus.channel);
+        break;
+
+    case VIR_DOMAIN_CHR_TYPE_NULL:
+    case VIR_DOMAIN_CHR_TYPE_VC:
+    case VIR_DOMAIN_CHR_TYPE_STDIO:
+    case VIR_DOMAIN_CHR_TYPE_LAST:
+        break;
+    }
+
+    virDomainDefDiffString(ctx, typepath, "/log/@file", a->logfile, b->logfile);
+    virDomainDefDiffOptionalEnum(ctx, typepath, "/log/@append",
+                                 a->logappend, b->logappend,
+                                 virTristateSwitchTypeToString);
+
+    virDomainDefDiffDeviceSeclabels(ctx, path,
+                                    a->seclabels, a->nseclabels,
+                                    b->seclabels, b->nseclabels);
+}
+
+
+static void
+virDomainDefDiffSecretLookup(virDomainDefDiffCtx *ctx,
+                             const char *path,
+                             virSecretLookupTypeDef *a,
+                             virSecretLookupTypeDef *b)
+{
+    char olduuid[VIR_UUID_STRING_BUFLEN];
+    char newuuid[VIR_UUID_STRING_BUFLEN];
+
+    virDomainDefDiffString(ctx, path, "/@uuid",
+                           a->type == VIR_SECRET_LOOKUP_TYPE_UUID ?
+                           virUUIDFormat(a->u.uuid, olduuid) : NULL,
+                           b->type == VIR_SECRET_LOOKUP_TYPE_UUID ?
+                           virUUIDFormat(b->u.uuid, newuuid) : NULL);
+    virDomainDefDiffString(ctx, path, "/@usage",
+                           a->type == VIR_SECRET_LOOKUP_TYPE_USAGE ?
+                           a->u.usage : NULL,
+                           b->type == VIR_SECRET_LOOKUP_TYPE_USAGE ?
+                           b->u.usage : NULL);
+}
+
+
+static void
+virDomainDefDiffStorageAuth(virDomainDefDiffCtx *ctx,
+                            const char *parent,
+                            virStorageAuthDef *a,
+                            virStorageAuthDef *b)
+{
+    g_autofree char *path = g_strconcat(parent, "/auth", NULL);
+    g_autofree char *secretPath = g_strconcat(path, "/secret", NULL);
+
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_STRING("/@username", username);
+    DIFF_STRING("/secret/@type", secrettype);
+    virDomainDefDiffSecretLookup(ctx, secretPath, &a->seclookupdef,
+                                 &b->seclookupdef);
+}
+
+
+static void
+virDomainDefDiffStorageEncryption(virDomainDefDiffCtx *ctx,
+                                  const char *parent,
+                                  virStorageEncryption *a,
+                                  virStorageEncryption *b)
+{
+    g_autofree char *path = g_strconcat(parent, "/encryption", NULL);
+    size_t i;
+
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_ENUM("/@format", format, virStorageEncryptionFormat);
+    DIFF_ENUM("/@engine", engine, virStorageEncryptionEngine);
+
+    for (i = 0; i < MAX(a->nsecrets, b->nsecrets); i++) {
+        g_autofree char *secretPath = virDomainDefDiffPath(path, "/secret[%zu]", i + 1);
+
+        if (i >= a->nsecrets || i >= b->nsecrets) {
+            virDomainDefDiffElement(ctx, secretPath, "",
+                                    i < a->nsecrets, i < b->nsecrets);
+            continue;
+        }
+
+        virDomainDefDiffEnum(ctx, secretPath, "/@type",
+                             a->secrets[i]->type, b->secrets[i]->type,
+                             virStorageEncryptionSecretTypeToString);
+        virDomainDefDiffSecretLookup(ctx, secretPath,
+                                     &a->secrets[i]->seclookupdef,
+                                     &b->secrets[i]->seclookupdef);
+    }
+
+    DIFF_STRING("/cipher/@name", encinfo.cipher_name);
+    DIFF_UNSIGNED("/cipher/@size", encinfo.cipher_size);
+    DIFF_STRING("/cipher/@mode", encinfo.cipher_mode);
+    DIFF_STRING("/cipher/@hash", encinfo.cipher_hash);
+    DIFF_STRING("/ivgen/@name", encinfo.ivgen_name);
+    DIFF_STRING("/ivgen/@hash", encinfo.ivgen_hash);
+}
+
+
+static const char *
+virDomainDefDiffStorageSourcePathAttr(virStorageType type)
+{
+    switch (type) {
+    case VIR_STORAGE_TYPE_BLOCK:
+    case VIR_STORAGE_TYPE_VHOST_VDPA:
+        return "/@dev";
+    case VIR_STORAGE_TYPE_DIR:
+        return "/@dir";
+    case VIR_STORAGE_TYPE_NETWORK:
+        return "/@name";
+    case VIR_STORAGE_TYPE_VHOST_USER:
+        return "/@path";
+    case VIR_STORAGE_TYPE_FILE:
+    case VIR_STORAGE_TYPE_VOLUME:
+    case VIR_STORAGE_TYPE_NVME:
+    case VIR_STORAGE_TYPE_NONE:
+    case VIR_STORAGE_TYPE_LAST:
+        break;
+    }
+
+    return "/@file";
+}
+
+
+/* Network sources keep the volume of the name separately. */
+static char *
+virDomainDefDiffStorageSourceName(virStorageSource *src)
+{
+    if (src->volume)
+        return g_strdup_printf("%s/%s", src->volume, NULLSTR_EMPTY(src->path));
+
+    return g_strdup(src->path);
+}
+
+
+static virStorageNetCookieDef *
+virDomainDefDiffFindCookie(virStorageSource *src,
+                           const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < src->ncookies; i++) {
+        if (STREQ(src->cookies[i]->name, name))
+            return src->cookies[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffStorageCookies(virDomainDefDiffCtx *ctx,
+                               const char *path,
+                               virStorageSource *a,
+                               virStorageSource *b)
+{
+    size_t i;
+
+    /* cookies are secret */
+    if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_SECURE))
+        return;
+
+    for (i = 0; i < a->ncookies; i++) {
+        virStorageNetCookieDef *cookie = virDomainDefDiffFindCookie(b, a->cookies[i]->name);
+        g_autofree char *suffix = g_strdup_printf("/cookies/cookie[@name='%s']",
+                                                  a->cookies[i]->name);
+
+        virDomainDefDiffString(ctx, path, suffix, a->cookies[i]->value,
+                               cookie ? cookie->value : NULL);
+    }
+
+    for (i = 0; i < b->ncookies; i++) {
+        g_autofree char *suffix = NULL;
+
+        if (virDomainDefDiffFindCookie(a, b->cookies[i]->name))
+            continue;
+
+        suffix = g_strdup_printf("/cookies/cookie[@name='%s']", b->cookies[i]->name);
+        virDomainDefDiffString(ctx, path, suffix, NULL, b->cookies[i]->value);
+    }
+}
+
+
+/**
+ * virDomainDefDiffStorageSource:
+ * @ctx: diff context
+ * @path: location of the <source> element
+ * @a: original storage source
+ * @b: updated storage source
+ *
+ * Compares the location, authentication, encryption and other data of
+ * <source> of disks and their backing stores. The type and format of the
+ * sources are formatted outside of <source> and compared by the callers.
+ */
+static void
+virDomainDefDiffStorageSource(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              virStorageSource *a,
+                              virStorageSource *b)
+{
+    g_autofree char *oldName = virDomainDefDiffStorageSourceName(a);
+    g_autofree char *newName = virDomainDefDiffStorageSourceName(b);
+    size_t i;
+
+    virDomainDefDiffString(ctx, path,
+                           virDomainDefDiffStorageSourcePathAttr(b->type),
+                           oldName, newName);
+    DIFF_STRING("/@fdgroup", fdgroup);
+    DIFF_STRING("/@dev", vdpadev);
+
+    virDomainDefDiffString(ctx, path, "/@pool",
+                           a->srcpool ? a->srcpool->pool : NULL,
+                           b->srcpool ? b->srcpool->pool : NULL);
+    virDomainDefDiffString(ctx, path, "/@volume",
+                           a->srcpool ? a->srcpool->volume : NULL,
+                           b->srcpool ? b->srcpool->volume : NULL);
+    virDomainDefDiffEnum(ctx, path, "/@mode",
+                         a->srcpool ? a->srcpool->mode : 0,
+                         b->srcpool ? b->srcpool->mode : 0,
+                         virStorageSourcePoolModeTypeToString);
+
+    DIFF_ENUM("/@protocol", protocol, virStorageNetProtocol);
+    DIFF_STRING("/@query", query);
+    DIFF_TRISTATE_BOOL("/@tls", haveTLS);
+    DIFF_STRING("/@tlsHostname", tlsHostname);
+
+    for (i = 0; i < MAX(a->nhosts, b->nhosts); i++) {
+        g_autofree char *hostPath = virDomainDefDiffPath(path, "/host[%zu]", i + 1);
+
+        if (i >= a->nhosts || i >= b->nhosts) {
+            virDomainDefDiffElement(ctx, hostPath, "",
+                                    i < a->nhosts, i < b->nhosts);
+            continue;
+        }
+
+        virDomainDefDiffString(ctx, hostPath, "/@name",
+                               a->hosts[i].name, b->hosts[i].name);
+        virDomainDefDiffUnsigned(ctx, hostPath, "/@port",
+                                 a->hosts[i].port, b->hosts[i].port);
+        virDomainDefDiffEnum(ctx, hostPath, "/@transport",
+                             a->hosts[i].transport, b->hosts[i].transport,
+                             virStorageNetHostTransportTypeToString);
+        virDomainDefDiffString(ctx, hostPath, "/@socket",
+                               a->hosts[i].socket, b->hosts[i].socket);
+    }
+
+    DIFF_STRING("/identity/@user", nfs_user);
+    DIFF_STRING("/identity/@group", nfs_group);
+    DIFF_UNSIGNED("/reconnect/@delay", reconnectDelay);
+    DIFF_STRING("/snapshot/@name", snapshot);
+    DIFF_STRING("/config/@file", configFile);
+    DIFF_STRING("/initiator/iqn/@name", initiator.iqn);
+    DIFF_TRISTATE_BOOL("/ssl/@verify", sslverify);
+    virDomainDefDiffStorageCookies(ctx, path, a, b);
+    DIFF_UNSIGNED("/readahead/@size", readahead);
+    DIFF_UNSIGNED("/timeout/@seconds", timeout);
+    DIFF_STRING("/knownHosts/@path", ssh_known_hosts_file);
+    DIFF_STRING("/identity/@username", ssh_user);
+    DIFF_STRING("/identity/@keyfile", ssh_keyfile);
+    DIFF_STRING("/identity/@agentsock", ssh_agent);
+
+    if (a->nvme && b->nvme) {
+        g_autofree char *addrPath = g_strconcat(path, "/address", NULL);
+
+        DIFF_TRISTATE_BOOL("/@managed", nvme->managed);
+        DIFF_UNSIGNED("/@namespace", nvme->namespc);
+        virDomainDefDiffAddressPCI(ctx, addrPath, &a->nvme->pciAddr,
+                                   &b->nvme->pciAddr);
+    }
+
+    if (a->vhostuser && b->vhostuser)
+        virDomainDefDiffChrSource(ctx, path, path, a->vhostuser, b->vhostuser);
+
+    if (DIFF_BOTH("/slices/slice[@type='storage']", sliceStorage)) {
+        DIFF_UNSIGNED("/slices/slice[@type='storage']/@offset", sliceStorage->offset);
+        DIFF_UNSIGNED("/slices/slice[@type='storage']/@size", sliceStorage->size);
+    }
+
+    virDomainDefDiffDeviceSeclabels(ctx, path,
+                                    a->seclabels, a->nseclabels,
+                                    b->seclabels, b->nseclabels);
+
+    virDomainDefDiffStorageAuth(ctx, path, a->auth, b->auth);
+    virDomainDefDiffStorageEncryption(ctx, path, a->encryption, b->encryption);
+
+    if (DIFF_BOTH("/reservations", pr)) {
+        DIFF_TRISTATE_BOOL("/reservations/@managed", pr->managed);
+        DIFF_STRING("/reservations/source/@path", pr->path);
+    }
+}
+
+
+/**
+ * virDomainDefDiffBackingStore:
+ * @ctx: diff context
+ * @parent: location of the element the backing store belongs to
+ * @oldParent: original storage source
+ * @newParent: updated storage source
+ *
+ * Compares the backing chains of two storage sources.
+ */
+static void
+virDomainDefDiffBackingStore(virDomainDefDiffCtx *ctx,
+                             const char *parent,
+                             virStorageSource *oldParent,
+                             virStorageSource *newParent)
+{
+    virStorageSource *a = oldParent->backingStore;
+    virStorageSource *b = newParent->backingStore;
+    g_autofree char *path = g_strconcat(parent, "/backingStore", NULL);
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+
+    /* detected backing chain members aren't part of inactive XML */
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE) {
+        if (a && a->detected)
+            a = NULL;
+        if (b && b->detected)
+            b = NULL;
+    }
+
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_ENUM("/@type", type, virStorage);
+
+    /* terminator of the chain */
+    if (a->type == VIR_STORAGE_TYPE_NONE || b->type == VIR_STORAGE_TYPE_NONE)
+        return;
+
+    if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE))
+        DIFF_UNSIGNED("/@index", id);
+
+    DIFF_ENUM("/format/@type", format, virStorageFileFormat);
+    DIFF_UNSIGNED("/format/metadata_cache/max_size", metadataCacheMaxSize);
+
+    virDomainDefDiffStorageSource(ctx, sourcePath, a, b);
+    virDomainDefDiffBackingStore(ctx, path, a, b);
+}
+
+
+/* Used for values whose names depend on the type of the device, if the
+ * type doesn't have any names. */
+static const char *
+virDomainDefDiffNoName(int value G_GNUC_UNUSED)
+{
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffIdmapEntries(virDomainDefDiffCtx *ctx,
+                             const char *parent,
+                             const char *name,
+                             virDomainIdMapEntry *oldEntries,
+                             size_t noldEntries,
+                             virDomainIdMapEntry *newEntries,
+                             size_t nnewEntries)
+{
+    size_t i;
+
+    for (i = 0; i < MAX(noldEntries, nnewEntries); i++) {
+        virDomainIdMapEntry *a = &oldEntries[i];
+        virDomainIdMapEntry *b = &newEntries[i];
+        g_autofree char *path = virDomainDefDiffPath(parent, "/idmap/%s[%zu]",
+                                                     name, i + 1);
+
+        if (i >= noldEntries || i >= nnewEntries) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    i < noldEntries, i < nnewEntries);
+            continue;
+        }
+
+        DIFF_UNSIGNED("/@start", start);
+        DIFF_UNSIGNED("/@target", target);
+        DIFF_UNSIGNED("/@count", count);
+    }
+}
+
+
+static void
+virDomainDefDiffIdmap(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainIdMapDef *a,
+                      virDomainIdMapDef *b)
+{
+    virDomainDefDiffIdmapEntries(ctx, path, "uid",
+                                 a->uidmap, a->nuidmap,
+                                 b->uidmap, b->nuidmap);
+    virDomainDefDiffIdmapEntries(ctx, path, "gid",
+                                 a->gidmap, a->ngidmap,
+                                 b->gidmap, b->ngidmap);
+}
+
+
+static void
+virDomainDefDiffIPInfo(virDomainDefDiffCtx *ctx,
+                       const char *parent,
+                       virNetDevIPInfo *oldInfo,
+                       virNetDevIPInfo *newInfo)
+{
+    size_t i;
+
+    for (i = 0; i < MAX(oldInfo->nips, newInfo->nips); i++) {
+        g_autofree char *path = virDomainDefDiffPath(parent, "/ip[%zu]", i + 1);
+        virNetDevIPAddr *a;
+        virNetDevIPAddr *b;
+
+        if (i >= oldInfo->nips || i >= newInfo->nips) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    i < oldInfo->nips, i < newInfo->nips);
+            continue;
+        }
+
+        a = oldInfo->ips[i];
+        b = newInfo->ips[i];
+
+        DIFF_SOCKET_ADDR("/@address", address);
+        DIFF_UNSIGNED("/@prefix", prefix);
+        DIFF_SOCKET_ADDR("/@peer", peer);
+    }
+
+    for (i = 0; i < MAX(oldInfo->nroutes, newInfo->nroutes); i++) {
+        g_autofree char *path = virDomainDefDiffPath(parent, "/route[%zu]", i + 1);
+        virNetDevIPRoute *a;
+        virNetDevIPRoute *b;
+
+        if (i >= oldInfo->nroutes || i >= newInfo->nroutes) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    i < oldInfo->nroutes, i < newInfo->nroutes);
+            continue;
+        }
+
+        a = oldInfo->routes[i];
+        b = newInfo->routes[i];
+
+        DIFF_STRING("/@family", family);
+        DIFF_SOCKET_ADDR("/@address", address);
+        DIFF_SOCKET_ADDR("/@netmask", netmask);
+        virDomainDefDiffValue(ctx, path, "/@prefix",
+                              a->has_prefix ? g_strdup_printf("%u", a->prefix) : NULL,
+                              b->has_prefix ? g_strdup_printf("%u", b->prefix) : NULL);
+        virDomainDefDiffValue(ctx, path, "/@metric",
+                              a->has_metric ? g_strdup_printf("%u", a->metric) : NULL,
+                              b->has_metric ? g_strdup_printf("%u", b->metric) : NULL);
+        DIFF_SOCKET_ADDR("/@gateway", gateway);
+    }
+}
+
+
+static void
+virDomainDefDiffBandwidthRate(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              virNetDevBandwidthRate *a,
+                              virNetDevBandwidthRate *b)
+{
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_UNSIGNED("/@average", average);
+    DIFF_UNSIGNED("/@peak", peak);
+    DIFF_UNSIGNED("/@floor", floor);
+    DIFF_UNSIGNED("/@burst", burst);
+}
+
+
+/* Interfaces without <bandwidth> equal interfaces with no rates set. */
+static void
+virDomainDefDiffBandwidth(virDomainDefDiffCtx *ctx,
+                          const char *parent,
+                          virNetDevBandwidth *a,
+                          virNetDevBandwidth *b)
+{
+    g_autofree char *inPath = g_strconcat(parent, "/bandwidth/inbound", NULL);
+    g_autofree char *outPath = g_strconcat(parent, "/bandwidth/outbound", NULL);
+
+    virDomainDefDiffBandwidthRate(ctx, inPath,
+                                  a ? a->in : NULL, b ? b->in : NULL);
+    virDomainDefDiffBandwidthRate(ctx, outPath,
+                                  a ? a->out : NULL, b ? b->out : NULL);
+}
+
+
+static void
+virDomainDefDiffTeaming(virDomainDefDiffCtx *ctx,
+                        const char *path,
+                        virDomainNetTeamingInfo *oldTeaming,
+                        virDomainNetTeamingInfo *newTeaming)
+{
+    virDomainNetTeamingInfo empty = { 0 };
+    virDomainNetTeamingInfo *a = oldTeaming ? oldTeaming : &empty;
+    virDomainNetTeamingInfo *b = newTeaming ? newTeaming : &empty;
+
+    DIFF_ENUM("/teaming/@type", type, virDomainNetTeaming);
+    DIFF_STRING("/teaming/@persistent", persistent);
+}
+
+
+static void
+virDomainDefDiffDiskIothreads(virDomainDefDiffCtx *ctx,
+                              const char *parent,
+                              GSList *oldIothreads,
+                              GSList *newIothreads)
+{
+    GSList *olditer = oldIothreads;
+    GSList *newiter = newIothreads;
+    size_t i;
+
+    for (i = 1; olditer || newiter; i++) {
+        virDomainDiskIothreadDef *a = olditer ? olditer->data : NULL;
+        virDomainDiskIothreadDef *b = newiter ? newiter->data : NULL;
+        g_autofree char *path = virDomainDefDiffPath(parent,
+                                                     "/driver/iothreads/iothread[%zu]",
+                                                     i);
+
+        if (olditer)
+            olditer = olditer->next;
+        if (newiter)
+            newiter = newiter->next;
+
+        if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+            continue;
+
+        DIFF_UNSIGNED("/@id", id);
+
+        if (a->nqueues != b->nqueues ||
+            (a->nqueues > 0 &&
+             memcmp(a->queues, b->queues, a->nqueues * sizeof(*a->queues)) != 0))
+            virDomainDefDiffElement(ctx, path, "/queue", true, true);
+    }
+}
+
+
+static void
+virDomainDefDiffIoTune(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       virDomainBlockIoTuneInfo *a,
+                       virDomainBlockIoTuneInfo *b)
+{
+    DIFF_UNSIGNED("/total_bytes_sec", total_bytes_sec);
+    DIFF_UNSIGNED("/read_bytes_sec", read_bytes_sec);
+    DIFF_UNSIGNED("/write_bytes_sec", write_bytes_sec);
+    DIFF_UNSIGNED("/total_iops_sec", total_iops_sec);
+    DIFF_UNSIGNED("/read_iops_sec", read_iops_sec);
+    DIFF_UNSIGNED("/write_iops_sec", write_iops_sec);
+    DIFF_UNSIGNED("/total_bytes_sec_max", total_bytes_sec_max);
+    DIFF_UNSIGNED("/read_bytes_sec_max", read_bytes_sec_max);
+    DIFF_UNSIGNED("/write_bytes_sec_max", write_bytes_sec_max);
+    DIFF_UNSIGNED("/total_iops_sec_max", total_iops_sec_max);
+    DIFF_UNSIGNED("/read_iops_sec_max", read_iops_sec_max);
+    DIFF_UNSIGNED("/write_iops_sec_max", write_iops_sec_max);
+    DIFF_UNSIGNED("/size_iops_sec", size_iops_sec);
+    DIFF_STRING("/group_name", group_name);
+    DIFF_UNSIGNED("/total_bytes_sec_max_length", total_bytes_sec_max_length);
+    DIFF_UNSIGNED("/read_bytes_sec_max_length", read_bytes_sec_max_length);
+    DIFF_UNSIGNED("/write_bytes_sec_max_length", write_bytes_sec_max_length);
+    DIFF_UNSIGNED("/total_iops_sec_max_length", total_iops_sec_max_length);
+    DIFF_UNSIGNED("/read_iops_sec_max_length", read_iops_sec_max_length);
+    DIFF_UNSIGNED("/write_iops_sec_max_length", write_iops_sec_max_length);
+}
+
+
+static void
+virDomainDefDiffDisk(virDomainDefDiffCtx *ctx,
+                     const char *path,
+                     virDomainDiskDef *a,
+                     virDomainDiskDef *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+    g_autofree char *iotunePath = g_strconcat(path, "/iotune", NULL);
+    bool inactive = !!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE);
+
+    DIFF_ENUM("/@type", src->type, virStorage);
+    DIFF_ENUM("/@device", device, virDomainDiskDevice);
+    DIFF_ENUM("/@model", model, virDomainDiskModel);
+    DIFF_ENUM("/@snapshot", snapshot, virDomainSnapshotLocation);
+    DIFF_TRISTATE_BOOL("/@rawio", rawio);
+    DIFF_ENUM("/@sgio", sgio, virDomainDeviceSGIO);
+
+    DIFF_STRING("/driver/@name", driverName);
+    DIFF_ENUM("/driver/@type", src->format, virStorageFileFormat);
+    DIFF_ENUM("/driver/@cache", cachemode, virDomainDiskCache);
+    DIFF_ENUM("/driver/@error_policy", error_policy, virDomainDiskErrorPolicy);
+    DIFF_ENUM("/driver/@rerror_policy", rerror_policy, virDomainDiskErrorPolicy);
+    DIFF_ENUM("/driver/@io", iomode, virDomainDiskIo);
+    DIFF_TRISTATE_SWITCH("/driver/@ioeventfd", ioeventfd);
+    DIFF_TRISTATE_SWITCH("/driver/@event_idx", event_idx);
+    DIFF_TRISTATE_SWITCH("/driver/@copy_on_read", copy_on_read);
+    DIFF_ENUM("/driver/@discard", discard, virDomainDiskDiscard);
+    DIFF_UNSIGNED("/driver/@iothread", iothread);
+    DIFF_ENUM("/driver/@detect_zeroes", detect_zeroes, virDomainDiskDetectZeroes);
+    DIFF_TRISTATE_SWITCH("/driver/@discard_no_unref", discard_no_unref);
+    DIFF_UNSIGNED("/driver/@queues", queues);
+    DIFF_UNSIGNED("/driver/@queue_size", queue_size);
+    DIFF_UNSIGNED("/driver/metadata_cache/max_size", src->metadataCacheMaxSize);
+    virDomainDefDiffDiskIothreads(ctx, path, a->iothreads, b->iothreads);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    DIFF_ENUM("/source/@startupPolicy", startupPolicy, virDomainStartupPolicy);
+    if (!inactive)
+        DIFF_UNSIGNED("/source/@index", src->id);
+    virDomainDefDiffStorageSource(ctx, sourcePath, a->src, b->src);
+    virDomainDefDiffBackingStore(ctx, path, a->src, b->src);
+
+    /* block jobs are part of the live state only */
+    if (!inactive && DIFF_BOTH("/mirror", mirror)) {
+        g_autofree char *mirrorPath = g_strconcat(path, "/mirror", NULL);
+        g_autofree char *mirrorSourcePath = g_strconcat(mirrorPath, "/source", NULL);
+
+        DIFF_ENUM("/mirror/@type", mirror->type, virStorage);
+        DIFF_SIGNED("/mirror/@job", mirrorJob);
+        DIFF_ENUM("/mirror/@ready", mirrorState, virDomainDiskMirrorState);
+        DIFF_ENUM("/mirror/format/@type", mirror->format, virStorageFileFormat);
+        virDomainDefDiffStorageSource(ctx, mirrorSourcePath, a->mirror, b->mirror);
+        virDomainDefDiffBackingStore(ctx, mirrorPath, a->mirror, b->mirror);
+    }
+
+    DIFF_STRING("/target/@dev", dst);
+    DIFF_ENUM("/target/@bus", bus, virDomainDiskBus);
+    DIFF_ENUM("/target/@tray", tray_status, virDomainDiskTray);
+    DIFF_TRISTATE_SWITCH("/target/@removable", removable);
+    DIFF_UNSIGNED("/target/@rotation_rate", rotation_rate);
+
+    DIFF_UNSIGNED("/geometry/@cyls", geometry.cylinders);
+    DIFF_UNSIGNED("/geometry/@heads", geometry.heads);
+    DIFF_UNSIGNED("/geometry/@secs", geometry.sectors);
+    DIFF_ENUM("/geometry/@trans", geometry.trans, virDomainDiskGeometryTrans);
+
+    DIFF_UNSIGNED("/blockio/@logical_block_size", blockio.logical_block_size);
+    DIFF_UNSIGNED("/blockio/@physical_block_size", blockio.physical_block_size);
+    DIFF_UNSIGNED("/blockio/@discard_granularity", blockio.discard_granularity);
+
+    virDomainDefDiffIoTune(ctx, iotunePath, &a->blkdeviotune, &b->blkdeviotune);
+
+    DIFF_BOOL("/readonly", src->readonly);
+    DIFF_BOOL("/shareable", src->shared);
+    DIFF_BOOL("/transient", transient);
+    DIFF_TRISTATE_BOOL("/transient/@shareBacking", transientShareBacking);
+    DIFF_STRING("/serial", serial);
+    DIFF_STRING("/wwn", wwn);
+    DIFF_STRING("/vendor", vendor);
+    DIFF_STRING("/product", product);
+    DIFF_STRING("/backenddomain/@name", domain_name);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static virDomainDefDiffEnumToString
+virDomainDefDiffControllerModelToString(virDomainControllerType type)
+{
+    switch (type) {
+    case VIR_DOMAIN_CONTROLLER_TYPE_SCSI:
+        return virDomainControllerModelSCSITypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_USB:
+        return virDomainControllerModelUSBTypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_PCI:
+        return virDomainControllerModelPCITypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_IDE:
+        return virDomainControllerModelIDETypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_VIRTIO_SERIAL:
+        return virDomainControllerModelVirtioSerialTypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_ISA:
+        return virDomainControllerModelISATypeToString;
+    case VIR_DOMAIN_CONTROLLER_TYPE_FDC:
+    case VIR_DOMAIN_CONTROLLER_TYPE_SATA:
+    case VIR_DOMAIN_CONTROLLER_TYPE_CCID:
+    case VIR_DOMAIN_CONTROLLER_TYPE_XENBUS:
+    case VIR_DOMAIN_CONTROLLER_TYPE_LAST:
+        break;
+    }
+
+    return virDomainDefDiffNoName;
+}
+
+
+static void
+virDomainDefDiffController(virDomainDefDiffCtx *ctx,
+                           const char *path,
+                           virDomainControllerDef *a,
+                           virDomainControllerDef *b)
+{
+    DIFF_ENUM("/@type", type, virDomainController);
+    DIFF_SIGNED("/@index", idx);
+
+    if (a->type != b->type)
+        return;
+
+    virDomainDefDiffEnum(ctx, path, "/@model", a->model, b->model,
+                         virDomainDefDiffControllerModelToString(a->type));
+
+    DIFF_UNSIGNED("/driver/@queues", queues);
+    DIFF_UNSIGNED("/driver/@cmd_per_lun", cmd_per_lun);
+    DIFF_UNSIGNED("/driver/@max_sectors", max_sectors);
+    DIFF_TRISTATE_SWITCH("/driver/@ioeventfd", ioeventfd);
+    DIFF_UNSIGNED("/driver/@iothread", iothread);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    switch (a->type) {
+    case VIR_DOMAIN_CONTROLLER_TYPE_VIRTIO_SERIAL:
+        DIFF_SIGNED("/@ports", opts.vioserial.ports);
+        DIFF_SIGNED("/@vectors", opts.vioserial.vectors);
+        break;
+
+    case VIR_DOMAIN_CONTROLLER_TYPE_PCI:
+        virDomainDefDiffValue(ctx, path, "/pcihole64",
+                              a->opts.pciopts.pcihole64 ?
+                              g_strdup_printf("%llu", a->opts.pciopts.pcihole64size) : NULL,
+                              b->opts.pciopts.pcihole64 ?
+                              g_strdup_printf("%llu", b->opts.pciopts.pcihole64size) : NULL);
+        DIFF_ENUM("/model/@name", opts.pciopts.modelName,
+                  virDomainControllerPCIModelName);
+        DIFF_SIGNED("/target/@chassisNr", opts.pciopts.chassisNr);
+        DIFF_SIGNED("/target/@chassis", opts.pciopts.chassis);
+        DIFF_SIGNED("/target/@port", opts.pciopts.port);
+        DIFF_SIGNED("/target/@busNr", opts.pciopts.busNr);
+        DIFF_SIGNED("/target/@index", opts.pciopts.targetIndex);
+        DIFF_SIGNED("/target/node", opts.pciopts.numaNode);
+        DIFF_TRISTATE_SWITCH("/target/@hotplug", opts.pciopts.hotplug);
+        break;
+
+    case VIR_DOMAIN_CONTROLLER_TYPE_USB:
+        DIFF_SIGNED("/@ports", opts.usbopts.ports);
+        break;
+
+    case VIR_DOMAIN_CONTROLLER_TYPE_XENBUS:
+        DIFF_SIGNED("/@maxGrantFrames", opts.xenbusopts.maxGrantFrames);
+        DIFF_SIGNED("/@maxEventChannels", opts.xenbusopts.maxEventChannels);
+        break;
+
+    case VIR_DOMAIN_CONTROLLER_TYPE_IDE:
+    case VIR_DOMAIN_CONTROLLER_TYPE_FDC:
+    case VIR_DOMAIN_CONTROLLER_TYPE_SCSI:
+    case VIR_DOMAIN_CONTROLLER_TYPE_SATA:
+    case VIR_DOMAIN_CONTROLLER_TYPE_CCID:
+    case VIR_DOMAIN_CONTROLLER_TYPE_ISA:
+    case VIR_DOMAIN_CONTROLLER_TYPE_LAST:
+        break;
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffLease(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainLeaseDef *a,
+                      virDomainLeaseDef *b)
+{
+    DIFF_STRING("/lockspace", lockspace);
+    DIFF_STRING("/key", key);
+    DIFF_STRING("/target/@path", path);
+    DIFF_UNSIGNED("/target/@offset", offset);
+}
+
+
+static const char *
+virDomainDefDiffFSSourceAttr(virDomainFSType type)
+{
+    switch (type) {
+    case VIR_DOMAIN_FS_TYPE_BLOCK:
+        return "/source/@dev";
+    case VIR_DOMAIN_FS_TYPE_FILE:
+        return "/source/@file";
+    case VIR_DOMAIN_FS_TYPE_TEMPLATE:
+        return "/source/@name";
+    case VIR_DOMAIN_FS_TYPE_MOUNT:
+    case VIR_DOMAIN_FS_TYPE_BIND:
+    case VIR_DOMAIN_FS_TYPE_RAM:
+    case VIR_DOMAIN_FS_TYPE_VOLUME:
+    case VIR_DOMAIN_FS_TYPE_LAST:
+        break;
+    }
+
+    return "/source/@dir";
+}
+
+
+static void
+virDomainDefDiffFS(virDomainDefDiffCtx *ctx,
+                   const char *path,
+                   virDomainFSDef *a,
+                   virDomainFSDef *b)
+{
+    DIFF_ENUM("/@type", type, virDomainFS);
+    DIFF_ENUM("/@accessmode", accessmode, virDomainFSAccessMode);
+    DIFF_ENUM("/@model", model, virDomainFSModel);
+    DIFF_ENUM("/@multidevs", multidevs, virDomainFSMultidevs);
+    DIFF_UNSIGNED("/@fmode", fmode);
+    DIFF_UNSIGNED("/@dmode", dmode);
+
+    DIFF_ENUM("/driver/@type", fsdriver, virDomainFSDriver);
+    DIFF_ENUM("/driver/@format", format, virStorageFileFormat);
+    DIFF_ENUM("/driver/@wrpolicy", wrpolicy, virDomainFSWrpolicy);
+    DIFF_UNSIGNED("/driver/@queue", queue_size);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    DIFF_STRING("/binary/@path", binary);
+    DIFF_TRISTATE_SWITCH("/binary/@xattr", xattr);
+    DIFF_ENUM("/binary/cache/@mode", cache, virDomainFSCacheMode);
+    DIFF_ENUM("/binary/sandbox/@mode", sandbox, virDomainFSSandboxMode);
+    DIFF_TRISTATE_SWITCH("/binary/lock/@posix", posix_lock);
+    DIFF_TRISTATE_SWITCH("/binary/lock/@flock", flock);
+    DIFF_SIGNED("/binary/thread_pool/@size", thread_pool_size);
+
+    virDomainDefDiffIdmap(ctx, path, &a->idmap, &b->idmap);
+
+    if (a->type == b->type) {
+        switch (a->type) {
+        case VIR_DOMAIN_FS_TYPE_RAM:
+            DIFF_UNSIGNED("/source/@usage", usage);
+            break;
+
+        case VIR_DOMAIN_FS_TYPE_VOLUME:
+            virDomainDefDiffString(ctx, path, "/source/@pool",
+                                   a->src->srcpool ? a->src->srcpool->pool : NULL,
+                                   b->src->srcpool ? b->src->srcpool->pool : NULL);
+            virDomainDefDiffString(ctx, path, "/source/@volume",
+                                   a->src->srcpool ? a->src->srcpool->volume : NULL,
+                                   b->src->srcpool ? b->src->srcpool->volume : NULL);
+            break;
+
+        case VIR_DOMAIN_FS_TYPE_MOUNT:
+        case VIR_DOMAIN_FS_TYPE_BIND:
+            DIFF_STRING("/source/@socket", sock);
+            G_GNUC_FALLTHROUGH;
+        case VIR_DOMAIN_FS_TYPE_BLOCK:
+        case VIR_DOMAIN_FS_TYPE_FILE:
+        case VIR_DOMAIN_FS_TYPE_TEMPLATE:
+            virDomainDefDiffString(ctx, path, virDomainDefDiffFSSourceAttr(a->type),
+                                   a->src->path, b->src->path);
+            break;
+
+        case VIR_DOMAIN_FS_TYPE_LAST:
+            break;
+        }
+    }
+
+    DIFF_STRING("/target/@dir", dst);
+    DIFF_BOOL("/readonly", readonly);
+    DIFF_UNSIGNED("/space_hard_limit", space_hard_limit);
+    DIFF_UNSIGNED("/space_soft_limit", space_soft_limit);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffHostdevSubsys(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              virDomainHostdevSubsys *a,
+                              virDomainHostdevSubsys *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+    g_autofree char *addrPath = g_strconcat(path, "/source/address", NULL);
+
+    if (a->type != b->type) {
+        DIFF_ENUM("/@type", type, virDomainHostdevSubsys);
+        return;
+    }
+
+    switch (a->type) {
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_USB:
+        DIFF_HEX("/source/vendor/@id", u.usb.vendor);
+        DIFF_HEX("/source/product/@id", u.usb.product);
+        /* the address of devices given by vendor and product is looked up
+         * when the domain is started */
+        if (!a->u.usb.autoAddress || !b->u.usb.autoAddress) {
+            DIFF_UNSIGNED("/source/address/@bus", u.usb.bus);
+            DIFF_UNSIGNED("/source/address/@device", u.usb.device);
+        }
+        DIFF_ENUM("/source/@guestReset", u.usb.guestReset,
+                  virDomainHostdevSubsysUSBGuestReset);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_PCI:
+        virDomainDefDiffAddressPCI(ctx, addrPath,
+                                   &a->u.pci.addr, &b->u.pci.addr);
+        DIFF_ENUM("/driver/@name", u.pci.driver.name, virDeviceHostdevPCIDriverName);
+        DIFF_STRING("/driver/@model", u.pci.driver.model);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_SCSI:
+        DIFF_ENUM("/@sgio", u.scsi.sgio, virDomainDeviceSGIO);
+        DIFF_TRISTATE_BOOL("/@rawio", u.scsi.rawio);
+
+        if (a->u.scsi.protocol != b->u.scsi.protocol) {
+            DIFF_ENUM("/source/@protocol", u.scsi.protocol,
+                      virDomainHostdevSubsysSCSIProtocol);
+            break;
+        }
+
+        if (a->u.scsi.protocol == VIR_DOMAIN_HOSTDEV_SCSI_PROTOCOL_TYPE_ISCSI) {
+            virDomainDefDiffStorageSource(ctx, sourcePath,
+                                          a->u.scsi.u.iscsi.src,
+                                          b->u.scsi.u.iscsi.src);
+        } else {
+            DIFF_STRING("/source/adapter/@name", u.scsi.u.host.adapter);
+            DIFF_UNSIGNED("/source/address/@bus", u.scsi.u.host.bus);
+            DIFF_UNSIGNED("/source/address/@target", u.scsi.u.host.target);
+            DIFF_UNSIGNED("/source/address/@unit", u.scsi.u.host.unit);
+        }
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_SCSI_HOST:
+        DIFF_ENUM("/source/@protocol", u.scsi_host.protocol,
+                  virDomainHostdevSubsysSCSIHostProtocol);
+        DIFF_STRING("/source/@wwpn", u.scsi_host.wwpn);
+        DIFF_ENUM("/@model", u.scsi_host.model, virDomainHostdevSubsysSCSIVHostModel);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_MDEV:
+        DIFF_ENUM("/@model", u.mdev.model, virMediatedDeviceModel);
+        DIFF_TRISTATE_SWITCH("/@display", u.mdev.display);
+        DIFF_STRING("/source/address/@uuid", u.mdev.uuidstr);
+        DIFF_TRISTATE_SWITCH("/@ramfb", u.mdev.ramfb);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_SUBSYS_TYPE_LAST:
+        break;
+    }
+}
+
+
+static void
+virDomainDefDiffHostdevCaps(virDomainDefDiffCtx *ctx,
+                            const char *path,
+                            virDomainHostdevCaps *a,
+                            virDomainHostdevCaps *b)
+{
+    if (a->type != b->type) {
+        DIFF_ENUM("/@type", type, virDomainHostdevCaps);
+        return;
+    }
+
+    switch (a->type) {
+    case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_STORAGE:
+        DIFF_STRING("/source/block", u.storage.block);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_MISC:
+        DIFF_STRING("/source/char", u.misc.chardev);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_NET:
+        DIFF_STRING("/source/interface", u.net.ifname);
+        virDomainDefDiffIPInfo(ctx, path, &a->u.net.ip, &b->u.net.ip);
+        break;
+
+    case VIR_DOMAIN_HOSTDEV_CAPS_TYPE_LAST:
+        break;
+    }
+}
+
+
+/* Compares the host side of a host device, which is shared by <hostdev>
+ * and <interface type='hostdev'>. */
+static void
+virDomainDefDiffHostdevSource(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              virDomainHostdevDef *a,
+                              virDomainHostdevDef *b)
+{
+    DIFF_ENUM("/@mode", mode, virDomainHostdevMode);
+    DIFF_BOOL("/@managed", managed);
+
+    if (a->mode != b->mode)
+        return;
+
+    if (a->mode == VIR_DOMAIN_HOSTDEV_MODE_SUBSYS)
+        virDomainDefDiffHostdevSubsys(ctx, path, &a->source.subsys, &b->source.subsys);
+    else
+        virDomainDefDiffHostdevCaps(ctx, path, &a->source.caps, &b->source.caps);
+}
+
+
+static void
+virDomainDefDiffHostdev(virDomainDefDiffCtx *ctx,
+                        const char *path,
+                        virDomainHostdevDef *a,
+                        virDomainHostdevDef *b)
+{
+    virDomainDefDiffHostdevSource(ctx, path, a, b);
+
+    DIFF_ENUM("/source/@startupPolicy", startupPolicy, virDomainStartupPolicy);
+    DIFF_TRISTATE_BOOL("/source/@writeFiltering", writeFiltering);
+    DIFF_BOOL("/readonly", readonly);
+    DIFF_BOOL("/shareable", shareable);
+    virDomainDefDiffTeaming(ctx, path, a->teaming, b->teaming);
+
+    virDomainDefDiffDeviceInfo(ctx, path, a->info, b->info);
+}
+
+
+/* Names of tap devices generated by libvirt aren't part of the inactive
+ * definition. */
+static const char *
+virDomainDefDiffNetIfname(virDomainDefDiffCtx *ctx,
+                          virDomainNetDef *net)
+{
+    if (!net->ifname ||
+        net->managed_tap == VIR_TRISTATE_BOOL_NO ||
+        !(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE))
+        return net->ifname;
+
+    if (STRPREFIX(net->ifname, VIR_NET_GENERATED_VNET_PREFIX) ||
+        STRPREFIX(net->ifname, VIR_NET_GENERATED_MACVTAP_PREFIX) ||
+        STRPREFIX(net->ifname, VIR_NET_GENERATED_MACVLAN_PREFIX))
+        return NULL;
+
+    return net->ifname;
+}
+
+
+static void
+virDomainDefDiffNetPortForwards(virDomainDefDiffCtx *ctx,
+                                const char *parent,
+                                virDomainNetDef *oldNet,
+                                virDomainNetDef *newNet)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < MAX(oldNet->nPortForwards, newNet->nPortForwards); i++) {
+        g_autofree char *path = virDomainDefDiffPath(parent, "/portForward[%zu]", i + 1);
+        virDomainNetPortForward *a;
+        virDomainNetPortForward *b;
+
+        if (i >= oldNet->nPortForwards || i >= newNet->nPortForwards) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    i < oldNet->nPortForwards,
+                                    i < newNet->nPortForwards);
+            continue;
+        }
+
+        a = oldNet->portForwards[i];
+        b = newNet->portForwards[i];
+
+        DIFF_STRING("/@dev", dev);
+        DIFF_ENUM("/@proto", proto, virDomainNetProto);
+        DIFF_SOCKET_ADDR("/@address", address);
+
+        for (j = 0; j < MAX(a->nRanges, b->nRanges); j++) {
+            g_autofree char *rangePath = virDomainDefDiffPath(path, "/range[%zu]", j + 1);
+            virDomainNetPortForwardRange *oldRange;
+            virDomainNetPortForwardRange *newRange;
+
+            if (j >= a->nRanges || j >= b->nRanges) {
+                virDomainDefDiffElement(ctx, rangePath, "",
+                                        j < a->nRanges, j < b->nRanges);
+                continue;
+            }
+
+            oldRange = a->ranges[j];
+            newRange = b->ranges[j];
+
+            virDomainDefDiffUnsigned(ctx, rangePath, "/@start",
+                                     oldRange->start, newRange->start);
+            virDomainDefDiffUnsigned(ctx, rangePath, "/@end",
+                                     oldRange->end, newRange->end);
+            virDomainDefDiffUnsigned(ctx, rangePath, "/@to",
+                                     oldRange->to, newRange->to);
+            virDomainDefDiffEnum(ctx, rangePath, "/@exclude",
+                                 oldRange->exclude, newRange->exclude,
+                                 virTristateBoolTypeToString);
+        }
+    }
+}
+
+
+static void
+virDomainDefDiffNetCoalesce(virDomainDefDiffCtx *ctx,
+                            const char *path,
+                            virNetDevCoalesce *oldCoalesce,
+                            virNetDevCoalesce *newCoalesce)
+{
+    virDomainDefDiffValue(ctx, path, "/coalesce/rx/frames/@max",
+                          oldCoalesce ?
+                          g_strdup_printf("%u", oldCoalesce->rx_max_coalesced_frames) : NULL,
+                          newCoalesce ?
+                          g_strdup_printf("%u", newCoalesce->rx_max_coalesced_frames) : NULL);
+}
+
+
+/* The <virtualport> and <vlan> elements are small and compared as a whole. */
+static void
+virDomainDefDiffNetVportVlan(virDomainDefDiffCtx *ctx,
+                             const char *path,
+                             const virNetDevVPortProfile *oldProfile,
+                             const virNetDevVPortProfile *newProfile,
+                             const virNetDevVlan *oldVlan,
+                             const virNetDevVlan *newVlan)
+{
+    if (!virNetDevVPortProfileEqual(oldProfile, newProfile))
+        virDomainDefDiffElement(ctx, path, "/virtualport",
+                                !!oldProfile, !!newProfile);
+
+    if (!virNetDevVlanEqual(oldVlan, newVlan))
+        virDomainDefDiffElement(ctx, path, "/vlan",
+                                oldVlan->nTags > 0, newVlan->nTags > 0);
+}
+
+
+static void
+virDomainDefDiffActualNet(virDomainDefDiffCtx *ctx,
+                          const char *parent,
+                          virDomainActualNetDef *a,
+                          virDomainActualNetDef *b)
+{
+    g_autofree char *path = g_strconcat(parent, "/actual", NULL);
+
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_ENUM("/@type", type, virDomainNet);
+
+    if (a->type == b->type) {
+        switch (a->type) {
+        case VIR_DOMAIN_NET_TYPE_BRIDGE:
+        case VIR_DOMAIN_NET_TYPE_NETWORK:
+            DIFF_STRING("/source/@bridge", data.bridge.brname);
+            DIFF_ENUM("/source/@macTableManager", data.bridge.macTableManager,
+                      virNetworkBridgeMACTableManager);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_DIRECT:
+            DIFF_STRING("/source/@dev", data.direct.linkdev);
+            DIFF_ENUM("/source/@mode", data.direct.mode, virNetDevMacVLanMode);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+            virDomainDefDiffHostdevSource(ctx, path, &a->data.hostdev.def,
+                                          &b->data.hostdev.def);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_USER:
+        case VIR_DOMAIN_NET_TYPE_ETHERNET:
+        case VIR_DOMAIN_NET_TYPE_VHOSTUSER:
+        case VIR_DOMAIN_NET_TYPE_SERVER:
+        case VIR_DOMAIN_NET_TYPE_CLIENT:
+        case VIR_DOMAIN_NET_TYPE_MCAST:
+        case VIR_DOMAIN_NET_TYPE_INTERNAL:
+        case VIR_DOMAIN_NET_TYPE_UDP:
+        case VIR_DOMAIN_NET_TYPE_VDPA:
+        case VIR_DOMAIN_NET_TYPE_NULL:
+        case VIR_DOMAIN_NET_TYPE_VDS:
+        case VIR_DOMAIN_NET_TYPE_LAST:
+            break;
+        }
+    }
+
+    virDomainDefDiffNetVportVlan(ctx, path, a->virtPortProfile, b->virtPortProfile,
+                                 &a->vlan, &b->vlan);
+    virDomainDefDiffBandwidth(ctx, path, a->bandwidth, b->bandwidth);
+    DIFF_TRISTATE_BOOL("/@trustGuestRxFilters", trustGuestRxFilters);
+    DIFF_TRISTATE_BOOL("/port/@isolated", isolatedPort);
+    DIFF_UNSIGNED("/class/@id", class_id);
+}
+
+
+static void
+virDomainDefDiffNet(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    virDomainNetDef *a,
+                    virDomainNetDef *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+    bool inactive = !!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE);
+
+    DIFF_ENUM("/@type", type, virDomainNet);
+    DIFF_TRISTATE_BOOL("/@trustGuestRxFilters", trustGuestRxFilters);
+
+    if (virMacAddrCmp(&a->mac, &b->mac) != 0) {
+        char oldmac[VIR_MAC_STRING_BUFLEN];
+        char newmac[VIR_MAC_STRING_BUFLEN];
+
+        virDomainDefDiffValue(ctx, path, "/mac/@address",
+                              g_strdup(virMacAddrFormat(&a->mac, oldmac)),
+                              g_strdup(virMacAddrFormat(&b->mac, newmac)));
+    }
+    DIFF_ENUM("/mac/@type", mac_type, virDomainNetMacType);
+    DIFF_TRISTATE_BOOL("/mac/@check", mac_check);
+
+    virDomainDefDiffString(ctx, path, "/model/@type",
+                           virDomainNetGetModelString(a),
+                           virDomainNetGetModelString(b));
+
+    DIFF_ENUM("/driver/@name", driver.virtio.name, virDomainNetDriver);
+    DIFF_ENUM("/driver/@txmode", driver.virtio.txmode, virDomainNetVirtioTxMode);
+    DIFF_TRISTATE_SWITCH("/driver/@ioeventfd", driver.virtio.ioeventfd);
+    DIFF_TRISTATE_SWITCH("/driver/@event_idx", driver.virtio.event_idx);
+    DIFF_UNSIGNED("/driver/@queues", driver.virtio.queues);
+    DIFF_UNSIGNED("/driver/@rx_queue_size", driver.virtio.rx_queue_size);
+    DIFF_UNSIGNED("/driver/@tx_queue_size", driver.virtio.tx_queue_size);
+    DIFF_TRISTATE_SWITCH("/driver/@rss", driver.virtio.rss);
+    DIFF_TRISTATE_SWITCH("/driver/@rss_hash_report", driver.virtio.rss_hash_report);
+    DIFF_TRISTATE_SWITCH("/driver/host/@csum", driver.virtio.host.csum);
+    DIFF_TRISTATE_SWITCH("/driver/host/@gso", driver.virtio.host.gso);
+    DIFF_TRISTATE_SWITCH("/driver/host/@tso4", driver.virtio.host.tso4);
+    DIFF_TRISTATE_SWITCH("/driver/host/@tso6", driver.virtio.host.tso6);
+    DIFF_TRISTATE_SWITCH("/driver/host/@ecn", driver.virtio.host.ecn);
+    DIFF_TRISTATE_SWITCH("/driver/host/@ufo", driver.virtio.host.ufo);
+    DIFF_TRISTATE_SWITCH("/driver/host/@mrg_rxbuf", driver.virtio.host.mrg_rxbuf);
+    DIFF_TRISTATE_SWITCH("/driver/guest/@csum", driver.virtio.guest.csum);
+    DIFF_TRISTATE_SWITCH("/driver/guest/@tso4", driver.virtio.guest.tso4);
+    DIFF_TRISTATE_SWITCH("/driver/guest/@tso6", driver.virtio.guest.tso6);
+    DIFF_TRISTATE_SWITCH("/driver/guest/@ecn", driver.virtio.guest.ecn);
+    DIFF_TRISTATE_SWITCH("/driver/guest/@ufo", driver.virtio.guest.ufo);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    DIFF_ENUM("/backend/@type", backend.type, virDomainNetBackend);
+    DIFF_STRING("/backend/@tap", backend.tap);
+    DIFF_STRING("/backend/@vhost", backend.vhost);
+    DIFF_STRING("/backend/@logFile", backend.logFile);
+
+    virDomainDefDiffTeaming(ctx, path, a->teaming, b->teaming);
+
+    if (a->type == b->type) {
+        switch (a->type) {
+        case VIR_DOMAIN_NET_TYPE_VHOSTUSER:
+            virDomainDefDiffChrSource(ctx, path, sourcePath,
+                                      a->data.vhostuser, b->data.vhostuser);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_SERVER:
+        case VIR_DOMAIN_NET_TYPE_CLIENT:
+        case VIR_DOMAIN_NET_TYPE_MCAST:
+        case VIR_DOMAIN_NET_TYPE_UDP:
+            DIFF_STRING("/source/@address", data.socket.address);
+            DIFF_SIGNED("/source/@port", data.socket.port);
+            DIFF_STRING("/source/local/@address", data.socket.localaddr);
+            DIFF_SIGNED("/source/local/@port", data.socket.localport);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_NETWORK:
+            DIFF_STRING("/source/@network", data.network.name);
+            DIFF_STRING("/source/@portgroup", data.network.portgroup);
+            /* ports of the network are allocated when the domain starts */
+            if (!inactive) {
+                DIFF_UUID("/source/@portid", data.network.portid);
+                virDomainDefDiffActualNet(ctx, path, a->data.network.actual,
+                                          b->data.network.actual);
+            }
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_VDPA:
+            DIFF_STRING("/source/@dev", data.vdpa.devicepath);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_BRIDGE:
+            DIFF_STRING("/source/@bridge", data.bridge.brname);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_INTERNAL:
+            DIFF_STRING("/source/@name", data.internal.name);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_DIRECT:
+            DIFF_STRING("/source/@dev", data.direct.linkdev);
+            DIFF_ENUM("/source/@mode", data.direct.mode, virNetDevMacVLanMode);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+            virDomainDefDiffHostdevSource(ctx, path, &a->data.hostdev.def,
+                                          &b->data.hostdev.def);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_VDS:
+            DIFF_UUID("/source/@switchid", data.vds.switch_id);
+            DIFF_STRING("/source/@portgroupid", data.vds.portgroup_id);
+            DIFF_SIGNED("/source/@portid", data.vds.port_id);
+            DIFF_SIGNED("/source/@connectionid", data.vds.connection_id);
+            break;
+
+        case VIR_DOMAIN_NET_TYPE_USER:
+        case VIR_DOMAIN_NET_TYPE_ETHERNET:
+        case VIR_DOMAIN_NET_TYPE_NULL:
+        case VIR_DOMAIN_NET_TYPE_LAST:
+            break;
+        }
+    }
+
+    DIFF_STRING("/source/@dev", sourceDev);
+    virDomainDefDiffIPInfo(ctx, sourcePath, &a->hostIP, &b->hostIP);
+    virDomainDefDiffIPInfo(ctx, path, &a->guestIP, &b->guestIP);
+    virDomainDefDiffNetPortForwards(ctx, path, a, b);
+
+    virDomainDefDiffNetVportVlan(ctx, path, a->virtPortProfile, b->virtPortProfile,
+                                 &a->vlan, &b->vlan);
+    virDomainDefDiffBandwidth(ctx, path, a->bandwidth, b->bandwidth);
+
+    virDomainDefDiffValue(ctx, path, "/tune/sndbuf",
+                          a->tune.sndbuf_specified ?
+                          g_strdup_printf("%llu", a->tune.sndbuf) : NULL,
+                          b->tune.sndbuf_specified ?
+                          g_strdup_printf("%llu", b->tune.sndbuf) : NULL);
+
+    DIFF_STRING("/script/@path", script);
+    DIFF_STRING("/downscript/@path", downscript);
+    DIFF_STRING("/backenddomain/@name", domain_name);
+    virDomainDefDiffString(ctx, path, "/target/@dev",
+                           virDomainDefDiffNetIfname(ctx, a),
+                           virDomainDefDiffNetIfname(ctx, b));
+    DIFF_TRISTATE_BOOL("/target/@managed", managed_tap);
+    DIFF_STRING("/guest/@dev", ifname_guest);
+    DIFF_STRING("/guest/@actual", ifname_guest_actual);
+
+    DIFF_STRING("/filterref/@filter", filter);
+    if (!virNWFilterHashTableEqual(a->filterparams, b->filterparams))
+        virDomainDefDiffElement(ctx, path, "/filterref", !!a->filter, !!b->filter);
+
+    DIFF_TRISTATE_BOOL("/port/@isolated", isolatedPort);
+    DIFF_ENUM("/link/@state", linkstate, virDomainNetInterfaceLinkState);
+    DIFF_UNSIGNED("/mtu/@size", mtu);
+    virDomainDefDiffNetCoalesce(ctx, path, a->coalesce, b->coalesce);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffInput(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainInputDef *a,
+                      virDomainInputDef *b)
+{
+    DIFF_ENUM("/@type", type, virDomainInput);
+    DIFF_ENUM("/@bus", bus, virDomainInputBus);
+    DIFF_ENUM("/@model", model, virDomainInputModel);
+    DIFF_STRING("/source/@evdev", source.evdev);
+    DIFF_ENUM("/source/@grab", source.grab, virDomainInputSourceGrab);
+    DIFF_ENUM("/source/@grabToggle", source.grabToggle, virDomainInputSourceGrabToggle);
+    DIFF_TRISTATE_SWITCH("/source/@repeat", source.repeat);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffSound(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainSoundDef *a,
+                      virDomainSoundDef *b)
+{
+    size_t i;
+
+    DIFF_ENUM("/@model", model, virDomainSoundModel);
+    DIFF_TRISTATE_BOOL("/@multichannel", multichannel);
+    DIFF_UNSIGNED("/audio/@id", audioId);
+
+    for (i = 0; i < MAX(a->ncodecs, b->ncodecs); i++) {
+        g_autofree char *codecPath = virDomainDefDiffPath(path, "/codec[%zu]", i + 1);
+
+        if (i >= a->ncodecs || i >= b->ncodecs) {
+            virDomainDefDiffElement(ctx, codecPath, "",
+                                    i < a->ncodecs, i < b->ncodecs);
+            continue;
+        }
+
+        virDomainDefDiffEnum(ctx, codecPath, "/@type",
+                             a->codecs[i]->type, b->codecs[i]->type,
+                             virDomainSoundCodecTypeToString);
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffAudioIOCommon(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              virDomainAudioIOCommon *a,
+                              virDomainAudioIOCommon *b)
+{
+    DIFF_TRISTATE_BOOL("/@mixingEngine", mixingEngine);
+    DIFF_TRISTATE_BOOL("/@fixedSettings", fixedSettings);
+    DIFF_UNSIGNED("/@voices", voices);
+    DIFF_UNSIGNED("/@bufferLength", bufferLength);
+    DIFF_UNSIGNED("/settings/@frequency", frequency);
+    DIFF_UNSIGNED("/settings/@channels", channels);
+    DIFF_ENUM("/settings/@format", format, virDomainAudioFormat);
+}
+
+
+static void
+virDomainDefDiffAudio(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainAudioDef *a,
+                      virDomainAudioDef *b)
+{
+    g_autofree char *inPath = g_strconcat(path, "/input", NULL);
+    g_autofree char *outPath = g_strconcat(path, "/output", NULL);
+
+    DIFF_ENUM("/@type", type, virDomainAudioType);
+    DIFF_UNSIGNED("/@id", id);
+    DIFF_UNSIGNED("/@timerPeriod", timerPeriod);
+
+    virDomainDefDiffAudioIOCommon(ctx, inPath, &a->input, &b->input);
+    virDomainDefDiffAudioIOCommon(ctx, outPath, &a->output, &b->output);
+
+    if (a->type != b->type)
+        return;
+
+    switch (a->type) {
+    case VIR_DOMAIN_AUDIO_TYPE_ALSA:
+        DIFF_STRING("/input/@dev", backend.alsa.input.dev);
+        DIFF_STRING("/output/@dev", backend.alsa.output.dev);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_COREAUDIO:
+        DIFF_UNSIGNED("/input/@bufferCount", backend.coreaudio.input.bufferCount);
+        DIFF_UNSIGNED("/output/@bufferCount", backend.coreaudio.output.bufferCount);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_JACK:
+        DIFF_STRING("/input/@serverName", backend.jack.input.serverName);
+        DIFF_STRING("/input/@clientName", backend.jack.input.clientName);
+        DIFF_STRING("/input/@connectPorts", backend.jack.input.connectPorts);
+        DIFF_TRISTATE_BOOL("/input/@exactName", backend.jack.input.exactName);
+        DIFF_STRING("/output/@serverName", backend.jack.output.serverName);
+        DIFF_STRING("/output/@clientName", backend.jack.output.clientName);
+        DIFF_STRING("/output/@connectPorts", backend.jack.output.connectPorts);
+        DIFF_TRISTATE_BOOL("/output/@exactName", backend.jack.output.exactName);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_OSS:
+        DIFF_STRING("/input/@dev", backend.oss.input.dev);
+        DIFF_UNSIGNED("/input/@bufferCount", backend.oss.input.bufferCount);
+        DIFF_TRISTATE_BOOL("/input/@tryPoll", backend.oss.input.tryPoll);
+        DIFF_STRING("/output/@dev", backend.oss.output.dev);
+        DIFF_UNSIGNED("/output/@bufferCount", backend.oss.output.bufferCount);
+        DIFF_TRISTATE_BOOL("/output/@tryPoll", backend.oss.output.tryPoll);
+        DIFF_TRISTATE_BOOL("/@tryMMap", backend.oss.tryMMap);
+        DIFF_TRISTATE_BOOL("/@exclusive", backend.oss.exclusive);
+        virDomainDefDiffValue(ctx, path, "/@dspPolicy",
+                              a->backend.oss.dspPolicySet ?
+                              g_strdup_printf("%d", a->backend.oss.dspPolicy) : NULL,
+                              b->backend.oss.dspPolicySet ?
+                              g_strdup_printf("%d", b->backend.oss.dspPolicy) : NULL);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_PULSEAUDIO:
+        DIFF_STRING("/input/@name", backend.pulseaudio.input.name);
+        DIFF_STRING("/input/@streamName", backend.pulseaudio.input.streamName);
+        DIFF_UNSIGNED("/input/@latency", backend.pulseaudio.input.latency);
+        DIFF_STRING("/output/@name", backend.pulseaudio.output.name);
+        DIFF_STRING("/output/@streamName", backend.pulseaudio.output.streamName);
+        DIFF_UNSIGNED("/output/@latency", backend.pulseaudio.output.latency);
+        DIFF_STRING("/@serverName", backend.pulseaudio.serverName);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_SDL:
+        DIFF_UNSIGNED("/input/@bufferCount", backend.sdl.input.bufferCount);
+        DIFF_UNSIGNED("/output/@bufferCount", backend.sdl.output.bufferCount);
+        DIFF_ENUM("/@driver", backend.sdl.driver, virDomainAudioSDLDriver);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_FILE:
+        DIFF_STRING("/@path", backend.file.path);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_PIPEWIRE:
+        DIFF_STRING("/input/@name", backend.pipewire.input.name);
+        DIFF_STRING("/input/@streamName", backend.pipewire.input.streamName);
+        DIFF_UNSIGNED("/input/@latency", backend.pipewire.input.latency);
+        DIFF_STRING("/output/@name", backend.pipewire.output.name);
+        DIFF_STRING("/output/@streamName", backend.pipewire.output.streamName);
+        DIFF_UNSIGNED("/output/@latency", backend.pipewire.output.latency);
+        DIFF_STRING("/@runtimeDir", backend.pipewire.runtimeDir);
+        break;
+
+    case VIR_DOMAIN_AUDIO_TYPE_NONE:
+    case VIR_DOMAIN_AUDIO_TYPE_SPICE:
+    case VIR_DOMAIN_AUDIO_TYPE_DBUS:
+    case VIR_DOMAIN_AUDIO_TYPE_LAST:
+        break;
+    }
+}
+
+
+static void
+virDomainDefDiffVideo(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainVideoDef *a,
+                      virDomainVideoDef *b)
+{
+    DIFF_ENUM("/model/@type", type, virDomainVideo);
+    DIFF_UNSIGNED("/model/@ram", ram);
+    DIFF_UNSIGNED("/model/@vram", vram);
+    DIFF_UNSIGNED("/model/@vram64", vram64);
+    DIFF_UNSIGNED("/model/@vgamem", vgamem);
+    DIFF_UNSIGNED("/model/@heads", heads);
+    DIFF_BOOL("/model/@primary", primary);
+    DIFF_TRISTATE_SWITCH("/model/@blob", blob);
+
+    if (DIFF_BOTH("/model/acceleration", accel)) {
+        DIFF_TRISTATE_BOOL("/model/acceleration/@accel2d", accel->accel2d);
+        DIFF_TRISTATE_BOOL("/model/acceleration/@accel3d", accel->accel3d);
+        DIFF_STRING("/model/acceleration/@rendernode", accel->rendernode);
+    }
+
+    if (DIFF_BOTH("/model/resolution", res)) {
+        DIFF_UNSIGNED("/model/resolution/@x", res->x);
+        DIFF_UNSIGNED("/model/resolution/@y", res->y);
+    }
+
+    virDomainDefDiffEnum(ctx, path, "/driver/@vgaconf",
+                         a->driver ? a->driver->vgaconf : 0,
+                         b->driver ? b->driver->vgaconf : 0,
+                         virDomainVideoVGAConfTypeToString);
+    DIFF_ENUM("/driver/@name", backend, virDomainVideoBackend);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffWatchdog(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         virDomainWatchdogDef *a,
+                         virDomainWatchdogDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainWatchdogModel);
+    DIFF_ENUM("/@action", action, virDomainWatchdogAction);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+/* Ports allocated when the domain is started are formatted as -1 into the
+ * inactive definition. */
+static void
+virDomainDefDiffGraphicsPort(virDomainDefDiffCtx *ctx,
+                             const char *path,
+                             const char *suffix,
+                             int oldPort,
+                             bool oldAutoport,
+                             int newPort,
+                             bool newAutoport)
+{
+    bool inactive = !!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE);
+
+    if (oldAutoport && (inactive || oldPort == 0))
+        oldPort = -1;
+    if (newAutoport && (inactive || newPort == 0))
+        newPort = -1;
+
+    virDomainDefDiffSigned(ctx, path, suffix, oldPort, newPort);
+}
+
+
+static void
+virDomainDefDiffGraphicsAuth(virDomainDefDiffCtx *ctx,
+                             const char *path,
+                             virDomainGraphicsAuthDef *a,
+                             virDomainGraphicsAuthDef *b)
+{
+    /* passwords are part of the secure definition only */
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_SECURE)
+        DIFF_STRING("/@passwd", passwd);
+
+    virDomainDefDiffValue(ctx, path, "/@passwdValidTo",
+                          a->expires ? g_strdup_printf("%lld", (long long) a->validTo) : NULL,
+                          b->expires ? g_strdup_printf("%lld", (long long) b->validTo) : NULL);
+    DIFF_ENUM("/@connected", connected, virDomainGraphicsAuthConnected);
+}
+
+
+static void
+virDomainDefDiffGraphicsListens(virDomainDefDiffCtx *ctx,
+                                const char *parent,
+                                virDomainGraphicsDef *oldGraphics,
+                                virDomainGraphicsDef *newGraphics)
+{
+    bool inactive = !!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE);
+    size_t i;
+
+    for (i = 0; i < MAX(oldGraphics->nListens, newGraphics->nListens); i++) {
+        g_autofree char *path = virDomainDefDiffPath(parent, "/listen[%zu]", i + 1);
+        virDomainGraphicsListenDef *a;
+        virDomainGraphicsListenDef *b;
+
+        if (i >= oldGraphics->nListens || i >= newGraphics->nListens) {
+            virDomainDefDiffElement(ctx, path, "",
+                                    i < oldGraphics->nListens,
+                                    i < newGraphics->nListens);
+            continue;
+        }
+
+        a = &oldGraphics->listens[i];
+        b = &newGraphics->listens[i];
+
+        if (a->type != b->type) {
+            DIFF_ENUM("/@type", type, virDomainGraphicsListen);
+            continue;
+        }
+
+        switch (a->type) {
+        case VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_NETWORK:
+            DIFF_STRING("/@network", network);
+            /* the address of the network is looked up on startup */
+            if (!inactive)
+                DIFF_STRING("/@address", address);
+            break;
+
+        case VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_ADDRESS:
+            DIFF_STRING("/@address", address);
+            break;
+
+        case VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_SOCKET:
+            DIFF_STRING("/@socket", socket);
+            break;
+
+        case VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_NONE:
+        case VIR_DOMAIN_GRAPHICS_LISTEN_TYPE_LAST:
+            break;
+        }
+    }
+}
+
+
+static void
+virDomainDefDiffGraphics(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         virDomainGraphicsDef *a,
+                         virDomainGraphicsDef *b)
+{
+    bool inactive = !!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE);
+    size_t i;
+
+    if (a->type != b->type) {
+        DIFF_ENUM("/@type", type, virDomainGraphics);
+        return;
+    }
+
+    switch (a->type) {
+    case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
+        virDomainDefDiffGraphicsPort(ctx, path, "/@port",
+                                     a->data.vnc.port, a->data.vnc.autoport,
+                                     b->data.vnc.port, b->data.vnc.autoport);
+        DIFF_BOOL("/@autoport", data.vnc.autoport);
+        virDomainDefDiffGraphicsPort(ctx, path, "/@websocket",
+                                     a->data.vnc.websocket,
+                                     a->data.vnc.websocketGenerated && inactive,
+                                     b->data.vnc.websocket,
+                                     b->data.vnc.websocketGenerated && inactive);
+        DIFF_STRING("/@keymap", data.vnc.keymap);
+        DIFF_ENUM("/@sharePolicy", data.vnc.sharePolicy, virDomainGraphicsVNCSharePolicy);
+        DIFF_TRISTATE_BOOL("/@powerControl", data.vnc.powerControl);
+        DIFF_UNSIGNED("/audio/@id", data.vnc.audioId);
+        virDomainDefDiffGraphicsAuth(ctx, path, &a->data.vnc.auth, &b->data.vnc.auth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
+        DIFF_STRING("/@display", data.sdl.display);
+        DIFF_STRING("/@xauth", data.sdl.xauth);
+        DIFF_BOOL("/@fullscreen", data.sdl.fullscreen);
+        DIFF_TRISTATE_BOOL("/gl/@enable", data.sdl.gl);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
+        virDomainDefDiffGraphicsPort(ctx, path, "/@port",
+                                     a->data.rdp.port, a->data.rdp.autoport,
+                                     b->data.rdp.port, b->data.rdp.autoport);
+        DIFF_BOOL("/@autoport", data.rdp.autoport);
+        DIFF_BOOL("/@replaceUser", data.rdp.replaceUser);
+        DIFF_BOOL("/@multiUser", data.rdp.multiUser);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
+        DIFF_STRING("/@display", data.desktop.display);
+        DIFF_BOOL("/@fullscreen", data.desktop.fullscreen);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
+        virDomainDefDiffGraphicsPort(ctx, path, "/@port",
+                                     a->data.spice.port, a->data.spice.autoport,
+                                     b->data.spice.port, b->data.spice.autoport);
+        virDomainDefDiffGraphicsPort(ctx, path, "/@tlsPort",
+                                     a->data.spice.tlsPort, a->data.spice.autoport,
+                                     b->data.spice.tlsPort, b->data.spice.autoport);
+        DIFF_BOOL("/@autoport", data.spice.autoport);
+        DIFF_STRING("/@keymap", data.spice.keymap);
+        DIFF_ENUM("/@defaultMode", data.spice.defaultMode,
+                  virDomainGraphicsSpiceChannelMode);
+        virDomainDefDiffGraphicsAuth(ctx, path, &a->data.spice.auth, &b->data.spice.auth);
+
+        for (i = 0; i < VIR_DOMAIN_GRAPHICS_SPICE_CHANNEL_LAST; i++) {
+            g_autofree char *channelPath = NULL;
+
+            if (a->data.spice.channels[i] == b->data.spice.channels[i])
+                continue;
+
+            channelPath = virDomainDefDiffPath(path, "/channel[@name='%s']",
+                                               virDomainGraphicsSpiceChannelNameTypeToString(i));
+            virDomainDefDiffEnum(ctx, channelPath, "/@mode",
+                                 a->data.spice.channels[i],
+                                 b->data.spice.channels[i],
+                                 virDomainGraphicsSpiceChannelModeTypeToString);
+        }
+
+        DIFF_ENUM("/mouse/@mode", data.spice.mousemode, virDomainMouseMode);
+        DIFF_ENUM("/image/@compression", data.spice.image,
+                  virDomainGraphicsSpiceImageCompression);
+        DIFF_ENUM("/jpeg/@compression", data.spice.jpeg,
+                  virDomainGraphicsSpiceJpegCompression);
+        DIFF_ENUM("/zlib/@compression", data.spice.zlib,
+                  virDomainGraphicsSpiceZlibCompression);
+        DIFF_TRISTATE_SWITCH("/playback/@compression", data.spice.playback);
+        DIFF_ENUM("/streaming/@mode", data.spice.streaming,
+                  virDomainGraphicsSpiceStreamingMode);
+        DIFF_TRISTATE_BOOL("/clipboard/@copypaste", data.spice.copypaste);
+        DIFF_TRISTATE_BOOL("/filetransfer/@enable", data.spice.filetransfer);
+        DIFF_TRISTATE_BOOL("/gl/@enable", data.spice.gl);
+        DIFF_STRING("/gl/@rendernode", data.spice.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
+        DIFF_STRING("/gl/@rendernode", data.egl_headless.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DBUS:
+        DIFF_BOOL("/@p2p", data.dbus.p2p);
+        DIFF_STRING("/@address", data.dbus.address);
+        DIFF_TRISTATE_BOOL("/gl/@enable", data.dbus.gl);
+        DIFF_STRING("/gl/@rendernode", data.dbus.rendernode);
+        DIFF_UNSIGNED("/audio/@id", data.dbus.audioId);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
+        break;
+    }
+
+    virDomainDefDiffGraphicsListens(ctx, path, a, b);
+}
+
+
+static void
+virDomainDefDiffHub(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    virDomainHubDef *a,
+                    virDomainHubDef *b)
+{
+    DIFF_ENUM("/@type", type, virDomainHub);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffRedirdev(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         virDomainRedirdevDef *a,
+                         virDomainRedirdevDef *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+
+    DIFF_ENUM("/@bus", bus, virDomainRedirdevBus);
+    virDomainDefDiffChrSource(ctx, path, sourcePath, a->source, b->source);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffSmartcard(virDomainDefDiffCtx *ctx,
+                          const char *path,
+                          virDomainSmartcardDef *a,
+                          virDomainSmartcardDef *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+    size_t i;
+
+    DIFF_ENUM("/@mode", type, virDomainSmartcard);
+
+    if (a->type == b->type) {
+        switch (a->type) {
+        case VIR_DOMAIN_SMARTCARD_TYPE_HOST_CERTIFICATES:
+            for (i = 0; i < VIR_DOMAIN_SMARTCARD_NUM_CERTIFICATES; i++) {
+                g_autofree char *certPath = virDomainDefDiffPath(path, "/certificate[%zu]",
+                                                                 i + 1);
+
+                virDomainDefDiffString(ctx, certPath, "",
+                                       a->data.cert.file[i], b->data.cert.file[i]);
+            }
+            DIFF_STRING("/database", data.cert.database);
+            break;
+
+        case VIR_DOMAIN_SMARTCARD_TYPE_PASSTHROUGH:
+            virDomainDefDiffChrSource(ctx, path, sourcePath,
+                                      a->data.passthru, b->data.passthru);
+            break;
+
+        case VIR_DOMAIN_SMARTCARD_TYPE_HOST:
+        case VIR_DOMAIN_SMARTCARD_TYPE_LAST:
+            break;
+        }
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static virDomainDefDiffEnumToString
+virDomainDefDiffChrTargetTypeToString(virDomainChrDeviceType type)
+{
+    switch (type) {
+    case VIR_DOMAIN_CHR_DEVICE_TYPE_SERIAL:
+        return virDomainChrSerialTargetTypeToString;
+    case VIR_DOMAIN_CHR_DEVICE_TYPE_CONSOLE:
+        return virDomainChrConsoleTargetTypeToString;
+    case VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL:
+        return virDomainChrChannelTargetTypeToString;
+    case VIR_DOMAIN_CHR_DEVICE_TYPE_PARALLEL:
+    case VIR_DOMAIN_CHR_DEVICE_TYPE_LAST:
+        break;
+    }
+
+    return virDomainDefDiffNoName;
+}
+
+
+static void
+virDomainDefDiffChr(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    virDomainChrDef *a,
+                    virDomainChrDef *b)
+{
+    g_autofree char *sourcePath = g_strconcat(path, "/source", NULL);
+
+    if (a->deviceType != b->deviceType) {
+        DIFF_ENUM("", deviceType, virDomainChrDevice);
+        return;
+    }
+
+    virDomainDefDiffEnum(ctx, path, "/target/@type", a->targetType, b->targetType,
+                         virDomainDefDiffChrTargetTypeToString(a->deviceType));
+    DIFF_ENUM("/target/model/@name", targetModel, virDomainChrSerialTargetModel);
+
+    if (a->targetType == b->targetType) {
+        if (a->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL &&
+            a->targetType == VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_GUESTFWD) {
+            virDomainDefDiffSocketAddr(ctx, path, "/target/@address",
+                                       a->target.addr, b->target.addr);
+            virDomainDefDiffSigned(ctx, path, "/target/@port",
+                                   a->target.addr ? virSocketAddrGetPort(a->target.addr) : 0,
+                                   b->target.addr ? virSocketAddrGetPort(b->target.addr) : 0);
+        } else if (a->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL) {
+            DIFF_STRING("/target/@name", target.name);
+        } else {
+            DIFF_SIGNED("/target/@port", target.port);
+        }
+    }
+
+    /* the connection state is reported by the guest agent */
+    if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE))
+        DIFF_ENUM("/target/@state", state, virDomainChrDeviceState);
+
+    virDomainDefDiffChrSource(ctx, path, sourcePath, a->source, b->source);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffMemballoon(virDomainDefDiffCtx *ctx,
+                           const char *path,
+                           virDomainMemballoonDef *a,
+                           virDomainMemballoonDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainMemballoonModel);
+    DIFF_TRISTATE_SWITCH("/@autodeflate", autodeflate);
+    DIFF_TRISTATE_SWITCH("/@freePageReporting", free_page_reporting);
+    DIFF_SIGNED("/stats/@period", period);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffRNG(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    virDomainRNGDef *a,
+                    virDomainRNGDef *b)
+{
+    g_autofree char *backendPath = g_strconcat(path, "/backend", NULL);
+    g_autofree char *sourcePath = g_strconcat(path, "/backend/source", NULL);
+
+    DIFF_ENUM("/@model", model, virDomainRNGModel);
+    DIFF_ENUM("/backend/@model", backend, virDomainRNGBackend);
+    DIFF_UNSIGNED("/rate/@bytes", rate);
+    DIFF_UNSIGNED("/rate/@period", period);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    if (a->backend == b->backend) {
+        switch (a->backend) {
+        case VIR_DOMAIN_RNG_BACKEND_RANDOM:
+            DIFF_STRING("/backend", source.file);
+            break;
+
+        case VIR_DOMAIN_RNG_BACKEND_EGD:
+            virDomainDefDiffChrSource(ctx, backendPath, sourcePath,
+                                      a->source.chardev, b->source.chardev);
+            break;
+
+        case VIR_DOMAIN_RNG_BACKEND_BUILTIN:
+        case VIR_DOMAIN_RNG_BACKEND_LAST:
+            break;
+        }
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffShmem(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainShmemDef *a,
+                      virDomainShmemDef *b)
+{
+    DIFF_STRING("/@name", name);
+    DIFF_UNSIGNED("/size", size);
+    DIFF_ENUM("/model/@type", model, virDomainShmemModel);
+    DIFF_ENUM("/@role", role, virDomainShmemRole);
+
+    if (a->server.enabled != b->server.enabled) {
+        virDomainDefDiffElement(ctx, path, "/server",
+                                a->server.enabled, b->server.enabled);
+    } else if (a->server.enabled) {
+        virDomainDefDiffString(ctx, path, "/server/@path",
+                               a->server.chr ? a->server.chr->data.nix.path : NULL,
+                               b->server.chr ? b->server.chr->data.nix.path : NULL);
+    }
+
+    if (a->msi.enabled != b->msi.enabled) {
+        virDomainDefDiffElement(ctx, path, "/msi",
+                                a->msi.enabled, b->msi.enabled);
+    } else if (a->msi.enabled) {
+        DIFF_UNSIGNED("/msi/@vectors", msi.vectors);
+        DIFF_TRISTATE_SWITCH("/msi/@ioeventfd", msi.ioeventfd);
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffTPM(virDomainDefDiffCtx *ctx,
+                    const char *path,
+                    virDomainTPMDef *a,
+                    virDomainTPMDef *b)
+{
+    g_autofree char *backendPath = g_strconcat(path, "/backend", NULL);
+    g_autofree char *sourcePath = g_strconcat(path, "/backend/source", NULL);
+
+    DIFF_ENUM("/@model", model, virDomainTPMModel);
+    DIFF_ENUM("/backend/@type", type, virDomainTPMBackend);
+
+    if (a->type == b->type) {
+        switch (a->type) {
+        case VIR_DOMAIN_TPM_TYPE_PASSTHROUGH:
+            DIFF_STRING("/backend/device/@path",
+                        data.passthrough.source->data.file.path);
+            break;
+
+        case VIR_DOMAIN_TPM_TYPE_EMULATOR:
+            /* the socket, state and log of the emulator are set up by the
+             * driver when the domain is started */
+            DIFF_ENUM("/backend/@version", data.emulator.version, virDomainTPMVersion);
+            DIFF_BOOL("/backend/@persistent_state", data.emulator.persistent_state);
+            if (a->data.emulator.hassecretuuid != b->data.emulator.hassecretuuid) {
+                virDomainDefDiffElement(ctx, path, "/backend/encryption",
+                                        a->data.emulator.hassecretuuid,
+                                        b->data.emulator.hassecretuuid);
+            } else if (a->data.emulator.hassecretuuid) {
+                DIFF_UUID("/backend/encryption/@secret", data.emulator.secretuuid);
+            }
+            DIFF_BITMAP("/backend/active_pcr_banks", data.emulator.activePcrBanks);
+            break;
+
+        case VIR_DOMAIN_TPM_TYPE_EXTERNAL:
+            virDomainDefDiffChrSource(ctx, backendPath, sourcePath,
+                                      a->data.external.source,
+                                      b->data.external.source);
+            break;
+
+        case VIR_DOMAIN_TPM_TYPE_LAST:
+            break;
+        }
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffPanic(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainPanicDef *a,
+                      virDomainPanicDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainPanicModel);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffMemory(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       virDomainMemoryDef *a,
+                       virDomainMemoryDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainMemoryModel);
+    DIFF_ENUM("/@access", access, virDomainMemoryAccess);
+    DIFF_TRISTATE_BOOL("/@discard", discard);
+    DIFF_UNSIGNED("/target/size", size);
+    DIFF_SIGNED("/target/node", targetNode);
+
+    if (a->model != b->model) {
+        virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+        return;
+    }
+
+    switch (a->model) {
+    case VIR_DOMAIN_MEMORY_MODEL_DIMM:
+        DIFF_UNSIGNED("/source/pagesize", source.dimm.pagesize);
+        DIFF_BITMAP("/source/nodemask", source.dimm.nodes);
+        break;
+
+    case VIR_DOMAIN_MEMORY_MODEL_NVDIMM:
+        DIFF_STRING("/source/path", source.nvdimm.path);
+        DIFF_BOOL("/source/pmem", source.nvdimm.pmem);
+        DIFF_UNSIGNED("/source/alignsize", source.nvdimm.alignsize);
+        DIFF_UNSIGNED("/target/label/size", target.nvdimm.labelsize);
+        DIFF_BOOL("/target/readonly", target.nvdimm.readonly);
+        if (DIFF_BOTH("/uuid", target.nvdimm.uuid))
+            DIFF_UUID("/uuid", target.nvdimm.uuid);
+        break;
+
+    case VIR_DOMAIN_MEMORY_MODEL_VIRTIO_PMEM:
+        DIFF_STRING("/source/path", source.virtio_pmem.path);
+        DIFF_HEX("/target/address/@base", target.virtio_pmem.address);
+        break;
+
+    case VIR_DOMAIN_MEMORY_MODEL_VIRTIO_MEM:
+        DIFF_UNSIGNED("/source/pagesize", source.virtio_mem.pagesize);
+        DIFF_BITMAP("/source/nodemask", source.virtio_mem.nodes);
+        DIFF_UNSIGNED("/target/block", target.virtio_mem.blocksize);
+        DIFF_UNSIGNED("/target/requested", target.virtio_mem.requestedsize);
+        /* the size actually plugged in is reported by the running guest */
+        if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE))
+            DIFF_UNSIGNED("/target/current", target.virtio_mem.currentsize);
+        DIFF_HEX("/target/address/@base", target.virtio_mem.address);
+        DIFF_TRISTATE_BOOL("/target/@dynamicMemslots", target.virtio_mem.dynamicMemslots);
+        break;
+
+    case VIR_DOMAIN_MEMORY_MODEL_SGX_EPC:
+        DIFF_BITMAP("/source/nodemask", source.sgx_epc.nodes);
+        break;
+
+    case VIR_DOMAIN_MEMORY_MODEL_NONE:
+    case VIR_DOMAIN_MEMORY_MODEL_LAST:
+        break;
+    }
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffIOMMU(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainIOMMUDef *a,
+                      virDomainIOMMUDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainIOMMUModel);
+    DIFF_TRISTATE_SWITCH("/driver/@intremap", intremap);
+    DIFF_TRISTATE_SWITCH("/driver/@caching_mode", caching_mode);
+    DIFF_TRISTATE_SWITCH("/driver/@eim", eim);
+    DIFF_TRISTATE_SWITCH("/driver/@iotlb", iotlb);
+    DIFF_UNSIGNED("/driver/@aw_bits", aw_bits);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffVsock(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainVsockDef *a,
+                      virDomainVsockDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainVsockModel);
+    DIFF_TRISTATE_BOOL("/cid/@auto", auto_cid);
+    DIFF_UNSIGNED("/cid/@address", guest_cid);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+static void
+virDomainDefDiffCrypto(virDomainDefDiffCtx *ctx,
+                       const char *path,
+                       virDomainCryptoDef *a,
+                       virDomainCryptoDef *b)
+{
+    DIFF_ENUM("/@model", model, virDomainCryptoModel);
+    DIFF_ENUM("/@type", type, virDomainCryptoType);
+    DIFF_ENUM("/backend/@model", backend, virDomainCryptoBackend);
+    DIFF_UNSIGNED("/backend/@queues", queues);
+    virDomainDefDiffVirtioOptions(ctx, path, a->virtio, b->virtio);
+
+    virDomainDefDiffDeviceInfo(ctx, path, &a->info, &b->info);
+}
+
+
+/**
+ * virDomainDefDiffDeviceDef:
+ * @ctx: diff context
+ * @path: location of the device element
+ * @oldDev: original device
+ * @newDev: updated device of the same type
+ *
+ * Compares two devices field by field, the same way the ABI stability
+ * checks do.
+ */
+static void
+virDomainDefDiffDeviceDef(virDomainDefDiffCtx *ctx,
+                          const char *path,
+                          virDomainDeviceDef *oldDev,
+                          virDomainDeviceDef *newDev)
+{
+    ctx->devtype = oldDev->type;
+
+    switch (oldDev->type) {
+    case VIR_DOMAIN_DEVICE_DISK:
+        virDomainDefDiffDisk(ctx, path, oldDev->data.disk, newDev->data.disk);
+        break;
+    case VIR_DOMAIN_DEVICE_CONTROLLER:
+        virDomainDefDiffController(ctx, path, oldDev->data.controller,
+                                   newDev->data.controller);
+        break;
+    case VIR_DOMAIN_DEVICE_LEASE:
+        virDomainDefDiffLease(ctx, path, oldDev->data.lease, newDev->data.lease);
+        break;
+    case VIR_DOMAIN_DEVICE_FS:
+        virDomainDefDiffFS(ctx, path, oldDev->data.fs, newDev->data.fs);
+        break;
+    case VIR_DOMAIN_DEVICE_NET:
+        virDomainDefDiffNet(ctx, path, oldDev->data.net, newDev->data.net);
+        break;
+    case VIR_DOMAIN_DEVICE_INPUT:
+        virDomainDefDiffInput(ctx, path, oldDev->data.input, newDev->data.input);
+        break;
+    case VIR_DOMAIN_DEVICE_SOUND:
+        virDomainDefDiffSound(ctx, path, oldDev->data.sound, newDev->data.sound);
+        break;
+    case VIR_DOMAIN_DEVICE_VIDEO:
+        virDomainDefDiffVideo(ctx, path, oldDev->data.video, newDev->data.video);
+        break;
+    case VIR_DOMAIN_DEVICE_HOSTDEV:
+        virDomainDefDiffHostdev(ctx, path, oldDev->data.hostdev,
+                                newDev->data.hostdev);
+        break;
+    case VIR_DOMAIN_DEVICE_WATCHDOG:
+        virDomainDefDiffWatchdog(ctx, path, oldDev->data.watchdog,
+                                 newDev->data.watchdog);
+        break;
+    case VIR_DOMAIN_DEVICE_GRAPHICS:
+        virDomainDefDiffGraphics(ctx, path, oldDev->data.graphics,
+                                 newDev->data.graphics);
+        break;
+    case VIR_DOMAIN_DEVICE_HUB:
+        virDomainDefDiffHub(ctx, path, oldDev->data.hub, newDev->data.hub);
+        break;
+    case VIR_DOMAIN_DEVICE_REDIRDEV:
+        virDomainDefDiffRedirdev(ctx, path, oldDev->data.redirdev,
+                                 newDev->data.redirdev);
+        break;
+    case VIR_DOMAIN_DEVICE_SMARTCARD:
+        virDomainDefDiffSmartcard(ctx, path, oldDev->data.smartcard,
+                                  newDev->data.smartcard);
+        break;
+    case VIR_DOMAIN_DEVICE_CHR:
+        virDomainDefDiffChr(ctx, path, oldDev->data.chr, newDev->data.chr);
+        break;
+    case VIR_DOMAIN_DEVICE_MEMBALLOON:
+        virDomainDefDiffMemballoon(ctx, path, oldDev->data.memballoon,
+                                   newDev->data.memballoon);
+        break;
+    case VIR_DOMAIN_DEVICE_NVRAM:
+        virDomainDefDiffDeviceInfo(ctx, path, &oldDev->data.nvram->info,
+                                   &newDev->data.nvram->info);
+        break;
+    case VIR_DOMAIN_DEVICE_RNG:
+        virDomainDefDiffRNG(ctx, path, oldDev->data.rng, newDev->data.rng);
+        break;
+    case VIR_DOMAIN_DEVICE_SHMEM:
+        virDomainDefDiffShmem(ctx, path, oldDev->data.shmem, newDev->data.shmem);
+        break;
+    case VIR_DOMAIN_DEVICE_TPM:
+        virDomainDefDiffTPM(ctx, path, oldDev->data.tpm, newDev->data.tpm);
+        break;
+    case VIR_DOMAIN_DEVICE_PANIC:
+        virDomainDefDiffPanic(ctx, path, oldDev->data.panic, newDev->data.panic);
+        break;
+    case VIR_DOMAIN_DEVICE_MEMORY:
+        virDomainDefDiffMemory(ctx, path, oldDev->data.memory, newDev->data.memory);
+        break;
+    case VIR_DOMAIN_DEVICE_IOMMU:
+        virDomainDefDiffIOMMU(ctx, path, oldDev->data.iommu, newDev->data.iommu);
+        break;
+    case VIR_DOMAIN_DEVICE_VSOCK:
+        virDomainDefDiffVsock(ctx, path, oldDev->data.vsock, newDev->data.vsock);
+        break;
+    case VIR_DOMAIN_DEVICE_AUDIO:
+        virDomainDefDiffAudio(ctx, path, oldDev->data.audio, newDev->data.audio);
+        break;
+    case VIR_DOMAIN_DEVICE_CRYPTO:
+        virDomainDefDiffCrypto(ctx, path, oldDev->data.crypto, newDev->data.crypto);
+        break;
+    case VIR_DOMAIN_DEVICE_NONE:
+    case VIR_DOMAIN_DEVICE_LAST:
+        break;
+    }
+
+    ctx->devtype = VIR_DOMAIN_DEVICE_NONE;
+}
+
+
+/* Values formatted only if they were set, e.g. <bootmenu timeout=''/> */
+static void
+virDomainDefDiffOptionalUnsigned(virDomainDefDiffCtx *ctx,
+                                 const char *path,
+                                 const char *suffix,
+                                 bool oldSet,
+                                 unsigned long long oldValue,
+                                 bool newSet,
+                                 unsigned long long newValue)
+{
+    if (oldSet == newSet && (!oldSet || oldValue == newValue))
+        return;
+
+    virDomainDefDiffValue(ctx, path, suffix,
+                          oldSet ? g_strdup_printf("%llu", oldValue) : NULL,
+                          newSet ? g_strdup_printf("%llu", newValue) : NULL);
+}
+
+
+/**
+ * virDomainDefDiffTable:
+ * @ctx: diff context
+ * @path: location of the compared element
+ * @oldTable: values of the original definition
+ * @newTable: values of the updated definition
+ * @element: whether the tables list elements rather than values
+ *
+ * Compares data without a flat structure which was collected into tables
+ * keyed by the location of the values within @path. The keys are visited
+ * in sorted order to keep the list of changes stable.
+ */
+static void
+virDomainDefDiffTable(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      GHashTable *oldTable,
+                      GHashTable *newTable,
+                      bool element)
+{
+    g_autofree virHashKeyValuePair *oldItems = virHashGetItems(oldTable, NULL, true);
+    g_autofree virHashKeyValuePair *newItems = virHashGetItems(newTable, NULL, true);
+    size_t i;
+
+    for (i = 0; oldItems[i].key; i++) {
+        const char *key = oldItems[i].key;
+
+        if (element) {
+            virDomainDefDiffElement(ctx, path, key, true,
+                                    !virHashHasEntry(newTable, key));
+            continue;
+        }
+
+        virDomainDefDiffString(ctx, path, key, oldItems[i].value,
+                               virHashLookup(newTable, key));
+    }
+
+    for (i = 0; newItems[i].key; i++) {
+        const char *key = newItems[i].key;
+
+        if (virHashHasEntry(oldTable, key))
+            continue;
+
+        if (element)
+            virDomainDefDiffElement(ctx, path, key, false, true);
+        else
+            virDomainDefDiffString(ctx, path, key, NULL, newItems[i].value);
+    }
+}
+
+
+static void
+virDomainDefDiffThreadSched(virDomainDefDiffCtx *ctx,
+                            const char *path,
+                            virDomainThreadSchedParam *a,
+                            virDomainThreadSchedParam *b)
+{
+    DIFF_ENUM("/@scheduler", policy, virProcessSchedPolicy);
+    DIFF_SIGNED("/@priority", priority);
+}
+
+
+static void
+virDomainDefDiffGeneral(virDomainDefDiffCtx *ctx,
+                        virDomainDef *a,
+                        virDomainDef *b)
+{
+    const char *path = "/domain";
+
+    DIFF_ENUM("/@type", virtType, virDomainVirt);
+    DIFF_STRING("/name", name);
+    DIFF_UUID("/uuid", uuid);
+
+    /* generated IDs change with every start of the domain */
+    if (a->genidRequested != b->genidRequested) {
+        virDomainDefDiffElement(ctx, path, "/genid",
+                                a->genidRequested, b->genidRequested);
+    } else if (a->genidRequested &&
+               !((ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE) &&
+                 (a->genidGenerated || b->genidGenerated))) {
+        DIFF_UUID("/genid", genid);
+    }
+
+    DIFF_STRING("/title", title);
+    DIFF_STRING("/description", description);
+}
+
+
+static void
+virDomainDefDiffHugepage(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         virDomainHugePage *a,
+                         virDomainHugePage *b)
+{
+    DIFF_UNSIGNED("/@size", size);
+    DIFF_BITMAP("/@nodeset", nodemask);
+}
+
+
+static void
+virDomainDefDiffMemtune(virDomainDefDiffCtx *ctx,
+                        virDomainDef *a,
+                        virDomainDef *b)
+{
+    const char *path = "/domain";
+    size_t i;
+
+    DIFF_UNSIGNED("/maxMemory", mem.max_memory);
+    DIFF_UNSIGNED("/maxMemory/@slots", mem.memory_slots);
+    virDomainDefDiffUnsigned(ctx, path, "/memory",
+                             virDomainDefGetMemoryTotal(a),
+                             virDomainDefGetMemoryTotal(b));
+    DIFF_TRISTATE_SWITCH("/memory/@dumpCore", mem.dump_core);
+    DIFF_UNSIGNED("/currentMemory", mem.cur_balloon);
+
+    for (i = 0; i < MAX(a->mem.nhugepages, b->mem.nhugepages); i++) {
+        g_autofree char *pagePath = virDomainDefDiffPath(path,
+                                                         "/memoryBacking/hugepages/page[%zu]",
+                                                         i + 1);
+
+        if (i >= a->mem.nhugepages || i >= b->mem.nhugepages) {
+            virDomainDefDiffElement(ctx, pagePath, "",
+                                    i < a->mem.nhugepages,
+                                    i < b->mem.nhugepages);
+            continue;
+        }
+
+        virDomainDefDiffHugepage(ctx, pagePath, &a->mem.hugepages[i],
+                                 &b->mem.hugepages[i]);
+    }
+
+    DIFF_BOOL("/memoryBacking/nosharepages", mem.nosharepages);
+    DIFF_BOOL("/memoryBacking/locked", mem.locked);
+    DIFF_ENUM("/memoryBacking/source/@type", mem.source, virDomainMemorySource);
+    DIFF_ENUM("/memoryBacking/access/@mode", mem.access, virDomainMemoryAccess);
+    DIFF_ENUM("/memoryBacking/allocation/@mode", mem.allocation,
+              virDomainMemoryAllocation);
+    DIFF_UNSIGNED("/memoryBacking/allocation/@threads", mem.allocation_threads);
+    DIFF_TRISTATE_BOOL("/memoryBacking/discard", mem.discard);
+
+    DIFF_UNSIGNED("/memtune/hard_limit", mem.hard_limit);
+    DIFF_UNSIGNED("/memtune/soft_limit", mem.soft_limit);
+    DIFF_UNSIGNED("/memtune/min_guarantee", mem.min_guarantee);
+    DIFF_UNSIGNED("/memtune/swap_hard_limit", mem.swap_hard_limit);
+}
+
+
+static virBlkioDevice *
+virDomainDefDiffFindBlkioDevice(virDomainBlkiotune *blkio,
+                                const char *devpath)
+{
+    size_t i;
+
+    for (i = 0; i < blkio->ndevices; i++) {
+        if (STREQ(blkio->devices[i].path, devpath))
+            return &blkio->devices[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffBlkioDevice(virDomainDefDiffCtx *ctx,
+                            const char *path,
+                            virBlkioDevice *a,
+                            virBlkioDevice *b)
+{
+    DIFF_UNSIGNED("/weight", weight);
+    DIFF_UNSIGNED("/read_iops_sec", riops);
+    DIFF_UNSIGNED("/write_iops_sec", wiops);
+    DIFF_UNSIGNED("/read_bytes_sec", rbps);
+    DIFF_UNSIGNED("/write_bytes_sec", wbps);
+}
+
+
+static void
+virDomainDefDiffBlkiotune(virDomainDefDiffCtx *ctx,
+                          virDomainBlkiotune *a,
+                          virDomainBlkiotune *b)
+{
+    const char *path = "/domain/blkiotune";
+    size_t i;
+
+    DIFF_UNSIGNED("/weight", weight);
+
+    for (i = 0; i < a->ndevices; i++) {
+        virBlkioDevice *oldDevice = &a->devices[i];
+        virBlkioDevice *newDevice = virDomainDefDiffFindBlkioDevice(b, oldDevice->path);
+        g_autofree char *devPath = virDomainDefDiffPath(path, "/device[path='%s']",
+                                                        oldDevice->path);
+
+        if (!newDevice) {
+            virDomainDefDiffElement(ctx, devPath, "", true, false);
+            continue;
+        }
+
+        virDomainDefDiffBlkioDevice(ctx, devPath, oldDevice, newDevice);
+    }
+
+    for (i = 0; i < b->ndevices; i++) {
+        g_autofree char *devPath = NULL;
+
+        if (virDomainDefDiffFindBlkioDevice(a, b->devices[i].path))
+            continue;
+
+        devPath = virDomainDefDiffPath(path, "/device[path='%s']",
+                                       b->devices[i].path);
+        virDomainDefDiffElement(ctx, devPath, "", false, true);
+    }
+}
+
+
+static void
+virDomainDefDiffVcpu(virDomainDefDiffCtx *ctx,
+                     size_t id,
+                     virDomainVcpuDef *a,
+                     virDomainVcpuDef *b)
+{
+    g_autofree char *path = g_strdup_printf("/domain/vcpus/vcpu[@id='%zu']", id);
+    g_autofree char *pinPath = g_strdup_printf("/domain/cputune/vcpupin[@vcpu='%zu']", id);
+    g_autofree char *schedPath = g_strdup_printf("/domain/cputune/vcpusched[@vcpus='%zu']", id);
+
+    DIFF_BOOL("/@enabled", online);
+    DIFF_TRISTATE_BOOL("/@hotpluggable", hotpluggable);
+    DIFF_UNSIGNED("/@order", order);
+
+    virDomainDefDiffBitmap(ctx, pinPath, "/@cpuset", a->cpumask, b->cpumask);
+    virDomainDefDiffThreadSched(ctx, schedPath, &a->sched, &b->sched);
+}
+
+
+static void
+virDomainDefDiffVcpus(virDomainDefDiffCtx *ctx,
+                      virDomainDef *a,
+                      virDomainDef *b)
+{
+    const char *path = "/domain";
+    size_t i;
+
+    virDomainDefDiffUnsigned(ctx, path, "/vcpu",
+                             virDomainDefGetVcpusMax(a),
+                             virDomainDefGetVcpusMax(b));
+    virDomainDefDiffUnsigned(ctx, path, "/vcpu/@current",
+                             virDomainDefGetVcpus(a),
+                             virDomainDefGetVcpus(b));
+    DIFF_ENUM("/vcpu/@placement", placement_mode, virDomainCpuPlacementMode);
+    DIFF_BITMAP("/vcpu/@cpuset", cpumask);
+
+    /* vCPUs beyond the common maximum are covered by the change of <vcpu> */
+    for (i = 0; i < MIN(a->maxvcpus, b->maxvcpus); i++)
+        virDomainDefDiffVcpu(ctx, i, a->vcpus[i], b->vcpus[i]);
+}
+
+
+static void
+virDomainDefDiffIOThread(virDomainDefDiffCtx *ctx,
+                         const char *path,
+                         virDomainIOThreadIDDef *a,
+                         virDomainIOThreadIDDef *b)
+{
+    g_autofree char *pinPath = g_strdup_printf("/domain/cputune/iothreadpin[@iothread='%u']",
+                                               a->iothread_id);
+    g_autofree char *schedPath = g_strdup_printf("/domain/cputune/iothreadsched[@iothreads='%u']",
+                                                 a->iothread_id);
+
+    DIFF_SIGNED("/@thread_pool_min", thread_pool_min);
+    DIFF_SIGNED("/@thread_pool_max", thread_pool_max);
+    virDomainDefDiffOptionalUnsigned(ctx, path, "/poll/@max",
+                                     a->set_poll_max_ns, a->poll_max_ns,
+                                     b->set_poll_max_ns, b->poll_max_ns);
+    virDomainDefDiffOptionalUnsigned(ctx, path, "/poll/@grow",
+                                     a->set_poll_grow, a->poll_grow,
+                                     b->set_poll_grow, b->poll_grow);
+    virDomainDefDiffOptionalUnsigned(ctx, path, "/poll/@shrink",
+                                     a->set_poll_shrink, a->poll_shrink,
+                                     b->set_poll_shrink, b->poll_shrink);
+
+    virDomainDefDiffBitmap(ctx, pinPath, "/@cpuset", a->cpumask, b->cpumask);
+    virDomainDefDiffThreadSched(ctx, schedPath, &a->sched, &b->sched);
+}
+
+
+static void
+virDomainDefDiffIOThreads(virDomainDefDiffCtx *ctx,
+                          virDomainDef *a,
+                          virDomainDef *b)
+{
+    const char *path = "/domain";
+    size_t i;
+
+    DIFF_UNSIGNED("/iothreads", niothreadids);
+
+    for (i = 0; i < a->niothreadids; i++) {
+        virDomainIOThreadIDDef *oldIOThread = a->iothreadids[i];
+        virDomainIOThreadIDDef *newIOThread = virDomainIOThreadIDFind(b, oldIOThread->iothread_id);
+        g_autofree char *iothreadPath = virDomainDefDiffPath(path,
+                                                             "/iothreadids/iothread[@id='%u']",
+                                                             oldIOThread->iothread_id);
+
+        if (!newIOThread) {
+            virDomainDefDiffElement(ctx, iothreadPath, "", true, false);
+            continue;
+        }
+
+        virDomainDefDiffIOThread(ctx, iothreadPath, oldIOThread, newIOThread);
+    }
+
+    for (i = 0; i < b->niothreadids; i++) {
+        g_autofree char *iothreadPath = NULL;
+
+        if (virDomainIOThreadIDFind(a, b->iothreadids[i]->iothread_id))
+            continue;
+
+        iothreadPath = virDomainDefDiffPath(path, "/iothreadids/iothread[@id='%u']",
+                                            b->iothreadids[i]->iothread_id);
+        virDomainDefDiffElement(ctx, iothreadPath, "", false, true);
+    }
+
+    if (DIFF_BOTH("/defaultiothread", defaultIOThread)) {
+        DIFF_SIGNED("/defaultiothread/@thread_pool_min",
+                    defaultIOThread->thread_pool_min);
+        DIFF_SIGNED("/defaultiothread/@thread_pool_max",
+                    defaultIOThread->thread_pool_max);
+    }
+}
+
+
+static void
+virDomainDefDiffCputune(virDomainDefDiffCtx *ctx,
+                        virDomainCputune *a,
+                        virDomainCputune *b)
+{
+    const char *path = "/domain/cputune";
+
+    virDomainDefDiffOptionalUnsigned(ctx, path, "/shares",
+                                     a->sharesSpecified, a->shares,
+                                     b->sharesSpecified, b->shares);
+    DIFF_UNSIGNED("/period", period);
+    DIFF_SIGNED("/quota", quota);
+    DIFF_UNSIGNED("/global_period", global_period);
+    DIFF_SIGNED("/global_quota", global_quota);
+    DIFF_UNSIGNED("/emulator_period", emulator_period);
+    DIFF_SIGNED("/emulator_quota", emulator_quota);
+    DIFF_UNSIGNED("/iothread_period", iothread_period);
+    DIFF_SIGNED("/iothread_quota", iothread_quota);
+    DIFF_BITMAP("/emulatorpin/@cpuset", emulatorpin);
+
+    if (DIFF_BOTH("/emulatorsched", emulatorsched)) {
+        g_autofree char *schedPath = g_strconcat(path, "/emulatorsched", NULL);
+
+        virDomainDefDiffThreadSched(ctx, schedPath, a->emulatorsched,
+                                    b->emulatorsched);
+    }
+}
+
+
+typedef struct _virDomainDefDiffResctrlData virDomainDefDiffResctrlData;
+struct _virDomainDefDiffResctrlData {
+    GHashTable *values;
+    const char *vcpus;
+};
+
+static int
+virDomainDefDiffResctrlCache(unsigned int level,
+                             virCacheType type,
+                             unsigned int cache,
+                             unsigned long long size,
+                             void *opaque)
+{
+    virDomainDefDiffResctrlData *data = opaque;
+
+    g_hash_table_insert(data->values,
+                        g_strdup_printf("/cachetune[@vcpus='%s']/cache[@id='%u'][@level='%u'][@type='%s']/@size",
+                                        data->vcpus, cache, level,
+                                        virCacheTypeToString(type)),
+                        g_strdup_printf("%llu", size));
+    return 0;
+}
+
+
+static int
+virDomainDefDiffResctrlMemory(unsigned int id,
+                              unsigned int bandwidth,
+                              void *opaque)
+{
+    virDomainDefDiffResctrlData *data = opaque;
+
+    g_hash_table_insert(data->values,
+                        g_strdup_printf("/memorytune[@vcpus='%s']/node[@id='%u']/@bandwidth",
+                                        data->vcpus, id),
+                        g_strdup_printf("%u", bandwidth));
+    return 0;
+}
+
+
+/* The allocations are kept in an opaque form, collect their values and
+ * monitors keyed by their location within <cputune>. */
+static int
+virDomainDefDiffGetResctrls(virDomainDef *def,
+                            GHashTable *values,
+                            GHashTable *monitors)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < def->nresctrls; i++) {
+        virDomainResctrlDef *resctrl = def->resctrls[i];
+        g_autofree char *vcpus = virBitmapFormat(resctrl->vcpus);
+        virDomainDefDiffResctrlData data = { .values = values, .vcpus = vcpus };
+
+        if (virResctrlAllocForeachCache(resctrl->alloc,
+                                        virDomainDefDiffResctrlCache,
+                                        &data) < 0 ||
+            virResctrlAllocForeachMemory(resctrl->alloc,
+                                         virDomainDefDiffResctrlMemory,
+                                         &data) < 0)
+            return -1;
+
+        for (j = 0; j < resctrl->nmonitors; j++) {
+            virDomainResctrlMonDef *monitor = resctrl->monitors[j];
+            g_autofree char *monitorVcpus = virBitmapFormat(monitor->vcpus);
+            const char *element = "cachetune";
+
+            if (monitor->tag == VIR_RESCTRL_MONITOR_TYPE_MEMBW)
+                element = "memorytune";
+
+            g_hash_table_insert(monitors,
+                                g_strdup_printf("/%s[@vcpus='%s']/monitor[@vcpus='%s']",
+                                                element, vcpus, monitorVcpus),
+                                NULL);
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+virDomainDefDiffResctrls(virDomainDefDiffCtx *ctx,
+                         virDomainDef *oldDef,
+                         virDomainDef *newDef)
+{
+    g_autoptr(GHashTable) oldValues = virHashNew(g_free);
+    g_autoptr(GHashTable) newValues = virHashNew(g_free);
+    g_autoptr(GHashTable) oldMonitors = virHashNew(NULL);
+    g_autoptr(GHashTable) newMonitors = virHashNew(NULL);
+
+    if (virDomainDefDiffGetResctrls(oldDef, oldValues, oldMonitors) < 0 ||
+        virDomainDefDiffGetResctrls(newDef, newValues, newMonitors) < 0)
+        return -1;
+
+    virDomainDefDiffTable(ctx, "/domain/cputune", oldValues, newValues, false);
+    virDomainDefDiffTable(ctx, "/domain/cputune", oldMonitors, newMonitors, true);
+
+    return 0;
+}
+
+
+static void
+virDomainDefDiffNumatune(virDomainDefDiffCtx *ctx,
+                         virDomainNuma *oldNuma,
+                         virDomainNuma *newNuma)
+{
+    const char *path = "/domain/numatune/memory";
+    virDomainNumatuneMemMode oldMode;
+    virDomainNumatuneMemMode newMode;
+    bool oldSet = virDomainNumatuneGetMode(oldNuma, -1, &oldMode) == 0;
+    bool newSet = virDomainNumatuneGetMode(newNuma, -1, &newMode) == 0;
+    size_t ncells = MAX(virDomainNumaGetNodeCount(oldNuma),
+                        virDomainNumaGetNodeCount(newNuma));
+    size_t i;
+
+    if (oldSet != newSet) {
+        virDomainDefDiffElement(ctx, path, "", oldSet, newSet);
+    } else if (oldSet) {
+        bool oldAuto = virDomainNumatuneHasPlacementAuto(oldNuma);
+        bool newAuto = virDomainNumatuneHasPlacementAuto(newNuma);
+
+        virDomainDefDiffEnum(ctx, path, "/@mode", oldMode, newMode,
+                             virDomainNumatuneMemModeTypeToString);
+
+        if (oldAuto != newAuto) {
+            virDomainDefDiffString(ctx, path, "/@placement",
+                                   oldAuto ? "auto" : "static",
+                                   newAuto ? "auto" : "static");
+        }
+
+        virDomainDefDiffBitmap(ctx, path, "/@nodeset",
+                               virDomainNumatuneGetNodeset(oldNuma, NULL, -1),
+                               virDomainNumatuneGetNodeset(newNuma, NULL, -1));
+    }
+
+    for (i = 0; i < ncells; i++) {
+        g_autofree char *nodePath = g_strdup_printf("/domain/numatune/memnode[@cellid='%zu']", i);
+
+        oldSet = virDomainNumatuneNodeSpecified(oldNuma, i);
+        newSet = virDomainNumatuneNodeSpecified(newNuma, i);
+
+        if (!oldSet || !newSet) {
+            virDomainDefDiffElement(ctx, nodePath, "", oldSet, newSet);
+            continue;
+        }
+
+        ignore_value(virDomainNumatuneGetMode(oldNuma, i, &oldMode));
+        ignore_value(virDomainNumatuneGetMode(newNuma, i, &newMode));
+
+        virDomainDefDiffEnum(ctx, nodePath, "/@mode", oldMode, newMode,
+                             virDomainNumatuneMemModeTypeToString);
+        virDomainDefDiffBitmap(ctx, nodePath, "/@nodeset",
+                               virDomainNumatuneGetNodeset(oldNuma, NULL, i),
+                               virDomainNumatuneGetNodeset(newNuma, NULL, i));
+    }
+}
+
+
+static void
+virDomainDefDiffNumaCache(virDomainDefDiffCtx *ctx,
+                          const char *cellPath,
+                          virDomainNuma *oldNuma,
+                          virDomainNuma *newNuma,
+                          size_t cell)
+{
+    size_t noldCaches = virDomainNumaGetNodeCacheCount(oldNuma, cell);
+    size_t nnewCaches = virDomainNumaGetNodeCacheCount(newNuma, cell);
+    size_t i;
+
+    for (i = 0; i < MAX(noldCaches, nnewCaches); i++) {
+        g_autofree char *path = virDomainDefDiffPath(cellPath, "/cache[%zu]", i + 1);
+        unsigned int oldLevel, oldSize, oldLine;
+        unsigned int newLevel, newSize, newLine;
+        virNumaCacheAssociativity oldAssociativity, newAssociativity;
+        virNumaCachePolicy oldPolicy, newPolicy;
+
+        if (i >= noldCaches || i >= nnewCaches) {
+            virDomainDefDiffElement(ctx, path, "", i < noldCaches, i < nnewCaches);
+            continue;
+        }
+
+        ignore_value(virDomainNumaGetNodeCache(oldNuma, cell, i, &oldLevel,
+                                               &oldSize, &oldLine,
+                                               &oldAssociativity, &oldPolicy));
+        ignore_value(virDomainNumaGetNodeCache(newNuma, cell, i, &newLevel,
+                                               &newSize, &newLine,
+                                               &newAssociativity, &newPolicy));
+
+        virDomainDefDiffUnsigned(ctx, path, "/@level", oldLevel, newLevel);
+        virDomainDefDiffEnum(ctx, path, "/@associativity",
+                             oldAssociativity, newAssociativity,
+                             virNumaCacheAssociativityTypeToString);
+        virDomainDefDiffEnum(ctx, path, "/@policy", oldPolicy, newPolicy,
+                             virNumaCachePolicyTypeToString);
+        virDomainDefDiffUnsigned(ctx, path, "/size/@value", oldSize, newSize);
+        virDomainDefDiffUnsigned(ctx, path, "/line/@value", oldLine, newLine);
+    }
+}
+
+
+static void
+virDomainDefDiffNumaInterconnects(virDomainDefDiffCtx *ctx,
+                                  virDomainNuma *oldNuma,
+                                  virDomainNuma *newNuma)
+{
+    size_t nold = virDomainNumaGetInterconnectsCount(oldNuma);
+    size_t nnew = virDomainNumaGetInterconnectsCount(newNuma);
+    size_t i;
+
+    for (i = 0; i < MAX(nold, nnew); i++) {
+        g_autofree char *path = g_strdup_printf("/domain/cpu/numa/interconnects/*[%zu]",
+                                                i + 1);
+        virNumaInterconnectType oldType, newType;
+        unsigned int oldInitiator, oldTarget, oldCache;
+        unsigned int newInitiator, newTarget, newCache;
+        virMemoryLatency oldAccess, newAccess;
+        unsigned long oldValue, newValue;
+
+        if (i >= nold || i >= nnew) {
+            virDomainDefDiffElement(ctx, path, "", i < nold, i < nnew);
+            continue;
+        }
+
+        ignore_value(virDomainNumaGetInterconnect(oldNuma, i, &oldType,
+                                                  &oldInitiator, &oldTarget,
+                                                  &oldCache, &oldAccess,
+                                                  &oldValue));
+        ignore_value(virDomainNumaGetInterconnect(newNuma, i, &newType,
+                                                  &newInitiator, &newTarget,
+                                                  &newCache, &newAccess,
+                                                  &newValue));
+
+        /* <latency> and <bandwidth> are different elements */
+        if (oldType != newType) {
+            virDomainDefDiffElement(ctx, path, "", true, true);
+            continue;
+        }
+
+        virDomainDefDiffUnsigned(ctx, path, "/@initiator", oldInitiator, newInitiator);
+        virDomainDefDiffUnsigned(ctx, path, "/@target", oldTarget, newTarget);
+        virDomainDefDiffUnsigned(ctx, path, "/@cache", oldCache, newCache);
+        virDomainDefDiffEnum(ctx, path, "/@type", oldAccess, newAccess,
+                             virMemoryLatencyTypeToString);
+        virDomainDefDiffUnsigned(ctx, path, "/@value", oldValue, newValue);
+    }
+}
+
+
+/**
+ * virDomainDefDiffNuma:
+ * @ctx: diff context
+ * @oldNuma: original guest NUMA topology
+ * @newNuma: updated guest NUMA topology
+ *
+ * Compares the guest NUMA cells formatted within <cpu>. The struct is
+ * opaque, the values are taken from its accessors.
+ */
+static void
+virDomainDefDiffNuma(virDomainDefDiffCtx *ctx,
+                     virDomainNuma *oldNuma,
+                     virDomainNuma *newNuma)
+{
+    size_t nold = virDomainNumaGetNodeCount(oldNuma);
+    size_t nnew = virDomainNumaGetNodeCount(newNuma);
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < MAX(nold, nnew); i++) {
+        g_autofree char *path = g_strdup_printf("/domain/cpu/numa/cell[@id='%zu']", i);
+
+        if (i >= nold || i >= nnew) {
+            virDomainDefDiffElement(ctx, path, "", i < nold, i < nnew);
+            continue;
+        }
+
+        virDomainDefDiffBitmap(ctx, path, "/@cpus",
+                               virDomainNumaGetNodeCpumask(oldNuma, i),
+                               virDomainNumaGetNodeCpumask(newNuma, i));
+        virDomainDefDiffUnsigned(ctx, path, "/@memory",
+                                 virDomainNumaGetNodeMemorySize(oldNuma, i),
+                                 virDomainNumaGetNodeMemorySize(newNuma, i));
+        virDomainDefDiffOptionalEnum(ctx, path, "/@memAccess",
+                                     virDomainNumaGetNodeMemoryAccessMode(oldNuma, i),
+                                     virDomainNumaGetNodeMemoryAccessMode(newNuma, i),
+                                     virDomainMemoryAccessTypeToString);
+        virDomainDefDiffOptionalEnum(ctx, path, "/@discard",
+                                     virDomainNumaGetNodeDiscard(oldNuma, i),
+                                     virDomainNumaGetNodeDiscard(newNuma, i),
+                                     virTristateBoolTypeToString);
+
+        /* distances to removed or added cells change along with them */
+        for (j = 0; j < MIN(nold, nnew); j++) {
+            g_autofree char *siblingPath = virDomainDefDiffPath(path,
+                                                                "/distances/sibling[@id='%zu']",
+                                                                j);
+
+            virDomainDefDiffUnsigned(ctx, siblingPath, "/@value",
+                                     virDomainNumaGetNodeDistance(oldNuma, i, j),
+                                     virDomainNumaGetNodeDistance(newNuma, i, j));
+        }
+
+        virDomainDefDiffNumaCache(ctx, path, oldNuma, newNuma, i);
+    }
+
+    virDomainDefDiffNumaInterconnects(ctx, oldNuma, newNuma);
+}
+
+
+static virCPUFeatureDef *
+virDomainDefDiffFindCPUFeature(virCPUDef *cpu,
+                               const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < cpu->nfeatures; i++) {
+        if (STREQ(cpu->features[i].name, name))
+            return &cpu->features[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffCPUFeatures(virDomainDefDiffCtx *ctx,
+                            const char *cpuPath,
+                            virCPUDef *oldCPU,
+                            virCPUDef *newCPU)
+{
+    size_t i;
+
+    for (i = 0; i < oldCPU->nfeatures; i++) {
+        virCPUFeatureDef *a = &oldCPU->features[i];
+        virCPUFeatureDef *b = virDomainDefDiffFindCPUFeature(newCPU, a->name);
+        g_autofree char *path = virDomainDefDiffPath(cpuPath, "/feature[@name='%s']",
+                                                     a->name);
+
+        if (!b) {
+            virDomainDefDiffElement(ctx, path, "", true, false);
+            continue;
+        }
+
+        DIFF_ENUM("/@policy", policy, virCPUFeaturePolicy);
+    }
+
+    for (i = 0; i < newCPU->nfeatures; i++) {
+        g_autofree char *path = NULL;
+
+        if (virDomainDefDiffFindCPUFeature(oldCPU, newCPU->features[i].name))
+            continue;
+
+        path = virDomainDefDiffPath(cpuPath, "/feature[@name='%s']",
+                                    newCPU->features[i].name);
+        virDomainDefDiffElement(ctx, path, "", false, true);
+    }
+}
+
+
+/* Only the data of guest CPU definitions is compared, the signature and
+ * other details of host CPUs never show up in domain XML. */
+static void
+virDomainDefDiffCPU(virDomainDefDiffCtx *ctx,
+                    virCPUDef *a,
+                    virCPUDef *b)
+{
+    const char *path = "/domain/cpu";
+
+    if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+        return;
+
+    DIFF_ENUM("/@mode", mode, virCPUMode);
+    DIFF_ENUM("/@match", match, virCPUMatch);
+    DIFF_ENUM("/@check", check, virCPUCheck);
+    DIFF_TRISTATE_SWITCH("/@migratable", migratable);
+    DIFF_STRING("/model", model);
+    DIFF_ENUM("/model/@fallback", fallback, virCPUFallback);
+    DIFF_STRING("/model/@vendor_id", vendor_id);
+    DIFF_STRING("/vendor", vendor);
+    DIFF_UNSIGNED("/topology/@sockets", sockets);
+    DIFF_UNSIGNED("/topology/@dies", dies);
+    DIFF_UNSIGNED("/topology/@clusters", clusters);
+    DIFF_UNSIGNED("/topology/@cores", cores);
+    DIFF_UNSIGNED("/topology/@threads", threads);
+
+    if (DIFF_BOTH("/cache", cache)) {
+        DIFF_SIGNED("/cache/@level", cache->level);
+        DIFF_ENUM("/cache/@mode", cache->mode, virCPUCacheMode);
+    }
+
+    if (DIFF_BOTH("/maxphysaddr", addr)) {
+        DIFF_ENUM("/maxphysaddr/@mode", addr->mode, virCPUMaxPhysAddrMode);
+        DIFF_SIGNED("/maxphysaddr/@bits", addr->bits);
+        DIFF_UNSIGNED("/maxphysaddr/@limit", addr->limit);
+    }
+
+    virDomainDefDiffCPUFeatures(ctx, path, a, b);
+}
+
+
+static void
+virDomainDefDiffResource(virDomainDefDiffCtx *ctx,
+                         virDomainResourceDef *a,
+                         virDomainResourceDef *b)
+{
+    const char *path = "/domain/resource";
+
+    virDomainDefDiffString(ctx, path, "/partition",
+                           a ? a->partition : NULL,
+                           b ? b->partition : NULL);
+    virDomainDefDiffString(ctx, path, "/fibrechannel/@appid",
+                           a ? a->appid : NULL,
+                           b ? b->appid : NULL);
+}
+
+
+static void
+virDomainDefDiffEvents(virDomainDefDiffCtx *ctx,
+                       virDomainDef *a,
+                       virDomainDef *b)
+{
+    const char *path = "/domain";
+    size_t i;
+
+    DIFF_ENUM("/on_poweroff", onPoweroff, virDomainLifecycleAction);
+    DIFF_ENUM("/on_reboot", onReboot, virDomainLifecycleAction);
+    DIFF_ENUM("/on_crash", onCrash, virDomainLifecycleAction);
+    DIFF_ENUM("/on_lockfailure", onLockFailure, virDomainLockFailure);
+
+    DIFF_TRISTATE_BOOL("/pm/suspend-to-mem/@enabled", pm.s3);
+    DIFF_TRISTATE_BOOL("/pm/suspend-to-disk/@enabled", pm.s4);
+
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        g_autofree char *eventPath = g_strdup_printf("/domain/perf/event[@name='%s']",
+                                                     virPerfEventTypeToString(i));
+
+        virDomainDefDiffOptionalEnum(ctx, eventPath, "/@enabled",
+                                     a->perf.events[i], b->perf.events[i],
+                                     virTristateBoolTypeToString);
+    }
+}
+
+
+static void
+virDomainDefDiffLoader(virDomainDefDiffCtx *ctx,
+                       virDomainLoaderDef *a,
+                       virDomainLoaderDef *b)
+{
+    const char *path = "/domain/os";
+
+    if (!virDomainDefDiffBoth(ctx, path, "/loader", a, b))
+        return;
+
+    DIFF_STRING("/loader", path);
+    DIFF_TRISTATE_BOOL("/loader/@readonly", readonly);
+    DIFF_ENUM("/loader/@type", type, virDomainLoader);
+    DIFF_TRISTATE_BOOL("/loader/@secure", secure);
+    DIFF_TRISTATE_BOOL("/loader/@stateless", stateless);
+    DIFF_ENUM("/loader/@format", format, virStorageFileFormat);
+    DIFF_STRING("/nvram/@template", nvramTemplate);
+
+    if (!DIFF_BOTH("/nvram", nvram))
+        return;
+
+    DIFF_ENUM("/nvram/@type", nvram->type, virStorage);
+    DIFF_ENUM("/nvram/@format", nvram->format, virStorageFileFormat);
+
+    if (a->nvram->type != b->nvram->type)
+        return;
+
+    /* plain files are formatted as the content of <nvram> */
+    if (!a->newStyleNVRAM && !b->newStyleNVRAM) {
+        DIFF_STRING("/nvram", nvram->path);
+    } else {
+        g_autofree char *sourcePath = g_strconcat(path, "/nvram/source", NULL);
+
+        virDomainDefDiffStorageSource(ctx, sourcePath, a->nvram, b->nvram);
+    }
+}
+
+
+static void
+virDomainDefDiffOSEnv(virDomainDefDiffCtx *ctx,
+                      virDomainOSDef *oldOS,
+                      virDomainOSDef *newOS)
+{
+    size_t nold = 0;
+    size_t nnew = 0;
+    size_t i;
+
+    while (oldOS->initargv && oldOS->initargv[nold])
+        nold++;
+    while (newOS->initargv && newOS->initargv[nnew])
+        nnew++;
+
+    for (i = 0; i < MAX(nold, nnew); i++) {
+        g_autofree char *suffix = g_strdup_printf("/initarg[%zu]", i + 1);
+
+        virDomainDefDiffString(ctx, "/domain/os", suffix,
+                               i < nold ? oldOS->initargv[i] : NULL,
+                               i < nnew ? newOS->initargv[i] : NULL);
+    }
+
+    for (nold = 0; oldOS->initenv && oldOS->initenv[nold]; nold++)
+        ;
+    for (nnew = 0; newOS->initenv && newOS->initenv[nnew]; nnew++)
+        ;
+
+    for (i = 0; i < MAX(nold, nnew); i++) {
+        virDomainOSEnv *a = i < nold ? oldOS->initenv[i] : NULL;
+        virDomainOSEnv *b = i < nnew ? newOS->initenv[i] : NULL;
+        g_autofree char *path = g_strdup_printf("/domain/os/initenv[%zu]", i + 1);
+
+        if (!virDomainDefDiffBoth(ctx, path, "", a, b))
+            continue;
+
+        DIFF_STRING("/@name", name);
+        DIFF_STRING("", value);
+    }
+}
+
+
+static void
+virDomainDefDiffOS(virDomainDefDiffCtx *ctx,
+                   virDomainOSDef *a,
+                   virDomainOSDef *b)
+{
+    const char *path = "/domain/os";
+    size_t i;
+
+    DIFF_ENUM("/type", type, virDomainOS);
+    virDomainDefDiffString(ctx, path, "/type/@arch",
+                           a->arch ? virArchToString(a->arch) : NULL,
+                           b->arch ? virArchToString(b->arch) : NULL);
+    DIFF_STRING("/type/@machine", machine);
+    DIFF_ENUM("/@firmware", firmware, virDomainOsDefFirmware);
+
+    for (i = 0; i < VIR_DOMAIN_OS_DEF_FIRMWARE_FEATURE_LAST; i++) {
+        g_autofree char *featurePath = g_strdup_printf("/domain/os/firmware/feature[@name='%s']",
+                                                       virDomainOsDefFirmwareFeatureTypeToString(i));
+
+        virDomainDefDiffOptionalEnum(ctx, featurePath, "/@enabled",
+                                     a->firmwareFeatures ? a->firmwareFeatures[i] : 0,
+                                     b->firmwareFeatures ? b->firmwareFeatures[i] : 0,
+                                     virTristateBoolTypeToString);
+    }
+
+    virDomainDefDiffLoader(ctx, a->loader, b->loader);
+
+    for (i = 0; i < MAX(a->nBootDevs, b->nBootDevs); i++) {
+        g_autofree char *bootPath = g_strdup_printf("/domain/os/boot[%zu]", i + 1);
+
+        if (i >= a->nBootDevs || i >= b->nBootDevs) {
+            virDomainDefDiffElement(ctx, bootPath, "",
+                                    i < a->nBootDevs, i < b->nBootDevs);
+            continue;
+        }
+
+        virDomainDefDiffEnum(ctx, bootPath, "/@dev",
+                             a->bootDevs[i], b->bootDevs[i],
+                             virDomainBootTypeToString);
+    }
+
+    DIFF_TRISTATE_BOOL("/bootmenu/@enable", bootmenu);
+    virDomainDefDiffOptionalUnsigned(ctx, path, "/bootmenu/@timeout",
+                                     a->bm_timeout_set, a->bm_timeout,
+                                     b->bm_timeout_set, b->bm_timeout);
+    DIFF_ENUM("/smbios/@mode", smbios_mode, virDomainSmbiosMode);
+    DIFF_TRISTATE_BOOL("/bios/@useserial", bios.useserial);
+
+    if (a->bios.rt_set != b->bios.rt_set ||
+        (a->bios.rt_set && a->bios.rt_delay != b->bios.rt_delay)) {
+        virDomainDefDiffValue(ctx, path, "/bios/@rebootTimeout",
+                              a->bios.rt_set ? g_strdup_printf("%d", a->bios.rt_delay) : NULL,
+                              b->bios.rt_set ? g_strdup_printf("%d", b->bios.rt_delay) : NULL);
+    }
+
+    DIFF_STRING("/init", init);
+    virDomainDefDiffOSEnv(ctx, a, b);
+    DIFF_STRING("/initdir", initdir);
+    DIFF_STRING("/inituser", inituser);
+    DIFF_STRING("/initgroup", initgroup);
+    DIFF_STRING("/kernel", kernel);
+    DIFF_STRING("/initrd", initrd);
+    DIFF_STRING("/cmdline", cmdline);
+    DIFF_STRING("/dtb", dtb);
+    DIFF_STRING("/root", root);
+    DIFF_STRING("/acpi/table", slic_table);
+
+    virDomainDefDiffString(ctx, "/domain", "/bootloader",
+                           a->bootloader, b->bootloader);
+    virDomainDefDiffString(ctx, "/domain", "/bootloader_args",
+                           a->bootloaderArgs, b->bootloaderArgs);
+}
+
+
+/**
+ * virDomainDefDiffFeature:
+ * @ctx: diff context
+ * @name: element name of the feature
+ * @attr: attribute holding the value of the feature
+ * @oldValue: original value, 0 if the feature isn't present
+ * @newValue: updated value, 0 if the feature isn't present
+ * @toString: names of the values
+ *
+ * Returns true if the feature is present in both definitions and its
+ * sub-elements are worth a comparison.
+ */
+static bool
+virDomainDefDiffFeature(virDomainDefDiffCtx *ctx,
+                        const char *name,
+                        const char *attr,
+                        int oldValue,
+                        int newValue,
+                        virDomainDefDiffEnumToString toString)
+{
+    g_autofree char *path = g_strdup_printf("/domain/features/%s", name);
+
+    if (!oldValue || !newValue) {
+        virDomainDefDiffElement(ctx, path, "", !!oldValue, !!newValue);
+        return oldValue && newValue;
+    }
+
+    virDomainDefDiffEnum(ctx, path, attr, oldValue, newValue, toString);
+    return true;
+}
+
+
+static void
+virDomainDefDiffFeatureStates(virDomainDefDiffCtx *ctx,
+                              const char *path,
+                              const int *oldStates,
+                              const int *newStates,
+                              size_t nstates,
+                              virDomainDefDiffEnumToString toString)
+{
+    size_t i;
+
+    for (i = 0; i < nstates; i++) {
+        g_autofree char *statePath = virDomainDefDiffPath(path, "/%s", toString(i));
+
+        if (!oldStates[i] || !newStates[i]) {
+            virDomainDefDiffElement(ctx, statePath, "",
+                                    !!oldStates[i], !!newStates[i]);
+            continue;
+        }
+
+        virDomainDefDiffEnum(ctx, statePath, "/@state",
+                             oldStates[i], newStates[i],
+                             virTristateSwitchTypeToString);
+    }
+}
+
+
+/* Sub-elements of the hypervisor features, only compared if the feature
+ * is present in both definitions. */
+static void
+virDomainDefDiffFeatureDetails(virDomainDefDiffCtx *ctx,
+                               virDomainFeature feature,
+                               virDomainDef *a,
+                               virDomainDef *b)
+{
+    const char *path = "/domain/features";
+
+    switch (feature) {
+    case VIR_DOMAIN_FEATURE_HYPERV:
+        virDomainDefDiffFeatureStates(ctx, "/domain/features/hyperv",
+                                      a->hyperv_features, b->hyperv_features,
+                                      VIR_DOMAIN_HYPERV_LAST,
+                                      virDomainHypervTypeToString);
+        DIFF_UNSIGNED("/hyperv/spinlocks/@retries", hyperv_spinlocks);
+        DIFF_STRING("/hyperv/vendor_id/@value", hyperv_vendor_id);
+        DIFF_TRISTATE_SWITCH("/hyperv/stimer/direct/@state", hyperv_stimer_direct);
+        break;
+
+    case VIR_DOMAIN_FEATURE_KVM:
+        if (!DIFF_BOTH("/kvm", kvm_features))
+            break;
+
+        virDomainDefDiffFeatureStates(ctx, "/domain/features/kvm",
+                                      a->kvm_features->features,
+                                      b->kvm_features->features,
+                                      VIR_DOMAIN_KVM_LAST,
+                                      virDomainKVMTypeToString);
+        DIFF_UNSIGNED("/kvm/dirty-ring/@size", kvm_features->dirty_ring_size);
+        break;
+
+    case VIR_DOMAIN_FEATURE_XEN:
+        virDomainDefDiffFeatureStates(ctx, "/domain/features/xen",
+                                      a->xen_features, b->xen_features,
+                                      VIR_DOMAIN_XEN_LAST,
+                                      virDomainXenTypeToString);
+        DIFF_ENUM("/xen/passthrough/@mode", xen_passthrough_mode,
+                  virDomainXenPassthroughMode);
+        break;
+
+    case VIR_DOMAIN_FEATURE_CAPABILITIES:
+        virDomainDefDiffFeatureStates(ctx, "/domain/features/capabilities",
+                                      a->caps_features, b->caps_features,
+                                      VIR_DOMAIN_PROCES_CAPS_FEATURE_LAST,
+                                      virDomainProcessCapsFeatureTypeToString);
+        break;
+
+    case VIR_DOMAIN_FEATURE_MSRS:
+        DIFF_ENUM("/msrs/@unknown", msrs_features[VIR_DOMAIN_MSRS_UNKNOWN],
+                  virDomainMsrsUnknown);
+        break;
+
+    case VIR_DOMAIN_FEATURE_GIC:
+        DIFF_ENUM("/gic/@version", gic_version, virGICVersion);
+        break;
+
+    case VIR_DOMAIN_FEATURE_HPT:
+        DIFF_ENUM("/hpt/@resizing", hpt_resizing, virDomainHPTResizing);
+        DIFF_UNSIGNED("/hpt/maxpagesize", hpt_maxpagesize);
+        break;
+
+    case VIR_DOMAIN_FEATURE_APIC:
+        DIFF_TRISTATE_SWITCH("/apic/@eoi", apic_eoi);
+        break;
+
+    case VIR_DOMAIN_FEATURE_SMM:
+        virDomainDefDiffOptionalUnsigned(ctx, path, "/smm/tseg",
+                                         a->tseg_specified, a->tseg_size,
+                                         b->tseg_specified, b->tseg_size);
+        break;
+
+    case VIR_DOMAIN_FEATURE_TCG:
+        if (DIFF_BOTH("/tcg", tcg_features))
+            DIFF_UNSIGNED("/tcg/tb-cache", tcg_features->tb_cache);
+        break;
+
+    case VIR_DOMAIN_FEATURE_ACPI:
+    case VIR_DOMAIN_FEATURE_PAE:
+    case VIR_DOMAIN_FEATURE_HAP:
+    case VIR_DOMAIN_FEATURE_VIRIDIAN:
+    case VIR_DOMAIN_FEATURE_PRIVNET:
+    case VIR_DOMAIN_FEATURE_PVSPINLOCK:
+    case VIR_DOMAIN_FEATURE_PMU:
+    case VIR_DOMAIN_FEATURE_VMPORT:
+    case VIR_DOMAIN_FEATURE_IOAPIC:
+    case VIR_DOMAIN_FEATURE_VMCOREINFO:
+    case VIR_DOMAIN_FEATURE_HTM:
+    case VIR_DOMAIN_FEATURE_NESTED_HV:
+    case VIR_DOMAIN_FEATURE_CCF_ASSIST:
+    case VIR_DOMAIN_FEATURE_CFPC:
+    case VIR_DOMAIN_FEATURE_SBBC:
+    case VIR_DOMAIN_FEATURE_IBS:
+    case VIR_DOMAIN_FEATURE_ASYNC_TEARDOWN:
+    case VIR_DOMAIN_FEATURE_LAST:
+        break;
+    }
+}
+
+
+/* Mirrors virDomainDefFeaturesCheckABIStability() */
+static void
+virDomainDefDiffFeatures(virDomainDefDiffCtx *ctx,
+                         virDomainDef *a,
+                         virDomainDef *b)
+{
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_FEATURE_LAST; i++) {
+        virDomainFeature feature = i;
+        const char *name = virDomainFeatureTypeToString(feature);
+        const char *attr = "/@state";
+        virDomainDefDiffEnumToString toString = virTristateSwitchTypeToString;
+        int oldValue = a->features[i];
+        int newValue = b->features[i];
+
+        switch (feature) {
+        case VIR_DOMAIN_FEATURE_HYPERV:
+            attr = "/@mode";
+            toString = virDomainHyperVModeTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_CAPABILITIES:
+            attr = "/@policy";
+            toString = virDomainCapabilitiesPolicyTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_IOAPIC:
+            attr = "/@driver";
+            toString = virDomainIOAPICTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_CFPC:
+            attr = "/@value";
+            toString = virDomainCFPCTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_SBBC:
+            attr = "/@value";
+            toString = virDomainSBBCTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_IBS:
+            attr = "/@value";
+            toString = virDomainIBSTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_ASYNC_TEARDOWN:
+            attr = "/@enabled";
+            toString = virTristateBoolTypeToString;
+            break;
+        case VIR_DOMAIN_FEATURE_TCG:
+            /* present only through its sub-elements */
+            oldValue = !!a->tcg_features;
+            newValue = !!b->tcg_features;
+            break;
+        case VIR_DOMAIN_FEATURE_ACPI:
+        case VIR_DOMAIN_FEATURE_APIC:
+        case VIR_DOMAIN_FEATURE_PAE:
+        case VIR_DOMAIN_FEATURE_HAP:
+        case VIR_DOMAIN_FEATURE_VIRIDIAN:
+        case VIR_DOMAIN_FEATURE_PRIVNET:
+        case VIR_DOMAIN_FEATURE_KVM:
+        case VIR_DOMAIN_FEATURE_PVSPINLOCK:
+        case VIR_DOMAIN_FEATURE_PMU:
+        case VIR_DOMAIN_FEATURE_VMPORT:
+        case VIR_DOMAIN_FEATURE_GIC:
+        case VIR_DOMAIN_FEATURE_SMM:
+        case VIR_DOMAIN_FEATURE_HPT:
+        case VIR_DOMAIN_FEATURE_VMCOREINFO:
+        case VIR_DOMAIN_FEATURE_HTM:
+        case VIR_DOMAIN_FEATURE_NESTED_HV:
+        case VIR_DOMAIN_FEATURE_MSRS:
+        case VIR_DOMAIN_FEATURE_CCF_ASSIST:
+        case VIR_DOMAIN_FEATURE_XEN:
+        case VIR_DOMAIN_FEATURE_LAST:
+            break;
+        }
+
+        if (virDomainDefDiffFeature(ctx, name, attr, oldValue, newValue, toString))
+            virDomainDefDiffFeatureDetails(ctx, feature, a, b);
+    }
+}
+
+
+static virDomainTimerDef *
+virDomainDefDiffFindTimer(virDomainClockDef *clock,
+                          virDomainTimerNameType name)
+{
+    size_t i;
+
+    for (i = 0; i < clock->ntimers; i++) {
+        if (clock->timers[i]->name == name)
+            return clock->timers[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffTimer(virDomainDefDiffCtx *ctx,
+                      const char *path,
+                      virDomainTimerDef *a,
+                      virDomainTimerDef *b)
+{
+    DIFF_TRISTATE_BOOL("/@present", present);
+    DIFF_ENUM("/@tickpolicy", tickpolicy, virDomainTimerTickpolicy);
+    DIFF_ENUM("/@track", track, virDomainTimerTrack);
+    DIFF_UNSIGNED("/@frequency", frequency);
+    DIFF_ENUM("/@mode", mode, virDomainTimerMode);
+    DIFF_UNSIGNED("/catchup/@threshold", catchup.threshold);
+    DIFF_UNSIGNED("/catchup/@slew", catchup.slew);
+    DIFF_UNSIGNED("/catchup/@limit", catchup.limit);
+}
+
+
+static void
+virDomainDefDiffClock(virDomainDefDiffCtx *ctx,
+                      virDomainClockDef *a,
+                      virDomainClockDef *b)
+{
+    const char *path = "/domain/clock";
+    size_t i;
+
+    DIFF_ENUM("/@offset", offset, virDomainClockOffset);
+
+    if (a->offset == b->offset) {
+        switch ((virDomainClockOffsetType) a->offset) {
+        case VIR_DOMAIN_CLOCK_OFFSET_UTC:
+        case VIR_DOMAIN_CLOCK_OFFSET_LOCALTIME:
+            virDomainDefDiffString(ctx, path, "/@adjustment",
+                                   a->data.utc_reset ? "reset" : NULL,
+                                   b->data.utc_reset ? "reset" : NULL);
+            break;
+        case VIR_DOMAIN_CLOCK_OFFSET_VARIABLE:
+            DIFF_SIGNED("/@adjustment", data.variable.adjustment);
+            DIFF_ENUM("/@basis", data.variable.basis, virDomainClockBasis);
+            break;
+        case VIR_DOMAIN_CLOCK_OFFSET_TIMEZONE:
+            DIFF_STRING("/@timezone", data.timezone);
+            break;
+        case VIR_DOMAIN_CLOCK_OFFSET_ABSOLUTE:
+            DIFF_UNSIGNED("/@start", data.starttime);
+            break;
+        case VIR_DOMAIN_CLOCK_OFFSET_LAST:
+            break;
+        }
+    }
+
+    for (i = 0; i < a->ntimers; i++) {
+        virDomainTimerDef *oldTimer = a->timers[i];
+        virDomainTimerDef *newTimer = virDomainDefDiffFindTimer(b, oldTimer->name);
+        g_autofree char *timerPath = virDomainDefDiffPath(path, "/timer[@name='%s']",
+                                                          virDomainTimerNameTypeToString(oldTimer->name));
+
+        if (!newTimer) {
+            virDomainDefDiffElement(ctx, timerPath, "", true, false);
+            continue;
+        }
+
+        virDomainDefDiffTimer(ctx, timerPath, oldTimer, newTimer);
+    }
+
+    for (i = 0; i < b->ntimers; i++) {
+        g_autofree char *timerPath = NULL;
+
+        if (virDomainDefDiffFindTimer(a, b->timers[i]->name))
+            continue;
+
+        timerPath = virDomainDefDiffPath(path, "/timer[@name='%s']",
+                                         virDomainTimerNameTypeToString(b->timers[i]->name));
+        virDomainDefDiffElement(ctx, timerPath, "", false, true);
+    }
+}
+
+
+/* Labels of the default type are never formatted. */
+static virSecurityLabelDef *
+virDomainDefDiffFindSeclabel(virDomainDef *def,
+                             const char *model)
+{
+    size_t i;
+
+    for (i = 0; i < def->nseclabels; i++) {
+        virSecurityLabelDef *seclabel = def->seclabels[i];
+
+        if (seclabel->type != VIR_DOMAIN_SECLABEL_DEFAULT &&
+            STREQ_NULLABLE(seclabel->model, model))
+            return seclabel;
+    }
+
+    return NULL;
+}
+
+
+static char *
+virDomainDefDiffSeclabelPath(const char *model)
+{
+    if (!model)
+        return g_strdup("/domain/seclabel");
+
+    return g_strdup_printf("/domain/seclabel[@model='%s']", model);
+}
+
+
+static void
+virDomainDefDiffSeclabel(virDomainDefDiffCtx *ctx,
+                         virSecurityLabelDef *a,
+                         virSecurityLabelDef *b)
+{
+    g_autofree char *path = virDomainDefDiffSeclabelPath(a->model);
+
+    DIFF_ENUM("/@type", type, virDomainSeclabel);
+    DIFF_BOOL("/@relabel", relabel);
+
+    /* dynamic labels are generated when the domain starts */
+    if (!(ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE) ||
+        (a->type != VIR_DOMAIN_SECLABEL_DYNAMIC &&
+         b->type != VIR_DOMAIN_SECLABEL_DYNAMIC)) {
+        DIFF_STRING("/label", label);
+        DIFF_STRING("/imagelabel", imagelabel);
+    }
+
+    DIFF_STRING("/baselabel", baselabel);
+}
+
+
+static void
+virDomainDefDiffSeclabels(virDomainDefDiffCtx *ctx,
+                          virDomainDef *oldDef,
+                          virDomainDef *newDef)
+{
+    size_t i;
+
+    for (i = 0; i < oldDef->nseclabels; i++) {
+        virSecurityLabelDef *oldLabel = oldDef->seclabels[i];
+        virSecurityLabelDef *newLabel;
+
+        if (oldLabel->type == VIR_DOMAIN_SECLABEL_DEFAULT)
+            continue;
+
+        if (!(newLabel = virDomainDefDiffFindSeclabel(newDef, oldLabel->model))) {
+            g_autofree char *path = virDomainDefDiffSeclabelPath(oldLabel->model);
+
+            virDomainDefDiffElement(ctx, path, "", true, false);
+            continue;
+        }
+
+        virDomainDefDiffSeclabel(ctx, oldLabel, newLabel);
+    }
+
+    for (i = 0; i < newDef->nseclabels; i++) {
+        virSecurityLabelDef *newLabel = newDef->seclabels[i];
+        g_autofree char *path = NULL;
+
+        if (newLabel->type == VIR_DOMAIN_SECLABEL_DEFAULT ||
+            virDomainDefDiffFindSeclabel(oldDef, newLabel->model))
+            continue;
+
+        path = virDomainDefDiffSeclabelPath(newLabel->model);
+        virDomainDefDiffElement(ctx, path, "", false, true);
+    }
+}
+
+
+static void
+virDomainDefDiffSysinfoBaseBoard(virDomainDefDiffCtx *ctx,
+                                 const char *path,
+                                 virSysinfoBaseBoardDef *a,
+                                 virSysinfoBaseBoardDef *b)
+{
+    DIFF_STRING("/entry[@name='manufacturer']", manufacturer);
+    DIFF_STRING("/entry[@name='product']", product);
+    DIFF_STRING("/entry[@name='version']", version);
+    DIFF_STRING("/entry[@name='serial']", serial);
+    DIFF_STRING("/entry[@name='asset']", asset);
+    DIFF_STRING("/entry[@name='location']", location);
+}
+
+
+static virSysinfoFWCfgDef *
+virDomainDefDiffFindFWCfg(virSysinfoDef *sysinfo,
+                          const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < sysinfo->nfw_cfgs; i++) {
+        if (STREQ(sysinfo->fw_cfgs[i].name, name))
+            return &sysinfo->fw_cfgs[i];
+    }
+
+    return NULL;
+}
+
+
+static void
+virDomainDefDiffSysinfoFWCfgs(virDomainDefDiffCtx *ctx,
+                              const char *sysinfoPath,
+                              virSysinfoDef *oldSysinfo,
+                              virSysinfoDef *newSysinfo)
+{
+    size_t i;
+
+    for (i = 0; i < oldSysinfo->nfw_cfgs; i++) {
+        virSysinfoFWCfgDef *a = &oldSysinfo->fw_cfgs[i];
+        virSysinfoFWCfgDef *b = virDomainDefDiffFindFWCfg(newSysinfo, a->name);
+        g_autofree char *path = virDomainDefDiffPath(sysinfoPath, "/entry[@name='%s']",
+                                                     a->name);
+
+        if (!b) {
+            virDomainDefDiffElement(ctx, path, "", true, false);
+            continue;
+        }
+
+        DIFF_STRING("", value);
+        DIFF_STRING("/@file", file);
+    }
+
+    for (i = 0; i < newSysinfo->nfw_cfgs; i++) {
+        g_autofree char *path = NULL;
+
+        if (virDomainDefDiffFindFWCfg(oldSysinfo, newSysinfo->fw_cfgs[i].name))
+            continue;
+
+        path = virDomainDefDiffPath(sysinfoPath, "/entry[@name='%s']",
+                                    newSysinfo->fw_cfgs[i].name);
+        virDomainDefDiffElement(ctx, path, "", false, true);
+    }
+}
+
+
+#define DIFF_SYSINFO_ENTRY(section, field) \
+    virDomainDefDiffString(ctx, path, \
+                           "/" #section "/entry[@name='" #field "']", \
+                           a->section ? a->section->field : NULL, \
+                           b->section ? b->section->field : NULL)
+
+/* Processors and memory modules are read from the host only. */
+static void
+virDomainDefDiffSysinfo(virDomainDefDiffCtx *ctx,
+                        const char *path,
+                        virSysinfoDef *a,
+                        virSysinfoDef *b)
+{
+    size_t noldStrings = a->oemStrings ? a->oemStrings->nvalues : 0;
+    size_t nnewStrings = b->oemStrings ? b->oemStrings->nvalues : 0;
+    size_t i;
+
+    DIFF_ENUM("/@type", type, virSysinfo);
+
+    if (a->type != b->type)
+        return;
+
+    DIFF_SYSINFO_ENTRY(bios, vendor);
+    DIFF_SYSINFO_ENTRY(bios, version);
+    DIFF_SYSINFO_ENTRY(bios, date);
+    DIFF_SYSINFO_ENTRY(bios, release);
+
+    DIFF_SYSINFO_ENTRY(system, manufacturer);
+    DIFF_SYSINFO_ENTRY(system, product);
+    DIFF_SYSINFO_ENTRY(system, version);
+    DIFF_SYSINFO_ENTRY(system, serial);
+    DIFF_SYSINFO_ENTRY(system, uuid);
+    DIFF_SYSINFO_ENTRY(system, sku);
+    DIFF_SYSINFO_ENTRY(system, family);
+
+    for (i = 0; i < MAX(a->nbaseBoard, b->nbaseBoard); i++) {
+        g_autofree char *boardPath = virDomainDefDiffPath(path, "/baseBoard[%zu]", i + 1);
+
+        if (i >= a->nbaseBoard || i >= b->nbaseBoard) {
+            virDomainDefDiffElement(ctx, boardPath, "",
+                                    i < a->nbaseBoard, i < b->nbaseBoard);
+            continue;
+        }
+
+        virDomainDefDiffSysinfoBaseBoard(ctx, boardPath, &a->baseBoard[i],
+                                         &b->baseBoard[i]);
+    }
+
+    DIFF_SYSINFO_ENTRY(chassis, manufacturer);
+    DIFF_SYSINFO_ENTRY(chassis, version);
+    DIFF_SYSINFO_ENTRY(chassis, serial);
+    DIFF_SYSINFO_ENTRY(chassis, asset);
+    DIFF_SYSINFO_ENTRY(chassis, sku);
+
+    for (i = 0; i < MAX(noldStrings, nnewStrings); i++) {
+        g_autofree char *suffix = g_strdup_printf("/oemStrings/entry[%zu]", i + 1);
+
+        virDomainDefDiffString(ctx, path, suffix,
+                               i < noldStrings ? a->oemStrings->values[i] : NULL,
+                               i < nnewStrings ? b->oemStrings->values[i] : NULL);
+    }
+
+    virDomainDefDiffSysinfoFWCfgs(ctx, path, a, b);
+}
+
+#undef DIFF_SYSINFO_ENTRY
+
+static void
+virDomainDefDiffRedirFilter(virDomainDefDiffCtx *ctx,
+                            virDomainRedirFilterDef *oldFilter,
+                            virDomainRedirFilterDef *newFilter)
+{
+    size_t nold = oldFilter ? oldFilter->nusbdevs : 0;
+    size_t nnew = newFilter ? newFilter->nusbdevs : 0;
+    size_t i;
+
+    for (i = 0; i < MAX(nold, nnew); i++) {
+        g_autofree char *path = g_strdup_printf("/domain/devices/redirfilter/usbdev[%zu]",
+                                                i + 1);
+        virDomainRedirFilterUSBDevDef *a;
+        virDomainRedirFilterUSBDevDef *b;
+
+        if (i >= nold || i >= nnew) {
+            virDomainDefDiffElement(ctx, path, "", i < nold, i < nnew);
+            continue;
+        }
+
+        a = oldFilter->usbdevs[i];
+        b = newFilter->usbdevs[i];
+
+        /* -1 stands for any value and isn't formatted */
+        DIFF_SIGNED("/@class", usbClass);
+        DIFF_SIGNED("/@vendor", vendor);
+        DIFF_SIGNED("/@product", product);
+        DIFF_SIGNED("/@version", version);
+        DIFF_BOOL("/@allow", allow);
+    }
+}
+
+
+static void
+virDomainDefDiffSecurity(virDomainDefDiffCtx *ctx,
+                         virDomainDef *a,
+                         virDomainDef *b)
+{
+    const char *path = "/domain";
+
+    if (DIFF_BOTH("/keywrap", keywrap)) {
+        DIFF_TRISTATE_SWITCH("/keywrap/cipher[@name='aes']/@state", keywrap->aes);
+        DIFF_TRISTATE_SWITCH("/keywrap/cipher[@name='dea']/@state", keywrap->dea);
+    }
+
+    if (!DIFF_BOTH("/launchSecurity", sec))
+        return;
+
+    DIFF_ENUM("/launchSecurity/@type", sec->sectype, virDomainLaunchSecurity);
+
+    if (a->sec->sectype != b->sec->sectype)
+        return;
+
+    switch (a->sec->sectype) {
+    case VIR_DOMAIN_LAUNCH_SECURITY_SEV:
+        virDomainDefDiffOptionalUnsigned(ctx, path, "/launchSecurity/cbitpos",
+                                         a->sec->data.sev.haveCbitpos,
+                                         a->sec->data.sev.cbitpos,
+                                         b->sec->data.sev.haveCbitpos,
+                                         b->sec->data.sev.cbitpos);
+        virDomainDefDiffOptionalUnsigned(ctx, path, "/launchSecurity/reducedPhysBits",
+                                         a->sec->data.sev.haveReducedPhysBits,
+                                         a->sec->data.sev.reduced_phys_bits,
+                                         b->sec->data.sev.haveReducedPhysBits,
+                                         b->sec->data.sev.reduced_phys_bits);
+        DIFF_HEX("/launchSecurity/policy", sec->data.sev.policy);
+        DIFF_STRING("/launchSecurity/dhCert", sec->data.sev.dh_cert);
+        DIFF_STRING("/launchSecurity/session", sec->data.sev.session);
+        DIFF_TRISTATE_BOOL("/launchSecurity/@kernelHashes",
+                           sec->data.sev.kernel_hashes);
+        break;
+
+    case VIR_DOMAIN_LAUNCH_SECURITY_PV:
+    case VIR_DOMAIN_LAUNCH_SECURITY_NONE:
+    case VIR_DOMAIN_LAUNCH_SECURITY_LAST:
+        break;
+    }
+}
+
+
+/**
+ * virDomainDefDiffOpaque:
+ * @ctx: diff context
+ * @oldDef: original definition
+ * @newDef: updated definition
+ *
+ * Compares <metadata> and the data of the driver specific XML namespace.
+ * Both are opaque to the domain code and compared in their XML form.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+virDomainDefDiffOpaque(virDomainDefDiffCtx *ctx,
+                       virDomainDef *oldDef,
+                       virDomainDef *newDef)
+{
+    g_autofree char *oldMetadata = NULL;
+    g_autofree char *newMetadata = NULL;
+    g_auto(virBuffer) oldNS = VIR_BUFFER_INITIALIZER;
+    g_auto(virBuffer) newNS = VIR_BUFFER_INITIALIZER;
+
+    if ((oldDef->metadata &&
+         !(oldMetadata = virXMLNodeToString(oldDef->metadata->doc,
+                                            oldDef->metadata))) ||
+        (newDef->metadata &&
+         !(newMetadata = virXMLNodeToString(newDef->metadata->doc,
+                                            newDef->metadata))))
+        return -1;
+
+    if (STRNEQ_NULLABLE(oldMetadata, newMetadata))
+        virDomainDefDiffElement(ctx, "/domain/metadata", "",
+                                !!oldMetadata, !!newMetadata);
+
+    if ((oldDef->namespaceData && oldDef->ns.format &&
+         oldDef->ns.format(&oldNS, oldDef->namespaceData) < 0) ||
+        (newDef->namespaceData && newDef->ns.format &&
+         newDef->ns.format(&newNS, newDef->namespaceData) < 0))
+        return -1;
+
+    if (STRNEQ(virBufferCurrentContent(&oldNS), virBufferCurrentContent(&newNS))) {
+        g_autofree char *path = g_strdup_printf("/domain/%s:*",
+                                                NULLSTR(newDef->ns.prefix));
+
+        virDomainDefDiffElement(ctx, path, "",
+                                virBufferUse(&oldNS) > 0,
+                                virBufferUse(&newNS) > 0);
+    }
+
+    return 0;
+}
+
+
+/**
+ * virDomainDefDiffDeviceKey:
+ * @dev: device
+ * @info: address and alias of @dev, may be NULL
+ * @flags: bitwise-OR of virDomainDefDiffFlags
+ *
+ * Returns the element name of @dev followed by the predicate identifying
+ * it, e.g. "disk[target/@dev='vda']". Devices without anything unique
+ * enough get just the element name and are matched by position.
+ */
+static char *
+virDomainDefDiffDeviceKey(virDomainDeviceDef *dev,
+                          virDomainDeviceInfo *info,
+                          unsigned int flags)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    char macstr[VIR_MAC_STRING_BUFLEN];
+    virDomainChrDef *chr;
+
+    if (dev->type == VIR_DOMAIN_DEVICE_CHR)
+        virBufferAdd(&buf, virDomainChrDeviceTypeToString(dev->data.chr->deviceType), -1);
+    else
+        virBufferAdd(&buf, virDomainDeviceTypeToString(dev->type), -1);
+
+    switch ((virDomainDeviceType) dev->type) {
+    case VIR_DOMAIN_DEVICE_DISK:
+        virBufferEscapeString(&buf, "[target/@dev='%s']", dev->data.disk->dst);
+        return virBufferContentAndReset(&buf);
+
+    case VIR_DOMAIN_DEVICE_FS:
+        if (dev->data.fs->dst) {
+            virBufferEscapeString(&buf, "[target/@dir='%s']", dev->data.fs->dst);
+            return virBufferContentAndReset(&buf);
+        }
+        break;
+
+    case VIR_DOMAIN_DEVICE_NET:
+        virBufferAsprintf(&buf, "[mac/@address='%s']",
+                          virMacAddrFormat(&dev->data.net->mac, macstr));
+        return virBufferContentAndReset(&buf);
+
+    case VIR_DOMAIN_DEVICE_CONTROLLER:
+        virBufferAsprintf(&buf, "[@type='%s'][@index='%d']",
+                          virDomainControllerTypeToString(dev->data.controller->type),
+                          dev->data.controller->idx);
+        return virBufferContentAndReset(&buf);
+
+    case VIR_DOMAIN_DEVICE_CHR:
+        chr = dev->data.chr;
+
+        switch ((virDomainChrDeviceType) chr->deviceType) {
+        case VIR_DOMAIN_CHR_DEVICE_TYPE_CONSOLE:
+            virBufferAsprintf(&buf, "[target/@type='%s']",
+                              virDomainChrConsoleTargetTypeToString(chr->targetType));
+            G_GNUC_FALLTHROUGH;
+        case VIR_DOMAIN_CHR_DEVICE_TYPE_SERIAL:
+        case VIR_DOMAIN_CHR_DEVICE_TYPE_PARALLEL:
+            virBufferAsprintf(&buf, "[target/@port='%d']", chr->target.port);
+            return virBufferContentAndReset(&buf);
+
+        case VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL:
+            if (chr->targetType == VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_VIRTIO &&
+                chr->target.name) {
+                virBufferEscapeString(&buf, "[target/@name='%s']", chr->target.name);
+                return virBufferContentAndReset(&buf);
+            }
+            break;
+
+        case VIR_DOMAIN_CHR_DEVICE_TYPE_LAST:
+            break;
+        }
+        break;
+
+    case VIR_DOMAIN_DEVICE_LEASE:
+    case VIR_DOMAIN_DEVICE_INPUT:
+    case VIR_DOMAIN_DEVICE_SOUND:
+    case VIR_DOMAIN_DEVICE_VIDEO:
+    case VIR_DOMAIN_DEVICE_HOSTDEV:
+    case VIR_DOMAIN_DEVICE_WATCHDOG:
+    case VIR_DOMAIN_DEVICE_GRAPHICS:
+    case VIR_DOMAIN_DEVICE_HUB:
+    case VIR_DOMAIN_DEVICE_REDIRDEV:
+    case VIR_DOMAIN_DEVICE_SMARTCARD:
+    case VIR_DOMAIN_DEVICE_MEMBALLOON:
+    case VIR_DOMAIN_DEVICE_NVRAM:
+    case VIR_DOMAIN_DEVICE_RNG:
+    case VIR_DOMAIN_DEVICE_SHMEM:
+    case VIR_DOMAIN_DEVICE_TPM:
+    case VIR_DOMAIN_DEVICE_PANIC:
+    case VIR_DOMAIN_DEVICE_MEMORY:
+    case VIR_DOMAIN_DEVICE_IOMMU:
+    case VIR_DOMAIN_DEVICE_VSOCK:
+    case VIR_DOMAIN_DEVICE_AUDIO:
+    case VIR_DOMAIN_DEVICE_CRYPTO:
+    case VIR_DOMAIN_DEVICE_NONE:
+    case VIR_DOMAIN_DEVICE_LAST:
+        break;
+    }
+
+    if (!info)
+        return virBufferContentAndReset(&buf);
+
+    /* inactive definitions keep only aliases set by the user */
+    if (info->alias &&
+        (!(flags & VIR_DOMAIN_DEF_DIFF_INACTIVE) ||
+         virDomainDeviceAliasIsUserAlias(info->alias))) {
+        virBufferEscapeString(&buf, "[alias/@name='%s']", info->alias);
+        return virBufferContentAndReset(&buf);
+    }
+
+    /* other address types don't identify devices across definitions
+     * reliably, those devices are matched by position */
+    if (info->type == VIR_DOMAIN_DEVICE_ADDRESS_TYPE_PCI) {
+        virBufferAsprintf(&buf,
+                          "[address/@domain='0x%04x'][address/@bus='0x%02x']"
+                          "[address/@slot='0x%02x'][address/@function='0x%x']",
+                          info->addr.pci.domain, info->addr.pci.bus,
+                          info->addr.pci.slot, info->addr.pci.function);
+    } else if (info->type == VIR_DOMAIN_DEVICE_ADDRESS_TYPE_DRIVE) {
+        virBufferAsprintf(&buf,
+                          "[address/@controller='%u'][address/@bus='%u']"
+                          "[address/@target='%u'][address/@unit='%u']",
+                          info->addr.drive.controller, info->addr.drive.bus,
+                          info->addr.drive.target, info->addr.drive.unit);
+    }
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+typedef struct _virDomainDefDiffDevice virDomainDefDiffDevice;
+struct _virDomainDefDiffDevice {
+    virDomainDeviceDef dev;
+    char *key; /* unique within the definition */
+    bool matched;
+};
+
+static void
+virDomainDefDiffDeviceFree(virDomainDefDiffDevice *device)
+{
+    g_free(device->key);
+    g_free(device);
+}
+
+
+typedef struct _virDomainDefDiffCollectData virDomainDefDiffCollectData;
+struct _virDomainDefDiffCollectData {
+    GPtrArray *devices;
+    GHashTable *counts;
+    unsigned int flags;
+};
+
+static int
+virDomainDefDiffCollectDevice(virDomainDef *def G_GNUC_UNUSED,
+                              virDomainDeviceDef *dev,
+                              virDomainDeviceInfo *info,
+                              void *opaque)
+{
+    virDomainDefDiffCollectData *data = opaque;
+    virDomainDefDiffDevice *device;
+    g_autofree char *base = NULL;
+    size_t count;
+
+    /* formatted as part of their <interface> */
+    if (dev->type == VIR_DOMAIN_DEVICE_HOSTDEV &&
+        dev->data.hostdev->parentnet)
+        return 0;
+
+    base = virDomainDefDiffDeviceKey(dev, info, data->flags);
+
+    count = GPOINTER_TO_SIZE(g_hash_table_lookup(data->counts, base)) + 1;
+    g_hash_table_insert(data->counts, g_strdup(base), GSIZE_TO_POINTER(count));
+
+    device = g_new0(virDomainDefDiffDevice, 1);
+    device->dev = *dev;
+
+    if (count == 1)
+        device->key = g_steal_pointer(&base);
+    else
+        device->key = g_strdup_printf("%s[%zu]", base, count);
+
+    g_ptr_array_add(data->devices, device);
+    return 0;
+}
+
+
+/**
+ * virDomainDefDiffGetDevices:
+ * @def: domain definition
+ * @flags: bitwise-OR of virDomainDefDiffFlags
+ *
+ * Collects the devices of @def along with the keys used to match them
+ * against the devices of the other definition. The keys are made unique
+ * by appending the position among the devices sharing the same base key.
+ */
+static GPtrArray *
+virDomainDefDiffGetDevices(virDomainDef *def,
+                           unsigned int flags)
+{
+    g_autoptr(GHashTable) counts = virHashNew(NULL);
+    virDomainDefDiffCollectData data = {
+        .devices = g_ptr_array_new_with_free_func((GDestroyNotify) virDomainDefDiffDeviceFree),
+        .counts = counts,
+        .flags = flags,
+    };
+
+    ignore_value(virDomainDeviceInfoIterateFlags(def,
+                                                 virDomainDefDiffCollectDevice,
+                                                 DOMAIN_DEVICE_ITERATE_MISSING_INFO,
+                                                 &data));
+
+    return data.devices;
+}
+
+
+static char *
+virDomainDefDiffDeviceFormat(virDomainDeviceDef *dev,
+                             virDomainXMLOption *xmlopt,
+                             unsigned int flags)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+
+    if (virDomainDeviceDefFormat(&buf, dev, xmlopt, flags) < 0)
+        return NULL;
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+static int
+virDomainDefDiffDevices(virDomainDefDiffCtx *ctx,
+                        virDomainDef *oldDef,
+                        virDomainDef *newDef,
+                        virDomainXMLOption *xmlopt)
+{
+    g_autoptr(GPtrArray) oldDevices = virDomainDefDiffGetDevices(oldDef, ctx->flags);
+    g_autoptr(GPtrArray) newDevices = virDomainDefDiffGetDevices(newDef, ctx->flags);
+    g_autoptr(GHashTable) newKeys = virHashNew(NULL);
+    unsigned int fmtflags = 0;
+    size_t i;
+
+    /* added and removed devices carry their XML */
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_INACTIVE)
+        fmtflags |= VIR_DOMAIN_DEF_FORMAT_INACTIVE;
+    if (ctx->flags & VIR_DOMAIN_DEF_DIFF_SECURE)
+        fmtflags |= VIR_DOMAIN_DEF_FORMAT_SECURE;
+
+    for (i = 0; i < newDevices->len; i++) {
+        virDomainDefDiffDevice *device = g_ptr_array_index(newDevices, i);
+
+        g_hash_table_insert(newKeys, g_strdup(device->key), device);
+    }
+
+    for (i = 0; i < oldDevices->len; i++) {
+        virDomainDefDiffDevice *oldDevice = g_ptr_array_index(oldDevices, i);
+        virDomainDefDiffDevice *newDevice = g_hash_table_lookup(newKeys, oldDevice->key);
+        g_autofree char *path = g_strdup_printf("/domain/devices/%s", oldDevice->key);
+        char *oldXML;
+
+        if (newDevice) {
+            newDevice->matched = true;
+            virDomainDefDiffDeviceDef(ctx, path, &oldDevice->dev, &newDevice->dev);
+            continue;
+        }
+
+        if (!(oldXML = virDomainDefDiffDeviceFormat(&oldDevice->dev, xmlopt, fmtflags)))
+            return -1;
+
+        ctx->devtype = oldDevice->dev.type;
+        virDomainDefDiffAdd(ctx, VIR_DOMAIN_DEF_CHANGE_REMOVED,
+                            g_steal_pointer(&path), oldXML, NULL, true);
+    }
+
+    for (i = 0; i < newDevices->len; i++) {
+        virDomainDefDiffDevice *newDevice = g_ptr_array_index(newDevices, i);
+        char *newXML;
+
+        if (newDevice->matched)
+            continue;
+
+        if (!(newXML = virDomainDefDiffDeviceFormat(&newDevice->dev, xmlopt, fmtflags)))
+            return -1;
+
+        ctx->devtype = newDevice->dev.type;
+        virDomainDefDiffAdd(ctx, VIR_DOMAIN_DEF_CHANGE_ADDED,
+                            g_strdup_printf("/domain/devices/%s", newDevice->key),
+                            NULL, newXML, true);
+    }
+
+    ctx->devtype = VIR_DOMAIN_DEVICE_NONE;
+    return 0;
+}
+
+
+/**
+ * virDomainDefDiffCompute:
+ * @oldDef: original definition
+ * @newDef: updated definition
+ * @xmlopt: XML parser configuration
+ * @flags: bitwise-OR of virDomainDefDiffFlags
+ *
+ * Compares @oldDef and @newDef section by section and lists the added,
+ * removed and modified devices and values. The @flags select which data
+ * take part in the comparison, e.g. VIR_DOMAIN_DEF_DIFF_INACTIVE leaves
+ * out runtime state and VIR_DOMAIN_DEF_DIFF_SECURE includes passwords.
+ *
+ * Returns the list of changes, empty if the definitions are equal, or NULL
+ * on error.
+ */
+virDomainDefDiff *
+virDomainDefDiffCompute(virDomainDef *oldDef,
+                        virDomainDef *newDef,
+                        virDomainXMLOption *xmlopt,
+                        unsigned int flags)
+{
+    g_autoptr(virDomainDefDiff) diff = g_new0(virDomainDefDiff, 1);
+    virDomainDefDiffCtx ctx = { .diff = diff, .flags = flags };
+    size_t i;
+
+    virCheckFlags(VIR_DOMAIN_DEF_DIFF_INACTIVE |
+                  VIR_DOMAIN_DEF_DIFF_SECURE |
+                  VIR_DOMAIN_DEF_DIFF_NO_DEVICE_INFO, NULL);
+
+    virDomainDefDiffGeneral(&ctx, oldDef, newDef);
+    virDomainDefDiffMemtune(&ctx, oldDef, newDef);
+    virDomainDefDiffBlkiotune(&ctx, &oldDef->blkio, &newDef->blkio);
+    virDomainDefDiffVcpus(&ctx, oldDef, newDef);
+    virDomainDefDiffIOThreads(&ctx, oldDef, newDef);
+    virDomainDefDiffCputune(&ctx, &oldDef->cputune, &newDef->cputune);
+
+    if (virDomainDefDiffResctrls(&ctx, oldDef, newDef) < 0)
+        return NULL;
+
+    virDomainDefDiffNumatune(&ctx, oldDef->numa, newDef->numa);
+    virDomainDefDiffResource(&ctx, oldDef->resource, newDef->resource);
+
+    for (i = 0; i < MAX(oldDef->nsysinfo, newDef->nsysinfo); i++) {
+        g_autofree char *path = g_strdup_printf("/domain/sysinfo[%zu]", i + 1);
+
+        if (i >= oldDef->nsysinfo || i >= newDef->nsysinfo) {
+            virDomainDefDiffElement(&ctx, path, "",
+                                    i < oldDef->nsysinfo, i < newDef->nsysinfo);
+            continue;
+        }
+
+        virDomainDefDiffSysinfo(&ctx, path, oldDef->sysinfo[i], newDef->sysinfo[i]);
+    }
+
+    virDomainDefDiffOS(&ctx, &oldDef->os, &newDef->os);
+    virDomainDefDiffIdmap(&ctx, "/domain", &oldDef->idmap, &newDef->idmap);
+    virDomainDefDiffFeatures(&ctx, oldDef, newDef);
+    virDomainDefDiffCPU(&ctx, oldDef->cpu, newDef->cpu);
+    virDomainDefDiffNuma(&ctx, oldDef->numa, newDef->numa);
+    virDomainDefDiffClock(&ctx, &oldDef->clock, &newDef->clock);
+    virDomainDefDiffEvents(&ctx, oldDef, newDef);
+
+    virDomainDefDiffString(&ctx, "/domain/devices", "/emulator",
+                           oldDef->emulator, newDef->emulator);
+
+    if (virDomainDefDiffDevices(&ctx, oldDef, newDef, xmlopt) < 0)
+        return NULL;
+
+    virDomainDefDiffRedirFilter(&ctx, oldDef->redirfilter, newDef->redirfilter);
+    virDomainDefDiffSeclabels(&ctx, oldDef, newDef);
+    virDomainDefDiffSecurity(&ctx, oldDef, newDef);
+
+    if (virDomainDefDiffOpaque(&ctx, oldDef, newDef) < 0)
+        return NULL;
+
+    VIR_DEBUG("found %zu changes between definitions of domain '%s'",
+              diff->nchanges, newDef->name);
+
+    return g_steal_pointer(&diff);
+}
+
+
+/**
+ * virDomainDeviceDefDiffCompute:
+ * @oldDev: original device
+ * @newDev: updated device
+ * @flags: bitwise-OR of virDomainDefDiffFlags
+ *
+ * Compares two definitions of a device, e.g. the one of a running domain
+ * and the one passed to a device update. The paths of the changes start
+ * with the element name of the device, e.g. /memory/target/requested.
+ *
+ * Returns the list of changes, empty if the devices are equal, or NULL on
+ * error.
+ */
+virDomainDefDiff *
+virDomainDeviceDefDiffCompute(virDomainDeviceDef *oldDev,
+                              virDomainDeviceDef *newDev,
+                              unsigned int flags)
+{
+    g_autoptr(virDomainDefDiff) diff = g_new0(virDomainDefDiff, 1);
+    virDomainDefDiffCtx ctx = { .diff = diff, .flags = flags };
+    g_autofree char *path = NULL;
+
+    virCheckFlags(VIR_DOMAIN_DEF_DIFF_INACTIVE |
+                  VIR_DOMAIN_DEF_DIFF_SECURE |
+                  VIR_DOMAIN_DEF_DIFF_NO_DEVICE_INFO, NULL);
+
+    if (oldDev->type != newDev->type) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("cannot compare device of type '%1$s' to device of type '%2$s'"),
+                       virDomainDeviceTypeToString(oldDev->type),
+                       virDomainDeviceTypeToString(newDev->type));
+        return NULL;
+    }
+
+    if (oldDev->type == VIR_DOMAIN_DEVICE_CHR)
+        path = g_strdup_printf("/%s", virDomainChrDeviceTypeToString(oldDev->data.chr->deviceType));
+    else
+        path = g_strdup_printf("/%s", virDomainDeviceTypeToString(oldDev->type));
+
+    virDomainDefDiffDeviceDef(&ctx, path, oldDev, newDev);
+
+    return g_steal_pointer(&diff);
+}
+
+
+/**
+ * virDomainDefDiffHasDeviceChanges:
+ * @diff: list of changes
+ * @devtype: device type
+ *
+ * Returns true if any device of type @devtype was added, removed or
+ * modified. Passing VIR_DOMAIN_DEVICE_NONE checks the changes outside of
+ * devices.
+ */
+bool
+virDomainDefDiffHasDeviceChanges(const virDomainDefDiff *diff,
+                                 virDomainDeviceType devtype)
+{
+    size_t i;
+
+    for (i = 0; i < diff->nchanges; i++) {
+        if (diff->changes[i].devtype == devtype)
+            return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * virDomainDefDiffFormat:
+ * @diff: list of changes
+ *
+ * Formats @diff as one line per change. Values of elements changed as a
+ * whole, e.g. the XML of added and removed devices, are left out.
+ *
+ * Returns the formatted list, or an empty string if there are no changes.
+ */
+char *
+virDomainDefDiffFormat(const virDomainDefDiff *diff)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    size_t i;
+
+    for (i = 0; i < diff->nchanges; i++) {
+        const virDomainDefChange *change = &diff->changes[i];
+
+        virBufferAsprintf(&buf, "%s %s",
+                          virDomainDefChangeTypeToString(change->type),
+                          change->path);
+
+        if (!change->element) {
+            switch (change->type) {
+            case VIR_DOMAIN_DEF_CHANGE_ADDED:
+                virBufferAsprintf(&buf, " '%s'", change->newValue);
+                break;
+            case VIR_DOMAIN_DEF_CHANGE_REMOVED:
+                virBufferAsprintf(&buf, " '%s'", change->oldValue);
+                break;
+            case VIR_DOMAIN_DEF_CHANGE_MODIFIED:
+                virBufferAsprintf(&buf, " '%s' -> '%s'",
+                                  NULLSTR_EMPTY(change->oldValue),
+                                  NULLSTR_EMPTY(change->newValue));
+                break;
+            case VIR_DOMAIN_DEF_CHANGE_LAST:
+                break;
+            }
+        }
+
+        virBufferAddLit(&buf, "\n");
+    }
+
+    if (virBufferUse(&buf) == 0)
+        return g_strdup("");
+
+    return virBufferContentAndReset(&buf);
+}
@@ -0,0 +1,93 @@
+/*
+ * domain_diff.h: structural comparison of domain definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "domain_conf.h"
+#include "virenum.h"
+
+typedef enum {
+    /* leave out runtime state, e.g. aliases not set by the user */
+    VIR_DOMAIN_DEF_DIFF_INACTIVE = (1 << 0),
+    /* compare passwords and other secrets */
+    VIR_DOMAIN_DEF_DIFF_SECURE = (1 << 1),
+    /* leave out addresses, aliases, boot order and other data of
+     * <address>, <alias>, <boot>, <rom> and <acpi> of devices */
+    VIR_DOMAIN_DEF_DIFF_NO_DEVICE_INFO = (1 << 2),
+} virDomainDefDiffFlags;
+
+typedef enum {
+    VIR_DOMAIN_DEF_CHANGE_ADDED,
+    VIR_DOMAIN_DEF_CHANGE_REMOVED,
+    VIR_DOMAIN_DEF_CHANGE_MODIFIED,
+
+    VIR_DOMAIN_DEF_CHANGE_LAST
+} virDomainDefChangeType;
+
+VIR_ENUM_DECL(virDomainDefChange);
+
+typedef struct _virDomainDefChange virDomainDefChange;
+struct _virDomainDefChange {
+    virDomainDefChangeType type;
+
+    /* type of the device the change belongs to, VIR_DOMAIN_DEVICE_NONE
+     * for changes outside of <devices> */
+    virDomainDeviceType devtype;
+
+    /* XPath-like location of the changed element or attribute, devices
+     * are identified by their target, MAC address, alias, address or
+     * position, e.g. /domain/devices/disk[target/@dev='vda']/driver/@cache */
+    char *path;
+
+    /* value of an attribute or text node, or XML of an added or removed
+     * device; @oldValue is NULL for added and @newValue for removed items.
+     * Both are NULL for other elements changed as a whole. */
+    char *oldValue;
+    char *newValue;
+
+    /* whether the change concerns a whole element rather than a value */
+    bool element;
+};
+
+typedef struct _virDomainDefDiff virDomainDefDiff;
+struct _virDomainDefDiff {
+    size_t nchanges;
+    virDomainDefChange *changes;
+};
+
+void
+virDomainDefDiffFree(virDomainDefDiff *diff);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virDomainDefDiff, virDomainDefDiffFree);
+
+virDomainDefDiff *
+virDomainDefDiffCompute(virDomainDef *oldDef,
+                        virDomainDef *newDef,
+                        virDomainXMLOption *xmlopt,
+                        unsigned int flags);
+
+virDomainDefDiff *
+virDomainDeviceDefDiffCompute(virDomainDeviceDef *oldDev,
+                              virDomainDeviceDef *newDev,
+                              unsigned int flags);
+
+bool
+virDomainDefDiffHasDeviceChanges(const virDomainDefDiff *diff,
+                                 virDomainDeviceType devtype);
+
+char *
+virDomainDefDiffFormat(const virDomainDefDiff *diff);
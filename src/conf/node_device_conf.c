@@ -36,6 +36,7 @@
 #include "virlog.h"
 #include "virfcp.h"
 #include "virpcivpd.h"
+#include "virfile.h"
 
 #define VIR_FROM_THIS VIR_FROM_NODEDEV
 
@@ -131,6 +132,84 @@ virNodeDeviceDefFree(virNodeDeviceDef *def)
 }
 
 
+/**
+ * virNodeDeviceDefFormatAddress:
+ * @def: node device definition
+ *
+ * Formats the bus address of the device, which is what mediated devices
+ * use to refer to their parent.
+ *
+ * Returns the address, or NULL if the device has none.
+ */
+char *
+virNodeDeviceDefFormatAddress(const virNodeDeviceDef *def)
+{
+    virNodeDevCapsDef *caps = NULL;
+    char *addr = NULL;
+
+    for (caps = def->caps; caps != NULL; caps = caps->next) {
+        switch (caps->data.type) {
+        case VIR_NODE_DEV_CAP_PCI_DEV: {
+            virPCIDeviceAddress pci_addr = {
+                .domain = caps->data.pci_dev.domain,
+                .bus = caps->data.pci_dev.bus,
+                .slot = caps->data.pci_dev.slot,
+                .function = caps->data.pci_dev.function
+            };
+
+            addr = virPCIDeviceAddressAsString(&pci_addr);
+            break;
+            }
+
+        case VIR_NODE_DEV_CAP_CSS_DEV: {
+            virCCWDeviceAddress ccw_addr = {
+                .cssid = caps->data.ccw_dev.cssid,
+                .ssid = caps->data.ccw_dev.ssid,
+                .devno = caps->data.ccw_dev.devno
+            };
+
+            addr = virCCWDeviceAddressAsString(&ccw_addr);
+            break;
+            }
+
+        case VIR_NODE_DEV_CAP_AP_MATRIX:
+            addr = g_strdup(caps->data.ap_matrix.addr);
+            break;
+
+        case VIR_NODE_DEV_CAP_MDEV_TYPES:
+            addr = g_strdup(caps->data.mdev_parent.address);
+            break;
+
+        case VIR_NODE_DEV_CAP_SYSTEM:
+        case VIR_NODE_DEV_CAP_USB_DEV:
+        case VIR_NODE_DEV_CAP_USB_INTERFACE:
+        case VIR_NODE_DEV_CAP_NET:
+        case VIR_NODE_DEV_CAP_SCSI_HOST:
+        case VIR_NODE_DEV_CAP_SCSI_TARGET:
+        case VIR_NODE_DEV_CAP_SCSI:
+        case VIR_NODE_DEV_CAP_STORAGE:
+        case VIR_NODE_DEV_CAP_FC_HOST:
+        case VIR_NODE_DEV_CAP_VPORTS:
+        case VIR_NODE_DEV_CAP_SCSI_GENERIC:
+        case VIR_NODE_DEV_CAP_DRM:
+        case VIR_NODE_DEV_CAP_MDEV:
+        case VIR_NODE_DEV_CAP_CCW_DEV:
+        case VIR_NODE_DEV_CAP_VDPA:
+        case VIR_NODE_DEV_CAP_AP_CARD:
+        case VIR_NODE_DEV_CAP_AP_QUEUE:
+        case VIR_NODE_DEV_CAP_VPD:
+        case VIR_NODE_DEV_CAP_LAST:
+            break;
+        }
+
+        if (addr)
+            break;
+    }
+
+    return addr;
+}
+
+
 static void
 virPCIELinkFormat(virBuffer *buf,
                   virPCIELink *lnk,
@@ -3041,6 +3120,10 @@ virNodeDeviceGetMdevTypesCaps(const char *sysfspath,
 /**
  * virNodeDeviceGetPCIVPDDynamicCap:
  * @devCapPCIDev: a virNodeDevCapPCIDev for which to add VPD resources.
+ * @sysfsPath: sysfs path of the device
+ * @vpdOpen: function to open the VPD with instead of reading it from
+ *           sysfs, or NULL
+ * @opaque: data for @vpdOpen
  *
  * While VPD has a read-only portion, there may be a read-write portion per
  * the specs which may change dynamically.
@@ -3049,7 +3132,10 @@ virNodeDeviceGetMdevTypesCaps(const char *sysfspath,
  * that device since it is optional in the specs, -1 otherwise.
  */
 static int
-virNodeDeviceGetPCIVPDDynamicCap(virNodeDevCapPCIDev *devCapPCIDev)
+virNodeDeviceGetPCIVPDDynamicCap(virNodeDevCapPCIDev *devCapPCIDev,
+                                 const char *sysfsPath,
+                                 virNodeDevicePCIVPDOpenFunc vpdOpen,
+                                 void *opaque)
 {
     g_autoptr(virPCIDevice) pciDev = NULL;
     virPCIDeviceAddress devAddr = { 0 };
@@ -3068,7 +3154,16 @@ virNodeDeviceGetPCIVPDDynamicCap(virNodeDevCapPCIDev *devCapPCIDev)
 
     if (virPCIDeviceHasVPD(pciDev)) {
         /* VPD is optional in PCI(e) specs. If it is there, attempt to add it. */
-        if ((res = virPCIDeviceGetVPD(pciDev))) {
+        if (vpdOpen) {
+            VIR_AUTOCLOSE fd = vpdOpen(sysfsPath, opaque);
+
+            if (fd >= 0)
+                res = virPCIVPDParse(fd);
+        } else {
+            res = virPCIDeviceGetVPD(pciDev);
+        }
+
+        if (res) {
             devCapPCIDev->flags |= VIR_NODE_DEV_CAP_FLAG_PCI_VPD;
             devCapPCIDev->vpd = g_steal_pointer(&res);
         } else {
@@ -3088,6 +3183,26 @@ virNodeDeviceGetPCIVPDDynamicCap(virNodeDevCapPCIDev *devCapPCIDev)
 int
 virNodeDeviceGetPCIDynamicCaps(const char *sysfsPath,
                                virNodeDevCapPCIDev *pci_dev)
+{
+    return virNodeDeviceGetPCIDynamicCapsFull(sysfsPath, pci_dev, NULL, NULL);
+}
+
+
+/**
+ * virNodeDeviceGetPCIDynamicCapsFull:
+ * @sysfsPath: sysfs path of the device
+ * @pci_dev: PCI capability to update
+ * @vpdOpen: function to open the VPD with, or NULL to read it from sysfs
+ * @opaque: data for @vpdOpen
+ *
+ * Like virNodeDeviceGetPCIDynamicCaps(), but allows reading the VPD,
+ * which can be very slow to read from the device, from elsewhere.
+ */
+int
+virNodeDeviceGetPCIDynamicCapsFull(const char *sysfsPath,
+                                   virNodeDevCapPCIDev *pci_dev,
+                                   virNodeDevicePCIVPDOpenFunc vpdOpen,
+                                   void *opaque)
 {
     if (virNodeDeviceGetPCISRIOVCaps(sysfsPath, pci_dev) < 0 ||
         virNodeDeviceGetPCIIOMMUGroupCaps(pci_dev) < 0)
@@ -3101,7 +3216,7 @@ virNodeDeviceGetPCIDynamicCaps(const char *sysfsPath,
     if (pci_dev->nmdev_types > 0)
         pci_dev->flags |= VIR_NODE_DEV_CAP_FLAG_PCI_MDEV;
 
-    if (virNodeDeviceGetPCIVPDDynamicCap(pci_dev) < 0)
+    if (virNodeDeviceGetPCIVPDDynamicCap(pci_dev, sysfsPath, vpdOpen, opaque) < 0)
         return -1;
 
     return 0;
@@ -3183,6 +3298,15 @@ virNodeDeviceGetPCIDynamicCaps(const char *sysfsPath G_GNUC_UNUSED,
     return -1;
 }
 
+int
+virNodeDeviceGetPCIDynamicCapsFull(const char *sysfsPath G_GNUC_UNUSED,
+                                   virNodeDevCapPCIDev *pci_dev G_GNUC_UNUSED,
+                                   virNodeDevicePCIVPDOpenFunc vpdOpen G_GNUC_UNUSED,
+                                   void *opaque G_GNUC_UNUSED)
+{
+    return -1;
+}
+
 
 int virNodeDeviceGetSCSITargetCaps(const char *sysfsPath G_GNUC_UNUSED,
                                    virNodeDevCapSCSITarget *scsi_target G_GNUC_UNUSED)
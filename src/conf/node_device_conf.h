@@ -399,6 +399,9 @@ virNodeDeviceDefFree(virNodeDeviceDef *def);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virNodeDeviceDef, virNodeDeviceDefFree);
 
+char *
+virNodeDeviceDefFormatAddress(const virNodeDeviceDef *def);
+
 void
 virNodeDevCapsDefFree(virNodeDevCapsDef *caps);
 
@@ -452,6 +455,17 @@ int
 virNodeDeviceGetPCIDynamicCaps(const char *sysfsPath,
                                virNodeDevCapPCIDev *pci_dev);
 
+/* Returns a file descriptor to read the VPD of the PCI device at
+ * @sysfsPath from, or -1 with an error reported */
+typedef int (*virNodeDevicePCIVPDOpenFunc)(const char *sysfsPath,
+                                           void *opaque);
+
+int
+virNodeDeviceGetPCIDynamicCapsFull(const char *sysfsPath,
+                                   virNodeDevCapPCIDev *pci_dev,
+                                   virNodeDevicePCIVPDOpenFunc vpdOpen,
+                                   void *opaque);
+
 int
 virNodeDeviceGetCSSDynamicCaps(const char *sysfsPath,
                                virNodeDevCapCCW *ccw_dev);
@@ -1215,6 +1215,48 @@ virDomainNumaNew(void)
 }
 
 
+
+/**
+ * virDomainNumaCopy:
+ * @src: NUMA definition to copy
+ *
+ * Returns a deep copy of @src.
+ */
+virDomainNuma *
+virDomainNumaCopy(const virDomainNuma *src)
+{
+    virDomainNuma *ret = virDomainNumaNew();
+    size_t i;
+
+    *ret = *src;
+
+    if (src->memory.nodeset)
+        ret->memory.nodeset = virBitmapNewCopy(src->memory.nodeset);
+
+    ret->mem_nodes = g_new0(struct _virDomainNumaNode, src->nmem_nodes);
+    for (i = 0; i < src->nmem_nodes; i++) {
+        struct _virDomainNumaNode *dst = &ret->mem_nodes[i];
+        const struct _virDomainNumaNode *node = &src->mem_nodes[i];
+
+        *dst = *node;
+
+        if (node->cpumask)
+            dst->cpumask = virBitmapNewCopy(node->cpumask);
+        if (node->nodeset)
+            dst->nodeset = virBitmapNewCopy(node->nodeset);
+
+        dst->distances = g_memdup(node->distances,
+                                  node->ndistances * sizeof(*node->distances));
+        dst->caches = g_memdup(node->caches,
+                               node->ncaches * sizeof(*node->caches));
+    }
+
+    ret->interconnects = g_memdup(src->interconnects,
+                                  src->ninterconnects * sizeof(*src->interconnects));
+
+    return ret;
+}
+
 bool
 virDomainNumaCheckABIStability(virDomainNuma *src,
                                virDomainNuma *tgt)
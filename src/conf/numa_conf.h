@@ -85,6 +85,7 @@ VIR_ENUM_DECL(virMemoryLatency);
 
 
 virDomainNuma *virDomainNumaNew(void);
+virDomainNuma *virDomainNumaCopy(const virDomainNuma *src);
 void virDomainNumaFree(virDomainNuma *numa);
 
 /*
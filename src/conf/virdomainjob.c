@@ -620,6 +620,11 @@ virDomainObjEndJob(virDomainObj *obj)
     if (virDomainTrackJob(job) && obj->job->cb &&
         obj->job->cb->saveStatusPrivate)
         obj->job->cb->saveStatusPrivate(obj);
+
+    /* query jobs don't change the domain, the current view stays valid */
+    if (job != VIR_JOB_QUERY)
+        virDomainObjPublishView(obj);
+
     /* We indeed need to wake up ALL threads waiting because
      * grabbing a job requires checking more variables. */
     virCondBroadcast(&obj->job->cond);
@@ -655,5 +660,6 @@ virDomainObjEndAsyncJob(virDomainObj *obj)
     virDomainObjResetAsyncJob(obj->job);
     if (obj->job->cb && obj->job->cb->saveStatusPrivate)
         obj->job->cb->saveStatusPrivate(obj);
+    virDomainObjPublishView(obj);
     virCondBroadcast(&obj->job->asyncCond);
 }
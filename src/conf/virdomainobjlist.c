@@ -167,6 +167,37 @@ virDomainObjListFindByUUID(virDomainObjList *doms,
 }
 
 
+/**
+ * @doms: Domain object list
+ * @uuid: UUID to search the doms->objs table
+ *
+ * Lookup the @uuid in the doms->objs hash table and return a ref counted
+ * read-only view of the domain object without locking it, see
+ * virDomainObjGetView. Returns NULL without reporting an error if the
+ * domain doesn't exist or has no view published; the caller is expected
+ * to fall back to virDomainObjListFindByUUID, which reports the error.
+ */
+virDomainObjView *
+virDomainObjListFindViewByUUID(virDomainObjList *doms,
+                               const unsigned char *uuid)
+{
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    g_autoptr(virDomainObj) obj = NULL;
+
+    virUUIDFormat(uuid, uuidstr);
+
+    virObjectRWLockRead(doms);
+    if ((obj = virHashLookup(doms->objs, uuidstr)))
+        virObjectRef(obj);
+    virObjectRWUnlock(doms);
+
+    if (!obj)
+        return NULL;
+
+    return virDomainObjGetView(obj);
+}
+
+
 static virDomainObj *
 virDomainObjListFindByNameLocked(virDomainObjList *doms,
                                  const char *name)
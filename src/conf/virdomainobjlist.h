@@ -35,6 +35,9 @@ virDomainObjListFindByID(virDomainObjList *doms,
 virDomainObj *
 virDomainObjListFindByUUID(virDomainObjList *doms,
                            const unsigned char *uuid);
+virDomainObjView *
+virDomainObjListFindViewByUUID(virDomainObjList *doms,
+                               const unsigned char *uuid);
 virDomainObj *
 virDomainObjListFindByName(virDomainObjList *doms,
                            const char *name);
@@ -64,7 +64,13 @@ struct _virNetworkObj {
 struct _virNetworkObjList {
     virObjectRWLockable parent;
 
+    /* uuid string -> virNetworkObj mapping
+     * for O(1), lookup-by-uuid */
     GHashTable *objs;
+
+    /* name string -> virNetworkObj mapping
+     * for O(1), lookup-by-name */
+    GHashTable *objsName;
 };
 
 static virClass *virNetworkObjClass;
@@ -320,6 +326,7 @@ virNetworkObjListNew(void)
         return NULL;
 
     nets->objs = virHashNew(virObjectUnref);
+    nets->objsName = virHashNew(virObjectUnref);
 
     return nets;
 }
@@ -366,32 +373,11 @@ virNetworkObjFindByUUID(virNetworkObjList *nets,
 }
 
 
-static int
-virNetworkObjSearchName(const void *payload,
-                        const char *name G_GNUC_UNUSED,
-                        const void *data)
-{
-    virNetworkObj *obj = (virNetworkObj *) payload;
-    int want = 0;
-
-    virObjectLock(obj);
-    if (STREQ(obj->def->name, (const char *)data))
-        want = 1;
-    virObjectUnlock(obj);
-    return want;
-}
-
-
 static virNetworkObj *
 virNetworkObjFindByNameLocked(virNetworkObjList *nets,
                               const char *name)
 {
-    virNetworkObj *obj = NULL;
-
-    obj = virHashSearch(nets->objs, virNetworkObjSearchName, name, NULL);
-    if (obj)
-        virObjectRef(obj);
-    return obj;
+    return virObjectRef(virHashLookup(nets->objsName, name));
 }
 
 
@@ -453,6 +439,7 @@ virNetworkObjListDispose(void *opaque)
     virNetworkObjList *nets = opaque;
 
     g_clear_pointer(&nets->objs, g_hash_table_unref);
+    g_clear_pointer(&nets->objsName, g_hash_table_unref);
 }
 
 
@@ -580,6 +567,12 @@ virNetworkObjAssignDefLocked(virNetworkObjList *nets,
             goto cleanup;
         virObjectRef(obj);
 
+        if (virHashAddEntry(nets->objsName, def->name, obj) < 0) {
+            virHashRemoveEntry(nets->objs, uuidstr);
+            goto cleanup;
+        }
+        virObjectRef(obj);
+
         obj->def = def;
         obj->persistent = !(flags & VIR_NETWORK_OBJ_LIST_ADD_LIVE);
     }
@@ -760,6 +753,7 @@ virNetworkObjRemoveInactive(virNetworkObjList *nets,
     virObjectRWLockWrite(nets);
     virObjectLock(obj);
     virHashRemoveEntry(nets->objs, uuidstr);
+    virHashRemoveEntry(nets->objsName, obj->def->name);
     virObjectRWUnlock(nets);
     virObjectUnref(obj);
 }
@@ -1497,6 +1491,7 @@ virNetworkObjListNumOfNetworks(virNetworkObjList *nets,
 
 
 struct virNetworkObjListPruneHelperData {
+    virNetworkObjList *nets;
     unsigned int flags;
 };
 
@@ -1511,6 +1506,8 @@ virNetworkObjListPruneHelper(const void *payload,
 
     virObjectLock(obj);
     want = virNetworkObjMatch(obj, data->flags);
+    if (want)
+        virHashRemoveEntry(data->nets->objsName, obj->def->name);
     virObjectUnlock(obj);
     return want;
 }
@@ -1528,7 +1525,7 @@ void
 virNetworkObjListPrune(virNetworkObjList *nets,
                        unsigned int flags)
 {
-    struct virNetworkObjListPruneHelperData data = {flags};
+    struct virNetworkObjListPruneHelperData data = {nets, flags};
 
     virObjectRWLockWrite(nets);
     virHashRemoveSet(nets->objs, virNetworkObjListPruneHelper, &data);
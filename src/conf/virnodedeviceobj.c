@@ -41,6 +41,13 @@ struct _virNodeDeviceObj {
     bool active;
     bool persistent;
     bool autostart;
+
+    /* keys this object is filed under in the secondary indexes of the
+     * list, protected by the list lock */
+    char *indexSysfsPath;
+    char *indexWWNs;
+    char *indexMdevUUID;
+    char *indexAddress;
 };
 
 struct _virNodeDeviceObjList {
@@ -50,6 +57,19 @@ struct _virNodeDeviceObjList {
      * for O(1), lookup-by-name */
     GHashTable *objs;
 
+    /* Secondary indexes, see virHashMultiNew(). They are updated
+     * whenever a definition is assigned, but as definitions may still
+     * be modified in place lookups must check the candidates they
+     * yield against the definition.
+     *
+     * sysfs path -> virNodeDeviceObj */
+    GHashTable *sysfsPaths;
+    /* "wwnn:wwpn" of SCSI hosts -> virNodeDeviceObj */
+    GHashTable *wwns;
+    /* mdev UUID -> virNodeDeviceObj */
+    GHashTable *mdevUUIDs;
+    /* bus address, which mdevs refer to their parent by -> virNodeDeviceObj */
+    GHashTable *addresses;
 };
 
 
@@ -79,6 +99,10 @@ virNodeDeviceObjDispose(void *opaque)
     virNodeDeviceObj *obj = opaque;
 
     virNodeDeviceDefFree(obj->def);
+    g_free(obj->indexSysfsPath);
+    g_free(obj->indexWWNs);
+    g_free(obj->indexMdevUUID);
+    g_free(obj->indexAddress);
 }
 
 
@@ -197,6 +221,102 @@ virNodeDeviceObjListSearch(virNodeDeviceObjList *devs,
 }
 
 
+/*
+ * Like virNodeDeviceObjListSearch(), but @callback is only tried on
+ * the objects filed under @key in @index. If @fallback is true and none
+ * of them matches, all objects are searched.
+ */
+static virNodeDeviceObj *
+virNodeDeviceObjListSearchIndex(virNodeDeviceObjList *devs,
+                                GHashTable *index,
+                                const char *key,
+                                virHashSearcher callback,
+                                const void *data,
+                                bool fallback)
+{
+    virNodeDeviceObj *obj = NULL;
+    GPtrArray *candidates;
+    size_t i;
+
+    virObjectRWLockRead(devs);
+
+    if ((candidates = virHashMultiLookup(index, key))) {
+        for (i = 0; i < candidates->len; i++) {
+            virNodeDeviceObj *candidate = g_ptr_array_index(candidates, i);
+
+            if (callback(candidate, NULL, data)) {
+                obj = virObjectRef(candidate);
+                break;
+            }
+        }
+    }
+
+    if (!obj && fallback)
+        obj = virObjectRef(virHashSearch(devs->objs, callback, data, NULL));
+
+    virObjectRWUnlock(devs);
+
+    if (obj)
+        virObjectLock(obj);
+
+    return obj;
+}
+
+
+static char *
+virNodeDeviceObjWWNsKey(const char *wwnn,
+                        const char *wwpn)
+{
+    if (!wwnn || !wwpn)
+        return NULL;
+
+    return g_strdup_printf("%s:%s", wwnn, wwpn);
+}
+
+
+/* The caller must hold the write lock on @devs and the lock on @obj */
+static void
+virNodeDeviceObjListIndex(virNodeDeviceObjList *devs,
+                          virNodeDeviceObj *obj)
+{
+    virNodeDevCapsDef *cap;
+
+    obj->indexSysfsPath = g_strdup(obj->def->sysfs_path);
+
+    for (cap = obj->def->caps; cap; cap = cap->next) {
+        if (cap->data.type == VIR_NODE_DEV_CAP_SCSI_HOST && !obj->indexWWNs)
+            obj->indexWWNs = virNodeDeviceObjWWNsKey(cap->data.scsi_host.wwnn,
+                                                     cap->data.scsi_host.wwpn);
+        else if (cap->data.type == VIR_NODE_DEV_CAP_MDEV && !obj->indexMdevUUID)
+            obj->indexMdevUUID = g_strdup(cap->data.mdev.uuid);
+    }
+
+    obj->indexAddress = virNodeDeviceDefFormatAddress(obj->def);
+
+    virHashMultiAdd(devs->sysfsPaths, obj->indexSysfsPath, obj);
+    virHashMultiAdd(devs->wwns, obj->indexWWNs, obj);
+    virHashMultiAdd(devs->mdevUUIDs, obj->indexMdevUUID, obj);
+    virHashMultiAdd(devs->addresses, obj->indexAddress, obj);
+}
+
+
+/* The caller must hold the write lock on @devs */
+static void
+virNodeDeviceObjListUnindex(virNodeDeviceObjList *devs,
+                            virNodeDeviceObj *obj)
+{
+    virHashMultiRemove(devs->sysfsPaths, obj->indexSysfsPath, obj);
+    virHashMultiRemove(devs->wwns, obj->indexWWNs, obj);
+    virHashMultiRemove(devs->mdevUUIDs, obj->indexMdevUUID, obj);
+    virHashMultiRemove(devs->addresses, obj->indexAddress, obj);
+
+    g_clear_pointer(&obj->indexSysfsPath, g_free);
+    g_clear_pointer(&obj->indexWWNs, g_free);
+    g_clear_pointer(&obj->indexMdevUUID, g_free);
+    g_clear_pointer(&obj->indexAddress, g_free);
+}
+
+
 static int
 virNodeDeviceObjListFindBySysfsPathCallback(const void *payload,
                                             const char *name G_GNUC_UNUSED,
@@ -219,9 +339,9 @@ virNodeDeviceObj *
 virNodeDeviceObjListFindBySysfsPath(virNodeDeviceObjList *devs,
                                     const char *sysfs_path)
 {
-    return virNodeDeviceObjListSearch(devs,
-                                      virNodeDeviceObjListFindBySysfsPathCallback,
-                                      sysfs_path);
+    return virNodeDeviceObjListSearchIndex(devs, devs->sysfsPaths, sysfs_path,
+                                           virNodeDeviceObjListFindBySysfsPathCallback,
+                                           sysfs_path, false);
 }
 
 
@@ -283,10 +403,14 @@ virNodeDeviceObjListFindByWWNs(virNodeDeviceObjList *devs,
 {
     struct virNodeDeviceObjListFindByWWNsData data = {
         .parent_wwnn = parent_wwnn, .parent_wwpn = parent_wwpn };
-
-    return virNodeDeviceObjListSearch(devs,
-                                      virNodeDeviceObjListFindByWWNsCallback,
-                                      &data);
+    g_autofree char *key = virNodeDeviceObjWWNsKey(parent_wwnn, parent_wwpn);
+
+    /* The WWNs of SCSI hosts are refreshed in place by
+     * virNodeDeviceUpdateCaps(), a host which didn't report them when it
+     * was added is only found by the full scan. */
+    return virNodeDeviceObjListSearchIndex(devs, devs->wwns, key,
+                                           virNodeDeviceObjListFindByWWNsCallback,
+                                           &data, true);
 }
 
 
@@ -393,10 +517,13 @@ virNodeDeviceObjListFindSCSIHostByWWNs(virNodeDeviceObjList *devs,
 {
     struct virNodeDeviceObjListFindSCSIHostByWWNsData data = {
         .wwnn = wwnn, .wwpn = wwpn };
+    g_autofree char *key = virNodeDeviceObjWWNsKey(wwnn, wwpn);
 
-    return virNodeDeviceObjListSearch(devs,
-                                      virNodeDeviceObjListFindSCSIHostByWWNsCallback,
-                                      &data);
+    /* This lookup refreshes the SCSI host capabilities, a host which
+     * didn't report its WWNs when it was added may match only now. */
+    return virNodeDeviceObjListSearchIndex(devs, devs->wwns, key,
+                                           virNodeDeviceObjListFindSCSIHostByWWNsCallback,
+                                           &data, true);
 }
 
 
@@ -440,9 +567,43 @@ virNodeDeviceObjListFindMediatedDeviceByUUID(virNodeDeviceObjList *devs,
                                              const char *parent_addr)
 {
     const FindMediatedDeviceData data = {uuid, parent_addr};
-    return virNodeDeviceObjListSearch(devs,
-                                      virNodeDeviceObjListFindMediatedDeviceByUUIDCallback,
-                                      &data);
+    return virNodeDeviceObjListSearchIndex(devs, devs->mdevUUIDs, uuid,
+                                           virNodeDeviceObjListFindMediatedDeviceByUUIDCallback,
+                                           &data, false);
+}
+
+
+static int
+virNodeDeviceObjListFindByAddressCallback(const void *payload,
+                                          const char *name G_GNUC_UNUSED,
+                                          const void *opaque)
+{
+    virNodeDeviceObj *obj = (virNodeDeviceObj *) payload;
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+    g_autofree char *addr = virNodeDeviceDefFormatAddress(obj->def);
+
+    return STREQ_NULLABLE(addr, opaque);
+}
+
+
+/**
+ * virNodeDeviceObjListFindByAddress:
+ * @devs: Pointer to object list
+ * @addr: bus address as formatted by virNodeDeviceDefFormatAddress()
+ *
+ * Looks up the device mediated devices refer to as their parent by @addr.
+ *
+ * Returns the locked and ref'd object, or NULL if there is none.
+ */
+virNodeDeviceObj *
+virNodeDeviceObjListFindByAddress(virNodeDeviceObjList *devs,
+                                  const char *addr)
+{
+    /* The bus address of a device doesn't change, mdevs of parents which
+     * are not present are common, so there's no full scan fallback */
+    return virNodeDeviceObjListSearchIndex(devs, devs->addresses, addr,
+                                           virNodeDeviceObjListFindByAddressCallback,
+                                           addr, false);
 }
 
 static void
@@ -450,6 +611,10 @@ virNodeDeviceObjListDispose(void *obj)
 {
     virNodeDeviceObjList *devs = obj;
 
+    g_clear_pointer(&devs->sysfsPaths, g_hash_table_unref);
+    g_clear_pointer(&devs->wwns, g_hash_table_unref);
+    g_clear_pointer(&devs->mdevUUIDs, g_hash_table_unref);
+    g_clear_pointer(&devs->addresses, g_hash_table_unref);
     g_clear_pointer(&devs->objs, g_hash_table_unref);
 }
 
@@ -466,6 +631,10 @@ virNodeDeviceObjListNew(void)
         return NULL;
 
     devs->objs = virHashNew(virObjectUnref);
+    devs->sysfsPaths = virHashMultiNew();
+    devs->wwns = virHashMultiNew();
+    devs->mdevUUIDs = virHashMultiNew();
+    devs->addresses = virHashMultiNew();
 
     return devs;
 }
@@ -488,6 +657,7 @@ virNodeDeviceObjListAssignDef(virNodeDeviceObjList *devs,
 
     if ((obj = virNodeDeviceObjListFindByNameLocked(devs, def->name))) {
         virObjectLock(obj);
+        virNodeDeviceObjListUnindex(devs, obj);
         virNodeDeviceDefFree(obj->def);
         obj->def = def;
     } else {
@@ -503,6 +673,8 @@ virNodeDeviceObjListAssignDef(virNodeDeviceObjList *devs,
         virObjectRef(obj);
     }
 
+    virNodeDeviceObjListIndex(devs, obj);
+
  cleanup:
     virObjectRWUnlock(devs);
     return obj;
@@ -531,6 +703,7 @@ void
 virNodeDeviceObjListRemoveLocked(virNodeDeviceObjList *devs,
                                  virNodeDeviceObj *dev)
 {
+    virNodeDeviceObjListUnindex(devs, dev);
     virHashRemoveEntry(devs->objs, dev->def->name);
 }
 
@@ -1060,6 +1233,7 @@ virNodeDeviceObjSetAutostart(virNodeDeviceObj *obj,
 
 typedef struct _PredicateHelperData PredicateHelperData;
 struct _PredicateHelperData {
+    virNodeDeviceObjList *devs;
     virNodeDeviceObjListPredicate predicate;
     void *opaque;
 };
@@ -1070,7 +1244,11 @@ static int virNodeDeviceObjListRemoveHelper(void *key G_GNUC_UNUSED,
 {
     PredicateHelperData *data = opaque;
 
-    return data->predicate(value, data->opaque);
+    if (!data->predicate(value, data->opaque))
+        return 0;
+
+    virNodeDeviceObjListUnindex(data->devs, value);
+    return 1;
 }
 
 
@@ -1090,6 +1268,7 @@ virNodeDeviceObjListForEachRemove(virNodeDeviceObjList *devs,
                                   void *opaque)
 {
     PredicateHelperData data = {
+        .devs = devs,
         .predicate = callback,
         .opaque = opaque
     };
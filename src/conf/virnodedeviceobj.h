@@ -129,6 +129,10 @@ virNodeDeviceObjListFindMediatedDeviceByUUID(virNodeDeviceObjList *devs,
                                              const char *uuid,
                                              const char *parent_addr);
 
+virNodeDeviceObj *
+virNodeDeviceObjListFindByAddress(virNodeDeviceObjList *devs,
+                                  const char *addr);
+
 bool
 virNodeDeviceObjIsActive(virNodeDeviceObj *obj);
 
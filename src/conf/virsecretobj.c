@@ -43,6 +43,7 @@ struct _virSecretObj {
     virSecretDef *def;
     unsigned char *value;       /* May be NULL */
     size_t value_size;
+    char *indexUsageID;         /* key in virSecretObjList.usageIDs */
 };
 
 static virClass *virSecretObjClass;
@@ -56,6 +57,10 @@ struct _virSecretObjList {
     /* uuid string -> virSecretObj  mapping
      * for O(1), lookup-by-uuid */
     GHashTable *objs;
+
+    /* usage id string -> virSecretObj mapping, see virHashMultiNew().
+     * The usage id of a secret can't change once it's been added. */
+    GHashTable *usageIDs;
 };
 
 struct virSecretSearchData {
@@ -123,6 +128,8 @@ virSecretObjListNew(void)
         return NULL;
     }
 
+    secrets->usageIDs = virHashMultiNew();
+
     return secrets;
 }
 
@@ -140,6 +147,7 @@ virSecretObjDispose(void *opaque)
     }
     g_free(obj->configFile);
     g_free(obj->base64File);
+    g_free(obj->indexUsageID);
 }
 
 
@@ -148,6 +156,7 @@ virSecretObjListDispose(void *obj)
 {
     virSecretObjList *secrets = obj;
 
+    g_clear_pointer(&secrets->usageIDs, g_hash_table_unref);
     g_clear_pointer(&secrets->objs, g_hash_table_unref);
 }
 
@@ -235,14 +244,22 @@ virSecretObjListFindByUsageLocked(virSecretObjList *secrets,
                                   int usageType,
                                   const char *usageID)
 {
-    virSecretObj *obj = NULL;
     struct virSecretSearchData data = { .usageType = usageType,
                                         .usageID = usageID };
+    GPtrArray *candidates;
+    size_t i;
 
-    obj = virHashSearch(secrets->objs, virSecretObjSearchName, &data, NULL);
-    if (obj)
-        virObjectRef(obj);
-    return obj;
+    if (!(candidates = virHashMultiLookup(secrets->usageIDs, usageID)))
+        return NULL;
+
+    for (i = 0; i < candidates->len; i++) {
+        virSecretObj *obj = g_ptr_array_index(candidates, i);
+
+        if (virSecretObjSearchName(obj, NULL, &data))
+            return virObjectRef(obj);
+    }
+
+    return NULL;
 }
 
 
@@ -299,6 +316,7 @@ virSecretObjListRemove(virSecretObjList *secrets,
 
     virObjectRWLockWrite(secrets);
     virObjectLock(obj);
+    virHashMultiRemove(secrets->usageIDs, obj->indexUsageID, obj);
     virHashRemoveEntry(secrets->objs, uuidstr);
     virSecretObjEndAPI(&obj);
     virObjectRWUnlock(secrets);
@@ -389,6 +407,8 @@ virSecretObjListAdd(virSecretObjList *secrets,
             goto cleanup;
 
         obj->def = g_steal_pointer(newdef);
+        obj->indexUsageID = g_strdup(obj->def->usage_id);
+        virHashMultiAdd(secrets->usageIDs, obj->indexUsageID, obj);
         virObjectRef(obj);
     }
 
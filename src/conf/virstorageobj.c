@@ -90,6 +90,11 @@ struct _virStoragePoolObj {
     virStoragePoolDef *def;
     virStoragePoolDef *newDef;
 
+    /* target paths of @def and @newDef this object is filed under in
+     * virStoragePoolObjList.targetPaths, protected by the list lock */
+    char *indexTargetPath;
+    char *indexNewTargetPath;
+
     virStorageVolObjList *volumes;
 };
 
@@ -103,6 +108,12 @@ struct _virStoragePoolObjList {
     /* name string -> virStoragePoolObj mapping
      * for (1), lookup-by-name */
     GHashTable *objsName;
+
+    /* target path string -> virStoragePoolObj mapping, see
+     * virHashMultiNew(). Both the current and the next definition
+     * of a pool are indexed, as the latter replaces the former
+     * without the list being locked. */
+    GHashTable *targetPaths;
 };
 
 
@@ -354,6 +365,8 @@ virStoragePoolObjDispose(void *opaque)
 
     g_free(obj->configFile);
     g_free(obj->autostartLink);
+    g_free(obj->indexTargetPath);
+    g_free(obj->indexNewTargetPath);
 }
 
 
@@ -364,6 +377,7 @@ virStoragePoolObjListDispose(void *opaque)
 
     g_clear_pointer(&pools->objs, g_hash_table_unref);
     g_clear_pointer(&pools->objsName, g_hash_table_unref);
+    g_clear_pointer(&pools->targetPaths, g_hash_table_unref);
 }
 
 
@@ -380,6 +394,7 @@ virStoragePoolObjListNew(void)
 
     pools->objs = virHashNew(virObjectUnref);
     pools->objsName = virHashNew(virObjectUnref);
+    pools->targetPaths = virHashMultiNew();
 
     return pools;
 }
@@ -497,6 +512,75 @@ virStoragePoolObjListSearch(virStoragePoolObjList *pools,
 }
 
 
+/* The caller must hold the write lock on @pools and the lock on @obj */
+static void
+virStoragePoolObjListIndex(virStoragePoolObjList *pools,
+                           virStoragePoolObj *obj)
+{
+    if (obj->def)
+        obj->indexTargetPath = g_strdup(obj->def->target.path);
+    if (obj->newDef)
+        obj->indexNewTargetPath = g_strdup(obj->newDef->target.path);
+
+    virHashMultiAdd(pools->targetPaths, obj->indexTargetPath, obj);
+    if (STRNEQ_NULLABLE(obj->indexTargetPath, obj->indexNewTargetPath))
+        virHashMultiAdd(pools->targetPaths, obj->indexNewTargetPath, obj);
+}
+
+
+/* The caller must hold the write lock on @pools */
+static void
+virStoragePoolObjListUnindex(virStoragePoolObjList *pools,
+                             virStoragePoolObj *obj)
+{
+    virHashMultiRemove(pools->targetPaths, obj->indexTargetPath, obj);
+    if (STRNEQ_NULLABLE(obj->indexTargetPath, obj->indexNewTargetPath))
+        virHashMultiRemove(pools->targetPaths, obj->indexNewTargetPath, obj);
+
+    g_clear_pointer(&obj->indexTargetPath, g_free);
+    g_clear_pointer(&obj->indexNewTargetPath, g_free);
+}
+
+
+/**
+ * virStoragePoolObjListFindByTargetPath
+ * @pools: Pointer to pools object
+ * @path: sanitized target path
+ *
+ * Find the active pool whose target path is @path.
+ *
+ * Returns a locked and reffed object when found and NULL when not found
+ */
+virStoragePoolObj *
+virStoragePoolObjListFindByTargetPath(virStoragePoolObjList *pools,
+                                      const char *path)
+{
+    virStoragePoolObj *obj = NULL;
+    GPtrArray *candidates;
+    size_t i;
+
+    virObjectRWLockRead(pools);
+
+    if ((candidates = virHashMultiLookup(pools->targetPaths, path))) {
+        for (i = 0; i < candidates->len; i++) {
+            virStoragePoolObj *candidate = g_ptr_array_index(candidates, i);
+
+            virObjectLock(candidate);
+            if (virStoragePoolObjIsActive(candidate) &&
+                STREQ_NULLABLE(candidate->def->target.path, path)) {
+                obj = virObjectRef(candidate);
+                break;
+            }
+            virObjectUnlock(candidate);
+        }
+    }
+
+    virObjectRWUnlock(pools);
+
+    return obj;
+}
+
+
 void
 virStoragePoolObjRemove(virStoragePoolObjList *pools,
                         virStoragePoolObj *obj)
@@ -508,6 +592,7 @@ virStoragePoolObjRemove(virStoragePoolObjList *pools,
     virObjectUnlock(obj);
     virObjectRWLockWrite(pools);
     virObjectLock(obj);
+    virStoragePoolObjListUnindex(pools, obj);
     g_hash_table_remove(pools->objs, uuidstr);
     g_hash_table_remove(pools->objsName, obj->def->name);
     virObjectUnref(obj);
@@ -1534,7 +1619,9 @@ virStoragePoolObjListAdd(virStoragePoolObjList *pools,
     if (rc < 0)
         goto error;
     if (rc > 0) {
+        virStoragePoolObjListUnindex(pools, obj);
         virStoragePoolObjAssignDef(obj, def, flags);
+        virStoragePoolObjListIndex(pools, obj);
         virObjectRWUnlock(pools);
         return obj;
     }
@@ -1556,6 +1643,7 @@ virStoragePoolObjListAdd(virStoragePoolObjList *pools,
     virObjectRef(obj);
 
     obj->def = g_steal_pointer(def);
+    virStoragePoolObjListIndex(pools, obj);
     virObjectRWUnlock(pools);
     return obj;
 
@@ -250,6 +250,10 @@ virStoragePoolObjListSearch(virStoragePoolObjList *pools,
                             virStoragePoolObjListSearcher searcher,
                             const void *opaque);
 
+virStoragePoolObj *
+virStoragePoolObjListFindByTargetPath(virStoragePoolObjList *pools,
+                                      const char *path);
+
 virStoragePoolObjList *
 virStoragePoolObjListNew(void);
 
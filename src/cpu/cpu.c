@@ -552,6 +552,248 @@ virCPUBaseline(virArch arch,
 }
 
 
+struct _virCPUBaselineState {
+    struct cpuArchDriver *driver;
+    virArch arch;
+    size_t ncpus;
+    void *data;
+};
+
+
+/**
+ * virCPUBaselineStateNew:
+ *
+ * @arch: CPU architecture
+ *
+ * Creates a new state for computing a baseline CPU incrementally. Host CPU
+ * definitions can be added to (and removed from) the state at any time using
+ * virCPUBaselineStateAdd (and virCPUBaselineStateRemove) without having to
+ * process all the other CPUs again. The baseline CPU of all CPUs currently
+ * stored in the state is computed by virCPUBaselineStateCompute.
+ *
+ * Returns the new state or NULL on error.
+ */
+virCPUBaselineState *
+virCPUBaselineStateNew(virArch arch)
+{
+    g_autoptr(virCPUBaselineState) state = NULL;
+    struct cpuArchDriver *driver;
+
+    VIR_DEBUG("arch=%s", virArchToString(arch));
+
+    if (!(driver = cpuGetSubDriver(arch)))
+        return NULL;
+
+    if (!driver->baselineStateNew) {
+        virReportError(VIR_ERR_NO_SUPPORT,
+                       _("cannot compute incremental baseline CPU of %1$s architecture"),
+                       virArchToString(arch));
+        return NULL;
+    }
+
+    state = g_new0(virCPUBaselineState, 1);
+    state->driver = driver;
+    state->arch = arch;
+
+    if (!(state->data = driver->baselineStateNew()))
+        return NULL;
+
+    return g_steal_pointer(&state);
+}
+
+
+void
+virCPUBaselineStateFree(virCPUBaselineState *state)
+{
+    if (!state)
+        return;
+
+    if (state->data)
+        state->driver->baselineStateFree(state->data);
+    g_free(state);
+}
+
+
+static int
+virCPUBaselineStateCheckCPUs(virCPUBaselineState *state,
+                             virCPUDef **cpus,
+                             unsigned int ncpus)
+{
+    size_t i;
+
+    if (!cpus && ncpus != 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       "%s", _("nonzero ncpus doesn't match with NULL cpus"));
+        return -1;
+    }
+
+    for (i = 0; i < ncpus; i++) {
+        if (!cpus[i]) {
+            virReportError(VIR_ERR_INVALID_ARG,
+                           _("invalid CPU definition at index %1$zu"), i);
+            return -1;
+        }
+        if (!cpus[i]->model) {
+            virReportError(VIR_ERR_INVALID_ARG,
+                           _("no CPU model specified at index %1$zu"), i);
+            return -1;
+        }
+        if (cpus[i]->arch != VIR_ARCH_NONE && cpus[i]->arch != state->arch) {
+            virReportError(VIR_ERR_INVALID_ARG,
+                           _("CPU architecture %1$s at index %2$zu does not match %3$s"),
+                           virArchToString(cpus[i]->arch), i,
+                           virArchToString(state->arch));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * virCPUBaselineStateAdd:
+ *
+ * @state: baseline state
+ * @cpus: list of host CPU definitions
+ * @ncpus: number of CPUs in @cpus
+ *
+ * Adds all @cpus to the baseline @state. Either all CPUs are added or
+ * none of them in case of an error.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virCPUBaselineStateAdd(virCPUBaselineState *state,
+                       virCPUDef **cpus,
+                       unsigned int ncpus)
+{
+    size_t i;
+
+    VIR_DEBUG("state=%p, cpus=%p, ncpus=%u", state, cpus, ncpus);
+
+    if (virCPUBaselineStateCheckCPUs(state, cpus, ncpus) < 0)
+        return -1;
+
+    for (i = 0; i < ncpus; i++) {
+        if (state->driver->baselineStateUpdate(state->data, cpus[i], true) < 0) {
+            virErrorPtr orig_err;
+
+            virErrorPreserveLast(&orig_err);
+            while (i-- > 0) {
+                ignore_value(state->driver->baselineStateUpdate(state->data,
+                                                                cpus[i], false));
+                state->ncpus--;
+            }
+            virErrorRestore(&orig_err);
+            return -1;
+        }
+        state->ncpus++;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virCPUBaselineStateRemove:
+ *
+ * @state: baseline state
+ * @cpus: list of host CPU definitions
+ * @ncpus: number of CPUs in @cpus
+ *
+ * Removes all @cpus from the baseline @state. Each of the CPU definitions
+ * has to be identical to a CPU previously added by virCPUBaselineStateAdd.
+ * Either all CPUs are removed or none of them in case of an error.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virCPUBaselineStateRemove(virCPUBaselineState *state,
+                          virCPUDef **cpus,
+                          unsigned int ncpus)
+{
+    size_t i;
+
+    VIR_DEBUG("state=%p, cpus=%p, ncpus=%u", state, cpus, ncpus);
+
+    if (virCPUBaselineStateCheckCPUs(state, cpus, ncpus) < 0)
+        return -1;
+
+    if (ncpus > state->ncpus) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("cannot remove %1$u CPUs from baseline of %2$zu CPUs"),
+                       ncpus, state->ncpus);
+        return -1;
+    }
+
+    for (i = 0; i < ncpus; i++) {
+        if (state->driver->baselineStateUpdate(state->data, cpus[i], false) < 0) {
+            virErrorPtr orig_err;
+
+            virErrorPreserveLast(&orig_err);
+            while (i-- > 0) {
+                ignore_value(state->driver->baselineStateUpdate(state->data,
+                                                                cpus[i], true));
+                state->ncpus++;
+            }
+            virErrorRestore(&orig_err);
+            return -1;
+        }
+        state->ncpus--;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virCPUBaselineStateGetCount:
+ *
+ * @state: baseline state
+ *
+ * Returns the number of CPUs currently stored in the baseline @state.
+ */
+size_t
+virCPUBaselineStateGetCount(virCPUBaselineState *state)
+{
+    return state->ncpus;
+}
+
+
+/**
+ * virCPUBaselineStateCompute:
+ *
+ * @state: baseline state
+ * @models: list of CPU models that can be considered for the baseline CPU
+ * @features: optional NULL terminated list of allowed features
+ * @migratable: requests non-migratable features to be removed from the result
+ *
+ * Computes the most feature-rich CPU which is compatible with all CPUs
+ * currently stored in the baseline @state. See virCPUBaseline for more
+ * details.
+ *
+ * Returns baseline CPU definition or NULL on error.
+ */
+virCPUDef *
+virCPUBaselineStateCompute(virCPUBaselineState *state,
+                           virDomainCapsCPUModels *models,
+                           const char **features,
+                           bool migratable)
+{
+    VIR_DEBUG("state=%p, ncpus=%zu, models=%p, features=%p, migratable=%d",
+              state, state->ncpus, models, features, migratable);
+
+    if (state->ncpus < 1) {
+        virReportError(VIR_ERR_INVALID_ARG, "%s", _("no CPUs given"));
+        return NULL;
+    }
+
+    return state->driver->baselineStateCompute(state->data, models,
+                                               features, migratable);
+}
+
+
 /**
  * virCPUUpdate:
  *
@@ -78,6 +78,23 @@ typedef virCPUDef *
                       const char **features,
                       bool migratable);
 
+typedef void *
+(*virCPUArchBaselineStateNew)(void);
+
+typedef void
+(*virCPUArchBaselineStateFree)(void *state);
+
+typedef int
+(*virCPUArchBaselineStateUpdate)(void *state,
+                                 virCPUDef *cpu,
+                                 bool add);
+
+typedef virCPUDef *
+(*virCPUArchBaselineStateCompute)(void *state,
+                                  virDomainCapsCPUModels *models,
+                                  const char **features,
+                                  bool migratable);
+
 typedef int
 (*virCPUArchUpdate)(virCPUDef *guest,
                     const virCPUDef *host,
@@ -146,6 +163,10 @@ struct cpuArchDriver {
     cpuArchDataFree     dataFree;
     virCPUArchGetHost   getHost;
     virCPUArchBaseline baseline;
+    virCPUArchBaselineStateNew baselineStateNew;
+    virCPUArchBaselineStateFree baselineStateFree;
+    virCPUArchBaselineStateUpdate baselineStateUpdate;
+    virCPUArchBaselineStateCompute baselineStateCompute;
     virCPUArchUpdate    update;
     virCPUArchUpdateLive updateLive;
     virCPUArchCheckFeature checkFeature;
@@ -226,6 +247,38 @@ virCPUBaseline(virArch arch,
                const char **features,
                bool migratable);
 
+typedef struct _virCPUBaselineState virCPUBaselineState;
+
+virCPUBaselineState *
+virCPUBaselineStateNew(virArch arch);
+
+void
+virCPUBaselineStateFree(virCPUBaselineState *state);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virCPUBaselineState, virCPUBaselineStateFree);
+
+int
+virCPUBaselineStateAdd(virCPUBaselineState *state,
+                       virCPUDef **cpus,
+                       unsigned int ncpus)
+    ATTRIBUTE_NONNULL(1);
+
+int
+virCPUBaselineStateRemove(virCPUBaselineState *state,
+                          virCPUDef **cpus,
+                          unsigned int ncpus)
+    ATTRIBUTE_NONNULL(1);
+
+size_t
+virCPUBaselineStateGetCount(virCPUBaselineState *state)
+    ATTRIBUTE_NONNULL(1);
+
+virCPUDef *
+virCPUBaselineStateCompute(virCPUBaselineState *state,
+                           virDomainCapsCPUModels *models,
+                           const char **features,
+                           bool migratable)
+    ATTRIBUTE_NONNULL(1);
+
 int
 virCPUUpdate(virArch arch,
              virCPUDef *guest,
@@ -51,6 +51,7 @@ typedef struct _virCPUx86Feature virCPUx86Feature;
 struct _virCPUx86Feature {
     char *name;
     virCPUx86Data data;
+    uint64_t *bits; /* @data in the map's bitset layout, see x86DataToBits */
     bool migratable;
 };
 
@@ -147,6 +148,7 @@ struct _virCPUx86Model {
     virCPUx86Vendor *vendor;
     virCPUx86Signatures *signatures;
     virCPUx86Data data;
+    uint64_t *bits; /* only set for models stored in the map */
     GStrv removedFeatures;
 
     /* Features added to the CPU model after its original version was released.
@@ -171,6 +173,12 @@ struct _virCPUx86Map {
     virCPUx86Model **models;
     size_t nblockers;
     virCPUx86Feature **migrate_blockers;
+
+    /* Every CPUID leaf and MSR referenced by any feature in the map (with
+     * all register values cleared) defines two 64b words in the fixed-width
+     * bitsets used for fast feature matching. */
+    virCPUx86Data layout;
+    size_t nwords;
 };
 
 static virCPUx86Map *cpuMap;
@@ -447,8 +455,8 @@ virCPUx86DataSorter(const void *a,
 }
 
 static int
-virCPUx86DataItemCmp(const virCPUx86DataItem *item1,
-                     const virCPUx86DataItem *item2)
+virCPUx86DataItemCmp(const void *item1,
+                     const void *item2)
 {
     return virCPUx86DataSorter(item1, item2, NULL);
 }
@@ -475,19 +483,16 @@ virCPUx86DataNext(virCPUx86DataIterator *iterator)
 }
 
 
+/* Items are kept sorted by virCPUx86DataAddItem. */
 static virCPUx86DataItem *
 virCPUx86DataGet(const virCPUx86Data *data,
                  const virCPUx86DataItem *item)
 {
-    size_t i;
-
-    for (i = 0; i < data->len; i++) {
-        virCPUx86DataItem *di = data->items + i;
-        if (virCPUx86DataItemCmp(di, item) == 0)
-            return di;
-    }
+    if (data->len == 0)
+        return NULL;
 
-    return NULL;
+    return bsearch(item, data->items, data->len, sizeof(*data->items),
+                   virCPUx86DataItemCmp);
 }
 
 static void
@@ -638,19 +643,130 @@ x86DataIsSubset(const virCPUx86Data *data,
 }
 
 
-/* also removes all detected features from data */
+/*
+ * Converts CPU @data into a bitset with map->nwords words. Only bits which
+ * belong to CPUID leaves or MSRs used by features in the @map are kept, which
+ * is enough for all feature matching operations since features cannot
+ * contain any other bits.
+ */
+static uint64_t *
+x86DataToBits(virCPUx86Map *map,
+              const virCPUx86Data *data)
+{
+    uint64_t *bits = g_new0(uint64_t, map->nwords);
+    size_t i;
+
+    for (i = 0; i < data->len; i++) {
+        const virCPUx86DataItem *item = data->items + i;
+        virCPUx86DataItem *key;
+        uint64_t *words;
+
+        if (!(key = virCPUx86DataGet(&map->layout, item)))
+            continue;
+
+        words = bits + 2 * (key - map->layout.items);
+
+        switch (item->type) {
+        case VIR_CPU_X86_DATA_CPUID:
+            words[0] |= item->data.cpuid.eax |
+                        (uint64_t) item->data.cpuid.ebx << 32;
+            words[1] |= item->data.cpuid.ecx |
+                        (uint64_t) item->data.cpuid.edx << 32;
+            break;
+
+        case VIR_CPU_X86_DATA_MSR:
+            words[0] |= item->data.msr.eax |
+                        (uint64_t) item->data.msr.edx << 32;
+            break;
+
+        case VIR_CPU_X86_DATA_NONE:
+        default:
+            break;
+        }
+    }
+
+    return bits;
+}
+
+
+static uint64_t *
+x86BitsCopy(const uint64_t *bits,
+            size_t nwords)
+{
+    uint64_t *copy = g_new0(uint64_t, nwords);
+
+    if (nwords > 0)
+        memcpy(copy, bits, nwords * sizeof(*bits));
+
+    return copy;
+}
+
+
+static void
+x86BitsAdd(uint64_t *bits,
+           const uint64_t *other,
+           size_t nwords)
+{
+    size_t i;
+
+    for (i = 0; i < nwords; i++)
+        bits[i] |= other[i];
+}
+
+
+static void
+x86BitsSubtract(uint64_t *bits,
+                const uint64_t *other,
+                size_t nwords)
+{
+    size_t i;
+
+    for (i = 0; i < nwords; i++)
+        bits[i] &= ~other[i];
+}
+
+
+static void
+x86BitsIntersect(uint64_t *bits,
+                 const uint64_t *other,
+                 size_t nwords)
+{
+    size_t i;
+
+    for (i = 0; i < nwords; i++)
+        bits[i] &= other[i];
+}
+
+
+static bool
+x86BitsIsSubset(const uint64_t *bits,
+                const uint64_t *subset,
+                size_t nwords)
+{
+    size_t i;
+
+    for (i = 0; i < nwords; i++) {
+        if ((bits[i] & subset[i]) != subset[i])
+            return false;
+    }
+
+    return true;
+}
+
+
+/* also removes all detected features from bits */
 static int
-x86DataToCPUFeatures(virCPUDef *cpu,
+x86BitsToCPUFeatures(virCPUDef *cpu,
                      int policy,
-                     virCPUx86Data *data,
+                     uint64_t *bits,
                      virCPUx86Map *map)
 {
     size_t i;
 
     for (i = 0; i < map->nfeatures; i++) {
         virCPUx86Feature *feature = map->features[i];
-        if (x86DataIsSubset(data, &feature->data)) {
-            x86DataSubtract(data, &feature->data);
+        if (x86BitsIsSubset(bits, feature->bits, map->nwords)) {
+            x86BitsSubtract(bits, feature->bits, map->nwords);
             if (virCPUDefAddFeature(cpu, feature->name, policy) < 0)
                 return -1;
         }
@@ -660,10 +776,60 @@ x86DataToCPUFeatures(virCPUDef *cpu,
 }
 
 
-/* also removes bits corresponding to vendor string from data */
+/* Inverse operation to x86DataToBits. */
+static void
+x86BitsToData(virCPUx86Map *map,
+              const uint64_t *bits,
+              virCPUx86Data *data)
+{
+    size_t i;
+
+    for (i = 0; i < map->layout.len; i++) {
+        virCPUx86DataItem item = map->layout.items[i];
+        const uint64_t *words = bits + 2 * i;
+
+        if (!words[0] && !words[1])
+            continue;
+
+        switch (item.type) {
+        case VIR_CPU_X86_DATA_CPUID:
+            item.data.cpuid.eax = words[0] & 0xffffffff;
+            item.data.cpuid.ebx = words[0] >> 32;
+            item.data.cpuid.ecx = words[1] & 0xffffffff;
+            item.data.cpuid.edx = words[1] >> 32;
+            break;
+
+        case VIR_CPU_X86_DATA_MSR:
+            item.data.msr.eax = words[0] & 0xffffffff;
+            item.data.msr.edx = words[0] >> 32;
+            break;
+
+        case VIR_CPU_X86_DATA_NONE:
+        default:
+            continue;
+        }
+
+        virCPUx86DataAddItem(data, &item);
+    }
+}
+
+
+static int
+x86DataToCPUFeatures(virCPUDef *cpu,
+                     int policy,
+                     const virCPUx86Data *data,
+                     virCPUx86Map *map)
+{
+    g_autofree uint64_t *bits = x86DataToBits(map, data);
+
+    return x86BitsToCPUFeatures(cpu, policy, bits, map);
+}
+
+
 static virCPUx86Vendor *
-x86DataToVendor(const virCPUx86Data *data,
-                virCPUx86Map *map)
+x86DataFindVendor(const virCPUx86Data *data,
+                  virCPUx86Map *map,
+                  virCPUx86DataItem **vendorItem)
 {
     virCPUx86DataItem *item;
     size_t i;
@@ -672,7 +838,8 @@ x86DataToVendor(const virCPUx86Data *data,
         virCPUx86Vendor *vendor = map->vendors[i];
         if ((item = virCPUx86DataGet(data, &vendor->data)) &&
             virCPUx86DataItemMatchMasked(item, &vendor->data)) {
-            virCPUx86DataItemClearBits(item, &vendor->data);
+            if (vendorItem)
+                *vendorItem = item;
             return vendor;
         }
     }
@@ -681,6 +848,21 @@ x86DataToVendor(const virCPUx86Data *data,
 }
 
 
+/* also removes bits corresponding to vendor string from data */
+static virCPUx86Vendor *
+x86DataToVendor(virCPUx86Data *data,
+                virCPUx86Map *map)
+{
+    virCPUx86DataItem *item;
+    virCPUx86Vendor *vendor;
+
+    if ((vendor = x86DataFindVendor(data, map, &item)))
+        virCPUx86DataItemClearBits(item, &vendor->data);
+
+    return vendor;
+}
+
+
 static int
 virCPUx86VendorToData(const char *vendor,
                       virCPUx86DataItem *item)
@@ -862,22 +1044,24 @@ x86DataToCPU(const virCPUx86Data *data,
              virCPUType cpuType)
 {
     g_autoptr(virCPUDef) cpu = NULL;
-    g_auto(virCPUx86Data) copy = VIR_CPU_X86_DATA_INIT;
-    g_auto(virCPUx86Data) modelData = VIR_CPU_X86_DATA_INIT;
+    g_autofree uint64_t *copy = NULL;
+    g_autofree uint64_t *modelData = NULL;
     virCPUx86Vendor *vendor;
 
     cpu = virCPUDefNew();
 
     cpu->model = g_strdup(model->name);
 
-    x86DataCopy(&copy, data);
-    x86DataCopy(&modelData, &model->data);
-
-    if ((vendor = x86DataToVendor(&copy, map)))
+    /* The vendor string is in CPUID leaf 0 which no feature refers to,
+     * x86DataToBits ignores it without removing it from @data. */
+    if ((vendor = x86DataFindVendor(data, map, NULL)))
         cpu->vendor = g_strdup(vendor->name);
 
-    x86DataSubtract(&copy, &modelData);
-    x86DataSubtract(&modelData, data);
+    copy = x86DataToBits(map, data);
+    modelData = x86BitsCopy(model->bits, map->nwords);
+
+    x86BitsSubtract(modelData, copy, map->nwords);
+    x86BitsSubtract(copy, model->bits, map->nwords);
 
     /* The hypervisor's version of the CPU model (hvModel) may contain
      * additional features which may be currently unavailable. Such features
@@ -889,16 +1073,16 @@ x86DataToCPU(const virCPUx86Data *data,
 
         for (blocker = hvModel->blockers; *blocker; blocker++) {
             if ((feature = x86FeatureFind(map, *blocker)) &&
-                !x86DataIsSubset(&copy, &feature->data))
-                x86DataAdd(&modelData, &feature->data);
+                !x86BitsIsSubset(copy, feature->bits, map->nwords))
+                x86BitsAdd(modelData, feature->bits, map->nwords);
         }
     }
 
     /* because feature policy is ignored for host CPU */
     cpu->type = VIR_CPU_TYPE_GUEST;
 
-    if (x86DataToCPUFeatures(cpu, VIR_CPU_FEATURE_REQUIRE, &copy, map) ||
-        x86DataToCPUFeatures(cpu, VIR_CPU_FEATURE_DISABLE, &modelData, map))
+    if (x86BitsToCPUFeatures(cpu, VIR_CPU_FEATURE_REQUIRE, copy, map) ||
+        x86BitsToCPUFeatures(cpu, VIR_CPU_FEATURE_DISABLE, modelData, map))
         return NULL;
 
     if (cpuType == VIR_CPU_TYPE_GUEST) {
@@ -982,6 +1166,7 @@ x86FeatureFree(virCPUx86Feature *feature)
 
     g_free(feature->name);
     virCPUx86DataClear(&feature->data);
+    g_free(feature->bits);
     g_free(feature);
 }
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virCPUx86Feature, x86FeatureFree);
@@ -1286,6 +1471,7 @@ x86ModelFree(virCPUx86Model *model)
     g_free(model->name);
     virCPUx86SignaturesFree(model->signatures);
     virCPUx86DataClear(&model->data);
+    g_free(model->bits);
     g_strfreev(model->removedFeatures);
     g_strfreev(model->addedFeatures);
     g_free(model);
@@ -1731,11 +1917,59 @@ x86MapFree(virCPUx86Map *map)
      */
     g_free(map->migrate_blockers);
 
+    virCPUx86DataClear(&map->layout);
+
     g_free(map);
 }
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virCPUx86Map, x86MapFree);
 
 
+/*
+ * Precomputes bitset representation of all features and models in the @map
+ * so that decoding CPU data does not need to walk through CPUID leaves of
+ * every feature for every CPU model.
+ */
+static void
+x86MapInitBits(virCPUx86Map *map)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < map->nfeatures; i++) {
+        virCPUx86Data *data = &map->features[i]->data;
+
+        for (j = 0; j < data->len; j++) {
+            virCPUx86DataItem key = { .type = data->items[j].type };
+
+            switch (key.type) {
+            case VIR_CPU_X86_DATA_CPUID:
+                key.data.cpuid.eax_in = data->items[j].data.cpuid.eax_in;
+                key.data.cpuid.ecx_in = data->items[j].data.cpuid.ecx_in;
+                break;
+
+            case VIR_CPU_X86_DATA_MSR:
+                key.data.msr.index = data->items[j].data.msr.index;
+                break;
+
+            case VIR_CPU_X86_DATA_NONE:
+            default:
+                continue;
+            }
+
+            virCPUx86DataAddItem(&map->layout, &key);
+        }
+    }
+
+    map->nwords = 2 * map->layout.len;
+
+    for (i = 0; i < map->nfeatures; i++)
+        map->features[i]->bits = x86DataToBits(map, &map->features[i]->data);
+
+    for (i = 0; i < map->nmodels; i++)
+        map->models[i]->bits = x86DataToBits(map, &map->models[i]->data);
+}
+
+
 static virCPUx86Map *
 virCPUx86LoadMap(void)
 {
@@ -1746,6 +1980,8 @@ virCPUx86LoadMap(void)
     if (cpuMapLoad("x86", x86VendorParse, x86FeatureParse, x86ModelParse, map) < 0)
         return NULL;
 
+    x86MapInitBits(map);
+
     return g_steal_pointer(&map);
 }
 
@@ -2063,20 +2299,6 @@ x86DecodeUseCandidate(virCPUx86Model *current,
 {
     bool isPreferred = false;
 
-    if (cpuCandidate->type == VIR_CPU_TYPE_HOST &&
-        !candidate->decodeHost) {
-        VIR_DEBUG("%s is not supposed to be used for host CPU definition",
-                  cpuCandidate->model);
-        return 0;
-    }
-
-    if (cpuCandidate->type == VIR_CPU_TYPE_GUEST &&
-        !candidate->decodeGuest) {
-        VIR_DEBUG("%s is not supposed to be used for guest CPU definition",
-                  cpuCandidate->model);
-        return 0;
-    }
-
     if (cpuCandidate->type == VIR_CPU_TYPE_HOST) {
         size_t i;
         for (i = 0; i < cpuCandidate->nfeatures; i++) {
@@ -2124,6 +2346,44 @@ x86DecodeUseCandidate(virCPUx86Model *current,
 }
 
 
+/*
+ * Cheap checks which allow us to skip candidates x86DecodeUseCandidate would
+ * reject anyway without computing the list of features for them.
+ */
+static bool
+x86DecodeCandidateMayMatch(virCPUx86Model *current,
+                           virCPUx86Model *candidate,
+                           virCPUType cpuType,
+                           uint32_t signature,
+                           const char **preferred)
+{
+    if (cpuType == VIR_CPU_TYPE_HOST && !candidate->decodeHost) {
+        VIR_DEBUG("%s is not supposed to be used for host CPU definition",
+                  candidate->name);
+        return false;
+    }
+
+    if (cpuType == VIR_CPU_TYPE_GUEST && !candidate->decodeGuest) {
+        VIR_DEBUG("%s is not supposed to be used for guest CPU definition",
+                  candidate->name);
+        return false;
+    }
+
+    if (preferred && !preferred[1] && STREQ(candidate->name, preferred[0]))
+        return true;
+
+    if (current && signature &&
+        virCPUx86SignaturesMatch(current->signatures, signature) &&
+        !virCPUx86SignaturesMatch(candidate->signatures, signature)) {
+        VIR_DEBUG("%s differs in signature from matching %s",
+                  candidate->name, current->name);
+        return false;
+    }
+
+    return true;
+}
+
+
 /**
  * Drop broken TSX features.
  */
@@ -2235,6 +2495,10 @@ x86Decode(virCPUDef *cpu,
             continue;
         }
 
+        if (!x86DecodeCandidateMayMatch(model, candidate, cpu->type,
+                                        signature, preferred))
+            continue;
+
         if (!(cpuCandidate = x86DataToCPU(&data, candidate, map, hvModel,
                                           cpu->type)))
             return -1;
@@ -2914,6 +3178,236 @@ virCPUx86Baseline(virCPUDef **cpus,
 }
 
 
+typedef struct _virCPUx86BaselineState virCPUx86BaselineState;
+struct _virCPUx86BaselineState {
+    virCPUx86Map *map;
+    size_t ncpus;
+    /* number of CPUs providing each bit of the map's bitset layout */
+    unsigned int *counts;
+    /* model name -> number of CPUs using the model */
+    GHashTable *models;
+    virCPUx86Vendor *vendor;
+    size_t nvendor;     /* CPUs with known vendor */
+    size_t nnovendor;   /* CPUs without explicitly specified vendor */
+};
+
+
+static void *
+virCPUx86BaselineStateNew(void)
+{
+    virCPUx86BaselineState *state;
+    virCPUx86Map *map;
+
+    if (!(map = virCPUx86GetMap()))
+        return NULL;
+
+    state = g_new0(virCPUx86BaselineState, 1);
+    state->map = map;
+    state->counts = g_new0(unsigned int, map->nwords * 64);
+    state->models = virHashNew(NULL);
+
+    return state;
+}
+
+
+static void
+virCPUx86BaselineStateFree(void *opaque)
+{
+    virCPUx86BaselineState *state = opaque;
+
+    if (!state)
+        return;
+
+    g_free(state->counts);
+    g_clear_pointer(&state->models, g_hash_table_unref);
+    g_free(state);
+}
+
+
+/*
+ * Adds (@add == true) or removes (@add == false) @cpu to/from the baseline
+ * @state. The cost depends only on the number of features of @cpu, not on
+ * the number of CPUs already stored in @state.
+ */
+static int
+virCPUx86BaselineStateUpdate(void *opaque,
+                             virCPUDef *cpu,
+                             bool add)
+{
+    virCPUx86BaselineState *state = opaque;
+    virCPUx86Map *map = state->map;
+    g_autoptr(virCPUx86Model) model = NULL;
+    g_autofree uint64_t *bits = NULL;
+    virCPUx86Vendor *vendor = NULL;
+    const char *vn = NULL;
+    unsigned int count;
+    size_t i;
+
+    if (!(model = x86ModelFromCPU(cpu, map, -1)))
+        return -1;
+
+    if (cpu->vendor && model->vendor &&
+        STRNEQ(cpu->vendor, model->vendor->name)) {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       _("CPU vendor %1$s of model %2$s differs from vendor %3$s"),
+                       model->vendor->name, model->name, cpu->vendor);
+        return -1;
+    }
+
+    if (cpu->vendor)
+        vn = cpu->vendor;
+    else if (model->vendor)
+        vn = model->vendor->name;
+
+    if (vn && !(vendor = x86VendorFind(map, vn))) {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       _("Unknown CPU vendor %1$s"), vn);
+        return -1;
+    }
+
+    if (vendor && state->vendor && vendor != state->vendor) {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       "%s", _("CPU vendors do not match"));
+        return -1;
+    }
+
+    bits = x86DataToBits(map, &model->data);
+
+    if (!add) {
+        for (i = 0; i < map->nwords * 64; i++) {
+            if (bits[i / 64] & (1ULL << (i % 64)) &&
+                state->counts[i] == 0) {
+                virReportError(VIR_ERR_INVALID_ARG,
+                               _("CPU model %1$s was not added to the baseline"),
+                               cpu->model);
+                return -1;
+            }
+        }
+    }
+
+    for (i = 0; i < map->nwords; i++) {
+        uint64_t word = bits[i];
+
+        while (word) {
+            size_t bit = i * 64 + __builtin_ctzll(word);
+
+            if (add)
+                state->counts[bit]++;
+            else
+                state->counts[bit]--;
+
+            word &= word - 1;
+        }
+    }
+
+    if (vendor) {
+        if (add) {
+            state->vendor = vendor;
+            state->nvendor++;
+        } else if (--state->nvendor == 0) {
+            state->vendor = NULL;
+        }
+    }
+
+    if (!cpu->vendor) {
+        if (add)
+            state->nnovendor++;
+        else
+            state->nnovendor--;
+    }
+
+    if (cpu->model) {
+        count = GPOINTER_TO_UINT(virHashLookup(state->models, cpu->model));
+
+        if (add)
+            count++;
+        else if (count > 0)
+            count--;
+
+        if (count > 0)
+            ignore_value(virHashUpdateEntry(state->models, cpu->model,
+                                            GUINT_TO_POINTER(count)));
+        else
+            virHashRemoveEntry(state->models, cpu->model);
+    }
+
+    if (add)
+        state->ncpus++;
+    else
+        state->ncpus--;
+
+    return 0;
+}
+
+
+static virCPUDef *
+virCPUx86BaselineStateCompute(void *opaque,
+                              virDomainCapsCPUModels *models,
+                              const char **features,
+                              bool migratable)
+{
+    virCPUx86BaselineState *state = opaque;
+    virCPUx86Map *map = state->map;
+    g_autoptr(virCPUDef) cpu = NULL;
+    g_auto(virCPUx86Data) data = VIR_CPU_X86_DATA_INIT;
+    g_autofree uint64_t *bits = NULL;
+    g_autofree virHashKeyValuePair *items = NULL;
+    g_autofree char **modelNames = NULL;
+    size_t nitems = 0;
+    size_t i;
+
+    bits = g_new0(uint64_t, map->nwords);
+    for (i = 0; i < map->nwords * 64; i++) {
+        if (state->counts[i] == state->ncpus)
+            bits[i / 64] |= 1ULL << (i % 64);
+    }
+
+    if (features) {
+        g_autofree uint64_t *featBits = g_new0(uint64_t, map->nwords);
+        virCPUx86Feature *feat;
+
+        for (i = 0; features[i]; i++) {
+            if ((feat = x86FeatureFind(map, features[i])))
+                x86BitsAdd(featBits, feat->bits, map->nwords);
+        }
+
+        x86BitsIntersect(bits, featBits, map->nwords);
+    }
+
+    x86BitsToData(map, bits, &data);
+
+    if (x86DataIsEmpty(&data)) {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       "%s", _("CPUs are incompatible"));
+        return NULL;
+    }
+
+    if (state->vendor)
+        virCPUx86DataAddItem(&data, &state->vendor->data);
+
+    items = virHashGetItems(state->models, &nitems, true);
+    modelNames = g_new0(char *, nitems + 1);
+    for (i = 0; i < nitems; i++)
+        modelNames[i] = (char *) items[i].key;
+
+    cpu = virCPUDefNew();
+    cpu->type = VIR_CPU_TYPE_GUEST;
+    cpu->match = VIR_CPU_MATCH_EXACT;
+
+    if (x86Decode(cpu, &data, models,
+                  (const char **) modelNames, migratable) < 0)
+        return NULL;
+
+    if (nitems == 1 && STREQ(cpu->model, modelNames[0]))
+        cpu->fallback = VIR_CPU_FALLBACK_FORBID;
+
+    if (state->nnovendor > 0)
+        g_clear_pointer(&cpu->vendor, g_free);
+
+    return g_steal_pointer(&cpu);
+}
+
+
 static int
 x86UpdateHostModel(virCPUDef *guest,
                    const virCPUDef *host)
@@ -3580,6 +4074,10 @@ struct cpuArchDriver cpuDriverX86 = {
     .getHost    = virCPUx86GetHost,
 #endif
     .baseline   = virCPUx86Baseline,
+    .baselineStateNew = virCPUx86BaselineStateNew,
+    .baselineStateFree = virCPUx86BaselineStateFree,
+    .baselineStateUpdate = virCPUx86BaselineStateUpdate,
+    .baselineStateCompute = virCPUx86BaselineStateCompute,
     .update     = virCPUx86Update,
     .updateLive = virCPUx86UpdateLive,
     .checkFeature = virCPUx86CheckFeature,
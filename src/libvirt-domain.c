@@ -12479,6 +12479,23 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  *     "perf.emulation_faults" - The count of emulation faults as unsigned
  *                               long long. It is produced by the
  *                               emulation_faults perf event
+ *     "perf.ipc" - instructions per cpu cycle as double. It is reported when
+ *                  both the cpu_cycles and instructions perf events are
+ *                  enabled.
+ *     "perf.cache_miss_rate" - the share of cache references which missed
+ *                              the cache as double. It is reported when
+ *                              both the cache_references and cache_misses
+ *                              perf events are enabled.
+ *     "perf.vcpu.<num>.<event>" - the count of <event> for the thread of
+ *                                 virtual CPU <num> as unsigned long long.
+ *                                 It is reported for the cpu_cycles,
+ *                                 instructions, cache_references,
+ *                                 cache_misses, branch_instructions and
+ *                                 branch_misses perf events if they are
+ *                                 enabled.
+ *     "perf.vcpu.<num>.ipc" - "perf.ipc" of virtual CPU <num>.
+ *     "perf.vcpu.<num>.cache_miss_rate" - "perf.cache_miss_rate" of virtual
+ *                                         CPU <num>.
  *
  * VIR_DOMAIN_STATS_IOTHREAD:
  *     Return IOThread statistics if available. IOThread polling is a
@@ -12542,6 +12559,14 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  *     "memory.bandwidth.monitor.<num>.node.<index>.bytes.total" - the total
  *                       bytes consumed by @vcpus that passing through all
  *                       memory controllers, either local or remote controller.
+ *     "memory.bandwidth.monitor.<num>.node.<index>.rate.local" - the bytes
+ *                       per second passing through the local memory
+ *                       controller, measured between the two last periodic
+ *                       samples of the monitor. Only reported if the
+ *                       hypervisor samples resctrl monitors periodically.
+ *     "memory.bandwidth.monitor.<num>.node.<index>.rate.total" - the bytes
+ *                       per second passing through all memory controllers,
+ *                       measured the same way as the local rate.
  *
  * VIR_DOMAIN_STATS_DIRTYRATE:
  *     Return memory dirty rate information. The typed parameter keys are in
@@ -12591,6 +12616,19 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  *      naming or meaning will stay consistent. Changes to existing fields,
  *      however, are expected to be rare.
  *
+ * VIR_DOMAIN_STATS_XML:
+ *     Return the XML description of the domain, as virDomainGetXMLDesc()
+ *     with no flags would. This group is not part of the default set
+ *     returned for @stats of 0 and has to be requested explicitly.
+ *     The typed parameter keys are in this format:
+ *
+ *     "xml" - the XML description of the domain as string.
+ *
+ *     The stats of all domains are returned in a single message when
+ *     connected to a remote daemon, which is limited to 32 MiB. With many
+ *     or big domains, callers should request this group with
+ *     virDomainListGetStats() for chunks of domains instead.
+ *
  * Note that entire stats groups or individual stat fields may be missing from
  * the output in case they are not supported by the given hypervisor, are not
  * applicable for the current state of the guest domain, or their retrieval
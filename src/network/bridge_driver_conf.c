@@ -148,11 +148,23 @@ virNetworkDriverConfigDispose(void *obj)
 
 
 
+/*
+ * The version of dnsmasq is checked for every network that is started.
+ * If the binary passed the previous check, it is checked again in the
+ * background for the next network so that starting this one doesn't
+ * wait for dnsmasq. Otherwise it is looked up and checked right away.
+ */
 int
 networkDnsmasqCapsRefresh(virNetworkDriverState *driver)
 {
+    g_autoptr(dnsmasqCaps) current = networkGetDnsmasqCaps(driver);
     dnsmasqCaps *caps;
 
+    if (current && dnsmasqCapsIsUsable(current)) {
+        dnsmasqCapsRefreshAsync(current);
+        return 0;
+    }
+
     if (!(caps = dnsmasqCapsNewFromBinary()))
         return -1;
 
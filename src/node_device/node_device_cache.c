@@ -0,0 +1,250 @@
+/*
+ * node_device_cache.c: cache of slow to read sysfs attributes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "node_device_cache.h"
+#include "vircrypto.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+
+#define VIR_FROM_THIS VIR_FROM_NODEDEV
+
+VIR_LOG_INIT("node_device.node_device_cache");
+
+/* longest key file accepted, see nodeDeviceCacheOpen() */
+#define NODE_DEVICE_CACHE_KEY_MAX (PATH_MAX + 64)
+
+/*
+ * Some sysfs attributes, most notably the VPD of PCI devices, are read
+ * from the device itself by the kernel, which can take seconds per
+ * device. Their content does not change as long as the device is not
+ * re-added, so a copy of them is kept in files below @dir, which
+ * usually is on tmpfs and thus survives restarts of the daemon but not
+ * of the host.
+ *
+ * Every device has a directory named by the SHA-256 of its sysfs path.
+ * Next to the copy of each attribute there is a '<attr>.key' file with
+ * the generation of the device the copy was taken from, followed by the
+ * sysfs path to guard against hash collisions. A copy is used only if
+ * the generation matches the current one of the device.
+ */
+struct _nodeDeviceCache {
+    char *dir;
+};
+
+typedef struct _nodeDeviceCacheData nodeDeviceCacheData;
+struct _nodeDeviceCacheData {
+    const char *data;
+    size_t len;
+};
+
+
+nodeDeviceCache *
+nodeDeviceCacheNew(const char *dir)
+{
+    nodeDeviceCache *cache = NULL;
+
+    if (g_mkdir_with_parents(dir, S_IRWXU) < 0) {
+        virReportSystemError(errno, _("cannot create cache directory '%1$s'"),
+                             dir);
+        return NULL;
+    }
+
+    cache = g_new0(nodeDeviceCache, 1);
+    cache->dir = g_strdup(dir);
+
+    return cache;
+}
+
+
+void
+nodeDeviceCacheFree(nodeDeviceCache *cache)
+{
+    if (!cache)
+        return;
+
+    g_free(cache->dir);
+    g_free(cache);
+}
+
+
+static char *
+nodeDeviceCacheEntryDir(nodeDeviceCache *cache,
+                        const char *sysfsPath)
+{
+    g_autofree char *hash = NULL;
+
+    if (virCryptoHashString(VIR_CRYPTO_HASH_SHA256, sysfsPath, &hash) < 0)
+        return NULL;
+
+    return g_build_filename(cache->dir, hash, NULL);
+}
+
+
+static int
+nodeDeviceCacheWriteHelper(int fd,
+                           const char *path,
+                           const void *opaque)
+{
+    const nodeDeviceCacheData *data = opaque;
+
+    if (safewrite(fd, data->data, data->len) < 0) {
+        virReportSystemError(errno, _("cannot write data to file '%1$s'"),
+                             path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+nodeDeviceCacheWrite(const char *path,
+                     const char *data,
+                     size_t len)
+{
+    nodeDeviceCacheData opaque = { .data = data, .len = len };
+
+    return virFileRewrite(path, S_IRUSR | S_IWUSR, -1, -1,
+                          nodeDeviceCacheWriteHelper, &opaque);
+}
+
+
+/**
+ * nodeDeviceCacheOpen:
+ * @cache: the cache
+ * @sysfsPath: sysfs path of the device
+ * @attr: name of the attribute
+ * @generation: identifies the instance of the device, or NULL
+ * @maxlen: maximum size of the attribute
+ *
+ * Opens a copy of the attribute @attr of the device at @sysfsPath,
+ * storing one first if there is none for @generation yet. The device
+ * itself is opened if the attribute can't be cached, which is always
+ * the case without @generation.
+ *
+ * Returns a file descriptor positioned at the start of the attribute,
+ * or -1 with an error reported.
+ */
+int
+nodeDeviceCacheOpen(nodeDeviceCache *cache,
+                    const char *sysfsPath,
+                    const char *attr,
+                    const char *generation,
+                    int maxlen)
+{
+    g_autofree char *attrPath = g_build_filename(sysfsPath, attr, NULL);
+    g_autofree char *entryDir = NULL;
+    g_autofree char *dataPath = NULL;
+    g_autofree char *keyPath = NULL;
+    g_autofree char *key = NULL;
+    g_autofree char *cachedKey = NULL;
+    g_autofree char *data = NULL;
+    int fd = -1;
+    int cachedFD;
+    int len;
+
+    if (generation && (entryDir = nodeDeviceCacheEntryDir(cache, sysfsPath))) {
+        dataPath = g_build_filename(entryDir, attr, NULL);
+        keyPath = g_strdup_printf("%s.key", dataPath);
+        key = g_strdup_printf("%s\n%s\n", generation, sysfsPath);
+
+        if (virFileReadAllQuiet(keyPath, NODE_DEVICE_CACHE_KEY_MAX, &cachedKey) >= 0 &&
+            STREQ(cachedKey, key) &&
+            (fd = open(dataPath, O_RDONLY | O_CLOEXEC)) >= 0) {
+            VIR_DEBUG("using cached '%s' of '%s'", attr, sysfsPath);
+            return fd;
+        }
+    }
+
+    if ((fd = open(attrPath, O_RDONLY | O_CLOEXEC)) < 0) {
+        virReportSystemError(errno, _("cannot open '%1$s'"), attrPath);
+        return -1;
+    }
+
+    if (!key)
+        return fd;
+
+    if ((len = virFileReadLimFD(fd, maxlen, &data)) < 0) {
+        VIR_DEBUG("cannot read '%s', not caching it: %s",
+                  attrPath, g_strerror(errno));
+        goto nocache;
+    }
+
+    /* the key is written last so that a copy is never used before it
+     * is complete */
+    if (g_mkdir_with_parents(entryDir, S_IRWXU) < 0) {
+        VIR_WARN("cannot create cache directory '%s': %s",
+                 entryDir, g_strerror(errno));
+        goto nocache;
+    }
+
+    if (nodeDeviceCacheWrite(dataPath, data, len) < 0 ||
+        nodeDeviceCacheWrite(keyPath, key, strlen(key)) < 0) {
+        VIR_WARN("cannot cache '%s': %s", attrPath, virGetLastErrorMessage());
+        virResetLastError();
+        goto nocache;
+    }
+
+    if ((cachedFD = open(dataPath, O_RDONLY | O_CLOEXEC)) < 0)
+        goto nocache;
+
+    VIR_DEBUG("cached '%s' of '%s'", attr, sysfsPath);
+    VIR_FORCE_CLOSE(fd);
+    return cachedFD;
+
+ nocache:
+    if (lseek(fd, 0, SEEK_SET) < 0) {
+        virReportSystemError(errno, _("cannot seek in '%1$s'"), attrPath);
+        VIR_FORCE_CLOSE(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/**
+ * nodeDeviceCacheRemove:
+ * @cache: the cache
+ * @sysfsPath: sysfs path of the device
+ *
+ * Drops everything cached for the device at @sysfsPath.
+ */
+void
+nodeDeviceCacheRemove(nodeDeviceCache *cache,
+                      const char *sysfsPath)
+{
+    g_autofree char *entryDir = NULL;
+
+    if (!(entryDir = nodeDeviceCacheEntryDir(cache, sysfsPath))) {
+        virResetLastError();
+        return;
+    }
+
+    if (virFileExists(entryDir) && virFileDeleteTree(entryDir) < 0) {
+        VIR_WARN("cannot remove cache directory '%s': %s",
+                 entryDir, virGetLastErrorMessage());
+        virResetLastError();
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * node_device_cache.h: cache of slow to read sysfs attributes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+
+typedef struct _nodeDeviceCache nodeDeviceCache;
+
+nodeDeviceCache *
+nodeDeviceCacheNew(const char *dir);
+
+void
+nodeDeviceCacheFree(nodeDeviceCache *cache);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(nodeDeviceCache, nodeDeviceCacheFree);
+
+int
+nodeDeviceCacheOpen(nodeDeviceCache *cache,
+                    const char *sysfsPath,
+                    const char *attr,
+                    const char *generation,
+                    int maxlen);
+
+void
+nodeDeviceCacheRemove(nodeDeviceCache *cache,
+                      const char *sysfsPath);
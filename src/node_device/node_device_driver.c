@@ -663,75 +663,6 @@ nodeDeviceDefToMdevctlConfig(virNodeDeviceDef *def, char **buf, bool defined)
 }
 
 
-static char *
-nodeDeviceObjFormatAddress(virNodeDeviceObj *obj)
-{
-    virNodeDevCapsDef *caps = NULL;
-    char *addr = NULL;
-    virNodeDeviceDef *def = virNodeDeviceObjGetDef(obj);
-    for (caps = def->caps; caps != NULL; caps = caps->next) {
-        switch (caps->data.type) {
-        case VIR_NODE_DEV_CAP_PCI_DEV: {
-            virPCIDeviceAddress pci_addr = {
-                .domain = caps->data.pci_dev.domain,
-                .bus = caps->data.pci_dev.bus,
-                .slot = caps->data.pci_dev.slot,
-                .function = caps->data.pci_dev.function
-            };
-
-            addr = virPCIDeviceAddressAsString(&pci_addr);
-            break;
-            }
-
-        case VIR_NODE_DEV_CAP_CSS_DEV: {
-            virCCWDeviceAddress ccw_addr = {
-                .cssid = caps->data.ccw_dev.cssid,
-                .ssid = caps->data.ccw_dev.ssid,
-                .devno = caps->data.ccw_dev.devno
-            };
-
-            addr = virCCWDeviceAddressAsString(&ccw_addr);
-            break;
-            }
-
-        case VIR_NODE_DEV_CAP_AP_MATRIX:
-            addr = g_strdup(caps->data.ap_matrix.addr);
-            break;
-
-        case VIR_NODE_DEV_CAP_MDEV_TYPES:
-            addr = g_strdup(caps->data.mdev_parent.address);
-            break;
-
-        case VIR_NODE_DEV_CAP_SYSTEM:
-        case VIR_NODE_DEV_CAP_USB_DEV:
-        case VIR_NODE_DEV_CAP_USB_INTERFACE:
-        case VIR_NODE_DEV_CAP_NET:
-        case VIR_NODE_DEV_CAP_SCSI_HOST:
-        case VIR_NODE_DEV_CAP_SCSI_TARGET:
-        case VIR_NODE_DEV_CAP_SCSI:
-        case VIR_NODE_DEV_CAP_STORAGE:
-        case VIR_NODE_DEV_CAP_FC_HOST:
-        case VIR_NODE_DEV_CAP_VPORTS:
-        case VIR_NODE_DEV_CAP_SCSI_GENERIC:
-        case VIR_NODE_DEV_CAP_DRM:
-        case VIR_NODE_DEV_CAP_MDEV:
-        case VIR_NODE_DEV_CAP_CCW_DEV:
-        case VIR_NODE_DEV_CAP_VDPA:
-        case VIR_NODE_DEV_CAP_AP_CARD:
-        case VIR_NODE_DEV_CAP_AP_QUEUE:
-        case VIR_NODE_DEV_CAP_VPD:
-        case VIR_NODE_DEV_CAP_LAST:
-            break;
-        }
-
-        if (addr)
-            break;
-    }
-
-    return addr;
-}
-
-
 virCommand *
 nodeDeviceGetMdevctlCommand(virNodeDeviceDef *def,
                             virMdevctlCommand cmd_type,
@@ -1202,17 +1133,6 @@ static void mdevGenerateDeviceName(virNodeDeviceDef *dev)
 }
 
 
-static bool
-matchDeviceAddress(virNodeDeviceObj *obj,
-                   const void *opaque)
-{
-    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
-    g_autofree char *addr = nodeDeviceObjFormatAddress(obj);
-
-    return STREQ_NULLABLE(addr, opaque);
-}
-
-
 static int
 nodeDeviceParseMdevctlAttributes(virMediatedDeviceConfig *config,
                                  virJSONValue *attrs)
@@ -1271,8 +1191,7 @@ nodeDeviceParseMdevctlChildDevice(const char *parent,
     /* Look up id of parent device. mdevctl supports defining mdevs for parent
      * devices that are not present on the system (to support starting mdevs on
      * hotplug, etc) so the parent may not actually exist. */
-    if ((parent_obj = virNodeDeviceObjListFind(driver->devs, matchDeviceAddress,
-                                               (void *)parent))) {
+    if ((parent_obj = virNodeDeviceObjListFindByAddress(driver->devs, parent))) {
         virNodeDeviceDef *parentdef = virNodeDeviceObjGetDef(parent_obj);
         child->parent = g_strdup(parentdef->name);
         virNodeDeviceObjEndAPI(&parent_obj);
@@ -2111,7 +2030,7 @@ int nodeDeviceDefPostParse(virNodeDeviceDef *def,
                 obj = virNodeDeviceObjListFindByName(driver->devs, def->parent);
 
             if (obj) {
-                caps->data.mdev.parent_addr = nodeDeviceObjFormatAddress(obj);
+                caps->data.mdev.parent_addr = virNodeDeviceDefFormatAddress(virNodeDeviceObjGetDef(obj));
                 virNodeDeviceObjEndAPI(&obj);
             }
         }
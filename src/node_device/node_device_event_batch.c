@@ -0,0 +1,242 @@
+/*
+ * node_device_event_batch.c: coalescing of device events
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "node_device_event_batch.h"
+#include "virlog.h"
+
+#define VIR_FROM_THIS VIR_FROM_NODEDEV
+
+VIR_LOG_INIT("node_device.node_device_event_batch");
+
+VIR_ENUM_IMPL(nodeDeviceEventAction,
+              NODE_DEVICE_EVENT_ACTION_LAST,
+              "add",
+              "change",
+              "remove",
+              "move",
+);
+
+/*
+ * Events for a device only depend on the state of the device at the
+ * time they are processed, not at the time they were emitted: both
+ * 'add' and 'change' re-read everything about the device. So as long
+ * as a batch is being collected, a later 'add' or 'change' supersedes
+ * an earlier one for the same device and a 'remove' supersedes both.
+ *
+ * A superseding 'add' or 'change' takes the place of the event it
+ * replaces. The kernel announces devices after their parent, which
+ * thus keeps being processed before its children even if it changes
+ * again later on. A 'remove' is queued at its own place, after the
+ * removal of any children.
+ */
+struct _nodeDeviceEventBatch {
+    /* nodeDeviceEvent *, NULL for events superseded by a 'remove' */
+    GPtrArray *events;
+    /* syspath -> index in @events of an 'add' or 'change' which
+     * can be superseded */
+    GHashTable *pending;
+    /* number of non-NULL entries in @events */
+    size_t len;
+    /* number of events passed to nodeDeviceEventBatchAdd */
+    size_t received;
+};
+
+
+void
+nodeDeviceEventFree(nodeDeviceEvent *event)
+{
+    if (!event)
+        return;
+
+    if (event->freePayload)
+        event->freePayload(event->payload);
+    g_free(event->syspath);
+    g_free(event);
+}
+
+
+nodeDeviceEventBatch *
+nodeDeviceEventBatchNew(void)
+{
+    nodeDeviceEventBatch *batch = g_new0(nodeDeviceEventBatch, 1);
+
+    batch->events = g_ptr_array_new_with_free_func((GDestroyNotify) nodeDeviceEventFree);
+    batch->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    return batch;
+}
+
+
+void
+nodeDeviceEventBatchFree(nodeDeviceEventBatch *batch)
+{
+    if (!batch)
+        return;
+
+    g_ptr_array_unref(batch->events);
+    g_hash_table_unref(batch->pending);
+    g_free(batch);
+}
+
+
+/**
+ * nodeDeviceEventBatchAdd:
+ * @batch: the batch
+ * @syspath: sysfs path of the device
+ * @action: action as reported by udev
+ * @payload: data to be passed along with the event
+ * @freePayload: function to free @payload
+ *
+ * Adds an event to @batch. Events with actions which don't need to be
+ * processed, e.g. 'bind', are dropped right away.
+ */
+void
+nodeDeviceEventBatchAdd(nodeDeviceEventBatch *batch,
+                        const char *syspath,
+                        const char *action,
+                        void *payload,
+                        GDestroyNotify freePayload)
+{
+    nodeDeviceEvent *event;
+    gpointer idx;
+    int act;
+
+    batch->received++;
+
+    if (!syspath || !action ||
+        (act = nodeDeviceEventActionTypeFromString(action)) < 0) {
+        VIR_DEBUG("ignoring '%s' event for '%s'", NULLSTR(action), NULLSTR(syspath));
+        if (freePayload)
+            freePayload(payload);
+        return;
+    }
+
+    event = g_new0(nodeDeviceEvent, 1);
+    event->syspath = g_strdup(syspath);
+    event->action = act;
+    event->payload = payload;
+    event->freePayload = freePayload;
+
+    if (g_hash_table_lookup_extended(batch->pending, syspath, NULL, &idx)) {
+        nodeDeviceEvent **old = (nodeDeviceEvent **) &g_ptr_array_index(batch->events,
+                                                                        GPOINTER_TO_SIZE(idx));
+
+        switch ((nodeDeviceEventAction) act) {
+        case NODE_DEVICE_EVENT_ACTION_ADD:
+        case NODE_DEVICE_EVENT_ACTION_CHANGE:
+            VIR_DEBUG("'%s' event for '%s' supersedes '%s'", action, syspath,
+                      nodeDeviceEventActionTypeToString((*old)->action));
+            if ((*old)->action == NODE_DEVICE_EVENT_ACTION_ADD)
+                event->action = NODE_DEVICE_EVENT_ACTION_ADD;
+            nodeDeviceEventFree(*old);
+            *old = event;
+            return;
+
+        case NODE_DEVICE_EVENT_ACTION_REMOVE:
+            VIR_DEBUG("'%s' event for '%s' supersedes '%s'", action, syspath,
+                      nodeDeviceEventActionTypeToString((*old)->action));
+            g_clear_pointer(old, nodeDeviceEventFree);
+            batch->len--;
+            break;
+
+        case NODE_DEVICE_EVENT_ACTION_MOVE:
+            /* the device is re-added under @syspath, keep whatever
+             * happened before that */
+            break;
+
+        case NODE_DEVICE_EVENT_ACTION_LAST:
+            break;
+        }
+
+        g_hash_table_remove(batch->pending, syspath);
+    }
+
+    g_ptr_array_add(batch->events, event);
+    batch->len++;
+
+    if (event->action == NODE_DEVICE_EVENT_ACTION_ADD ||
+        event->action == NODE_DEVICE_EVENT_ACTION_CHANGE) {
+        g_hash_table_insert(batch->pending, g_strdup(syspath),
+                            GSIZE_TO_POINTER(batch->events->len - 1));
+    }
+}
+
+
+/**
+ * nodeDeviceEventBatchLen:
+ * @batch: the batch
+ *
+ * Returns the number of events in @batch which are still to be processed.
+ */
+size_t
+nodeDeviceEventBatchLen(nodeDeviceEventBatch *batch)
+{
+    return batch->len;
+}
+
+
+/**
+ * nodeDeviceEventBatchReceived:
+ * @batch: the batch
+ *
+ * Returns the number of events added to @batch, including those which
+ * were dropped or superseded.
+ */
+size_t
+nodeDeviceEventBatchReceived(nodeDeviceEventBatch *batch)
+{
+    return batch->received;
+}
+
+
+/**
+ * nodeDeviceEventBatchSteal:
+ * @batch: the batch
+ *
+ * Takes the events which are to be processed out of @batch, which is
+ * empty afterwards.
+ *
+ * Returns an array of nodeDeviceEvent in the order they should be
+ * processed in.
+ */
+GPtrArray *
+nodeDeviceEventBatchSteal(nodeDeviceEventBatch *batch)
+{
+    GPtrArray *ret = g_ptr_array_new_full(batch->len,
+                                          (GDestroyNotify) nodeDeviceEventFree);
+    size_t i;
+
+    for (i = 0; i < batch->events->len; i++) {
+        nodeDeviceEvent **event = (nodeDeviceEvent **) &g_ptr_array_index(batch->events, i);
+
+        if (*event)
+            g_ptr_array_add(ret, g_steal_pointer(event));
+    }
+
+    VIR_DEBUG("processing %u events out of %zu received",
+              ret->len, batch->received);
+
+    g_ptr_array_set_size(batch->events, 0);
+    g_hash_table_remove_all(batch->pending);
+    batch->len = 0;
+    batch->received = 0;
+
+    return ret;
+}
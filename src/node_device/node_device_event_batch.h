@@ -0,0 +1,69 @@
+/*
+ * node_device_event_batch.h: coalescing of device events
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "virenum.h"
+
+typedef enum {
+    NODE_DEVICE_EVENT_ACTION_ADD,
+    NODE_DEVICE_EVENT_ACTION_CHANGE,
+    NODE_DEVICE_EVENT_ACTION_REMOVE,
+    NODE_DEVICE_EVENT_ACTION_MOVE,
+
+    NODE_DEVICE_EVENT_ACTION_LAST
+} nodeDeviceEventAction;
+
+VIR_ENUM_DECL(nodeDeviceEventAction);
+
+typedef struct _nodeDeviceEvent nodeDeviceEvent;
+struct _nodeDeviceEvent {
+    char *syspath;
+    nodeDeviceEventAction action;
+    void *payload;
+    GDestroyNotify freePayload;
+};
+
+void
+nodeDeviceEventFree(nodeDeviceEvent *event);
+
+typedef struct _nodeDeviceEventBatch nodeDeviceEventBatch;
+
+nodeDeviceEventBatch *
+nodeDeviceEventBatchNew(void);
+
+void
+nodeDeviceEventBatchFree(nodeDeviceEventBatch *batch);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(nodeDeviceEventBatch, nodeDeviceEventBatchFree);
+
+void
+nodeDeviceEventBatchAdd(nodeDeviceEventBatch *batch,
+                        const char *syspath,
+                        const char *action,
+                        void *payload,
+                        GDestroyNotify freePayload);
+
+size_t
+nodeDeviceEventBatchLen(nodeDeviceEventBatch *batch);
+
+size_t
+nodeDeviceEventBatchReceived(nodeDeviceEventBatch *batch);
+
+GPtrArray *
+nodeDeviceEventBatchSteal(nodeDeviceEventBatch *batch);
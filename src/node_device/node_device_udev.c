@@ -28,6 +28,8 @@
 
 #include "node_device_conf.h"
 #include "node_device_event.h"
+#include "node_device_cache.h"
+#include "node_device_event_batch.h"
 #include "node_device_driver.h"
 #include "node_device_udev.h"
 #include "virerror.h"
@@ -43,6 +45,8 @@
 #include "virnetdev.h"
 #include "virmdev.h"
 #include "virutil.h"
+#include "virthreadpool.h"
+#include "virtime.h"
 
 #include "configmake.h"
 
@@ -56,6 +60,23 @@ VIR_LOG_INIT("node_device.node_device_udev");
 
 #define DMI_DEVPATH "/sys/devices/virtual/dmi/id"
 
+/* udev events are collected for up to UDEV_EVENT_BATCH_WINDOW ms, or
+ * until there are UDEV_EVENT_BATCH_MAX of them, before being processed
+ * together */
+#define UDEV_EVENT_BATCH_WINDOW 100
+#define UDEV_EVENT_BATCH_MAX 1024
+
+/* Gathering the details of fewer devices than this is not worth
+ * handing out to the workers */
+#define UDEV_WORKERS_MIN_DEVICES 4
+#define UDEV_WORKERS_MAX 32
+
+/* Devices found while enumerating are gathered in chunks of this many */
+#define UDEV_ENUMERATE_CHUNK 256
+
+/* The VPD address space of a PCI device is 32KiB */
+#define UDEV_PCI_VPD_MAX 32768
+
 typedef struct _udevEventData udevEventData;
 struct _udevEventData {
     virObjectLockable parent;
@@ -72,6 +93,12 @@ struct _udevEventData {
     /* init thread */
     virThread *initThread;
 
+    /* workers gathering device details, see udevNewDeviceDefs() */
+    virThreadPool *workers;
+
+    /* copies of slow to read sysfs attributes, may be NULL */
+    nodeDeviceCache *cache;
+
     GList *mdevctlMonitors;
     virMutex mdevctlLock;
     int mdevctlTimeout;
@@ -88,6 +115,8 @@ udevEventDataDispose(void *obj)
     if (priv->watch != -1)
         virEventRemoveHandle(priv->watch);
 
+    g_clear_pointer(&priv->cache, nodeDeviceCacheFree);
+
     if (!priv->udev_monitor)
         return;
 
@@ -357,10 +386,36 @@ udevTranslatePCIIds(unsigned int vendor,
 }
 
 
+typedef struct _udevPCIVPDOpenData udevPCIVPDOpenData;
+struct _udevPCIVPDOpenData {
+    nodeDeviceCache *cache;
+    const char *generation;
+};
+
+
+/*
+ * The PCI spec allows the read-write part of the VPD to change
+ * dynamically, e.g. when the firmware updates it, without the device
+ * being re-added. Such changes are not seen as long as the copy taken
+ * for the current USEC_INITIALIZED is used; only the read-only fields
+ * libvirt reports can be relied upon to be up to date.
+ */
+static int
+udevPCIVPDOpen(const char *sysfsPath,
+               void *opaque)
+{
+    udevPCIVPDOpenData *data = opaque;
+
+    return nodeDeviceCacheOpen(data->cache, sysfsPath, "vpd",
+                               data->generation, UDEV_PCI_VPD_MAX);
+}
+
+
 static int
 udevProcessPCI(struct udev_device *device,
                virNodeDeviceDef *def)
 {
+    udevEventData *priv = driver->privateData;
     virNodeDevCapPCIDev *pci_dev = &def->caps->data.pci_dev;
     virPCIEDeviceInfo *pci_express = NULL;
     virPCIDevice *pciDev = NULL;
@@ -408,8 +463,21 @@ udevProcessPCI(struct udev_device *device,
                             &pci_dev->numa_node, 10) < 0)
         goto cleanup;
 
-    if (virNodeDeviceGetPCIDynamicCaps(def->sysfs_path, pci_dev) < 0)
-        goto cleanup;
+    /* Reading the VPD from the device is slow, use the copy taken
+     * when this instance of the device was first seen if possible */
+    if (priv->cache) {
+        udevPCIVPDOpenData vpd = {
+            .cache = priv->cache,
+            .generation = udev_device_get_property_value(device, "USEC_INITIALIZED"),
+        };
+
+        if (virNodeDeviceGetPCIDynamicCapsFull(def->sysfs_path, pci_dev,
+                                               udevPCIVPDOpen, &vpd) < 0)
+            goto cleanup;
+    } else {
+        if (virNodeDeviceGetPCIDynamicCaps(def->sysfs_path, pci_dev) < 0)
+            goto cleanup;
+    }
 
     devAddr.domain = pci_dev->domain;
     devAddr.bus = pci_dev->bus;
@@ -1444,8 +1512,10 @@ static void scheduleMdevctlUpdate(udevEventData *data, bool force);
 
 
 static int
-udevRemoveOneDeviceSysPath(const char *path)
+udevRemoveOneDeviceSysPath(const char *path,
+                           GPtrArray *events)
 {
+    udevEventData *priv = driver->privateData;
     virNodeDeviceObj *obj = NULL;
     virNodeDeviceDef *def;
     virObjectEvent *event = NULL;
@@ -1474,23 +1544,20 @@ udevRemoveOneDeviceSysPath(const char *path)
     }
     virNodeDeviceObjEndAPI(&obj);
 
+    if (priv->cache)
+        nodeDeviceCacheRemove(priv->cache, path);
+
     /* cannot check for mdev_types since they have already been removed */
-    scheduleMdevctlUpdate(driver->privateData, false);
+    scheduleMdevctlUpdate(priv, false);
 
-    virObjectEventStateQueue(driver->nodeDeviceEventState, event);
+    if (events)
+        g_ptr_array_add(events, event);
+    else
+        virObjectEventStateQueue(driver->nodeDeviceEventState, event);
     return 0;
 }
 
 
-static int
-udevRemoveOneDevice(struct udev_device *device)
-{
-    const char *path = udev_device_get_syspath(device);
-
-    return udevRemoveOneDeviceSysPath(path);
-}
-
-
 static int
 udevSetParent(struct udev_device *device,
               virNodeDeviceDef *def)
@@ -1532,10 +1599,156 @@ udevSetParent(struct udev_device *device,
     return 0;
 }
 
+
+/*
+ * Gathers everything about @device that does not depend on other node
+ * devices. This only ever touches @device itself, which allows
+ * udevNewDeviceDefs() to call it for several devices in parallel.
+ */
+static virNodeDeviceDef *
+udevNewDeviceDef(struct udev_device *device)
+{
+    g_autoptr(virNodeDeviceDef) def = g_new0(virNodeDeviceDef, 1);
+
+    def->sysfs_path = g_strdup(udev_device_get_syspath(device));
+
+    udevGetStringProperty(device, "DRIVER", &def->driver);
+
+    def->caps = g_new0(virNodeDevCapsDef, 1);
+
+    if (udevGetDeviceType(device, &def->caps->data.type) != 0 ||
+        udevGetDeviceNodes(device, def) != 0 ||
+        udevGetDeviceDetails(device, def) != 0) {
+        VIR_DEBUG("Discarding device %p %s", def, NULLSTR(def->sysfs_path));
+        return NULL;
+    }
+
+    return g_steal_pointer(&def);
+}
+
+
+typedef struct _udevNewDeviceDefJobs udevNewDeviceDefJobs;
+struct _udevNewDeviceDefJobs {
+    virMutex lock;
+    virCond cond;
+    size_t pending;
+};
+
+typedef struct _udevNewDeviceDefJob udevNewDeviceDefJob;
+struct _udevNewDeviceDefJob {
+    struct udev_device *device;
+    virNodeDeviceDef **def;
+    udevNewDeviceDefJobs *jobs;
+};
+
+
+static void
+udevNewDeviceDefWorker(void *jobdata,
+                       void *opaque G_GNUC_UNUSED)
+{
+    udevNewDeviceDefJob *job = jobdata;
+
+    *job->def = udevNewDeviceDef(job->device);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&job->jobs->lock) {
+        if (--job->jobs->pending == 0)
+            virCondSignal(&job->jobs->cond);
+    }
+}
+
+
+/**
+ * udevNewDeviceDefs:
+ * @priv: udev event data
+ * @devices: devices to gather details of, NULL entries are skipped
+ * @defs: filled with the definitions, or NULL for devices which failed
+ * @ndevices: number of items in @devices and @defs
+ *
+ * Calls udevNewDeviceDef() for each of @devices. Reading sysfs is the
+ * bulk of the work for every device, so this is spread over the
+ * workers in @priv when there are enough devices.
+ */
+static void
+udevNewDeviceDefs(udevEventData *priv,
+                  struct udev_device **devices,
+                  virNodeDeviceDef **defs,
+                  size_t ndevices)
+{
+    g_autofree udevNewDeviceDefJob *job = NULL;
+    udevNewDeviceDefJobs jobs = { 0 };
+    bool parallel = false;
+    size_t i;
+
+    if (priv->workers && ndevices >= UDEV_WORKERS_MIN_DEVICES &&
+        virMutexInit(&jobs.lock) == 0) {
+        if (virCondInit(&jobs.cond) == 0)
+            parallel = true;
+        else
+            virMutexDestroy(&jobs.lock);
+    }
+
+    if (!parallel) {
+        for (i = 0; i < ndevices; i++) {
+            if (devices[i])
+                defs[i] = udevNewDeviceDef(devices[i]);
+        }
+        return;
+    }
+
+    job = g_new0(udevNewDeviceDefJob, ndevices);
+
+    for (i = 0; i < ndevices; i++) {
+        virNodeDevCapType type;
+
+        if (!devices[i])
+            continue;
+
+        /* libudev objects are not thread safe. Devices can be handled
+         * in parallel only as long as no new udev_device is created
+         * from the shared udev context, which udevProcessMediatedDevice()
+         * does by looking up the parent device. */
+        if (udevGetDeviceType(devices[i], &type) == 0 &&
+            type == VIR_NODE_DEV_CAP_MDEV) {
+            defs[i] = udevNewDeviceDef(devices[i]);
+            continue;
+        }
+
+        job[i].device = devices[i];
+        job[i].def = &defs[i];
+        job[i].jobs = &jobs;
+
+        VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+            jobs.pending++;
+        }
+
+        if (virThreadPoolSendJob(priv->workers, 0, &job[i]) < 0) {
+            VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+                jobs.pending--;
+            }
+            defs[i] = udevNewDeviceDef(devices[i]);
+        }
+    }
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+        while (jobs.pending > 0)
+            ignore_value(virCondWait(&jobs.cond, &jobs.lock));
+    }
+
+    virCondDestroy(&jobs.cond);
+    virMutexDestroy(&jobs.lock);
+}
+
+
+/*
+ * Adds @def, gathered by udevNewDeviceDef() from @device, to the list
+ * of node devices. @def is consumed. The resulting lifecycle event is
+ * appended to @events if given, or queued right away otherwise.
+ */
 static int
-udevAddOneDevice(struct udev_device *device)
+udevAddOneDeviceDef(struct udev_device *device,
+                    virNodeDeviceDef *def,
+                    GPtrArray *events)
 {
-    virNodeDeviceDef *def = NULL;
     virNodeDeviceObj *obj = NULL;
     virNodeDeviceDef *objdef;
     virObjectEvent *event = NULL;
@@ -1546,23 +1759,6 @@ udevAddOneDevice(struct udev_device *device)
     bool is_mdev;
     bool has_mdev_types = false;
 
-    def = g_new0(virNodeDeviceDef, 1);
-
-    def->sysfs_path = g_strdup(udev_device_get_syspath(device));
-
-    udevGetStringProperty(device, "DRIVER", &def->driver);
-
-    def->caps = g_new0(virNodeDevCapsDef, 1);
-
-    if (udevGetDeviceType(device, &def->caps->data.type) != 0)
-        goto cleanup;
-
-    if (udevGetDeviceNodes(device, def) != 0)
-        goto cleanup;
-
-    if (udevGetDeviceDetails(device, def) != 0)
-        goto cleanup;
-
     if (udevSetParent(device, def) != 0)
         goto cleanup;
 
@@ -1609,7 +1805,10 @@ udevAddOneDevice(struct udev_device *device)
     ret = 0;
 
  cleanup:
-    virObjectEventStateQueue(driver->nodeDeviceEventState, event);
+    if (events && event)
+        g_ptr_array_add(events, event);
+    else
+        virObjectEventStateQueue(driver->nodeDeviceEventState, event);
 
     if (ret != 0) {
         VIR_DEBUG("Discarding device %d %p %s", ret, def,
@@ -1621,29 +1820,33 @@ udevAddOneDevice(struct udev_device *device)
 }
 
 
-static int
-udevProcessDeviceListEntry(struct udev *udev,
-                           struct udev_list_entry *list_entry)
+/*
+ * Adds the @ndevices devices in @devices, which are unreferenced. The
+ * details of the devices are gathered in parallel, the devices are
+ * added in order so that parents keep preceding their children.
+ */
+static void
+udevProcessDeviceList(udevEventData *priv,
+                      struct udev_device **devices,
+                      size_t ndevices)
 {
-    struct udev_device *device;
-    const char *name = NULL;
-    int ret = -1;
+    g_autofree virNodeDeviceDef **defs = g_new0(virNodeDeviceDef *, ndevices);
+    size_t i;
 
-    name = udev_list_entry_get_name(list_entry);
+    udevNewDeviceDefs(priv, devices, defs, ndevices);
 
-    device = udev_device_new_from_syspath(udev, name);
+    for (i = 0; i < ndevices; i++) {
+        if (!devices[i])
+            continue;
 
-    if (device != NULL) {
-        if (udevAddOneDevice(device) != 0) {
+        if (!defs[i] ||
+            udevAddOneDeviceDef(devices[i], g_steal_pointer(&defs[i]), NULL) != 0) {
             VIR_DEBUG("Failed to create node device for udev device '%s'",
-                      name);
+                      udev_device_get_syspath(devices[i]));
         }
-        ret = 0;
-    }
 
-    udev_device_unref(device);
-
-    return ret;
+        g_clear_pointer(&devices[i], udev_device_unref);
+    }
 }
 
 
@@ -1674,8 +1877,11 @@ udevEnumerateAddMatches(struct udev_enumerate *udev_enumerate)
 static int
 udevEnumerateDevices(struct udev *udev)
 {
+    udevEventData *priv = driver->privateData;
     struct udev_enumerate *udev_enumerate = NULL;
     struct udev_list_entry *list_entry = NULL;
+    struct udev_device *devices[UDEV_ENUMERATE_CHUNK] = { 0 };
+    size_t ndevices = 0;
     int ret = -1;
 
     udev_enumerate = udev_enumerate_new(udev);
@@ -1685,12 +1891,23 @@ udevEnumerateDevices(struct udev *udev)
     if (udev_enumerate_scan_devices(udev_enumerate) < 0)
         VIR_WARN("udev scan devices failed");
 
+    /* Creating the udev_device objects uses the shared udev context
+     * and is done here, gathering their details is left to the workers */
     udev_list_entry_foreach(list_entry,
                             udev_enumerate_get_list_entry(udev_enumerate)) {
+        const char *name = udev_list_entry_get_name(list_entry);
 
-        udevProcessDeviceListEntry(udev, list_entry);
+        if (!(devices[ndevices] = udev_device_new_from_syspath(udev, name)))
+            continue;
+
+        if (++ndevices == G_N_ELEMENTS(devices)) {
+            udevProcessDeviceList(priv, devices, ndevices);
+            ndevices = 0;
+        }
     }
 
+    udevProcessDeviceList(priv, devices, ndevices);
+
     ret = 0;
  cleanup:
     udev_enumerate_unref(udev_enumerate);
@@ -1733,6 +1950,7 @@ nodeStateCleanup(void)
             virThreadJoin(priv->th);
             g_clear_pointer(&priv->th, g_free);
         }
+        g_clear_pointer(&priv->workers, virThreadPoolFree);
     }
 
     virObjectUnref(priv);
@@ -1753,42 +1971,104 @@ nodeStateCleanup(void)
 }
 
 
+/*
+ * Processes one udev event. @def is what udevNewDeviceDef() gathered
+ * for the device unless the device is being removed, it's consumed.
+ */
 static int
-udevHandleOneDevice(struct udev_device *device)
+udevHandleOneEvent(nodeDeviceEvent *event,
+                   virNodeDeviceDef *def,
+                   GPtrArray *events)
 {
+    struct udev_device *device = event->payload;
     virNodeDevCapType dev_cap_type;
-    const char *action = udev_device_get_action(device);
+    const char *devpath_old;
+    int ret;
 
-    VIR_DEBUG("udev action: '%s': %s", action, udev_device_get_syspath(device));
+    VIR_DEBUG("udev action: '%s': %s",
+              nodeDeviceEventActionTypeToString(event->action), event->syspath);
 
-    if (STREQ(action, "add") || STREQ(action, "change")) {
-        int ret = udevAddOneDevice(device);
+    switch (event->action) {
+    case NODE_DEVICE_EVENT_ACTION_ADD:
+    case NODE_DEVICE_EVENT_ACTION_CHANGE:
+        if (!def)
+            return -1;
+
+        ret = udevAddOneDeviceDef(device, def, events);
         if (ret == 0 &&
             udevGetDeviceType(device, &dev_cap_type) == 0 &&
             dev_cap_type == VIR_NODE_DEV_CAP_MDEV)
             scheduleMdevctlUpdate(driver->privateData, false);
         return ret;
-    }
 
-    if (STREQ(action, "remove"))
-        return udevRemoveOneDevice(device);
+    case NODE_DEVICE_EVENT_ACTION_REMOVE:
+        return udevRemoveOneDeviceSysPath(event->syspath, events);
 
-    if (STREQ(action, "move")) {
-        const char *devpath_old = udevGetDeviceProperty(device, "DEVPATH_OLD");
+    case NODE_DEVICE_EVENT_ACTION_MOVE:
+        devpath_old = udevGetDeviceProperty(device, "DEVPATH_OLD");
 
         if (devpath_old) {
             g_autofree char *devpath_old_fixed = g_strdup_printf("/sys%s", devpath_old);
 
-            udevRemoveOneDeviceSysPath(devpath_old_fixed);
+            udevRemoveOneDeviceSysPath(devpath_old_fixed, events);
         }
 
-        return udevAddOneDevice(device);
+        if (!def)
+            return -1;
+
+        return udevAddOneDeviceDef(device, def, events);
+
+    case NODE_DEVICE_EVENT_ACTION_LAST:
+        break;
     }
 
+    virNodeDeviceDefFree(def);
     return 0;
 }
 
 
+/**
+ * udevProcessEventBatch:
+ * @priv: udev event data
+ * @batch: collected events
+ *
+ * Processes all events collected in @batch. The details of all the
+ * devices are gathered first, in parallel, before the events are
+ * applied to the list of node devices in order. The lifecycle events
+ * are queued only once the whole batch was applied so that clients
+ * reacting to them see a consistent device tree.
+ */
+static void
+udevProcessEventBatch(udevEventData *priv,
+                      nodeDeviceEventBatch *batch)
+{
+    g_autoptr(GPtrArray) todo = nodeDeviceEventBatchSteal(batch);
+    g_autoptr(GPtrArray) events = g_ptr_array_new();
+    g_autofree struct udev_device **devices = NULL;
+    g_autofree virNodeDeviceDef **defs = NULL;
+    size_t i;
+
+    devices = g_new0(struct udev_device *, todo->len);
+    defs = g_new0(virNodeDeviceDef *, todo->len);
+
+    for (i = 0; i < todo->len; i++) {
+        nodeDeviceEvent *event = g_ptr_array_index(todo, i);
+
+        if (event->action != NODE_DEVICE_EVENT_ACTION_REMOVE)
+            devices[i] = event->payload;
+    }
+
+    udevNewDeviceDefs(priv, devices, defs, todo->len);
+
+    for (i = 0; i < todo->len; i++)
+        udevHandleOneEvent(g_ptr_array_index(todo, i), defs[i], events);
+
+    for (i = 0; i < events->len; i++)
+        virObjectEventStateQueue(driver->nodeDeviceEventState,
+                                 g_ptr_array_index(events, i));
+}
+
+
 /* the caller must be holding the udevEventData object lock prior to calling
  * this function
  */
@@ -1837,29 +2117,56 @@ udevEventMonitorSanityCheck(udevEventData *priv,
  * based algorithm. Although the issue can be mitigated by resetting
  * priv->dataReady for each event found; however, the scheduler issues
  * would still come into play.
+ *
+ * Events are not processed one by one, but collected into a batch for
+ * up to UDEV_EVENT_BATCH_WINDOW ms after the first one arrived, which
+ * allows bursts of events, e.g. from a SCSI rescan, to be coalesced,
+ * see udevProcessEventBatch().
  */
 static void
 udevEventHandleThread(void *opaque G_GNUC_UNUSED)
 {
     udevEventData *priv = driver->privateData;
+    g_autoptr(nodeDeviceEventBatch) batch = nodeDeviceEventBatchNew();
+    unsigned long long deadline = 0;
+    unsigned long long now;
     struct udev_device *device = NULL;
 
     /* continue rather than break from the loop on non-fatal errors */
     while (1) {
+        bool flush = false;
+
         VIR_WITH_OBJECT_LOCK_GUARD(priv) {
-            while (!priv->dataReady && !priv->threadQuit) {
-                if (virCondWait(&priv->threadCond, &priv->parent.lock)) {
-                    virReportSystemError(errno, "%s",
-                                         _("handler failed to wait on condition"));
-                    return;
+            while (!priv->dataReady && !priv->threadQuit && !flush) {
+                if (nodeDeviceEventBatchLen(batch) == 0) {
+                    if (virCondWait(&priv->threadCond, &priv->parent.lock)) {
+                        virReportSystemError(errno, "%s",
+                                             _("handler failed to wait on condition"));
+                        return;
+                    }
+                } else if (virCondWaitUntil(&priv->threadCond,
+                                            &priv->parent.lock, deadline) < 0) {
+                    if (errno != ETIMEDOUT) {
+                        virReportSystemError(errno, "%s",
+                                             _("handler failed to wait on condition"));
+                        return;
+                    }
+                    flush = true;
                 }
             }
 
             if (priv->threadQuit)
                 return;
 
-            errno = 0;
-            device = udev_monitor_receive_device(priv->udev_monitor);
+            if (!flush) {
+                errno = 0;
+                device = udev_monitor_receive_device(priv->udev_monitor);
+            }
+        }
+
+        if (flush) {
+            udevProcessEventBatch(priv, batch);
+            continue;
         }
 
         if (!device) {
@@ -1892,13 +2199,24 @@ udevEventHandleThread(void *opaque G_GNUC_UNUSED)
             continue;
         }
 
-        udevHandleOneDevice(device);
-        udev_device_unref(device);
+        if (virTimeMillisNow(&now) < 0)
+            now = 0;
+
+        if (nodeDeviceEventBatchLen(batch) == 0)
+            deadline = now + UDEV_EVENT_BATCH_WINDOW;
+
+        nodeDeviceEventBatchAdd(batch,
+                                udev_device_get_syspath(device),
+                                udev_device_get_action(device),
+                                device, (GDestroyNotify) udev_device_unref);
 
-        /* Instead of waiting for the next event after processing @device
-         * data, let's keep reading from the udev monitor and only wait
-         * for the next event once either a EAGAIN or a EWOULDBLOCK error
-         * is encountered. */
+        /* Instead of waiting for the next event after queueing @device,
+         * let's keep reading from the udev monitor and only wait for the
+         * next event once either a EAGAIN or a EWOULDBLOCK error is
+         * encountered, unless the batch is due already. */
+        if (nodeDeviceEventBatchLen(batch) >= UDEV_EVENT_BATCH_MAX ||
+            now >= deadline)
+            udevProcessEventBatch(priv, batch);
     }
 }
 
@@ -2238,6 +2556,7 @@ nodeStateInitialize(bool privileged,
 {
     udevEventData *priv = NULL;
     struct udev *udev = NULL;
+    g_autofree char *cachedir = NULL;
 
     if (root != NULL) {
         virReportError(VIR_ERR_INVALID_ARG, "%s",
@@ -2283,6 +2602,8 @@ nodeStateInitialize(bool privileged,
          virPidFileAcquire(driver->stateDir, "driver", getpid())) < 0)
         goto cleanup;
 
+    cachedir = g_strdup_printf("%s/cache", driver->stateDir);
+
     if (!(driver->devs = virNodeDeviceObjListNew()) ||
         !(priv = udevEventDataNew()))
         goto cleanup;
@@ -2321,6 +2642,20 @@ nodeStateInitialize(bool privileged,
         udev_monitor_set_receive_buffer_size(priv->udev_monitor,
                                              128 * 1024 * 1024);
 
+    if (!(priv->cache = nodeDeviceCacheNew(cachedir))) {
+        VIR_WARN("not caching device attributes: %s", virGetLastErrorMessage());
+        virResetLastError();
+    }
+
+    if (!(priv->workers = virThreadPoolNewFull(0,
+                                               MIN(g_get_num_processors(),
+                                                   UDEV_WORKERS_MAX),
+                                               0,
+                                               udevNewDeviceDefWorker,
+                                               "nodedev-worker",
+                                               NULL, NULL)))
+        goto unlock;
+
     priv->th = g_new0(virThread, 1);
     if (virThreadCreateFull(priv->th, true, udevEventHandleThread,
                             "udev-event", false, NULL) < 0) {
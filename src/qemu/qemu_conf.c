@@ -31,6 +31,7 @@
 #include "qemu_capabilities.h"
 #include "qemu_domain.h"
 #include "qemu_firmware.h"
+#include "qemu_hostdev.h"
 #include "qemu_namespace.h"
 #include "qemu_security.h"
 #include "viruuid.h"
@@ -38,6 +39,7 @@
 #include "viralloc.h"
 #include "virxml.h"
 #include "virlog.h"
+#include "virprobe.h"
 #include "cpu/cpu.h"
 #include "domain_driver.h"
 #include "virfile.h"
@@ -46,6 +48,10 @@
 #include "configmake.h"
 #include "security/security_util.h"
 
+#ifdef WITH_DTRACE_PROBES
+# include "libvirt_qemu_probes.h"
+#endif
+
 #define VIR_FROM_THIS VIR_FROM_QEMU
 
 VIR_LOG_INIT("qemu.qemu_conf");
@@ -73,6 +79,11 @@ VIR_ENUM_IMPL(virQEMUSchedCore,
               "emulator",
               "full");
 
+VIR_ENUM_IMPL(virQEMUNumaPlacement,
+              QEMU_NUMA_PLACEMENT_LAST,
+              "numad",
+              "builtin");
+
 
 static virClass *virQEMUDriverConfigClass;
 static void virQEMUDriverConfigDispose(void *obj);
@@ -272,6 +283,13 @@ virQEMUDriverConfig *virQEMUDriverConfigNew(bool privileged,
     cfg->glusterDebugLevel = 4;
     cfg->stdioLogD = true;
 
+#if WITH_NUMAD
+    cfg->numaPlacement = QEMU_NUMA_PLACEMENT_NUMAD;
+#else
+    cfg->numaPlacement = QEMU_NUMA_PLACEMENT_BUILTIN;
+#endif
+    cfg->numaRebalanceThreshold = 20;
+
     cfg->namespaces = virBitmapNew(QEMU_DOMAIN_NS_LAST);
 
     if (privileged &&
@@ -633,6 +651,7 @@ virQEMUDriverConfigLoadProcessEntry(virQEMUDriverConfig *cfg,
     g_autofree char *stdioHandler = NULL;
     g_autofree char *corestr = NULL;
     g_autofree char *schedCore = NULL;
+    g_autofree char *numaPlacement = NULL;
     size_t i;
 
     if (virConfGetValueStringList(conf, "hugetlbfs_mount", true,
@@ -739,6 +758,72 @@ virQEMUDriverConfigLoadProcessEntry(virQEMUDriverConfig *cfg,
         cfg->schedCore = val;
     }
 
+    if (virConfGetValueString(conf, "numa_placement", &numaPlacement) < 0)
+        return -1;
+    if (numaPlacement) {
+        int val = virQEMUNumaPlacementTypeFromString(numaPlacement);
+
+        if (val < 0) {
+            virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
+                           _("Unknown numa_placement value %1$s"),
+                           numaPlacement);
+            return -1;
+        }
+
+#if !WITH_NUMAD
+        if (val == QEMU_NUMA_PLACEMENT_NUMAD) {
+            virReportError(VIR_ERR_CONFIG_UNSUPPORTED, "%s",
+                           _("numad is not available on this host"));
+            return -1;
+        }
+#endif
+
+        cfg->numaPlacement = val;
+    }
+
+    if (virConfGetValueUInt(conf, "numa_rebalance_interval",
+                            &cfg->numaRebalanceInterval) < 0)
+        return -1;
+    if (cfg->numaRebalanceInterval > 86400) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("numa_rebalance_interval must not be greater than 86400"));
+        return -1;
+    }
+    if (virConfGetValueUInt(conf, "numa_rebalance_threshold",
+                            &cfg->numaRebalanceThreshold) < 0)
+        return -1;
+    if (cfg->numaRebalanceThreshold > 200) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("numa_rebalance_threshold must not be greater than 200"));
+        return -1;
+    }
+
+    if (virConfGetValueUInt(conf, "resctrl_sample_interval",
+                            &cfg->resctrlSampleInterval) < 0)
+        return -1;
+    if (cfg->resctrlSampleInterval > 86400) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("resctrl_sample_interval must not be greater than 86400"));
+        return -1;
+    }
+    if (virConfGetValueUInt(conf, "memory_bandwidth_limit",
+                            &cfg->memoryBandwidthLimit) < 0)
+        return -1;
+    if (cfg->memoryBandwidthLimit > 0 && cfg->resctrlSampleInterval == 0) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("memory_bandwidth_limit requires resctrl_sample_interval to be set"));
+        return -1;
+    }
+
+    if (virConfGetValueUInt(conf, "hugepage_pool_max_percent",
+                            &cfg->hugepagePoolMaxPercent) < 0)
+        return -1;
+    if (cfg->hugepagePoolMaxPercent > 100) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("hugepage_pool_max_percent must not be greater than 100"));
+        return -1;
+    }
+
     return 0;
 }
 
@@ -1337,6 +1422,7 @@ virQEMUDriverCreateXMLConf(virQEMUDriver *driver,
                                 &virQEMUDriverDomainJobConfig);
 
     virDomainXMLOptionSetCloseCallbackAlloc(ret, virCloseCallbacksDomainAlloc);
+    virDomainXMLOptionSetObjViews(ret, true);
 
     return ret;
 }
@@ -1505,6 +1591,110 @@ virQEMUDriverGetDomainCapabilities(virQEMUDriver *driver,
 }
 
 
+typedef struct _virQEMUDomainCapsCacheEntry virQEMUDomainCapsCacheEntry;
+struct _virQEMUDomainCapsCacheEntry {
+    virQEMUCaps *qemuCaps;
+    char *firmwareStamp;
+    bool supportsVFIO;
+    char *xml;
+};
+
+
+static void
+virQEMUDomainCapsCacheEntryFree(void *opaque)
+{
+    virQEMUDomainCapsCacheEntry *entry = opaque;
+
+    if (!entry)
+        return;
+
+    virObjectUnref(entry->qemuCaps);
+    g_free(entry->firmwareStamp);
+    g_free(entry->xml);
+    g_free(entry);
+}
+
+
+/**
+ * virQEMUDriverGetDomainCapabilitiesXML:
+ *
+ * Get formatted domain capabilities XML. The result is cached per emulator,
+ * arch, machine type, and virt type and reused as long as @qemuCaps is the
+ * same object (i.e., the capabilities cache was not refreshed) and neither
+ * the firmware descriptors nor the host VFIO support changed.
+ *
+ * Returns: domain capabilities XML the caller has to free or NULL
+ */
+char *
+virQEMUDriverGetDomainCapabilitiesXML(virQEMUDriver *driver,
+                                      virQEMUCaps *qemuCaps,
+                                      const char *machine,
+                                      virArch arch,
+                                      virDomainVirtType virttype)
+{
+    g_autoptr(virDomainCaps) domCaps = NULL;
+    g_autofree char *key = NULL;
+    g_autofree char *firmwareStamp = NULL;
+    bool supportsVFIO = qemuHostdevHostSupportsPassthroughVFIO();
+    virQEMUDomainCapsCacheEntry *entry;
+    char *xml = NULL;
+
+    key = g_strdup_printf("%s:%s:%s:%s",
+                          virQEMUCapsGetBinary(qemuCaps),
+                          virArchToString(arch),
+                          NULLSTR(machine),
+                          virDomainVirtTypeToString(virttype));
+
+    if (!(firmwareStamp = qemuFirmwareGetConfigsStamp(driver->privileged)))
+        return NULL;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        if (!driver->domCapsCache)
+            driver->domCapsCache = virHashNew(virQEMUDomainCapsCacheEntryFree);
+
+        entry = virHashLookup(driver->domCapsCache, key);
+        if (entry &&
+            entry->qemuCaps == qemuCaps &&
+            entry->supportsVFIO == supportsVFIO &&
+            STREQ(entry->firmwareStamp, firmwareStamp)) {
+            driver->domCapsCacheHits++;
+            xml = g_strdup(entry->xml);
+        } else {
+            driver->domCapsCacheMisses++;
+        }
+
+        PROBE(QEMU_DOMCAPS_CACHE_LOOKUP,
+              "key=%s hit=%d hits=%llu misses=%llu",
+              key, !!xml,
+              driver->domCapsCacheHits, driver->domCapsCacheMisses);
+    }
+
+    if (xml)
+        return xml;
+
+    if (!(domCaps = virQEMUDriverGetDomainCapabilities(driver, qemuCaps,
+                                                       machine, arch,
+                                                       virttype)))
+        return NULL;
+
+    if (!(xml = virDomainCapsFormat(domCaps)))
+        return NULL;
+
+    entry = g_new0(virQEMUDomainCapsCacheEntry, 1);
+    entry->qemuCaps = virObjectRef(qemuCaps);
+    entry->firmwareStamp = g_steal_pointer(&firmwareStamp);
+    entry->supportsVFIO = supportsVFIO;
+    entry->xml = g_strdup(xml);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        if (virHashUpdateEntry(driver->domCapsCache, key, entry) < 0)
+            virQEMUDomainCapsCacheEntryFree(entry);
+    }
+
+    return xml;
+}
+
+
 int qemuDriverAllocateID(virQEMUDriver *driver)
 {
     return g_atomic_int_add(&driver->lastvmid, 1) + 1;
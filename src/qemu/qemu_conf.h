@@ -56,8 +56,19 @@ typedef enum {
 
 VIR_ENUM_DECL(virQEMUSchedCore);
 
+typedef enum {
+    QEMU_NUMA_PLACEMENT_NUMAD = 0,
+    QEMU_NUMA_PLACEMENT_BUILTIN,
+
+    QEMU_NUMA_PLACEMENT_LAST
+} virQEMUNumaPlacement;
+
+VIR_ENUM_DECL(virQEMUNumaPlacement);
+
 typedef struct _virQEMUDriver virQEMUDriver;
 
+typedef struct _qemuHugepageLedger qemuHugepageLedger;
+
 typedef struct _virQEMUDriverConfig virQEMUDriverConfig;
 
 /* Main driver config. The data in these object
@@ -233,6 +244,15 @@ struct _virQEMUDriverConfig {
     bool storageUseNbdkit;
 
     virQEMUSchedCore schedCore;
+
+    virQEMUNumaPlacement numaPlacement;
+    unsigned int numaRebalanceInterval;
+    unsigned int numaRebalanceThreshold;
+
+    unsigned int resctrlSampleInterval;
+    unsigned int memoryBandwidthLimit;
+
+    unsigned int hugepagePoolMaxPercent;
 };
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virQEMUDriverConfig, virObjectUnref);
@@ -252,6 +272,10 @@ struct _virQEMUDriver {
     /* Immutable pointer, self-locking APIs */
     virThreadPool *workerPool;
 
+    /* Immutable pointer, self-locking APIs. Gathers domain stats, see
+     * qemuDomainGetStatsList. */
+    virThreadPool *statsPool;
+
     /* Atomic increment only */
     int lastvmid;
 
@@ -323,6 +347,32 @@ struct _virQEMUDriver {
 
     /* Immutable pointer, self-locking APIs */
     virFileCache *nbdkitCapsCache;
+
+    /* Lazy initialized on first use, require lock to access the table
+     * and the counters. Maps emulator, arch, machine and virt type to
+     * formatted domain capabilities XML. The counters are reported by
+     * the qemu_domcaps_cache_lookup probe. */
+    GHashTable *domCapsCache;
+    unsigned long long domCapsCacheHits;
+    unsigned long long domCapsCacheMisses;
+
+    /* Require lock to access. Number of vCPUs of domains with automatic
+     * NUMA placement per host NUMA node, indexed by node number. */
+    unsigned int *numaNodeVcpus;
+    size_t nnumaNodeVcpus;
+
+    /* Immutable value, -1 if periodic NUMA rebalancing is disabled */
+    int numaRebalanceTimer;
+
+    /* Require lock to access. Number of domains moved to other host NUMA
+     * nodes in the current rebalancing interval. */
+    unsigned int numaRebalanceMoves;
+
+    /* Immutable value, -1 if periodic resctrl sampling is disabled */
+    int resctrlSampleTimer;
+
+    /* Immutable pointer, self-locking APIs */
+    qemuHugepageLedger *hugepageLedger;
 };
 
 virQEMUDriverConfig *virQEMUDriverConfigNew(bool privileged,
@@ -352,6 +402,13 @@ virQEMUDriverGetDomainCapabilities(virQEMUDriver *driver,
                                    virArch arch,
                                    virDomainVirtType virttype);
 
+char *
+virQEMUDriverGetDomainCapabilitiesXML(virQEMUDriver *driver,
+                                      virQEMUCaps *qemuCaps,
+                                      const char *machine,
+                                      virArch arch,
+                                      virDomainVirtType virttype);
+
 int qemuDriverAllocateID(virQEMUDriver *driver);
 virDomainXMLOption *virQEMUDriverCreateXMLConf(virQEMUDriver *driver,
                                                  const char *defsecmodel);
@@ -456,6 +456,27 @@ qemuDomainObjFromDomain(virDomainPtr domain)
 }
 
 
+/**
+ * qemuDomainObjViewFromDomain:
+ * @domain: Domain pointer that has to be looked up
+ *
+ * This function looks up @domain and returns a read-only view of its
+ * definition and state without locking the domain object, so that it
+ * doesn't wait for jobs running on the domain.
+ *
+ * Returns the view which has to be released by virObjectUnref(), or NULL
+ * without an error if there's none and the caller has to use
+ * qemuDomainObjFromDomain() instead.
+ */
+virDomainObjView *
+qemuDomainObjViewFromDomain(virDomainPtr domain)
+{
+    virQEMUDriver *driver = domain->conn->privateData;
+
+    return virDomainObjListFindViewByUUID(driver->domains, domain->uuid);
+}
+
+
 static virClass *qemuDomainSaveCookieClass;
 
 static void qemuDomainSaveCookieDispose(void *obj);
@@ -898,6 +919,7 @@ qemuDomainVcpuPrivateDispose(void *obj)
     g_free(priv->alias);
     virJSONValueFree(priv->props);
     g_free(priv->qomPath);
+    virPerfFree(priv->perf);
     return;
 }
 
@@ -1833,10 +1855,12 @@ qemuDomainObjPrivateDataClear(qemuDomainObjPrivate *priv)
     /* remove automatic pinning data */
     g_clear_pointer(&priv->autoNodeset, virBitmapFree);
     g_clear_pointer(&priv->autoCpuset, virBitmapFree);
+    priv->numaRebalanceTime = 0;
     g_clear_pointer(&priv->pciaddrs, virDomainPCIAddressSetFree);
     g_clear_pointer(&priv->usbaddrs, virDomainUSBAddressSetFree);
     g_clear_pointer(&priv->origCPU, virCPUDefFree);
     g_clear_pointer(&priv->namespaces, virBitmapFree);
+    g_clear_pointer(&priv->nsagent, virNSAgentFree);
 
     priv->rememberOwner = false;
 
@@ -6418,6 +6442,9 @@ qemuDomainSaveStatus(virDomainObj *obj)
     virQEMUDriver *driver = priv->driver;
     g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
 
+    /* the status changed, possibly outside of a job */
+    virDomainObjInvalidateView(obj);
+
     if (virDomainObjIsActive(obj)) {
         if (virDomainObjSave(obj, driver->xmlopt, cfg->stateDir) < 0)
             VIR_WARN("Failed to save status on vm %s", obj->def->name);
@@ -10079,6 +10106,8 @@ qemuDomainRefreshVcpuInfo(virDomainObj *vm,
         }
     }
 
+    qemuDomainPerfRefreshVcpus(vm);
+
     ret = 0;
 
  cleanup:
@@ -10086,6 +10115,75 @@ qemuDomainRefreshVcpuInfo(virDomainObj *vm,
     return ret;
 }
 
+
+/* Hardware events which are counted for each vCPU thread too, if they are
+ * enabled for the domain */
+static const virPerfEventType qemuDomainVcpuPerfEvents[] = {
+    VIR_PERF_EVENT_CPU_CYCLES,
+    VIR_PERF_EVENT_INSTRUCTIONS,
+    VIR_PERF_EVENT_CACHE_REFERENCES,
+    VIR_PERF_EVENT_CACHE_MISSES,
+    VIR_PERF_EVENT_BRANCH_INSTRUCTIONS,
+    VIR_PERF_EVENT_BRANCH_MISSES,
+};
+
+
+/**
+ * qemuDomainPerfRefreshVcpus:
+ * @vm: domain object
+ *
+ * Make the per vCPU thread perf counters of @vm follow the events enabled
+ * for the domain and the current vCPU threads. Counters of vCPUs which were
+ * unplugged, or whose thread changed, are closed. Failure to open a counter
+ * is not fatal, the vCPU then just lacks it in the statistics.
+ */
+void
+qemuDomainPerfRefreshVcpus(virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    size_t maxvcpus = virDomainDefGetVcpusMax(vm->def);
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < maxvcpus; i++) {
+        virDomainVcpuDef *vcpu = virDomainDefGetVcpu(vm->def, i);
+        qemuDomainVcpuPrivate *vcpupriv = QEMU_DOMAIN_VCPU_PRIVATE(vcpu);
+
+        if (vcpupriv->perf &&
+            (!priv->perf || !vcpu->online || vcpupriv->tid != vcpupriv->perfTid))
+            g_clear_pointer(&vcpupriv->perf, virPerfFree);
+
+        if (!priv->perf || !vcpu->online || vcpupriv->tid <= 0)
+            continue;
+
+        for (j = 0; j < G_N_ELEMENTS(qemuDomainVcpuPerfEvents); j++) {
+            virPerfEventType type = qemuDomainVcpuPerfEvents[j];
+            bool enabled = virPerfEventIsEnabled(priv->perf, type);
+            int rc;
+
+            if (enabled == virPerfEventIsEnabled(vcpupriv->perf, type))
+                continue;
+
+            if (!vcpupriv->perf) {
+                vcpupriv->perf = virPerfNew();
+                vcpupriv->perfTid = vcpupriv->tid;
+            }
+
+            if (enabled)
+                rc = virPerfEventEnable(vcpupriv->perf, type, vcpupriv->tid);
+            else
+                rc = virPerfEventDisable(vcpupriv->perf, type);
+
+            if (rc < 0) {
+                VIR_WARN("Unable to update perf event '%s' of vCPU %zu of domain %s: %s",
+                         virPerfEventTypeToString(type), i, vm->def->name,
+                         virGetLastErrorMessage());
+                virResetLastError();
+            }
+        }
+    }
+}
+
 /**
  * qemuDomainGetVcpuHalted:
  * @vm: domain object
@@ -11621,6 +11719,8 @@ qemuProcessEventFree(struct qemuProcessEvent *event)
     case QEMU_PROCESS_EVENT_UNATTENDED_MIGRATION:
     case QEMU_PROCESS_EVENT_RESET:
     case QEMU_PROCESS_EVENT_NBDKIT_EXITED:
+    case QEMU_PROCESS_EVENT_NUMA_REBALANCE:
+    case QEMU_PROCESS_EVENT_RESCTRL_SAMPLE:
     case QEMU_PROCESS_EVENT_MONITOR_EOF:
     case QEMU_PROCESS_EVENT_LAST:
         break;
@@ -42,6 +42,7 @@
 #include "virdomainmomentobjlist.h"
 #include "virenum.h"
 #include "vireventthread.h"
+#include "virnsagent.h"
 #include "storage_source_conf.h"
 
 #define QEMU_DOMAIN_FORMAT_LIVE_FLAGS \
@@ -105,6 +106,7 @@ struct _qemuDomainObjPrivate {
     virQEMUDriver *driver;
 
     virBitmap *namespaces;
+    virNSAgent *nsagent;
 
     virEventThread *eventThread;
 
@@ -166,6 +168,10 @@ struct _qemuDomainObjPrivate {
     /* Bitmaps below hold data from the auto NUMA feature */
     virBitmap *autoNodeset;
     virBitmap *autoCpuset;
+    /* vCPUs accounted in driver->numaNodeVcpus for autoNodeset */
+    unsigned int autoPlacedVcpus;
+    /* Monotonic time in seconds of the last NUMA rebalancing move */
+    unsigned long long numaRebalanceTime;
 
     bool signalIOError; /* true if the domain condition should be signalled on
                            I/O error */
@@ -341,6 +347,10 @@ struct _qemuDomainVcpuPrivate {
     int vcpus;
 
     char *qomPath;
+
+    /* per thread perf counters, see qemuDomainPerfRefreshVcpus */
+    virPerf *perf;
+    pid_t perfTid; /* thread @perf was opened for */
 };
 
 #define QEMU_DOMAIN_VCPU_PRIVATE(vcpu) \
@@ -469,6 +479,8 @@ typedef enum {
     QEMU_PROCESS_EVENT_UNATTENDED_MIGRATION,
     QEMU_PROCESS_EVENT_RESET,
     QEMU_PROCESS_EVENT_NBDKIT_EXITED,
+    QEMU_PROCESS_EVENT_NUMA_REBALANCE,
+    QEMU_PROCESS_EVENT_RESCTRL_SAMPLE,
 
     QEMU_PROCESS_EVENT_LAST
 } qemuProcessEventType;
@@ -577,6 +589,7 @@ int qemuDomainObjStartWorker(virDomainObj *dom);
 void qemuDomainObjStopWorker(virDomainObj *dom);
 
 virDomainObj *qemuDomainObjFromDomain(virDomainPtr domain);
+virDomainObjView *qemuDomainObjViewFromDomain(virDomainPtr domain);
 
 qemuDomainSaveCookie *qemuDomainSaveCookieNew(virDomainObj *vm);
 
@@ -865,6 +878,7 @@ int qemuDomainRefreshVcpuInfo(virDomainObj *vm,
                               int asyncJob,
                               bool state);
 bool qemuDomainGetVcpuHalted(virDomainObj *vm, unsigned int vcpu);
+void qemuDomainPerfRefreshVcpus(virDomainObj *vm);
 int qemuDomainRefreshVcpuHalted(virDomainObj *vm,
                                 int asyncJob);
 
@@ -31,6 +31,8 @@
 #include <sys/ioctl.h>
 
 #include "qemu_driver.h"
+#define LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW
+#include "qemu_driverpriv.h"
 #include "qemu_agent.h"
 #include "qemu_alias.h"
 #include "qemu_block.h"
@@ -39,6 +41,7 @@
 #include "qemu_command.h"
 #include "qemu_hostdev.h"
 #include "qemu_hotplug.h"
+#include "qemu_hugepages.h"
 #include "qemu_monitor.h"
 #include "qemu_passt.h"
 #include "qemu_process.h"
@@ -49,6 +52,8 @@
 #include "qemu_checkpoint.h"
 #include "qemu_backup.h"
 #include "qemu_namespace.h"
+#include "qemu_numa.h"
+#include "qemu_resctrl.h"
 #include "qemu_saveimage.h"
 #include "qemu_snapshot.h"
 #include "qemu_validate.h"
@@ -566,6 +571,8 @@ qemuStateInitialize(bool privileged,
     qemu_driver = g_new0(virQEMUDriver, 1);
 
     qemu_driver->lockFD = -1;
+    qemu_driver->numaRebalanceTimer = -1;
+    qemu_driver->resctrlSampleTimer = -1;
 
     if (virMutexInit(&qemu_driver->lock) < 0) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
@@ -729,6 +736,9 @@ qemuStateInitialize(bool privileged,
     if (!(qemu_driver->hostdevMgr = virHostdevManagerGetDefault()))
         goto error;
 
+    if (!(qemu_driver->hugepageLedger = qemuHugepageLedgerNew()))
+        goto error;
+
     if (qemuMigrationDstErrorInit(qemu_driver) < 0)
         goto error;
 
@@ -914,8 +924,17 @@ qemuStateInitialize(bool privileged,
     if (!qemu_driver->workerPool)
         goto error;
 
+    if (!(qemu_driver->statsPool = qemuDomainGetStatsPoolNew(identity)))
+        goto error;
+
     qemuProcessReconnectAll(qemu_driver);
 
+    if (qemuNumaRebalanceInit(qemu_driver) < 0)
+        goto error;
+
+    if (qemuResctrlSampleInit(qemu_driver) < 0)
+        goto error;
+
     if (virDriverShouldAutostart(cfg->stateDir, &autostart) < 0)
         goto error;
 
@@ -1063,7 +1082,10 @@ qemuStateCleanup(void)
     if (!qemu_driver)
         return -1;
 
+    qemuNumaRebalanceCleanup(qemu_driver);
+    qemuResctrlSampleCleanup(qemu_driver);
     virThreadPoolFree(qemu_driver->workerPool);
+    virThreadPoolFree(qemu_driver->statsPool);
     virObjectUnref(qemu_driver->migrationErrors);
     virLockManagerPluginUnref(qemu_driver->lockManager);
     virSysinfoDefFree(qemu_driver->hostsysinfo);
@@ -1071,6 +1093,7 @@ qemuStateCleanup(void)
     virPortAllocatorRangeFree(qemu_driver->webSocketPorts);
     virPortAllocatorRangeFree(qemu_driver->remotePorts);
     virObjectUnref(qemu_driver->hostdevMgr);
+    virObjectUnref(qemu_driver->hugepageLedger);
     virObjectUnref(qemu_driver->securityManager);
     virObjectUnref(qemu_driver->domainEventState);
     virObjectUnref(qemu_driver->qemuCapsCache);
@@ -1081,6 +1104,8 @@ qemuStateCleanup(void)
     VIR_FREE(qemu_driver->qemuImgBinary);
     virObjectUnref(qemu_driver->domains);
     virObjectUnref(qemu_driver->nbdkitCapsCache);
+    g_clear_pointer(&qemu_driver->domCapsCache, g_hash_table_unref);
+    g_free(qemu_driver->numaNodeVcpus);
 
     if (qemu_driver->lockFD != -1)
         virPidFileRelease(qemu_driver->config->stateDir, "driver", qemu_driver->lockFD);
@@ -2471,54 +2496,80 @@ static int qemuDomainSendKey(virDomainPtr domain,
 
 
 static int
-qemuDomainGetInfo(virDomainPtr dom,
-                  virDomainInfoPtr info)
+qemuDomainGetInfoFromDef(virDomainDef *def,
+                         virDomainState state,
+                         pid_t pid,
+                         virDomainInfoPtr info)
 {
     unsigned long long maxmem;
-    virDomainObj *vm;
-    int ret = -1;
-
-    if (!(vm = qemuDomainObjFromDomain(dom)))
-        goto cleanup;
-
-    if (virDomainGetInfoEnsureACL(dom->conn, vm->def) < 0)
-        goto cleanup;
-
-    qemuDomainUpdateCurrentMemorySize(vm);
+    unsigned long long curmem;
 
     memset(info, 0, sizeof(*info));
 
-    info->state = virDomainObjGetState(vm, NULL);
+    info->state = state;
 
-    maxmem = virDomainDefGetMemoryTotal(vm->def);
+    maxmem = virDomainDefGetMemoryTotal(def);
     if (VIR_ASSIGN_IS_OVERFLOW(info->maxMem, maxmem)) {
         virReportError(VIR_ERR_OVERFLOW, "%s",
                        _("Initial memory size too large"));
-        goto cleanup;
+        return -1;
     }
 
-    if (VIR_ASSIGN_IS_OVERFLOW(info->memory, vm->def->mem.cur_balloon)) {
+    /* same as qemuDomainUpdateCurrentMemorySize, @def may be read-only */
+    curmem = def->mem.cur_balloon;
+    if (def->id != -1 && !virDomainDefHasMemballoon(def))
+        curmem = maxmem;
+
+    if (VIR_ASSIGN_IS_OVERFLOW(info->memory, curmem)) {
         virReportError(VIR_ERR_OVERFLOW, "%s",
                        _("Current memory size too large"));
-        goto cleanup;
+        return -1;
     }
 
-    if (virDomainObjIsActive(vm)) {
+    if (def->id != -1) {
         if (virProcessGetStatInfo(&(info->cpuTime), NULL, NULL,
                                   NULL, NULL,
-                                  vm->pid, 0) < 0) {
+                                  pid, 0) < 0) {
             virReportError(VIR_ERR_OPERATION_FAILED, "%s",
                            _("cannot read cputime for domain"));
-            goto cleanup;
+            return -1;
         }
     }
 
-    if (VIR_ASSIGN_IS_OVERFLOW(info->nrVirtCpu, virDomainDefGetVcpus(vm->def))) {
+    if (VIR_ASSIGN_IS_OVERFLOW(info->nrVirtCpu, virDomainDefGetVcpus(def))) {
         virReportError(VIR_ERR_OVERFLOW, "%s", _("cpu count too large"));
-        goto cleanup;
+        return -1;
     }
 
-    ret = 0;
+    return 0;
+}
+
+static int
+qemuDomainGetInfo(virDomainPtr dom,
+                  virDomainInfoPtr info)
+{
+    g_autoptr(virDomainObjView) view = NULL;
+    virDomainObj *vm;
+    int ret = -1;
+
+    if ((view = qemuDomainObjViewFromDomain(dom))) {
+        if (virDomainGetInfoEnsureACL(dom->conn, view->def) < 0)
+            return -1;
+
+        return qemuDomainGetInfoFromDef(view->def, view->state.state,
+                                        view->pid, info);
+    }
+
+    if (!(vm = qemuDomainObjFromDomain(dom)))
+        goto cleanup;
+
+    if (virDomainGetInfoEnsureACL(dom->conn, vm->def) < 0)
+        goto cleanup;
+
+    qemuDomainUpdateCurrentMemorySize(vm);
+
+    ret = qemuDomainGetInfoFromDef(vm->def, virDomainObjGetState(vm, NULL),
+                                   vm->pid, info);
 
  cleanup:
     virDomainObjEndAPI(&vm);
@@ -2531,11 +2582,22 @@ qemuDomainGetState(virDomainPtr dom,
                    int *reason,
                    unsigned int flags)
 {
+    g_autoptr(virDomainObjView) view = NULL;
     virDomainObj *vm;
     int ret = -1;
 
     virCheckFlags(0, -1);
 
+    if ((view = qemuDomainObjViewFromDomain(dom))) {
+        if (virDomainGetStateEnsureACL(dom->conn, view->def) < 0)
+            return -1;
+
+        *state = view->state.state;
+        if (reason)
+            *reason = view->state.reason;
+        return 0;
+    }
+
     if (!(vm = qemuDomainObjFromDomain(dom)))
         goto cleanup;
 
@@ -4114,6 +4176,12 @@ static void qemuProcessEventHandler(void *data, void *opaque)
     case QEMU_PROCESS_EVENT_NBDKIT_EXITED:
         processNbdkitExitedEvent(vm, processEvent->data);
         break;
+    case QEMU_PROCESS_EVENT_NUMA_REBALANCE:
+        qemuNumaRebalanceDomain(driver, vm);
+        break;
+    case QEMU_PROCESS_EVENT_RESCTRL_SAMPLE:
+        qemuResctrlSampleDomain(driver, vm);
+        break;
     case QEMU_PROCESS_EVENT_LAST:
         break;
     }
@@ -6139,12 +6207,27 @@ static char
                       unsigned int flags)
 {
     virQEMUDriver *driver = dom->conn->privateData;
+    g_autoptr(virDomainObjView) view = NULL;
     virDomainObj *vm;
     char *ret = NULL;
 
     virCheckFlags(VIR_DOMAIN_XML_COMMON_FLAGS | VIR_DOMAIN_XML_UPDATE_CPU,
                   NULL);
 
+    /* The live XML can be formatted from the view unless the current memory
+     * size needs to be updated, see qemuDomainUpdateCurrentMemorySize. */
+    if (!(flags & (VIR_DOMAIN_XML_INACTIVE |
+                   VIR_DOMAIN_XML_MIGRATABLE |
+                   VIR_DOMAIN_XML_UPDATE_CPU)) &&
+        (view = qemuDomainObjViewFromDomain(dom)) &&
+        (!virDomainObjViewIsActive(view) ||
+         virDomainDefHasMemballoon(view->def))) {
+        if (virDomainGetXMLDescEnsureACL(dom->conn, view->def, flags) < 0)
+            return NULL;
+
+        return qemuDomainDefFormatXML(driver, NULL, view->def, flags);
+    }
+
     if (!(vm = qemuDomainObjFromDomain(dom)))
         goto cleanup;
 
@@ -8543,6 +8626,7 @@ qemuDomainSetPerfEvents(virDomainPtr dom,
                 VIR_TRISTATE_BOOL_YES : VIR_TRISTATE_BOOL_NO;
         }
 
+        qemuDomainPerfRefreshVcpus(vm);
         qemuDomainSaveStatus(vm);
     }
 
@@ -16040,10 +16124,34 @@ qemuNodeGetMemoryParameters(virConnectPtr conn,
                             int *nparams,
                             unsigned int flags)
 {
+    virQEMUDriver *driver = conn->privateData;
+    int nhostparams = 0;
+
     if (virNodeGetMemoryParametersEnsureACL(conn) < 0)
         return -1;
 
-    return virHostMemGetParameters(params, nparams, flags);
+    /* Query the number of host parameters, the huge page reservations
+     * tracked by the driver follow them. */
+    if (virHostMemGetParameters(NULL, &nhostparams, flags) < 0)
+        return -1;
+
+    if (*nparams == 0) {
+        *nparams = nhostparams + QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM;
+        return 0;
+    }
+
+    if (virHostMemGetParameters(params, nparams, flags) < 0)
+        return -1;
+
+    if (*nparams > nhostparams) {
+        if (qemuHugepagesGetParameters(driver, params + nhostparams,
+                                       *nparams - nhostparams) < 0)
+            return -1;
+
+        *nparams = MIN(*nparams, nhostparams + QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM);
+    }
+
+    return 0;
 }
 
 
@@ -16488,7 +16596,6 @@ qemuConnectGetDomainCapabilities(virConnectPtr conn,
     g_autoptr(virQEMUCaps) qemuCaps = NULL;
     virArch arch;
     virDomainVirtType virttype;
-    g_autoptr(virDomainCaps) domCaps = NULL;
 
     virCheckFlags(0, NULL);
 
@@ -16504,12 +16611,8 @@ qemuConnectGetDomainCapabilities(virConnectPtr conn,
     if (!qemuCaps)
         return NULL;
 
-    if (!(domCaps = virQEMUDriverGetDomainCapabilities(driver,
-                                                       qemuCaps, machine,
-                                                       arch, virttype)))
-        return NULL;
-
-    return virDomainCapsFormat(domCaps);
+    return virQEMUDriverGetDomainCapabilitiesXML(driver, qemuCaps, machine,
+                                                 arch, virttype);
 }
 
 
@@ -16591,6 +16694,7 @@ qemuDomainGetResctrlMonData(virQEMUDriver *driver,
     virQEMUResctrlMonData *res = NULL;
     char **features = NULL;
     g_autoptr(virCaps) caps = NULL;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
     size_t i = 0;
     size_t j = 0;
 
@@ -16640,9 +16744,15 @@ qemuDomainGetResctrlMonData(virQEMUDriver *driver,
 
             res->name = g_strdup(virResctrlMonitorGetID(monitor));
 
-            if (virResctrlMonitorGetStats(monitor, (const char **)features,
-                                          &res->stats, &res->nstats) < 0)
-                goto error;
+            /* Prefer the periodic sample unless it missed two intervals */
+            if (cfg->resctrlSampleInterval == 0 ||
+                virResctrlMonitorGetSampledStats(monitor,
+                                                 cfg->resctrlSampleInterval * 2000ULL,
+                                                 &res->stats, &res->nstats) == 0) {
+                if (virResctrlMonitorGetStats(monitor, (const char **)features,
+                                              &res->stats, &res->nstats) < 0)
+                    goto error;
+            }
 
             VIR_APPEND_ELEMENT(*resdata, *nresdata, res);
         }
@@ -16698,6 +16808,10 @@ qemuDomainGetStatsMemoryBandwidth(virQEMUDriver *driver,
                      * controller is recorded with 64 bit counter. */
                     virTypedParamListAddULLong(params, resdata[i]->stats[j]->vals[k],
                                                "memory.bandwidth.monitor.%zu.node.%zu.bytes.local", i, j);
+
+                    if (resdata[i]->stats[j]->rates)
+                        virTypedParamListAddULLong(params, resdata[i]->stats[j]->rates[k],
+                                                   "memory.bandwidth.monitor.%zu.node.%zu.rate.local", i, j);
                 }
 
                 if (STREQ(features[k], "mbm_total_bytes")) {
@@ -16705,6 +16819,10 @@ qemuDomainGetStatsMemoryBandwidth(virQEMUDriver *driver,
                      * memory controller is recorded with 64 bit counter. */
                     virTypedParamListAddULLong(params, resdata[i]->stats[j]->vals[k],
                                                "memory.bandwidth.monitor.%zu.node.%zu.bytes.total", i, j);
+
+                    if (resdata[i]->stats[j]->rates)
+                        virTypedParamListAddULLong(params, resdata[i]->stats[j]->rates[k],
+                                                   "memory.bandwidth.monitor.%zu.node.%zu.rate.total", i, j);
                 }
             }
         }
@@ -17583,21 +17701,68 @@ qemuDomainGetStatsIOThread(virQEMUDriver *driver G_GNUC_UNUSED,
 }
 
 
+static void
+qemuDomainGetStatsPerfRatios(virPerf *perf,
+                             const uint64_t *values,
+                             virTypedParamList *params,
+                             const char *prefix)
+{
+    if (virPerfEventIsEnabled(perf, VIR_PERF_EVENT_CPU_CYCLES) &&
+        virPerfEventIsEnabled(perf, VIR_PERF_EVENT_INSTRUCTIONS) &&
+        values[VIR_PERF_EVENT_CPU_CYCLES] > 0) {
+        virTypedParamListAddDouble(params,
+                                   (double)values[VIR_PERF_EVENT_INSTRUCTIONS] /
+                                   values[VIR_PERF_EVENT_CPU_CYCLES],
+                                   "%s.ipc", prefix);
+    }
+
+    if (virPerfEventIsEnabled(perf, VIR_PERF_EVENT_CACHE_REFERENCES) &&
+        virPerfEventIsEnabled(perf, VIR_PERF_EVENT_CACHE_MISSES) &&
+        values[VIR_PERF_EVENT_CACHE_REFERENCES] > 0) {
+        virTypedParamListAddDouble(params,
+                                   (double)values[VIR_PERF_EVENT_CACHE_MISSES] /
+                                   values[VIR_PERF_EVENT_CACHE_REFERENCES],
+                                   "%s.cache_miss_rate", prefix);
+    }
+}
+
+
 static int
-qemuDomainGetStatsPerfOneEvent(virPerf *perf,
-                               virPerfEventType type,
-                               virTypedParamList *params)
+qemuDomainGetStatsPerfVcpus(virDomainObj *dom,
+                            virTypedParamList *params)
 {
-    uint64_t value = 0;
+    size_t maxvcpus = virDomainDefGetVcpusMax(dom->def);
+    size_t i;
+    size_t j;
 
-    if (virPerfReadEvent(perf, type, &value) < 0)
-        return -1;
+    for (i = 0; i < maxvcpus; i++) {
+        virDomainVcpuDef *vcpu = virDomainDefGetVcpu(dom->def, i);
+        qemuDomainVcpuPrivate *vcpupriv = QEMU_DOMAIN_VCPU_PRIVATE(vcpu);
+        uint64_t values[VIR_PERF_EVENT_LAST];
+        g_autofree char *prefix = NULL;
+
+        if (!vcpupriv->perf)
+            continue;
+
+        if (virPerfReadEvents(vcpupriv->perf, values) < 0)
+            return -1;
+
+        for (j = 0; j < VIR_PERF_EVENT_LAST; j++) {
+            if (!virPerfEventIsEnabled(vcpupriv->perf, j))
+                continue;
+
+            virTypedParamListAddULLong(params, values[j], "perf.vcpu.%zu.%s",
+                                       i, virPerfEventTypeToString(j));
+        }
 
-    virTypedParamListAddULLong(params, value, "perf.%s", virPerfEventTypeToString(type));
+        prefix = g_strdup_printf("perf.vcpu.%zu", i);
+        qemuDomainGetStatsPerfRatios(vcpupriv->perf, values, params, prefix);
+    }
 
     return 0;
 }
 
+
 static int
 qemuDomainGetStatsPerf(virQEMUDriver *driver G_GNUC_UNUSED,
                        virDomainObj *dom,
@@ -17606,16 +17771,26 @@ qemuDomainGetStatsPerf(virQEMUDriver *driver G_GNUC_UNUSED,
 {
     size_t i;
     qemuDomainObjPrivate *priv = dom->privateData;
+    uint64_t values[VIR_PERF_EVENT_LAST];
+
+    if (!priv->perf)
+        return 0;
+
+    /* A single read per group of events instead of one per event */
+    if (virPerfReadEvents(priv->perf, values) < 0)
+        return -1;
 
     for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
         if (!virPerfEventIsEnabled(priv->perf, i))
              continue;
 
-        if (qemuDomainGetStatsPerfOneEvent(priv->perf, i, params) < 0)
-            return -1;
+        virTypedParamListAddULLong(params, values[i], "perf.%s",
+                                   virPerfEventTypeToString(i));
     }
 
-    return 0;
+    qemuDomainGetStatsPerfRatios(priv->perf, values, params, "perf");
+
+    return qemuDomainGetStatsPerfVcpus(dom, params);
 }
 
 static int
@@ -17703,6 +17878,25 @@ qemuDomainGetStatsVm(virQEMUDriver *driver G_GNUC_UNUSED,
     return 0;
 }
 
+
+static int
+qemuDomainGetStatsXML(virQEMUDriver *driver,
+                      virDomainObj *dom,
+                      virTypedParamList *params,
+                      unsigned int privflags G_GNUC_UNUSED)
+{
+    g_autofree char *xml = NULL;
+
+    qemuDomainUpdateCurrentMemorySize(dom);
+
+    if (!(xml = qemuDomainFormatXML(driver, dom, 0)))
+        return -1;
+
+    virTypedParamListAddString(params, xml, "xml");
+
+    return 0;
+}
+
 typedef int
 (*qemuDomainGetStatsFunc)(virQEMUDriver *driver,
                           virDomainObj *dom,
@@ -17739,6 +17933,7 @@ static struct qemuDomainGetStatsWorker qemuDomainGetStatsWorkers[] = {
     { qemuDomainGetStatsMemory, VIR_DOMAIN_STATS_MEMORY, false, NULL },
     { qemuDomainGetStatsDirtyRate, VIR_DOMAIN_STATS_DIRTYRATE, true, queryDirtyRateRequired },
     { qemuDomainGetStatsVm, VIR_DOMAIN_STATS_VM, true, queryVmRequired },
+    { qemuDomainGetStatsXML, VIR_DOMAIN_STATS_XML, false, NULL },
     { NULL, 0, false, NULL }
 };
 
@@ -17771,7 +17966,9 @@ qemuDomainGetStatsCheckSupport(unsigned int *stats,
     }
 
     if (*stats == 0) {
-        *stats = supportedstats;
+        /* the XML is much bigger than all the other groups together,
+         * it has to be asked for explicitly */
+        *stats = supportedstats & ~VIR_DOMAIN_STATS_XML;
         return 0;
     }
 
@@ -17837,6 +18034,217 @@ qemuDomainGetStats(virConnectPtr conn,
 }
 
 
+/* minimum number of domains to gather stats of in parallel */
+#define QEMU_DOMAIN_STATS_WORKERS_MIN_DOMAINS 8
+#define QEMU_DOMAIN_STATS_WORKERS_MAX 16
+
+static int
+qemuConnectGetAllDomainStatsOne(virConnectPtr conn,
+                                virDomainObj *vm,
+                                unsigned int stats,
+                                virDomainStatsRecordPtr *record,
+                                unsigned int flags)
+{
+    bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
+    unsigned int privflags = 0;
+    unsigned int domflags = 0;
+    int rc;
+
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
+        domflags |= QEMU_DOMAIN_STATS_BACKING;
+
+    virObjectLock(vm);
+
+    if (qemuDomainGetStatsCheckSupport(&stats, enforce, vm) < 0) {
+        virObjectUnlock(vm);
+        return -1;
+    }
+
+    if (qemuDomainGetStatsNeedMonitor(stats))
+        privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+
+    if (HAVE_JOB(privflags)) {
+        int rv;
+
+        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
+            rv = virDomainObjBeginJobNowait(vm, VIR_JOB_QUERY);
+        else
+            rv = virDomainObjBeginJob(vm, VIR_JOB_QUERY);
+
+        if (rv == 0)
+            domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+    }
+    /* else: without a job it's still possible to gather some data */
+
+    rc = qemuDomainGetStats(conn, vm, stats, record, domflags);
+
+    if (HAVE_JOB(domflags))
+        virDomainObjEndJob(vm);
+
+    virObjectUnlock(vm);
+
+    return rc;
+}
+
+
+typedef struct _qemuDomainStatsJobs qemuDomainStatsJobs;
+struct _qemuDomainStatsJobs {
+    virMutex lock;
+    virCond cond;
+    size_t pending;
+
+    virConnectPtr conn;
+    unsigned int stats;
+    unsigned int flags;
+};
+
+typedef struct _qemuDomainStatsJob qemuDomainStatsJob;
+struct _qemuDomainStatsJob {
+    virDomainObj *vm;
+    virDomainStatsRecordPtr record;
+    virErrorPtr err;
+    int rc;
+    qemuDomainStatsJobs *jobs;
+};
+
+
+static void
+qemuDomainStatsJobRun(qemuDomainStatsJob *job)
+{
+    qemuDomainStatsJobs *jobs = job->jobs;
+
+    job->rc = qemuConnectGetAllDomainStatsOne(jobs->conn, job->vm, jobs->stats,
+                                              &job->record, jobs->flags);
+    if (job->rc < 0)
+        virErrorPreserveLast(&job->err);
+}
+
+
+static void
+qemuDomainStatsWorker(void *jobdata,
+                      void *opaque G_GNUC_UNUSED)
+{
+    qemuDomainStatsJob *job = jobdata;
+
+    qemuDomainStatsJobRun(job);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&job->jobs->lock) {
+        if (--job->jobs->pending == 0)
+            virCondSignal(&job->jobs->cond);
+    }
+}
+
+
+/**
+ * qemuDomainGetStatsPoolNew:
+ * @identity: identity of the workers
+ *
+ * Creates the pool of workers qemuDomainGetStatsList() spreads the
+ * domains over.
+ */
+virThreadPool *
+qemuDomainGetStatsPoolNew(virIdentity *identity)
+{
+    return virThreadPoolNewFull(0,
+                                MIN(g_get_num_processors(),
+                                    QEMU_DOMAIN_STATS_WORKERS_MAX),
+                                0, qemuDomainStatsWorker, "qemu-stats",
+                                identity, NULL);
+}
+
+
+/**
+ * qemuDomainGetStatsList:
+ * @conn: connection
+ * @vms: domains to gather stats of
+ * @nvms: number of items in @vms
+ * @stats: requested stats groups
+ * @records: filled with the stats record of each of @vms
+ * @flags: virConnectGetAllDomainStatsFlags
+ *
+ * Gathers the stats of @vms. With enough domains this is done on the
+ * driver's pool of stats workers, so that domains which are busy, e.g. by
+ * waiting for their monitor, don't hold up the rest.
+ *
+ * Returns 0 on success, -1 with the error of the first domain in @vms
+ * which failed reported. The records gathered are stored in @records
+ * in either case, in the order of @vms and without gaps.
+ */
+int
+qemuDomainGetStatsList(virConnectPtr conn,
+                       virDomainObj **vms,
+                       size_t nvms,
+                       unsigned int stats,
+                       virDomainStatsRecordPtr *records,
+                       unsigned int flags)
+{
+    virQEMUDriver *driver = conn->privateData;
+    g_autofree qemuDomainStatsJob *job = NULL;
+    qemuDomainStatsJobs jobs = { .conn = conn, .stats = stats, .flags = flags };
+    bool parallel = false;
+    size_t n = 0;
+    int ret = 0;
+    size_t i;
+
+    if (driver->statsPool && nvms >= QEMU_DOMAIN_STATS_WORKERS_MIN_DOMAINS &&
+        virMutexInit(&jobs.lock) == 0) {
+        if (virCondInit(&jobs.cond) == 0)
+            parallel = true;
+        else
+            virMutexDestroy(&jobs.lock);
+    }
+
+    job = g_new0(qemuDomainStatsJob, nvms);
+
+    for (i = 0; i < nvms; i++) {
+        job[i].vm = vms[i];
+        job[i].jobs = &jobs;
+
+        if (parallel) {
+            VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+                jobs.pending++;
+            }
+
+            if (virThreadPoolSendJob(driver->statsPool, 0, &job[i]) == 0)
+                continue;
+
+            VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+                jobs.pending--;
+            }
+            virResetLastError();
+        }
+
+        qemuDomainStatsJobRun(&job[i]);
+
+        if (!parallel && job[i].rc < 0)
+            break;
+    }
+
+    if (parallel) {
+        VIR_WITH_MUTEX_LOCK_GUARD(&jobs.lock) {
+            while (jobs.pending > 0)
+                ignore_value(virCondWait(&jobs.cond, &jobs.lock));
+        }
+
+        virCondDestroy(&jobs.cond);
+        virMutexDestroy(&jobs.lock);
+    }
+
+    for (i = 0; i < nvms; i++) {
+        if (job[i].record)
+            records[n++] = job[i].record;
+
+        if (job[i].rc < 0 && ret == 0) {
+            virErrorRestore(&job[i].err);
+            ret = -1;
+        }
+        virFreeError(job[i].err);
+    }
+
+    return ret;
+}
+
+
 static int
 qemuConnectGetAllDomainStats(virConnectPtr conn,
                              virDomainPtr *doms,
@@ -17850,9 +18258,6 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     virDomainObj **vms = NULL;
     size_t nvms;
     virDomainStatsRecordPtr *tmpstats = NULL;
-    bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
-    int nstats = 0;
-    size_t i;
     int ret = -1;
     unsigned int lflags = flags & (VIR_CONNECT_LIST_DOMAINS_FILTERS_ACTIVE |
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_PERSISTENT |
@@ -17881,56 +18286,12 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
 
     tmpstats = g_new0(virDomainStatsRecordPtr, nvms + 1);
 
-    for (i = 0; i < nvms; i++) {
-        virDomainObj *vm = vms[i];
-        virDomainStatsRecordPtr tmp = NULL;
-        unsigned int privflags = 0;
-        unsigned int requestedStats = stats;
-        unsigned int domflags = 0;
-        int rc;
-
-        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
-            domflags |= QEMU_DOMAIN_STATS_BACKING;
-
-        virObjectLock(vm);
-
-        if (qemuDomainGetStatsCheckSupport(&requestedStats, enforce, vm) < 0) {
-            virObjectUnlock(vm);
-            goto cleanup;
-        }
-
-        if (qemuDomainGetStatsNeedMonitor(requestedStats))
-            privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
-
-        if (HAVE_JOB(privflags)) {
-            int rv;
-
-            if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
-                rv = virDomainObjBeginJobNowait(vm, VIR_JOB_QUERY);
-            else
-                rv = virDomainObjBeginJob(vm, VIR_JOB_QUERY);
-
-            if (rv == 0)
-                domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
-        }
-        /* else: without a job it's still possible to gather some data */
-
-        rc = qemuDomainGetStats(conn, vm, requestedStats, &tmp, domflags);
-
-        if (HAVE_JOB(domflags))
-            virDomainObjEndJob(vm);
-
-        virObjectUnlock(vm);
-
-        if (rc < 0)
-            goto cleanup;
-
-        tmpstats[nstats++] = tmp;
-    }
+    if (qemuDomainGetStatsList(conn, vms, nvms, stats, tmpstats, flags) < 0)
+        goto cleanup;
 
     *retStats = g_steal_pointer(&tmpstats);
 
-    ret = nstats;
+    ret = nvms;
 
  cleanup:
     virErrorPreserveLast(&orig_err);
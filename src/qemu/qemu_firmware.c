@@ -888,6 +888,21 @@ qemuFirmwareFetchConfigs(char ***firmwares,
 }
 
 
+/**
+ * qemuFirmwareGetConfigsStamp:
+ * @privileged: whether running as privileged daemon
+ *
+ * Returns a string which changes whenever any firmware descriptor which
+ * would be found by qemuFirmwareFetchConfigs is added, removed or modified,
+ * NULL on error.
+ */
+char *
+qemuFirmwareGetConfigsStamp(bool privileged)
+{
+    return qemuInteropGetConfigsStamp("firmware", privileged);
+}
+
+
 static bool
 qemuFirmwareMatchesMachineArch(const qemuFirmware *fw,
                                const char *machine,
@@ -1563,6 +1578,248 @@ qemuFirmwareFetchParsedConfigs(bool privileged,
 }
 
 
+typedef struct _qemuFirmwareIndexCandidates qemuFirmwareIndexCandidates;
+struct _qemuFirmwareIndexCandidates {
+    size_t n;
+    size_t *fws; /* indexes into qemuFirmwareIndex->firmwares */
+
+    uint64_t supported; /* 1 << VIR_DOMAIN_OS_DEF_FIRMWARE_* */
+    bool secure;
+};
+
+
+/* Parsed firmware descriptors together with derived data used for quick
+ * lookups. Descriptors are immutable once the index is built, so they can be
+ * accessed without holding the lock for as long as a reference is held. */
+typedef struct _qemuFirmwareIndex qemuFirmwareIndex;
+struct _qemuFirmwareIndex {
+    virObjectLockable parent;
+
+    char *stamp;
+
+    size_t nfirmwares;
+    qemuFirmware **firmwares;
+    char **paths;
+
+    /* "arch:machine" -> qemuFirmwareIndexCandidates, filled in lazily */
+    GHashTable *candidates;
+};
+
+static virClass *qemuFirmwareIndexClass;
+static void qemuFirmwareIndexDispose(void *obj);
+
+static int
+qemuFirmwareIndexOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(qemuFirmwareIndex, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(qemuFirmwareIndex);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(qemuFirmwareIndex, virObjectUnref);
+
+/* Indexed by @privileged */
+static qemuFirmwareIndex *qemuFirmwareIndexes[2];
+static virMutex qemuFirmwareIndexesLock = VIR_MUTEX_INITIALIZER;
+
+
+static void
+qemuFirmwareIndexCandidatesFree(void *opaque)
+{
+    qemuFirmwareIndexCandidates *candidates = opaque;
+
+    if (!candidates)
+        return;
+
+    g_free(candidates->fws);
+    g_free(candidates);
+}
+
+
+static void
+qemuFirmwareIndexDispose(void *obj)
+{
+    qemuFirmwareIndex *idx = obj;
+    size_t i;
+
+    for (i = 0; i < idx->nfirmwares; i++)
+        qemuFirmwareFree(idx->firmwares[i]);
+    g_free(idx->firmwares);
+    g_strfreev(idx->paths);
+    g_free(idx->stamp);
+    g_clear_pointer(&idx->candidates, g_hash_table_unref);
+}
+
+
+static qemuFirmwareIndex *
+qemuFirmwareIndexNew(bool privileged)
+{
+    g_autoptr(qemuFirmwareIndex) idx = NULL;
+    ssize_t nfirmwares;
+
+    if (qemuFirmwareIndexInitialize() < 0)
+        return NULL;
+
+    if (!(idx = virObjectLockableNew(qemuFirmwareIndexClass)))
+        return NULL;
+
+    if ((nfirmwares = qemuFirmwareFetchParsedConfigs(privileged,
+                                                     &idx->firmwares,
+                                                     &idx->paths)) < 0)
+        return NULL;
+
+    idx->nfirmwares = nfirmwares;
+    idx->candidates = virHashNew(qemuFirmwareIndexCandidatesFree);
+
+    VIR_DEBUG("Indexed %zu firmware descriptors", idx->nfirmwares);
+
+    return g_steal_pointer(&idx);
+}
+
+
+/**
+ * qemuFirmwareIndexGet:
+ * @privileged: whether running as privileged daemon
+ *
+ * Returns a reference to the index of firmware descriptors. The index is
+ * built on first use and rebuilt only when the descriptor directories
+ * change, so that firmware selection does not need to read and parse every
+ * descriptor on each domain start.
+ *
+ * Returns: the index on success (caller must unref it),
+ *          NULL on error.
+ */
+static qemuFirmwareIndex *
+qemuFirmwareIndexGet(bool privileged)
+{
+    g_autofree char *stamp = NULL;
+    qemuFirmwareIndex **cached = &qemuFirmwareIndexes[!!privileged];
+    qemuFirmwareIndex *idx;
+    VIR_LOCK_GUARD lock = { NULL };
+
+    if (!(stamp = qemuFirmwareGetConfigsStamp(privileged)))
+        return NULL;
+
+    lock = virLockGuardLock(&qemuFirmwareIndexesLock);
+
+    if (*cached && STREQ((*cached)->stamp, stamp))
+        return virObjectRef(*cached);
+
+    VIR_DEBUG("Firmware descriptors changed, rebuilding index");
+
+    if (!(idx = qemuFirmwareIndexNew(privileged)))
+        return NULL;
+
+    idx->stamp = g_steal_pointer(&stamp);
+
+    virObjectUnref(*cached);
+    *cached = idx;
+
+    return virObjectRef(idx);
+}
+
+
+static qemuFirmwareIndexCandidates *
+qemuFirmwareIndexCandidatesNew(qemuFirmwareIndex *idx,
+                               const char *machine,
+                               virArch arch)
+{
+    qemuFirmwareIndexCandidates *candidates;
+    size_t i;
+    size_t j;
+
+    candidates = g_new0(qemuFirmwareIndexCandidates, 1);
+    candidates->fws = g_new0(size_t, idx->nfirmwares);
+
+    for (i = 0; i < idx->nfirmwares; i++) {
+        const qemuFirmware *fw = idx->firmwares[i];
+
+        if (!qemuFirmwareMatchesMachineArch(fw, machine, arch))
+            continue;
+
+        candidates->fws[candidates->n++] = i;
+
+        for (j = 0; j < fw->ninterfaces; j++) {
+            switch (fw->interfaces[j]) {
+            case QEMU_FIRMWARE_OS_INTERFACE_UEFI:
+                candidates->supported |= 1ULL << VIR_DOMAIN_OS_DEF_FIRMWARE_EFI;
+                break;
+            case QEMU_FIRMWARE_OS_INTERFACE_BIOS:
+                candidates->supported |= 1ULL << VIR_DOMAIN_OS_DEF_FIRMWARE_BIOS;
+                break;
+            case QEMU_FIRMWARE_OS_INTERFACE_NONE:
+            case QEMU_FIRMWARE_OS_INTERFACE_OPENFIRMWARE:
+            case QEMU_FIRMWARE_OS_INTERFACE_UBOOT:
+            case QEMU_FIRMWARE_OS_INTERFACE_LAST:
+            default:
+                break;
+            }
+        }
+
+        for (j = 0; j < fw->nfeatures; j++) {
+            switch (fw->features[j]) {
+            case QEMU_FIRMWARE_FEATURE_REQUIRES_SMM:
+                candidates->secure = true;
+                break;
+            case QEMU_FIRMWARE_FEATURE_NONE:
+            case QEMU_FIRMWARE_FEATURE_ACPI_S3:
+            case QEMU_FIRMWARE_FEATURE_ACPI_S4:
+            case QEMU_FIRMWARE_FEATURE_AMD_SEV:
+            case QEMU_FIRMWARE_FEATURE_AMD_SEV_ES:
+            case QEMU_FIRMWARE_FEATURE_ENROLLED_KEYS:
+            case QEMU_FIRMWARE_FEATURE_SECURE_BOOT:
+            case QEMU_FIRMWARE_FEATURE_VERBOSE_DYNAMIC:
+            case QEMU_FIRMWARE_FEATURE_VERBOSE_STATIC:
+            case QEMU_FIRMWARE_FEATURE_LAST:
+                break;
+            }
+        }
+    }
+
+    return candidates;
+}
+
+
+/**
+ * qemuFirmwareIndexLookup:
+ * @idx: firmware index
+ * @machine: machine type
+ * @arch: architecture
+ *
+ * Returns the list of firmware descriptors (in order of their priority)
+ * which declare support for @machine on @arch, along with the interfaces and
+ * features they provide. The result is owned by @idx and valid for as long
+ * as the caller holds a reference to @idx.
+ *
+ * Returns: the list of candidates on success,
+ *          NULL on error.
+ */
+static const qemuFirmwareIndexCandidates *
+qemuFirmwareIndexLookup(qemuFirmwareIndex *idx,
+                        const char *machine,
+                        virArch arch)
+{
+    g_autofree char *key = g_strdup_printf("%s:%s",
+                                           virArchToString(arch),
+                                           NULLSTR(machine));
+    VIR_LOCK_GUARD lock = virObjectLockGuard(idx);
+    qemuFirmwareIndexCandidates *candidates;
+
+    if (!(candidates = virHashLookup(idx->candidates, key))) {
+        candidates = qemuFirmwareIndexCandidatesNew(idx, machine, arch);
+        if (virHashAddEntry(idx->candidates, key, candidates) < 0) {
+            qemuFirmwareIndexCandidatesFree(candidates);
+            return NULL;
+        }
+    }
+
+    return candidates;
+}
+
+
 /**
  * qemuFirmwareFillDomainLegacy:
  * @driver: QEMU driver
@@ -1678,46 +1935,44 @@ static int
 qemuFirmwareFillDomainModern(virQEMUDriver *driver,
                              virDomainDef *def)
 {
-    g_auto(GStrv) paths = NULL;
-    qemuFirmware **firmwares = NULL;
-    ssize_t nfirmwares = 0;
+    g_autoptr(qemuFirmwareIndex) idx = NULL;
+    const qemuFirmwareIndexCandidates *candidates;
     const qemuFirmware *theone = NULL;
+    const char *path = NULL;
     size_t i;
-    int ret = -1;
 
-    if ((nfirmwares = qemuFirmwareFetchParsedConfigs(driver->privileged,
-                                                     &firmwares, &paths)) < 0)
+    if (!(idx = qemuFirmwareIndexGet(driver->privileged)))
+        return -1;
+
+    if (!(candidates = qemuFirmwareIndexLookup(idx, def->os.machine,
+                                               def->os.arch)))
         return -1;
 
-    for (i = 0; i < nfirmwares; i++) {
-        if (qemuFirmwareMatchDomain(def, firmwares[i], paths[i])) {
-            theone = firmwares[i];
+    for (i = 0; i < candidates->n; i++) {
+        const qemuFirmware *fw = idx->firmwares[candidates->fws[i]];
+        const char *fwpath = idx->paths[candidates->fws[i]];
+
+        if (qemuFirmwareMatchDomain(def, fw, fwpath)) {
+            theone = fw;
+            path = fwpath;
             VIR_DEBUG("Found matching firmware (description path '%s')",
-                      paths[i]);
+                      path);
             break;
         }
     }
 
-    if (!theone) {
-        ret = 1;
-        goto cleanup;
-    }
+    if (!theone)
+        return 1;
 
     /* Firstly, let's do some sanity checks. If either of these
      * fail we can still start the domain successfully, but it's
      * likely that admin/FW manufacturer messed up. */
-    qemuFirmwareSanityCheck(theone, paths[i]);
+    qemuFirmwareSanityCheck(theone, path);
 
     if (qemuFirmwareEnableFeaturesModern(def, theone) < 0)
-        goto cleanup;
-
-    ret = 0;
+        return -1;
 
- cleanup:
-    for (i = 0; i < nfirmwares; i++)
-        qemuFirmwareFree(firmwares[i]);
-    VIR_FREE(firmwares);
-    return ret;
+    return 0;
 }
 
 
@@ -1878,8 +2133,8 @@ qemuFirmwareGetSupported(const char *machine,
                          virFirmware ***fws,
                          size_t *nfws)
 {
-    qemuFirmware **firmwares = NULL;
-    ssize_t nfirmwares = 0;
+    g_autoptr(qemuFirmwareIndex) idx = NULL;
+    const qemuFirmwareIndexCandidates *candidates;
     size_t i;
 
     *supported = VIR_DOMAIN_OS_DEF_FIRMWARE_NONE;
@@ -1890,57 +2145,26 @@ qemuFirmwareGetSupported(const char *machine,
         *nfws = 0;
     }
 
-    if ((nfirmwares = qemuFirmwareFetchParsedConfigs(privileged,
-                                                     &firmwares, NULL)) < 0)
+    if (!(idx = qemuFirmwareIndexGet(privileged)))
+        return -1;
+
+    if (!(candidates = qemuFirmwareIndexLookup(idx, machine, arch)))
         return -1;
 
-    for (i = 0; i < nfirmwares; i++) {
-        qemuFirmware *fw = firmwares[i];
+    *supported = candidates->supported;
+    *secure = candidates->secure;
+
+    if (!fws)
+        return 0;
+
+    for (i = 0; i < candidates->n; i++) {
+        const qemuFirmware *fw = idx->firmwares[candidates->fws[i]];
         const qemuFirmwareMappingFlash *flash = &fw->mapping.data.flash;
         const qemuFirmwareMappingMemory *memory = &fw->mapping.data.memory;
         const char *fwpath = NULL;
         const char *nvrampath = NULL;
         size_t j;
 
-        if (!qemuFirmwareMatchesMachineArch(fw, machine, arch))
-            continue;
-
-        for (j = 0; j < fw->ninterfaces; j++) {
-            switch (fw->interfaces[j]) {
-            case QEMU_FIRMWARE_OS_INTERFACE_UEFI:
-                *supported |= 1ULL << VIR_DOMAIN_OS_DEF_FIRMWARE_EFI;
-                break;
-            case QEMU_FIRMWARE_OS_INTERFACE_BIOS:
-                *supported |= 1ULL << VIR_DOMAIN_OS_DEF_FIRMWARE_BIOS;
-                break;
-            case QEMU_FIRMWARE_OS_INTERFACE_NONE:
-            case QEMU_FIRMWARE_OS_INTERFACE_OPENFIRMWARE:
-            case QEMU_FIRMWARE_OS_INTERFACE_UBOOT:
-            case QEMU_FIRMWARE_OS_INTERFACE_LAST:
-            default:
-                break;
-            }
-        }
-
-        for (j = 0; j < fw->nfeatures; j++) {
-            switch (fw->features[j]) {
-            case QEMU_FIRMWARE_FEATURE_REQUIRES_SMM:
-                *secure = true;
-                break;
-            case QEMU_FIRMWARE_FEATURE_NONE:
-            case QEMU_FIRMWARE_FEATURE_ACPI_S3:
-            case QEMU_FIRMWARE_FEATURE_ACPI_S4:
-            case QEMU_FIRMWARE_FEATURE_AMD_SEV:
-            case QEMU_FIRMWARE_FEATURE_AMD_SEV_ES:
-            case QEMU_FIRMWARE_FEATURE_ENROLLED_KEYS:
-            case QEMU_FIRMWARE_FEATURE_SECURE_BOOT:
-            case QEMU_FIRMWARE_FEATURE_VERBOSE_DYNAMIC:
-            case QEMU_FIRMWARE_FEATURE_VERBOSE_STATIC:
-            case QEMU_FIRMWARE_FEATURE_LAST:
-                break;
-            }
-        }
-
         switch (fw->mapping.device) {
         case QEMU_FIRMWARE_DEVICE_FLASH:
             fwpath = flash->executable.filename;
@@ -1957,7 +2181,7 @@ qemuFirmwareGetSupported(const char *machine,
             break;
         }
 
-        if (fws && fwpath) {
+        if (fwpath) {
             g_autoptr(virFirmware) tmp = NULL;
 
             /* Append only unique pairs. */
@@ -1977,11 +2201,8 @@ qemuFirmwareGetSupported(const char *machine,
         }
     }
 
-    if (fws && !*fws && nfirmwares)
+    if (!*fws && idx->nfirmwares)
         VIR_REALLOC_N(*fws, 0);
 
-    for (i = 0; i < nfirmwares; i++)
-        qemuFirmwareFree(firmwares[i]);
-    VIR_FREE(firmwares);
     return 0;
 }
@@ -42,6 +42,9 @@ int
 qemuFirmwareFetchConfigs(char ***firmwares,
                          bool privileged);
 
+char *
+qemuFirmwareGetConfigsStamp(bool privileged);
+
 int
 qemuFirmwareFillDomain(virQEMUDriver *driver,
                        virDomainDef *def,
@@ -39,6 +39,7 @@
 #include "qemu_virtiofs.h"
 #include "domain_audit.h"
 #include "domain_cgroup.h"
+#include "domain_diff.h"
 #include "domain_interface.h"
 #include "netdev_bandwidth_conf.h"
 #include "domain_nwfilter.h"
@@ -7031,9 +7032,13 @@ qemuDomainChangeDiskLive(virDomainObj *vm,
 
 
 static bool
-qemuDomainChangeMemoryLiveValidateChange(const virDomainMemoryDef *oldDef,
-                                         const virDomainMemoryDef *newDef)
+qemuDomainChangeMemoryLiveValidateChange(virDomainDeviceDef *oldDev,
+                                         virDomainDeviceDef *newDev)
 {
+    virDomainMemoryDef *oldDef = oldDev->data.memory;
+    g_autoptr(virDomainDefDiff) diff = NULL;
+    size_t i;
+
     /* The only thing that is allowed to change is 'requestedsize' for
      * virtio-mem model. Check if user isn't trying to sneak in change for
      * something else. */
@@ -7055,75 +7060,22 @@ qemuDomainChangeMemoryLiveValidateChange(const virDomainMemoryDef *oldDef,
         break;
     }
 
-    if (oldDef->model != newDef->model) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory model from '%1$s' to '%2$s'"),
-                       virDomainMemoryModelTypeToString(oldDef->model),
-                       virDomainMemoryModelTypeToString(newDef->model));
+    /* The device was looked up by its info, the size plugged in by the
+     * guest isn't part of the update. */
+    if (!(diff = virDomainDeviceDefDiffCompute(oldDev, newDev,
+                                               VIR_DOMAIN_DEF_DIFF_INACTIVE |
+                                               VIR_DOMAIN_DEF_DIFF_NO_DEVICE_INFO)))
         return false;
-    }
 
-    if (oldDef->access != newDef->access) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory access from '%1$s' to '%2$s'"),
-                       virDomainMemoryAccessTypeToString(oldDef->access),
-                       virDomainMemoryAccessTypeToString(newDef->access));
-        return false;
-    }
-
-    if (oldDef->discard != newDef->discard) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory discard from '%1$s' to '%2$s'"),
-                       virTristateBoolTypeToString(oldDef->discard),
-                       virTristateBoolTypeToString(newDef->discard));
-        return false;
-    }
-
-    if (!virBitmapEqual(oldDef->source.virtio_mem.nodes,
-                        newDef->source.virtio_mem.nodes)) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED, "%s",
-                       _("cannot modify memory source nodes"));
-        return false;
-    }
-
-    if (oldDef->source.virtio_mem.pagesize != newDef->source.virtio_mem.pagesize) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory pagesize from '%1$llu' to '%2$llu'"),
-                       oldDef->source.virtio_mem.pagesize,
-                       newDef->source.virtio_mem.pagesize);
-        return false;
-    }
-
-    if (oldDef->targetNode != newDef->targetNode) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory targetNode from '%1$d' to '%2$d'"),
-                       oldDef->targetNode, newDef->targetNode);
-        return false;
-    }
-
-    if (oldDef->size != newDef->size) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory size from '%1$llu' to '%2$llu'"),
-                       oldDef->size, newDef->size);
-        return false;
-    }
-
-    if (oldDef->target.virtio_mem.blocksize != newDef->target.virtio_mem.blocksize) {
-        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory block size from '%1$llu' to '%2$llu'"),
-                       oldDef->target.virtio_mem.blocksize,
-                       newDef->target.virtio_mem.blocksize);
-        return false;
-    }
-
-    /* requestedsize can change */
+    for (i = 0; i < diff->nchanges; i++) {
+        const char *path = diff->changes[i].path;
 
+        /* requestedsize can change */
+        if (STREQ(path, "/memory/target/requested"))
+            continue;
 
-    if (oldDef->target.virtio_mem.address != newDef->target.virtio_mem.address) {
         virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
-                       _("cannot modify memory address from '0x%1$llx' to '0x%2$llx'"),
-                       oldDef->target.virtio_mem.address,
-                       newDef->target.virtio_mem.address);
+                       _("cannot modify '%1$s' of memory device"), path);
         return false;
     }
 
@@ -7154,7 +7106,7 @@ qemuDomainChangeMemoryLive(virQEMUDriver *driver G_GNUC_UNUSED,
                                      true) < 0)
         return -1;
 
-    if (!qemuDomainChangeMemoryLiveValidateChange(oldDef, newDef))
+    if (!qemuDomainChangeMemoryLiveValidateChange(&oldDev, dev))
         return -1;
 
     if (qemuDomainChangeMemoryRequestedSize(vm, newDef->info.alias,
@@ -0,0 +1,561 @@
+/*
+ * qemu_hugepages.c: QEMU huge page reservations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_hugepages.h"
+#include "qemu_domain.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virhostmem.h"
+#include "virlog.h"
+#include "virnuma.h"
+#include "virtypedparam.h"
+#include "virutil.h"
+#include "viruuid.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_hugepages");
+
+/* Huge pages of one size set aside on one host NUMA node */
+typedef struct _qemuHugepageReservation qemuHugepageReservation;
+struct _qemuHugepageReservation {
+    unsigned int pagesize; /* in KiB */
+    int node; /* -1 if NUMA is not available */
+    unsigned long long npages;
+};
+
+typedef struct _qemuHugepageDomainReservation qemuHugepageDomainReservation;
+struct _qemuHugepageDomainReservation {
+    size_t nitems;
+    qemuHugepageReservation *items;
+};
+
+/* Huge pages promised to domains which are being started but whose QEMU has
+ * not allocated its memory yet. Without it, concurrent starts would count on
+ * the same free huge pages and all but one of them would fail late, once
+ * QEMU tries to preallocate guest memory. */
+struct _qemuHugepageLedger {
+    virObjectLockable parent;
+
+    /* domain UUID -> qemuHugepageDomainReservation */
+    GHashTable *domains;
+
+    /* Huge page memory added to the host pools for reservations, in KiB */
+    unsigned long long grown;
+};
+
+static virClass *qemuHugepageLedgerClass;
+static void qemuHugepageLedgerDispose(void *obj);
+
+static int
+qemuHugepageLedgerOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(qemuHugepageLedger, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(qemuHugepageLedger);
+
+
+static void
+qemuHugepageDomainReservationFree(void *opaque)
+{
+    qemuHugepageDomainReservation *res = opaque;
+
+    if (!res)
+        return;
+
+    g_free(res->items);
+    g_free(res);
+}
+
+
+static void
+qemuHugepageLedgerDispose(void *obj)
+{
+    qemuHugepageLedger *ledger = obj;
+
+    g_clear_pointer(&ledger->domains, g_hash_table_unref);
+}
+
+
+qemuHugepageLedger *
+qemuHugepageLedgerNew(void)
+{
+    qemuHugepageLedger *ledger;
+
+    if (qemuHugepageLedgerInitialize() < 0)
+        return NULL;
+
+    if (!(ledger = virObjectLockableNew(qemuHugepageLedgerClass)))
+        return NULL;
+
+    ledger->domains = virHashNew(qemuHugepageDomainReservationFree);
+
+    return ledger;
+}
+
+
+static void
+qemuHugepageDomainReservationAdd(qemuHugepageDomainReservation *res,
+                                 unsigned int pagesize,
+                                 int node,
+                                 unsigned long long npages)
+{
+    qemuHugepageReservation item = { .pagesize = pagesize,
+                                     .node = node,
+                                     .npages = npages };
+    size_t i;
+
+    for (i = 0; i < res->nitems; i++) {
+        if (res->items[i].pagesize == pagesize &&
+            res->items[i].node == node) {
+            res->items[i].npages += npages;
+            return;
+        }
+    }
+
+    VIR_APPEND_ELEMENT(res->items, res->nitems, item);
+}
+
+
+/* Number of huge pages of @pagesize reserved on @node by all domains,
+ * including the one being reserved for. */
+static unsigned long long
+qemuHugepageLedgerGetReserved(qemuHugepageLedger *ledger,
+                              unsigned int pagesize,
+                              int node)
+{
+    GHashTableIter iter;
+    gpointer value;
+    unsigned long long ret = 0;
+
+    g_hash_table_iter_init(&iter, ledger->domains);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        qemuHugepageDomainReservation *res = value;
+        size_t i;
+
+        for (i = 0; i < res->nitems; i++) {
+            if (res->items[i].pagesize == pagesize &&
+                res->items[i].node == node)
+                ret += res->items[i].npages;
+        }
+    }
+
+    return ret;
+}
+
+
+/* Maximum number of huge pages of @pagesize the pool of @node may be grown
+ * to, @percent of the memory of the node. */
+static int
+qemuHugepagesGetPoolLimit(unsigned int pagesize,
+                          int node,
+                          unsigned int percent,
+                          unsigned long long *limit)
+{
+    unsigned long long memsize;
+
+    if (node < 0) {
+        if (virHostMemGetInfo(&memsize, NULL) < 0)
+            return -1;
+    } else {
+        if (virNumaGetNodeMemory(node, &memsize, NULL) < 0)
+            return -1;
+    }
+
+    *limit = memsize / 1024 * percent / 100 / pagesize;
+    return 0;
+}
+
+
+/*
+ * Reserve up to *@remaining huge pages of @pagesize on host @node for @res,
+ * decreasing *@remaining by the number of pages reserved. With @grow the
+ * pool of the node is grown first to cover the shortage, as far as the
+ * configured limit allows.
+ */
+static int
+qemuHugepagesReserveOnNode(qemuHugepageLedger *ledger,
+                           virQEMUDriverConfig *cfg,
+                           qemuHugepageDomainReservation *res,
+                           unsigned int pagesize,
+                           int node,
+                           bool grow,
+                           unsigned long long *remaining)
+{
+    unsigned long long ntotal;
+    unsigned long long nfree;
+    unsigned long long reserved;
+    unsigned long long take;
+
+    if (virNumaGetPageInfo(node, pagesize, 0, &ntotal, &nfree) < 0)
+        return -1;
+
+    reserved = qemuHugepageLedgerGetReserved(ledger, pagesize, node);
+
+    if (grow && reserved + *remaining > nfree) {
+        unsigned long long limit;
+        unsigned long long delta;
+        unsigned long long oldTotal = ntotal;
+
+        if (qemuHugepagesGetPoolLimit(pagesize, node,
+                                      cfg->hugepagePoolMaxPercent, &limit) < 0)
+            return -1;
+
+        if (limit <= ntotal)
+            return 0;
+
+        delta = MIN(reserved + *remaining - nfree, limit - ntotal);
+
+        VIR_DEBUG("Growing pool of %u KiB huge pages on node %d by %llu",
+                  pagesize, node, delta);
+
+        /* The kernel may not find enough contiguous memory for all of the
+         * pages, take whatever it managed to allocate. */
+        if (virNumaSetPagePoolSize(node, pagesize, delta, true) < 0) {
+            VIR_WARN("Unable to grow pool of %u KiB huge pages on node %d: %s",
+                     pagesize, node, virGetLastErrorMessage());
+            virResetLastError();
+        }
+
+        if (virNumaGetPageInfo(node, pagesize, 0, &ntotal, &nfree) < 0)
+            return -1;
+
+        if (ntotal > oldTotal)
+            ledger->grown += (ntotal - oldTotal) * pagesize;
+    }
+
+    if (nfree <= reserved)
+        return 0;
+
+    take = MIN(nfree - reserved, *remaining);
+    qemuHugepageDomainReservationAdd(res, pagesize, node, take);
+    *remaining -= take;
+
+    return 0;
+}
+
+
+static int
+qemuHugepagesReserveMemory(qemuHugepageLedger *ledger,
+                           virQEMUDriverConfig *cfg,
+                           virDomainObj *vm,
+                           qemuHugepageDomainReservation *res,
+                           unsigned int pagesize,
+                           virBitmap *nodeset,
+                           unsigned long long memory)
+{
+    unsigned long long remaining = VIR_DIV_UP(memory, pagesize);
+    g_autofree int *nodes = NULL;
+    size_t nnodes = 0;
+    size_t i;
+
+    if (virNumaIsAvailable()) {
+        int maxnode;
+        int node;
+
+        if ((maxnode = virNumaGetMaxNode()) < 0)
+            return -1;
+
+        nodes = g_new0(int, maxnode + 1);
+        for (node = 0; node <= maxnode; node++) {
+            if (!virNumaNodeIsAvailable(node))
+                continue;
+            if (nodeset && !virBitmapIsBitSet(nodeset, node))
+                continue;
+            nodes[nnodes++] = node;
+        }
+    } else {
+        nodes = g_new0(int, 1);
+        nodes[nnodes++] = -1;
+    }
+
+    for (i = 0; i < nnodes && remaining > 0; i++) {
+        if (qemuHugepagesReserveOnNode(ledger, cfg, res, pagesize,
+                                       nodes[i], false, &remaining) < 0)
+            return -1;
+    }
+
+    if (cfg->hugepagePoolMaxPercent > 0) {
+        for (i = 0; i < nnodes && remaining > 0; i++) {
+            if (qemuHugepagesReserveOnNode(ledger, cfg, res, pagesize,
+                                           nodes[i], true, &remaining) < 0)
+                return -1;
+        }
+    }
+
+    if (remaining > 0) {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       _("Not enough free huge pages of size %1$u KiB for domain '%2$s', %3$llu more needed"),
+                       pagesize, vm->def->name, remaining);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* Mirrors the page size lookup of qemuBuildMemoryGetPagesize. Sets
+ * @pagesize to 0 if @cell is not backed by huge pages. */
+static void
+qemuHugepagesGetPageSize(virQEMUDriverConfig *cfg,
+                         const virDomainDef *def,
+                         ssize_t cell,
+                         unsigned long long *pagesize)
+{
+    virDomainHugePage *hugepage = NULL;
+    size_t i;
+
+    *pagesize = 0;
+
+    for (i = 0; i < def->mem.nhugepages; i++) {
+        virDomainHugePage *tmp = &def->mem.hugepages[i];
+
+        if (!tmp->nodemask) {
+            if (!hugepage)
+                hugepage = tmp;
+            continue;
+        }
+
+        if (cell >= 0 && virBitmapIsBitSet(tmp->nodemask, cell)) {
+            hugepage = tmp;
+            break;
+        }
+    }
+
+    if (!hugepage)
+        return;
+
+    if (hugepage->size == 0) {
+        virHugeTLBFS *fs;
+
+        if (cfg->nhugetlbfs == 0)
+            return;
+
+        if (!(fs = virFileGetDefaultHugepage(cfg->hugetlbfs, cfg->nhugetlbfs)))
+            fs = &cfg->hugetlbfs[0];
+
+        *pagesize = fs->size;
+    } else {
+        *pagesize = hugepage->size;
+    }
+
+    if (*pagesize == virGetSystemPageSizeKB())
+        *pagesize = 0;
+}
+
+
+static int
+qemuHugepagesReserveCell(qemuHugepageLedger *ledger,
+                         virQEMUDriverConfig *cfg,
+                         virDomainObj *vm,
+                         qemuHugepageDomainReservation *res,
+                         ssize_t cell,
+                         unsigned long long memory)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    virDomainNumatuneMemMode mode;
+    virBitmap *nodeset = NULL;
+    unsigned long long pagesize;
+
+    qemuHugepagesGetPageSize(cfg, vm->def, cell, &pagesize);
+
+    if (pagesize == 0 || memory == 0)
+        return 0;
+
+    /* Memory of cells with a preferred or interleaved policy may end up on
+     * any host node. */
+    if (virDomainNumatuneGetMode(vm->def->numa, cell, &mode) == 0 &&
+        (mode == VIR_DOMAIN_NUMATUNE_MEM_STRICT ||
+         mode == VIR_DOMAIN_NUMATUNE_MEM_RESTRICTIVE))
+        nodeset = virDomainNumatuneGetNodeset(vm->def->numa,
+                                              priv->autoNodeset, cell);
+
+    return qemuHugepagesReserveMemory(ledger, cfg, vm, res, pagesize,
+                                      nodeset, memory);
+}
+
+
+/**
+ * qemuHugepagesReserve:
+ * @driver: qemu driver
+ * @vm: domain object being started
+ *
+ * Reserve the huge pages backing the guest NUMA cells of @vm, or its whole
+ * initial memory if it has none, on the host NUMA nodes its numatune allows.
+ * Free huge pages reserved for other domains being started are not
+ * considered available. If there are not enough of them, the huge page pools
+ * are grown as allowed by hugepage_pool_max_percent.
+ *
+ * The reservation is held until qemuHugepagesRelease is called, once QEMU
+ * has allocated the memory.
+ *
+ * Returns 0 on success, -1 with an error reported if there are not enough
+ * free huge pages.
+ */
+int
+qemuHugepagesReserve(virQEMUDriver *driver,
+                     virDomainObj *vm)
+{
+    qemuHugepageLedger *ledger = driver->hugepageLedger;
+    g_autoptr(virQEMUDriverConfig) cfg = NULL;
+    qemuHugepageDomainReservation *res;
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    size_t ncells;
+    size_t i;
+
+    if (!ledger || vm->def->mem.nhugepages == 0)
+        return 0;
+
+    cfg = virQEMUDriverGetConfig(driver);
+    ncells = virDomainNumaGetNodeCount(vm->def->numa);
+    virUUIDFormat(vm->def->uuid, uuidstr);
+
+    VIR_WITH_OBJECT_LOCK_GUARD(ledger) {
+        /* Reserved pages count as unavailable for the following cells of
+         * the domain too, so the reservation is added first and filled in
+         * cell by cell. */
+        res = g_new0(qemuHugepageDomainReservation, 1);
+        g_hash_table_insert(ledger->domains, g_strdup(uuidstr), res);
+
+        if (ncells == 0) {
+            if (qemuHugepagesReserveCell(ledger, cfg, vm, res, -1,
+                                         virDomainDefGetMemoryInitial(vm->def)) < 0) {
+                g_hash_table_remove(ledger->domains, uuidstr);
+                return -1;
+            }
+        }
+
+        for (i = 0; i < ncells; i++) {
+            if (qemuHugepagesReserveCell(ledger, cfg, vm, res, i,
+                                         virDomainNumaGetNodeMemorySize(vm->def->numa, i)) < 0) {
+                g_hash_table_remove(ledger->domains, uuidstr);
+                return -1;
+            }
+        }
+
+        for (i = 0; i < res->nitems; i++) {
+            VIR_DEBUG("Reserved %llu huge pages of size %u KiB on node %d for domain %s",
+                      res->items[i].npages, res->items[i].pagesize,
+                      res->items[i].node, vm->def->name);
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * qemuHugepagesRelease:
+ * @driver: qemu driver
+ * @vm: domain object
+ *
+ * Drop the huge page reservation of @vm, if there is any.
+ */
+void
+qemuHugepagesRelease(virQEMUDriver *driver,
+                     virDomainObj *vm)
+{
+    qemuHugepageLedger *ledger = driver->hugepageLedger;
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+
+    if (!ledger)
+        return;
+
+    virUUIDFormat(vm->def->uuid, uuidstr);
+
+    VIR_WITH_OBJECT_LOCK_GUARD(ledger) {
+        if (g_hash_table_remove(ledger->domains, uuidstr))
+            VIR_DEBUG("Released huge page reservation of domain %s",
+                      vm->def->name);
+    }
+}
+
+
+/**
+ * qemuHugepagesGetParameters:
+ * @driver: qemu driver
+ * @params: array to fill in
+ * @nparams: number of elements of @params
+ *
+ * Fill in up to QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM node memory parameters
+ * describing the current huge page reservations.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+qemuHugepagesGetParameters(virQEMUDriver *driver,
+                           virTypedParameterPtr params,
+                           int nparams)
+{
+    qemuHugepageLedger *ledger = driver->hugepageLedger;
+    unsigned long long reserved = 0;
+    unsigned int nreservations = 0;
+    unsigned long long grown = 0;
+    size_t i;
+
+    if (ledger) {
+        VIR_WITH_OBJECT_LOCK_GUARD(ledger) {
+            GHashTableIter iter;
+            gpointer value;
+
+            g_hash_table_iter_init(&iter, ledger->domains);
+            while (g_hash_table_iter_next(&iter, NULL, &value)) {
+                qemuHugepageDomainReservation *res = value;
+
+                for (i = 0; i < res->nitems; i++)
+                    reserved += res->items[i].npages * res->items[i].pagesize;
+            }
+
+            nreservations = g_hash_table_size(ledger->domains);
+            grown = ledger->grown;
+        }
+    }
+
+    for (i = 0; i < nparams && i < QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM; i++) {
+        virTypedParameterPtr param = &params[i];
+
+        switch (i) {
+        case 0:
+            if (virTypedParameterAssign(param, VIR_NODE_MEMORY_HUGEPAGES_RESERVED,
+                                        VIR_TYPED_PARAM_ULLONG, reserved) < 0)
+                return -1;
+            break;
+
+        case 1:
+            if (virTypedParameterAssign(param, VIR_NODE_MEMORY_HUGEPAGES_RESERVATIONS,
+                                        VIR_TYPED_PARAM_UINT, nreservations) < 0)
+                return -1;
+            break;
+
+        case 2:
+            if (virTypedParameterAssign(param, VIR_NODE_MEMORY_HUGEPAGES_GROWN,
+                                        VIR_TYPED_PARAM_ULLONG, grown) < 0)
+                return -1;
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -20,8 +20,11 @@
 
 #include <config.h>
 
+#include <sys/stat.h>
+
 #include "qemu_interop_config.h"
 #include "configmake.h"
+#include "virbuffer.h"
 #include "virerror.h"
 #include "virfile.h"
 #include "virhash.h"
@@ -79,22 +82,17 @@ qemuBuildFileList(GHashTable *files, const char *dir)
 
 #define QEMU_CONFDIR SYSCONFDIR "/qemu"
 
-int
-qemuInteropFetchConfigs(const char *name,
-                        char ***configs,
-                        bool privileged)
+/* Returns the list of directories searched for @name descriptors ordered
+ * from the lowest to the highest priority. */
+static GStrv
+qemuInteropGetConfigDirs(const char *name,
+                         bool privileged)
 {
-    g_autoptr(GHashTable) files = virHashNew(g_free);
-    g_autofree char *homeConfig = NULL;
-    g_autofree char *xdgConfig = NULL;
-    g_autofree char *dataLocation = virFileBuildPath(QEMU_DATADIR, name, NULL);
-    g_autofree char *confLocation = virFileBuildPath(QEMU_CONFDIR, name, NULL);
-    g_autofree virHashKeyValuePair *pairs = NULL;
-    size_t npairs;
-    virHashKeyValuePair *tmp = NULL;
-    size_t nconfigs = 0;
+    GStrv dirs = g_new0(char *, 4);
+    size_t ndirs = 0;
 
-    *configs = NULL;
+    dirs[ndirs++] = virFileBuildPath(QEMU_DATADIR, name, NULL);
+    dirs[ndirs++] = virFileBuildPath(QEMU_CONFDIR, name, NULL);
 
     if (!privileged) {
         /* This is a slight divergence from the specification.
@@ -102,7 +100,7 @@ qemuInteropFetchConfigs(const char *name,
          * much sense to parse files in root's home directory. It
          * makes sense only for session daemon which runs under
          * regular user. */
-        xdgConfig = g_strdup(getenv("XDG_CONFIG_HOME"));
+        g_autofree char *xdgConfig = g_strdup(getenv("XDG_CONFIG_HOME"));
 
         if (!xdgConfig) {
             g_autofree char *home = virGetUserDirectory();
@@ -110,18 +108,32 @@ qemuInteropFetchConfigs(const char *name,
             xdgConfig = g_strdup_printf("%s/.config", home);
         }
 
-        homeConfig = g_strdup_printf("%s/qemu/%s", xdgConfig, name);
+        dirs[ndirs++] = g_strdup_printf("%s/qemu/%s", xdgConfig, name);
     }
 
-    if (qemuBuildFileList(files, dataLocation) < 0)
-        return -1;
+    return dirs;
+}
 
-    if (qemuBuildFileList(files, confLocation) < 0)
-        return -1;
 
-    if (homeConfig &&
-        qemuBuildFileList(files, homeConfig) < 0)
-        return -1;
+int
+qemuInteropFetchConfigs(const char *name,
+                        char ***configs,
+                        bool privileged)
+{
+    g_autoptr(GHashTable) files = virHashNew(g_free);
+    g_auto(GStrv) dirs = qemuInteropGetConfigDirs(name, privileged);
+    g_autofree virHashKeyValuePair *pairs = NULL;
+    size_t npairs;
+    virHashKeyValuePair *tmp = NULL;
+    size_t nconfigs = 0;
+    char **dir;
+
+    *configs = NULL;
+
+    for (dir = dirs; *dir; dir++) {
+        if (qemuBuildFileList(files, *dir) < 0)
+            return -1;
+    }
 
     /* At this point, the @files hash table contains unique set of filenames
      * where each filename (as key) has the highest priority full pathname
@@ -160,3 +172,94 @@ qemuInteropFetchConfigs(const char *name,
 
     return 0;
 }
+
+
+#ifdef __APPLE__
+# define QEMU_INTEROP_STAT_CTIM(sb) ((sb)->st_ctimespec)
+# define QEMU_INTEROP_STAT_MTIM(sb) ((sb)->st_mtimespec)
+#else
+# define QEMU_INTEROP_STAT_CTIM(sb) ((sb)->st_ctim)
+# define QEMU_INTEROP_STAT_MTIM(sb) ((sb)->st_mtim)
+#endif
+
+/* Both timestamps with nanoseconds, files changed twice within the same
+ * second must still result in a different stamp. */
+static void
+qemuInteropStampTimes(virBuffer *buf,
+                      const struct stat *sb)
+{
+    virBufferAsprintf(buf, "%lld.%09ld:%lld.%09ld",
+                      (long long)QEMU_INTEROP_STAT_CTIM(sb).tv_sec,
+                      (long)QEMU_INTEROP_STAT_CTIM(sb).tv_nsec,
+                      (long long)QEMU_INTEROP_STAT_MTIM(sb).tv_sec,
+                      (long)QEMU_INTEROP_STAT_MTIM(sb).tv_nsec);
+}
+
+
+/**
+ * qemuInteropGetConfigsStamp:
+ * @name: name of the descriptor type (e.g. "firmware")
+ * @privileged: whether running as privileged daemon
+ *
+ * Computes a string describing the current state of all directories which
+ * are searched by qemuInteropFetchConfigs for @name descriptors. The string
+ * changes whenever a descriptor is added, removed, renamed or modified, which
+ * allows callers to cache data derived from the descriptors without having to
+ * read and parse them every time.
+ *
+ * Returns the stamp on success, NULL on error.
+ */
+char *
+qemuInteropGetConfigsStamp(const char *name,
+                           bool privileged)
+{
+    g_auto(GStrv) dirs = qemuInteropGetConfigDirs(name, privileged);
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    char **dir;
+
+    for (dir = dirs; *dir; dir++) {
+        g_autoptr(DIR) dirp = NULL;
+        struct dirent *ent = NULL;
+        struct stat sb;
+        int rc;
+
+        if ((rc = virDirOpenIfExists(&dirp, *dir)) < 0)
+            return NULL;
+
+        if (rc == 0 || fstat(dirfd(dirp), &sb) < 0) {
+            virBufferAsprintf(&buf, "%s:-;", *dir);
+            continue;
+        }
+
+        virBufferAsprintf(&buf, "%s:", *dir);
+        qemuInteropStampTimes(&buf, &sb);
+        virBufferAddLit(&buf, ";");
+
+        while ((rc = virDirRead(dirp, &ent, *dir)) > 0) {
+            g_autofree char *path = NULL;
+
+            if (STRPREFIX(ent->d_name, "."))
+                continue;
+
+            path = g_strdup_printf("%s/%s", *dir, ent->d_name);
+
+            /* Follow symlinks, descriptors are often provided as links. */
+            if (stat(path, &sb) < 0) {
+                virBufferAsprintf(&buf, "%s:-;", ent->d_name);
+                continue;
+            }
+
+            virBufferAsprintf(&buf, "%s:%llu:%lld:",
+                              ent->d_name,
+                              (unsigned long long)sb.st_ino,
+                              (long long)sb.st_size);
+            qemuInteropStampTimes(&buf, &sb);
+            virBufferAddLit(&buf, ";");
+        }
+
+        if (rc < 0)
+            return NULL;
+    }
+
+    return virBufferContentAndReset(&buf);
+}
@@ -23,3 +23,5 @@
 #include "internal.h"
 
 int qemuInteropFetchConfigs(const char *name, char ***configs, bool privileged);
+
+char *qemuInteropGetConfigsStamp(const char *name, bool privileged);
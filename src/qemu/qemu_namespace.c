@@ -40,6 +40,7 @@
 #include "virlog.h"
 #include "virdevmapper.h"
 #include "virglibutil.h"
+#include "virnsagent.h"
 
 #define VIR_FROM_THIS VIR_FROM_QEMU
 
@@ -908,6 +909,10 @@ void
 qemuDomainDestroyNamespace(virQEMUDriver *driver G_GNUC_UNUSED,
                            virDomainObj *vm)
 {
+    qemuDomainObjPrivate *priv = vm->privateData;
+
+    g_clear_pointer(&priv->nsagent, virNSAgentFree);
+
     if (qemuDomainNamespaceEnabled(vm, QEMU_DOMAIN_NS_MOUNT))
         qemuDomainDisableNamespace(vm, QEMU_DOMAIN_NS_MOUNT);
 }
@@ -992,156 +997,6 @@ qemuNamespaceMknodDataClear(qemuNamespaceMknodData *data)
 
 /* Our way of creating devices is highly linux specific */
 #if defined(__linux__)
-static int
-qemuNamespaceMknodOne(qemuNamespaceMknodItem *data)
-{
-    int ret = -1;
-    bool delDevice = false;
-    bool isLink = S_ISLNK(data->sb.st_mode);
-    bool isDev = S_ISCHR(data->sb.st_mode) || S_ISBLK(data->sb.st_mode);
-    bool isReg = S_ISREG(data->sb.st_mode) || S_ISFIFO(data->sb.st_mode) || S_ISSOCK(data->sb.st_mode);
-    bool isDir = S_ISDIR(data->sb.st_mode);
-    bool exists = false;
-
-    if (virFileExists(data->file))
-        exists = true;
-
-    if (virFileMakeParentPath(data->file) < 0) {
-        virReportSystemError(errno,
-                             _("Unable to create %1$s"), data->file);
-        goto cleanup;
-    }
-
-    if (isLink) {
-        g_autofree char *target = NULL;
-
-        if ((target = g_file_read_link(data->file, NULL)) &&
-            STREQ(target, data->target)) {
-            VIR_DEBUG("Skipping symlink %s -> %s which exists and points to correct target",
-                      data->file, data->target);
-        } else {
-            VIR_DEBUG("Creating symlink %s -> %s", data->file, data->target);
-
-            /* First, unlink the symlink target. Symlinks change and
-             * therefore we have no guarantees that pre-existing
-             * symlink is still valid. */
-            if (unlink(data->file) < 0 &&
-                errno != ENOENT) {
-                virReportSystemError(errno,
-                                     _("Unable to remove symlink %1$s"),
-                                     data->file);
-                goto cleanup;
-            }
-
-            if (symlink(data->target, data->file) < 0) {
-                virReportSystemError(errno,
-                                     _("Unable to create symlink %1$s (pointing to %2$s)"),
-                                     data->file, data->target);
-                goto cleanup;
-            } else {
-                delDevice = true;
-            }
-        }
-    } else if (isDev) {
-        GStatBuf sb;
-
-        if (g_lstat(data->file, &sb) >= 0 &&
-            sb.st_rdev == data->sb.st_rdev) {
-            VIR_DEBUG("Skipping dev %s (%d,%d) which exists and has correct MAJ:MIN",
-                       data->file, major(data->sb.st_rdev), minor(data->sb.st_rdev));
-        } else {
-            VIR_DEBUG("Creating dev %s (%d,%d)",
-                      data->file, major(data->sb.st_rdev), minor(data->sb.st_rdev));
-            unlink(data->file);
-            if (mknod(data->file, data->sb.st_mode, data->sb.st_rdev) < 0) {
-                virReportSystemError(errno,
-                                     _("Unable to create device %1$s"),
-                                     data->file);
-                goto cleanup;
-            } else {
-                delDevice = true;
-            }
-        }
-    } else if (isReg || isDir) {
-        /* We are not cleaning up disks on virDomainDetachDevice
-         * because disk might be still in use by different disk
-         * as its backing chain. This might however clash here.
-         * Therefore do the cleanup here. */
-        if (umount(data->file) < 0 &&
-            errno != ENOENT && errno != EINVAL) {
-            virReportSystemError(errno,
-                                 _("Unable to umount %1$s"),
-                                 data->file);
-            goto cleanup;
-        }
-        if ((isReg && virFileTouch(data->file, data->sb.st_mode) < 0) ||
-            (isDir && g_mkdir_with_parents(data->file, data->sb.st_mode) < 0))
-            goto cleanup;
-        delDevice = true;
-        /* Just create the file here so that code below sets
-         * proper owner and mode. Move the mount only after that. */
-    } else {
-        virReportError(VIR_ERR_OPERATION_UNSUPPORTED,
-                       _("unsupported device type %1$s 0%2$o"),
-                       data->file, data->sb.st_mode);
-        goto cleanup;
-    }
-
-    if (lchown(data->file, data->sb.st_uid, data->sb.st_gid) < 0) {
-        virReportSystemError(errno,
-                             _("Failed to chown device %1$s"),
-                             data->file);
-        goto cleanup;
-    }
-
-    /* Symlinks don't have mode */
-    if (!isLink &&
-        chmod(data->file, data->sb.st_mode) < 0) {
-        virReportSystemError(errno,
-                             _("Failed to set permissions for device %1$s"),
-                             data->file);
-        goto cleanup;
-    }
-
-    if (data->acl &&
-        virFileSetACLs(data->file, data->acl) < 0 &&
-        errno != ENOTSUP) {
-        virReportSystemError(errno,
-                             _("Unable to set ACLs on %1$s"), data->file);
-        goto cleanup;
-    }
-
-# ifdef WITH_SELINUX
-    if (data->tcon &&
-        lsetfilecon_raw(data->file, (const char *)data->tcon) < 0) {
-        VIR_WARNINGS_NO_WLOGICALOP_EQUAL_EXPR
-        if (errno != EOPNOTSUPP && errno != ENOTSUP) {
-        VIR_WARNINGS_RESET
-            virReportSystemError(errno,
-                                 _("Unable to set SELinux label on %1$s"),
-                                 data->file);
-            goto cleanup;
-        }
-    }
-# endif
-
-    /* Finish mount process started earlier. */
-    if ((isReg || isDir) &&
-        virFileMoveMount(data->target, data->file) < 0)
-        goto cleanup;
-
-    ret = exists;
- cleanup:
-    if (ret < 0 && delDevice) {
-        if (isDir)
-            virFileDeleteTree(data->file);
-        else
-            unlink(data->file);
-    }
-    return ret;
-}
-
-
 static bool
 qemuNamespaceMknodItemNeedsBindMount(mode_t st_mode)
 {
@@ -1153,34 +1008,46 @@ qemuNamespaceMknodItemNeedsBindMount(mode_t st_mode)
 }
 
 
-static int
-qemuNamespaceMknodHelper(pid_t pid G_GNUC_UNUSED,
-                         void *opaque)
+static virJSONValue *
+qemuNamespaceMknodItemFormatJSON(qemuNamespaceMknodItem *item)
 {
-    qemuNamespaceMknodData *data = opaque;
-    size_t i;
-    int ret = -1;
-    bool exists = false;
-
-    qemuSecurityPostFork(data->driver->securityManager);
+    g_autoptr(virJSONValue) ret = NULL;
+    g_autofree char *acl = NULL;
+    const char *tcon = NULL;
 
-    for (i = 0; i < data->nitems; i++) {
-        int rc = 0;
+    if (item->acl &&
+        !(acl = virFileFormatACLs(item->acl))) {
+        virReportSystemError(errno,
+                             _("Unable to format ACLs of %1$s"), item->file);
+        return NULL;
+    }
 
-        if ((rc = qemuNamespaceMknodOne(&data->items[i])) < 0)
-            goto cleanup;
+# ifdef WITH_SELINUX
+    tcon = item->tcon;
+# endif
 
-        if (rc > 0)
-            exists = true;
-    }
+    if (virJSONValueObjectAdd(&ret,
+                              "s:file", item->file,
+                              "S:target", item->target,
+                              "u:mode", (unsigned int) item->sb.st_mode,
+                              "U:rdev", (unsigned long long) item->sb.st_rdev,
+                              "u:uid", (unsigned int) item->sb.st_uid,
+                              "u:gid", (unsigned int) item->sb.st_gid,
+                              "S:acl", acl,
+                              "S:tcon", tcon,
+                              NULL) < 0)
+        return NULL;
 
-    ret = exists;
- cleanup:
-    qemuNamespaceMknodDataClear(data);
-    return ret;
+    return g_steal_pointer(&ret);
 }
 
 
+static int
+qemuNamespaceRunAgent(virDomainObj *vm,
+                      const char *command,
+                      virJSONValue **args);
+
+
 static int
 qemuNamespaceMknodItemInit(qemuNamespaceMknodItem *item,
                            virQEMUDriverConfig *cfg,
@@ -1329,6 +1196,8 @@ qemuNamespaceMknodPaths(virDomainObj *vm,
     g_autoptr(virQEMUDriverConfig) cfg = NULL;
     g_auto(GStrv) devMountsPath = NULL;
     qemuNamespaceMknodData data = { 0 };
+    g_autoptr(virJSONValue) items = NULL;
+    g_autoptr(virJSONValue) args = NULL;
     size_t i;
     int ret = -1;
     GSList *next;
@@ -1363,12 +1232,20 @@ qemuNamespaceMknodPaths(virDomainObj *vm,
         }
     }
 
-    if (qemuSecurityPreFork(driver->securityManager) < 0)
+    items = virJSONValueNewArray();
+
+    for (i = 0; i < data.nitems; i++) {
+        g_autoptr(virJSONValue) item = NULL;
+
+        if (!(item = qemuNamespaceMknodItemFormatJSON(&data.items[i])) ||
+            virJSONValueArrayAppend(items, &item) < 0)
+            goto cleanup;
+    }
+
+    if (virJSONValueObjectAdd(&args, "a:items", &items, NULL) < 0)
         goto cleanup;
 
-    ret = virProcessRunInMountNamespace(vm->pid, qemuNamespaceMknodHelper,
-                                        &data);
-    qemuSecurityPostFork(driver->securityManager);
+    ret = qemuNamespaceRunAgent(vm, "mknod", &args);
 
     if (ret == 0 && created != NULL)
         *created = true;
@@ -1402,25 +1279,31 @@ qemuNamespaceMknodPaths(virDomainObj *vm G_GNUC_UNUSED,
 #endif /* !defined(__linux__) */
 
 
+/*
+ * Runs @command in the namespace agent of @vm, starting it first if
+ * needed. The agent lives as long as the domain and saves a fork of the
+ * whole daemon for every batch of paths created in or removed from the
+ * namespace. See src/util/nsagent.c for the commands. The agent doesn't
+ * use the security manager, so unlike the forks of
+ * virProcessRunInMountNamespace() it doesn't need qemuSecurityPreFork().
+ */
 static int
-qemuNamespaceUnlinkHelper(pid_t pid G_GNUC_UNUSED,
-                          void *opaque)
+qemuNamespaceRunAgent(virDomainObj *vm,
+                      const char *command,
+                      virJSONValue **args)
 {
-    g_autoptr(virGSListString) paths = opaque;
-    GSList *next;
+    qemuDomainObjPrivate *priv = vm->privateData;
 
-    for (next = paths; next; next = next->next) {
-        const char *path = next->data;
+    if (priv->nsagent &&
+        (virNSAgentIsBroken(priv->nsagent) ||
+         virNSAgentGetTargetPid(priv->nsagent) != vm->pid))
+        g_clear_pointer(&priv->nsagent, virNSAgentFree);
 
-        VIR_DEBUG("Unlinking %s", path);
-        if (unlink(path) < 0 && errno != ENOENT) {
-            virReportSystemError(errno,
-                                 _("Unable to remove device %1$s"), path);
-            return -1;
-        }
-    }
+    if (!priv->nsagent &&
+        !(priv->nsagent = virNSAgentNew(vm->pid)))
+        return -1;
 
-    return 0;
+    return virNSAgentRun(priv->nsagent, command, args);
 }
 
 
@@ -1433,6 +1316,8 @@ qemuNamespaceUnlinkPaths(virDomainObj *vm,
     g_autoptr(virQEMUDriverConfig) cfg = NULL;
     g_auto(GStrv) devMountsPath = NULL;
     g_autoptr(virGSListString) unlinkPaths = NULL;
+    g_autoptr(virJSONValue) array = NULL;
+    g_autoptr(virJSONValue) args = NULL;
     GSList *next;
 
     if (!paths)
@@ -1474,10 +1359,20 @@ qemuNamespaceUnlinkPaths(virDomainObj *vm,
         }
     }
 
-    if (unlinkPaths &&
-        virProcessRunInMountNamespace(vm->pid,
-                                      qemuNamespaceUnlinkHelper,
-                                      unlinkPaths) < 0)
+    if (!unlinkPaths)
+        return 0;
+
+    array = virJSONValueNewArray();
+
+    for (next = unlinkPaths; next; next = next->next) {
+        if (virJSONValueArrayAppendString(array, next->data) < 0)
+            return -1;
+    }
+
+    if (virJSONValueObjectAdd(&args, "a:paths", &array, NULL) < 0)
+        return -1;
+
+    if (qemuNamespaceRunAgent(vm, "unlink", &args) < 0)
         return -1;
 
     return 0;
@@ -682,7 +682,7 @@ qemuNbdkitProcessStartMonitor(qemuNbdkitProcess *proc WITHOUT_NBDKIT_UNUSED,
     int pidfd;
     qemuNbdkitProcessEventData *data;
 
-    pidfd = syscall(SYS_pidfd_open, proc->pid, 0);
+    pidfd = virProcessPidFDOpen(proc->pid);
     if (pidfd < 0) {
         virReportSystemError(errno, _("pidfd_open failed for %1$i"), proc->pid);
         return -1;
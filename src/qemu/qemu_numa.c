@@ -0,0 +1,727 @@
+/*
+ * qemu_numa.c: QEMU automatic NUMA placement and rebalancing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_numa.h"
+#include "qemu_domain.h"
+#include "qemu_process.h"
+#include "domain_cgroup.h"
+#include "domain_event.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+#include "virnuma.h"
+#include "virprocess.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_numa");
+
+/* Maximum number of domains moved per rebalancing interval */
+#define QEMU_NUMA_REBALANCE_MAX_MOVES 1
+
+/* Number of rebalancing intervals a domain is left alone after it was moved */
+#define QEMU_NUMA_REBALANCE_COOLDOWN 10
+
+
+static void
+qemuNumaLoadUpdate(virQEMUDriver *driver,
+                   virBitmap *nodeset,
+                   unsigned int vcpus,
+                   bool add)
+{
+    size_t nnodes = virBitmapCountBits(nodeset);
+    unsigned int share;
+    ssize_t node = -1;
+
+    if (nnodes == 0 || vcpus == 0)
+        return;
+
+    share = VIR_DIV_UP(vcpus, nnodes);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        while ((node = virBitmapNextSetBit(nodeset, node)) >= 0) {
+            if ((size_t) node >= driver->nnumaNodeVcpus) {
+                if (!add)
+                    continue;
+
+                VIR_EXPAND_N(driver->numaNodeVcpus, driver->nnumaNodeVcpus,
+                             node + 1 - driver->nnumaNodeVcpus);
+            }
+
+            if (add)
+                driver->numaNodeVcpus[node] += share;
+            else
+                driver->numaNodeVcpus[node] -= MIN(share, driver->numaNodeVcpus[node]);
+        }
+    }
+}
+
+
+/**
+ * qemuNumaLoadAdd:
+ * @driver: QEMU driver
+ * @vm: domain object
+ *
+ * Account vCPUs of @vm to the host NUMA nodes it was automatically placed
+ * on, so that the built-in placement engine can avoid overloaded nodes.
+ */
+void
+qemuNumaLoadAdd(virQEMUDriver *driver,
+                virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+
+    if (!priv->autoNodeset || priv->autoPlacedVcpus > 0)
+        return;
+
+    priv->autoPlacedVcpus = virDomainDefGetVcpus(vm->def);
+    qemuNumaLoadUpdate(driver, priv->autoNodeset,
+                       priv->autoPlacedVcpus, true);
+}
+
+
+void
+qemuNumaLoadRemove(virQEMUDriver *driver,
+                   virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+
+    if (!priv->autoNodeset || priv->autoPlacedVcpus == 0)
+        return;
+
+    qemuNumaLoadUpdate(driver, priv->autoNodeset,
+                       priv->autoPlacedVcpus, false);
+    priv->autoPlacedVcpus = 0;
+}
+
+
+/**
+ * qemuNumaGetNodeStatus:
+ * @driver: QEMU driver
+ * @caps: host NUMA topology
+ * @pagesize: size of pages the domain uses in KiB, 0 for regular pages
+ * @nstatus: returned number of items
+ *
+ * Collect the current free memory (or free huge pages of @pagesize) of each
+ * host NUMA node and the vCPUs of domains with automatic placement.
+ *
+ * Returns: per node status indexed by node number.
+ */
+static virCapsHostNUMANodeStatus *
+qemuNumaGetNodeStatus(virQEMUDriver *driver,
+                      virCapsHostNUMA *caps,
+                      unsigned int pagesize,
+                      size_t *nstatus)
+{
+    g_autofree virCapsHostNUMANodeStatus *status = NULL;
+    size_t n = virCapabilitiesHostNUMAGetMaxNode(caps) + 1;
+    size_t node;
+
+    status = g_new0(virCapsHostNUMANodeStatus, n);
+
+    for (node = 0; node < n; node++) {
+        unsigned long long memfree = 0;
+
+        if (!virNumaNodeIsAvailable(node))
+            continue;
+
+        if (pagesize > 0) {
+            if (virNumaGetPageInfo(node, pagesize, 0, NULL, &memfree) < 0) {
+                VIR_DEBUG("No free %uKiB pages on node %zu", pagesize, node);
+                virResetLastError();
+                continue;
+            }
+
+            status[node].memFree = memfree * pagesize;
+        } else {
+            if (virNumaGetNodeMemory(node, NULL, &memfree) < 0)
+                continue;
+
+            status[node].memFree = memfree / 1024;
+        }
+    }
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        for (node = 0; node < n && node < driver->nnumaNodeVcpus; node++)
+            status[node].vcpus = driver->numaNodeVcpus[node];
+    }
+
+    *nstatus = n;
+    return g_steal_pointer(&status);
+}
+
+
+/**
+ * qemuNumaGetBuiltinPlacement:
+ * @driver: QEMU driver
+ * @vm: domain object
+ * @caps: host NUMA topology
+ *
+ * Let the built-in placement engine select host NUMA nodes for @vm based on
+ * the current free memory (or free huge pages if the domain is backed by
+ * them) of each node and the vCPUs of other domains with automatic
+ * placement.
+ *
+ * Returns: nodeset on success,
+ *          NULL on error.
+ */
+virBitmap *
+qemuNumaGetBuiltinPlacement(virQEMUDriver *driver,
+                            virDomainObj *vm,
+                            virCapsHostNUMA *caps)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    g_autofree virCapsHostNUMANodeStatus *status = NULL;
+    size_t nstatus = 0;
+    unsigned int pagesize = 0;
+
+    if (vm->def->mem.nhugepages > 0) {
+        pagesize = vm->def->mem.hugepages[0].size;
+
+        if (pagesize == 0) {
+            virHugeTLBFS *fs = virFileGetDefaultHugepage(cfg->hugetlbfs,
+                                                         cfg->nhugetlbfs);
+
+            if (fs)
+                pagesize = fs->size;
+        }
+    }
+
+    if (!virNumaIsAvailable()) {
+        /* Fake single node topology */
+        nstatus = 1;
+        status = g_new0(virCapsHostNUMANodeStatus, 1);
+        status[0].memFree = virDomainDefGetMemoryTotal(vm->def);
+    } else {
+        status = qemuNumaGetNodeStatus(driver, caps, pagesize, &nstatus);
+    }
+
+    return virCapabilitiesHostNUMAPlace(caps, status, nstatus,
+                                        virDomainDefGetVcpus(vm->def),
+                                        virDomainDefGetMemoryTotal(vm->def));
+}
+
+
+/**
+ * qemuNumaRebalanceIsEligible:
+ * @vm: domain object
+ *
+ * Only domains whose memory can be migrated between host NUMA nodes at
+ * runtime, i.e. those with restrictive automatic memory placement not backed
+ * by huge pages, are considered for rebalancing.
+ *
+ * Returns: true if @vm can be moved to other host NUMA nodes.
+ */
+static bool
+qemuNumaRebalanceIsEligible(virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    virDomainNumatuneMemMode mode;
+    size_t i;
+
+    if (!virDomainObjIsActive(vm) ||
+        !priv->autoNodeset ||
+        !priv->autoCpuset ||
+        priv->autoPlacedVcpus == 0)
+        return false;
+
+    if (vm->def->mem.nhugepages > 0)
+        return false;
+
+    if (!virDomainNumatuneHasPlacementAuto(vm->def->numa) ||
+        virDomainNumatuneGetMode(vm->def->numa, -1, &mode) < 0 ||
+        mode != VIR_DOMAIN_NUMATUNE_MEM_RESTRICTIVE)
+        return false;
+
+    for (i = 0; i < virDomainNumaGetNodeCount(vm->def->numa); i++) {
+        if (virDomainNumatuneGetMode(vm->def->numa, i, &mode) == 0 &&
+            mode != VIR_DOMAIN_NUMATUNE_MEM_RESTRICTIVE)
+            return false;
+    }
+
+    return virCgroupHasController(priv->cgroup, VIR_CGROUP_CONTROLLER_CPUSET);
+}
+
+
+/**
+ * qemuNumaRebalanceOvercommit:
+ * @caps: host NUMA topology
+ * @status: per node status
+ * @nstatus: number of items in @status
+ * @nodeset: host NUMA nodes
+ * @vcpus: number of vCPUs to add to the load of @nodeset
+ *
+ * Returns: vCPU overcommit of @nodeset in percent of its host CPUs, capped
+ *          at 100.
+ */
+static unsigned int
+qemuNumaRebalanceOvercommit(virCapsHostNUMA *caps,
+                            virCapsHostNUMANodeStatus *status,
+                            size_t nstatus,
+                            virBitmap *nodeset,
+                            unsigned int vcpus)
+{
+    g_autoptr(virBitmap) cpus = virCapabilitiesHostNUMAGetCpus(caps, nodeset);
+    unsigned long long load = vcpus;
+    unsigned long long ncpus;
+    ssize_t node = -1;
+
+    if (!cpus || (ncpus = virBitmapCountBits(cpus)) == 0)
+        return 100;
+
+    while ((node = virBitmapNextSetBit(nodeset, node)) >= 0) {
+        if ((size_t) node < nstatus)
+            load += status[node].vcpus;
+    }
+
+    if (load <= ncpus)
+        return 0;
+
+    return MIN(100, (load - ncpus) * 100 / ncpus);
+}
+
+
+/**
+ * qemuNumaRebalanceLocality:
+ * @memory: per node memory usage of the domain
+ * @nmemory: number of items in @memory
+ * @total: sum of @memory
+ * @nodeset: host NUMA nodes
+ *
+ * Returns: share of the domain's memory residing on @nodeset in percent.
+ */
+static unsigned int
+qemuNumaRebalanceLocality(unsigned long long *memory,
+                          size_t nmemory,
+                          unsigned long long total,
+                          virBitmap *nodeset)
+{
+    unsigned long long local = 0;
+    ssize_t node = -1;
+
+    if (total == 0)
+        return 100;
+
+    while ((node = virBitmapNextSetBit(nodeset, node)) >= 0) {
+        if ((size_t) node < nmemory)
+            local += memory[node];
+    }
+
+    return local * 100 / total;
+}
+
+
+/**
+ * qemuNumaRebalanceFindPlacement:
+ * @driver: QEMU driver
+ * @vm: domain object
+ * @caps: host NUMA topology
+ * @cpuset: returned host CPUs of the new placement
+ *
+ * Run the built-in placement engine for @vm as if it was not running and
+ * compare the result with its current placement. The domain's own vCPUs are
+ * not counted as load of its current nodes and its resident memory is
+ * counted as free memory of the nodes it resides on.
+ *
+ * Returns: host NUMA nodes with memory @vm should be moved to,
+ *          NULL if the current placement is good enough or on error.
+ */
+static virBitmap *
+qemuNumaRebalanceFindPlacement(virQEMUDriver *driver,
+                               virDomainObj *vm,
+                               virCapsHostNUMA *caps,
+                               virBitmap **cpuset)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autofree virCapsHostNUMANodeStatus *status = NULL;
+    g_autofree unsigned long long *memory = NULL;
+    g_autoptr(virBitmap) placement = NULL;
+    g_autoptr(virBitmap) nodeset = NULL;
+    g_autoptr(virBitmap) hostMemoryNodeset = NULL;
+    g_autofree char *curStr = NULL;
+    g_autofree char *newStr = NULL;
+    size_t nstatus = 0;
+    size_t nmemory = 0;
+    unsigned long long total = 0;
+    unsigned int vcpus = priv->autoPlacedVcpus;
+    unsigned int share;
+    int score;
+    ssize_t node = -1;
+    size_t i;
+
+    if (virNumaGetProcessMemory(vm->pid, &memory, &nmemory) < 0)
+        return NULL;
+
+    status = qemuNumaGetNodeStatus(driver, caps, 0, &nstatus);
+
+    share = VIR_DIV_UP(vcpus, virBitmapCountBits(priv->autoNodeset));
+    while ((node = virBitmapNextSetBit(priv->autoNodeset, node)) >= 0) {
+        if ((size_t) node < nstatus)
+            status[node].vcpus -= MIN(share, status[node].vcpus);
+    }
+
+    for (i = 0; i < nmemory; i++) {
+        if (i < nstatus)
+            status[i].memFree += memory[i];
+        total += memory[i];
+    }
+
+    if (!(placement = virCapabilitiesHostNUMAPlace(caps, status, nstatus, vcpus,
+                                                   MAX(total, virDomainDefGetMemoryTotal(vm->def)))))
+        return NULL;
+
+    if (!(hostMemoryNodeset = virNumaGetHostMemoryNodeset()))
+        return NULL;
+
+    nodeset = virBitmapNewCopy(placement);
+    virBitmapIntersect(nodeset, hostMemoryNodeset);
+
+    if (virBitmapIsAllClear(nodeset) ||
+        virBitmapEqual(nodeset, priv->autoNodeset))
+        return NULL;
+
+    /* Lower vCPU overcommit and more local memory both count as improvement */
+    score = (int) qemuNumaRebalanceOvercommit(caps, status, nstatus,
+                                              priv->autoNodeset, vcpus);
+    score -= (int) qemuNumaRebalanceOvercommit(caps, status, nstatus,
+                                               placement, vcpus);
+    score += (int) qemuNumaRebalanceLocality(memory, nmemory, total, nodeset);
+    score -= (int) qemuNumaRebalanceLocality(memory, nmemory, total,
+                                             priv->autoNodeset);
+
+    curStr = virBitmapFormat(priv->autoNodeset);
+    newStr = virBitmapFormat(nodeset);
+    VIR_DEBUG("vm=%s current=%s proposed=%s score=%d threshold=%u",
+              vm->def->name, curStr, newStr, score,
+              cfg->numaRebalanceThreshold);
+
+    if (score < (int) cfg->numaRebalanceThreshold)
+        return NULL;
+
+    if (!(*cpuset = virCapabilitiesHostNUMAGetCpus(caps, placement)))
+        return NULL;
+
+    return g_steal_pointer(&nodeset);
+}
+
+
+static int
+qemuNumaRebalanceSetupThread(virDomainObj *vm,
+                             virCgroupThreadName nameval,
+                             int id,
+                             pid_t pid,
+                             virBitmap *cpumask,
+                             virBitmap *cpuset,
+                             const char *mems)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virCgroup) cgroup = NULL;
+
+    if (virCgroupNewThread(priv->cgroup, nameval, id, false, &cgroup) < 0)
+        return -1;
+
+    /* Threads pinned explicitly keep their pinning */
+    if (qemuDomainEvaluateCPUMask(vm->def, cpumask, cpuset) == cpuset) {
+        if (virDomainCgroupSetupCpusetCpus(cgroup, cpuset) < 0)
+            return -1;
+
+        if (pid > 0 && virProcessSetAffinity(pid, cpuset, false) < 0)
+            return -1;
+    }
+
+    if (virCgroupSetCpusetMemoryMigrate(cgroup, true) < 0 ||
+        virCgroupSetCpusetMems(cgroup, mems) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+/**
+ * qemuNumaRebalanceSetup:
+ * @vm: domain object
+ * @nodeset: host NUMA nodes for the domain memory
+ * @cpuset: host CPUs for threads without explicit pinning
+ *
+ * Move the emulator, vCPU and IOThread threads of @vm to @cpuset and make
+ * the kernel migrate their memory to @nodeset.
+ *
+ * Returns: 0 on success,
+ *         -1 on error.
+ */
+static int
+qemuNumaRebalanceSetup(virDomainObj *vm,
+                       virBitmap *nodeset,
+                       virBitmap *cpuset)
+{
+    g_autofree char *mems = virBitmapFormat(nodeset);
+    size_t i;
+
+    if (qemuNumaRebalanceSetupThread(vm, VIR_CGROUP_THREAD_EMULATOR, 0,
+                                     vm->pid, vm->def->cputune.emulatorpin,
+                                     cpuset, mems) < 0)
+        return -1;
+
+    for (i = 0; i < virDomainDefGetVcpusMax(vm->def); i++) {
+        virDomainVcpuDef *vcpu = virDomainDefGetVcpu(vm->def, i);
+
+        if (!vcpu->online)
+            continue;
+
+        if (qemuNumaRebalanceSetupThread(vm, VIR_CGROUP_THREAD_VCPU, i,
+                                         qemuDomainGetVcpuPid(vm, i),
+                                         vcpu->cpumask, cpuset, mems) < 0)
+            return -1;
+    }
+
+    for (i = 0; i < vm->def->niothreadids; i++) {
+        virDomainIOThreadIDDef *iothread = vm->def->iothreadids[i];
+
+        if (qemuNumaRebalanceSetupThread(vm, VIR_CGROUP_THREAD_IOTHREAD,
+                                         iothread->iothread_id,
+                                         iothread->thread_id,
+                                         iothread->cpumask, cpuset, mems) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+static void
+qemuNumaRebalanceEmitEvent(virQEMUDriver *driver,
+                           virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+    int maxparams = 0;
+    g_autofree char *nodesetStr = virBitmapFormat(priv->autoNodeset);
+    g_autofree char *cpusetStr = virBitmapFormat(priv->autoCpuset);
+    virObjectEvent *event = NULL;
+    size_t i;
+
+    if (virTypedParamsAddString(&params, &nparams, &maxparams,
+                                VIR_DOMAIN_TUNABLE_NUMA_NODESET,
+                                nodesetStr) < 0)
+        goto cleanup;
+
+    if (qemuDomainEvaluateCPUMask(vm->def, vm->def->cputune.emulatorpin,
+                                  priv->autoCpuset) == priv->autoCpuset &&
+        virTypedParamsAddString(&params, &nparams, &maxparams,
+                                VIR_DOMAIN_TUNABLE_CPU_EMULATORPIN,
+                                cpusetStr) < 0)
+        goto cleanup;
+
+    for (i = 0; i < virDomainDefGetVcpusMax(vm->def); i++) {
+        virDomainVcpuDef *vcpu = virDomainDefGetVcpu(vm->def, i);
+        char paramField[VIR_TYPED_PARAM_FIELD_LENGTH] = "";
+
+        if (!vcpu->online ||
+            qemuDomainEvaluateCPUMask(vm->def, vcpu->cpumask,
+                                      priv->autoCpuset) != priv->autoCpuset)
+            continue;
+
+        g_snprintf(paramField, VIR_TYPED_PARAM_FIELD_LENGTH,
+                   VIR_DOMAIN_TUNABLE_CPU_VCPUPIN, (unsigned int) i);
+
+        if (virTypedParamsAddString(&params, &nparams, &maxparams,
+                                    paramField, cpusetStr) < 0)
+            goto cleanup;
+    }
+
+    event = virDomainEventTunableNewFromObj(vm, &params, nparams);
+    virObjectEventStateQueue(driver->domainEventState, event);
+
+ cleanup:
+    virTypedParamsFree(params, nparams);
+}
+
+
+/**
+ * qemuNumaRebalanceDomain:
+ * @driver: QEMU driver
+ * @vm: domain object, locked
+ *
+ * Move @vm to other host NUMA nodes if the built-in placement engine finds
+ * nodes that are better by at least numa_rebalance_threshold percent. At
+ * most QEMU_NUMA_REBALANCE_MAX_MOVES domains are moved per rebalancing
+ * interval and a domain is not moved again for
+ * QEMU_NUMA_REBALANCE_COOLDOWN intervals.
+ */
+void
+qemuNumaRebalanceDomain(virQEMUDriver *driver,
+                        virDomainObj *vm)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virCapsHostNUMA) caps = NULL;
+    g_autoptr(virBitmap) nodeset = NULL;
+    g_autoptr(virBitmap) cpuset = NULL;
+    g_autofree char *nodesetStr = NULL;
+    unsigned long long now = g_get_monotonic_time() / G_USEC_PER_SEC;
+    bool reserved = false;
+
+    /* Don't wait for other jobs, the domain is checked again later */
+    if (virDomainObjBeginJobNowait(vm, VIR_JOB_MODIFY) < 0) {
+        virResetLastError();
+        return;
+    }
+
+    if (!qemuNumaRebalanceIsEligible(vm))
+        goto endjob;
+
+    if (priv->numaRebalanceTime > 0 &&
+        now - priv->numaRebalanceTime <
+        (unsigned long long) cfg->numaRebalanceInterval * QEMU_NUMA_REBALANCE_COOLDOWN)
+        goto endjob;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        if (driver->numaRebalanceMoves < QEMU_NUMA_REBALANCE_MAX_MOVES) {
+            driver->numaRebalanceMoves++;
+            reserved = true;
+        }
+    }
+
+    if (!reserved)
+        goto endjob;
+
+    if (!(caps = virCapabilitiesHostNUMANewHost()))
+        goto cleanup;
+
+    if (!(nodeset = qemuNumaRebalanceFindPlacement(driver, vm, caps, &cpuset)))
+        goto cleanup;
+
+    nodesetStr = virBitmapFormat(nodeset);
+    VIR_INFO("Moving domain %s to host NUMA nodes %s",
+             vm->def->name, nodesetStr);
+
+    if (qemuNumaRebalanceSetup(vm, nodeset, cpuset) < 0) {
+        virErrorPtr orig_err;
+
+        virErrorPreserveLast(&orig_err);
+        ignore_value(qemuNumaRebalanceSetup(vm, priv->autoNodeset,
+                                            priv->autoCpuset));
+        virErrorRestore(&orig_err);
+        VIR_WARN("Unable to move domain %s to other host NUMA nodes: %s",
+                 vm->def->name, virGetLastErrorMessage());
+        goto cleanup;
+    }
+
+    qemuNumaLoadRemove(driver, vm);
+    virBitmapFree(priv->autoNodeset);
+    priv->autoNodeset = g_steal_pointer(&nodeset);
+    virBitmapFree(priv->autoCpuset);
+    priv->autoCpuset = g_steal_pointer(&cpuset);
+    qemuNumaLoadAdd(driver, vm);
+
+    priv->numaRebalanceTime = now;
+    reserved = false;
+
+    qemuDomainSaveStatus(vm);
+    qemuNumaRebalanceEmitEvent(driver, vm);
+
+ cleanup:
+    if (reserved) {
+        VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+            driver->numaRebalanceMoves--;
+        }
+    }
+    virResetLastError();
+
+ endjob:
+    virDomainObjEndJob(vm);
+}
+
+
+static int
+qemuNumaRebalanceCheckDomain(virDomainObj *vm,
+                             void *opaque G_GNUC_UNUSED)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(vm);
+
+    if (qemuNumaRebalanceIsEligible(vm))
+        qemuProcessEventSubmit(vm, QEMU_PROCESS_EVENT_NUMA_REBALANCE,
+                               0, 0, NULL);
+
+    return 0;
+}
+
+
+static void
+qemuNumaRebalanceTimer(int timer G_GNUC_UNUSED,
+                       void *opaque)
+{
+    virQEMUDriver *driver = opaque;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&driver->lock) {
+        driver->numaRebalanceMoves = 0;
+    }
+
+    virDomainObjListForEach(driver->domains, false,
+                            qemuNumaRebalanceCheckDomain, NULL);
+}
+
+
+/**
+ * qemuNumaRebalanceInit:
+ * @driver: QEMU driver
+ *
+ * Start periodic NUMA rebalancing if numa_rebalance_interval is set.
+ *
+ * Returns: 0 on success,
+ *         -1 on error.
+ */
+int
+qemuNumaRebalanceInit(virQEMUDriver *driver)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+
+    if (cfg->numaRebalanceInterval == 0)
+        return 0;
+
+    if (!driver->privileged || !virNumaIsAvailable()) {
+        VIR_DEBUG("NUMA rebalancing is not available");
+        return 0;
+    }
+
+    if ((driver->numaRebalanceTimer = virEventAddTimeout(cfg->numaRebalanceInterval * 1000,
+                                                         qemuNumaRebalanceTimer,
+                                                         driver, NULL)) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("could not initialize NUMA rebalancing timer"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+void
+qemuNumaRebalanceCleanup(virQEMUDriver *driver)
+{
+    if (driver->numaRebalanceTimer < 0)
+        return;
+
+    virEventRemoveTimeout(driver->numaRebalanceTimer);
+    driver->numaRebalanceTimer = -1;
+}
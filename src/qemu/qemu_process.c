@@ -46,12 +46,14 @@
 #include "qemu_domain.h"
 #include "qemu_domain_address.h"
 #include "qemu_namespace.h"
+#include "qemu_numa.h"
 #include "qemu_cgroup.h"
 #include "qemu_capabilities.h"
 #include "qemu_monitor.h"
 #include "qemu_command.h"
 #include "qemu_hostdev.h"
 #include "qemu_hotplug.h"
+#include "qemu_hugepages.h"
 #include "qemu_migration.h"
 #include "qemu_migration_params.h"
 #include "qemu_interface.h"
@@ -271,7 +273,7 @@ qemuConnectAgent(virQEMUDriver *driver, virDomainObj *vm)
  *
  * Submits @eventType to be processed by the asynchronous event handling thread.
  */
-static void
+void
 qemuProcessEventSubmit(virDomainObj *vm,
                        qemuProcessEventType eventType,
                        int action,
@@ -6329,46 +6331,56 @@ qemuProcessUpdateGuestCPU(virDomainDef *def,
 
 
 static int
-qemuProcessPrepareDomainNUMAPlacement(virDomainObj *vm)
+qemuProcessPrepareDomainNUMAPlacement(virQEMUDriver *driver,
+                                      virDomainObj *vm)
 {
     qemuDomainObjPrivate *priv = vm->privateData;
-    g_autofree char *nodeset = NULL;
-    g_autoptr(virBitmap) numadNodeset = NULL;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    g_autoptr(virBitmap) autoNodeset = NULL;
     g_autoptr(virBitmap) hostMemoryNodeset = NULL;
     g_autoptr(virCapsHostNUMA) caps = NULL;
 
-    /* Get the advisory nodeset from numad if 'placement' of
-     * either <vcpu> or <numatune> is 'auto'.
+    /* Get the advisory nodeset if 'placement' of either <vcpu> or
+     * <numatune> is 'auto'.
      */
     if (!virDomainDefNeedsPlacementAdvice(vm->def))
         return 0;
 
-    nodeset = virNumaGetAutoPlacementAdvice(virDomainDefGetVcpus(vm->def),
-                                            virDomainDefGetMemoryTotal(vm->def));
-
-    if (!nodeset)
+    if (!(caps = virCapabilitiesHostNUMANewHost()))
         return -1;
 
-    if (!(hostMemoryNodeset = virNumaGetHostMemoryNodeset()))
-        return -1;
+    if (cfg->numaPlacement == QEMU_NUMA_PLACEMENT_BUILTIN) {
+        if (!(autoNodeset = qemuNumaGetBuiltinPlacement(driver, vm, caps)))
+            return -1;
+    } else {
+        g_autofree char *nodeset = NULL;
 
-    VIR_DEBUG("Nodeset returned from numad: %s", nodeset);
+        nodeset = virNumaGetAutoPlacementAdvice(virDomainDefGetVcpus(vm->def),
+                                                virDomainDefGetMemoryTotal(vm->def));
 
-    if (virBitmapParse(nodeset, &numadNodeset, VIR_DOMAIN_CPUMASK_LEN) < 0)
-        return -1;
+        if (!nodeset)
+            return -1;
 
-    if (!(caps = virCapabilitiesHostNUMANewHost()))
+        VIR_DEBUG("Nodeset returned from numad: %s", nodeset);
+
+        if (virBitmapParse(nodeset, &autoNodeset, VIR_DOMAIN_CPUMASK_LEN) < 0)
+            return -1;
+    }
+
+    if (!(hostMemoryNodeset = virNumaGetHostMemoryNodeset()))
         return -1;
 
-    /* numad may return a nodeset that only contains cpus but cgroups don't play
-     * well with that. Set the autoCpuset from all cpus from that nodeset, but
-     * assign autoNodeset only with nodes containing memory. */
-    if (!(priv->autoCpuset = virCapabilitiesHostNUMAGetCpus(caps, numadNodeset)))
+    /* The advice may contain nodes that only contain cpus but cgroups don't
+     * play well with that. Set the autoCpuset from all cpus from that nodeset,
+     * but assign autoNodeset only with nodes containing memory. */
+    if (!(priv->autoCpuset = virCapabilitiesHostNUMAGetCpus(caps, autoNodeset)))
         return -1;
 
-    virBitmapIntersect(numadNodeset, hostMemoryNodeset);
+    virBitmapIntersect(autoNodeset, hostMemoryNodeset);
+
+    priv->autoNodeset = g_steal_pointer(&autoNodeset);
 
-    priv->autoNodeset = g_steal_pointer(&numadNodeset);
+    qemuNumaLoadAdd(driver, vm);
 
     return 0;
 }
@@ -6628,7 +6640,7 @@ qemuProcessPrepareDomain(virQEMUDriver *driver,
         }
         virDomainAuditSecurityLabel(vm, true);
 
-        if (qemuProcessPrepareDomainNUMAPlacement(vm) < 0)
+        if (qemuProcessPrepareDomainNUMAPlacement(driver, vm) < 0)
             return -1;
     }
 
@@ -7264,6 +7276,10 @@ qemuProcessPrepareHost(virQEMUDriver *driver,
     if (qemuProcessBuildDestroyMemoryPaths(driver, vm, NULL, true) < 0)
         return -1;
 
+    VIR_DEBUG("Reserving huge pages");
+    if (qemuHugepagesReserve(driver, vm) < 0)
+        return -1;
+
     /* Ensure no historical cgroup for this VM is lying around bogus
      * settings */
     VIR_DEBUG("Ensuring no historical cgroup is lying around");
@@ -7885,6 +7901,10 @@ qemuProcessLaunch(virConnectPtr conn,
     if (qemuProcessWaitForMonitor(driver, vm, asyncJob, logCtxt) < 0)
         goto cleanup;
 
+    /* Huge page backed memory is preallocated before QEMU starts serving
+     * the monitor, the pages are not free anymore. */
+    qemuHugepagesRelease(driver, vm);
+
     if (qemuConnectAgent(driver, vm) < 0)
         goto cleanup;
 
@@ -8700,8 +8720,12 @@ void qemuProcessStop(virQEMUDriver *driver,
 
     qemuSecurityReleaseLabel(driver->securityManager, vm->def);
 
+    qemuNumaLoadRemove(driver, vm);
+    qemuHugepagesRelease(driver, vm);
+
     /* clear all private data entries which are no longer needed */
     qemuDomainObjPrivateDataClear(priv);
+    qemuDomainPerfRefreshVcpus(vm);
 
     /* The "release" hook cleans up additional resources */
     if (virHookPresent(VIR_HOOK_DRIVER_QEMU)) {
@@ -9059,6 +9083,8 @@ qemuProcessReconnect(void *opaque)
     if (qemuHostdevUpdateActiveDomainDevices(driver, obj->def) < 0)
         goto error;
 
+    qemuNumaLoadAdd(driver, obj);
+
     if (qemuDomainObjStartWorker(obj) < 0)
         goto error;
 
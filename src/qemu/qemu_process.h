@@ -185,6 +185,12 @@ int qemuProcessKill(virDomainObj *vm, unsigned int flags);
 
 void qemuProcessShutdownOrReboot(virDomainObj *vm);
 
+void qemuProcessEventSubmit(virDomainObj *vm,
+                            qemuProcessEventType eventType,
+                            int action,
+                            int status,
+                            void *data);
+
 void qemuProcessAutoDestroy(virDomainObj *dom,
                             virConnectPtr conn);
 
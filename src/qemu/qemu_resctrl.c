@@ -0,0 +1,376 @@
+/*
+ * qemu_resctrl.c: QEMU resctrl monitor sampling and MBA feedback control
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_resctrl.h"
+#include "qemu_domain.h"
+#include "qemu_process.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virlog.h"
+#include "virresctrl.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_resctrl");
+
+/* Bandwidth is raised again once it drops below this percentage of the limit */
+#define QEMU_RESCTRL_MBA_RAISE_PERCENT 80
+
+
+static char **
+qemuResctrlGetMonitorFeatures(virCaps *caps,
+                              virResctrlMonitorType tag)
+{
+    switch (tag) {
+    case VIR_RESCTRL_MONITOR_TYPE_CACHE:
+        if (caps->host.cache.monitor)
+            return caps->host.cache.monitor->features;
+        break;
+    case VIR_RESCTRL_MONITOR_TYPE_MEMBW:
+        if (caps->host.memBW.monitor)
+            return caps->host.memBW.monitor->features;
+        break;
+    case VIR_RESCTRL_MONITOR_TYPE_UNSUPPORT:
+    case VIR_RESCTRL_MONITOR_TYPE_LAST:
+        break;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * qemuResctrlMemoryBandwidthNext:
+ * @current: memory bandwidth currently applied, in percent
+ * @configured: memory bandwidth from the domain definition, in percent
+ * @rate: measured memory bandwidth in bytes per second
+ * @limit: memory bandwidth limit in bytes per second
+ * @control: MBA properties of the host node
+ *
+ * Bandwidth above @limit is throttled proportionally in one step, bandwidth
+ * well below @limit is given back one granularity step at a time, up to
+ * @configured.
+ *
+ * Returns: memory bandwidth to apply, in percent.
+ */
+static unsigned int
+qemuResctrlMemoryBandwidthNext(unsigned int current,
+                               unsigned int configured,
+                               unsigned long long rate,
+                               unsigned long long limit,
+                               const virResctrlInfoMemBWPerNode *control)
+{
+    unsigned int granularity = MAX(control->granularity, 1);
+    unsigned int min = MAX(control->min, granularity);
+    unsigned int next = current;
+
+    if (rate > limit) {
+        next = current * limit / rate;
+        next -= next % granularity;
+
+        if (next >= current)
+            next = current > granularity ? current - granularity : current;
+
+        return MAX(next, min);
+    }
+
+    if (rate < limit / 100 * QEMU_RESCTRL_MBA_RAISE_PERCENT)
+        next = MIN(current + granularity, configured);
+
+    return MAX(next, current);
+}
+
+
+struct qemuResctrlControlData {
+    virDomainObj *vm;
+    virCaps *caps;
+    virResctrlAlloc *alloc;
+    unsigned long long limit;
+
+    /* Measured bandwidth per MBA node, indexed by node id */
+    unsigned long long *rates;
+    size_t nrates;
+    virBitmap *measured;
+};
+
+
+static int
+qemuResctrlControlNode(unsigned int id,
+                       unsigned int configured,
+                       void *opaque)
+{
+    struct qemuResctrlControlData *data = opaque;
+    virResctrlInfoMemBWPerNode control = { .granularity = 10, .min = 10 };
+    unsigned int current;
+    unsigned int next;
+    size_t i;
+
+    if (!virBitmapIsBitSet(data->measured, id))
+        return 0;
+
+    for (i = 0; i < data->caps->host.memBW.nnodes; i++) {
+        if (data->caps->host.memBW.nodes[i]->id == id) {
+            control = data->caps->host.memBW.nodes[i]->control;
+            break;
+        }
+    }
+
+    if (virResctrlAllocGetMemoryBandwidthLive(data->alloc, id, &current) < 0)
+        return 0;
+
+    next = qemuResctrlMemoryBandwidthNext(current, configured,
+                                          data->rates[id], data->limit,
+                                          &control);
+
+    if (next == current)
+        return 0;
+
+    VIR_INFO("Changing memory bandwidth of allocation %s of domain %s on node %u from %u%% to %u%%, measured %llu bytes/s",
+             virResctrlAllocGetID(data->alloc), data->vm->def->name,
+             id, current, next, data->rates[id]);
+
+    if (virResctrlAllocSetMemoryBandwidthLive(data->alloc, id, next) < 0) {
+        VIR_WARN("Unable to change memory bandwidth of domain %s: %s",
+                 data->vm->def->name, virGetLastErrorMessage());
+        virResetLastError();
+    }
+
+    return 0;
+}
+
+
+/**
+ * qemuResctrlControlMemoryBandwidth:
+ * @vm: domain object
+ * @caps: host capabilities
+ * @limit: memory bandwidth limit in bytes per second
+ *
+ * Adjust the memory bandwidth allocations of @vm so that the total memory
+ * bandwidth measured by the memory bandwidth monitors of each allocation
+ * stays below @limit on every node.
+ */
+static void
+qemuResctrlControlMemoryBandwidth(virDomainObj *vm,
+                                  virCaps *caps,
+                                  unsigned long long limit)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+    size_t l;
+
+    for (i = 0; i < vm->def->nresctrls; i++) {
+        virDomainResctrlDef *resctrl = vm->def->resctrls[i];
+        struct qemuResctrlControlData data = {
+            .vm = vm, .caps = caps, .alloc = resctrl->alloc, .limit = limit,
+        };
+
+        if (!resctrl->alloc)
+            continue;
+
+        data.measured = virBitmapNew(0);
+
+        for (j = 0; j < resctrl->nmonitors; j++) {
+            virDomainResctrlMonDef *domresmon = resctrl->monitors[j];
+            virResctrlMonitorStats **stats = NULL;
+            size_t nstats = 0;
+
+            if (domresmon->tag != VIR_RESCTRL_MONITOR_TYPE_MEMBW)
+                continue;
+
+            /* The monitors were sampled just now */
+            if (virResctrlMonitorGetSampledStats(domresmon->instance, ULLONG_MAX,
+                                                 &stats, &nstats) <= 0)
+                continue;
+
+            for (k = 0; k < nstats; k++) {
+                if (!stats[k]->rates)
+                    continue;
+
+                for (l = 0; l < stats[k]->nvals; l++) {
+                    if (STRNEQ(stats[k]->features[l], "mbm_total_bytes"))
+                        continue;
+
+                    if (stats[k]->id >= data.nrates)
+                        VIR_EXPAND_N(data.rates, data.nrates,
+                                     stats[k]->id + 1 - data.nrates);
+
+                    data.rates[stats[k]->id] += stats[k]->rates[l];
+                    virBitmapSetBitExpand(data.measured, stats[k]->id);
+                }
+            }
+
+            for (k = 0; k < nstats; k++)
+                virResctrlMonitorStatsFree(stats[k]);
+            g_free(stats);
+        }
+
+        ignore_value(virResctrlAllocForeachMemory(resctrl->alloc,
+                                                  qemuResctrlControlNode,
+                                                  &data));
+
+        g_free(data.rates);
+        virBitmapFree(data.measured);
+    }
+}
+
+
+/**
+ * qemuResctrlSampleDomain:
+ * @driver: QEMU driver
+ * @vm: domain object, locked
+ *
+ * Sample all resctrl monitors of @vm so that domain statistics can report
+ * the sampled values and rates without reading resctrl on every call, and
+ * adjust its memory bandwidth allocations if memory_bandwidth_limit is set.
+ */
+void
+qemuResctrlSampleDomain(virQEMUDriver *driver,
+                        virDomainObj *vm)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    g_autoptr(virCaps) caps = NULL;
+    virDomainJob job = VIR_JOB_QUERY;
+    size_t i;
+    size_t j;
+
+    /* Adjusting the allocations rewrites the schemata, which must not be
+     * seen half done by queries running at the same time. */
+    if (cfg->memoryBandwidthLimit > 0)
+        job = VIR_JOB_MODIFY;
+
+    /* Don't wait for other jobs, the domain is sampled again later */
+    if (virDomainObjBeginJobNowait(vm, job) < 0) {
+        virResetLastError();
+        return;
+    }
+
+    if (!virDomainObjIsActive(vm))
+        goto endjob;
+
+    if (!(caps = virQEMUDriverGetCapabilities(driver, false)))
+        goto endjob;
+
+    for (i = 0; i < vm->def->nresctrls; i++) {
+        virDomainResctrlDef *resctrl = vm->def->resctrls[i];
+
+        for (j = 0; j < resctrl->nmonitors; j++) {
+            virDomainResctrlMonDef *domresmon = resctrl->monitors[j];
+            char **features = qemuResctrlGetMonitorFeatures(caps, domresmon->tag);
+
+            if (!features || !*features)
+                continue;
+
+            if (virResctrlMonitorSample(domresmon->instance,
+                                        (const char **) features) < 0) {
+                VIR_DEBUG("Unable to sample resctrl monitor of domain %s: %s",
+                          vm->def->name, virGetLastErrorMessage());
+                virResetLastError();
+            }
+        }
+    }
+
+    if (cfg->memoryBandwidthLimit > 0)
+        qemuResctrlControlMemoryBandwidth(vm, caps,
+                                          cfg->memoryBandwidthLimit * 1024ULL * 1024ULL);
+
+ endjob:
+    virResetLastError();
+    virDomainObjEndJob(vm);
+}
+
+
+static int
+qemuResctrlSampleCheckDomain(virDomainObj *vm,
+                             void *opaque G_GNUC_UNUSED)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(vm);
+    size_t i;
+
+    if (!virDomainObjIsActive(vm))
+        return 0;
+
+    for (i = 0; i < vm->def->nresctrls; i++) {
+        if (vm->def->resctrls[i]->nmonitors > 0) {
+            qemuProcessEventSubmit(vm, QEMU_PROCESS_EVENT_RESCTRL_SAMPLE,
+                                   0, 0, NULL);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+static void
+qemuResctrlSampleTimer(int timer G_GNUC_UNUSED,
+                       void *opaque)
+{
+    virQEMUDriver *driver = opaque;
+
+    virDomainObjListForEach(driver->domains, false,
+                            qemuResctrlSampleCheckDomain, NULL);
+}
+
+
+/**
+ * qemuResctrlSampleInit:
+ * @driver: QEMU driver
+ *
+ * Start periodic sampling of resctrl monitors if resctrl_sample_interval
+ * is set.
+ *
+ * Returns: 0 on success,
+ *         -1 on error.
+ */
+int
+qemuResctrlSampleInit(virQEMUDriver *driver)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+
+    if (cfg->resctrlSampleInterval == 0)
+        return 0;
+
+    if (!driver->privileged) {
+        VIR_DEBUG("resctrl sampling is not available");
+        return 0;
+    }
+
+    if ((driver->resctrlSampleTimer = virEventAddTimeout(cfg->resctrlSampleInterval * 1000,
+                                                         qemuResctrlSampleTimer,
+                                                         driver, NULL)) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("could not initialize resctrl sampling timer"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+void
+qemuResctrlSampleCleanup(virQEMUDriver *driver)
+{
+    if (driver->resctrlSampleTimer < 0)
+        return;
+
+    virEventRemoveTimeout(driver->resctrlSampleTimer);
+    driver->resctrlSampleTimer = -1;
+}
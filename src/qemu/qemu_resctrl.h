@@ -0,0 +1,31 @@
+/*
+ * qemu_resctrl.h: QEMU resctrl monitor sampling and MBA feedback control
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "qemu_conf.h"
+
+int
+qemuResctrlSampleInit(virQEMUDriver *driver);
+
+void
+qemuResctrlSampleCleanup(virQEMUDriver *driver);
+
+void
+qemuResctrlSampleDomain(virQEMUDriver *driver,
+                        virDomainObj *vm);
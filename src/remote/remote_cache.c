@@ -0,0 +1,199 @@
+/*
+ * remote_cache.c: cache of replies about the host in the remote driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "remote_cache.h"
+#include "virlog.h"
+
+#define VIR_FROM_THIS VIR_FROM_REMOTE
+
+VIR_LOG_INIT("remote.remote_cache");
+
+/*
+ * With the 'cache_ttl' URI parameter, replies about the host which
+ * hardly ever change (capabilities, hostname, ...) are kept for that
+ * long and reused instead of asking the server again. Bumping the
+ * generation invalidates everything cached so far. This is done
+ * without any lock, so that it can be done from event handlers.
+ */
+struct _remoteCache {
+    GHashTable *entries;
+    unsigned long long ttl; /* in ms */
+    int generation;
+};
+
+typedef struct _remoteCacheEntry remoteCacheEntry;
+struct _remoteCacheEntry {
+    GBytes *data;
+    unsigned long long expires; /* monotonic time in ms */
+    int generation;
+};
+
+
+static void
+remoteCacheEntryFree(remoteCacheEntry *entry)
+{
+    g_bytes_unref(entry->data);
+    g_free(entry);
+}
+
+
+/**
+ * remoteCacheNew:
+ * @ttl: how long to keep the data, in milliseconds
+ *
+ * Returns a new empty cache.
+ */
+remoteCache *
+remoteCacheNew(unsigned long long ttl)
+{
+    remoteCache *cache = g_new0(remoteCache, 1);
+
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                           (GDestroyNotify) remoteCacheEntryFree);
+    cache->ttl = ttl;
+
+    return cache;
+}
+
+
+void
+remoteCacheFree(remoteCache *cache)
+{
+    if (!cache)
+        return;
+
+    g_hash_table_unref(cache->entries);
+    g_free(cache);
+}
+
+
+/**
+ * remoteCacheLookup:
+ * @cache: the cache, may be NULL
+ * @key: what to look up
+ * @generation: filled with the generation to pass to remoteCacheStore()
+ *
+ * The caller must make sure that lookups and stores don't run
+ * concurrently.
+ *
+ * Returns the data cached for @key, or NULL if there is none.
+ */
+GBytes *
+remoteCacheLookup(remoteCache *cache,
+                  const char *key,
+                  int *generation)
+{
+    remoteCacheEntry *entry;
+
+    if (!cache) {
+        *generation = 0;
+        return NULL;
+    }
+
+    *generation = g_atomic_int_get(&cache->generation);
+
+    if (!(entry = g_hash_table_lookup(cache->entries, key)))
+        return NULL;
+
+    if (entry->generation != *generation ||
+        (unsigned long long) g_get_monotonic_time() / 1000 >= entry->expires) {
+        VIR_DEBUG("Dropping stale cached '%s'", key);
+        g_hash_table_remove(cache->entries, key);
+        return NULL;
+    }
+
+    VIR_DEBUG("Using cached '%s'", key);
+    return g_bytes_ref(entry->data);
+}
+
+
+/**
+ * remoteCacheStore:
+ * @cache: the cache, may be NULL
+ * @key: what to store
+ * @generation: as filled by remoteCacheLookup() before asking the server
+ * @data: the data to cache
+ * @len: length of @data
+ *
+ * Caches a copy of @data for @key unless the cache was invalidated since
+ * @generation was obtained.
+ */
+void
+remoteCacheStore(remoteCache *cache,
+                 const char *key,
+                 int generation,
+                 const void *data,
+                 size_t len)
+{
+    remoteCacheEntry *entry;
+
+    if (!cache ||
+        generation != g_atomic_int_get(&cache->generation))
+        return;
+
+    entry = g_new0(remoteCacheEntry, 1);
+    entry->data = g_bytes_new(data, len);
+    entry->expires = (unsigned long long) g_get_monotonic_time() / 1000 + cache->ttl;
+    entry->generation = generation;
+
+    g_hash_table_insert(cache->entries, g_strdup(key), entry);
+}
+
+
+char *
+remoteCacheLookupString(remoteCache *cache,
+                        const char *key,
+                        int *generation)
+{
+    g_autoptr(GBytes) data = NULL;
+
+    if (!(data = remoteCacheLookup(cache, key, generation)))
+        return NULL;
+
+    return g_strdup(g_bytes_get_data(data, NULL));
+}
+
+
+void
+remoteCacheStoreString(remoteCache *cache,
+                       const char *key,
+                       int generation,
+                       const char *str)
+{
+    remoteCacheStore(cache, key, generation, str, strlen(str) + 1);
+}
+
+
+/**
+ * remoteCacheInvalidate:
+ * @cache: the cache, may be NULL
+ *
+ * Marks everything cached so far as stale, including data which is
+ * being fetched from the server right now. Safe to call concurrently
+ * with lookups and stores.
+ */
+void
+remoteCacheInvalidate(remoteCache *cache)
+{
+    if (!cache)
+        return;
+
+    g_atomic_int_inc(&cache->generation);
+}
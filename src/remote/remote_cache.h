@@ -0,0 +1,46 @@
+/*
+ * remote_cache.h: cache of replies about the host in the remote driver
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+
+typedef struct _remoteCache remoteCache;
+
+remoteCache *remoteCacheNew(unsigned long long ttl);
+void remoteCacheFree(remoteCache *cache);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(remoteCache, remoteCacheFree);
+
+GBytes *remoteCacheLookup(remoteCache *cache,
+                          const char *key,
+                          int *generation);
+void remoteCacheStore(remoteCache *cache,
+                      const char *key,
+                      int generation,
+                      const void *data,
+                      size_t len);
+
+char *remoteCacheLookupString(remoteCache *cache,
+                              const char *key,
+                              int *generation);
+void remoteCacheStoreString(remoteCache *cache,
+                            const char *key,
+                            int generation,
+                            const char *str);
+
+void remoteCacheInvalidate(remoteCache *cache);
@@ -37,6 +37,7 @@
 #include "driver.h"
 #include "remote_driver.h"
 #include "remote_protocol.h"
+#include "remote_cache.h"
 #include "remote_sockets.h"
 #include "lxc_protocol.h"
 #include "qemu_protocol.h"
@@ -95,6 +96,8 @@ struct private_data {
     bool serverEventFilter;     /* Does server support modern event filtering */
     bool serverCloseCallback;   /* Does server support driver close callback */
 
+    remoteCache *cache;         /* Replies about the host, if cache_ttl is set */
+
     virObjectEventState *eventState;
     virConnectCloseCallbackData *closeCallback;
 };
@@ -123,6 +126,7 @@ static void remoteDriverUnlock(struct private_data *driver)
     virMutexUnlock(&driver->lock);
 }
 
+
 static int call(virConnectPtr conn, struct private_data *priv,
                 unsigned int flags, int proc_nr,
                 xdrproc_t args_filter, char *args,
@@ -134,6 +138,15 @@ static int callFull(virConnectPtr conn, struct private_data *priv,
                     int proc_nr,
                     xdrproc_t args_filter, char *args,
                     xdrproc_t ret_filter, char *ret);
+
+typedef struct _remotePendingCall remotePendingCall;
+static remotePendingCall *callPipelined(virConnectPtr conn,
+                                        struct private_data *priv,
+                                        unsigned int flags, int proc_nr,
+                                        xdrproc_t args_filter, char *args);
+static int callFinish(virConnectPtr conn, struct private_data *priv,
+                      remotePendingCall *pending,
+                      xdrproc_t ret_filter, char *ret);
 static int remoteAuthenticate(virConnectPtr conn, struct private_data *priv,
                               virConnectAuthPtr auth, const char *authtype);
 #if WITH_SASL
@@ -757,6 +770,40 @@ remoteConnectFormatURI(virURI *uri,
     }
 
 
+/*
+ * The cache is invalidated by node device lifecycle events, which the
+ * server sends only when asked to. Ask for them regardless of whether
+ * the application registers a callback on its own, it just won't find
+ * a callback for the events of this registration. Events are read
+ * along with replies to other calls, or by the event loop if the
+ * application runs one. Failing to register leaves the cache to
+ * expire by cache_ttl only.
+ */
+static void
+remoteCacheRegisterEvents(virConnectPtr conn,
+                          struct private_data *priv)
+{
+    remote_connect_node_device_event_register_any_args args = {
+        .eventID = VIR_NODE_DEVICE_EVENT_ID_LIFECYCLE,
+        .dev = NULL,
+    };
+    g_auto(remote_connect_node_device_event_register_any_ret) ret = { 0 };
+
+    if (!priv->serverEventFilter) {
+        VIR_DEBUG("Cached data expires by cache_ttl only");
+        return;
+    }
+
+    if (call(conn, priv, 0, REMOTE_PROC_CONNECT_NODE_DEVICE_EVENT_REGISTER_ANY,
+             (xdrproc_t) xdr_remote_connect_node_device_event_register_any_args, (char *) &args,
+             (xdrproc_t) xdr_remote_connect_node_device_event_register_any_ret, (char *) &ret) == -1) {
+        VIR_DEBUG("Cached data expires by cache_ttl only: %s",
+                  virGetLastErrorMessage());
+        virResetLastError();
+    }
+}
+
+
 /*
  * URIs that this driver needs to handle:
  *
@@ -803,6 +850,7 @@ doRemoteOpen(virConnectPtr conn,
     g_autofree char *daemon_path = NULL;
     g_autofree char *proxy_str = NULL;
     g_autofree char *virtSshURI = NULL;
+    g_autofree char *cache_ttl_str = NULL;
     bool sanity = true;
     bool verify = true;
 #ifndef WIN32
@@ -850,6 +898,7 @@ doRemoteOpen(virConnectPtr conn,
             EXTRACT_URI_ARG_STR("tls_priority", tls_priority);
             EXTRACT_URI_ARG_STR("mode", mode_str);
             EXTRACT_URI_ARG_STR("proxy", proxy_str);
+            EXTRACT_URI_ARG_STR("cache_ttl", cache_ttl_str);
             EXTRACT_URI_ARG_BOOL("no_sanity", sanity);
             EXTRACT_URI_ARG_BOOL("no_verify", verify);
 #ifndef WIN32
@@ -886,6 +935,20 @@ doRemoteOpen(virConnectPtr conn,
         name = g_strdup("");
     }
 
+    if (cache_ttl_str) {
+        unsigned int cache_ttl;
+
+        if (virStrToLong_uip(cache_ttl_str, NULL, 10, &cache_ttl) < 0) {
+            virReportError(VIR_ERR_INVALID_ARG,
+                           _("Failed to parse value of URI component %1$s"),
+                           "cache_ttl");
+            goto error;
+        }
+
+        if (cache_ttl > 0)
+            priv->cache = remoteCacheNew(cache_ttl * 1000ULL);
+    }
+
     if (conf && !mode_str &&
         virConfGetValueString(conf, "remote_mode", &mode_str) < 0)
         goto error;
@@ -1190,42 +1253,83 @@ doRemoteOpen(virConnectPtr conn,
             goto error;
     }
 
-    /* Now try and find out what URI the daemon used */
-    if (conn->uri == NULL) {
-        remote_connect_get_uri_ret uriret = { 0 };
-
-        VIR_DEBUG("Trying to query remote URI");
-        if (call(conn, priv, 0,
-                 REMOTE_PROC_CONNECT_GET_URI,
-                 (xdrproc_t) xdr_void, (char *) NULL,
-                 (xdrproc_t) xdr_remote_connect_get_uri_ret, (char *) &uriret) < 0)
-            goto error;
-
-        VIR_DEBUG("Auto-probed URI is %s", uriret.uri);
-        conn->uri = virURIParse(uriret.uri);
-        VIR_FREE(uriret.uri);
-        if (!conn->uri)
-            goto error;
-    }
-
     /* Set up events */
     if (!(priv->eventState = virObjectEventStateNew()))
         goto error;
 
-    priv->serverEventFilter = remoteConnectSupportsFeatureUnlocked(conn,
-                                priv, VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK);
-    if (!priv->serverEventFilter) {
-        VIR_INFO("Avoiding server event filtering since it is not "
-                 "supported by the server");
-    }
+    /* The remaining queries don't depend on each other, so they are
+     * pipelined to spare round trips on slow links */
+    {
+        remote_connect_supports_feature_args eventFilterArgs = {
+            VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK
+        };
+        remote_connect_supports_feature_args closeCallbackArgs = {
+            VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK
+        };
+        g_auto(remote_connect_supports_feature_ret) eventFilterRet = { 0 };
+        g_auto(remote_connect_supports_feature_ret) closeCallbackRet = { 0 };
+        g_auto(remote_connect_get_uri_ret) uriret = { 0 };
+        remotePendingCall *uriCall = NULL;
+        remotePendingCall *eventFilterCall;
+        remotePendingCall *closeCallbackCall;
+        int rc = 0;
+
+        /* Now try and find out what URI the daemon used */
+        if (conn->uri == NULL) {
+            VIR_DEBUG("Trying to query remote URI");
+            if (!(uriCall = callPipelined(conn, priv, 0,
+                                          REMOTE_PROC_CONNECT_GET_URI,
+                                          (xdrproc_t) xdr_void, (char *) NULL)))
+                goto error;
+        }
+
+        eventFilterCall = callPipelined(conn, priv, 0,
+                                        REMOTE_PROC_CONNECT_SUPPORTS_FEATURE,
+                                        (xdrproc_t) xdr_remote_connect_supports_feature_args,
+                                        (char *) &eventFilterArgs);
+        closeCallbackCall = callPipelined(conn, priv, 0,
+                                          REMOTE_PROC_CONNECT_SUPPORTS_FEATURE,
+                                          (xdrproc_t) xdr_remote_connect_supports_feature_args,
+                                          (char *) &closeCallbackArgs);
+
+        if (uriCall)
+            rc = callFinish(conn, priv, uriCall,
+                            (xdrproc_t) xdr_remote_connect_get_uri_ret,
+                            (char *) &uriret);
+
+        priv->serverEventFilter = eventFilterCall &&
+            callFinish(conn, priv, eventFilterCall,
+                       (xdrproc_t) xdr_remote_connect_supports_feature_ret,
+                       (char *) &eventFilterRet) != -1 &&
+            eventFilterRet.supported;
+        if (!priv->serverEventFilter) {
+            VIR_INFO("Avoiding server event filtering since it is not "
+                     "supported by the server");
+        }
+
+        priv->serverCloseCallback = closeCallbackCall &&
+            callFinish(conn, priv, closeCallbackCall,
+                       (xdrproc_t) xdr_remote_connect_supports_feature_ret,
+                       (char *) &closeCallbackRet) != -1 &&
+            closeCallbackRet.supported;
+        if (!priv->serverCloseCallback) {
+            VIR_INFO("Close callback registering isn't supported "
+                     "by the remote side.");
+        }
 
-    priv->serverCloseCallback = remoteConnectSupportsFeatureUnlocked(conn,
-                                    priv, VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK);
-    if (!priv->serverCloseCallback) {
-        VIR_INFO("Close callback registering isn't supported "
-                 "by the remote side.");
+        if (rc < 0)
+            goto error;
+
+        if (uriCall) {
+            VIR_DEBUG("Auto-probed URI is %s", uriret.uri);
+            if (!(conn->uri = virURIParse(uriret.uri)))
+                goto error;
+        }
     }
 
+    if (priv->cache)
+        remoteCacheRegisterEvents(conn, priv);
+
     return VIR_DRV_OPEN_SUCCESS;
 
  error:
@@ -1236,6 +1340,8 @@ doRemoteOpen(virConnectPtr conn,
     g_clear_pointer(&priv->client, virObjectUnref);
     g_clear_pointer(&priv->closeCallback, virObjectUnref);
     g_clear_pointer(&priv->tls, virObjectUnref);
+    g_clear_pointer(&priv->cache, remoteCacheFree);
+    g_clear_pointer(&priv->eventState, virObjectUnref);
 
     VIR_FREE(priv->hostname);
     return VIR_DRV_OPEN_ERROR;
@@ -1354,6 +1460,7 @@ doRemoteClose(virConnectPtr conn, struct private_data *priv)
 
     /* See comment for remoteType. */
     VIR_FREE(priv->type);
+    g_clear_pointer(&priv->cache, remoteCacheFree);
 
     g_clear_pointer(&priv->eventState, virObjectUnref);
 
@@ -1411,6 +1518,123 @@ remoteConnectGetType(virConnectPtr conn)
     return priv->type = g_steal_pointer(&ret.type);
 }
 
+static char *
+remoteConnectGetHostname(virConnectPtr conn)
+{
+    g_auto(remote_connect_get_hostname_ret) ret = {0};
+    struct private_data *priv = conn->privateData;
+    VIR_LOCK_GUARD lock = remoteDriverLock(priv);
+    char *hostname;
+    int generation;
+
+    if ((hostname = remoteCacheLookupString(priv->cache, "hostname", &generation)))
+        return hostname;
+
+    if (call(conn, priv, 0, REMOTE_PROC_CONNECT_GET_HOSTNAME,
+             (xdrproc_t) xdr_void, (char *) NULL,
+             (xdrproc_t) xdr_remote_connect_get_hostname_ret, (char *) &ret) == -1)
+        return NULL;
+
+    remoteCacheStoreString(priv->cache, "hostname", generation, ret.hostname);
+
+    return g_steal_pointer(&ret.hostname);
+}
+
+static int
+remoteNodeGetInfo(virConnectPtr conn,
+                  virNodeInfoPtr info)
+{
+    g_auto(remote_node_get_info_ret) ret = {0};
+    struct private_data *priv = conn->privateData;
+    VIR_LOCK_GUARD lock = remoteDriverLock(priv);
+    g_autoptr(GBytes) cached = NULL;
+    int generation;
+
+    if ((cached = remoteCacheLookup(priv->cache, "nodeinfo", &generation))) {
+        memcpy(info, g_bytes_get_data(cached, NULL), sizeof(*info));
+        return 0;
+    }
+
+    if (call(conn, priv, 0, REMOTE_PROC_NODE_GET_INFO,
+             (xdrproc_t) xdr_void, (char *) NULL,
+             (xdrproc_t) xdr_remote_node_get_info_ret, (char *) &ret) == -1)
+        return -1;
+
+    memcpy(info->model, ret.model, sizeof(info->model));
+    info->memory = ret.memory;
+    info->cpus = ret.cpus;
+    info->mhz = ret.mhz;
+    info->nodes = ret.nodes;
+    info->sockets = ret.sockets;
+    info->cores = ret.cores;
+    info->threads = ret.threads;
+
+    remoteCacheStore(priv->cache, "nodeinfo", generation, info, sizeof(*info));
+
+    return 0;
+}
+
+static char *
+remoteConnectGetCapabilities(virConnectPtr conn)
+{
+    g_auto(remote_connect_get_capabilities_ret) ret = {0};
+    struct private_data *priv = conn->privateData;
+    VIR_LOCK_GUARD lock = remoteDriverLock(priv);
+    char *capabilities;
+    int generation;
+
+    if ((capabilities = remoteCacheLookupString(priv->cache, "capabilities", &generation)))
+        return capabilities;
+
+    if (call(conn, priv, 0, REMOTE_PROC_CONNECT_GET_CAPABILITIES,
+             (xdrproc_t) xdr_void, (char *) NULL,
+             (xdrproc_t) xdr_remote_connect_get_capabilities_ret, (char *) &ret) == -1)
+        return NULL;
+
+    remoteCacheStoreString(priv->cache, "capabilities", generation, ret.capabilities);
+
+    return g_steal_pointer(&ret.capabilities);
+}
+
+static char *
+remoteConnectGetDomainCapabilities(virConnectPtr conn,
+                                   const char *emulatorbin,
+                                   const char *arch,
+                                   const char *machine,
+                                   const char *virttype,
+                                   unsigned int flags)
+{
+    remote_connect_get_domain_capabilities_args args = {0};
+    g_auto(remote_connect_get_domain_capabilities_ret) ret = {0};
+    struct private_data *priv = conn->privateData;
+    VIR_LOCK_GUARD lock = remoteDriverLock(priv);
+    g_autofree char *key = NULL;
+    char *capabilities;
+    int generation;
+
+    key = g_strdup_printf("domcaps:%s:%s:%s:%s:%x",
+                          NULLSTR(emulatorbin), NULLSTR(arch),
+                          NULLSTR(machine), NULLSTR(virttype), flags);
+
+    if ((capabilities = remoteCacheLookupString(priv->cache, key, &generation)))
+        return capabilities;
+
+    args.emulatorbin = emulatorbin ? (char **)&emulatorbin : NULL;
+    args.arch = arch ? (char **)&arch : NULL;
+    args.machine = machine ? (char **)&machine : NULL;
+    args.virttype = virttype ? (char **)&virttype : NULL;
+    args.flags = flags;
+
+    if (call(conn, priv, 0, REMOTE_PROC_CONNECT_GET_DOMAIN_CAPABILITIES,
+             (xdrproc_t) xdr_remote_connect_get_domain_capabilities_args, (char *) &args,
+             (xdrproc_t) xdr_remote_connect_get_domain_capabilities_ret, (char *) &ret) == -1)
+        return NULL;
+
+    remoteCacheStoreString(priv->cache, key, generation, ret.capabilities);
+
+    return g_steal_pointer(&ret.capabilities);
+}
+
 static int remoteConnectIsSecure(virConnectPtr conn)
 {
     struct private_data *priv = conn->privateData;
@@ -4876,6 +5100,11 @@ remoteNodeDeviceBuildEventLifecycle(virNetClientProgram *prog G_GNUC_UNUSED,
     virNodeDevicePtr dev;
     virObjectEvent *event = NULL;
 
+    /* Devices appearing or going away may change the capabilities
+     * of the host. The private data is not locked here, so the cache
+     * is only marked as stale. */
+    remoteCacheInvalidate(priv->cache);
+
     dev = get_nonnull_node_device(conn, msg->dev);
     if (!dev)
         return;
@@ -6021,6 +6250,17 @@ remoteDomainGetDiskErrors(virDomainPtr dom,
  * Serial a set of arguments into a method call message,
  * send that to the server and wait for reply
  */
+static virNetClientProgram *
+callProgram(struct private_data *priv,
+            unsigned int flags)
+{
+    if (flags & REMOTE_CALL_QEMU)
+        return priv->qemuProgram;
+    if (flags & REMOTE_CALL_LXC)
+        return priv->lxcProgram;
+    return priv->remoteProgram;
+}
+
 static int
 callFull(virConnectPtr conn G_GNUC_UNUSED,
          struct private_data *priv,
@@ -6034,18 +6274,11 @@ callFull(virConnectPtr conn G_GNUC_UNUSED,
          xdrproc_t ret_filter, char *ret)
 {
     int rv;
-    virNetClientProgram *prog;
+    virNetClientProgram *prog = callProgram(priv, flags);
     int counter = priv->counter++;
     virNetClient *client = priv->client;
     priv->localUses++;
 
-    if (flags & REMOTE_CALL_QEMU)
-        prog = priv->qemuProgram;
-    else if (flags & REMOTE_CALL_LXC)
-        prog = priv->lxcProgram;
-    else
-        prog = priv->remoteProgram;
-
     /* Unlock, so that if we get any async events/stream data
      * while processing the RPC, we don't deadlock when our
      * callbacks for those are invoked
@@ -6082,6 +6315,77 @@ call(virConnectPtr conn,
 }
 
 
+/*
+ * Calls made by callPipelined() are sent right away, but their replies
+ * are only waited for by callFinish(). Making several calls before
+ * finishing any of them has all of them in flight at once, which
+ * costs a single round trip instead of one per call.
+ */
+struct _remotePendingCall {
+    virNetClientProgram *prog;
+    virNetClientCall *call;
+    int serial;
+    int proc_nr;
+};
+
+static remotePendingCall *
+callPipelined(virConnectPtr conn G_GNUC_UNUSED,
+              struct private_data *priv,
+              unsigned int flags,
+              int proc_nr,
+              xdrproc_t args_filter, char *args)
+{
+    remotePendingCall *pending = g_new0(remotePendingCall, 1);
+    virNetClient *client = priv->client;
+
+    pending->prog = callProgram(priv, flags);
+    pending->serial = priv->counter++;
+    pending->proc_nr = proc_nr;
+
+    /* See callFull() */
+    priv->localUses++;
+    remoteDriverUnlock(priv);
+    pending->call = virNetClientProgramCallPipelined(pending->prog,
+                                                     client,
+                                                     pending->serial,
+                                                     proc_nr,
+                                                     args_filter, args);
+    remoteDriverLock(priv);
+    priv->localUses--;
+
+    if (!pending->call) {
+        g_free(pending);
+        return NULL;
+    }
+
+    return pending;
+}
+
+static int
+callFinish(virConnectPtr conn G_GNUC_UNUSED,
+           struct private_data *priv,
+           remotePendingCall *pending,
+           xdrproc_t ret_filter, char *ret)
+{
+    virNetClient *client = priv->client;
+    int rv;
+
+    priv->localUses++;
+    remoteDriverUnlock(priv);
+    rv = virNetClientProgramCallFinish(pending->prog,
+                                       client,
+                                       pending->call,
+                                       pending->serial,
+                                       pending->proc_nr,
+                                       ret_filter, ret);
+    remoteDriverLock(priv);
+    priv->localUses--;
+
+    g_free(pending);
+    return rv;
+}
+
+
 static int
 remoteDomainGetInterfaceParameters(virDomainPtr domain,
                                    const char *device,
@@ -4065,14 +4065,14 @@ enum remote_procedure {
     REMOTE_PROC_CONNECT_GET_MAX_VCPUS = 5,
 
     /**
-     * @generate: both
+     * @generate: server
      * @priority: high
      * @acl: connect:read
      */
     REMOTE_PROC_NODE_GET_INFO = 6,
 
     /**
-     * @generate: both
+     * @generate: server
      * @acl: connect:read
      */
     REMOTE_PROC_CONNECT_GET_CAPABILITIES = 7,
@@ -4430,7 +4430,7 @@ enum remote_procedure {
     REMOTE_PROC_DOMAIN_SET_SCHEDULER_PARAMETERS = 58,
 
     /**
-     * @generate: both
+     * @generate: server
      * @priority: high
      * @acl: connect:getattr
      */
@@ -6341,7 +6341,7 @@ enum remote_procedure {
     REMOTE_PROC_NETWORK_GET_DHCP_LEASES = 341,
 
     /**
-     * @generate: both
+     * @generate: server
      * @acl: connect:write
      */
     REMOTE_PROC_CONNECT_GET_DOMAIN_CAPABILITIES = 342,
@@ -40,8 +40,6 @@
 
 VIR_LOG_INIT("rpc.netclient");
 
-typedef struct _virNetClientCall virNetClientCall;
-
 enum {
     VIR_NET_CLIENT_MODE_WAIT_TX,
     VIR_NET_CLIENT_MODE_WAIT_RX,
@@ -59,6 +57,11 @@ struct _virNetClientCall {
     bool expectReply;
     bool nonBlock;
     bool haveThread;
+    /* The reply is collected by virNetClientCallWait() rather than
+     * by the thread which sent the call */
+    bool pipelined;
+    /* Nobody is going to collect the reply of the pipelined call */
+    bool cancelled;
 
     virCond cond;
 
@@ -125,6 +128,8 @@ static int virNetClientOnceInit(void)
 
 VIR_ONCE_GLOBAL_INIT(virNetClient);
 
+static int virNetClientIOWait(virNetClient *client,
+                              virNetClientCall *thiscall);
 static void virNetClientIOEventLoopPassTheBuck(virNetClient *client,
                                                virNetClientCall *thiscall);
 static int virNetClientQueueNonBlocking(virNetClient *client,
@@ -238,6 +243,21 @@ static bool virNetClientCallMatchPredicate(virNetClientCall *head,
 }
 
 
+static bool virNetClientCallIsSame(virNetClientCall *call,
+                                   void *opaque)
+{
+    return call == opaque;
+}
+
+
+static void virNetClientCallFree(virNetClientCall *call)
+{
+    virCondDestroy(&call->cond);
+    virNetMessageFree(call->msg);
+    g_free(call);
+}
+
+
 bool
 virNetClientKeepAliveIsSupported(virNetClient *client)
 {
@@ -1552,13 +1572,13 @@ static bool virNetClientIOEventLoopRemoveDone(virNetClientCall *call,
     if (call->haveThread) {
         VIR_DEBUG("Waking up sleep %p", call);
         virCondSignal(&call->cond);
+    } else if (call->pipelined && !call->cancelled) {
+        VIR_DEBUG("Keeping reply of pipelined call %p", call);
     } else {
         VIR_DEBUG("Removing completed call %p", call);
-        if (call->expectReply)
+        if (call->expectReply && !call->pipelined)
             VIR_WARN("Got a call expecting a reply but without a waiting thread");
-        virCondDestroy(&call->cond);
-        virNetMessageFree(call->msg);
-        VIR_FREE(call);
+        virNetClientCallFree(call);
     }
 
     return true;
@@ -1582,10 +1602,14 @@ virNetClientIOEventLoopRemoveAll(virNetClientCall *call,
     if (call == thiscall)
         return false;
 
+    /* virNetClientCallWait() reports the failure of the call */
+    if (call->pipelined && !call->cancelled) {
+        VIR_DEBUG("Dropping pipelined call %p", call);
+        return true;
+    }
+
     VIR_DEBUG("Removing call %p", call);
-    virCondDestroy(&call->cond);
-    virNetMessageFree(call->msg);
-    VIR_FREE(call);
+    virNetClientCallFree(call);
     return true;
 }
 
@@ -1917,8 +1941,6 @@ static gboolean virNetClientIOWakeup(gpointer opaque)
 static int virNetClientIO(virNetClient *client,
                           virNetClientCall *thiscall)
 {
-    int rv = -1;
-
     VIR_DEBUG("Outgoing message prog=%u version=%u serial=%u proc=%d type=%d length=%zu dispatch=%p",
               thiscall->msg->header.prog,
               thiscall->msg->header.vers,
@@ -1931,6 +1953,19 @@ static int virNetClientIO(virNetClient *client,
     /* Stick ourselves on the end of the wait queue */
     virNetClientCallQueue(&client->waitDispatch, thiscall);
 
+    return virNetClientIOWait(client, thiscall);
+}
+
+
+/*
+ * Waits for @thiscall, which is already queued, as described for
+ * virNetClientIO().
+ */
+static int virNetClientIOWait(virNetClient *client,
+                              virNetClientCall *thiscall)
+{
+    int rv = -1;
+
     /* Check to see if another thread is dispatching */
     if (client->haveTheBuck) {
         /* Force other thread to wakeup from poll */
@@ -2223,6 +2258,142 @@ int virNetClientSendNonBlock(virNetClient *client,
     return ret;
 }
 
+/*
+ * @msg: a message allocated on the heap
+ * @call: filled with the pending call
+ *
+ * Send a message without waiting for the reply. The message is only
+ * sent right away as far as it can be without blocking, the rest is
+ * sent along with later calls or by the event loop. This allows
+ * several calls to be in flight at the same time even if they are
+ * all made by a single thread.
+ *
+ * On success, @msg is owned by @call, which must be passed to either
+ * virNetClientCallWait() or virNetClientCallCancel(). Otherwise the
+ * caller is still responsible for free'ing @msg.
+ *
+ * Returns 0 on success, -1 on failure
+ */
+int virNetClientSendWithReplyPipelined(virNetClient *client,
+                                       virNetMessage *msg,
+                                       virNetClientCall **call)
+{
+    virNetClientCall *thecall;
+    int rv;
+
+    virObjectLock(client);
+
+    PROBE(RPC_CLIENT_MSG_TX_QUEUE,
+          "client=%p len=%zu prog=%u vers=%u proc=%u type=%u status=%u serial=%u",
+          client, msg->bufferLength,
+          msg->header.prog, msg->header.vers, msg->header.proc,
+          msg->header.type, msg->header.status, msg->header.serial);
+
+    if (!client->sock || client->wantClose) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("client socket is closed"));
+        virObjectUnlock(client);
+        return -1;
+    }
+
+    if (!(thecall = virNetClientCallNew(msg, true, false))) {
+        virObjectUnlock(client);
+        return -1;
+    }
+
+    /* Sending the call as a non-blocking one makes virNetClientIO()
+     * return as soon as it can't make progress without waiting */
+    thecall->pipelined = true;
+    thecall->nonBlock = true;
+    thecall->haveThread = true;
+
+    rv = virNetClientIO(client, thecall);
+    thecall->nonBlock = false;
+    thecall->haveThread = false;
+
+    virObjectUnlock(client);
+
+    if (rv < 0) {
+        virCondDestroy(&thecall->cond);
+        g_free(thecall);
+        return -1;
+    }
+
+    *call = thecall;
+    return 0;
+}
+
+
+/*
+ * @call: a call made by virNetClientSendWithReplyPipelined()
+ *
+ * Wait for the reply to @call, which is freed.
+ *
+ * Returns the message with the reply, which the caller must free, or
+ * NULL on failure
+ */
+virNetMessage *virNetClientCallWait(virNetClient *client,
+                                    virNetClientCall *call)
+{
+    virNetMessage *msg;
+    int rv = 0;
+
+    virObjectLock(client);
+
+    if (call->mode == VIR_NET_CLIENT_MODE_COMPLETE) {
+        /* the reply was received in the meantime */
+        virNetClientCallRemove(&client->waitDispatch, call);
+    } else if (!virNetClientCallMatchPredicate(client->waitDispatch,
+                                               virNetClientCallIsSame,
+                                               call)) {
+        /* the call was dropped when the connection was closed */
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("client socket is closed"));
+        rv = -1;
+    } else {
+        call->haveThread = true;
+        rv = virNetClientIOWait(client, call);
+    }
+
+    virObjectUnlock(client);
+
+    msg = g_steal_pointer(&call->msg);
+    virNetClientCallFree(call);
+
+    if (rv < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
+
+/*
+ * @call: a call made by virNetClientSendWithReplyPipelined()
+ *
+ * Give up on @call. Its reply, if it's still to come, is discarded.
+ */
+void virNetClientCallCancel(virNetClient *client,
+                            virNetClientCall *call)
+{
+    VIR_WITH_OBJECT_LOCK_GUARD(client) {
+        if (call->mode != VIR_NET_CLIENT_MODE_COMPLETE &&
+            virNetClientCallMatchPredicate(client->waitDispatch,
+                                           virNetClientCallIsSame,
+                                           call)) {
+            VIR_DEBUG("Discarding reply of pipelined call %p", call);
+            call->cancelled = true;
+            return;
+        }
+
+        virNetClientCallRemove(&client->waitDispatch, call);
+    }
+
+    virNetClientCallFree(call);
+}
+
+
 /*
  * @msg: a message allocated on heap or stack
  *
@@ -132,6 +132,14 @@ int virNetClientSendWithReply(virNetClient *client,
 int virNetClientSendNonBlock(virNetClient *client,
                              virNetMessage *msg);
 
+int virNetClientSendWithReplyPipelined(virNetClient *client,
+                                       virNetMessage *msg,
+                                       virNetClientCall **call);
+virNetMessage *virNetClientCallWait(virNetClient *client,
+                                    virNetClientCall *call);
+void virNetClientCallCancel(virNetClient *client,
+                            virNetClientCall *call);
+
 int virNetClientSendStream(virNetClient *client,
                            virNetMessage *msg,
                            virNetClientStream *st);
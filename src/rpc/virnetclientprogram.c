@@ -258,27 +258,19 @@ int virNetClientProgramDispatch(virNetClientProgram *prog,
 }
 
 
-int virNetClientProgramCall(virNetClientProgram *prog,
-                            virNetClient *client,
-                            unsigned serial,
-                            int proc,
-                            size_t noutfds,
-                            int *outfds,
-                            size_t *ninfds,
-                            int **infds,
-                            xdrproc_t args_filter, void *args,
-                            xdrproc_t ret_filter, void *ret)
+static virNetMessage *
+virNetClientProgramNewCall(virNetClientProgram *prog,
+                           unsigned serial,
+                           int proc,
+                           size_t noutfds,
+                           int *outfds,
+                           xdrproc_t args_filter, void *args)
 {
     virNetMessage *msg;
     size_t i;
 
-    if (infds)
-        *infds = NULL;
-    if (ninfds)
-        *ninfds = 0;
-
     if (!(msg = virNetMessageNew(false)))
-        return -1;
+        return NULL;
 
     msg->header.prog = prog->program;
     msg->header.vers = prog->version;
@@ -315,8 +307,24 @@ int virNetClientProgramCall(virNetClientProgram *prog,
     if (virNetMessageEncodePayload(msg, args_filter, args) < 0)
         goto error;
 
-    if (virNetClientSendWithReply(client, msg) < 0)
-        goto error;
+    return msg;
+
+ error:
+    virNetMessageFree(msg);
+    return NULL;
+}
+
+
+static int
+virNetClientProgramHandleReply(virNetClientProgram *prog,
+                               virNetMessage *msg,
+                               unsigned serial,
+                               int proc,
+                               size_t *ninfds,
+                               int **infds,
+                               xdrproc_t ret_filter, void *ret)
+{
+    size_t i;
 
     /* None of these 3 should ever happen here, because
      * virNetClientSend should have validated the reply,
@@ -380,15 +388,122 @@ int virNetClientProgramCall(virNetClientProgram *prog,
         goto error;
     }
 
-    virNetMessageFree(msg);
-
     return 0;
 
  error:
-    virNetMessageFree(msg);
     if (infds && ninfds) {
         for (i = 0; i < *ninfds; i++)
             VIR_FORCE_CLOSE((*infds)[i]);
     }
     return -1;
 }
+
+
+int virNetClientProgramCall(virNetClientProgram *prog,
+                            virNetClient *client,
+                            unsigned serial,
+                            int proc,
+                            size_t noutfds,
+                            int *outfds,
+                            size_t *ninfds,
+                            int **infds,
+                            xdrproc_t args_filter, void *args,
+                            xdrproc_t ret_filter, void *ret)
+{
+    virNetMessage *msg;
+    int rv = -1;
+
+    if (infds)
+        *infds = NULL;
+    if (ninfds)
+        *ninfds = 0;
+
+    if (!(msg = virNetClientProgramNewCall(prog, serial, proc,
+                                           noutfds, outfds,
+                                           args_filter, args)))
+        return -1;
+
+    if (virNetClientSendWithReply(client, msg) < 0)
+        goto cleanup;
+
+    rv = virNetClientProgramHandleReply(prog, msg, serial, proc,
+                                        ninfds, infds, ret_filter, ret);
+
+ cleanup:
+    virNetMessageFree(msg);
+    return rv;
+}
+
+
+/**
+ * virNetClientProgramCallPipelined:
+ * @prog: the program
+ * @client: the client
+ * @serial: serial number of the call
+ * @proc: procedure to call
+ * @args_filter: XDR filter for @args
+ * @args: arguments of the call
+ *
+ * Like virNetClientProgramCall(), but doesn't wait for the reply. The
+ * returned call must be passed to virNetClientProgramCallFinish() or
+ * virNetClientCallCancel().
+ *
+ * Returns the pending call, or NULL on error.
+ */
+virNetClientCall *
+virNetClientProgramCallPipelined(virNetClientProgram *prog,
+                                 virNetClient *client,
+                                 unsigned serial,
+                                 int proc,
+                                 xdrproc_t args_filter, void *args)
+{
+    virNetMessage *msg;
+    virNetClientCall *call = NULL;
+
+    if (!(msg = virNetClientProgramNewCall(prog, serial, proc, 0, NULL,
+                                           args_filter, args)))
+        return NULL;
+
+    if (virNetClientSendWithReplyPipelined(client, msg, &call) < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return call;
+}
+
+
+/**
+ * virNetClientProgramCallFinish:
+ * @prog: the program
+ * @client: the client
+ * @call: call made by virNetClientProgramCallPipelined()
+ * @serial: serial number of @call
+ * @proc: procedure called by @call
+ * @ret_filter: XDR filter for @ret
+ * @ret: filled with the result of the call
+ *
+ * Waits for the reply to @call, which is consumed.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetClientProgramCallFinish(virNetClientProgram *prog,
+                              virNetClient *client,
+                              virNetClientCall *call,
+                              unsigned serial,
+                              int proc,
+                              xdrproc_t ret_filter, void *ret)
+{
+    virNetMessage *msg;
+    int rv;
+
+    if (!(msg = virNetClientCallWait(client, call)))
+        return -1;
+
+    rv = virNetClientProgramHandleReply(prog, msg, serial, proc,
+                                        NULL, NULL, ret_filter, ret);
+
+    virNetMessageFree(msg);
+    return rv;
+}
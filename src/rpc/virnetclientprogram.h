@@ -27,6 +27,8 @@
 
 typedef struct _virNetClient virNetClient;
 
+typedef struct _virNetClientCall virNetClientCall;
+
 typedef struct _virNetClientProgram virNetClientProgram;
 
 typedef struct _virNetClientProgramEvent virNetClientProgramEvent;
@@ -72,3 +74,16 @@ int virNetClientProgramCall(virNetClientProgram *prog,
                             int **infds,
                             xdrproc_t args_filter, void *args,
                             xdrproc_t ret_filter, void *ret);
+
+virNetClientCall *virNetClientProgramCallPipelined(virNetClientProgram *prog,
+                                                   virNetClient *client,
+                                                   unsigned serial,
+                                                   int proc,
+                                                   xdrproc_t args_filter, void *args);
+
+int virNetClientProgramCallFinish(virNetClientProgram *prog,
+                                  virNetClient *client,
+                                  virNetClientCall *call,
+                                  unsigned serial,
+                                  int proc,
+                                  xdrproc_t ret_filter, void *ret);
@@ -1688,21 +1688,6 @@ storageVolLookupByPath(virConnectPtr conn,
 }
 
 
-static bool
-storagePoolLookupByTargetPathCallback(virStoragePoolObj *obj,
-                                      const void *opaque)
-{
-    const char *path = opaque;
-    virStoragePoolDef *def;
-
-    if (!virStoragePoolObjIsActive(obj))
-        return false;
-
-    def = virStoragePoolObjGetDef(obj);
-    return STREQ_NULLABLE(path, def->target.path);
-}
-
-
 virStoragePoolPtr
 storagePoolLookupByTargetPath(virConnectPtr conn,
                               const char *path)
@@ -1716,9 +1701,8 @@ storagePoolLookupByTargetPath(virConnectPtr conn,
     if (!cleanpath)
         return NULL;
 
-    if ((obj = virStoragePoolObjListSearch(driver->pools,
-                                           storagePoolLookupByTargetPathCallback,
-                                           cleanpath))) {
+    if ((obj = virStoragePoolObjListFindByTargetPath(driver->pools,
+                                                     cleanpath))) {
         def = virStoragePoolObjGetDef(obj);
         if (virStoragePoolLookupByTargetPathEnsureACL(conn, def) < 0) {
             virStoragePoolObjEndAPI(&obj);
@@ -9782,7 +9782,8 @@ testDomainSetIOThreadParams(virDomainPtr dom,
 }
 
 static int
-testDomainGetStatsState(virDomainObj *dom,
+testDomainGetStatsState(testDriver *driver G_GNUC_UNUSED,
+                        virDomainObj *dom,
                         virTypedParamList *params)
 {
     virTypedParamListAddInt(params, dom->state.state, "state.state");
@@ -9792,7 +9793,8 @@ testDomainGetStatsState(virDomainObj *dom,
 }
 
 static int
-testDomainGetStatsIOThread(virDomainObj *dom,
+testDomainGetStatsIOThread(testDriver *driver G_GNUC_UNUSED,
+                           virDomainObj *dom,
                            virTypedParamList *params)
 {
     testDomainObjPrivate *priv = dom->privateData;
@@ -9824,8 +9826,24 @@ testDomainGetStatsIOThread(virDomainObj *dom,
     return 0;
 }
 
+static int
+testDomainGetStatsXML(testDriver *driver,
+                      virDomainObj *dom,
+                      virTypedParamList *params)
+{
+    g_autofree char *xml = NULL;
+
+    if (!(xml = virDomainDefFormat(dom->def, driver->xmlopt, 0)))
+        return -1;
+
+    virTypedParamListAddString(params, xml, "xml");
+
+    return 0;
+}
+
 typedef int
-(*testDomainGetStatsFunc)(virDomainObj *dom,
+(*testDomainGetStatsFunc)(testDriver *driver,
+                          virDomainObj *dom,
                           virTypedParamList *list);
 
 struct testDomainGetStatsWorker {
@@ -9836,6 +9854,7 @@ struct testDomainGetStatsWorker {
 static struct testDomainGetStatsWorker testDomainGetStatsWorkers[] = {
     { testDomainGetStatsState, VIR_DOMAIN_STATS_STATE },
     { testDomainGetStatsIOThread, VIR_DOMAIN_STATS_IOTHREAD },
+    { testDomainGetStatsXML, VIR_DOMAIN_STATS_XML },
     { NULL, 0 }
 };
 
@@ -9853,7 +9872,8 @@ testDomainGetStats(virConnectPtr conn,
 
     for (i = 0; testDomainGetStatsWorkers[i].func; i++) {
         if (stats & testDomainGetStatsWorkers[i].stats) {
-            if (testDomainGetStatsWorkers[i].func(dom, params) < 0)
+            if (testDomainGetStatsWorkers[i].func(conn->privateData,
+                                                  dom, params) < 0)
                 return -1;
         }
     }
@@ -9885,7 +9905,8 @@ testConnectGetAllDomainStats(virConnectPtr conn,
                                    VIR_CONNECT_LIST_DOMAINS_FILTERS_STATE);
 
     unsigned int supported = VIR_DOMAIN_STATS_STATE |
-                             VIR_DOMAIN_STATS_IOTHREAD;
+                             VIR_DOMAIN_STATS_IOTHREAD |
+                             VIR_DOMAIN_STATS_XML;
     virDomainObj **vms = NULL;
     size_t nvms;
     virDomainStatsRecordPtr *tmpstats = NULL;
@@ -9901,7 +9922,7 @@ testConnectGetAllDomainStats(virConnectPtr conn,
                   VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS, -1);
 
     if (!stats) {
-        stats = supported;
+        stats = supported & ~VIR_DOMAIN_STATS_XML;
     } else if ((flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS) &&
                (stats & ~supported)) {
         virReportError(VIR_ERR_ARGUMENT_UNSUPPORTED,
@@ -0,0 +1,416 @@
+/*
+ * nsagent.c: Helper program creating files inside a mount namespace
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Run by virNSAgentNew(), it supports these commands:
+ *
+ *   mknod:  { "items": [ { "file": ..., "target": ..., "mode": ...,
+ *                          "rdev": ..., "uid": ..., "gid": ...,
+ *                          "acl": ..., "tcon": ... }, ... ] }
+ *     Creates the device nodes and symlinks and moves the bind mounts
+ *     of regular files and directories from "target" to "file". Returns
+ *     1 if any of the files existed before, 0 otherwise.
+ *
+ *   unlink: { "paths": [ ... ] }
+ *     Removes the paths, ignoring the ones which don't exist.
+ */
+
+#include <config.h>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#if defined(WITH_SYS_MOUNT_H)
+# include <sys/mount.h>
+#endif
+#ifdef WITH_SELINUX
+# include <selinux/selinux.h>
+#endif
+
+#include "virerror.h"
+#include "virfile.h"
+#include "virgettext.h"
+#include "virlog.h"
+#include "virnsagent.h"
+#include "virprocess.h"
+#include "virstring.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("util.nsagent");
+
+static const char *program_name;
+
+typedef struct _nsagentMknodItem nsagentMknodItem;
+struct _nsagentMknodItem {
+    char *file;
+    char *target;
+    GStatBuf sb;
+    void *acl;
+    char *tcon;
+};
+
+
+static void
+nsagentMknodItemClear(nsagentMknodItem *item)
+{
+    g_free(item->file);
+    g_free(item->target);
+    virFileFreeACLs(&item->acl);
+    g_free(item->tcon);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(nsagentMknodItem, nsagentMknodItemClear);
+
+
+static int
+nsagentMknodItemParse(virJSONValue *json,
+                      nsagentMknodItem *item)
+{
+    const char *file = virJSONValueObjectGetString(json, "file");
+    const char *acl = virJSONValueObjectGetString(json, "acl");
+    unsigned long long rdev;
+    unsigned int mode;
+    unsigned int uid;
+    unsigned int gid;
+
+    if (!file ||
+        virJSONValueObjectGetNumberUint(json, "mode", &mode) < 0 ||
+        virJSONValueObjectGetNumberUlong(json, "rdev", &rdev) < 0 ||
+        virJSONValueObjectGetNumberUint(json, "uid", &uid) < 0 ||
+        virJSONValueObjectGetNumberUint(json, "gid", &gid) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("malformed namespace mknod item"));
+        return -1;
+    }
+
+    item->file = g_strdup(file);
+    item->target = g_strdup(virJSONValueObjectGetString(json, "target"));
+    item->sb.st_mode = mode;
+    item->sb.st_rdev = rdev;
+    item->sb.st_uid = uid;
+    item->sb.st_gid = gid;
+    item->tcon = g_strdup(virJSONValueObjectGetString(json, "tcon"));
+
+    if (acl &&
+        virFileParseACLs(acl, &item->acl) < 0 &&
+        errno != ENOTSUP) {
+        virReportSystemError(errno,
+                             _("Unable to parse ACLs of %1$s"), file);
+        return -1;
+    }
+
+    if (S_ISLNK(mode) && !item->target) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("missing target of symlink %1$s"), file);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+nsagentMknodOne(nsagentMknodItem *data)
+{
+    int ret = -1;
+    bool delDevice = false;
+    bool isLink = S_ISLNK(data->sb.st_mode);
+    bool isDev = S_ISCHR(data->sb.st_mode) || S_ISBLK(data->sb.st_mode);
+    bool isReg = S_ISREG(data->sb.st_mode) || S_ISFIFO(data->sb.st_mode) || S_ISSOCK(data->sb.st_mode);
+    bool isDir = S_ISDIR(data->sb.st_mode);
+    bool exists = false;
+
+    if (virFileExists(data->file))
+        exists = true;
+
+    if (virFileMakeParentPath(data->file) < 0) {
+        virReportSystemError(errno,
+                             _("Unable to create %1$s"), data->file);
+        goto cleanup;
+    }
+
+    if (isLink) {
+        g_autofree char *target = NULL;
+
+        if ((target = g_file_read_link(data->file, NULL)) &&
+            STREQ(target, data->target)) {
+            VIR_DEBUG("Skipping symlink %s -> %s which exists and points to correct target",
+                      data->file, data->target);
+        } else {
+            VIR_DEBUG("Creating symlink %s -> %s", data->file, data->target);
+
+            /* First, unlink the symlink target. Symlinks change and
+             * therefore we have no guarantees that pre-existing
+             * symlink is still valid. */
+            if (unlink(data->file) < 0 &&
+                errno != ENOENT) {
+                virReportSystemError(errno,
+                                     _("Unable to remove symlink %1$s"),
+                                     data->file);
+                goto cleanup;
+            }
+
+            if (symlink(data->target, data->file) < 0) {
+                virReportSystemError(errno,
+                                     _("Unable to create symlink %1$s (pointing to %2$s)"),
+                                     data->file, data->target);
+                goto cleanup;
+            } else {
+                delDevice = true;
+            }
+        }
+    } else if (isDev) {
+        GStatBuf sb;
+
+        if (g_lstat(data->file, &sb) >= 0 &&
+            sb.st_rdev == data->sb.st_rdev) {
+            VIR_DEBUG("Skipping dev %s (%d,%d) which exists and has correct MAJ:MIN",
+                       data->file, major(data->sb.st_rdev), minor(data->sb.st_rdev));
+        } else {
+            VIR_DEBUG("Creating dev %s (%d,%d)",
+                      data->file, major(data->sb.st_rdev), minor(data->sb.st_rdev));
+            unlink(data->file);
+            if (mknod(data->file, data->sb.st_mode, data->sb.st_rdev) < 0) {
+                virReportSystemError(errno,
+                                     _("Unable to create device %1$s"),
+                                     data->file);
+                goto cleanup;
+            } else {
+                delDevice = true;
+            }
+        }
+    } else if (isReg || isDir) {
+        /* We are not cleaning up disks on virDomainDetachDevice
+         * because disk might be still in use by different disk
+         * as its backing chain. This might however clash here.
+         * Therefore do the cleanup here. */
+        if (umount(data->file) < 0 &&
+            errno != ENOENT && errno != EINVAL) {
+            virReportSystemError(errno,
+                                 _("Unable to umount %1$s"),
+                                 data->file);
+            goto cleanup;
+        }
+        if ((isReg && virFileTouch(data->file, data->sb.st_mode) < 0) ||
+            (isDir && g_mkdir_with_parents(data->file, data->sb.st_mode) < 0))
+            goto cleanup;
+        delDevice = true;
+        /* Just create the file here so that code below sets
+         * proper owner and mode. Move the mount only after that. */
+    } else {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED,
+                       _("unsupported device type %1$s 0%2$o"),
+                       data->file, data->sb.st_mode);
+        goto cleanup;
+    }
+
+    if (lchown(data->file, data->sb.st_uid, data->sb.st_gid) < 0) {
+        virReportSystemError(errno,
+                             _("Failed to chown device %1$s"),
+                             data->file);
+        goto cleanup;
+    }
+
+    /* Symlinks don't have mode */
+    if (!isLink &&
+        chmod(data->file, data->sb.st_mode) < 0) {
+        virReportSystemError(errno,
+                             _("Failed to set permissions for device %1$s"),
+                             data->file);
+        goto cleanup;
+    }
+
+    if (data->acl &&
+        virFileSetACLs(data->file, data->acl) < 0 &&
+        errno != ENOTSUP) {
+        virReportSystemError(errno,
+                             _("Unable to set ACLs on %1$s"), data->file);
+        goto cleanup;
+    }
+
+#ifdef WITH_SELINUX
+    if (data->tcon &&
+        lsetfilecon_raw(data->file, (const char *)data->tcon) < 0) {
+        VIR_WARNINGS_NO_WLOGICALOP_EQUAL_EXPR
+        if (errno != EOPNOTSUPP && errno != ENOTSUP) {
+        VIR_WARNINGS_RESET
+            virReportSystemError(errno,
+                                 _("Unable to set SELinux label on %1$s"),
+                                 data->file);
+            goto cleanup;
+        }
+    }
+#endif
+
+    /* Finish mount process started earlier. */
+    if ((isReg || isDir) &&
+        virFileMoveMount(data->target, data->file) < 0)
+        goto cleanup;
+
+    ret = exists;
+ cleanup:
+    if (ret < 0 && delDevice) {
+        if (isDir)
+            virFileDeleteTree(data->file);
+        else
+            unlink(data->file);
+    }
+    return ret;
+}
+
+
+static int
+nsagentMknod(virJSONValue *args)
+{
+    virJSONValue *items = virJSONValueObjectGetArray(args, "items");
+    bool exists = false;
+    size_t i;
+
+    if (!items) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("missing namespace mknod items"));
+        return -1;
+    }
+
+    for (i = 0; i < virJSONValueArraySize(items); i++) {
+        g_auto(nsagentMknodItem) item = { 0 };
+        int rc;
+
+        if (nsagentMknodItemParse(virJSONValueArrayGet(items, i), &item) < 0)
+            return -1;
+
+        if ((rc = nsagentMknodOne(&item)) < 0)
+            return -1;
+
+        if (rc > 0)
+            exists = true;
+    }
+
+    return exists;
+}
+
+
+static int
+nsagentUnlink(virJSONValue *args)
+{
+    virJSONValue *paths = virJSONValueObjectGetArray(args, "paths");
+    size_t i;
+
+    if (!paths) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("missing namespace unlink paths"));
+        return -1;
+    }
+
+    for (i = 0; i < virJSONValueArraySize(paths); i++) {
+        const char *path = virJSONValueGetString(virJSONValueArrayGet(paths, i));
+
+        if (!path) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("malformed namespace unlink path"));
+            return -1;
+        }
+
+        VIR_DEBUG("Unlinking %s", path);
+        if (unlink(path) < 0 && errno != ENOENT) {
+            virReportSystemError(errno,
+                                 _("Unable to remove device %1$s"), path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static const virNSAgentCommand nsagentCommands[] = {
+    { "mknod", nsagentMknod },
+    { "unlink", nsagentUnlink },
+    { NULL, NULL },
+};
+
+
+/* The namespace is entered only if it's not ours already, which makes
+ * it possible to test the agent without privileges. */
+static int
+nsagentEnterNamespace(pid_t pid)
+{
+    g_autofree char *path = g_strdup_printf("/proc/%lld/ns/mnt", (long long) pid);
+    struct stat target;
+    struct stat self;
+
+    if (stat(path, &target) == 0 &&
+        stat("/proc/self/ns/mnt", &self) == 0 &&
+        target.st_dev == self.st_dev &&
+        target.st_ino == self.st_ino)
+        return 0;
+
+    return virProcessEnterMountNamespace(pid);
+}
+
+
+G_GNUC_NORETURN static void
+usage(int status)
+{
+    if (status) {
+        fprintf(stderr, _("%1$s: try --help for more details\n"), program_name);
+    } else {
+        printf(_("Usage: %1$s PID FD\n"), program_name);
+    }
+    exit(status);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    long long pid;
+    int fd;
+    int status;
+
+    program_name = argv[0];
+
+    if (virGettextInitialize() < 0 ||
+        virErrorInitialize() < 0) {
+        fprintf(stderr, _("%1$s: initialization failed\n"), program_name);
+        exit(EXIT_FAILURE);
+    }
+
+    if (argc > 1 && STREQ(argv[1], "--help"))
+        usage(EXIT_SUCCESS);
+
+    if (argc != 3)
+        usage(EXIT_FAILURE);
+
+    if (virStrToLong_ll(argv[1], NULL, 10, &pid) < 0 || pid <= 0) {
+        fprintf(stderr, _("%1$s: malformed pid %2$s\n"), program_name, argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (virStrToLong_i(argv[2], NULL, 10, &fd) < 0 || fd < 0) {
+        fprintf(stderr, _("%1$s: malformed fd %2$s\n"), program_name, argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* the failure is reported to the daemon over @fd */
+    status = nsagentEnterNamespace(pid);
+
+    if (virNSAgentServe(fd, status, nsagentCommands) < 0)
+        exit(EXIT_FAILURE);
+
+    exit(EXIT_SUCCESS);
+}
@@ -330,3 +330,196 @@ virDeleteElementsN(void *ptrptr, size_t size, size_t at,
         virShrinkN(ptrptr, size, countptr, toremove);
     return 0;
 }
+
+
+/* Memory of an arena comes in chunks, the most recent one first */
+typedef struct _virArenaChunk virArenaChunk;
+struct _virArenaChunk {
+    virArenaChunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+struct _virArena {
+    virArenaChunk *chunks;
+    size_t chunkSize;
+};
+
+#define VIR_ARENA_ALIGN 16
+#define VIR_ARENA_DEFAULT_CHUNK_SIZE 4096
+
+
+/**
+ * virArenaNew:
+ * @chunkSize: size of the blocks the arena allocates, 0 for the default
+ *
+ * Creates an arena for short-lived allocations which are all released at
+ * once by virArenaReset() or virArenaFree() instead of being freed one by
+ * one. Requests larger than @chunkSize get a block of their own.
+ *
+ * Returns the new arena, aborts on OOM.
+ */
+virArena *
+virArenaNew(size_t chunkSize)
+{
+    virArena *arena = g_new0(virArena, 1);
+
+    arena->chunkSize = chunkSize ? chunkSize : VIR_ARENA_DEFAULT_CHUNK_SIZE;
+
+    return arena;
+}
+
+
+static size_t
+virArenaChunkPadding(virArenaChunk *chunk)
+{
+    return -(uintptr_t)(chunk->data + chunk->used) & (VIR_ARENA_ALIGN - 1);
+}
+
+
+/**
+ * virArenaAlloc:
+ * @arena: arena to allocate from
+ * @size: number of bytes
+ *
+ * Allocates @size zeroed bytes aligned for any basic type. The memory
+ * must not be freed by g_free(), it is valid until @arena is reset or
+ * freed.
+ *
+ * Returns the allocated memory, aborts on OOM.
+ */
+void *
+virArenaAlloc(virArena *arena,
+              size_t size)
+{
+    virArenaChunk *chunk = arena->chunks;
+    size_t pad = 0;
+    char *ret;
+
+    if (chunk)
+        pad = virArenaChunkPadding(chunk);
+
+    /* written so that it can't overflow for huge @size */
+    if (!chunk ||
+        chunk->size - chunk->used < pad ||
+        chunk->size - chunk->used - pad < size) {
+        size_t chunkSize = arena->chunkSize;
+
+        if (size > G_MAXSIZE - sizeof(*chunk) - VIR_ARENA_ALIGN)
+            abort();
+
+        if (size + VIR_ARENA_ALIGN > chunkSize)
+            chunkSize = size + VIR_ARENA_ALIGN;
+
+        chunk = g_malloc(sizeof(*chunk) + chunkSize);
+        chunk->size = chunkSize;
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+
+        pad = virArenaChunkPadding(chunk);
+    }
+
+    ret = chunk->data + chunk->used + pad;
+    chunk->used += pad + size;
+
+    memset(ret, 0, size);
+    return ret;
+}
+
+
+/**
+ * virArenaStrndup:
+ * @arena: arena to allocate from
+ * @str: string to copy
+ * @len: number of bytes of @str to copy
+ *
+ * Copies at most @len bytes of @str into @arena and NUL terminates the
+ * copy.
+ *
+ * Returns the copy or NULL if @str is NULL.
+ */
+char *
+virArenaStrndup(virArena *arena,
+                const char *str,
+                size_t len)
+{
+    char *ret;
+
+    if (!str)
+        return NULL;
+
+    len = strnlen(str, len);
+    ret = virArenaAlloc(arena, len + 1);
+    memcpy(ret, str, len);
+
+    return ret;
+}
+
+
+/**
+ * virArenaStrdup:
+ * @arena: arena to allocate from
+ * @str: string to copy
+ *
+ * Returns copy of @str allocated from @arena or NULL if @str is NULL.
+ */
+char *
+virArenaStrdup(virArena *arena,
+               const char *str)
+{
+    if (!str)
+        return NULL;
+
+    return virArenaStrndup(arena, str, strlen(str));
+}
+
+
+/**
+ * virArenaReset:
+ * @arena: arena to reset
+ *
+ * Releases all memory allocated from @arena at once. The most recent block
+ * is kept for further allocations unless it was allocated for an oversized
+ * request.
+ */
+void
+virArenaReset(virArena *arena)
+{
+    virArenaChunk *chunk = arena->chunks;
+
+    arena->chunks = NULL;
+
+    if (chunk && chunk->size == arena->chunkSize) {
+        arena->chunks = chunk;
+        chunk = chunk->next;
+        arena->chunks->next = NULL;
+        arena->chunks->used = 0;
+    }
+
+    while (chunk) {
+        virArenaChunk *next = chunk->next;
+
+        g_free(chunk);
+        chunk = next;
+    }
+}
+
+
+/**
+ * virArenaFree:
+ * @arena: arena to free
+ *
+ * Frees @arena along with all memory allocated from it.
+ */
+void
+virArenaFree(virArena *arena)
+{
+    if (!arena)
+        return;
+
+    virArenaReset(arena);
+    g_free(arena->chunks);
+    g_free(arena);
+}
@@ -276,3 +276,22 @@ int virDeleteElementsN(void *ptrptr, size_t size, size_t at, size_t *countptr,
  * This macro is safe to use on arguments with side effects.
  */
 #define VIR_FREE(ptr) g_clear_pointer(&(ptr), g_free)
+
+
+/*
+ * Arena allocator for short-lived objects, which are released all at once
+ * rather than one by one. Unlike the helpers above it isn't deprecated.
+ */
+typedef struct _virArena virArena;
+
+virArena *virArenaNew(size_t chunkSize);
+void *virArenaAlloc(virArena *arena, size_t size)
+    ATTRIBUTE_NONNULL(1);
+char *virArenaStrdup(virArena *arena, const char *str)
+    ATTRIBUTE_NONNULL(1);
+char *virArenaStrndup(virArena *arena, const char *str, size_t len)
+    ATTRIBUTE_NONNULL(1);
+void virArenaReset(virArena *arena)
+    ATTRIBUTE_NONNULL(1);
+void virArenaFree(virArena *arena);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virArena, virArenaFree);
@@ -32,6 +32,9 @@
 #endif
 #include <fcntl.h>
 #include <unistd.h>
+#if WITH_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+# include <spawn.h>
+#endif
 
 #if WITH_CAPNG
 # include <cap-ng.h>
@@ -54,6 +57,7 @@
 #include "virpidfile.h"
 #include "virprocess.h"
 #include "virbuffer.h"
+#include "virevent.h"
 #include "virsecureerase.h"
 #include "virthread.h"
 #include "virstring.h"
@@ -70,6 +74,7 @@ enum {
     VIR_EXEC_CLEAR_CAPS = (1 << 2),
     VIR_EXEC_RUN_SYNC   = (1 << 3),
     VIR_EXEC_ASYNC_IO   = (1 << 4),
+    VIR_EXEC_EVENT_IO   = (1 << 5),
 };
 
 typedef struct _virCommandFD virCommandFD;
@@ -659,6 +664,127 @@ virCommandMassClose(virCommand *cmd,
 }
 
 
+/*
+ * virExecCanSpawn:
+ * @cmd: command to be executed
+ *
+ * Checks whether @cmd needs any child side setup besides wiring up the
+ * standard FDs. Only commands that don't can be started by posix_spawn()
+ * which doesn't duplicate the address space of the daemon.
+ */
+static bool
+virExecCanSpawn(virCommand *cmd)
+{
+    if (cmd->hook || cmd->pidfile || cmd->handshake ||
+        cmd->npassfd > 0 || cmd->pwd || cmd->mask)
+        return false;
+
+    if (cmd->flags & (VIR_EXEC_DAEMON | VIR_EXEC_CLEAR_CAPS))
+        return false;
+
+    if (cmd->uid != (uid_t)-1 || cmd->gid != (gid_t)-1 ||
+        cmd->capabilities || cmd->schedCore)
+        return false;
+
+    if (cmd->setMaxMemLock || cmd->setMaxProcesses ||
+        cmd->setMaxFiles || cmd->setMaxCore)
+        return false;
+
+# if defined(WITH_SECDRIVER_SELINUX)
+    if (cmd->seLinuxLabel)
+        return false;
+# endif
+# if defined(WITH_SECDRIVER_APPARMOR)
+    if (cmd->appArmorProfile)
+        return false;
+# endif
+
+    return true;
+}
+
+
+# if WITH_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+/*
+ * virExecSpawn:
+ * @cmd: command to be executed
+ * @binary: resolved path of the binary
+ * @childin, @childout, @childerr: FDs to become the child's stdio
+ *
+ * Starts @cmd with posix_spawn(), which glibc implements with
+ * CLONE_VM | CLONE_VFORK, so the cost doesn't grow with the size of the
+ * daemon like fork() does. The child gets default signal dispositions, an
+ * empty signal mask and no FDs other than stdio, just like after virFork()
+ * and virCommandMassClose().
+ *
+ * Returns the PID of the child, or -1 if it couldn't be started, in which
+ * case no error is reported and the caller is expected to fall back to
+ * virFork() which reports errors the usual way.
+ */
+static pid_t
+virExecSpawn(virCommand *cmd,
+             const char *binary,
+             int childin,
+             int childout,
+             int childerr)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    pid_t pid = -1;
+    int rc = -1;
+
+    if (posix_spawn_file_actions_init(&actions) != 0)
+        return -1;
+
+    if (posix_spawnattr_init(&attr) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+
+    if (posix_spawn_file_actions_adddup2(&actions, childin, STDIN_FILENO) != 0 ||
+        posix_spawn_file_actions_adddup2(&actions, childout, STDOUT_FILENO) != 0 ||
+        posix_spawn_file_actions_adddup2(&actions, childerr, STDERR_FILENO) != 0 ||
+        posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1) != 0)
+        goto cleanup;
+
+    sigemptyset(&mask);
+    if (posix_spawnattr_setsigmask(&attr, &mask) != 0)
+        goto cleanup;
+
+    sigfillset(&mask);
+    if (posix_spawnattr_setsigdefault(&attr, &mask) != 0)
+        goto cleanup;
+
+    if (posix_spawnattr_setflags(&attr,
+                                 POSIX_SPAWN_SETSIGMASK |
+                                 POSIX_SPAWN_SETSIGDEF) != 0)
+        goto cleanup;
+
+    rc = posix_spawn(&pid, binary, &actions, &attr, cmd->args,
+                     cmd->env ? cmd->env : environ);
+    if (rc != 0) {
+        VIR_DEBUG("posix_spawn of %s failed: %s", binary, g_strerror(rc));
+        pid = -1;
+    }
+
+ cleanup:
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return pid;
+}
+# else /* !WITH_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+static pid_t
+virExecSpawn(virCommand *cmd G_GNUC_UNUSED,
+             const char *binary G_GNUC_UNUSED,
+             int childin G_GNUC_UNUSED,
+             int childout G_GNUC_UNUSED,
+             int childerr G_GNUC_UNUSED)
+{
+    return -1;
+}
+# endif /* !WITH_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP */
+
+
 /*
  * virExec:
  * @cmd virCommand * containing all information about the program to
@@ -738,7 +864,14 @@ virExec(virCommand *cmd)
     if ((ngroups = virGetGroupList(cmd->uid, cmd->gid, &groups)) < 0)
         goto cleanup;
 
-    pid = virFork();
+    /* Commands without any child side setup don't need to pay for
+     * duplicating our address space. If the spawn fails for whatever
+     * reason, go the usual way which reports the failure properly. */
+    pid = -1;
+    if (virExecCanSpawn(cmd))
+        pid = virExecSpawn(cmd, binary, childin, childout, childerr);
+    if (pid < 0)
+        pid = virFork();
 
     if (pid < 0)
         goto cleanup;
@@ -2582,7 +2715,7 @@ virCommandRunAsync(virCommand *cmd, pid_t *pid)
     /* Buffer management can only be requested via virCommandRun or
      * virCommandDoAsyncIO. */
     if (cmd->inbuf && cmd->infd == -1 &&
-        (synchronous || cmd->flags & VIR_EXEC_ASYNC_IO)) {
+        (synchronous || cmd->flags & (VIR_EXEC_ASYNC_IO | VIR_EXEC_EVENT_IO))) {
         if (virPipe(infd) < 0) {
             cmd->has_error = -1;
             return -1;
@@ -2804,6 +2937,554 @@ virCommandAbort(virCommand *cmd)
 }
 
 
+/*
+ * Commands run by virCommandRunAsyncCallback() are tracked by
+ * virCommandEventData. Their string I/O and exit are handled by the event
+ * loop, the exit is noticed via a pidfd. Where either is missing, a
+ * detached thread does the same with virCommandProcessIO() and
+ * virCommandWait().
+ *
+ * The data is referenced by the command in flight and by each of its
+ * event handles since the event loop may free those after the command
+ * completes.
+ */
+typedef struct _virCommandEventData virCommandEventData;
+struct _virCommandEventData {
+    int refs;
+
+    virCommand *cmd;
+    virCommandCompletionCallback cb;
+    void *opaque;
+
+    /* basename of the binary if it holds a slot of a concurrency limit */
+    char *limitKey;
+
+    int pidfd;
+    int pidWatch;
+    int inWatch;
+    int outWatch;
+    int errWatch;
+
+    size_t inoff;
+    size_t outlen;
+    size_t errlen;
+
+    /* output captured for logging if the caller didn't ask for it */
+    char *outbuf;
+    char *errbuf;
+
+    virErrorPtr error;
+};
+
+
+typedef struct _virCommandLimit virCommandLimit;
+struct _virCommandLimit {
+    unsigned int max; /* 0 for no limit */
+    unsigned int running;
+    GQueue pending; /* virCommandEventData waiting for a slot */
+};
+
+static virMutex virCommandLimitLock = VIR_MUTEX_INITIALIZER;
+static GHashTable *virCommandLimits;
+
+
+static void
+virCommandLimitFree(void *opaque)
+{
+    virCommandLimit *limit = opaque;
+
+    g_queue_clear(&limit->pending);
+    g_free(limit);
+}
+
+
+static void
+virCommandEventDataUnref(void *opaque)
+{
+    virCommandEventData *data = opaque;
+
+    if (!g_atomic_int_dec_and_test(&data->refs))
+        return;
+
+    virCommandFree(data->cmd);
+    VIR_FORCE_CLOSE(data->pidfd);
+    g_free(data->limitKey);
+    g_free(data->outbuf);
+    g_free(data->errbuf);
+    virFreeError(data->error);
+    g_free(data);
+}
+
+
+static void
+virCommandEventRemoveWatches(virCommandEventData *data)
+{
+    int *watches[] = { &data->pidWatch, &data->inWatch,
+                       &data->outWatch, &data->errWatch };
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS(watches); i++) {
+        if (*watches[i] < 0)
+            continue;
+
+        virEventRemoveHandle(*watches[i]);
+        *watches[i] = -1;
+    }
+}
+
+
+static int virCommandEventStart(virCommandEventData *data);
+
+
+/*
+ * Returns the next command queued for the limit of @key, taking a slot
+ * for it, or NULL.
+ */
+static virCommandEventData *
+virCommandLimitNext(const char *key)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&virCommandLimitLock);
+    virCommandLimit *limit;
+
+    if (!virCommandLimits ||
+        !(limit = g_hash_table_lookup(virCommandLimits, key)))
+        return NULL;
+
+    if (limit->max && limit->running >= limit->max)
+        return NULL;
+
+    if (g_queue_is_empty(&limit->pending))
+        return NULL;
+
+    limit->running++;
+    return g_queue_pop_head(&limit->pending);
+}
+
+
+static void
+virCommandEventComplete(virCommandEventData *data);
+
+static void
+virCommandLimitDispatch(const char *key)
+{
+    virCommandEventData *next;
+
+    while ((next = virCommandLimitNext(key))) {
+        if (virCommandEventStart(next) < 0) {
+            virErrorPreserveLast(&next->error);
+            virCommandEventComplete(next);
+        }
+    }
+}
+
+
+static void
+virCommandLimitRelease(virCommandEventData *data)
+{
+    g_autofree char *key = g_steal_pointer(&data->limitKey);
+
+    if (!key)
+        return;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&virCommandLimitLock) {
+        virCommandLimit *limit = g_hash_table_lookup(virCommandLimits, key);
+
+        limit->running--;
+    }
+
+    virCommandLimitDispatch(key);
+}
+
+
+/*
+ * Reports the result of the command, releases its concurrency slot and
+ * drops the reference held by the command in flight.
+ */
+static void
+virCommandEventComplete(virCommandEventData *data)
+{
+    virCommand *cmd = data->cmd;
+    int exitstatus = -1;
+    int ret = -1;
+
+    virCommandEventRemoveWatches(data);
+    VIR_FORCE_CLOSE(data->pidfd);
+    VIR_FORCE_CLOSE(cmd->inpipe);
+
+    if (data->error) {
+        virCommandAbort(cmd);
+    } else if ((ret = virCommandWait(cmd, &exitstatus)) < 0) {
+        virErrorPreserveLast(&data->error);
+    }
+
+    VIR_DEBUG("Command %s finished with ret=%d status=%d, stdout: '%s' stderr: '%s'",
+              cmd->args[0], ret, exitstatus,
+              cmd->outbuf ? NULLSTR(*cmd->outbuf) : "(null)",
+              cmd->errbuf ? NULLSTR(*cmd->errbuf) : "(null)");
+
+    if (data->error)
+        virErrorRestore(&data->error);
+
+    data->cb(cmd, ret, exitstatus, data->opaque);
+
+    virCommandLimitRelease(data);
+    virCommandEventDataUnref(data);
+}
+
+
+static void
+virCommandEventCheckDone(virCommandEventData *data)
+{
+    if (data->pidWatch < 0 && data->inWatch < 0 &&
+        data->outWatch < 0 && data->errWatch < 0)
+        virCommandEventComplete(data);
+}
+
+
+static void
+virCommandEventFail(virCommandEventData *data)
+{
+    virErrorPreserveLast(&data->error);
+    virCommandEventComplete(data);
+}
+
+
+static void
+virCommandEventHandlePid(int watch,
+                         int fd G_GNUC_UNUSED,
+                         int events G_GNUC_UNUSED,
+                         void *opaque)
+{
+    virCommandEventData *data = opaque;
+
+    virEventRemoveHandle(watch);
+    data->pidWatch = -1;
+
+    virCommandEventCheckDone(data);
+}
+
+
+static void
+virCommandEventHandleInput(int watch,
+                           int fd,
+                           int events G_GNUC_UNUSED,
+                           void *opaque)
+{
+    virCommandEventData *data = opaque;
+    virCommand *cmd = data->cmd;
+    size_t inlen = strlen(cmd->inbuf);
+    ssize_t done;
+
+    done = write(fd, cmd->inbuf + data->inoff, inlen - data->inoff); /* sc_avoid_write */
+    if (done < 0) {
+        if (errno == EINTR || errno == EAGAIN)
+            return;
+
+        if (errno != EPIPE) {
+            virReportSystemError(errno, "%s",
+                                 _("unable to write to child input"));
+            virCommandEventFail(data);
+            return;
+        }
+
+        VIR_DEBUG("child closed stdin early, ignoring EPIPE on fd %d", fd);
+    } else {
+        data->inoff += done;
+        if (data->inoff < inlen)
+            return;
+    }
+
+    virEventRemoveHandle(watch);
+    data->inWatch = -1;
+    VIR_FORCE_CLOSE(cmd->inpipe);
+
+    virCommandEventCheckDone(data);
+}
+
+
+static void
+virCommandEventHandleOutput(int watch,
+                            int fd,
+                            int events G_GNUC_UNUSED,
+                            void *opaque)
+{
+    virCommandEventData *data = opaque;
+    virCommand *cmd = data->cmd;
+    bool isOut = watch == data->outWatch;
+    char **buf = isOut ? cmd->outbuf : cmd->errbuf;
+    size_t *len = isOut ? &data->outlen : &data->errlen;
+    char tmp[1024];
+    ssize_t done;
+
+    if ((done = read(fd, tmp, sizeof(tmp))) < 0) {
+        if (errno == EINTR || errno == EAGAIN)
+            return;
+
+        virReportSystemError(errno, "%s",
+                             isOut ? _("unable to read child stdout") :
+                                     _("unable to read child stderr"));
+        virCommandEventFail(data);
+        return;
+    }
+
+    if (done > 0) {
+        VIR_REALLOC_N(*buf, *len + done + 1);
+        memcpy(*buf + *len, tmp, done);
+        *len += done;
+        (*buf)[*len] = '\0';
+        return;
+    }
+
+    virEventRemoveHandle(watch);
+    if (isOut)
+        data->outWatch = -1;
+    else
+        data->errWatch = -1;
+
+    virCommandEventCheckDone(data);
+}
+
+
+static int
+virCommandEventAddHandle(virCommandEventData *data,
+                         int *watch,
+                         int fd,
+                         int events,
+                         virEventHandleCallback cb)
+{
+    g_atomic_int_inc(&data->refs);
+
+    if ((*watch = virEventAddHandle(fd, events, cb, data,
+                                    virCommandEventDataUnref)) < 0) {
+        virCommandEventDataUnref(data);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static void
+virCommandEventThread(void *opaque)
+{
+    virCommandEventData *data = opaque;
+
+    if (virCommandProcessIO(data->cmd) < 0)
+        virErrorPreserveLast(&data->error);
+
+    virCommandEventComplete(data);
+}
+
+
+static int
+virCommandEventStart(virCommandEventData *data)
+{
+    virCommand *cmd = data->cmd;
+    virThread thread;
+
+    if (virCommandRunAsync(cmd, NULL) < 0)
+        return -1;
+
+    /* dry run */
+    if (cmd->pid == -1) {
+        virCommandEventComplete(data);
+        return 0;
+    }
+
+    if (cmd->inbuf)
+        VIR_FORCE_CLOSE(cmd->infd);
+
+    if (cmd->outbuf) {
+        VIR_FREE(*cmd->outbuf);
+        *cmd->outbuf = g_new0(char, 1);
+    }
+    if (cmd->errbuf) {
+        VIR_FREE(*cmd->errbuf);
+        *cmd->errbuf = g_new0(char, 1);
+    }
+
+    /* Without an event loop to deliver the exit of the child we would
+     * have to poll for it, a thread is cheaper. */
+    if (virCommandGetNumSendBuffers(cmd) == 0 &&
+        (data->pidfd = virProcessPidFDOpen(cmd->pid)) >= 0 &&
+        virCommandEventAddHandle(data, &data->pidWatch, data->pidfd,
+                                 VIR_EVENT_HANDLE_READABLE,
+                                 virCommandEventHandlePid) == 0 &&
+        (cmd->inpipe == -1 ||
+         virCommandEventAddHandle(data, &data->inWatch, cmd->inpipe,
+                                  VIR_EVENT_HANDLE_WRITABLE,
+                                  virCommandEventHandleInput) == 0) &&
+        (!cmd->outbuf ||
+         virCommandEventAddHandle(data, &data->outWatch, cmd->outfd,
+                                  VIR_EVENT_HANDLE_READABLE,
+                                  virCommandEventHandleOutput) == 0) &&
+        (!cmd->errbuf ||
+         virCommandEventAddHandle(data, &data->errWatch, cmd->errfd,
+                                  VIR_EVENT_HANDLE_READABLE,
+                                  virCommandEventHandleOutput) == 0))
+        return 0;
+
+    virCommandEventRemoveWatches(data);
+    VIR_FORCE_CLOSE(data->pidfd);
+    virResetLastError();
+
+    VIR_DEBUG("Waiting for command %s in a thread", cmd->args[0]);
+
+    if (virThreadCreateFull(&thread, false, virCommandEventThread,
+                            "cmd-async-wait", false, data) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create thread to wait for command"));
+        virCommandAbort(cmd);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virCommandRunAsyncCallback:
+ * @cmd: command to run, consumed
+ * @cb: callback to call once the command finishes
+ * @opaque: opaque data for @cb
+ *
+ * Runs @cmd without blocking the caller. String I/O set up by
+ * virCommandSetInputBuffer() and friends is processed by the event loop
+ * and @cb is called once the command exited and closed its output, with
+ * the buffers filled in. Buffers must stay valid until then. The command
+ * is freed after @cb returns.
+ *
+ * If a limit was set for the binary of @cmd by
+ * virCommandSetConcurrencyLimit() and enough commands run already, @cmd
+ * is queued until one of them finishes.
+ *
+ * @cb is usually called from the event loop thread. It is called from a
+ * helper thread if pidfds or the event loop are not available, and before
+ * this function returns in dry run mode.
+ *
+ * Returns 0 if @cmd was started or queued and @cb will be called, -1
+ * otherwise.
+ */
+int
+virCommandRunAsyncCallback(virCommand *cmd,
+                           virCommandCompletionCallback cb,
+                           void *opaque)
+{
+    virCommandEventData *data;
+    virCommandLimit *limit = NULL;
+    g_autofree char *key = NULL;
+
+    if (virCommandHasError(cmd)) {
+        virCommandRaiseError(cmd);
+        virCommandFree(cmd);
+        return -1;
+    }
+
+    if ((cmd->flags & (VIR_EXEC_DAEMON | VIR_EXEC_ASYNC_IO)) ||
+        (cmd->outfdptr && cmd->outfdptr != &cmd->outfd) ||
+        (cmd->errfdptr && cmd->errfdptr != &cmd->errfd)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("only string I/O can be used with command completion callbacks"));
+        virCommandFree(cmd);
+        return -1;
+    }
+
+    data = g_new0(virCommandEventData, 1);
+    data->refs = 1;
+    data->cmd = cmd;
+    data->cb = cb;
+    data->opaque = opaque;
+    data->pidfd = -1;
+    data->pidWatch = -1;
+    data->inWatch = -1;
+    data->outWatch = -1;
+    data->errWatch = -1;
+
+    /* Merge stdout and stderr into one string if the caller asked for
+     * it and capture what the caller didn't ask for to log it. */
+    if (cmd->outbuf && cmd->outbuf == cmd->errbuf) {
+        cmd->errfdptr = &cmd->outfd;
+        cmd->errbuf = NULL;
+    }
+    if (!cmd->outfdptr) {
+        cmd->outfdptr = &cmd->outfd;
+        cmd->outbuf = &data->outbuf;
+    }
+    if (!cmd->errfdptr) {
+        cmd->errfdptr = &cmd->errfd;
+        cmd->errbuf = &data->errbuf;
+    }
+
+    cmd->flags |= VIR_EXEC_EVENT_IO | VIR_EXEC_NONBLOCK;
+
+    key = g_path_get_basename(cmd->args[0]);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&virCommandLimitLock) {
+        if (virCommandLimits)
+            limit = g_hash_table_lookup(virCommandLimits, key);
+
+        if (limit) {
+            data->limitKey = g_steal_pointer(&key);
+
+            if (limit->max && limit->running >= limit->max) {
+                VIR_DEBUG("Queueing command %s, %u instances running",
+                          cmd->args[0], limit->running);
+                g_queue_push_tail(&limit->pending, data);
+                return 0;
+            }
+
+            limit->running++;
+        }
+    }
+
+    if (virCommandEventStart(data) < 0) {
+        virErrorPtr err;
+
+        virErrorPreserveLast(&err);
+        virCommandLimitRelease(data);
+        virCommandEventDataUnref(data);
+        virErrorRestore(&err);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virCommandSetConcurrencyLimit:
+ * @binary: name of the binary, without path
+ * @limit: maximum number of instances, 0 for no limit
+ *
+ * Limits how many instances of @binary started by
+ * virCommandRunAsyncCallback() run at once. This keeps slow external
+ * tools from piling up.
+ */
+void
+virCommandSetConcurrencyLimit(const char *binary,
+                              unsigned int limit)
+{
+    VIR_WITH_MUTEX_LOCK_GUARD(&virCommandLimitLock) {
+        virCommandLimit *lim;
+
+        if (!virCommandLimits)
+            virCommandLimits = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                     g_free, virCommandLimitFree);
+
+        if (!(lim = g_hash_table_lookup(virCommandLimits, binary))) {
+            lim = g_new0(virCommandLimit, 1);
+            g_queue_init(&lim->pending);
+            g_hash_table_insert(virCommandLimits, g_strdup(binary), lim);
+        }
+
+        lim->max = limit;
+    }
+
+    /* a higher limit might allow queued commands to run */
+    virCommandLimitDispatch(binary);
+}
+
+
 /**
  * virCommandRequireHandshake:
  * @cmd: command to modify
@@ -3008,6 +3689,25 @@ virCommandAbort(virCommand *cmd G_GNUC_UNUSED)
 }
 
 
+int
+virCommandRunAsyncCallback(virCommand *cmd,
+                           virCommandCompletionCallback cb G_GNUC_UNUSED,
+                           void *opaque G_GNUC_UNUSED)
+{
+    virCommandFree(cmd);
+    virReportSystemError(ENOSYS, "%s",
+                         _("Executing new processes is not supported on Win32 platform"));
+    return -1;
+}
+
+
+void
+virCommandSetConcurrencyLimit(const char *binary G_GNUC_UNUSED,
+                              unsigned int limit G_GNUC_UNUSED)
+{
+}
+
+
 void virCommandRequireHandshake(virCommand *cmd)
 {
     if (virCommandHasError(cmd))
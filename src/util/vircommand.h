@@ -192,6 +192,25 @@ int virCommandRunAsync(virCommand *cmd,
 int virCommandWait(virCommand *cmd,
                    int *exitstatus) G_GNUC_WARN_UNUSED_RESULT;
 
+/**
+ * virCommandCompletionCallback:
+ * @cmd: the finished command
+ * @ret: 0 if the command ran, -1 otherwise with the error set
+ * @exitstatus: exit status of the command if @ret is 0
+ * @opaque: opaque data passed to virCommandRunAsyncCallback
+ */
+typedef void (*virCommandCompletionCallback)(virCommand *cmd,
+                                             int ret,
+                                             int exitstatus,
+                                             void *opaque);
+
+int virCommandRunAsyncCallback(virCommand *cmd,
+                               virCommandCompletionCallback cb,
+                               void *opaque) G_GNUC_WARN_UNUSED_RESULT;
+
+void virCommandSetConcurrencyLimit(const char *binary,
+                                   unsigned int limit);
+
 void virCommandRequireHandshake(virCommand *cmd);
 
 int virCommandHandshakeWait(virCommand *cmd)
@@ -571,8 +571,14 @@ dnsmasqReload(pid_t pid G_GNUC_UNUSED)
  *
  */
 struct _dnsmasqCaps {
-    virObject parent;
+    virObjectLockable parent;
     char *binaryPath;
+
+    /* Result of the last version check and whether one is running. The
+     * binary path is not changed by checks so that it can be used without
+     * holding the lock. */
+    bool usable;
+    bool refreshing;
 };
 
 static virClass *dnsmasqCapsClass;
@@ -587,7 +593,7 @@ dnsmasqCapsDispose(void *obj)
 
 static int dnsmasqCapsOnceInit(void)
 {
-    if (!VIR_CLASS_NEW(dnsmasqCaps, virClassForObject()))
+    if (!VIR_CLASS_NEW(dnsmasqCaps, virClassForObjectLockable()))
         return -1;
 
     return 0;
@@ -641,16 +647,26 @@ dnsmasqCapsSetFromBuffer(dnsmasqCaps *caps, const char *buf)
 
 }
 
+static virCommand *
+dnsmasqCapsVersionCommand(dnsmasqCaps *caps,
+                          char **version)
+{
+    virCommand *cmd = virCommandNewArgList(caps->binaryPath, "--version", NULL);
+
+    virCommandSetOutputBuffer(cmd, version);
+    virCommandAddEnvPassCommon(cmd);
+    virCommandClearCaps(cmd);
+
+    return cmd;
+}
+
 static int
 dnsmasqCapsRefreshInternal(dnsmasqCaps *caps)
 {
     g_autoptr(virCommand) vercmd = NULL;
     g_autofree char *version = NULL;
 
-    vercmd = virCommandNewArgList(caps->binaryPath, "--version", NULL);
-    virCommandSetOutputBuffer(vercmd, &version);
-    virCommandAddEnvPassCommon(vercmd);
-    virCommandClearCaps(vercmd);
+    vercmd = dnsmasqCapsVersionCommand(caps, &version);
     if (virCommandRun(vercmd, NULL) < 0)
         return -1;
 
@@ -665,7 +681,7 @@ dnsmasqCapsNewFromBinary(void)
     if (dnsmasqCapsInitialize() < 0)
         return NULL;
 
-    if (!(caps = virObjectNew(dnsmasqCapsClass)))
+    if (!(caps = virObjectLockableNew(dnsmasqCapsClass)))
         return NULL;
 
     if (!(caps->binaryPath = virFindFileInPath(DNSMASQ))) {
@@ -677,9 +693,105 @@ dnsmasqCapsNewFromBinary(void)
     if (dnsmasqCapsRefreshInternal(caps) < 0)
         return NULL;
 
+    caps->usable = true;
+
     return g_steal_pointer(&caps);
 }
 
+
+typedef struct _dnsmasqCapsRefreshData dnsmasqCapsRefreshData;
+struct _dnsmasqCapsRefreshData {
+    dnsmasqCaps *caps;
+    char *version;
+};
+
+
+static void
+dnsmasqCapsRefreshDone(virCommand *cmd G_GNUC_UNUSED,
+                       int ret,
+                       int exitstatus,
+                       void *opaque)
+{
+    dnsmasqCapsRefreshData *data = opaque;
+    dnsmasqCaps *caps = data->caps;
+    bool usable = false;
+
+    if (ret < 0) {
+        VIR_WARN("Unable to check version of %s: %s",
+                 caps->binaryPath, virGetLastErrorMessage());
+    } else if (exitstatus != 0) {
+        VIR_WARN("Checking version of %s failed with status %d",
+                 caps->binaryPath, exitstatus);
+    } else if (dnsmasqCapsSetFromBuffer(caps, NULLSTR_EMPTY(data->version)) < 0) {
+        VIR_WARN("%s", virGetLastErrorMessage());
+    } else {
+        usable = true;
+    }
+
+    VIR_WITH_OBJECT_LOCK_GUARD(caps) {
+        caps->usable = usable;
+        caps->refreshing = false;
+    }
+
+    virObjectUnref(caps);
+    g_free(data->version);
+    g_free(data);
+}
+
+
+/**
+ * dnsmasqCapsRefreshAsync:
+ * @caps: dnsmasq capabilities
+ *
+ * Checks the version of the dnsmasq binary of @caps again without
+ * waiting for the check to finish, unless one is running already. The
+ * result is reported by dnsmasqCapsIsUsable() once it's known.
+ */
+void
+dnsmasqCapsRefreshAsync(dnsmasqCaps *caps)
+{
+    dnsmasqCapsRefreshData *data;
+    virCommand *cmd;
+
+    VIR_WITH_OBJECT_LOCK_GUARD(caps) {
+        if (caps->refreshing)
+            return;
+        caps->refreshing = true;
+    }
+
+    data = g_new0(dnsmasqCapsRefreshData, 1);
+    data->caps = virObjectRef(caps);
+    cmd = dnsmasqCapsVersionCommand(caps, &data->version);
+
+    if (virCommandRunAsyncCallback(cmd, dnsmasqCapsRefreshDone, data) < 0) {
+        VIR_WARN("Unable to check version of %s: %s",
+                 caps->binaryPath, virGetLastErrorMessage());
+
+        VIR_WITH_OBJECT_LOCK_GUARD(caps) {
+            caps->refreshing = false;
+        }
+
+        virObjectUnref(caps);
+        g_free(data);
+    }
+}
+
+
+/**
+ * dnsmasqCapsIsUsable:
+ * @caps: dnsmasq capabilities
+ *
+ * Returns false if the last check of the dnsmasq binary of @caps failed,
+ * which means fresh capabilities have to be created before it is run.
+ */
+bool
+dnsmasqCapsIsUsable(dnsmasqCaps *caps)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(caps);
+
+    return caps->usable;
+}
+
 const char *
 dnsmasqCapsGetBinaryPath(dnsmasqCaps *caps)
 {
@@ -92,6 +92,8 @@ int              dnsmasqDelete(const dnsmasqContext *ctx);
 int              dnsmasqReload(pid_t pid);
 
 dnsmasqCaps *dnsmasqCapsNewFromBinary(void);
+void dnsmasqCapsRefreshAsync(dnsmasqCaps *caps);
+bool dnsmasqCapsIsUsable(dnsmasqCaps *caps);
 const char *dnsmasqCapsGetBinaryPath(dnsmasqCaps *caps);
 char *dnsmasqDhcpHostsToString(dnsmasqDhcpHost *hosts,
                                unsigned int nhosts);
@@ -3959,6 +3959,32 @@ virFileFreeACLs(void **acl)
     g_clear_pointer(acl, acl_free);
 }
 
+
+char *
+virFileFormatACLs(void *acl)
+{
+    char *text;
+    char *ret;
+
+    if (!(text = acl_to_text(acl, NULL)))
+        return NULL;
+
+    ret = g_strdup(text);
+    acl_free(text);
+    return ret;
+}
+
+
+int
+virFileParseACLs(const char *text,
+                 void **acl)
+{
+    if (!(*acl = acl_from_text(text)))
+        return -1;
+
+    return 0;
+}
+
 #else /* !defined(WITH_LIBACL) */
 
 int
@@ -3985,6 +4011,24 @@ virFileFreeACLs(void **acl)
     *acl = NULL;
 }
 
+
+char *
+virFileFormatACLs(void *acl G_GNUC_UNUSED)
+{
+    errno = ENOTSUP;
+    return NULL;
+}
+
+
+int
+virFileParseACLs(const char *text G_GNUC_UNUSED,
+                 void **acl)
+{
+    *acl = NULL;
+    errno = ENOTSUP;
+    return -1;
+}
+
 #endif /* !defined(WITH_LIBACL) */
 
 int
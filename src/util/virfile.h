@@ -339,6 +339,11 @@ int virFileSetACLs(const char *file,
 
 void virFileFreeACLs(void **acl);
 
+char *virFileFormatACLs(void *acl);
+
+int virFileParseACLs(const char *text,
+                     void **acl);
+
 int virFileCopyACLs(const char *src,
                     const char *dst);
 
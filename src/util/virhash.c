@@ -607,3 +607,93 @@ bool virHashEqual(GHashTable *table1,
 
     return data.equal;
 }
+
+
+/**
+ * virHashMultiNew:
+ *
+ * Create a new GHashTable * which maps string keys to any number of
+ * values, for use as secondary index of an object list where the
+ * indexed property is not necessarily unique. The table doesn't own
+ * the values, callers must remove them before they are freed.
+ *
+ * Returns the newly created object.
+ */
+GHashTable *
+virHashMultiNew(void)
+{
+    return virHashNew((GDestroyNotify) g_ptr_array_unref);
+}
+
+
+/**
+ * virHashMultiAdd:
+ * @table: the hash table created by virHashMultiNew()
+ * @name: the key
+ * @userdata: the value to add
+ *
+ * Adds @userdata to the values of @name. A NULL @name is ignored so
+ * that objects missing the indexed property can be passed as well.
+ */
+void
+virHashMultiAdd(GHashTable *table,
+                const char *name,
+                void *userdata)
+{
+    GPtrArray *values;
+
+    if (!name)
+        return;
+
+    if (!(values = g_hash_table_lookup(table, name))) {
+        values = g_ptr_array_new();
+        g_hash_table_insert(table, g_strdup(name), values);
+    }
+
+    g_ptr_array_add(values, userdata);
+}
+
+
+/**
+ * virHashMultiRemove:
+ * @table: the hash table created by virHashMultiNew()
+ * @name: the key
+ * @userdata: the value to remove
+ *
+ * Removes @userdata from the values of @name, dropping the key once it
+ * has no values left.
+ */
+void
+virHashMultiRemove(GHashTable *table,
+                   const char *name,
+                   void *userdata)
+{
+    GPtrArray *values;
+
+    if (!name || !(values = g_hash_table_lookup(table, name)))
+        return;
+
+    g_ptr_array_remove_fast(values, userdata);
+
+    if (values->len == 0)
+        g_hash_table_remove(table, name);
+}
+
+
+/**
+ * virHashMultiLookup:
+ * @table: the hash table created by virHashMultiNew()
+ * @name: the key
+ *
+ * Returns the array of values of @name, or NULL if there are none. The
+ * array is owned by @table and only valid until it is modified.
+ */
+GPtrArray *
+virHashMultiLookup(GHashTable *table,
+                   const char *name)
+{
+    if (!name)
+        return NULL;
+
+    return g_hash_table_lookup(table, name);
+}
@@ -124,3 +124,11 @@ int virHashForEachSorted(GHashTable *table, virHashIterator iter, void *opaque);
 ssize_t virHashRemoveSet(GHashTable *table, virHashSearcher iter, const void *opaque);
 void *virHashSearch(GHashTable *table, virHashSearcher iter,
                     const void *opaque, char **name);
+
+/*
+ * Tables mapping a key to any number of values
+ */
+GHashTable *virHashMultiNew(void) G_GNUC_WARN_UNUSED_RESULT;
+void virHashMultiAdd(GHashTable *table, const char *name, void *userdata);
+void virHashMultiRemove(GHashTable *table, const char *name, void *userdata);
+GPtrArray *virHashMultiLookup(GHashTable *table, const char *name);
@@ -33,6 +33,7 @@
 #include "virstring.h"
 #include "virutil.h"
 #include "virjson.h"
+#include "virprobe.h"
 
 #ifndef WIN32
 # include <sys/ioctl.h>
@@ -3584,3 +3585,284 @@ virNetDevGenerateName(char **ifname, virNetDevGenNameType type)
                    prefix);
     return -1;
 }
+
+
+/*
+ * Link configuration batches. Each step of setting up a device (MAC
+ * address, MTU, master, link state) is queued as a separate RTM_SETLINK
+ * message so that the kernel applies them in the same order the ioctl
+ * based helpers would, but all of them are sent in a single datagram
+ * and acknowledged together.
+ */
+struct _virNetDevLinkBatch {
+    GPtrArray *msgs;
+};
+
+static virMutex virNetDevLinkBatchStatsLock = VIR_MUTEX_INITIALIZER;
+static virNetDevLinkBatchStats virNetDevLinkBatchStatsTotal;
+
+
+/**
+ * virNetDevLinkBatchNew:
+ *
+ * Returns a new, empty batch of link configuration changes.
+ */
+virNetDevLinkBatch *
+virNetDevLinkBatchNew(void)
+{
+    virNetDevLinkBatch *batch = g_new0(virNetDevLinkBatch, 1);
+
+#if defined(WITH_LIBNL)
+    batch->msgs = g_ptr_array_new_with_free_func((GDestroyNotify) nlmsg_free);
+#else
+    batch->msgs = g_ptr_array_new();
+#endif
+
+    return batch;
+}
+
+
+void
+virNetDevLinkBatchFree(virNetDevLinkBatch *batch)
+{
+    if (!batch)
+        return;
+
+    g_ptr_array_unref(batch->msgs);
+    g_free(batch);
+}
+
+
+#if defined(WITH_LIBNL)
+/* The device is looked up by @ifname as ifi_index is left at 0. */
+static int
+virNetDevLinkBatchAdd(virNetDevLinkBatch *batch,
+                      const char *ifname,
+                      unsigned int ifflags,
+                      unsigned int ifchange,
+                      int attrtype,
+                      int attrlen,
+                      const void *attr)
+{
+    struct ifinfomsg ifinfo = {
+        .ifi_family = AF_UNSPEC,
+        .ifi_flags = ifflags,
+        .ifi_change = ifchange,
+    };
+    g_autoptr(virNetlinkMsg) msg = virNetlinkMsgNew(RTM_SETLINK, NLM_F_REQUEST);
+
+    if (nlmsg_append(msg, &ifinfo, sizeof(ifinfo), NLMSG_ALIGNTO) < 0 ||
+        nla_put_string(msg, IFLA_IFNAME, ifname) < 0 ||
+        (attr && nla_put(msg, attrtype, attrlen, attr) < 0)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("allocated netlink buffer is too small"));
+        return -1;
+    }
+
+    g_ptr_array_add(batch->msgs, g_steal_pointer(&msg));
+    return 0;
+}
+
+
+/**
+ * virNetDevLinkBatchSetMAC:
+ * @batch: batch to add the change to
+ * @ifname: interface name
+ * @macaddr: MAC address
+ *
+ * Queues setting the MAC address of @ifname, see virNetDevSetMAC().
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetDevLinkBatchSetMAC(virNetDevLinkBatch *batch,
+                         const char *ifname,
+                         const virMacAddr *macaddr)
+{
+    return virNetDevLinkBatchAdd(batch, ifname, 0, 0, IFLA_ADDRESS,
+                                 VIR_MAC_BUFLEN, macaddr->addr);
+}
+
+
+/**
+ * virNetDevLinkBatchSetMTU:
+ * @batch: batch to add the change to
+ * @ifname: interface name
+ * @mtu: MTU value
+ *
+ * Queues setting the MTU of @ifname, see virNetDevSetMTU().
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetDevLinkBatchSetMTU(virNetDevLinkBatch *batch,
+                         const char *ifname,
+                         unsigned int mtu)
+{
+    uint32_t val = mtu;
+
+    return virNetDevLinkBatchAdd(batch, ifname, 0, 0, IFLA_MTU,
+                                 sizeof(val), &val);
+}
+
+
+/**
+ * virNetDevLinkBatchSetMaster:
+ * @batch: batch to add the change to
+ * @ifname: interface name
+ * @master: name of the bridge or bond device
+ *
+ * Queues attaching @ifname to @master. Unlike virNetDevBridgeAddPort()
+ * this works for any kind of master device.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetDevLinkBatchSetMaster(virNetDevLinkBatch *batch,
+                            const char *ifname,
+                            const char *master)
+{
+    int ifindex;
+    uint32_t val;
+
+    if (virNetDevGetIndex(master, &ifindex) < 0)
+        return -1;
+
+    val = ifindex;
+    return virNetDevLinkBatchAdd(batch, ifname, 0, 0, IFLA_MASTER,
+                                 sizeof(val), &val);
+}
+
+
+/**
+ * virNetDevLinkBatchSetOnline:
+ * @batch: batch to add the change to
+ * @ifname: interface name
+ * @online: true for up, false for down
+ *
+ * Queues changing the link state of @ifname, see virNetDevSetOnline().
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetDevLinkBatchSetOnline(virNetDevLinkBatch *batch,
+                            const char *ifname,
+                            bool online)
+{
+    return virNetDevLinkBatchAdd(batch, ifname, online ? IFF_UP : 0, IFF_UP,
+                                 0, 0, NULL);
+}
+
+
+/**
+ * virNetDevLinkBatchRun:
+ * @batch: batch to execute
+ *
+ * Sends all changes queued in @batch to the kernel at once. Changes are
+ * applied in the order they were queued; the first one which fails is
+ * reported, but the kernel carries on with the rest.
+ *
+ * Returns 0 on success,
+ *        -1 on error (with error reported),
+ *        -2 if netlink is not available (no error reported), in which
+ *           case callers should fall back to the individual helpers.
+ */
+int
+virNetDevLinkBatchRun(virNetDevLinkBatch *batch)
+{
+    virNetDevLinkBatchStats stats = { 0 };
+    unsigned long long start;
+    unsigned long long elapsed;
+    int rc;
+
+    if (batch->msgs->len == 0)
+        return 0;
+
+    start = g_get_monotonic_time();
+    rc = virNetlinkCommandBatch((struct nl_msg **) batch->msgs->pdata,
+                                batch->msgs->len, NULL, NETLINK_ROUTE, NULL);
+    if (rc == -2)
+        return -2;
+    elapsed = g_get_monotonic_time() - start;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&virNetDevLinkBatchStatsLock) {
+        virNetDevLinkBatchStatsTotal.batches++;
+        virNetDevLinkBatchStatsTotal.messages += batch->msgs->len;
+        if (rc < 0)
+            virNetDevLinkBatchStatsTotal.failed++;
+        virNetDevLinkBatchStatsTotal.totalUs += elapsed;
+        virNetDevLinkBatchStatsTotal.maxUs = MAX(virNetDevLinkBatchStatsTotal.maxUs,
+                                                 elapsed);
+        stats = virNetDevLinkBatchStatsTotal;
+    }
+
+    PROBE(NETDEV_LINK_BATCH_RUN,
+          "messages=%u ret=%d elapsed=%llu batches=%llu failed=%llu totalUs=%llu maxUs=%llu",
+          batch->msgs->len, rc, elapsed,
+          stats.batches, stats.failed, stats.totalUs, stats.maxUs);
+
+    return rc;
+}
+
+#else /* !defined(WITH_LIBNL) */
+
+int
+virNetDevLinkBatchSetMAC(virNetDevLinkBatch *batch G_GNUC_UNUSED,
+                         const char *ifname G_GNUC_UNUSED,
+                         const virMacAddr *macaddr G_GNUC_UNUSED)
+{
+    return 0;
+}
+
+
+int
+virNetDevLinkBatchSetMTU(virNetDevLinkBatch *batch G_GNUC_UNUSED,
+                         const char *ifname G_GNUC_UNUSED,
+                         unsigned int mtu G_GNUC_UNUSED)
+{
+    return 0;
+}
+
+
+int
+virNetDevLinkBatchSetMaster(virNetDevLinkBatch *batch G_GNUC_UNUSED,
+                            const char *ifname G_GNUC_UNUSED,
+                            const char *master G_GNUC_UNUSED)
+{
+    return 0;
+}
+
+
+int
+virNetDevLinkBatchSetOnline(virNetDevLinkBatch *batch G_GNUC_UNUSED,
+                            const char *ifname G_GNUC_UNUSED,
+                            bool online G_GNUC_UNUSED)
+{
+    return 0;
+}
+
+
+int
+virNetDevLinkBatchRun(virNetDevLinkBatch *batch G_GNUC_UNUSED)
+{
+    return -2;
+}
+
+#endif /* !defined(WITH_LIBNL) */
+
+
+/**
+ * virNetDevLinkBatchGetStats:
+ * @stats: filled in with the statistics
+ *
+ * Reports how many link configuration batches were sent to the kernel
+ * since the daemon started and how long that took. Each batch is also
+ * reported by the netdev_link_batch_run probe along with these totals.
+ */
+void
+virNetDevLinkBatchGetStats(virNetDevLinkBatchStats *stats)
+{
+    VIR_WITH_MUTEX_LOCK_GUARD(&virNetDevLinkBatchStatsLock) {
+        *stats = virNetDevLinkBatchStatsTotal;
+    }
+}
@@ -207,7 +207,7 @@ int virNetDevSetMTUFromDevice(const char *ifname,
                               const char *otherifname)
     ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
 int virNetDevGetMTU(const char *ifname)
-    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT G_NO_INLINE;
 int virNetDevSetNamespace(const char *ifname, pid_t pidInNs)
     ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
 int virNetDevSetName(const char *ifname, const char *newifname)
@@ -216,7 +216,7 @@ int virNetDevSetName(const char *ifname, const char *newifname)
 char *virNetDevGetName(int ifindex)
     G_GNUC_WARN_UNUSED_RESULT;
 int virNetDevGetIndex(const char *ifname, int *ifindex)
-    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT G_NO_INLINE;
 
 int virNetDevGetVLanID(const char *ifname, int *vlanid)
     ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
@@ -338,3 +338,40 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(virNetDevRxFilter, virNetDevRxFilterFree);
 void virNetDevReserveName(const char *name);
 
 int virNetDevGenerateName(char **ifname, virNetDevGenNameType type);
+
+typedef struct _virNetDevLinkBatch virNetDevLinkBatch;
+
+typedef struct _virNetDevLinkBatchStats virNetDevLinkBatchStats;
+struct _virNetDevLinkBatchStats {
+    unsigned long long batches;  /* batches sent to the kernel */
+    unsigned long long messages; /* netlink messages in those batches */
+    unsigned long long failed;   /* batches which failed */
+    unsigned long long totalUs;  /* time spent waiting for the kernel */
+    unsigned long long maxUs;    /* longest single batch */
+};
+
+virNetDevLinkBatch *virNetDevLinkBatchNew(void);
+void virNetDevLinkBatchFree(virNetDevLinkBatch *batch);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virNetDevLinkBatch, virNetDevLinkBatchFree);
+
+int virNetDevLinkBatchSetMAC(virNetDevLinkBatch *batch,
+                             const char *ifname,
+                             const virMacAddr *macaddr)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(3);
+int virNetDevLinkBatchSetMTU(virNetDevLinkBatch *batch,
+                             const char *ifname,
+                             unsigned int mtu)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2);
+int virNetDevLinkBatchSetMaster(virNetDevLinkBatch *batch,
+                                const char *ifname,
+                                const char *master)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(3);
+int virNetDevLinkBatchSetOnline(virNetDevLinkBatch *batch,
+                                const char *ifname,
+                                bool online)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2);
+int virNetDevLinkBatchRun(virNetDevLinkBatch *batch)
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT G_NO_INLINE;
+
+void virNetDevLinkBatchGetStats(virNetDevLinkBatchStats *stats)
+    ATTRIBUTE_NONNULL(1);
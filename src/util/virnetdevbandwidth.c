@@ -23,9 +23,22 @@
 #include "vircommand.h"
 #include "viralloc.h"
 #include "virerror.h"
+#include "virfile.h"
 #include "virlog.h"
+#include "virnetlink.h"
+#include "virstring.h"
+#include "virthread.h"
 #include "virutil.h"
 
+#if WITH_LIBNL
+# include <arpa/inet.h>
+# include <net/if.h>
+# include <linux/if_ether.h>
+# include <linux/pkt_cls.h>
+# include <linux/pkt_sched.h>
+# include <linux/rtnetlink.h>
+#endif
+
 #define VIR_FROM_THIS VIR_FROM_NONE
 
 VIR_LOG_INIT("util.netdevbandwidth");
@@ -41,9 +54,8 @@ virNetDevBandwidthFree(virNetDevBandwidth *def)
     g_free(def);
 }
 
-static void
-virNetDevBandwidthCmdAddOptimalQuantum(virCommand *cmd,
-                                       const virNetDevBandwidthRate *rate)
+static unsigned long long
+virNetDevBandwidthGetOptimalQuantum(const virNetDevBandwidthRate *rate)
 {
     const unsigned long long mtu = 1500;
     unsigned long long r2q;
@@ -60,16 +72,770 @@ virNetDevBandwidthCmdAddOptimalQuantum(virCommand *cmd,
     if (!r2q)
         r2q = 1;
 
+    return r2q;
+}
+
+
+/*
+ * Traffic control requests for a single interface are collected in
+ * a virNetDevBandwidthTC and then executed together by
+ * virNetDevBandwidthTCRun(), in one netlink transaction. Every
+ * request is kept as an equivalent tc(8) command line too, which is
+ * used if netlink is not available or if the kernel rejects the
+ * message.
+ */
+typedef struct _virNetDevBandwidthTC virNetDevBandwidthTC;
+struct _virNetDevBandwidthTC {
+    char *ifname;
+    GPtrArray *cmds; /* virCommand */
+    GArray *ignore; /* bool, failure of the request is not fatal */
+#if WITH_LIBNL
+    GPtrArray *msgs; /* virNetlinkMsg, in the same order as @cmds */
+#endif
+};
+
+
+static void
+virNetDevBandwidthTCFree(virNetDevBandwidthTC *tc)
+{
+    if (!tc)
+        return;
+
+    g_free(tc->ifname);
+    g_ptr_array_unref(tc->cmds);
+    g_array_unref(tc->ignore);
+#if WITH_LIBNL
+    g_ptr_array_unref(tc->msgs);
+#endif
+    g_free(tc);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virNetDevBandwidthTC, virNetDevBandwidthTCFree);
+
+
+static virNetDevBandwidthTC *
+virNetDevBandwidthTCNew(const char *ifname)
+{
+    virNetDevBandwidthTC *tc = g_new0(virNetDevBandwidthTC, 1);
+
+    tc->ifname = g_strdup(ifname);
+    tc->cmds = g_ptr_array_new_with_free_func((GDestroyNotify) virCommandFree);
+    tc->ignore = g_array_new(false, false, sizeof(bool));
+#if WITH_LIBNL
+    tc->msgs = g_ptr_array_new_with_free_func((GDestroyNotify) nlmsg_free);
+#endif
+
+    return tc;
+}
+
+
+static virCommand *
+virNetDevBandwidthTCAddCommand(virNetDevBandwidthTC *tc,
+                               bool ignoreError)
+{
+    virCommand *cmd = virCommandNew(TC);
+
+    g_ptr_array_add(tc->cmds, cmd);
+    g_array_append_val(tc->ignore, ignoreError);
+
+    return cmd;
+}
+
+
+#if WITH_LIBNL
+
+# define PROC_NET_PSCHED "/proc/net/psched"
+
+# define VIR_TC_HANDLE(major, minor) TC_H_MAKE((major) << 16, (minor))
+
+/* Packet scheduler clock as reported by any kernel since 2.6.31,
+ * refined from /proc/net/psched the same way tc(8) does it. */
+static double virNetDevBandwidthTickInUsec = 1000.0 / 64;
+static unsigned int virNetDevBandwidthHZ = 1000000000;
+
+static int
+virNetDevBandwidthPSchedOnceInit(void)
+{
+    g_autofree char *buf = NULL;
+    unsigned int t2us;
+    unsigned int us2t;
+    unsigned int clockRes;
+    unsigned int hz;
+
+    if (virFileReadAllQuiet(PROC_NET_PSCHED, 128, &buf) < 0 ||
+        sscanf(buf, "%08x %08x %08x %08x", &t2us, &us2t, &clockRes, &hz) != 4 ||
+        us2t == 0) {
+        VIR_DEBUG("Unable to parse %s, using defaults", PROC_NET_PSCHED);
+        return 0;
+    }
+
+    /* Kernels with nanosecond resolution advertise a tick multiplier
+     * of 1000 for compatibility with old tc binaries. */
+    if (clockRes == 1000000000)
+        t2us = us2t;
+
+    virNetDevBandwidthTickInUsec = (double) t2us / us2t * clockRes / 1000000;
+
+    if (clockRes == 1000000 && hz)
+        virNetDevBandwidthHZ = hz;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virNetDevBandwidthPSched);
+
+
+/* Time in scheduler ticks needed to send @size bytes at @rate bytes
+ * per second, i.e. tc_calc_xmittime() of tc(8). */
+static unsigned int
+virNetDevBandwidthXmitTime(unsigned long long rate,
+                           unsigned long long size)
+{
+    double usec;
+    double ticks;
+
+    if (!rate)
+        return 0;
+
+    usec = 1000000.0 * size / rate;
+    if (usec > UINT_MAX)
+        usec = UINT_MAX;
+
+    ticks = (unsigned int) usec * virNetDevBandwidthTickInUsec;
+    if (ticks > UINT_MAX)
+        return UINT_MAX;
+
+    return ticks;
+}
+
+
+static void
+virNetDevBandwidthCalcRateTable(struct tc_ratespec *spec,
+                                uint32_t *rtab,
+                                unsigned long long rate,
+                                unsigned int mtu)
+{
+    unsigned int cellLog = 0;
+    size_t i;
+
+    while ((mtu >> cellLog) > 255)
+        cellLog++;
+
+    spec->rate = MIN(rate, UINT32_MAX);
+    spec->cell_log = cellLog;
+    spec->cell_align = -1;
+    spec->linklayer = TC_LINKLAYER_ETHERNET;
+
+    for (i = 0; i < 256; i++)
+        rtab[i] = virNetDevBandwidthXmitTime(spec->rate, (i + 1) << cellLog);
+}
+
+
+/* The interface index is filled in by virNetDevBandwidthTCRun() */
+static virNetlinkMsg *
+virNetDevBandwidthTCMsgNew(int type,
+                           int flags,
+                           uint32_t parent,
+                           uint32_t handle,
+                           uint32_t info,
+                           const char *kind)
+{
+    struct tcmsg tcm = {
+        .tcm_family = AF_UNSPEC,
+        .tcm_parent = parent,
+        .tcm_handle = handle,
+        .tcm_info = info,
+    };
+    g_autoptr(virNetlinkMsg) msg = virNetlinkMsgNew(type, NLM_F_REQUEST | flags);
+
+    if (nlmsg_append(msg, &tcm, sizeof(tcm), NLMSG_ALIGNTO) < 0 ||
+        (kind && nla_put_string(msg, TCA_KIND, kind) < 0)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("allocated netlink buffer is too small"));
+        return NULL;
+    }
+
+    return g_steal_pointer(&msg);
+}
+
+
+static virNetlinkMsg *
+virNetDevBandwidthTCHTBQdiscMsg(unsigned int defcls)
+{
+    struct tc_htb_glob opt = {
+        .version = 3,
+        .rate2quantum = 10,
+        .defcls = defcls,
+    };
+    struct nlattr *options;
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWQDISC,
+                                           NLM_F_CREATE | NLM_F_EXCL,
+                                           TC_H_ROOT, VIR_TC_HANDLE(1, 0),
+                                           0, "htb")))
+        return NULL;
+
+    if (!(options = nla_nest_start(msg, TCA_OPTIONS)) ||
+        nla_put(msg, TCA_HTB_INIT, sizeof(opt), &opt) < 0)
+        goto buffer_too_small;
+    nla_nest_end(msg, options);
+
+    return g_steal_pointer(&msg);
+
+ buffer_too_small:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("allocated netlink buffer is too small"));
+    return NULL;
+}
+
+
+static virNetlinkMsg *
+virNetDevBandwidthTCSFQMsg(uint32_t parent,
+                           uint32_t handle)
+{
+    struct tc_sfq_qopt opt = { .perturb_period = 10 };
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWQDISC,
+                                           NLM_F_CREATE | NLM_F_EXCL,
+                                           parent, handle, 0, "sfq")))
+        return NULL;
+
+    if (nla_put(msg, TCA_OPTIONS, sizeof(opt), &opt) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("allocated netlink buffer is too small"));
+        return NULL;
+    }
+
+    return g_steal_pointer(&msg);
+}
+
+
+/* @rate and @ceil are in bytes per second, @burst in bytes */
+static virNetlinkMsg *
+virNetDevBandwidthTCClassMsg(bool create,
+                             uint32_t parent,
+                             uint32_t classid,
+                             unsigned long long rate,
+                             unsigned long long ceil,
+                             unsigned long long burst,
+                             unsigned int quantum)
+{
+    const unsigned int mtu = 1600;
+    struct tc_htb_opt opt = { .quantum = quantum };
+    uint32_t rtab[256];
+    uint32_t ctab[256];
+    struct nlattr *options;
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    ignore_value(virNetDevBandwidthPSchedInitialize());
+
+    /* Same defaults as tc(8) uses: the buffer must hold at least one
+     * MTU sized packet plus whatever can be sent during a jiffy. */
+    if (!burst)
+        burst = rate / virNetDevBandwidthHZ + mtu;
+
+    virNetDevBandwidthCalcRateTable(&opt.rate, rtab, rate, mtu);
+    opt.buffer = virNetDevBandwidthXmitTime(rate, burst);
+    virNetDevBandwidthCalcRateTable(&opt.ceil, ctab, ceil, mtu);
+    opt.cbuffer = virNetDevBandwidthXmitTime(ceil, ceil / virNetDevBandwidthHZ + mtu);
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWTCLASS,
+                                           create ? NLM_F_CREATE | NLM_F_EXCL : 0,
+                                           parent, classid, 0, "htb")))
+        return NULL;
+
+    if (!(options = nla_nest_start(msg, TCA_OPTIONS)) ||
+        (rate > UINT32_MAX && nla_put_u64(msg, TCA_HTB_RATE64, rate) < 0) ||
+        (ceil > UINT32_MAX && nla_put_u64(msg, TCA_HTB_CEIL64, ceil) < 0) ||
+        nla_put(msg, TCA_HTB_PARMS, sizeof(opt), &opt) < 0 ||
+        nla_put(msg, TCA_HTB_RTAB, sizeof(rtab), rtab) < 0 ||
+        nla_put(msg, TCA_HTB_CTAB, sizeof(ctab), ctab) < 0)
+        goto buffer_too_small;
+    nla_nest_end(msg, options);
+
+    return g_steal_pointer(&msg);
+
+ buffer_too_small:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("allocated netlink buffer is too small"));
+    return NULL;
+}
+
+
+static virNetlinkMsg *
+virNetDevBandwidthTCFwFilterMsg(void)
+{
+    struct nlattr *options;
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWTFILTER,
+                                           NLM_F_CREATE | NLM_F_EXCL,
+                                           VIR_TC_HANDLE(1, 0), 1,
+                                           TC_H_MAKE(1 << 16, htons(ETH_P_ALL)),
+                                           "fw")))
+        return NULL;
+
+    if (!(options = nla_nest_start(msg, TCA_OPTIONS)) ||
+        nla_put_u32(msg, TCA_FW_CLASSID, 1) < 0)
+        goto buffer_too_small;
+    nla_nest_end(msg, options);
+
+    return g_steal_pointer(&msg);
+
+ buffer_too_small:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("allocated netlink buffer is too small"));
+    return NULL;
+}
+
+
+/* @rate is in bytes per second, @burst in bytes */
+static virNetlinkMsg *
+virNetDevBandwidthTCPoliceFilterMsg(unsigned long long rate,
+                                    unsigned long long burst)
+{
+    struct tc_police police = {
+        .action = TC_POLICE_SHOT,
+        .mtu = 64 * 1024,
+    };
+    uint32_t rtab[256];
+    size_t selsize = sizeof(struct tc_u32_sel) + sizeof(struct tc_u32_key);
+    g_autofree struct tc_u32_sel *sel = g_malloc0(selsize);
+    struct nlattr *options;
+    struct nlattr *policeopts;
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    ignore_value(virNetDevBandwidthPSchedInitialize());
+
+    /* A single all-zero key matches every packet */
+    sel->flags = TC_U32_TERMINAL;
+    sel->nkeys = 1;
+
+    /* Like tc(8), the rate table is computed from the rate capped to
+     * 32 bits, the full rate goes into TCA_POLICE_RATE64. */
+    virNetDevBandwidthCalcRateTable(&police.rate, rtab, rate, police.mtu);
+    police.burst = virNetDevBandwidthXmitTime(rate, burst);
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWTFILTER,
+                                           NLM_F_CREATE | NLM_F_EXCL,
+                                           VIR_TC_HANDLE(0xffff, 0), 0,
+                                           TC_H_MAKE(0, htons(ETH_P_ALL)),
+                                           "u32")))
+        return NULL;
+
+    if (!(options = nla_nest_start(msg, TCA_OPTIONS)) ||
+        !(policeopts = nla_nest_start(msg, TCA_U32_POLICE)) ||
+        nla_put(msg, TCA_POLICE_TBF, sizeof(police), &police) < 0 ||
+        nla_put(msg, TCA_POLICE_RATE, sizeof(rtab), rtab) < 0 ||
+        (rate > UINT32_MAX &&
+         nla_put_u64(msg, TCA_POLICE_RATE64, rate) < 0))
+        goto buffer_too_small;
+    nla_nest_end(msg, policeopts);
+
+    if (nla_put_u32(msg, TCA_U32_CLASSID, 1) < 0 ||
+        nla_put(msg, TCA_U32_SEL, selsize, sel) < 0)
+        goto buffer_too_small;
+    nla_nest_end(msg, options);
+
+    return g_steal_pointer(&msg);
+
+ buffer_too_small:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("allocated netlink buffer is too small"));
+    return NULL;
+}
+
+
+static virNetlinkMsg *
+virNetDevBandwidthTCMacFilterMsg(uint32_t handle,
+                                 const virMacAddr *ifmac_ptr,
+                                 uint32_t classid)
+{
+    unsigned char ifmac[VIR_MAC_BUFLEN];
+    size_t selsize = sizeof(struct tc_u32_sel) + 3 * sizeof(struct tc_u32_key);
+    g_autofree struct tc_u32_sel *sel = g_malloc0(selsize);
+    struct nlattr *options;
+    g_autoptr(virNetlinkMsg) msg = NULL;
+
+    virMacAddrGetRaw(ifmac_ptr, ifmac);
+
+    /* Offsets are relative to the IP header and must be 32 bit
+     * aligned, so the 16 bit matches land in the lower halves of
+     * their words: the ethertype and the destination MAC address
+     * split into its last four and first two bytes. */
+    sel->flags = TC_U32_TERMINAL;
+    sel->nkeys = 3;
+    sel->keys[0].off = -4;
+    sel->keys[0].val = htonl(0x0800);
+    sel->keys[0].mask = htonl(0xffff);
+    sel->keys[1].off = -12;
+    sel->keys[1].val = htonl((uint32_t) ifmac[2] << 24 | ifmac[3] << 16 |
+                             ifmac[4] << 8 | ifmac[5]);
+    sel->keys[1].mask = 0xffffffff;
+    sel->keys[2].off = -16;
+    sel->keys[2].val = htonl(ifmac[0] << 8 | ifmac[1]);
+    sel->keys[2].mask = htonl(0xffff);
+
+    if (!(msg = virNetDevBandwidthTCMsgNew(RTM_NEWTFILTER,
+                                           NLM_F_CREATE | NLM_F_EXCL,
+                                           0, handle,
+                                           TC_H_MAKE(2 << 16, htons(ETH_P_IP)),
+                                           "u32")))
+        return NULL;
+
+    if (!(options = nla_nest_start(msg, TCA_OPTIONS)) ||
+        nla_put_u32(msg, TCA_U32_CLASSID, classid) < 0 ||
+        nla_put(msg, TCA_U32_SEL, selsize, sel) < 0)
+        goto buffer_too_small;
+    nla_nest_end(msg, options);
+
+    return g_steal_pointer(&msg);
+
+ buffer_too_small:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("allocated netlink buffer is too small"));
+    return NULL;
+}
+
+
+/* Attaches @msg to the request queued last */
+static int
+virNetDevBandwidthTCAddMsg(virNetDevBandwidthTC *tc,
+                           virNetlinkMsg *msg)
+{
+    if (!msg)
+        return -1;
+
+    g_ptr_array_add(tc->msgs, msg);
+    return 0;
+}
+
+
+/*
+ * Sends all requests of @tc to the kernel in one batch. The requests
+ * the kernel didn't accept are retried with tc(8), which knows how to
+ * talk to older kernels too.
+ *
+ * Returns: 0 on success,
+ *         -1 otherwise (with error reported),
+ *         -2 if netlink is not available (no error reported).
+ */
+static int
+virNetDevBandwidthTCRunNetlink(virNetDevBandwidthTC *tc)
+{
+    bool *ignore = (bool *) tc->ignore->data;
+    size_t n = tc->msgs->len;
+    g_autofree int *errors = g_new0(int, n);
+    size_t i;
+    int rc;
+
+    rc = virNetlinkCommandBatch((struct nl_msg **) tc->msgs->pdata,
+                                n, ignore, NETLINK_ROUTE, errors);
+    if (rc != -1)
+        return rc;
+
+    VIR_WARN("Falling back to %s on %s: %s",
+             TC, tc->ifname, virGetLastErrorMessage());
+    virResetLastError();
+
+    for (i = 0; i < n; i++) {
+        int status;
+
+        /* A failure the kernel replied with to a request whose
+         * errors are ignored would only repeat with tc(8) */
+        if (errors[i] == 0 || (ignore[i] && errors[i] < 0))
+            continue;
+
+        if (virCommandRun(tc->cmds->pdata[i], ignore[i] ? &status : NULL) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+#endif /* WITH_LIBNL */
+
+
+/**
+ * virNetDevBandwidthTCRun:
+ * @tc: requests to execute
+ *
+ * Execute all requests queued in @tc. They are sent to the kernel
+ * in one batch if possible, otherwise tc(8) is spawned for each of
+ * them. Failures of requests queued with @ignoreError are not
+ * fatal.
+ *
+ * Returns: 0 on success,
+ *         -1 otherwise (with error reported).
+ */
+static int
+virNetDevBandwidthTCRun(virNetDevBandwidthTC *tc)
+{
+    bool *ignore = (bool *) tc->ignore->data;
+    size_t i;
+
+#if WITH_LIBNL
+    unsigned int ifindex;
+    int rc;
+
+    if (!(ifindex = if_nametoindex(tc->ifname))) {
+        for (i = 0; i < tc->ignore->len; i++) {
+            if (!ignore[i])
+                break;
+        }
+
+        /* Nothing to clean up on a device which is gone already */
+        if (i == tc->ignore->len)
+            return 0;
+
+        virReportSystemError(errno,
+                             _("Unable to get index for interface %1$s"),
+                             tc->ifname);
+        return -1;
+    }
+
+    for (i = 0; i < tc->msgs->len; i++) {
+        struct tcmsg *tcm = nlmsg_data(nlmsg_hdr(tc->msgs->pdata[i]));
+
+        tcm->tcm_ifindex = ifindex;
+    }
+
+    if ((rc = virNetDevBandwidthTCRunNetlink(tc)) != -2)
+        return rc;
+
+    VIR_DEBUG("netlink is not available, falling back to %s", TC);
+#endif /* WITH_LIBNL */
+
+    for (i = 0; i < tc->cmds->len; i++) {
+        int status;
+
+        if (virCommandRun(tc->cmds->pdata[i], ignore[i] ? &status : NULL) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+virNetDevBandwidthTCClear(virNetDevBandwidthTC *tc)
+{
+    virCommand *cmd;
+
+    cmd = virNetDevBandwidthTCAddCommand(tc, true);
+    virCommandAddArgList(cmd, "qdisc", "del", "dev", tc->ifname, "root", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCMsgNew(RTM_DELQDISC, 0,
+                                       TC_H_ROOT, 0, 0, NULL)) < 0)
+        return -1;
+#endif
+
+    cmd = virNetDevBandwidthTCAddCommand(tc, true);
+    virCommandAddArgList(cmd, "qdisc", "del", "dev", tc->ifname, "ingress", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCMsgNew(RTM_DELQDISC, 0,
+                                       TC_H_INGRESS, VIR_TC_HANDLE(0xffff, 0),
+                                       0, "ingress")) < 0)
+        return -1;
+#endif
+
+    return 0;
+}
+
+
+static int
+virNetDevBandwidthTCRootQdisc(virNetDevBandwidthTC *tc,
+                              unsigned int defcls)
+{
+    virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, false);
+
+    virCommandAddArgList(cmd, "qdisc", "add", "dev", tc->ifname, "root",
+                         "handle", "1:", "htb", "default", NULL);
+    virCommandAddArgFormat(cmd, "%x", defcls);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCHTBQdiscMsg(defcls)) < 0)
+        return -1;
+#endif
+
+    return 0;
+}
+
+
+/**
+ * virNetDevBandwidthTCClass:
+ * @tc: requests for the interface
+ * @create: whether to add a new class or change an existing one
+ * @parent: minor number of the parent class, 0 for the root qdisc
+ * @classid: minor number of the class
+ * @rate: guaranteed rate in kB/s
+ * @ceil: maximum rate in kB/s, 0 to use @rate
+ * @burst: burst size in kB, 0 to use the default
+ * @quantum: HTB quantum in bytes
+ *
+ * Queue a request to add (or change) HTB class 1:@classid. The
+ * @parent is ignored when changing a class.
+ */
+static int
+virNetDevBandwidthTCClass(virNetDevBandwidthTC *tc,
+                          bool create,
+                          unsigned int parent,
+                          unsigned int classid,
+                          unsigned long long rate,
+                          unsigned long long ceil,
+                          unsigned long long burst,
+                          unsigned long long quantum)
+{
+    virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, false);
+    g_autofree char *classidStr = g_strdup_printf("1:%x", classid);
+
+    if (create) {
+        g_autofree char *parentStr = NULL;
+
+        if (parent)
+            parentStr = g_strdup_printf("1:%x", parent);
+        else
+            parentStr = g_strdup("1:");
+
+        virCommandAddArgList(cmd, "class", "add", "dev", tc->ifname,
+                             "parent", parentStr, NULL);
+    } else {
+        virCommandAddArgList(cmd, "class", "change", "dev", tc->ifname, NULL);
+    }
+
+    virCommandAddArgList(cmd, "classid", classidStr, "htb", "rate", NULL);
+    virCommandAddArgFormat(cmd, "%llukbps", rate);
+    if (ceil) {
+        virCommandAddArg(cmd, "ceil");
+        virCommandAddArgFormat(cmd, "%llukbps", ceil);
+    }
+    if (burst) {
+        virCommandAddArg(cmd, "burst");
+        virCommandAddArgFormat(cmd, "%llukb", burst);
+    }
     virCommandAddArg(cmd, "quantum");
-    virCommandAddArgFormat(cmd, "%llu", r2q);
+    virCommandAddArgFormat(cmd, "%llu", quantum);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCClassMsg(create,
+                                         create ? VIR_TC_HANDLE(1, parent) : 0,
+                                         VIR_TC_HANDLE(1, classid),
+                                         rate * 1000,
+                                         (ceil ? ceil : rate) * 1000,
+                                         burst * 1024,
+                                         MIN(quantum, UINT32_MAX))) < 0)
+        return -1;
+#endif
+
+    return 0;
+}
+
+
+static int
+virNetDevBandwidthTCSFQ(virNetDevBandwidthTC *tc,
+                        unsigned int parent,
+                        unsigned int handle)
+{
+    virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, false);
+    g_autofree char *parentStr = g_strdup_printf("1:%x", parent);
+    g_autofree char *handleStr = g_strdup_printf("%x:", handle);
+
+    virCommandAddArgList(cmd, "qdisc", "add", "dev", tc->ifname, "parent",
+                         parentStr, "handle", handleStr, "sfq", "perturb",
+                         "10", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCSFQMsg(VIR_TC_HANDLE(1, parent),
+                                       VIR_TC_HANDLE(handle, 0))) < 0)
+        return -1;
+#endif
+
+    return 0;
+}
+
+
+static int
+virNetDevBandwidthTCFwFilter(virNetDevBandwidthTC *tc)
+{
+    virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, false);
+
+    virCommandAddArgList(cmd, "filter", "add", "dev", tc->ifname, "parent",
+                         "1:0", "protocol", "all", "prio", "1", "handle",
+                         "1", "fw", "flowid", "1", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc, virNetDevBandwidthTCFwFilterMsg()) < 0)
+        return -1;
+#endif
+
+    return 0;
+}
+
+
+/**
+ * virNetDevBandwidthTCIngress:
+ * @tc: requests for the interface
+ * @rate: rate in kB/s
+ * @burst: burst size in kB
+ *
+ * Queue requests to add the ingress qdisc and a filter policing all
+ * incoming traffic to @rate.
+ */
+static int
+virNetDevBandwidthTCIngress(virNetDevBandwidthTC *tc,
+                            unsigned long long rate,
+                            unsigned long long burst)
+{
+    virCommand *cmd;
+    g_autofree char *rateStr = g_strdup_printf("%llukbps", rate);
+    g_autofree char *burstStr = g_strdup_printf("%llukb", burst);
+
+    cmd = virNetDevBandwidthTCAddCommand(tc, false);
+    virCommandAddArgList(cmd, "qdisc", "add", "dev", tc->ifname,
+                         "ingress", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCMsgNew(RTM_NEWQDISC,
+                                       NLM_F_CREATE | NLM_F_EXCL,
+                                       TC_H_INGRESS, VIR_TC_HANDLE(0xffff, 0),
+                                       0, "ingress")) < 0)
+        return -1;
+#endif
+
+    /* Set filter to match all ingress traffic */
+    cmd = virNetDevBandwidthTCAddCommand(tc, false);
+    virCommandAddArgList(cmd, "filter", "add", "dev", tc->ifname, "parent",
+                         "ffff:", "protocol", "all", "u32", "match", "u32",
+                         "0", "0", "police", "rate", rateStr,
+                         "burst", burstStr, "mtu", "64kb", "drop", "flowid",
+                         ":1", NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCPoliceFilterMsg(rate * 1000, burst * 1024)) < 0)
+        return -1;
+#endif
+
+    return 0;
 }
 
+
 /**
  * virNetDevBandwidthManipulateFilter:
- * @ifname: interface to operate on
+ * @tc: requests for the interface to operate on
  * @ifmac_ptr: MAC of the interface to create filter over
  * @id: filter ID
- * @class_id: where to place traffic
+ * @class_id: minor number of the class where to place traffic
  * @remove_old: whether to remove the filter
  * @create_new: whether to create the filter
  *
@@ -81,11 +847,11 @@ virNetDevBandwidthCmdAddOptimalQuantum(virCommand *cmd,
  * bridge) and filter the traffic into QDiscs based on the
  * originating vNET device.
  *
- * Long story short, @ifname is the interface where the filter
- * should be created. The @ifmac_ptr is the MAC address for which
+ * Long story short, @tc holds requests for the interface where the
+ * filter should be created. The @ifmac_ptr is the MAC address for which
  * the filter should be created (usually different to the MAC
- * address of @ifname). Then, like everything - even filters have
- * an @id which should be unique (per @ifname). And @class_id
+ * address of the interface). Then, like everything - even filters have
+ * an @id which should be unique (per interface). And @class_id
  * tells into which QDisc should filter place the traffic.
  *
  * This function can be used for both, removing stale filter
@@ -96,22 +862,24 @@ virNetDevBandwidthCmdAddOptimalQuantum(virCommand *cmd,
  *         -1 otherwise (with error reported).
  */
 static int ATTRIBUTE_NONNULL(1)
-virNetDevBandwidthManipulateFilter(const char *ifname,
+virNetDevBandwidthManipulateFilter(virNetDevBandwidthTC *tc,
                                    const virMacAddr *ifmac_ptr,
                                    unsigned int id,
-                                   const char *class_id,
+                                   unsigned int class_id,
                                    bool remove_old,
                                    bool create_new)
 {
-    int ret = -1;
     g_autofree char *filter_id = NULL;
-    unsigned char ifmac[VIR_MAC_BUFLEN];
-    char *mac[2] = {NULL, NULL};
+#if WITH_LIBNL
+    g_autofree char *node = NULL;
+    unsigned int nodeid;
+    uint32_t handle;
+#endif
 
     if (!(remove_old || create_new)) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                        _("filter creation API error"));
-        goto cleanup;
+        return -1;
     }
 
     /* u32 filters must have 800:: prefix. Don't ask. Furthermore, handles
@@ -119,47 +887,68 @@ virNetDevBandwidthManipulateFilter(const char *ifname,
      *   800::(800 + id) */
     filter_id = g_strdup_printf("800::%u", 800 + id);
 
+#if WITH_LIBNL
+    /* tc(8) reads the node part of the handle as hexadecimal. Keep
+     * doing the same so that filters created by either can be removed
+     * by the other. */
+    node = g_strdup_printf("%u", 800 + id);
+    if (virStrToLong_ui(node, NULL, 16, &nodeid) < 0 ||
+        nodeid > TC_U32_NODE(~0U)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Invalid filter ID %1$u"), id);
+        return -1;
+    }
+    handle = TC_U32_HTID(0x800 << 20) | nodeid;
+#endif
+
     if (remove_old) {
-        g_autoptr(virCommand) cmd = virCommandNew(TC);
-        int cmd_ret = 0;
+        virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, true);
 
-        virCommandAddArgList(cmd, "filter", "del", "dev", ifname,
+        virCommandAddArgList(cmd, "filter", "del", "dev", tc->ifname,
                              "prio", "2", "handle",  filter_id, "u32", NULL);
 
-        if (virCommandRun(cmd, &cmd_ret) < 0)
-            goto cleanup;
-
+#if WITH_LIBNL
+        if (virNetDevBandwidthTCAddMsg(tc,
+                virNetDevBandwidthTCMsgNew(RTM_DELTFILTER, 0, 0, handle,
+                                           TC_H_MAKE(2 << 16, 0), "u32")) < 0)
+            return -1;
+#endif
     }
 
     if (create_new) {
-        g_autoptr(virCommand) cmd = virCommandNew(TC);
+        virCommand *cmd = virNetDevBandwidthTCAddCommand(tc, false);
+        g_autofree char *class_str = g_strdup_printf("1:%x", class_id);
+        g_autofree char *mac0 = NULL;
+        g_autofree char *mac1 = NULL;
+        unsigned char ifmac[VIR_MAC_BUFLEN];
+
         virMacAddrGetRaw(ifmac_ptr, ifmac);
 
-        mac[0] = g_strdup_printf("0x%02x%02x%02x%02x", ifmac[2],
-                                 ifmac[3], ifmac[4], ifmac[5]);
-        mac[1] = g_strdup_printf("0x%02x%02x", ifmac[0], ifmac[1]);
+        mac0 = g_strdup_printf("0x%02x%02x%02x%02x", ifmac[2],
+                               ifmac[3], ifmac[4], ifmac[5]);
+        mac1 = g_strdup_printf("0x%02x%02x", ifmac[0], ifmac[1]);
 
         /* Okay, this not nice. But since libvirt does not necessarily track
          * interface IP address(es), and tc fw filter simply refuse to use
          * ebtables marks, we need to use u32 selector to match MAC address.
          * If libvirt will ever know something, remove this FIXME
          */
-        virCommandAddArgList(cmd, "filter", "add", "dev", ifname, "protocol", "ip",
+        virCommandAddArgList(cmd, "filter", "add", "dev", tc->ifname, "protocol", "ip",
                              "prio", "2", "handle", filter_id, "u32",
                              "match", "u16", "0x0800", "0xffff", "at", "-2",
-                             "match", "u32", mac[0], "0xffffffff", "at", "-12",
-                             "match", "u16", mac[1], "0xffff", "at", "-14",
-                             "flowid", class_id, NULL);
-
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
+                             "match", "u32", mac0, "0xffffffff", "at", "-12",
+                             "match", "u16", mac1, "0xffff", "at", "-14",
+                             "flowid", class_str, NULL);
+
+#if WITH_LIBNL
+        if (virNetDevBandwidthTCAddMsg(tc,
+                virNetDevBandwidthTCMacFilterMsg(handle, ifmac_ptr,
+                                                 VIR_TC_HANDLE(1, class_id))) < 0)
+            return -1;
+#endif
     }
 
-    ret = 0;
- cleanup:
-    VIR_FREE(mac[1]);
-    VIR_FREE(mac[0]);
-    return ret;
+    return 0;
 }
 
 
@@ -192,18 +981,13 @@ virNetDevBandwidthSet(const char *ifname,
                       bool hierarchical_class,
                       bool swapped)
 {
-    int ret = -1;
     virNetDevBandwidthRate *rx = NULL; /* From domain POV */
     virNetDevBandwidthRate *tx = NULL; /* From domain POV */
-    virCommand *cmd = NULL;
-    char *average = NULL;
-    char *peak = NULL;
-    char *burst = NULL;
+    g_autoptr(virNetDevBandwidthTC) tc = NULL;
 
     if (!bandwidth) {
         /* nothing to be enabled */
-        ret = 0;
-        goto cleanup;
+        return 0;
     }
 
     if (geteuid() != 0) {
@@ -226,21 +1010,16 @@ virNetDevBandwidthSet(const char *ifname,
         tx = bandwidth->out;
     }
 
-    virNetDevBandwidthClear(ifname);
+    tc = virNetDevBandwidthTCNew(ifname);
+
+    if (virNetDevBandwidthTCClear(tc) < 0)
+        return -1;
 
     if (tx && tx->average) {
-        average = g_strdup_printf("%llukbps", tx->average);
-        if (tx->peak)
-            peak = g_strdup_printf("%llukbps", tx->peak);
-        if (tx->burst)
-            burst = g_strdup_printf("%llukb", tx->burst);
-
-        cmd = virCommandNew(TC);
-        virCommandAddArgList(cmd, "qdisc", "add", "dev", ifname, "root",
-                             "handle", "1:", "htb", "default",
-                             hierarchical_class ? "2" : "1", NULL);
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
+        unsigned long long quantum = virNetDevBandwidthGetOptimalQuantum(tx);
+
+        if (virNetDevBandwidthTCRootQdisc(tc, hierarchical_class ? 2 : 1) < 0)
+            return -1;
 
         /* If we are creating a hierarchical class, all non guaranteed traffic
          * goes to the 1:2 class which will adjust 'rate' dynamically as NICs
@@ -305,99 +1084,41 @@ virNetDevBandwidthSet(const char *ifname,
          * This description is rather long, but it is still a good idea to read
          * it before you dig into the code.
          */
-        if (hierarchical_class) {
-            virCommandFree(cmd);
-            cmd = virCommandNew(TC);
-            virCommandAddArgList(cmd, "class", "add", "dev", ifname, "parent",
-                                 "1:", "classid", "1:1", "htb", "rate", average,
-                                 "ceil", peak ? peak : average, NULL);
-            virNetDevBandwidthCmdAddOptimalQuantum(cmd, tx);
-            if (virCommandRun(cmd, NULL) < 0)
-                goto cleanup;
-        }
-        virCommandFree(cmd);
-        cmd = virCommandNew(TC);
-        virCommandAddArgList(cmd, "class", "add", "dev", ifname, "parent",
-                             hierarchical_class ? "1:1" : "1:", "classid",
-                             hierarchical_class ? "1:2" : "1:1", "htb",
-                             "rate", average, NULL);
-
-        if (peak)
-            virCommandAddArgList(cmd, "ceil", peak, NULL);
-        if (burst)
-            virCommandAddArgList(cmd, "burst", burst, NULL);
-
-        virNetDevBandwidthCmdAddOptimalQuantum(cmd, tx);
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
-
-        virCommandFree(cmd);
-        cmd = virCommandNew(TC);
-        virCommandAddArgList(cmd, "qdisc", "add", "dev", ifname, "parent",
-                             hierarchical_class ? "1:2" : "1:1",
-                             "handle", "2:", "sfq", "perturb",
-                             "10", NULL);
-
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
-
-        virCommandFree(cmd);
-        cmd = virCommandNew(TC);
-        virCommandAddArgList(cmd, "filter", "add", "dev", ifname, "parent",
-                             "1:0", "protocol", "all", "prio", "1", "handle",
-                             "1", "fw", "flowid", "1", NULL);
-
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
-
-        VIR_FREE(average);
-        VIR_FREE(peak);
-        VIR_FREE(burst);
+        if (hierarchical_class &&
+            virNetDevBandwidthTCClass(tc, true, 0, 1, tx->average,
+                                      tx->peak ? tx->peak : tx->average,
+                                      0, quantum) < 0)
+            return -1;
+
+        if (virNetDevBandwidthTCClass(tc, true,
+                                      hierarchical_class ? 1 : 0,
+                                      hierarchical_class ? 2 : 1,
+                                      tx->average, tx->peak, tx->burst,
+                                      quantum) < 0)
+            return -1;
+
+        if (virNetDevBandwidthTCSFQ(tc, hierarchical_class ? 2 : 1, 2) < 0)
+            return -1;
+
+        if (virNetDevBandwidthTCFwFilter(tc) < 0)
+            return -1;
     }
 
     if (rx) {
-        average = g_strdup_printf("%llukbps", rx->average);
+        unsigned long long burst = rx->burst;
 
-        if (rx->burst) {
-            burst = g_strdup_printf("%llukb", rx->burst);
-        } else {
+        if (!burst) {
             /* Internally, tc uses uint to store burst size (in bytes).
              * Therefore, the largest value we can set is UINT_MAX bytes.
              * We're outputting the vale in KiB though. */
-            unsigned long long avg = MIN(rx->average, UINT_MAX / 1024);
-
-            burst = g_strdup_printf("%llukb", avg);
+            burst = MIN(rx->average, UINT_MAX / 1024);
         }
 
-        virCommandFree(cmd);
-        cmd = virCommandNew(TC);
-            virCommandAddArgList(cmd, "qdisc", "add", "dev", ifname,
-                                 "ingress", NULL);
-
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
-
-        virCommandFree(cmd);
-        cmd = virCommandNew(TC);
-        /* Set filter to match all ingress traffic */
-        virCommandAddArgList(cmd, "filter", "add", "dev", ifname, "parent",
-                             "ffff:", "protocol", "all", "u32", "match", "u32",
-                             "0", "0", "police", "rate", average,
-                             "burst", burst, "mtu", "64kb", "drop", "flowid",
-                             ":1", NULL);
-
-        if (virCommandRun(cmd, NULL) < 0)
-            goto cleanup;
+        if (virNetDevBandwidthTCIngress(tc, rx->average, burst) < 0)
+            return -1;
     }
 
-    ret = 0;
-
- cleanup:
-    virCommandFree(cmd);
-    VIR_FREE(average);
-    VIR_FREE(peak);
-    VIR_FREE(burst);
-    return ret;
+    return virNetDevBandwidthTCRun(tc);
 }
 
 /**
@@ -413,27 +1134,17 @@ virNetDevBandwidthSet(const char *ifname,
 int
 virNetDevBandwidthClear(const char *ifname)
 {
-    int ret = 0;
-    int dummy; /* for ignoring the exit status */
-    g_autoptr(virCommand) rootcmd = NULL;
-    g_autoptr(virCommand) ingresscmd = NULL;
+    g_autoptr(virNetDevBandwidthTC) tc = NULL;
 
     if (!ifname)
        return 0;
 
-    rootcmd = virCommandNew(TC);
-    virCommandAddArgList(rootcmd, "qdisc", "del", "dev", ifname, "root", NULL);
-
-    if (virCommandRun(rootcmd, &dummy) < 0)
-        ret = -1;
+    tc = virNetDevBandwidthTCNew(ifname);
 
-    ingresscmd = virCommandNew(TC);
-    virCommandAddArgList(ingresscmd, "qdisc",  "del", "dev", ifname, "ingress", NULL);
-
-    if (virCommandRun(ingresscmd, &dummy) < 0)
-        ret = -1;
+    if (virNetDevBandwidthTCClear(tc) < 0)
+        return -1;
 
-    return ret;
+    return virNetDevBandwidthTCRun(tc);
 }
 
 /*
@@ -537,12 +1248,7 @@ virNetDevBandwidthPlug(const char *brname,
                        virNetDevBandwidth *bandwidth,
                        unsigned int id)
 {
-    g_autoptr(virCommand) cmd1 = NULL;
-    g_autoptr(virCommand) cmd2 = NULL;
-    g_autofree char *class_id = NULL;
-    g_autofree char *qdisc_id = NULL;
-    g_autofree char *floor = NULL;
-    g_autofree char *ceil = NULL;
+    g_autoptr(virNetDevBandwidthTC) tc = NULL;
     char ifmacStr[VIR_MAC_STRING_BUFLEN];
 
     if (id <= 2) {
@@ -559,35 +1265,24 @@ virNetDevBandwidthPlug(const char *brname,
         return -1;
     }
 
-    class_id = g_strdup_printf("1:%x", id);
-    qdisc_id = g_strdup_printf("%x:", id);
-    floor = g_strdup_printf("%llukbps", bandwidth->in->floor);
-    ceil = g_strdup_printf("%llukbps", net_bandwidth->in->peak ?
-                           net_bandwidth->in->peak :
-                           net_bandwidth->in->average);
-
-    cmd1 = virCommandNew(TC);
-    virCommandAddArgList(cmd1, "class", "add", "dev", brname, "parent", "1:1",
-                         "classid", class_id, "htb", "rate", floor,
-                         "ceil", ceil, NULL);
-    virNetDevBandwidthCmdAddOptimalQuantum(cmd1, bandwidth->in);
-
-    if (virCommandRun(cmd1, NULL) < 0)
-        return -1;
+    tc = virNetDevBandwidthTCNew(brname);
 
-    cmd2 = virCommandNew(TC);
-    virCommandAddArgList(cmd2, "qdisc", "add", "dev", brname, "parent",
-                         class_id, "handle", qdisc_id, "sfq", "perturb",
-                         "10", NULL);
+    if (virNetDevBandwidthTCClass(tc, true, 1, id, bandwidth->in->floor,
+                                  net_bandwidth->in->peak ?
+                                  net_bandwidth->in->peak :
+                                  net_bandwidth->in->average,
+                                  0,
+                                  virNetDevBandwidthGetOptimalQuantum(bandwidth->in)) < 0)
+        return -1;
 
-    if (virCommandRun(cmd2, NULL) < 0)
+    if (virNetDevBandwidthTCSFQ(tc, id, id) < 0)
         return -1;
 
-    if (virNetDevBandwidthManipulateFilter(brname, ifmac_ptr, id,
-                                           class_id, false, true) < 0)
+    if (virNetDevBandwidthManipulateFilter(tc, ifmac_ptr, id,
+                                           id, false, true) < 0)
         return -1;
 
-    return 0;
+    return virNetDevBandwidthTCRun(tc);
 }
 
 /*
@@ -603,11 +1298,10 @@ int
 virNetDevBandwidthUnplug(const char *brname,
                          unsigned int id)
 {
-    int cmd_ret = 0;
-    g_autoptr(virCommand) cmd1 = NULL;
-    g_autoptr(virCommand) cmd2 = NULL;
+    g_autoptr(virNetDevBandwidthTC) tc = NULL;
     g_autofree char *class_id = NULL;
     g_autofree char *qdisc_id = NULL;
+    virCommand *cmd;
 
     if (id <= 2) {
         virReportError(VIR_ERR_INTERNAL_ERROR, _("Invalid class ID %1$d"), id);
@@ -617,27 +1311,38 @@ virNetDevBandwidthUnplug(const char *brname,
     class_id = g_strdup_printf("1:%x", id);
     qdisc_id = g_strdup_printf("%x:", id);
 
-    cmd1 = virCommandNew(TC);
-    virCommandAddArgList(cmd1, "qdisc", "del", "dev", brname,
-                         "handle", qdisc_id, NULL);
+    tc = virNetDevBandwidthTCNew(brname);
 
     /* Don't threat tc errors as fatal, but
      * try to remove as much as possible */
-    if (virCommandRun(cmd1, &cmd_ret) < 0)
+    cmd = virNetDevBandwidthTCAddCommand(tc, true);
+    virCommandAddArgList(cmd, "qdisc", "del", "dev", brname,
+                         "handle", qdisc_id, NULL);
+
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCMsgNew(RTM_DELQDISC, 0,
+                                       VIR_TC_HANDLE(1, id),
+                                       VIR_TC_HANDLE(id, 0), 0, NULL)) < 0)
         return -1;
+#endif
 
-    if (virNetDevBandwidthManipulateFilter(brname, NULL, id,
-                                           NULL, true, false) < 0)
+    if (virNetDevBandwidthManipulateFilter(tc, NULL, id,
+                                           0, true, false) < 0)
         return -1;
 
-    cmd2 = virCommandNew(TC);
-    virCommandAddArgList(cmd2, "class", "del", "dev", brname,
+    cmd = virNetDevBandwidthTCAddCommand(tc, true);
+    virCommandAddArgList(cmd, "class", "del", "dev", brname,
                          "classid", class_id, NULL);
 
-    if (virCommandRun(cmd2, &cmd_ret) < 0)
+#if WITH_LIBNL
+    if (virNetDevBandwidthTCAddMsg(tc,
+            virNetDevBandwidthTCMsgNew(RTM_DELTCLASS, 0, 0,
+                                       VIR_TC_HANDLE(1, id), 0, NULL)) < 0)
         return -1;
+#endif
 
-    return 0;
+    return virNetDevBandwidthTCRun(tc);
 }
 
 /**
@@ -660,24 +1365,17 @@ virNetDevBandwidthUpdateRate(const char *ifname,
                              virNetDevBandwidth *bandwidth,
                              unsigned long long new_rate)
 {
-    g_autoptr(virCommand) cmd = NULL;
-    g_autofree char *class_id = NULL;
-    g_autofree char *rate = NULL;
-    g_autofree char *ceil = NULL;
-
-    class_id = g_strdup_printf("1:%x", id);
-    rate = g_strdup_printf("%llukbps", new_rate);
-    ceil = g_strdup_printf("%llukbps", bandwidth->in->peak ?
-                           bandwidth->in->peak :
-                           bandwidth->in->average);
-
-    cmd = virCommandNew(TC);
-    virCommandAddArgList(cmd, "class", "change", "dev", ifname,
-                         "classid", class_id, "htb", "rate", rate,
-                         "ceil", ceil, NULL);
-    virNetDevBandwidthCmdAddOptimalQuantum(cmd, bandwidth->in);
+    g_autoptr(virNetDevBandwidthTC) tc = virNetDevBandwidthTCNew(ifname);
+
+    if (virNetDevBandwidthTCClass(tc, false, 0, id, new_rate,
+                                  bandwidth->in->peak ?
+                                  bandwidth->in->peak :
+                                  bandwidth->in->average,
+                                  0,
+                                  virNetDevBandwidthGetOptimalQuantum(bandwidth->in)) < 0)
+        return -1;
 
-    return virCommandRun(cmd, NULL);
+    return virNetDevBandwidthTCRun(tc);
 }
 
 /**
@@ -702,19 +1400,13 @@ virNetDevBandwidthUpdateFilter(const char *ifname,
                                const virMacAddr *ifmac_ptr,
                                unsigned int id)
 {
-    int ret = -1;
-    char *class_id = NULL;
+    g_autoptr(virNetDevBandwidthTC) tc = virNetDevBandwidthTCNew(ifname);
 
-    class_id = g_strdup_printf("1:%x", id);
-
-    if (virNetDevBandwidthManipulateFilter(ifname, ifmac_ptr, id,
-                                           class_id, true, true) < 0)
-        goto cleanup;
+    if (virNetDevBandwidthManipulateFilter(tc, ifmac_ptr, id,
+                                           id, true, true) < 0)
+        return -1;
 
-    ret = 0;
- cleanup:
-    VIR_FREE(class_id);
-    return ret;
+    return virNetDevBandwidthTCRun(tc);
 }
 
 
@@ -63,7 +63,7 @@ int virNetDevBridgePortGetLearning(const char *brname,
 int virNetDevBridgePortSetLearning(const char *brname,
                                    const char *ifname,
                                    bool enable)
-    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT G_NO_INLINE;
 int virNetDevBridgePortGetUnicastFlood(const char *brname,
                                        const char *ifname,
                                        bool *enable)
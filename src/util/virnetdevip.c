@@ -844,6 +844,33 @@ virNetDevIPInfoClear(virNetDevIPInfo *ip)
 }
 
 
+/**
+ * virNetDevIPInfoCopy:
+ * @dst: IP info to fill, must be empty
+ * @src: IP info to copy
+ *
+ * Deep-copies the addresses and routes of @src into @dst.
+ */
+void
+virNetDevIPInfoCopy(virNetDevIPInfo *dst,
+                    const virNetDevIPInfo *src)
+{
+    size_t i;
+
+    dst->ips = g_new0(virNetDevIPAddr *, src->nips);
+    dst->nips = src->nips;
+    for (i = 0; i < src->nips; i++)
+        dst->ips[i] = g_memdup(src->ips[i], sizeof(*src->ips[i]));
+
+    dst->routes = g_new0(virNetDevIPRoute *, src->nroutes);
+    dst->nroutes = src->nroutes;
+    for (i = 0; i < src->nroutes; i++) {
+        dst->routes[i] = g_memdup(src->routes[i], sizeof(*src->routes[i]));
+        dst->routes[i]->family = g_strdup(src->routes[i]->family);
+    }
+}
+
+
 /**
  * virNetDevIPInfoAddToDev:
  * @ifname: name of device to operate on
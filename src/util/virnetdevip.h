@@ -85,6 +85,8 @@ virSocketAddr *virNetDevIPRouteGetGateway(virNetDevIPRoute *def);
 
 /* virNetDevIPInfo object */
 void virNetDevIPInfoClear(virNetDevIPInfo *ip);
+void virNetDevIPInfoCopy(virNetDevIPInfo *dst,
+                         const virNetDevIPInfo *src);
 int virNetDevIPInfoAddToDev(const char *ifname,
                             virNetDevIPInfo const *ipInfo);
 
@@ -85,7 +85,8 @@ virNetDevMacVLanIsMacvtap(const char *ifname)
  * @macvlan_mode: The macvlan mode to use
  * @flags: OR of virNetDevMacVLanCreateFlags.
  *
- * Create a macvtap device with the given properties.
+ * Create a macvtap device with the given properties. With
+ * VIR_NETDEV_MACVLAN_CREATE_IFUP the device is brought up too.
  *
  * Returns 0 on success, -1 on fatal error.
  */
@@ -103,6 +104,7 @@ virNetDevMacVLanCreate(const char *ifname,
     virNetlinkNewLinkData data = {
         .macvlan_mode = &macvlan_mode,
         .mac = macaddress,
+        .online = !!(flags & VIR_NETDEV_MACVLAN_CREATE_IFUP),
     };
 
     if (virNetDevGetIndex(srcdev, &ifindex) < 0)
@@ -665,6 +667,7 @@ virNetDevMacVLanCreateWithVPortProfile(const char *ifnameRequested,
     uint32_t macvtapMode;
     int vf = -1;
     bool vnet_hdr = flags & VIR_NETDEV_MACVLAN_VNET_HDR;
+    unsigned int createFlags = flags;
     virNetDevGenNameType type;
 
     macvtapMode = modeMap[mode];
@@ -708,9 +711,14 @@ virNetDevMacVLanCreateWithVPortProfile(const char *ifnameRequested,
     else
         type = VIR_NET_DEV_GEN_NAME_MACVLAN;
 
+    /* Unless the port needs to be associated first, bring the device up
+     * as part of creating it. */
+    if (virtPortProfile)
+        createFlags &= ~VIR_NETDEV_MACVLAN_CREATE_IFUP;
+
     if (virNetDevGenerateName(&ifname, type) < 0 ||
         virNetDevMacVLanCreate(ifname, macaddress,
-                               linkdev, macvtapMode, flags) < 0) {
+                               linkdev, macvtapMode, createFlags) < 0) {
         return -1;
     }
 
@@ -723,7 +731,7 @@ virNetDevMacVLanCreateWithVPortProfile(const char *ifnameRequested,
         goto link_del_exit;
     }
 
-    if (flags & VIR_NETDEV_MACVLAN_CREATE_IFUP) {
+    if ((flags & VIR_NETDEV_MACVLAN_CREATE_IFUP) && virtPortProfile) {
         if (virNetDevSetOnline(ifname, true) < 0)
             goto disassociate_exit;
     }
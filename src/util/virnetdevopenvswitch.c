@@ -22,6 +22,7 @@
 
 
 #include "virnetdevopenvswitch.h"
+#include "virovsdb.h"
 #include "vircommand.h"
 #include "viralloc.h"
 #include "virerror.h"
@@ -53,6 +54,22 @@ virNetDevOpenvswitchSetTimeout(unsigned int timeout)
     virNetDevOpenvswitchTimeout = timeout;
 }
 
+/*
+ * Returns the connection to ovsdb-server, or NULL if ovs-vsctl has to
+ * be used. Operations on the connection return -2 if ovsdb-server turns
+ * out not to be reachable, in which case ovs-vsctl is used as well.
+ */
+static virOVSDBClient *
+virNetDevOpenvswitchGetOVSDB(void)
+{
+    virOVSDBClient *client = virOVSDBGetDefault();
+
+    if (client)
+        virOVSDBClientSetTimeout(client, virNetDevOpenvswitchTimeout);
+
+    return client;
+}
+
 static virCommand *
 virNetDevOpenvswitchCreateCmd(char **errbuf)
 {
@@ -119,6 +136,340 @@ virNetDevOpenvswitchConstructVlans(virCommand *cmd, const virNetDevVlan *virtVla
     }
 }
 
+/**
+ * virNetDevOpenvswitchConstructVlanColumns:
+ * @row: Port row to fill
+ * @virtVlan: VLAN configuration to be applied
+ *
+ * Counterpart of virNetDevOpenvswitchConstructVlans() for OVSDB
+ * transactions. Columns not configured by @virtVlan are left out.
+ */
+static int
+virNetDevOpenvswitchConstructVlanColumns(virJSONValue *row,
+                                         const virNetDevVlan *virtVlan)
+{
+    g_autoptr(virJSONValue) trunks = NULL;
+    const char *mode = NULL;
+    long long tag = -1;
+
+    if (!virtVlan || !virtVlan->nTags)
+        return 0;
+
+    switch (virtVlan->nativeMode) {
+    case VIR_NATIVE_VLAN_MODE_TAGGED:
+        mode = "native-tagged";
+        tag = virtVlan->nativeTag;
+        break;
+    case VIR_NATIVE_VLAN_MODE_UNTAGGED:
+        mode = "native-untagged";
+        tag = virtVlan->nativeTag;
+        break;
+    case VIR_NATIVE_VLAN_MODE_DEFAULT:
+    default:
+        break;
+    }
+
+    if (virtVlan->trunk) {
+        size_t i;
+
+        trunks = virOVSDBNewSet();
+
+        for (i = 0; i < virtVlan->nTags; i++) {
+            g_autoptr(virJSONValue) atom = virJSONValueNewNumberUint(virtVlan->tag[i]);
+
+            if (virOVSDBSetAppend(trunks, &atom) < 0)
+                return -1;
+        }
+    } else {
+        tag = virtVlan->tag[0];
+    }
+
+    if (virJSONValueObjectAdd(&row,
+                              "S:vlan_mode", mode,
+                              "K:tag", tag,
+                              "A:trunks", &trunks,
+                              NULL) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static virJSONValue *
+virNetDevOpenvswitchWhereName(const char *name)
+{
+    g_autoptr(virJSONValue) value = virJSONValueNewString(g_strdup(name));
+    g_autoptr(virJSONValue) cond = NULL;
+    g_autoptr(virJSONValue) where = virJSONValueNewArray();
+
+    if (!(cond = virOVSDBNewClause("name", "==", &value)) ||
+        virJSONValueArrayAppend(where, &cond) < 0)
+        return NULL;
+
+    return g_steal_pointer(&where);
+}
+
+
+/*
+ * Appends an @op ("update", "mutate" or "select") operation on row @name
+ * of @table. @arg holds the new column values, the mutations or the
+ * columns to select respectively and is stolen.
+ */
+static int
+virNetDevOpenvswitchAppendOp(virJSONValue *ops,
+                             const char *op,
+                             const char *table,
+                             const char *name,
+                             virJSONValue **arg)
+{
+    g_autoptr(virJSONValue) where = NULL;
+    g_autoptr(virJSONValue) json = NULL;
+
+    if (!(where = virNetDevOpenvswitchWhereName(name)))
+        return -1;
+
+    if (virJSONValueObjectAdd(&json,
+                              "s:op", op,
+                              "s:table", table,
+                              "a:where", &where,
+                              NULL) < 0)
+        return -1;
+
+    if (STREQ(op, "mutate")) {
+        if (virJSONValueObjectAppend(json, "mutations", arg) < 0)
+            return -1;
+    } else if (STREQ(op, "select")) {
+        if (virJSONValueObjectAppend(json, "columns", arg) < 0)
+            return -1;
+    } else {
+        if (virJSONValueObjectAppend(json, "row", arg) < 0)
+            return -1;
+    }
+
+    return virJSONValueArrayAppend(ops, &json);
+}
+
+
+static int
+virNetDevOpenvswitchAppendInsert(virJSONValue *ops,
+                                 const char *table,
+                                 const char *uuidName,
+                                 virJSONValue **row)
+{
+    g_autoptr(virJSONValue) json = NULL;
+
+    if (virJSONValueObjectAdd(&json,
+                              "s:op", "insert",
+                              "s:table", table,
+                              "a:row", row,
+                              "s:uuid-name", uuidName,
+                              NULL) < 0)
+        return -1;
+
+    return virJSONValueArrayAppend(ops, &json);
+}
+
+
+/*
+ * Appends an operation which sets all keys of @map in @column of row
+ * @name, keeping other keys, like 'ovs-vsctl set <table> <name>
+ * <column>:<key>=<value>' does.
+ */
+static int
+virNetDevOpenvswitchAppendSetKeys(virJSONValue *ops,
+                                  const char *table,
+                                  const char *name,
+                                  const char *column,
+                                  virJSONValue **map)
+{
+    g_autoptr(virJSONValue) keys = virOVSDBNewSet();
+    g_autoptr(virJSONValue) mutations = virJSONValueNewArray();
+    g_autoptr(virJSONValue) del = NULL;
+    g_autoptr(virJSONValue) ins = NULL;
+    virJSONValue *pairs = virJSONValueArrayGet(*map, 1);
+    size_t i;
+
+    for (i = 0; i < virJSONValueArraySize(pairs); i++) {
+        virJSONValue *pair = virJSONValueArrayGet(pairs, i);
+        g_autoptr(virJSONValue) key = virJSONValueCopy(virJSONValueArrayGet(pair, 0));
+
+        if (virOVSDBSetAppend(keys, &key) < 0)
+            return -1;
+    }
+
+    if (!(del = virOVSDBNewClause(column, "delete", &keys)) ||
+        !(ins = virOVSDBNewClause(column, "insert", map)) ||
+        virJSONValueArrayAppend(mutations, &del) < 0 ||
+        virJSONValueArrayAppend(mutations, &ins) < 0)
+        return -1;
+
+    return virNetDevOpenvswitchAppendOp(ops, "mutate", table, name, &mutations);
+}
+
+
+/* Returns the "count" of rows an update or mutate operation modified. */
+static long long
+virNetDevOpenvswitchResultCount(virJSONValue *results,
+                                size_t op)
+{
+    virJSONValue *result = virJSONValueArrayGet(results, op);
+    long long count;
+
+    if (!result ||
+        virJSONValueObjectGetNumberLong(result, "count", &count) < 0)
+        return -1;
+
+    return count;
+}
+
+
+/*
+ * Native counterpart of 'ovs-vsctl [--if-exists] set <table> <name> ...'
+ * with the columns in @row.
+ */
+static int
+virNetDevOpenvswitchUpdateOVSDB(virOVSDBClient *ovsdb,
+                                const char *table,
+                                const char *name,
+                                virJSONValue **row,
+                                bool ifExists)
+{
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autoptr(virJSONValue) results = NULL;
+    int rc;
+
+    if (virNetDevOpenvswitchAppendOp(ops, "update", table, name, row) < 0)
+        return -1;
+
+    if ((rc = virOVSDBTransact(ovsdb, &ops, VIR_OVSDB_TRANSACT_WAIT,
+                               &results)) < 0)
+        return rc;
+
+    if (!ifExists &&
+        virNetDevOpenvswitchResultCount(results, 0) <= 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("no row \"%1$s\" in table %2$s"), name, table);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+virNetDevOpenvswitchAddPortOVSDB(virOVSDBClient *ovsdb,
+                                 const char *brname,
+                                 const char *ifname,
+                                 virJSONValue **extIDs,
+                                 const virNetDevVlan *virtVlan)
+{
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autoptr(virJSONValue) results = NULL;
+    g_autoptr(virJSONValue) ifaceRow = NULL;
+    g_autoptr(virJSONValue) portRow = NULL;
+    g_autoptr(virJSONValue) ifaceRef = NULL;
+    g_autoptr(virJSONValue) portRefs = virOVSDBNewSet();
+    g_autoptr(virJSONValue) portRef = NULL;
+    g_autoptr(virJSONValue) mutation = NULL;
+    g_autoptr(virJSONValue) mutations = virJSONValueNewArray();
+    g_autofree char *ifaceUUIDName = NULL;
+    g_autofree char *portUUIDName = NULL;
+    g_autofree char *curbrname = NULL;
+    int rc;
+
+    if ((rc = virOVSDBGetPort(ovsdb, ifname, NULL, &curbrname)) < 0)
+        return rc;
+
+    if (rc == 1) {
+        /* --may-exist only allows the port to be on the same bridge */
+        if (STRNEQ_NULLABLE(curbrname, brname)) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("port %1$s already exists on bridge %2$s"),
+                           ifname, NULLSTR(curbrname));
+            return -1;
+        }
+
+        if (virNetDevOpenvswitchAppendSetKeys(ops, "Interface", ifname,
+                                              "external_ids", extIDs) < 0)
+            return -1;
+
+        return virOVSDBTransact(ovsdb, &ops, VIR_OVSDB_TRANSACT_WAIT, NULL);
+    }
+
+    ifaceUUIDName = virOVSDBNewUUIDName();
+    portUUIDName = virOVSDBNewUUIDName();
+
+    if (virJSONValueObjectAdd(&ifaceRow,
+                              "s:name", ifname,
+                              "a:external_ids", extIDs,
+                              NULL) < 0 ||
+        virNetDevOpenvswitchAppendInsert(ops, "Interface", ifaceUUIDName,
+                                         &ifaceRow) < 0)
+        return -1;
+
+    ifaceRef = virOVSDBNewUUID(ifaceUUIDName, true);
+    if (virJSONValueObjectAdd(&portRow,
+                              "s:name", ifname,
+                              "a:interfaces", &ifaceRef,
+                              NULL) < 0 ||
+        virNetDevOpenvswitchConstructVlanColumns(portRow, virtVlan) < 0 ||
+        virNetDevOpenvswitchAppendInsert(ops, "Port", portUUIDName,
+                                         &portRow) < 0)
+        return -1;
+
+    /* Port and Interface are not root tables, the rows inserted above are
+     * dropped again unless the bridge refers to them. */
+    portRef = virOVSDBNewUUID(portUUIDName, true);
+    if (virOVSDBSetAppend(portRefs, &portRef) < 0 ||
+        !(mutation = virOVSDBNewClause("ports", "insert", &portRefs)) ||
+        virJSONValueArrayAppend(mutations, &mutation) < 0 ||
+        virNetDevOpenvswitchAppendOp(ops, "mutate", "Bridge", brname,
+                                     &mutations) < 0)
+        return -1;
+
+    if ((rc = virOVSDBTransact(ovsdb, &ops, VIR_OVSDB_TRANSACT_WAIT,
+                               &results)) < 0)
+        return rc;
+
+    if (virNetDevOpenvswitchResultCount(results, 2) <= 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("no bridge named %1$s"), brname);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+virNetDevOpenvswitchRemovePortOVSDB(virOVSDBClient *ovsdb,
+                                    const char *ifname)
+{
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autoptr(virJSONValue) portRefs = virOVSDBNewSet();
+    g_autoptr(virJSONValue) portRef = NULL;
+    g_autoptr(virJSONValue) mutation = NULL;
+    g_autoptr(virJSONValue) mutations = virJSONValueNewArray();
+    g_autofree char *portuuid = NULL;
+    g_autofree char *brname = NULL;
+    int rc;
+
+    /* --if-exists */
+    if ((rc = virOVSDBGetPort(ovsdb, ifname, &portuuid, &brname)) <= 0)
+        return rc;
+
+    /* the port and its interfaces go away once nothing refers to them */
+    portRef = virOVSDBNewUUID(portuuid, false);
+    if (virOVSDBSetAppend(portRefs, &portRef) < 0 ||
+        !(mutation = virOVSDBNewClause("ports", "delete", &portRefs)) ||
+        virJSONValueArrayAppend(mutations, &mutation) < 0 ||
+        virNetDevOpenvswitchAppendOp(ops, "mutate", "Bridge", brname,
+                                     &mutations) < 0)
+        return -1;
+
+    return virOVSDBTransact(ovsdb, &ops, VIR_OVSDB_TRANSACT_WAIT, NULL);
+}
+
 /**
  * virNetDevOpenvswitchAddPort:
  * @brname: the bridge name
@@ -140,6 +491,7 @@ int virNetDevOpenvswitchAddPort(const char *brname, const char *ifname,
     char macaddrstr[VIR_MAC_STRING_BUFLEN];
     char ifuuidstr[VIR_UUID_STRING_BUFLEN];
     char vmuuidstr[VIR_UUID_STRING_BUFLEN];
+    virOVSDBClient *ovsdb = NULL;
     g_autoptr(virCommand) cmd = NULL;
     g_autofree char *errbuf = NULL;
     g_autofree char *attachedmac_ex_id = NULL;
@@ -152,6 +504,32 @@ int virNetDevOpenvswitchAddPort(const char *brname, const char *ifname,
     virUUIDFormat(ovsport->interfaceID, ifuuidstr);
     virUUIDFormat(vmuuid, vmuuidstr);
 
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB())) {
+        g_autoptr(virJSONValue) extIDs = virOVSDBNewMap();
+        int rc;
+
+        if (virOVSDBMapAppend(extIDs, "attached-mac", macaddrstr) < 0 ||
+            virOVSDBMapAppend(extIDs, "iface-id", ifuuidstr) < 0 ||
+            virOVSDBMapAppend(extIDs, "vm-id", vmuuidstr) < 0)
+            return -1;
+
+        if (ovsport->profileID[0] != '\0' &&
+            (virOVSDBMapAppend(extIDs, "port-profile", ovsport->profileID) < 0 ||
+             virOVSDBMapAppend(extIDs, "ifname", ifname) < 0))
+            return -1;
+
+        if (virOVSDBMapAppend(extIDs, "iface-status", "active") < 0)
+            return -1;
+
+        rc = virNetDevOpenvswitchAddPortOVSDB(ovsdb, brname, ifname,
+                                              &extIDs, virtVlan);
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to add port %1$s to OVS bridge %2$s"),
+                                      ifname, brname);
+        if (rc != -2)
+            return rc;
+    }
+
     attachedmac_ex_id = g_strdup_printf("external-ids:attached-mac=\"%s\"",
                                         macaddrstr);
     ifaceid_ex_id = g_strdup_printf("external-ids:iface-id=\"%s\"", ifuuidstr);
@@ -208,9 +586,21 @@ int virNetDevOpenvswitchAddPort(const char *brname, const char *ifname,
  */
 int virNetDevOpenvswitchRemovePort(const char *brname G_GNUC_UNUSED, const char *ifname)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autofree char *errbuf = NULL;
-    g_autoptr(virCommand) cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
+    g_autoptr(virCommand) cmd = NULL;
+
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB())) {
+        int rc = virNetDevOpenvswitchRemovePortOVSDB(ovsdb, ifname);
+
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to delete port %1$s from OVS"),
+                                      ifname);
+        if (rc != -2)
+            return rc;
+    }
 
+    cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd, "--", "--if-exists", "del-port", ifname, NULL);
 
     if (virCommandRun(cmd, NULL) < 0) {
@@ -367,6 +757,43 @@ virNetDevOpenvswitchInterfaceParseStats(const char *json,
     return 0;
 }
 
+static int
+virNetDevOpenvswitchInterfaceStatsOVSDB(virOVSDBClient *ovsdb,
+                                        const char *ifname,
+                                        char **output)
+{
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autoptr(virJSONValue) columns = virJSONValueNewArray();
+    g_autoptr(virJSONValue) results = NULL;
+    virJSONValue *rows;
+    virJSONValue *row;
+    virJSONValue *statistics;
+    int rc;
+
+    if (virJSONValueArrayAppendString(columns, "statistics") < 0 ||
+        virNetDevOpenvswitchAppendOp(ops, "select", "Interface", ifname,
+                                     &columns) < 0)
+        return -1;
+
+    if ((rc = virOVSDBTransact(ovsdb, &ops, 0, &results)) < 0)
+        return rc;
+
+    if (!(rows = virJSONValueObjectGetArray(virJSONValueArrayGet(results, 0),
+                                            "rows")) ||
+        !(row = virJSONValueArrayGet(rows, 0)) ||
+        !(statistics = virJSONValueObjectGet(row, "statistics"))) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Interface not found: %1$s"), ifname);
+        return -1;
+    }
+
+    /* same format as 'ovs-vsctl --data=json' prints */
+    if (!(*output = virJSONValueToString(statistics, false)))
+        return -1;
+
+    return 0;
+}
+
 /**
  * virNetDevOpenvswitchInterfaceStats:
  * @ifname: the name of the interface
@@ -380,10 +807,21 @@ int
 virNetDevOpenvswitchInterfaceStats(const char *ifname,
                                    virDomainInterfaceStatsPtr stats)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autofree char *errbuf = NULL;
-    g_autoptr(virCommand) cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
+    g_autoptr(virCommand) cmd = NULL;
     g_autofree char *output = NULL;
+    int rc = -2;
+
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB()) &&
+        (rc = virNetDevOpenvswitchInterfaceStatsOVSDB(ovsdb, ifname,
+                                                      &output)) == -1)
+        return -1;
+
+    if (rc == 0)
+        goto parse;
 
+    cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd, "--if-exists", "--format=list", "--data=json",
                          "--no-headings", "--columns=statistics", "list",
                          "Interface", ifname, NULL);
@@ -406,6 +844,7 @@ virNetDevOpenvswitchInterfaceStats(const char *ifname,
         return -1;
     }
 
+ parse:
     if (virNetDevOpenvswitchInterfaceParseStats(output, stats) < 0)
         return -1;
 
@@ -444,12 +883,28 @@ virNetDevOpenvswitchInterfaceStats(const char *ifname,
 int
 virNetDevOpenvswitchInterfaceGetMaster(const char *ifname, char **master)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autofree char *errbuf = NULL;
-    g_autoptr(virCommand) cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
+    g_autoptr(virCommand) cmd = NULL;
     int exitstatus;
+    int rc;
 
     *master = NULL;
 
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB()) &&
+        (rc = virOVSDBGetInterfaceBridge(ovsdb, ifname, master)) != -2) {
+        if (rc < 0) {
+            virLastErrorPrefixMessage(_("Unable to get OVS master for interface %1$s"),
+                                      ifname);
+            return -1;
+        }
+
+        VIR_DEBUG("OVS master for %s is %s",
+                  ifname, *master ? *master : "(none)");
+        return 0;
+    }
+
+    cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd, "iface-to-br", ifname, NULL);
     virCommandSetOutputBuffer(cmd, master);
 
@@ -612,9 +1067,40 @@ virNetDevOpenvswitchGetVhostuserIfname(const char *path,
 int virNetDevOpenvswitchUpdateVlan(const char *ifname,
                                    const virNetDevVlan *virtVlan)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autofree char *errbuf = NULL;
-    g_autoptr(virCommand) cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
+    g_autoptr(virCommand) cmd = NULL;
+
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB())) {
+        g_autoptr(virJSONValue) row = virJSONValueNewObject();
+        const char *columns[] = { "tag", "trunks", "vlan_mode" };
+        size_t i;
+        int rc;
+
+        if (virNetDevOpenvswitchConstructVlanColumns(row, virtVlan) < 0)
+            return -1;
+
+        /* clear whatever @virtVlan doesn't set */
+        for (i = 0; i < G_N_ELEMENTS(columns); i++) {
+            g_autoptr(virJSONValue) empty = NULL;
+
+            if (virJSONValueObjectHasKey(row, columns[i]) == 1)
+                continue;
+
+            empty = virOVSDBNewSet();
+            if (virJSONValueObjectAppend(row, columns[i], &empty) < 0)
+                return -1;
+        }
+
+        rc = virNetDevOpenvswitchUpdateOVSDB(ovsdb, "Port", ifname, &row, true);
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to set vlan configuration on port %1$s"),
+                                      ifname);
+        if (rc != -2)
+            return rc;
+    }
 
+    cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd,
                          "--", "--if-exists", "clear", "Port", ifname, "tag",
                          "--", "--if-exists", "clear", "Port", ifname, "trunk",
@@ -735,9 +1221,29 @@ virNetDevOpenvswitchInterfaceClearTxQos(const char *ifname,
 static int
 virNetDevOpenvswitchInterfaceClearRxQos(const char *ifname)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autoptr(virCommand) cmd = NULL;
     g_autofree char *errbuf = NULL;
 
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB())) {
+        g_autoptr(virJSONValue) row = NULL;
+        int rc;
+
+        if (virJSONValueObjectAdd(&row,
+                                  "i:ingress_policing_rate", 0,
+                                  "i:ingress_policing_burst", 0,
+                                  NULL) < 0)
+            return -1;
+
+        rc = virNetDevOpenvswitchUpdateOVSDB(ovsdb, "Interface", ifname,
+                                             &row, false);
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to reset ingress on port %1$s"),
+                                      ifname);
+        if (rc != -2)
+            return rc;
+    }
+
     cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd, "set", "Interface", ifname, NULL);
     virCommandAddArgFormat(cmd, "ingress_policing_rate=%llu", 0llu);
@@ -862,9 +1368,32 @@ static int
 virNetDevOpenvswitchInterfaceSetRxQos(const char *ifname,
                                       const virNetDevBandwidthRate *rx)
 {
+    virOVSDBClient *ovsdb = NULL;
     g_autoptr(virCommand) cmd = NULL;
     g_autofree char *errbuf = NULL;
 
+    if ((ovsdb = virNetDevOpenvswitchGetOVSDB())) {
+        g_autoptr(virJSONValue) row = virJSONValueNewObject();
+        int rc;
+
+        if (virJSONValueObjectAppendNumberUlong(row, "ingress_policing_rate",
+                                                rx->average * VIR_NETDEV_RX_TO_OVS) < 0)
+            return -1;
+
+        if (rx->burst &&
+            virJSONValueObjectAppendNumberUlong(row, "ingress_policing_burst",
+                                                rx->burst * VIR_NETDEV_RX_TO_OVS) < 0)
+            return -1;
+
+        rc = virNetDevOpenvswitchUpdateOVSDB(ovsdb, "Interface", ifname,
+                                             &row, false);
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to set ingress policing on port %1$s"),
+                                      ifname);
+        if (rc != -2)
+            return rc;
+    }
+
     cmd = virNetDevOpenvswitchCreateCmd(&errbuf);
     virCommandAddArgList(cmd, "set", "Interface", ifname, NULL);
     virCommandAddArgFormat(cmd, "ingress_policing_rate=%llu",
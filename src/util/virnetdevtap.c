@@ -563,6 +563,74 @@ virNetDevTapReattachBridge(const char *tapname,
 }
 
 
+/*
+ * virNetDevTapAttachBridgeBatch:
+ *
+ * Counterpart of virNetDevSetMAC(), virNetDevTapAttachBridge() and
+ * virNetDevSetOnline() for a new tap device and a plain Linux bridge
+ * which queues all the steps into a single netlink batch rather than
+ * doing an ioctl() for each of them.
+ *
+ * Returns 0 on success, -1 on error, -2 if netlink is not available.
+ */
+static int
+virNetDevTapAttachBridgeBatch(const char *tapname,
+                              const char *brname,
+                              const virMacAddr *tapmac,
+                              virTristateBool isolatedPort,
+                              unsigned int mtu,
+                              unsigned int *actualMTU,
+                              bool online)
+{
+    g_autoptr(virNetDevLinkBatch) batch = virNetDevLinkBatchNew();
+    int rc;
+
+    /* See virNetDevTapAttachBridge() for why the MTU is always set */
+    if (mtu == 0) {
+        int brMTU;
+
+        if ((brMTU = virNetDevGetMTU(brname)) < 0)
+            return -1;
+
+        mtu = brMTU;
+    }
+
+    if (virNetDevLinkBatchSetMAC(batch, tapname, tapmac) < 0 ||
+        virNetDevLinkBatchSetMTU(batch, tapname, mtu) < 0 ||
+        virNetDevLinkBatchSetMaster(batch, tapname, brname) < 0)
+        return -1;
+
+    /* An isolated port must not pass any traffic before it's isolated */
+    if (isolatedPort != VIR_TRISTATE_BOOL_YES &&
+        virNetDevLinkBatchSetOnline(batch, tapname, online) < 0)
+        return -1;
+
+    if ((rc = virNetDevLinkBatchRun(batch)) < 0) {
+        if (rc == -1)
+            virLastErrorPrefixMessage(_("Unable to attach %1$s to bridge %2$s"),
+                                      tapname, brname);
+        return rc;
+    }
+
+    if (actualMTU)
+        *actualMTU = mtu;
+
+    if (isolatedPort == VIR_TRISTATE_BOOL_YES) {
+        if (virNetDevBridgePortSetIsolated(brname, tapname, true) < 0 ||
+            virNetDevSetOnline(tapname, online) < 0) {
+            virErrorPtr err;
+
+            virErrorPreserveLast(&err);
+            ignore_value(virNetDevBridgeRemovePort(brname, tapname));
+            virErrorRestore(&err);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
 /**
  * virNetDevTapCreateInBridgePort:
  * @brname: the bridge name
@@ -613,6 +681,7 @@ int virNetDevTapCreateInBridgePort(const char *brname,
 {
     virMacAddr tapmac;
     size_t i;
+    int rc = -2;
 
     if (virNetDevTapCreate(ifname, tunpath, tapfd, tapfdSize, flags) < 0)
         return -1;
@@ -639,17 +708,25 @@ int virNetDevTapCreateInBridgePort(const char *brname,
             tapmac.addr[0] = 0xFE;
     }
 
-    if (virNetDevSetMAC(*ifname, &tapmac) < 0)
+    if (!virtPortProfile &&
+        (rc = virNetDevTapAttachBridgeBatch(*ifname, brname, &tapmac,
+                                            isolatedPort, mtu, actualMTU,
+                                            !!(flags & VIR_NETDEV_TAP_CREATE_IFUP))) == -1)
         goto error;
 
-    if (virNetDevTapAttachBridge(*ifname, brname, macaddr, vmuuid,
-                                 virtPortProfile, virtVlan,
-                                 isolatedPort, mtu, actualMTU) < 0) {
-        goto error;
-    }
+    if (rc == -2) {
+        if (virNetDevSetMAC(*ifname, &tapmac) < 0)
+            goto error;
 
-    if (virNetDevSetOnline(*ifname, !!(flags & VIR_NETDEV_TAP_CREATE_IFUP)) < 0)
-        goto error;
+        if (virNetDevTapAttachBridge(*ifname, brname, macaddr, vmuuid,
+                                     virtPortProfile, virtVlan,
+                                     isolatedPort, mtu, actualMTU) < 0) {
+            goto error;
+        }
+
+        if (virNetDevSetOnline(*ifname, !!(flags & VIR_NETDEV_TAP_CREATE_IFUP)) < 0)
+            goto error;
+    }
 
     if (virNetDevSetCoalesce(*ifname, coalesce, false) < 0)
         goto error;
@@ -355,6 +355,173 @@ int virNetlinkCommand(struct nl_msg *nl_msg,
 }
 
 
+/**
+ * virNetlinkCommandBatch:
+ * @msgs: netlink messages to send
+ * @nmsgs: number of messages in @msgs
+ * @ignore: array of @nmsgs flags (may be NULL)
+ * @protocol: netlink protocol
+ * @errors: array of @nmsgs results (may be NULL)
+ *
+ * Send all @msgs to the kernel in a single datagram over a single
+ * netlink socket and wait until each of them is acknowledged. The
+ * kernel processes the messages in order and carries on after a
+ * failed one. Failures of messages which have the corresponding
+ * @ignore flag set are only logged, the first other failure is
+ * reported once all acknowledgments were received.
+ *
+ * If @errors is not NULL, it is filled with the outcome of each
+ * message: 0 on success, the negative errno the kernel replied with,
+ * or 1 if no reply was received.
+ *
+ * Returns: 0 on success,
+ *         -1 on error (with error reported),
+ *         -2 if netlink is not available (no error reported).
+ */
+int
+virNetlinkCommandBatch(struct nl_msg **msgs,
+                       size_t nmsgs,
+                       const bool *ignore,
+                       unsigned int protocol,
+                       int *errors)
+{
+    struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+    g_autoptr(virNetlinkHandle) nlhandle = NULL;
+    g_autoptr(GByteArray) buf = NULL;
+    g_autofree bool *acked = NULL;
+    uint32_t firstSeq = 0;
+    size_t pending = nmsgs;
+    size_t failedIdx = 0;
+    int failed = 0;
+    size_t i;
+    int fd;
+
+    if (nmsgs == 0)
+        return 0;
+
+    if (errors) {
+        for (i = 0; i < nmsgs; i++)
+            errors[i] = 1;
+    }
+
+    if (protocol >= MAX_LINKS) {
+        virReportSystemError(EINVAL,
+                             _("invalid protocol argument: %1$d"), protocol);
+        return -1;
+    }
+
+    if (!(nlhandle = virNetlinkCreateSocket(protocol)))
+        return -1;
+
+    if ((fd = nl_socket_get_fd(nlhandle)) < 0) {
+        virReportSystemError(errno,
+                             "%s", _("cannot get netlink socket fd"));
+        return -1;
+    }
+
+    buf = g_byte_array_new();
+
+    for (i = 0; i < nmsgs; i++) {
+        struct nlmsghdr *hdr = nlmsg_hdr(msgs[i]);
+        static const guint8 pad[NLMSG_ALIGNTO] = { 0 };
+
+        nl_complete_msg(nlhandle, msgs[i]);
+        hdr->nlmsg_flags |= NLM_F_ACK;
+
+        if (i == 0)
+            firstSeq = hdr->nlmsg_seq;
+
+        g_byte_array_append(buf, (const guint8 *) hdr, hdr->nlmsg_len);
+        g_byte_array_append(buf, pad,
+                            NLMSG_ALIGN(hdr->nlmsg_len) - hdr->nlmsg_len);
+    }
+
+    VIR_DEBUG("Sending %zu netlink messages (%u bytes)", nmsgs, buf->len);
+
+    if (nl_sendto(nlhandle, buf->data, buf->len) < 0) {
+        virReportSystemError(errno,
+                             "%s", _("cannot send to netlink socket"));
+        return -1;
+    }
+
+    acked = g_new0(bool, nmsgs);
+
+    while (pending > 0) {
+        g_autofree struct nlmsghdr *resp = NULL;
+        struct pollfd fds[1] = { { .fd = fd, .events = POLLIN } };
+        struct nlmsghdr *hdr;
+        int len;
+        int n;
+
+        if ((n = poll(fds, G_N_ELEMENTS(fds), NETLINK_ACK_TIMEOUT_S)) <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+
+            virReportSystemError(n < 0 ? errno : ETIMEDOUT, "%s",
+                                 _("no valid netlink response was received"));
+            return -1;
+        }
+
+        len = nl_recv(nlhandle, &nladdr, (unsigned char **)&resp, NULL);
+        if (len == 0) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("nl_recv failed - returned 0 bytes"));
+            return -1;
+        }
+        if (len < 0) {
+            virReportSystemError(errno, "%s", _("nl_recv failed"));
+            return -1;
+        }
+
+        for (hdr = resp; nlmsg_ok(hdr, len); hdr = nlmsg_next(hdr, &len)) {
+            struct nlmsgerr *err = NLMSG_DATA(hdr);
+            size_t idx = hdr->nlmsg_seq - firstSeq;
+
+            if (hdr->nlmsg_type != NLMSG_ERROR)
+                continue;
+
+            if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*err))) {
+                virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                               _("malformed netlink response message"));
+                return -1;
+            }
+
+            if (idx >= nmsgs || acked[idx])
+                continue;
+
+            acked[idx] = true;
+            pending--;
+
+            if (errors)
+                errors[idx] = err->error;
+
+            if (err->error == 0)
+                continue;
+
+            if (ignore && ignore[idx]) {
+                VIR_DEBUG("Ignoring error %d of netlink message %zu",
+                          err->error, idx);
+                continue;
+            }
+
+            if (failed == 0) {
+                failed = err->error;
+                failedIdx = idx;
+            }
+        }
+    }
+
+    if (failed < 0) {
+        virReportSystemError(-failed,
+                             _("netlink message %1$zu of %2$zu failed"),
+                             failedIdx + 1, nmsgs);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 /**
  * virNetlinkTalk:
  * @ifname: name of the link
@@ -592,6 +759,12 @@ virNetlinkNewLink(const char *ifname,
         return -1;
     }
 
+    /* saves a separate RTM_SETLINK round trip */
+    if (extra_args && extra_args->online) {
+        ifinfo.ifi_flags = IFF_UP;
+        ifinfo.ifi_change = IFF_UP;
+    }
+
     nl_msg = virNetlinkMsgNew(RTM_NEWLINK,
                               NLM_F_REQUEST | NLM_F_CREATE | NLM_F_EXCL);
 
@@ -1231,6 +1404,17 @@ int virNetlinkCommand(struct nl_msg *nl_msg G_GNUC_UNUSED,
     return -1;
 }
 
+int
+virNetlinkCommandBatch(struct nl_msg **msgs G_GNUC_UNUSED,
+                       size_t nmsgs G_GNUC_UNUSED,
+                       const bool *ignore G_GNUC_UNUSED,
+                       unsigned int protocol G_GNUC_UNUSED,
+                       int *errors G_GNUC_UNUSED)
+{
+    VIR_DEBUG("%s", unsupported);
+    return -2;
+}
+
 int
 virNetlinkDumpCommand(struct nl_msg *nl_msg G_GNUC_UNUSED,
                       virNetlinkDumpCallback callback G_GNUC_UNUSED,
@@ -50,6 +50,12 @@ int virNetlinkCommand(struct nl_msg *nl_msg,
                       uint32_t src_pid, uint32_t dst_pid,
                       unsigned int protocol, unsigned int groups);
 
+int virNetlinkCommandBatch(struct nl_msg **msgs,
+                           size_t nmsgs,
+                           const bool *ignore,
+                           unsigned int protocol,
+                           int *errors);
+
 typedef int (*virNetlinkDumpCallback)(struct nlmsghdr *resp,
                                       void *data);
 
@@ -65,6 +71,7 @@ struct _virNetlinkNewLinkData {
     const virMacAddr *mac;          /* The MAC address of the device */
     const uint32_t *macvlan_mode;   /* The mode of macvlan */
     const char *veth_peer;          /* The peer name for veth */
+    bool online;                    /* Bring the device up right away */
 };
 
 int virNetlinkNewLink(const char *ifname,
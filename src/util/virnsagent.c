@@ -0,0 +1,605 @@
+/*
+ * virnsagent.c: long lived helper running inside a mount namespace
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * virProcessRunInMountNamespace() forks the daemon for every single
+ * operation it runs inside a namespace. With a large daemon and device
+ * heavy domains this adds up. The agent is a separate helper program
+ * which is executed once, enters the mount namespace and then executes
+ * requests sent over a socketpair until the daemon closes its end.
+ * Being exec'd rather than forked from a multithreaded daemon, it
+ * inherits neither its locks nor any of its file descriptors.
+ *
+ * Commands are looked up by name from the table the helper passes to
+ * virNSAgentServe(). Their arguments and results travel as length
+ * prefixed JSON documents:
+ *
+ *   request: { "execute": "name", "arguments": { ... } }
+ *   reply:   { "return": 0, "error": { ... } }
+ *
+ * The very first reply is sent unsolicited once the agent has entered
+ * the namespace so that failures to do so are reported by
+ * virNSAgentNew(). Replies which don't arrive in time mark the agent as
+ * broken, it is killed when freed.
+ *
+ * Only the device node setup of the qemu driver goes through the agent.
+ * The relabel transactions of the DAC and SELinux security drivers still
+ * run in a fork entered into the namespace, as they call back into the
+ * daemon (storage chown callbacks, metadata locks held by the security
+ * manager) and so can't be executed by a separate program.
+ */
+
+#include <config.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef WIN32
+# include <poll.h>
+# include <sys/socket.h>
+#endif
+
+#include "virnsagent.h"
+#define LIBVIRT_VIRNSAGENTPRIV_H_ALLOW
+#include "virnsagentpriv.h"
+#include "configmake.h"
+#include "vircommand.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+#include "virthread.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("util.nsagent");
+
+/* Messages are a few kilobytes at most, anything this large means that
+ * the stream got out of sync. */
+#define VIR_NS_AGENT_MAX_MESSAGE (16 * 1024 * 1024)
+
+/* How long to wait for a reply, in milliseconds. Commands only touch a
+ * handful of files in /dev of the namespace. */
+#define VIR_NS_AGENT_TIMEOUT (30 * 1000)
+
+struct _virNSAgent {
+    virMutex lock;
+
+    pid_t target; /* process whose mount namespace the agent lives in */
+    virCommand *cmd;
+    pid_t pid;
+    int fd;
+    unsigned int timeout; /* in milliseconds */
+
+    /* the stream is unusable after an I/O error */
+    bool broken;
+};
+
+
+static int
+virNSAgentWriteMessage(int fd,
+                       virJSONValue *msg)
+{
+    g_autofree char *str = NULL;
+    uint32_t len;
+
+    if (!(str = virJSONValueToString(msg, false)))
+        return -1;
+
+    len = strlen(str);
+
+    if (safewrite(fd, &len, sizeof(len)) != sizeof(len) ||
+        safewrite(fd, str, len) != len) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to write to namespace agent"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Waits until @fd becomes readable. @deadline is in milliseconds of
+ * monotonic time, 0 means forever.
+ */
+#ifndef WIN32
+static int
+virNSAgentWait(int fd,
+               unsigned long long deadline)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    if (deadline == 0)
+        return 0;
+
+    while (true) {
+        unsigned long long now = g_get_monotonic_time() / 1000;
+        int rc;
+
+        if (now >= deadline) {
+            virReportError(VIR_ERR_OPERATION_TIMEOUT, "%s",
+                           _("namespace agent did not reply in time"));
+            return -1;
+        }
+
+        if ((rc = poll(&pfd, 1, MIN(deadline - now, INT_MAX))) > 0)
+            return 0;
+
+        if (rc < 0 && errno != EINTR) {
+            virReportSystemError(errno, "%s",
+                                 _("Unable to poll namespace agent"));
+            return -1;
+        }
+    }
+}
+#else /* WIN32 */
+static int
+virNSAgentWait(int fd G_GNUC_UNUSED,
+               unsigned long long deadline G_GNUC_UNUSED)
+{
+    return 0;
+}
+#endif /* WIN32 */
+
+
+static unsigned long long
+virNSAgentDeadline(virNSAgent *agent)
+{
+    if (agent->timeout == 0)
+        return 0;
+
+    return g_get_monotonic_time() / 1000 + agent->timeout;
+}
+
+
+/*
+ * Returns the number of bytes read, which is less than @len only at the
+ * end of the stream, or -1 with an error reported.
+ */
+static ssize_t
+virNSAgentRead(int fd,
+               void *buf,
+               size_t len,
+               unsigned long long deadline)
+{
+    size_t got = 0;
+
+    while (got < len) {
+        ssize_t rc;
+
+        if (virNSAgentWait(fd, deadline) < 0)
+            return -1;
+
+        if ((rc = read(fd, (char *) buf + got, len - got)) < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            virReportSystemError(errno, "%s",
+                                 _("Unable to read from namespace agent"));
+            return -1;
+        }
+
+        if (rc == 0)
+            break;
+
+        got += rc;
+    }
+
+    return got;
+}
+
+
+/*
+ * Returns 1 if a message was read, 0 on EOF before the start of a
+ * message and -1 with an error reported otherwise.
+ */
+static int
+virNSAgentReadMessage(int fd,
+                      virJSONValue **msg,
+                      unsigned long long deadline)
+{
+    g_autofree char *str = NULL;
+    uint32_t len;
+    ssize_t got;
+
+    if ((got = virNSAgentRead(fd, &len, sizeof(len), deadline)) <= 0)
+        return got;
+
+    if (got != sizeof(len) ||
+        len > VIR_NS_AGENT_MAX_MESSAGE) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Malformed namespace agent message"));
+        return -1;
+    }
+
+    str = g_new0(char, len + 1);
+
+    if ((got = virNSAgentRead(fd, str, len, deadline)) < 0)
+        return -1;
+
+    if (got != len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unexpected end of namespace agent stream"));
+        return -1;
+    }
+
+    if (!(*msg = virJSONValueFromString(str)))
+        return -1;
+
+    return 1;
+}
+
+
+static virJSONValue *
+virNSAgentMakeReply(int ret)
+{
+    g_autoptr(virJSONValue) reply = NULL;
+    g_autoptr(virJSONValue) error = NULL;
+    virErrorPtr err;
+
+    if (ret < 0 && (err = virGetLastError())) {
+        if (virJSONValueObjectAdd(&error,
+                                  "i:code", err->code,
+                                  "i:domain", err->domain,
+                                  "i:level", err->level,
+                                  "S:message", err->message,
+                                  "S:str1", err->str1,
+                                  "S:str2", err->str2,
+                                  "S:str3", err->str3,
+                                  "i:int1", err->int1,
+                                  "i:int2", err->int2,
+                                  NULL) < 0)
+            return NULL;
+    }
+
+    if (virJSONValueObjectAdd(&reply,
+                              "i:return", ret,
+                              "A:error", &error,
+                              NULL) < 0)
+        return NULL;
+
+    return g_steal_pointer(&reply);
+}
+
+
+static int
+virNSAgentProcessReply(virJSONValue *reply,
+                       const char *command)
+{
+    virJSONValue *error;
+    int ret;
+
+    if (virJSONValueObjectGetNumberInt(reply, "return", &ret) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Malformed namespace agent message"));
+        return -1;
+    }
+
+    if (ret >= 0)
+        return ret;
+
+    if ((error = virJSONValueObjectGetObject(reply, "error"))) {
+        int domain = VIR_FROM_NONE;
+        int code = VIR_ERR_INTERNAL_ERROR;
+        int level = VIR_ERR_ERROR;
+        int int1 = 0;
+        int int2 = 0;
+
+        ignore_value(virJSONValueObjectGetNumberInt(error, "domain", &domain));
+        ignore_value(virJSONValueObjectGetNumberInt(error, "code", &code));
+        ignore_value(virJSONValueObjectGetNumberInt(error, "level", &level));
+        ignore_value(virJSONValueObjectGetNumberInt(error, "int1", &int1));
+        ignore_value(virJSONValueObjectGetNumberInt(error, "int2", &int2));
+
+        virRaiseErrorFull(__FILE__, __FUNCTION__, __LINE__,
+                          domain, code, level,
+                          virJSONValueObjectGetString(error, "str1"),
+                          virJSONValueObjectGetString(error, "str2"),
+                          virJSONValueObjectGetString(error, "str3"),
+                          int1, int2,
+                          "%s", NULLSTR(virJSONValueObjectGetString(error, "message")));
+    } else {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("namespace agent command '%1$s' failed"),
+                       command);
+    }
+
+    return -1;
+}
+
+
+#ifdef __linux__
+/**
+ * virNSAgentServe:
+ * @fd: socket connected to the daemon
+ * @status: result of entering the namespace
+ * @commands: table of commands terminated by an entry with NULL name
+ *
+ * The main loop of the agent helper. Reports @status to the daemon
+ * first and then runs @commands as the daemon requests them until it
+ * closes its end of @fd. Nothing is run if @status is negative.
+ *
+ * Returns 0 once the daemon is gone, -1 on error.
+ */
+int
+virNSAgentServe(int fd,
+                int status,
+                const virNSAgentCommand *commands)
+{
+    g_autoptr(virJSONValue) ready = NULL;
+
+    if (!(ready = virNSAgentMakeReply(status)) ||
+        virNSAgentWriteMessage(fd, ready) < 0 ||
+        status < 0)
+        return -1;
+
+    while (true) {
+        g_autoptr(virJSONValue) request = NULL;
+        g_autoptr(virJSONValue) reply = NULL;
+        const virNSAgentCommand *cmd = NULL;
+        const char *name;
+        virJSONValue *args;
+        int ret = -1;
+        int rc;
+
+        if ((rc = virNSAgentReadMessage(fd, &request, 0)) <= 0)
+            return rc;
+
+        virResetLastError();
+
+        name = virJSONValueObjectGetString(request, "execute");
+        args = virJSONValueObjectGetObject(request, "arguments");
+
+        for (cmd = commands; name && cmd->name; cmd++) {
+            if (STREQ(cmd->name, name))
+                break;
+        }
+
+        if (!name || !args || !cmd->name) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("unknown namespace agent command '%1$s'"),
+                           NULLSTR(name));
+        } else {
+            VIR_DEBUG("Running namespace agent command '%s'", name);
+            ret = cmd->cb(args);
+        }
+
+        if (!(reply = virNSAgentMakeReply(ret)) ||
+            virNSAgentWriteMessage(fd, reply) < 0)
+            return -1;
+    }
+}
+
+
+/**
+ * virNSAgentNew:
+ * @pid: process whose mount namespace to enter
+ *
+ * Executes the libvirt_nsagent helper which enters the mount namespace
+ * of @pid and runs the commands sent to it by virNSAgentRun().
+ *
+ * Returns the agent on success, NULL with an error reported otherwise.
+ */
+virNSAgent *
+virNSAgentNew(pid_t pid)
+{
+    g_autoptr(virNSAgent) agent = NULL;
+    g_autoptr(virJSONValue) ready = NULL;
+    g_autofree char *path = NULL;
+    int pair[2] = { -1, -1 };
+    int rc;
+
+    agent = g_new0(virNSAgent, 1);
+
+    if (virMutexInit(&agent->lock) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to initialize mutex"));
+        g_free(g_steal_pointer(&agent));
+        return NULL;
+    }
+
+    agent->target = pid;
+    agent->fd = -1;
+    agent->timeout = VIR_NS_AGENT_TIMEOUT;
+
+    if (!(path = virFileFindResource("libvirt_nsagent",
+                                     abs_top_builddir "/src",
+                                     LIBEXECDIR)))
+        return NULL;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create socketpair"));
+        return NULL;
+    }
+
+    agent->fd = pair[0];
+
+    agent->cmd = virCommandNew(path);
+    virCommandAddArgFormat(agent->cmd, "%lld", (long long) pid);
+    virCommandAddArgFormat(agent->cmd, "%d", pair[1]);
+    virCommandPassFD(agent->cmd, pair[1], VIR_COMMAND_PASS_FD_CLOSE_PARENT);
+
+    if (virCommandRunAsync(agent->cmd, &agent->pid) < 0)
+        return NULL;
+
+    if ((rc = virNSAgentReadMessage(agent->fd, &ready,
+                                    virNSAgentDeadline(agent))) < 0)
+        return NULL;
+
+    if (rc == 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("namespace agent exited unexpectedly"));
+        return NULL;
+    }
+
+    if (virNSAgentProcessReply(ready, "startup") < 0)
+        return NULL;
+
+    VIR_DEBUG("Started namespace agent %lld for process %lld",
+              (long long) agent->pid, (long long) pid);
+
+    return g_steal_pointer(&agent);
+}
+
+
+#else /* !__linux__ */
+
+int
+virNSAgentServe(int fd G_GNUC_UNUSED,
+                int status G_GNUC_UNUSED,
+                const virNSAgentCommand *commands G_GNUC_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("Namespaces are not supported on this platform"));
+    return -1;
+}
+
+
+virNSAgent *
+virNSAgentNew(pid_t pid G_GNUC_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("Namespaces are not supported on this platform"));
+    return NULL;
+}
+
+#endif /* !__linux__ */
+
+
+/**
+ * virNSAgentFree:
+ * @agent: namespace agent
+ *
+ * Closes the connection to @agent and reaps its process.
+ */
+void
+virNSAgentFree(virNSAgent *agent)
+{
+    if (!agent)
+        return;
+
+    VIR_FORCE_CLOSE(agent->fd);
+
+    /* The agent exits on EOF, but it might be stuck in a command on an
+     * unresponsive filesystem, don't wait for it indefinitely. */
+    virCommandAbort(agent->cmd);
+    virCommandFree(agent->cmd);
+
+    virMutexDestroy(&agent->lock);
+    g_free(agent);
+}
+
+
+pid_t
+virNSAgentGetTargetPid(virNSAgent *agent)
+{
+    return agent->target;
+}
+
+
+pid_t
+virNSAgentGetPid(virNSAgent *agent)
+{
+    return agent->pid;
+}
+
+
+/**
+ * virNSAgentSetTimeout:
+ * @agent: namespace agent
+ * @timeout: how long to wait for replies, in milliseconds
+ */
+void
+virNSAgentSetTimeout(virNSAgent *agent,
+                     unsigned int timeout)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&agent->lock);
+
+    agent->timeout = timeout;
+}
+
+
+/**
+ * virNSAgentIsBroken:
+ * @agent: namespace agent
+ *
+ * Returns true if communication with @agent failed and it should be
+ * replaced by a new one.
+ */
+bool
+virNSAgentIsBroken(virNSAgent *agent)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&agent->lock);
+
+    return agent->broken;
+}
+
+
+/**
+ * virNSAgentRun:
+ * @agent: namespace agent
+ * @command: name of the command to run
+ * @args: pointer to the arguments object, may point to NULL
+ *
+ * Runs @command with @args in @agent and waits for it to finish. The
+ * arguments are consumed and *@args is cleared.
+ *
+ * Returns -1 with the error reported either here or by the command,
+ * otherwise the return value of the command.
+ */
+int
+virNSAgentRun(virNSAgent *agent,
+              const char *command,
+              virJSONValue **args)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&agent->lock);
+    g_autoptr(virJSONValue) request = NULL;
+    g_autoptr(virJSONValue) reply = NULL;
+    int rc;
+
+    if (agent->broken) {
+        virReportError(VIR_ERR_OPERATION_FAILED, "%s",
+                       _("namespace agent is not usable"));
+        return -1;
+    }
+
+    if (!*args)
+        *args = virJSONValueNewObject();
+
+    if (virJSONValueObjectAdd(&request,
+                              "s:execute", command,
+                              "a:arguments", args,
+                              NULL) < 0)
+        return -1;
+
+    if (virNSAgentWriteMessage(agent->fd, request) < 0 ||
+        (rc = virNSAgentReadMessage(agent->fd, &reply,
+                                    virNSAgentDeadline(agent))) < 0) {
+        agent->broken = true;
+        return -1;
+    }
+
+    if (rc == 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("namespace agent exited unexpectedly"));
+        agent->broken = true;
+        return -1;
+    }
+
+    return virNSAgentProcessReply(reply, command);
+}
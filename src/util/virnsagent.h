@@ -0,0 +1,58 @@
+/*
+ * virnsagent.h: long lived helper running inside a mount namespace
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "virjson.h"
+
+typedef struct _virNSAgent virNSAgent;
+
+/* Runs in the agent process. @args is never NULL. The return value is
+ * passed back to the caller of virNSAgentRun() together with the last
+ * error if it is negative. */
+typedef int (*virNSAgentCallback)(virJSONValue *args);
+
+typedef struct _virNSAgentCommand virNSAgentCommand;
+struct _virNSAgentCommand {
+    const char *name;
+    virNSAgentCallback cb;
+};
+
+virNSAgent *
+virNSAgentNew(pid_t pid);
+
+void
+virNSAgentFree(virNSAgent *agent);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virNSAgent, virNSAgentFree);
+
+pid_t
+virNSAgentGetTargetPid(virNSAgent *agent);
+
+bool
+virNSAgentIsBroken(virNSAgent *agent);
+
+int
+virNSAgentRun(virNSAgent *agent,
+              const char *command,
+              virJSONValue **args);
+
+int
+virNSAgentServe(int fd,
+                int status,
+                const virNSAgentCommand *commands);
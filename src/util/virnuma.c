@@ -1099,3 +1099,99 @@ virNumaNodesetToCPUset(virBitmap *nodeset,
 
     return 0;
 }
+
+
+/**
+ * virNumaParseNumaMaps:
+ * @maps: contents of /proc/$PID/numa_maps
+ * @memory: returned amount of memory per NUMA node (in KiB)
+ * @nmemory: number of items in @memory
+ *
+ * Sum up the memory of all mappings listed in @maps per NUMA node. The
+ * @memory array is indexed by NUMA node number.
+ *
+ * Returns 0 on success, -1 on error (with error reported).
+ */
+int
+virNumaParseNumaMaps(const char *maps,
+                     unsigned long long **memory,
+                     size_t *nmemory)
+{
+    g_auto(GStrv) lines = g_strsplit(maps, "\n", 0);
+    g_autofree unsigned long long *mem = NULL;
+    size_t nmem = 0;
+    char **line;
+
+    for (line = lines; *line; line++) {
+        g_auto(GStrv) fields = g_strsplit(*line, " ", 0);
+        unsigned long long pagesize = virGetSystemPageSizeKB();
+        char **field;
+
+        /* The page size is listed after the per node counts */
+        for (field = fields; *field; field++) {
+            if (STRPREFIX(*field, "kernelpagesize_kB=") &&
+                virStrToLong_ull(*field + strlen("kernelpagesize_kB="),
+                                 NULL, 10, &pagesize) < 0) {
+                virReportError(VIR_ERR_INTERNAL_ERROR,
+                               _("Unable to parse numa_maps entry '%1$s'"),
+                               *field);
+                return -1;
+            }
+        }
+
+        for (field = fields; *field; field++) {
+            unsigned int node;
+            unsigned long long pages;
+            char *end;
+
+            if (!STRPREFIX(*field, "N") ||
+                !g_ascii_isdigit((*field)[1]))
+                continue;
+
+            if (virStrToLong_ui(*field + 1, &end, 10, &node) < 0 ||
+                *end != '=' ||
+                virStrToLong_ull(end + 1, NULL, 10, &pages) < 0) {
+                virReportError(VIR_ERR_INTERNAL_ERROR,
+                               _("Unable to parse numa_maps entry '%1$s'"),
+                               *field);
+                return -1;
+            }
+
+            if (node >= nmem)
+                VIR_EXPAND_N(mem, nmem, node + 1 - nmem);
+
+            mem[node] += pages * pagesize;
+        }
+    }
+
+    *memory = g_steal_pointer(&mem);
+    *nmemory = nmem;
+    return 0;
+}
+
+
+/**
+ * virNumaGetProcessMemory:
+ * @pid: process ID
+ * @memory: returned amount of memory per NUMA node (in KiB)
+ * @nmemory: number of items in @memory
+ *
+ * Get the amount of memory of process @pid allocated from each NUMA node.
+ * See virNumaParseNumaMaps.
+ *
+ * Returns 0 on success, -1 on error (with error reported).
+ */
+int
+virNumaGetProcessMemory(pid_t pid,
+                        unsigned long long **memory,
+                        size_t *nmemory)
+{
+    g_autofree char *path = g_strdup_printf("/proc/%lld/numa_maps",
+                                            (long long) pid);
+    g_autofree char *maps = NULL;
+
+    if (virFileReadAll(path, 64 * 1024 * 1024, &maps) < 0)
+        return -1;
+
+    return virNumaParseNumaMaps(maps, memory, nmemory);
+}
@@ -56,7 +56,8 @@ int virNumaGetPageInfo(int node,
                        unsigned int page_size,
                        unsigned long long huge_page_sum,
                        unsigned long long *page_avail,
-                       unsigned long long *page_free);
+                       unsigned long long *page_free)
+    G_NO_INLINE;
 int virNumaGetPages(int node,
                     unsigned int **pages_size,
                     unsigned long long **pages_avail,
@@ -66,4 +67,12 @@ int virNumaGetPages(int node,
 int virNumaSetPagePoolSize(int node,
                            unsigned int page_size,
                            unsigned long long page_count,
-                           bool add);
+                           bool add)
+    G_NO_INLINE;
+
+int virNumaParseNumaMaps(const char *maps,
+                         unsigned long long **memory,
+                         size_t *nmemory);
+int virNumaGetProcessMemory(pid_t pid,
+                            unsigned long long **memory,
+                            size_t *nmemory);
@@ -0,0 +1,1450 @@
+/*
+ * virovsdb.c: Open vSwitch database protocol client
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every ovs-vsctl invocation connects to ovsdb-server, downloads the
+ * parts of the database it needs, commits a transaction and then waits
+ * for ovs-vswitchd to catch up. When many domains start at once they all
+ * queue up behind each other doing exactly that.
+ *
+ * This client keeps a single JSON-RPC (RFC 7047) connection to
+ * ovsdb-server open instead. Bridges, ports and interfaces are monitored
+ * so that lookups are answered from a local cache. Transactions submitted
+ * while another one is in flight are merged and committed together, which
+ * also means ovs-vswitchd is waited for only once per batch.
+ *
+ * Only one thread talks to the server at a time: whoever sets @busy
+ * owns the connection and the cache until it clears it again.
+ */
+
+#include <config.h>
+
+#include <unistd.h>
+#ifndef WIN32
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#include "virovsdb.h"
+#include "configmake.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+#include "virstring.h"
+#include "virthread.h"
+#include "virtime.h"
+#include "virutil.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("util.ovsdb");
+
+#define VIR_OVSDB_DATABASE "Open_vSwitch"
+
+/* Anything this large means that the stream got out of sync. */
+#define VIR_OVSDB_MAX_MESSAGE (64 * 1024 * 1024)
+
+typedef struct _virOVSDBRow virOVSDBRow;
+struct _virOVSDBRow {
+    char *name;
+    GStrv refs; /* Bridge.ports or Port.interfaces */
+};
+
+typedef struct _virOVSDBRequest virOVSDBRequest;
+struct _virOVSDBRequest {
+    virJSONValue *ops;
+    unsigned int flags;
+
+    virJSONValue *results;
+    virErrorPtr err;
+    int ret;
+    bool done;
+};
+
+struct _virOVSDBClient {
+    virMutex lock;
+    virCond cond;
+
+    char *path;
+    unsigned int timeout;
+
+    bool busy;
+    GPtrArray *queue; /* virOVSDBRequest */
+
+    /* The following is accessed only by the owner of the connection */
+    int fd;
+    unsigned long long serial;
+    GString *rbuf;
+
+    GHashTable *bridges;    /* uuid -> virOVSDBRow */
+    GHashTable *ports;      /* uuid -> virOVSDBRow */
+    GHashTable *interfaces; /* uuid -> virOVSDBRow */
+    long long curCfg;
+};
+
+static virOVSDBClient *virOVSDBDefault;
+
+
+static void
+virOVSDBRowFree(void *opaque)
+{
+    virOVSDBRow *row = opaque;
+
+    g_free(row->name);
+    g_strfreev(row->refs);
+    g_free(row);
+}
+
+
+/**
+ * virOVSDBClientNew:
+ * @path: path to the ovsdb-server UNIX socket
+ *
+ * Creates a client for the Open_vSwitch database served at @path. The
+ * connection is established by the first operation on the client.
+ *
+ * Returns the client on success, NULL with an error reported otherwise.
+ */
+virOVSDBClient *
+virOVSDBClientNew(const char *path)
+{
+    virOVSDBClient *client = g_new0(virOVSDBClient, 1);
+
+    if (virMutexInit(&client->lock) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to initialize mutex"));
+        g_free(client);
+        return NULL;
+    }
+
+    if (virCondInit(&client->cond) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to initialize condition variable"));
+        virMutexDestroy(&client->lock);
+        g_free(client);
+        return NULL;
+    }
+
+    client->path = g_strdup(path);
+    client->timeout = VIR_OVSDB_DEFAULT_TIMEOUT;
+    client->queue = g_ptr_array_new();
+    client->fd = -1;
+    client->rbuf = g_string_new(NULL);
+    client->bridges = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                            g_free, virOVSDBRowFree);
+    client->ports = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          g_free, virOVSDBRowFree);
+    client->interfaces = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, virOVSDBRowFree);
+
+    return client;
+}
+
+
+void
+virOVSDBClientFree(virOVSDBClient *client)
+{
+    if (!client)
+        return;
+
+    VIR_FORCE_CLOSE(client->fd);
+    g_ptr_array_unref(client->queue);
+    g_string_free(client->rbuf, TRUE);
+    g_hash_table_unref(client->bridges);
+    g_hash_table_unref(client->ports);
+    g_hash_table_unref(client->interfaces);
+    g_free(client->path);
+    virCondDestroy(&client->cond);
+    virMutexDestroy(&client->lock);
+    g_free(client);
+}
+
+
+/**
+ * virOVSDBClientSetTimeout:
+ * @client: OVSDB client
+ * @timeout: the timeout in seconds, 0 to wait forever
+ *
+ * Sets how long to wait for replies from ovsdb-server and for
+ * ovs-vswitchd to apply transactions.
+ */
+void
+virOVSDBClientSetTimeout(virOVSDBClient *client,
+                         unsigned int timeout)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&client->lock);
+
+    client->timeout = timeout;
+}
+
+
+static int
+virOVSDBOnceInit(void)
+{
+    const char *rundir = getenv("OVS_RUNDIR");
+    g_autofree char *path = NULL;
+
+    if (rundir)
+        path = g_strdup_printf("%s/db.sock", rundir);
+    else
+        path = g_strdup(RUNSTATEDIR "/openvswitch/db.sock");
+
+    if (!(virOVSDBDefault = virOVSDBClientNew(path)))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virOVSDB);
+
+
+/**
+ * virOVSDBGetDefault:
+ *
+ * Returns the client for the local ovsdb-server, or NULL if there is
+ * none. Operations on the client return -2 without reporting an error
+ * if the server is not reachable so that callers can fall back to
+ * ovs-vsctl.
+ */
+virOVSDBClient *
+virOVSDBGetDefault(void)
+{
+#ifdef WIN32
+    return NULL;
+#else
+    if (virOVSDBInitialize() < 0)
+        return NULL;
+
+    return virOVSDBDefault;
+#endif
+}
+
+
+/**
+ * virOVSDBNewUUIDName:
+ *
+ * Returns a name suitable as "uuid-name" of an insert operation. The
+ * names are unique so that operations of unrelated callers can be
+ * merged into one transaction.
+ */
+char *
+virOVSDBNewUUIDName(void)
+{
+    static int counter;
+
+    return g_strdup_printf("libvirt_row%u",
+                           (unsigned int) g_atomic_int_add(&counter, 1));
+}
+
+
+static virJSONValue *
+virOVSDBNewPair(const char *tag,
+                virJSONValue **value)
+{
+    g_autoptr(virJSONValue) ret = virJSONValueNewArray();
+
+    if (virJSONValueArrayAppendString(ret, tag) < 0 ||
+        virJSONValueArrayAppend(ret, value) < 0)
+        return NULL;
+
+    return g_steal_pointer(&ret);
+}
+
+
+/**
+ * virOVSDBNewUUID:
+ * @uuid: UUID of an existing row, or the uuid-name of a row inserted by
+ *        the same transaction if @named is true
+ *
+ * Returns a UUID atom referring to a row.
+ */
+virJSONValue *
+virOVSDBNewUUID(const char *uuid,
+                bool named)
+{
+    g_autoptr(virJSONValue) value = virJSONValueNewString(g_strdup(uuid));
+
+    return virOVSDBNewPair(named ? "named-uuid" : "uuid", &value);
+}
+
+
+/**
+ * virOVSDBNewSet:
+ *
+ * Returns an empty set, which is also how optional columns are cleared.
+ */
+virJSONValue *
+virOVSDBNewSet(void)
+{
+    g_autoptr(virJSONValue) atoms = virJSONValueNewArray();
+
+    return virOVSDBNewPair("set", &atoms);
+}
+
+
+int
+virOVSDBSetAppend(virJSONValue *set,
+                  virJSONValue **atom)
+{
+    return virJSONValueArrayAppend(virJSONValueArrayGet(set, 1), atom);
+}
+
+
+virJSONValue *
+virOVSDBNewMap(void)
+{
+    g_autoptr(virJSONValue) pairs = virJSONValueNewArray();
+
+    return virOVSDBNewPair("map", &pairs);
+}
+
+
+int
+virOVSDBMapAppend(virJSONValue *map,
+                  const char *key,
+                  const char *value)
+{
+    g_autoptr(virJSONValue) str = virJSONValueNewString(g_strdup(value));
+    g_autoptr(virJSONValue) pair = NULL;
+
+    if (!(pair = virOVSDBNewPair(key, &str)))
+        return -1;
+
+    return virJSONValueArrayAppend(virJSONValueArrayGet(map, 1), &pair);
+}
+
+
+/**
+ * virOVSDBNewClause:
+ * @column: column name
+ * @function: comparison function or mutator
+ * @value: the value to compare with or to mutate by, stolen
+ *
+ * Returns a condition for the "where" member of an operation, or a
+ * mutation for the "mutations" member of a mutate operation. Both have
+ * the same form.
+ */
+virJSONValue *
+virOVSDBNewClause(const char *column,
+                  const char *function,
+                  virJSONValue **value)
+{
+    g_autoptr(virJSONValue) ret = virJSONValueNewArray();
+
+    if (virJSONValueArrayAppendString(ret, column) < 0 ||
+        virJSONValueArrayAppendString(ret, function) < 0 ||
+        virJSONValueArrayAppend(ret, value) < 0)
+        return NULL;
+
+    return g_steal_pointer(&ret);
+}
+
+
+/**
+ * virOVSDBSplitMessage:
+ * @buf: data received from the server
+ * @len: length of @buf
+ *
+ * JSON-RPC messages are sent back to back without any framing. Finds
+ * the end of the first complete JSON object or array in @buf.
+ *
+ * Returns the length of the first message including any whitespace
+ * preceding it, or 0 if @buf doesn't hold a complete message yet.
+ */
+size_t
+virOVSDBSplitMessage(const char *buf,
+                     size_t len)
+{
+    size_t depth = 0;
+    bool string = false;
+    bool escape = false;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (string) {
+            if (escape)
+                escape = false;
+            else if (buf[i] == '\\')
+                escape = true;
+            else if (buf[i] == '"')
+                string = false;
+            continue;
+        }
+
+        switch (buf[i]) {
+        case '"':
+            string = true;
+            break;
+        case '{':
+        case '[':
+            depth++;
+            break;
+        case '}':
+        case ']':
+            if (depth > 0 && --depth == 0)
+                return i + 1;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+static const char *
+virOVSDBParseUUID(virJSONValue *atom)
+{
+    virJSONValue *type;
+    virJSONValue *uuid;
+
+    if (!atom ||
+        !virJSONValueIsArray(atom) ||
+        virJSONValueArraySize(atom) != 2 ||
+        !(type = virJSONValueArrayGet(atom, 0)) ||
+        !(uuid = virJSONValueArrayGet(atom, 1)) ||
+        STRNEQ_NULLABLE(virJSONValueGetString(type), "uuid"))
+        return NULL;
+
+    return virJSONValueGetString(uuid);
+}
+
+
+/* A set with a single member may be sent as just that member. */
+static GStrv
+virOVSDBParseUUIDSet(virJSONValue *datum)
+{
+    g_autoptr(GPtrArray) uuids = g_ptr_array_new_with_free_func(g_free);
+    virJSONValue *type = NULL;
+    virJSONValue *atoms = NULL;
+    const char *uuid;
+    size_t i;
+
+    if ((uuid = virOVSDBParseUUID(datum))) {
+        g_ptr_array_add(uuids, g_strdup(uuid));
+    } else if (virJSONValueIsArray(datum) &&
+               (type = virJSONValueArrayGet(datum, 0)) &&
+               (atoms = virJSONValueArrayGet(datum, 1)) &&
+               STREQ_NULLABLE(virJSONValueGetString(type), "set") &&
+               virJSONValueIsArray(atoms)) {
+        for (i = 0; i < virJSONValueArraySize(atoms); i++) {
+            if ((uuid = virOVSDBParseUUID(virJSONValueArrayGet(atoms, i))))
+                g_ptr_array_add(uuids, g_strdup(uuid));
+        }
+    }
+
+    g_ptr_array_add(uuids, NULL);
+    g_ptr_array_set_free_func(uuids, NULL);
+    return (GStrv) g_ptr_array_free(g_steal_pointer(&uuids), FALSE);
+}
+
+
+static void
+virOVSDBApplyRowUpdate(virOVSDBClient *client,
+                       const char *table,
+                       const char *uuid,
+                       virJSONValue *update)
+{
+    GHashTable *cache = NULL;
+    const char *refsColumn = NULL;
+    virOVSDBRow *row;
+    virJSONValue *new = virJSONValueObjectGetObject(update, "new");
+    virJSONValue *refs;
+    const char *name;
+
+    if (STREQ(table, "Open_vSwitch")) {
+        if (new)
+            ignore_value(virJSONValueObjectGetNumberLong(new, "cur_cfg",
+                                                         &client->curCfg));
+        return;
+    } else if (STREQ(table, "Bridge")) {
+        cache = client->bridges;
+        refsColumn = "ports";
+    } else if (STREQ(table, "Port")) {
+        cache = client->ports;
+        refsColumn = "interfaces";
+    } else if (STREQ(table, "Interface")) {
+        cache = client->interfaces;
+    } else {
+        return;
+    }
+
+    if (!new) {
+        g_hash_table_remove(cache, uuid);
+        return;
+    }
+
+    if (!(row = g_hash_table_lookup(cache, uuid))) {
+        row = g_new0(virOVSDBRow, 1);
+        g_hash_table_insert(cache, g_strdup(uuid), row);
+    }
+
+    if ((name = virJSONValueObjectGetString(new, "name"))) {
+        g_free(row->name);
+        row->name = g_strdup(name);
+    }
+
+    if (refsColumn && (refs = virJSONValueObjectGet(new, refsColumn))) {
+        g_strfreev(row->refs);
+        row->refs = virOVSDBParseUUIDSet(refs);
+    }
+}
+
+
+/* @updates is a <table-updates> object as sent by "update" notifications
+ * and returned by the "monitor" method. */
+static void
+virOVSDBApplyUpdates(virOVSDBClient *client,
+                     virJSONValue *updates)
+{
+    int ntables;
+    int i;
+
+    if (!virJSONValueIsObject(updates))
+        return;
+
+    ntables = virJSONValueObjectKeysNumber(updates);
+
+    for (i = 0; i < ntables; i++) {
+        const char *table = virJSONValueObjectGetKey(updates, i);
+        virJSONValue *rows = virJSONValueObjectGetValue(updates, i);
+        int nrows;
+        int j;
+
+        if (!virJSONValueIsObject(rows))
+            continue;
+
+        nrows = virJSONValueObjectKeysNumber(rows);
+
+        for (j = 0; j < nrows; j++) {
+            virJSONValue *update = virJSONValueObjectGetValue(rows, j);
+
+            if (!virJSONValueIsObject(update))
+                continue;
+
+            virOVSDBApplyRowUpdate(client, table,
+                                   virJSONValueObjectGetKey(rows, j), update);
+        }
+    }
+}
+
+
+static void
+virOVSDBDisconnect(virOVSDBClient *client)
+{
+    if (client->fd < 0)
+        return;
+
+    VIR_DEBUG("Closing connection to OVSDB server at %s", client->path);
+
+    VIR_FORCE_CLOSE(client->fd);
+    g_string_truncate(client->rbuf, 0);
+    g_hash_table_remove_all(client->bridges);
+    g_hash_table_remove_all(client->ports);
+    g_hash_table_remove_all(client->interfaces);
+    client->curCfg = 0;
+}
+
+
+static int
+virOVSDBSend(virOVSDBClient *client,
+             virJSONValue *msg)
+{
+    g_autofree char *str = NULL;
+
+    if (!(str = virJSONValueToString(msg, false)))
+        return -1;
+
+    VIR_DEBUG("Send: %s", str);
+
+    if (safewrite(client->fd, str, strlen(str)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to write to OVSDB server"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static unsigned long long
+virOVSDBDeadline(virOVSDBClient *client)
+{
+    unsigned long long now;
+
+    if (client->timeout == 0 ||
+        virTimeMillisNow(&now) < 0)
+        return ULLONG_MAX;
+
+    return now + client->timeout * 1000ull;
+}
+
+
+/*
+ * Reads the next message from the server. If none is buffered, waits
+ * for one until @deadline or doesn't wait at all if @deadline is 0.
+ *
+ * Returns 1 with @msg filled, 0 if no message arrived in time and -1 with
+ * an error reported otherwise.
+ */
+static int
+virOVSDBReadMessage(virOVSDBClient *client,
+                    unsigned long long deadline,
+                    virJSONValue **msg)
+{
+#ifndef WIN32
+    while (true) {
+        struct pollfd pfd = { .fd = client->fd, .events = POLLIN };
+        char buf[16384];
+        unsigned long long now;
+        int timeout = 0;
+        ssize_t got;
+        size_t len;
+        int rc;
+
+        if ((len = virOVSDBSplitMessage(client->rbuf->str, client->rbuf->len)) > 0) {
+            g_autofree char *str = g_strndup(client->rbuf->str, len);
+
+            g_string_erase(client->rbuf, 0, len);
+
+            VIR_DEBUG("Received: %s", str);
+
+            if (!(*msg = virJSONValueFromString(str)))
+                return -1;
+
+            return 1;
+        }
+
+        if (client->rbuf->len > VIR_OVSDB_MAX_MESSAGE) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("OVSDB server message is too large"));
+            return -1;
+        }
+
+        if (deadline > 0) {
+            if (virTimeMillisNow(&now) < 0)
+                return -1;
+
+            if (now >= deadline)
+                return 0;
+
+            timeout = MIN(deadline - now, INT_MAX);
+        }
+
+        if ((rc = poll(&pfd, 1, timeout)) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            virReportSystemError(errno, "%s",
+                                 _("Unable to poll OVSDB server connection"));
+            return -1;
+        }
+
+        if (rc == 0)
+            return 0;
+
+        if ((got = read(client->fd, buf, sizeof(buf))) < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+
+            virReportSystemError(errno, "%s",
+                                 _("Unable to read from OVSDB server"));
+            return -1;
+        }
+
+        if (got == 0) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("OVSDB server closed the connection"));
+            return -1;
+        }
+
+        g_string_append_len(client->rbuf, buf, got);
+    }
+#else /* WIN32 */
+    virReportSystemError(ENOSYS, "%s",
+                         _("OVSDB is not supported on this platform"));
+    return -1;
+#endif /* WIN32 */
+}
+
+
+/*
+ * Handles notifications and requests sent by the server.
+ *
+ * Returns 1 if @msg is the reply to the request with @id, 0 if it was
+ * something else and -1 on error.
+ */
+static int
+virOVSDBHandleMessage(virOVSDBClient *client,
+                      virJSONValue *msg,
+                      unsigned long long id)
+{
+    const char *method = virJSONValueObjectGetString(msg, "method");
+    virJSONValue *params = virJSONValueObjectGetArray(msg, "params");
+    unsigned long long replyid;
+
+    if (!method) {
+        if (virJSONValueObjectGetNumberUlong(msg, "id", &replyid) == 0 &&
+            replyid == id)
+            return 1;
+
+        VIR_DEBUG("Ignoring unexpected OVSDB reply");
+        return 0;
+    }
+
+    if (STREQ(method, "update")) {
+        if (params)
+            virOVSDBApplyUpdates(client, virJSONValueArrayGet(params, 1));
+        return 0;
+    }
+
+    if (STREQ(method, "echo")) {
+        g_autoptr(virJSONValue) reply = NULL;
+        g_autoptr(virJSONValue) result = NULL;
+        g_autoptr(virJSONValue) echoid = NULL;
+
+        result = params ? virJSONValueCopy(params) : virJSONValueNewArray();
+        if (virJSONValueObjectHasKey(msg, "id") == 1)
+            echoid = virJSONValueCopy(virJSONValueObjectGet(msg, "id"));
+        else
+            echoid = virJSONValueNewNull();
+
+        if (virJSONValueObjectAdd(&reply,
+                                  "a:result", &result,
+                                  "n:error",
+                                  "a:id", &echoid,
+                                  NULL) < 0)
+            return -1;
+
+        return virOVSDBSend(client, reply);
+    }
+
+    VIR_DEBUG("Ignoring unsupported OVSDB method '%s'", method);
+    return 0;
+}
+
+
+/*
+ * Calls @method and waits for its reply. @params is stolen.
+ *
+ * Returns 0 with @result filled, -1 with an error reported otherwise.
+ * Only errors reported by the server in the reply leave the connection
+ * open.
+ */
+static int
+virOVSDBCall(virOVSDBClient *client,
+             const char *method,
+             virJSONValue **params,
+             virJSONValue **result)
+{
+    g_autoptr(virJSONValue) msg = NULL;
+    unsigned long long id = ++client->serial;
+    unsigned long long deadline = virOVSDBDeadline(client);
+
+    if (virJSONValueObjectAdd(&msg,
+                              "s:method", method,
+                              "a:params", params,
+                              "U:id", id,
+                              NULL) < 0)
+        return -1;
+
+    if (virOVSDBSend(client, msg) < 0)
+        goto error;
+
+    while (true) {
+        g_autoptr(virJSONValue) reply = NULL;
+        virJSONValue *error;
+        int rc;
+
+        if ((rc = virOVSDBReadMessage(client, deadline, &reply)) < 0)
+            goto error;
+
+        if (rc == 0) {
+            virReportError(VIR_ERR_OPERATION_TIMEOUT,
+                           _("timed out waiting for OVSDB server to reply to '%1$s'"),
+                           method);
+            goto error;
+        }
+
+        if ((rc = virOVSDBHandleMessage(client, reply, id)) < 0)
+            goto error;
+
+        if (rc == 0)
+            continue;
+
+        if ((error = virJSONValueObjectGet(reply, "error")) &&
+            virJSONValueGetType(error) != VIR_JSON_TYPE_NULL) {
+            g_autofree char *str = virJSONValueToString(error, false);
+
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("OVSDB method '%1$s' failed: %2$s"),
+                           method, NULLSTR(str));
+            return -1;
+        }
+
+        if (virJSONValueObjectRemoveKey(reply, "result", result) <= 0) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("malformed OVSDB reply to '%1$s'"), method);
+            goto error;
+        }
+
+        return 0;
+    }
+
+ error:
+    virOVSDBDisconnect(client);
+    return -1;
+}
+
+
+static virJSONValue *
+virOVSDBNewMonitorRequest(const char *table,
+                          const char *column,
+                          ...)
+{
+    g_autoptr(virJSONValue) columns = virJSONValueNewArray();
+    g_autoptr(virJSONValue) ret = NULL;
+    va_list args;
+
+    va_start(args, column);
+    for (; column; column = va_arg(args, const char *)) {
+        if (virJSONValueArrayAppendString(columns, column) < 0) {
+            va_end(args);
+            return NULL;
+        }
+    }
+    va_end(args);
+
+    if (virJSONValueObjectAdd(&ret, "a:columns", &columns, NULL) < 0)
+        return NULL;
+
+    return g_steal_pointer(&ret);
+}
+
+
+/*
+ * Connects to the server unless already connected and starts monitoring
+ * the tables that are cached.
+ *
+ * Returns 0 on success, -2 without reporting an error if the server is
+ * not reachable and -1 on other errors.
+ */
+static int
+virOVSDBConnect(virOVSDBClient *client)
+{
+#ifndef WIN32
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    g_autoptr(virJSONValue) params = NULL;
+    g_autoptr(virJSONValue) monitorid = NULL;
+    g_autoptr(virJSONValue) requests = NULL;
+    g_autoptr(virJSONValue) bridge = NULL;
+    g_autoptr(virJSONValue) port = NULL;
+    g_autoptr(virJSONValue) iface = NULL;
+    g_autoptr(virJSONValue) ovs = NULL;
+    g_autoptr(virJSONValue) result = NULL;
+    VIR_AUTOCLOSE fd = -1;
+
+    if (client->fd >= 0)
+        return 0;
+
+    if (virStrcpyStatic(addr.sun_path, client->path) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("OVSDB socket path '%1$s' too long"),
+                       client->path);
+        return -1;
+    }
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        virReportSystemError(errno, "%s", _("Unable to create socket"));
+        return -1;
+    }
+
+    if (virSetCloseExec(fd) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to set close-on-exec flag"));
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        VIR_DEBUG("Unable to connect to OVSDB server at %s: %s",
+                  client->path, g_strerror(errno));
+        return -2;
+    }
+
+    client->fd = fd;
+    fd = -1;
+
+    if (!(bridge = virOVSDBNewMonitorRequest("Bridge", "name", "ports", NULL)) ||
+        !(port = virOVSDBNewMonitorRequest("Port", "name", "interfaces", NULL)) ||
+        !(iface = virOVSDBNewMonitorRequest("Interface", "name", NULL)) ||
+        !(ovs = virOVSDBNewMonitorRequest("Open_vSwitch", "cur_cfg", NULL)) ||
+        virJSONValueObjectAdd(&requests,
+                              "a:Bridge", &bridge,
+                              "a:Port", &port,
+                              "a:Interface", &iface,
+                              "a:Open_vSwitch", &ovs,
+                              NULL) < 0) {
+        virOVSDBDisconnect(client);
+        return -1;
+    }
+
+    params = virJSONValueNewArray();
+    monitorid = virJSONValueNewNull();
+    if (virJSONValueArrayAppendString(params, VIR_OVSDB_DATABASE) < 0 ||
+        virJSONValueArrayAppend(params, &monitorid) < 0 ||
+        virJSONValueArrayAppend(params, &requests) < 0) {
+        virOVSDBDisconnect(client);
+        return -1;
+    }
+
+    if (virOVSDBCall(client, "monitor", &params, &result) < 0) {
+        virOVSDBDisconnect(client);
+        return -1;
+    }
+
+    virOVSDBApplyUpdates(client, result);
+
+    VIR_DEBUG("Connected to OVSDB server at %s, cur_cfg=%lld",
+              client->path, client->curCfg);
+
+    return 0;
+#else /* WIN32 */
+    return -2;
+#endif /* WIN32 */
+}
+
+
+/* Processes whatever the server sent since we last looked. */
+static int
+virOVSDBDrain(virOVSDBClient *client)
+{
+    while (true) {
+        g_autoptr(virJSONValue) msg = NULL;
+        int rc;
+
+        if ((rc = virOVSDBReadMessage(client, 0, &msg)) < 0 ||
+            (rc > 0 && virOVSDBHandleMessage(client, msg, 0) < 0)) {
+            virOVSDBDisconnect(client);
+            return -1;
+        }
+
+        if (rc == 0)
+            return 0;
+    }
+}
+
+
+/* Waits until ovs-vswitchd has caught up with configuration @cfg. */
+static int
+virOVSDBWaitCfg(virOVSDBClient *client,
+                long long cfg)
+{
+    unsigned long long deadline = virOVSDBDeadline(client);
+
+    while (client->curCfg < cfg) {
+        g_autoptr(virJSONValue) msg = NULL;
+        int rc;
+
+        if ((rc = virOVSDBReadMessage(client, deadline, &msg)) < 0 ||
+            (rc > 0 && virOVSDBHandleMessage(client, msg, 0) < 0)) {
+            virOVSDBDisconnect(client);
+            return -1;
+        }
+
+        if (rc == 0) {
+            virReportError(VIR_ERR_OPERATION_TIMEOUT, "%s",
+                           _("timed out waiting for ovs-vswitchd to apply configuration"));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* Appends operations which make ovs-vswitchd acknowledge the transaction
+ * by bumping cur_cfg once it applied it. */
+static int
+virOVSDBAppendWaitOps(virJSONValue *params)
+{
+    g_autoptr(virJSONValue) one = virJSONValueNewNumberInt(1);
+    g_autoptr(virJSONValue) mutation = NULL;
+    g_autoptr(virJSONValue) mutations = virJSONValueNewArray();
+    g_autoptr(virJSONValue) columns = virJSONValueNewArray();
+    g_autoptr(virJSONValue) mutateWhere = virJSONValueNewArray();
+    g_autoptr(virJSONValue) selectWhere = virJSONValueNewArray();
+    g_autoptr(virJSONValue) mutate = NULL;
+    g_autoptr(virJSONValue) select = NULL;
+
+    if (!(mutation = virOVSDBNewClause("next_cfg", "+=", &one)) ||
+        virJSONValueArrayAppend(mutations, &mutation) < 0 ||
+        virJSONValueArrayAppendString(columns, "next_cfg") < 0)
+        return -1;
+
+    if (virJSONValueObjectAdd(&mutate,
+                              "s:op", "mutate",
+                              "s:table", "Open_vSwitch",
+                              "a:where", &mutateWhere,
+                              "a:mutations", &mutations,
+                              NULL) < 0 ||
+        virJSONValueObjectAdd(&select,
+                              "s:op", "select",
+                              "s:table", "Open_vSwitch",
+                              "a:where", &selectWhere,
+                              "a:columns", &columns,
+                              NULL) < 0)
+        return -1;
+
+    if (virJSONValueArrayAppend(params, &mutate) < 0 ||
+        virJSONValueArrayAppend(params, &select) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+/*
+ * Commits @ops as one transaction and, if @wait is true, waits for
+ * ovs-vswitchd to apply it.
+ *
+ * Returns 0 with one result per operation in @results. Otherwise -1 is
+ * returned with an error reported and @rejected tells whether the server
+ * refused the transaction, that is it had no effect at all.
+ */
+static int
+virOVSDBRunTransact(virOVSDBClient *client,
+                    virJSONValue *ops,
+                    bool wait,
+                    virJSONValue **results,
+                    bool *rejected)
+{
+    g_autoptr(virJSONValue) params = virJSONValueNewArray();
+    g_autoptr(virJSONValue) copy = virJSONValueCopy(ops);
+    g_autoptr(virJSONValue) reply = NULL;
+    g_autoptr(virJSONValue) ret = virJSONValueNewArray();
+    size_t nops = virJSONValueArraySize(ops);
+    long long nextCfg;
+    size_t i;
+
+    *rejected = false;
+
+    if (virJSONValueArrayAppendString(params, VIR_OVSDB_DATABASE) < 0 ||
+        virJSONValueArrayConcat(params, copy) < 0 ||
+        (wait && virOVSDBAppendWaitOps(params) < 0))
+        return -1;
+
+    if (virOVSDBCall(client, "transact", &params, &reply) < 0)
+        return -1;
+
+    if (!virJSONValueIsArray(reply))
+        goto malformed;
+
+    for (i = 0; i < virJSONValueArraySize(reply); i++) {
+        virJSONValue *res = virJSONValueArrayGet(reply, i);
+        const char *error;
+
+        if (!virJSONValueIsObject(res) ||
+            !(error = virJSONValueObjectGetString(res, "error")))
+            continue;
+
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("OVSDB transaction failed: %1$s: %2$s"),
+                       error, NULLSTR(virJSONValueObjectGetString(res, "details")));
+        *rejected = true;
+        return -1;
+    }
+
+    if (virJSONValueArraySize(reply) < nops + (wait ? 2 : 0))
+        goto malformed;
+
+    if (wait) {
+        virJSONValue *select = virJSONValueArrayGet(reply, nops + 1);
+        virJSONValue *rows = virJSONValueObjectGetArray(select, "rows");
+        virJSONValue *row = rows ? virJSONValueArrayGet(rows, 0) : NULL;
+
+        if (!row ||
+            virJSONValueObjectGetNumberLong(row, "next_cfg", &nextCfg) < 0)
+            goto malformed;
+
+        if (virOVSDBWaitCfg(client, nextCfg) < 0)
+            return -1;
+    }
+
+    for (i = 0; i < nops; i++) {
+        g_autoptr(virJSONValue) res = virJSONValueCopy(virJSONValueArrayGet(reply, i));
+
+        if (virJSONValueArrayAppend(ret, &res) < 0)
+            return -1;
+    }
+
+    *results = g_steal_pointer(&ret);
+    return 0;
+
+ malformed:
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("malformed OVSDB transaction reply"));
+    return -1;
+}
+
+
+static void
+virOVSDBRequestFail(virOVSDBRequest *req,
+                    int rc)
+{
+    req->ret = rc;
+    if (rc == -1)
+        req->err = virSaveLastError();
+}
+
+
+static void
+virOVSDBRunRequest(virOVSDBClient *client,
+                   virOVSDBRequest *req)
+{
+    bool rejected;
+    int rc;
+
+    if ((rc = virOVSDBConnect(client)) < 0 ||
+        (rc = virOVSDBRunTransact(client, req->ops,
+                                  req->flags & VIR_OVSDB_TRANSACT_WAIT,
+                                  &req->results, &rejected)) < 0) {
+        virOVSDBRequestFail(req, rc);
+        return;
+    }
+
+    req->ret = 0;
+}
+
+
+/*
+ * Commits the queued requests in @batch. They are merged into a single
+ * transaction first, if the server rejects that one they are retried one
+ * by one so that a bad request doesn't fail the others.
+ */
+static void
+virOVSDBRunBatch(virOVSDBClient *client,
+                 GPtrArray *batch)
+{
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autoptr(virJSONValue) results = NULL;
+    bool wait = false;
+    bool rejected = false;
+    size_t offset = 0;
+    size_t i;
+    int rc;
+
+    if (batch->len > 1) {
+        for (i = 0; i < batch->len; i++) {
+            virOVSDBRequest *req = g_ptr_array_index(batch, i);
+            g_autoptr(virJSONValue) copy = virJSONValueCopy(req->ops);
+
+            if (virJSONValueArrayConcat(ops, copy) < 0)
+                goto error;
+
+            if (req->flags & VIR_OVSDB_TRANSACT_WAIT)
+                wait = true;
+        }
+
+        VIR_DEBUG("Committing %u OVSDB requests in one transaction", batch->len);
+
+        if ((rc = virOVSDBConnect(client)) < 0 ||
+            (rc = virOVSDBRunTransact(client, ops, wait,
+                                      &results, &rejected)) < 0) {
+            if (rejected) {
+                VIR_DEBUG("Merged OVSDB transaction rejected, retrying requests one by one");
+                virResetLastError();
+                goto individual;
+            }
+
+            for (i = 0; i < batch->len; i++)
+                virOVSDBRequestFail(g_ptr_array_index(batch, i), rc);
+
+            virResetLastError();
+            return;
+        }
+
+        for (i = 0; i < batch->len; i++) {
+            virOVSDBRequest *req = g_ptr_array_index(batch, i);
+            size_t nops = virJSONValueArraySize(req->ops);
+            size_t j;
+
+            req->results = virJSONValueNewArray();
+
+            for (j = 0; j < nops; j++) {
+                g_autoptr(virJSONValue) res = NULL;
+
+                res = virJSONValueCopy(virJSONValueArrayGet(results, offset + j));
+
+                if (virJSONValueArrayAppend(req->results, &res) < 0)
+                    goto error;
+            }
+
+            offset += nops;
+            req->ret = 0;
+        }
+
+        return;
+    }
+
+ individual:
+    for (i = 0; i < batch->len; i++) {
+        virOVSDBRunRequest(client, g_ptr_array_index(batch, i));
+        virResetLastError();
+    }
+
+    return;
+
+ error:
+    for (i = 0; i < batch->len; i++) {
+        virOVSDBRequest *req = g_ptr_array_index(batch, i);
+
+        g_clear_pointer(&req->results, virJSONValueFree);
+        virOVSDBRequestFail(req, -1);
+    }
+
+    virResetLastError();
+}
+
+
+/**
+ * virOVSDBTransact:
+ * @client: OVSDB client
+ * @ops: array of operations, stolen
+ * @flags: bitwise-OR of virOVSDBTransactFlags
+ * @results: filled with the array of operation results (may be NULL)
+ *
+ * Commits @ops to the Open_vSwitch database. Operations submitted by
+ * several threads at the same time may be committed in one transaction,
+ * therefore rows inserted by @ops must be named by virOVSDBNewUUIDName().
+ *
+ * Returns 0 on success, -2 without reporting an error if the server is
+ * not reachable and -1 with an error reported otherwise.
+ */
+int
+virOVSDBTransact(virOVSDBClient *client,
+                 virJSONValue **ops,
+                 unsigned int flags,
+                 virJSONValue **results)
+{
+    virOVSDBRequest req = { 0 };
+
+    virCheckFlags(VIR_OVSDB_TRANSACT_WAIT, -1);
+
+    if (!virJSONValueIsArray(*ops)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("OVSDB operations must be an array"));
+        return -1;
+    }
+
+    req.ops = g_steal_pointer(ops);
+    req.flags = flags;
+
+    virMutexLock(&client->lock);
+
+    g_ptr_array_add(client->queue, &req);
+
+    while (!req.done) {
+        g_autoptr(GPtrArray) batch = NULL;
+        size_t i;
+
+        if (client->busy) {
+            ignore_value(virCondWait(&client->cond, &client->lock));
+            continue;
+        }
+
+        client->busy = true;
+        batch = g_steal_pointer(&client->queue);
+        client->queue = g_ptr_array_new();
+        virMutexUnlock(&client->lock);
+
+        virOVSDBRunBatch(client, batch);
+
+        virMutexLock(&client->lock);
+        for (i = 0; i < batch->len; i++)
+            ((virOVSDBRequest *) g_ptr_array_index(batch, i))->done = true;
+        client->busy = false;
+        virCondBroadcast(&client->cond);
+    }
+
+    virMutexUnlock(&client->lock);
+
+    virJSONValueFree(req.ops);
+
+    if (req.ret < 0) {
+        virErrorRestore(&req.err);
+        return req.ret;
+    }
+
+    if (results)
+        *results = g_steal_pointer(&req.results);
+    else
+        virJSONValueFree(req.results);
+
+    return 0;
+}
+
+
+/* Takes over the connection and brings the cache up to date. */
+static int
+virOVSDBAcquire(virOVSDBClient *client)
+{
+    int rc;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&client->lock) {
+        while (client->busy)
+            ignore_value(virCondWait(&client->cond, &client->lock));
+        client->busy = true;
+    }
+
+    if ((rc = virOVSDBConnect(client)) < 0)
+        return rc;
+
+    return virOVSDBDrain(client);
+}
+
+
+static void
+virOVSDBRelease(virOVSDBClient *client)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&client->lock);
+
+    client->busy = false;
+    virCondBroadcast(&client->cond);
+}
+
+
+static const char *
+virOVSDBFindRow(GHashTable *cache,
+                const char *name)
+{
+    GHashTableIter iter;
+    const char *uuid;
+    virOVSDBRow *row;
+
+    g_hash_table_iter_init(&iter, cache);
+    while (g_hash_table_iter_next(&iter, (void **) &uuid, (void **) &row)) {
+        if (STREQ_NULLABLE(row->name, name))
+            return uuid;
+    }
+
+    return NULL;
+}
+
+
+static virOVSDBRow *
+virOVSDBFindParent(GHashTable *cache,
+                   const char *child,
+                   const char **uuid)
+{
+    GHashTableIter iter;
+    virOVSDBRow *row;
+
+    g_hash_table_iter_init(&iter, cache);
+    while (g_hash_table_iter_next(&iter, (void **) uuid, (void **) &row)) {
+        if (row->refs && g_strv_contains((const char **) row->refs, child))
+            return row;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * virOVSDBGetPort:
+ * @client: OVSDB client
+ * @name: name of the port
+ * @portuuid: filled with the UUID of the port (may be NULL)
+ * @brname: filled with the name of the bridge the port is on (may be NULL)
+ *
+ * Looks up port @name in the cached bridge configuration.
+ *
+ * Returns 1 if the port was found, 0 if it doesn't exist, -2 without
+ * reporting an error if the server is not reachable and -1 with an error
+ * reported otherwise.
+ */
+int
+virOVSDBGetPort(virOVSDBClient *client,
+                const char *name,
+                char **portuuid,
+                char **brname)
+{
+    const char *uuid;
+    const char *bruuid;
+    virOVSDBRow *bridge;
+    int ret;
+
+    if ((ret = virOVSDBAcquire(client)) < 0)
+        goto cleanup;
+
+    if (!(uuid = virOVSDBFindRow(client->ports, name)) ||
+        !(bridge = virOVSDBFindParent(client->bridges, uuid, &bruuid)))
+        goto cleanup;
+
+    if (portuuid)
+        *portuuid = g_strdup(uuid);
+    if (brname)
+        *brname = g_strdup(bridge->name);
+    ret = 1;
+
+ cleanup:
+    virOVSDBRelease(client);
+    return ret;
+}
+
+
+/**
+ * virOVSDBGetInterfaceBridge:
+ * @client: OVSDB client
+ * @ifname: name of the interface
+ * @brname: filled with the name of the bridge @ifname is on
+ *
+ * Looks up the bridge interface @ifname belongs to in the cached
+ * bridge configuration, like 'ovs-vsctl iface-to-br' does.
+ *
+ * Returns 1 if the bridge was found, 0 if @ifname is not on any bridge,
+ * -2 without reporting an error if the server is not reachable and -1
+ * with an error reported otherwise.
+ */
+int
+virOVSDBGetInterfaceBridge(virOVSDBClient *client,
+                           const char *ifname,
+                           char **brname)
+{
+    const char *uuid;
+    const char *portuuid;
+    const char *bruuid;
+    virOVSDBRow *bridge;
+    int ret;
+
+    *brname = NULL;
+
+    if ((ret = virOVSDBAcquire(client)) < 0)
+        goto cleanup;
+
+    if (!(uuid = virOVSDBFindRow(client->interfaces, ifname)) ||
+        !virOVSDBFindParent(client->ports, uuid, &portuuid) ||
+        !(bridge = virOVSDBFindParent(client->bridges, portuuid, &bruuid)))
+        goto cleanup;
+
+    *brname = g_strdup(bridge->name);
+    ret = 1;
+
+ cleanup:
+    virOVSDBRelease(client);
+    return ret;
+}
@@ -0,0 +1,96 @@
+/*
+ * virovsdb.h: Open vSwitch database protocol client
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "virjson.h"
+
+#define VIR_OVSDB_DEFAULT_TIMEOUT 5
+
+typedef struct _virOVSDBClient virOVSDBClient;
+
+typedef enum {
+    /* wait until ovs-vswitchd has applied the transaction */
+    VIR_OVSDB_TRANSACT_WAIT = 1 << 0,
+} virOVSDBTransactFlags;
+
+virOVSDBClient *
+virOVSDBClientNew(const char *path);
+
+void
+virOVSDBClientFree(virOVSDBClient *client);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virOVSDBClient, virOVSDBClientFree);
+
+void
+virOVSDBClientSetTimeout(virOVSDBClient *client,
+                         unsigned int timeout);
+
+virOVSDBClient *
+virOVSDBGetDefault(void) G_NO_INLINE;
+
+char *
+virOVSDBNewUUIDName(void);
+
+virJSONValue *
+virOVSDBNewUUID(const char *uuid,
+                bool named);
+
+virJSONValue *
+virOVSDBNewSet(void);
+
+int
+virOVSDBSetAppend(virJSONValue *set,
+                  virJSONValue **atom);
+
+virJSONValue *
+virOVSDBNewMap(void);
+
+int
+virOVSDBMapAppend(virJSONValue *map,
+                  const char *key,
+                  const char *value);
+
+virJSONValue *
+virOVSDBNewClause(const char *column,
+                  const char *function,
+                  virJSONValue **value);
+
+size_t
+virOVSDBSplitMessage(const char *buf,
+                     size_t len);
+
+int
+virOVSDBTransact(virOVSDBClient *client,
+                 virJSONValue **ops,
+                 unsigned int flags,
+                 virJSONValue **results)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2);
+
+int
+virOVSDBGetPort(virOVSDBClient *client,
+                const char *name,
+                char **portuuid,
+                char **brname)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2);
+
+int
+virOVSDBGetInterfaceBridge(virOVSDBClient *client,
+                           const char *ifname,
+                           char **brname)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(3);
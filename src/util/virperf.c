@@ -49,9 +49,21 @@ VIR_ENUM_IMPL(virPerfEvent,
               "alignment_faults", "emulation_faults",
 );
 
+/* Events of the same kind are opened as a group so that all of them are
+ * read by a single read() of the group leader. RDT events live on a PMU of
+ * their own and are never grouped. */
+typedef enum {
+    VIR_PERF_GROUP_HARDWARE,
+    VIR_PERF_GROUP_SOFTWARE,
+
+    VIR_PERF_GROUP_LAST
+} virPerfGroup;
+
 struct virPerfEvent {
     int fd;
     bool enabled;
+    int group; /* virPerfGroup, -1 if the event is read on its own */
+    uint64_t id; /* kernel ID of a grouped event */
     union {
         /* cmt */
         struct {
@@ -62,6 +74,9 @@ struct virPerfEvent {
 
 struct _virPerf {
     struct virPerfEvent events[VIR_PERF_EVENT_LAST];
+    /* virPerfEventType of the leader of each group, -1 if it's empty */
+    int leaders[VIR_PERF_GROUP_LAST];
+    pid_t pid;
 };
 
 #if defined(__linux__) && defined(WITH_SYS_SYSCALL_H)
@@ -198,17 +213,39 @@ virPerfRdtAttrInit(void)
 }
 
 
-int
-virPerfEventEnable(virPerf *perf,
-                   virPerfEventType type,
-                   pid_t pid)
+static int
+virPerfEventGetGroup(virPerfEventType type)
+{
+    switch (attrs[type].attrType) {
+    case PERF_TYPE_HARDWARE:
+        return VIR_PERF_GROUP_HARDWARE;
+    case PERF_TYPE_SOFTWARE:
+        return VIR_PERF_GROUP_SOFTWARE;
+    }
+
+    return -1;
+}
+
+
+static int
+virPerfEventOpen(struct perf_event_attr *attr,
+                 pid_t pid,
+                 int groupFD)
+{
+    return syscall(__NR_perf_event_open, attr, pid, -1, groupFD, 0);
+}
+
+
+static int
+virPerfEventEnableInternal(virPerf *perf,
+                           virPerfEventType type,
+                           pid_t pid)
 {
     struct perf_event_attr attr = { 0 };
     struct virPerfEvent *event = &(perf->events[type]);
     struct virPerfEventAttr *event_attr = &attrs[type];
-
-    if (event->enabled)
-        return 0;
+    int group = virPerfEventGetGroup(type);
+    int leader = group >= 0 ? perf->leaders[group] : -1;
 
     if (event_attr->attrType == 0 && (type == VIR_PERF_EVENT_CMT ||
                                       type == VIR_PERF_EVENT_MBMT ||
@@ -240,7 +277,34 @@ virPerfEventEnable(virPerf *perf,
     attr.type = event_attr->attrType;
     attr.config = event_attr->attrConfig;
 
-    event->fd = syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+    event->group = -1;
+
+    if (leader >= 0) {
+        /* Members follow the state of the leader which is enabled already */
+        attr.disabled = 0;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        event->fd = virPerfEventOpen(&attr, pid, perf->events[leader].fd);
+
+        /* The PMU may not be able to count the whole group at once, read
+         * the event on its own then. */
+        if (event->fd < 0 && errno == EINVAL) {
+            VIR_DEBUG("Unable to add %s to perf event group, reading it separately",
+                      virPerfEventTypeToString(type));
+            attr.disabled = 1;
+            attr.read_format = 0;
+            group = -1;
+            event->fd = virPerfEventOpen(&attr, pid, -1);
+        }
+    } else {
+        if (group >= 0)
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        event->fd = virPerfEventOpen(&attr, pid, -1);
+    }
+
     if (event->fd < 0) {
         virReportSystemError(errno,
                              _("unable to open host cpu perf event for %1$s"),
@@ -248,13 +312,26 @@ virPerfEventEnable(virPerf *perf,
         goto error;
     }
 
-    if (ioctl(event->fd, PERF_EVENT_IOC_ENABLE) < 0) {
+    if (group >= 0 &&
+        ioctl(event->fd, PERF_EVENT_IOC_ID, &event->id) < 0) {
+        virReportSystemError(errno,
+                             _("unable to get ID of host cpu perf event for %1$s"),
+                             virPerfEventTypeToString(type));
+        goto error;
+    }
+
+    if (attr.disabled &&
+        ioctl(event->fd, PERF_EVENT_IOC_ENABLE) < 0) {
         virReportSystemError(errno,
                              _("unable to enable host cpu perf event for %1$s"),
                              virPerfEventTypeToString(type));
         goto error;
     }
 
+    if (group >= 0 && leader < 0)
+        perf->leaders[group] = type;
+
+    event->group = group;
     event->enabled = true;
     return 0;
 
@@ -263,15 +340,29 @@ virPerfEventEnable(virPerf *perf,
     return -1;
 }
 
+
 int
-virPerfEventDisable(virPerf *perf,
-                    virPerfEventType type)
+virPerfEventEnable(virPerf *perf,
+                   virPerfEventType type,
+                   pid_t pid)
 {
-    struct virPerfEvent *event = &(perf->events[type]);
-
-    if (!event->enabled)
+    if (perf->events[type].enabled)
         return 0;
 
+    if (virPerfEventEnableInternal(perf, type, pid) < 0)
+        return -1;
+
+    perf->pid = pid;
+    return 0;
+}
+
+
+static int
+virPerfEventClose(virPerf *perf,
+                  virPerfEventType type)
+{
+    struct virPerfEvent *event = &(perf->events[type]);
+
     if (ioctl(event->fd, PERF_EVENT_IOC_DISABLE) < 0) {
         virReportSystemError(errno,
                              _("unable to disable host cpu perf event for %1$s"),
@@ -280,33 +371,191 @@ virPerfEventDisable(virPerf *perf,
     }
 
     event->enabled = false;
+    event->group = -1;
     VIR_FORCE_CLOSE(event->fd);
     return 0;
 }
 
+
+int
+virPerfEventDisable(virPerf *perf,
+                    virPerfEventType type)
+{
+    struct virPerfEvent *event = &(perf->events[type]);
+    int group = event->group;
+    bool members[VIR_PERF_EVENT_LAST] = { false };
+    size_t i;
+
+    if (!event->enabled)
+        return 0;
+
+    if (group < 0 || perf->leaders[group] != type)
+        return virPerfEventClose(perf, type);
+
+    /* Closing the leader would turn the members into separate events, so
+     * the group is torn down and built again from the remaining members. */
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        if (i == type ||
+            !perf->events[i].enabled ||
+            perf->events[i].group != group)
+            continue;
+
+        members[i] = true;
+        if (virPerfEventClose(perf, i) < 0)
+            return -1;
+    }
+
+    if (virPerfEventClose(perf, type) < 0)
+        return -1;
+
+    perf->leaders[group] = -1;
+
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        if (members[i] &&
+            virPerfEventEnableInternal(perf, i, perf->pid) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
 bool virPerfEventIsEnabled(virPerf *perf,
                            virPerfEventType type)
 {
     return perf && perf->events[type].enabled;
 }
 
+
+static int
+virPerfReadGroup(virPerf *perf,
+                 virPerfGroup group,
+                 uint64_t *values)
+{
+    struct virPerfEvent *leader = &perf->events[perf->leaders[group]];
+    g_autofree uint64_t *buf = NULL;
+    size_t nmembers = 0;
+    size_t bufsize;
+    uint64_t nr;
+    uint64_t enabled;
+    uint64_t running;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        if (perf->events[i].enabled && perf->events[i].group == group)
+            nmembers++;
+    }
+
+    /* { nr, time_enabled, time_running, { value, id }[nr] } */
+    bufsize = (3 + 2 * nmembers) * sizeof(uint64_t);
+    buf = g_malloc0(bufsize);
+
+    if (saferead(leader->fd, buf, bufsize) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to read perf event group"));
+        return -1;
+    }
+
+    nr = MIN(buf[0], nmembers);
+    enabled = buf[1];
+    running = buf[2];
+
+    for (i = 0; i < nr; i++) {
+        uint64_t value = buf[3 + 2 * i];
+        uint64_t id = buf[4 + 2 * i];
+
+        /* The group was multiplexed with other events, extrapolate the
+         * count to the whole time it was enabled. */
+        if (running > 0 && running < enabled)
+            value = (uint64_t)((double)value * enabled / running);
+
+        for (j = 0; j < VIR_PERF_EVENT_LAST; j++) {
+            if (perf->events[j].enabled &&
+                perf->events[j].group == group &&
+                perf->events[j].id == id) {
+                values[j] = value;
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+virPerfReadSingle(virPerf *perf,
+                  virPerfEventType type,
+                  uint64_t *value)
+{
+    struct virPerfEvent *event = &perf->events[type];
+
+    if (saferead(event->fd, value, sizeof(uint64_t)) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to read cache data"));
+        return -1;
+    }
+
+    if (type == VIR_PERF_EVENT_CMT)
+        *value *= event->efields.cmt.scale;
+
+    return 0;
+}
+
+
 int
 virPerfReadEvent(virPerf *perf,
                  virPerfEventType type,
                  uint64_t *value)
 {
     struct virPerfEvent *event = &perf->events[type];
+    uint64_t values[VIR_PERF_EVENT_LAST] = { 0 };
+
     if (!event->enabled)
         return -1;
 
-    if (saferead(event->fd, value, sizeof(uint64_t)) < 0) {
-        virReportSystemError(errno, "%s",
-                             _("Unable to read cache data"));
+    if (event->group < 0)
+        return virPerfReadSingle(perf, type, value);
+
+    if (virPerfReadGroup(perf, event->group, values) < 0)
         return -1;
+
+    *value = values[type];
+    return 0;
+}
+
+
+/**
+ * virPerfReadEvents:
+ * @perf: perf events
+ * @values: array of VIR_PERF_EVENT_LAST elements
+ *
+ * Read the counts of all enabled events into @values, indexed by
+ * virPerfEventType, with a single read per group of events. Elements
+ * of disabled events are set to 0.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virPerfReadEvents(virPerf *perf,
+                  uint64_t *values)
+{
+    size_t i;
+
+    memset(values, 0, VIR_PERF_EVENT_LAST * sizeof(*values));
+
+    for (i = 0; i < VIR_PERF_GROUP_LAST; i++) {
+        if (perf->leaders[i] >= 0 &&
+            virPerfReadGroup(perf, i, values) < 0)
+            return -1;
     }
 
-    if (type == VIR_PERF_EVENT_CMT)
-        *value *= event->efields.cmt.scale;
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        if (perf->events[i].enabled &&
+            perf->events[i].group < 0 &&
+            virPerfReadSingle(perf, i, &values[i]) < 0)
+            return -1;
+    }
 
     return 0;
 }
@@ -355,6 +604,15 @@ virPerfReadEvent(virPerf *perf G_GNUC_UNUSED,
     return -1;
 }
 
+int
+virPerfReadEvents(virPerf *perf G_GNUC_UNUSED,
+                  uint64_t *values G_GNUC_UNUSED)
+{
+    virReportSystemError(ENXIO, "%s",
+                         _("Perf not supported on this platform"));
+    return -1;
+}
+
 #endif
 
 virPerf *
@@ -368,8 +626,12 @@ virPerfNew(void)
     for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
         perf->events[i].fd = -1;
         perf->events[i].enabled = false;
+        perf->events[i].group = -1;
     }
 
+    for (i = 0; i < VIR_PERF_GROUP_LAST; i++)
+        perf->leaders[i] = -1;
+
     if (virPerfRdtAttrInit() < 0)
         virResetLastError();
 
@@ -384,6 +646,16 @@ virPerfFree(virPerf *perf)
     if (perf == NULL)
         return;
 
+    /* Close group members before their leaders, so that the groups don't
+     * have to be built again. */
+    for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
+        int group = perf->events[i].group;
+
+        if (perf->events[i].enabled &&
+            (group < 0 || perf->leaders[group] != i))
+            virPerfEventDisable(perf, i);
+    }
+
     for (i = 0; i < VIR_PERF_EVENT_LAST; i++) {
         if (perf->events[i].enabled)
             virPerfEventDisable(perf, i);
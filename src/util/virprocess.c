@@ -26,8 +26,12 @@
 #include <limits.h>
 #include <signal.h>
 #ifndef WIN32
+# include <poll.h>
 # include <sys/wait.h>
 #endif
+#if WITH_DECL_SYS_PIDFD_OPEN
+# include <sys/syscall.h>
+#endif
 #if WITH_SYS_MOUNT_H
 # include <sys/mount.h>
 #endif
@@ -88,6 +92,28 @@ VIR_ENUM_IMPL(virProcessSchedPolicy,
 );
 
 
+/**
+ * virProcessPidFDOpen:
+ * @pid: process ID
+ *
+ * Opens a pidfd referring to @pid, which becomes readable once the process
+ * exits and, unlike the PID, can't be recycled for another process.
+ *
+ * Returns the pidfd, or -1 with errno set if pidfds aren't supported or
+ * the process doesn't exist. No error is reported.
+ */
+int
+virProcessPidFDOpen(pid_t pid)
+{
+#if WITH_DECL_SYS_PIDFD_OPEN
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
 #ifndef WIN32
 /**
  * virProcessTranslateStatus:
@@ -114,6 +140,31 @@ virProcessTranslateStatus(int status)
 }
 
 
+/*
+ * virProcessWaitExitTimeout:
+ * @pid: child process
+ * @timeout: time to wait in milliseconds
+ *
+ * Waits until @pid exits or @timeout expires, without reaping it. Uses a
+ * pidfd when available so that the wait ends as soon as the child exits.
+ */
+static void
+virProcessWaitExitTimeout(pid_t pid,
+                          int timeout)
+{
+    VIR_AUTOCLOSE pidfd = virProcessPidFDOpen(pid);
+    struct pollfd pfd = { .fd = pidfd, .events = POLLIN };
+
+    if (pidfd < 0) {
+        g_usleep(timeout * 1000);
+        return;
+    }
+
+    while (poll(&pfd, 1, timeout) < 0 && errno == EINTR)
+        ;
+}
+
+
 /**
  * virProcessAbort:
  * @pid: child process to kill
@@ -149,7 +200,7 @@ virProcessAbort(pid_t pid)
     } else if (ret == 0) {
         VIR_DEBUG("trying SIGTERM to child process %d", pid);
         kill(pid, SIGTERM);
-        g_usleep(10 * 1000);
+        virProcessWaitExitTimeout(pid, 10);
         while ((ret = waitpid(pid, &status, WNOHANG)) == -1 &&
                errno == EINTR);
         if (ret == pid) {
@@ -1218,33 +1269,49 @@ struct _virProcessNamespaceHelperData {
     void *opaque;
 };
 
-static int virProcessNamespaceHelper(pid_t pid G_GNUC_UNUSED,
-                                     void *opaque)
+/**
+ * virProcessEnterMountNamespace:
+ * @pid: process ID
+ *
+ * Moves the calling process into the mount namespace of @pid. This is
+ * meant to be called from a child that was forked for this purpose, as
+ * the whole process has to be single threaded for setns() to succeed.
+ *
+ * Returns 0 on success, -1 with an error reported otherwise.
+ */
+int
+virProcessEnterMountNamespace(pid_t pid)
 {
-    virProcessNamespaceHelperData *data = opaque;
-    int fd = -1;
-    int ret = -1;
+    VIR_AUTOCLOSE fd = -1;
     g_autofree char *path = NULL;
 
-    path = g_strdup_printf("/proc/%lld/ns/mnt", (long long)data->pid);
+    path = g_strdup_printf("/proc/%lld/ns/mnt", (long long)pid);
 
     if ((fd = open(path, O_RDONLY)) < 0) {
         virReportSystemError(errno, "%s",
                              _("Kernel does not provide mount namespace"));
-        goto cleanup;
+        return -1;
     }
 
     if (setns(fd, 0) < 0) {
         virReportSystemError(errno, "%s",
                              _("Unable to enter mount namespace"));
-        goto cleanup;
+        return -1;
     }
 
-    ret = data->cb(data->pid, data->opaque);
+    return 0;
+}
 
- cleanup:
-    VIR_FORCE_CLOSE(fd);
-    return ret;
+
+static int virProcessNamespaceHelper(pid_t pid G_GNUC_UNUSED,
+                                     void *opaque)
+{
+    virProcessNamespaceHelperData *data = opaque;
+
+    if (virProcessEnterMountNamespace(data->pid) < 0)
+        return -1;
+
+    return data->cb(data->pid, data->opaque);
 }
 
 /* Run cb(opaque) in the mount namespace of pid.  Return -1 with error
@@ -1265,6 +1332,14 @@ virProcessRunInMountNamespace(pid_t pid,
 
 #else /* ! __linux__ */
 
+int
+virProcessEnterMountNamespace(pid_t pid G_GNUC_UNUSED)
+{
+    virReportSystemError(ENOSYS, "%s",
+                         _("Namespaces are not supported on this platform"));
+    return -1;
+}
+
 int
 virProcessRunInMountNamespace(pid_t pid G_GNUC_UNUSED,
                               virProcessNamespaceCallback cb G_GNUC_UNUSED,
@@ -45,6 +45,9 @@ virProcessTranslateStatus(int status);
 void
 virProcessAbort(pid_t pid);
 
+int
+virProcessPidFDOpen(pid_t pid);
+
 void virProcessExitWithStatus(int status) G_GNUC_NORETURN;
 
 int
@@ -92,6 +95,8 @@ int virProcessGetMaxMemLock(pid_t pid, unsigned long long *bytes) G_NO_INLINE;
  * negative value is treated as EXIT_CANCELED.  */
 typedef int (*virProcessNamespaceCallback)(pid_t pid, void *opaque);
 
+int virProcessEnterMountNamespace(pid_t pid);
+
 int virProcessRunInMountNamespace(pid_t pid,
                                   virProcessNamespaceCallback cb,
                                   void *opaque);
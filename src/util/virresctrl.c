@@ -325,6 +325,11 @@ struct _virResctrlAllocPerLevel {
 struct _virResctrlAllocMemBW {
     unsigned int **bandwidths;
     size_t nbandwidths;
+
+    /* Bandwidths currently applied to the running allocation if they differ
+     * from @bandwidths, 0 otherwise. Indexed the same way as @bandwidths. */
+    unsigned int *live;
+    size_t nlive;
 };
 
 struct _virResctrlAlloc {
@@ -364,6 +369,12 @@ struct _virResctrlMonitor {
     /* libvirt-generated path in /sys/fs/resctrl for this particular
      * monitor */
     char *path;
+
+    /* The last statistics taken by virResctrlMonitorSample and the
+     * monotonic time they were taken at, in milliseconds */
+    virResctrlMonitorStats **samples;
+    size_t nsamples;
+    unsigned long long sampleTime;
 };
 
 
@@ -407,6 +418,7 @@ virResctrlAllocDispose(void *obj)
         for (i = 0; i < mem_bw->nbandwidths; i++)
             g_free(mem_bw->bandwidths[i]);
         g_free(alloc->mem_bw->bandwidths);
+        g_free(alloc->mem_bw->live);
         g_free(alloc->mem_bw);
     }
 
@@ -420,10 +432,14 @@ static void
 virResctrlMonitorDispose(void *obj)
 {
     virResctrlMonitor *monitor = obj;
+    size_t i;
 
     virObjectUnref(monitor->alloc);
     g_free(monitor->id);
     g_free(monitor->path);
+    for (i = 0; i < monitor->nsamples; i++)
+        virResctrlMonitorStatsFree(monitor->samples[i]);
+    g_free(monitor->samples);
 }
 
 
@@ -1330,6 +1346,107 @@ virResctrlAllocForeachMemory(virResctrlAlloc *alloc,
 }
 
 
+/* virResctrlAllocSetMemoryBandwidthLive
+ * @alloc: Pointer to a created allocation
+ * @id: node id of MBA to be set
+ * @memory_bandwidth: new memory bandwidth value
+ *
+ * Change the memory bandwidth of the node @id of the running allocation
+ * @alloc without changing the bandwidth it was defined with. Passing the
+ * defined bandwidth reverts any previous change.
+ *
+ * Returns 0 on success, -1 on failure with error message set.
+ */
+int
+virResctrlAllocSetMemoryBandwidthLive(virResctrlAlloc *alloc,
+                                      unsigned int id,
+                                      unsigned int memory_bandwidth)
+{
+    virResctrlAllocMemBW *mem_bw = alloc->mem_bw;
+    g_autofree char *schemata_path = NULL;
+    g_autofree char *schemata = NULL;
+    int lockfd = -1;
+    int ret = -1;
+
+    if (!mem_bw || id >= mem_bw->nbandwidths || !mem_bw->bandwidths[id]) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Memory Bandwidth is not defined for node %1$u"),
+                       id);
+        return -1;
+    }
+
+    if (memory_bandwidth == 0 || memory_bandwidth > 100) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Invalid memory bandwidth %1$u"), memory_bandwidth);
+        return -1;
+    }
+
+    if (!alloc->path || STREQ(alloc->path, SYSFS_RESCTRL_PATH)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Resctrl allocation was not created"));
+        return -1;
+    }
+
+    /* The kernel only updates the resources listed in the written schemata */
+    schemata_path = g_strdup_printf("%s/schemata", alloc->path);
+    schemata = g_strdup_printf("MB:%u=%u\n", id, memory_bandwidth);
+
+    lockfd = virResctrlLock();
+    if (lockfd < 0)
+        return -1;
+
+    VIR_DEBUG("Writing resctrl schemata '%s' into '%s'", schemata, schemata_path);
+    if (virFileWriteStr(schemata_path, schemata, 0) < 0) {
+        virReportSystemError(errno,
+                             _("Cannot write into schemata file '%1$s'"),
+                             schemata_path);
+        goto cleanup;
+    }
+
+    if (mem_bw->nlive <= id)
+        VIR_EXPAND_N(mem_bw->live, mem_bw->nlive, id - mem_bw->nlive + 1);
+
+    if (memory_bandwidth == *mem_bw->bandwidths[id])
+        mem_bw->live[id] = 0;
+    else
+        mem_bw->live[id] = memory_bandwidth;
+
+    ret = 0;
+ cleanup:
+    virResctrlUnlock(lockfd);
+    return ret;
+}
+
+
+/* virResctrlAllocGetMemoryBandwidthLive
+ * @alloc: Pointer to an allocation
+ * @id: node id of MBA
+ * @memory_bandwidth: returned memory bandwidth value
+ *
+ * Get the memory bandwidth of the node @id currently applied to @alloc,
+ * see virResctrlAllocSetMemoryBandwidthLive.
+ *
+ * Returns 0 on success, -1 if no bandwidth is defined for node @id.
+ */
+int
+virResctrlAllocGetMemoryBandwidthLive(virResctrlAlloc *alloc,
+                                      unsigned int id,
+                                      unsigned int *memory_bandwidth)
+{
+    virResctrlAllocMemBW *mem_bw = alloc->mem_bw;
+
+    if (!mem_bw || id >= mem_bw->nbandwidths || !mem_bw->bandwidths[id])
+        return -1;
+
+    if (id < mem_bw->nlive && mem_bw->live[id] > 0)
+        *memory_bandwidth = mem_bw->live[id];
+    else
+        *memory_bandwidth = *mem_bw->bandwidths[id];
+
+    return 0;
+}
+
+
 static int
 virResctrlSetID(char **resctrlid,
                 const char *id)
@@ -2638,6 +2755,165 @@ virResctrlMonitorGetStats(virResctrlMonitor *monitor,
 }
 
 
+static virResctrlMonitorStats *
+virResctrlMonitorStatsCopy(virResctrlMonitorStats *src)
+{
+    virResctrlMonitorStats *dst = g_new0(virResctrlMonitorStats, 1);
+
+    dst->id = src->id;
+    dst->features = g_strdupv(src->features);
+    dst->nvals = src->nvals;
+    dst->vals = g_memdup(src->vals, sizeof(*src->vals) * src->nvals);
+    if (src->rates)
+        dst->rates = g_memdup(src->rates, sizeof(*src->rates) * src->nvals);
+
+    return dst;
+}
+
+
+/*
+ * virResctrlMonitorStatsComputeRates
+ *
+ * @prev: statistics of the previous sample
+ * @nprev: length of @prev
+ * @cur: statistics of the current sample
+ * @ncur: length of @cur
+ * @elapsed: time between the two samples in milliseconds
+ *
+ * Fill in @rates of each record in @cur. Records are matched by their cache
+ * ID and feature name. Only accumulative counters, whose names end with
+ * '_bytes', get a rate. A counter that went backwards, e.g. because the
+ * monitoring group was recreated, gets a rate of 0.
+ */
+void
+virResctrlMonitorStatsComputeRates(virResctrlMonitorStats **prev,
+                                   size_t nprev,
+                                   virResctrlMonitorStats **cur,
+                                   size_t ncur,
+                                   unsigned long long elapsed)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+
+    for (i = 0; i < ncur; i++) {
+        virResctrlMonitorStats *c = cur[i];
+        virResctrlMonitorStats *p = NULL;
+
+        g_free(c->rates);
+        c->rates = g_new0(unsigned long long, c->nvals);
+
+        for (j = 0; j < nprev; j++) {
+            if (prev[j]->id == c->id) {
+                p = prev[j];
+                break;
+            }
+        }
+
+        if (!p || elapsed == 0)
+            continue;
+
+        for (j = 0; j < c->nvals; j++) {
+            if (!g_str_has_suffix(c->features[j], "_bytes"))
+                continue;
+
+            for (k = 0; k < p->nvals; k++) {
+                if (STREQ(c->features[j], p->features[k]))
+                    break;
+            }
+
+            if (k == p->nvals || c->vals[j] < p->vals[k])
+                continue;
+
+            c->rates[j] = (c->vals[j] - p->vals[k]) * 1000 / elapsed;
+        }
+    }
+}
+
+
+/*
+ * virResctrlMonitorSample
+ *
+ * @monitor: The monitor that the statistic data will be retrieved from.
+ * @resources: A string list for the monitor feature names.
+ *
+ * Take a sample of the statistics of @monitor, compute the rates of its
+ * accumulative counters since the previous sample and keep it for
+ * virResctrlMonitorGetSampledStats. Callers have to serialize the access
+ * to @monitor.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virResctrlMonitorSample(virResctrlMonitor *monitor,
+                        const char **resources)
+{
+    virResctrlMonitorStats **stats = NULL;
+    size_t nstats = 0;
+    unsigned long long now;
+    size_t i;
+
+    if (virResctrlMonitorGetStats(monitor, resources, &stats, &nstats) < 0) {
+        for (i = 0; i < nstats; i++)
+            virResctrlMonitorStatsFree(stats[i]);
+        g_free(stats);
+        return -1;
+    }
+
+    now = g_get_monotonic_time() / 1000;
+
+    if (monitor->sampleTime > 0)
+        virResctrlMonitorStatsComputeRates(monitor->samples, monitor->nsamples,
+                                           stats, nstats,
+                                           now - monitor->sampleTime);
+
+    for (i = 0; i < monitor->nsamples; i++)
+        virResctrlMonitorStatsFree(monitor->samples[i]);
+    g_free(monitor->samples);
+
+    monitor->samples = stats;
+    monitor->nsamples = nstats;
+    monitor->sampleTime = now;
+    return 0;
+}
+
+
+/*
+ * virResctrlMonitorGetSampledStats
+ *
+ * @monitor: The monitor that was sampled
+ * @maxAge: maximum age of the sample in milliseconds
+ * @stats: Pointer of of virResctrlMonitorStats * array for holding a copy of
+ * the sampled data.
+ * @nstats: A size_t pointer to hold the returned array length of @stats
+ *
+ * Get the statistics of @monitor taken by virResctrlMonitorSample unless
+ * they are older than @maxAge.
+ *
+ * Returns 1 if @stats were filled in, 0 if there is no recent enough sample.
+ */
+int
+virResctrlMonitorGetSampledStats(virResctrlMonitor *monitor,
+                                 unsigned long long maxAge,
+                                 virResctrlMonitorStats ***stats,
+                                 size_t *nstats)
+{
+    unsigned long long now = g_get_monotonic_time() / 1000;
+    size_t i;
+
+    if (monitor->sampleTime == 0 ||
+        now - monitor->sampleTime > maxAge)
+        return 0;
+
+    *stats = g_new0(virResctrlMonitorStats *, monitor->nsamples);
+    *nstats = monitor->nsamples;
+    for (i = 0; i < monitor->nsamples; i++)
+        (*stats)[i] = virResctrlMonitorStatsCopy(monitor->samples[i]);
+
+    return 1;
+}
+
+
 void
 virResctrlMonitorStatsFree(virResctrlMonitorStats *stat)
 {
@@ -2646,5 +2922,6 @@ virResctrlMonitorStatsFree(virResctrlMonitorStats *stat)
 
     g_strfreev(stat->features);
     g_free(stat->vals);
+    g_free(stat->rates);
     g_free(stat);
 }
@@ -149,6 +149,16 @@ virResctrlAllocForeachMemory(virResctrlAlloc *alloc,
                              virResctrlAllocForeachMemoryCallback cb,
                              void *opaque);
 
+int
+virResctrlAllocSetMemoryBandwidthLive(virResctrlAlloc *alloc,
+                                      unsigned int id,
+                                      unsigned int memory_bandwidth);
+
+int
+virResctrlAllocGetMemoryBandwidthLive(virResctrlAlloc *alloc,
+                                      unsigned int id,
+                                      unsigned int *memory_bandwidth);
+
 int
 virResctrlAllocSetID(virResctrlAlloc *alloc,
                      const char *id);
@@ -198,6 +208,10 @@ struct _virResctrlMonitorStats {
     unsigned long long *vals;
     /* The length of @vals array */
     size_t nvals;
+    /* @rates store the change of @vals per second since the previous sample
+     * for accumulative counters such as 'mbm_total_bytes' and 0 for the
+     * others. NULL unless the record comes from virResctrlMonitorSample */
+    unsigned long long *rates;
 };
 
 virResctrlMonitor *
@@ -235,5 +249,15 @@ virResctrlMonitorGetStats(virResctrlMonitor *monitor,
                           virResctrlMonitorStats ***stats,
                           size_t *nstats);
 
+int
+virResctrlMonitorSample(virResctrlMonitor *monitor,
+                        const char **resources);
+
+int
+virResctrlMonitorGetSampledStats(virResctrlMonitor *monitor,
+                                 unsigned long long maxAge,
+                                 virResctrlMonitorStats ***stats,
+                                 size_t *nstats);
+
 void
 virResctrlMonitorStatsFree(virResctrlMonitorStats *stats);
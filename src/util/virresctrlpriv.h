@@ -26,3 +26,10 @@
 
 virResctrlAlloc *
 virResctrlAllocGetUnused(virResctrlInfo *resctrl);
+
+void
+virResctrlMonitorStatsComputeRates(virResctrlMonitorStats **prev,
+                                   size_t nprev,
+                                   virResctrlMonitorStats **cur,
+                                   size_t ncur,
+                                   unsigned long long elapsed);
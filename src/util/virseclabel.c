@@ -78,6 +78,26 @@ virSecurityDeviceLabelDefNew(const char *model)
 }
 
 
+virSecurityLabelDef *
+virSecurityLabelDefCopy(const virSecurityLabelDef *src)
+{
+    virSecurityLabelDef *ret;
+
+    ret = g_new0(virSecurityLabelDef, 1);
+
+    ret->type = src->type;
+    ret->relabel = src->relabel;
+    ret->implicit = src->implicit;
+
+    ret->model = g_strdup(src->model);
+    ret->label = g_strdup(src->label);
+    ret->imagelabel = g_strdup(src->imagelabel);
+    ret->baselabel = g_strdup(src->baselabel);
+
+    return ret;
+}
+
+
 virSecurityDeviceLabelDef *
 virSecurityDeviceLabelDefCopy(const virSecurityDeviceLabelDef *src)
 {
@@ -58,6 +58,10 @@ virSecurityLabelDefNew(const char *model);
 virSecurityDeviceLabelDef *
 virSecurityDeviceLabelDefNew(const char *model);
 
+virSecurityLabelDef *
+virSecurityLabelDefCopy(const virSecurityLabelDef *src)
+    ATTRIBUTE_NONNULL(1);
+
 virSecurityDeviceLabelDef *
 virSecurityDeviceLabelDefCopy(const virSecurityDeviceLabelDef *src)
     ATTRIBUTE_NONNULL(1);
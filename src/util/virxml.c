@@ -33,6 +33,7 @@
 #include "viralloc.h"
 #include "virfile.h"
 #include "virstring.h"
+#include "virthread.h"
 #include "virutil.h"
 #include "viruuid.h"
 #include "configmake.h"
@@ -364,6 +365,91 @@ virXMLNodeContentString(xmlNodePtr node)
 }
 
 
+/* Arena for attribute values which the typed property getters only convert
+ * and throw away, one per thread */
+static virThreadLocal virXMLScratchArena;
+
+static void
+virXMLScratchArenaFree(void *opaque)
+{
+    virArenaFree(opaque);
+}
+
+static int
+virXMLScratchOnceInit(void)
+{
+    return virThreadLocalInit(&virXMLScratchArena, virXMLScratchArenaFree);
+}
+
+VIR_ONCE_GLOBAL_INIT(virXMLScratch);
+
+
+/**
+ * virXMLPropStringScratch:
+ * @node: XML dom node pointer
+ * @name: Name of the property (attribute) to get
+ *
+ * Same as virXMLPropString() except that the value is allocated from an
+ * arena private to the calling thread rather than from the heap. The value
+ * must not be freed and is valid only until the next call in the same
+ * thread, which is enough for getters converting it right away.
+ *
+ * Returns the property (attribute) value as string or NULL if the attribute
+ * is not present (no error is reported).
+ */
+static const char *
+virXMLPropStringScratch(xmlNodePtr node,
+                        const char *name)
+{
+    virArena *arena;
+    xmlAttrPtr attr;
+    xmlNodePtr cur = NULL;
+    size_t len = 0;
+    char *ret;
+
+    if (!(attr = xmlHasProp(node, BAD_CAST name)))
+        return NULL;
+
+    if (virXMLScratchInitialize() < 0)
+        abort();
+
+    if (!(arena = virThreadLocalGet(&virXMLScratchArena))) {
+        arena = virArenaNew(0);
+        if (virThreadLocalSet(&virXMLScratchArena, arena) < 0)
+            abort();
+    }
+
+    virArenaReset(arena);
+
+    /* Attributes defaulted by a DTD or containing entity references are
+     * rare, leave them to libxml2. */
+    if (attr->type == XML_ATTRIBUTE_NODE) {
+        for (cur = attr->children; cur; cur = cur->next) {
+            if (cur->type != XML_TEXT_NODE || !cur->content)
+                break;
+            len += strlen((const char *) cur->content);
+        }
+    }
+
+    if (attr->type != XML_ATTRIBUTE_NODE || cur) {
+        g_autofree char *tmp = virXMLPropString(node, name);
+
+        return virArenaStrdup(arena, tmp);
+    }
+
+    ret = virArenaAlloc(arena, len + 1);
+    len = 0;
+    for (cur = attr->children; cur; cur = cur->next) {
+        size_t curlen = strlen((const char *) cur->content);
+
+        memcpy(ret + len, cur->content, curlen);
+        len += curlen;
+    }
+
+    return ret;
+}
+
+
 static int
 virXMLPropEnumInternal(xmlNodePtr node,
                        const char *name,
@@ -373,12 +459,12 @@ virXMLPropEnumInternal(xmlNodePtr node,
                        unsigned int defaultResult)
 
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     int ret;
 
     *result = defaultResult;
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -499,12 +585,12 @@ virXMLPropInt(xmlNodePtr node,
               int *result,
               int defaultResult)
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     int val;
 
     *result = defaultResult;
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -589,13 +675,13 @@ virXMLPropUIntDefault(xmlNodePtr node,
                       unsigned int *result,
                       unsigned int defaultResult)
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     int ret;
     unsigned int val;
 
     *result = defaultResult;
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -649,12 +735,12 @@ virXMLPropLongLong(xmlNodePtr node,
                    long long *result,
                    long long defaultResult)
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     long long val;
 
     *result = defaultResult;
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -712,13 +798,13 @@ virXMLPropULongLong(xmlNodePtr node,
                     virXMLPropFlags flags,
                     unsigned long long *result)
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     int ret;
     unsigned long long val;
 
     *result = 0;
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -796,10 +882,10 @@ virXMLPropUUID(xmlNodePtr node,
                virXMLPropFlags flags,
                unsigned char *result)
 {
-    g_autofree char *tmp = NULL;
+    const char *tmp = NULL;
     unsigned char val[VIR_UUID_BUFLEN];
 
-    if (!(tmp = virXMLPropString(node, name))) {
+    if (!(tmp = virXMLPropStringScratch(node, name))) {
         if (!(flags & VIR_XML_PROP_REQUIRED))
             return 0;
 
@@ -929,6 +1015,183 @@ virXMLNodeGetSubelementList(xmlNodePtr node,
 }
 
 
+/**
+ * virXMLNodeGetSubelementContent:
+ * @node: node to get subelement of
+ * @name: name of subelement
+ *
+ * Child iteration based equivalent of virXPathString evaluating
+ * "string(./NAME[1])" with @node as the context node and @name as NAME.
+ *
+ * Returns the text content of the first sub-element of @node named @name,
+ * or NULL if there is no such sub-element or its content is empty.
+ */
+char *
+virXMLNodeGetSubelementContent(xmlNodePtr node,
+                               const char *name)
+{
+    xmlNodePtr n = virXMLNodeGetSubelement(node, name);
+    char *ret;
+
+    if (!n)
+        return NULL;
+
+    ret = (char *)xmlNodeGetContent(n);
+    if (ret && *ret == '\0')
+        g_clear_pointer(&ret, xmlFree);
+
+    return ret;
+}
+
+
+/**
+ * virXMLNodeGetSubelementProp:
+ * @node: node to get subelement of
+ * @name: name of subelement
+ * @attr: name of the attribute
+ *
+ * Child iteration based equivalent of virXPathString evaluating
+ * "string(./NAME/@ATTR)" with @node as the context node, @name as NAME and
+ * @attr as ATTR.
+ *
+ * Returns the value of @attr of the first sub-element of @node named @name
+ * which has it, or NULL if there is none or the value is empty.
+ */
+char *
+virXMLNodeGetSubelementProp(xmlNodePtr node,
+                            const char *name,
+                            const char *attr)
+{
+    xmlNodePtr n;
+
+    for (n = node->children; n; n = n->next) {
+        g_autofree char *ret = NULL;
+
+        if (n->type != XML_ELEMENT_NODE ||
+            !virXMLNodeNameEqual(n, name))
+            continue;
+
+        if ((ret = virXMLPropString(n, attr))) {
+            if (*ret == '\0')
+                return NULL;
+
+            return g_steal_pointer(&ret);
+        }
+    }
+
+    return NULL;
+}
+
+
+struct _virXMLChildIndex {
+    /* element name -> GPtrArray of xmlNodePtr in document order */
+    GHashTable *elements;
+};
+
+
+/**
+ * virXMLChildIndexNew:
+ * @node: node whose children to index
+ *
+ * Index the element children of @node by their name in a single pass over
+ * them. Looking the children up in the index afterwards replaces evaluating
+ * "./name" XPath expressions relative to @node one by one, each of which
+ * would have to be compiled and walk all of the children.
+ *
+ * Like XPath expressions without a namespace prefix, the index covers only
+ * elements in no namespace. The index borrows the nodes, so it must not
+ * outlive the document.
+ *
+ * Returns the index, free it with virXMLChildIndexFree().
+ */
+virXMLChildIndex *
+virXMLChildIndexNew(xmlNodePtr node)
+{
+    virXMLChildIndex *idx = g_new0(virXMLChildIndex, 1);
+
+    idx->elements = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                          (GDestroyNotify) g_ptr_array_unref);
+
+    if (node)
+        virXMLChildIndexAdd(idx, node);
+
+    return idx;
+}
+
+
+/**
+ * virXMLChildIndexAdd:
+ * @idx: child index
+ * @node: node whose children to add
+ *
+ * Add the element children of @node to @idx, after the ones indexed
+ * already. Indexing the children of several nodes with the same name
+ * mirrors XPath expressions such as "./devices/disk".
+ */
+void
+virXMLChildIndexAdd(virXMLChildIndex *idx,
+                    xmlNodePtr node)
+{
+    xmlNodePtr n;
+
+    for (n = node->children; n; n = n->next) {
+        GPtrArray *list;
+
+        if (n->type != XML_ELEMENT_NODE || n->ns)
+            continue;
+
+        if (!(list = g_hash_table_lookup(idx->elements, n->name))) {
+            list = g_ptr_array_new();
+            g_hash_table_insert(idx->elements, (char *) n->name, list);
+        }
+
+        g_ptr_array_add(list, n);
+    }
+}
+
+
+/**
+ * virXMLChildIndexGetNodeSet:
+ * @idx: child index
+ * @name: element name
+ * @list: the returned list of nodes (or NULL if only count matters)
+ *
+ * Counterpart of virXPathNodeSet for the indexed elements named @name.
+ *
+ * Returns the number of nodes found, in which case @list is set (and
+ *         must be freed) or NULL if there are none.
+ */
+int
+virXMLChildIndexGetNodeSet(virXMLChildIndex *idx,
+                           const char *name,
+                           xmlNodePtr **list)
+{
+    GPtrArray *nodes = g_hash_table_lookup(idx->elements, name);
+
+    if (list)
+        *list = NULL;
+
+    if (!nodes)
+        return 0;
+
+    if (list)
+        *list = g_memdup(nodes->pdata, nodes->len * sizeof(xmlNodePtr));
+
+    return nodes->len;
+}
+
+
+void
+virXMLChildIndexFree(virXMLChildIndex *idx)
+{
+    if (!idx)
+        return;
+
+    g_hash_table_unref(idx->elements);
+    g_free(idx);
+}
+
+
 /**
  * virXPathNode:
  * @xpath: the XPath string to evaluate
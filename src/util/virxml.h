@@ -81,6 +81,30 @@ GPtrArray *
 virXMLNodeGetSubelementList(xmlNodePtr node,
                             const char *name);
 
+char *
+virXMLNodeGetSubelementContent(xmlNodePtr node,
+                               const char *name);
+
+char *
+virXMLNodeGetSubelementProp(xmlNodePtr node,
+                            const char *name,
+                            const char *attr);
+
+typedef struct _virXMLChildIndex virXMLChildIndex;
+
+virXMLChildIndex *
+virXMLChildIndexNew(xmlNodePtr node);
+void
+virXMLChildIndexAdd(virXMLChildIndex *idx,
+                    xmlNodePtr node);
+int
+virXMLChildIndexGetNodeSet(virXMLChildIndex *idx,
+                           const char *name,
+                           xmlNodePtr **list);
+void
+virXMLChildIndexFree(virXMLChildIndex *idx);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virXMLChildIndex, virXMLChildIndexFree);
+
 xmlNodePtr
 virXPathNode(const char *xpath,
              xmlXPathContextPtr ctxt);
@@ -36,6 +36,7 @@
 #include "virfile.h"
 #include "virpidfile.h"
 #include "virerror.h"
+#include "virevent.h"
 #include "virprocess.h"
 #include "virutil.h"
 
@@ -1232,6 +1233,153 @@ test29(const void *unused G_GNUC_UNUSED)
 }
 
 
+#define SPAWN_ITERATIONS 50
+
+static int
+test30Run(const char *binary,
+          bool forceFork,
+          gint64 *elapsed)
+{
+    gint64 start = g_get_monotonic_time();
+    size_t i;
+
+    for (i = 0; i < SPAWN_ITERATIONS; i++) {
+        g_autoptr(virCommand) cmd = virCommandNew(binary);
+
+        /* A umask has to be applied in the child, which rules out
+         * posix_spawn() and makes virExec() fork. */
+        if (forceFork)
+            virCommandSetUmask(cmd, 022);
+
+        if (virCommandRun(cmd, NULL) < 0) {
+            fprintf(stderr, "Cannot run child %s\n", virGetLastErrorMessage());
+            return -1;
+        }
+    }
+
+    *elapsed = g_get_monotonic_time() - start;
+    return 0;
+}
+
+/*
+ * Compare the latency of starting a trivial command with and without
+ * child side setup. This doesn't assert anything about the numbers,
+ * they are printed in debug mode only.
+ */
+static int test30(const void *unused G_GNUC_UNUSED)
+{
+    g_autofree char *binary = virFindFileInPath("true");
+    gint64 spawnTime;
+    gint64 forkTime;
+
+    if (!binary)
+        return EXIT_AM_SKIP;
+
+    if (test30Run(binary, false, &spawnTime) < 0 ||
+        test30Run(binary, true, &forkTime) < 0)
+        return -1;
+
+    VIR_TEST_DEBUG("%d runs of %s: %lld us/run plain, %lld us/run with umask",
+                   SPAWN_ITERATIONS, binary,
+                   (long long) spawnTime / SPAWN_ITERATIONS,
+                   (long long) forkTime / SPAWN_ITERATIONS);
+
+    return 0;
+}
+
+
+struct test31Data {
+    char *out[3];
+    int done;
+    int ret;
+};
+
+
+static void
+test31Callback(virCommand *cmd G_GNUC_UNUSED,
+               int ret,
+               int exitstatus,
+               void *opaque)
+{
+    struct test31Data *data = opaque;
+
+    if (ret < 0 || exitstatus != 0) {
+        fprintf(stderr, "Command failed: %s\n", virGetLastErrorMessage());
+        data->ret = -1;
+    }
+
+    g_atomic_int_inc(&data->done);
+}
+
+
+static void
+test31Timeout(int timer G_GNUC_UNUSED,
+              void *opaque G_GNUC_UNUSED)
+{
+}
+
+
+/*
+ * Run several commands limited to one instance at a time with completion
+ * callbacks and check their output.
+ */
+static int test31(const void *unused G_GNUC_UNUSED)
+{
+    struct test31Data data = { 0 };
+    int timer = -1;
+    int started = 0;
+    size_t i;
+    int ret = -1;
+
+    if (virEventRegisterDefaultImpl() < 0)
+        return -1;
+
+    /* wake the loop up in case the callbacks come from helper threads */
+    if ((timer = virEventAddTimeout(10, test31Timeout, NULL, NULL)) < 0)
+        return -1;
+
+    virCommandSetConcurrencyLimit("echo", 1);
+
+    for (i = 0; i < G_N_ELEMENTS(data.out); i++) {
+        virCommand *cmd = virCommandNewArgList("echo", NULL);
+
+        virCommandAddArgFormat(cmd, "%zu", i);
+        virCommandSetOutputBuffer(cmd, &data.out[i]);
+
+        if (virCommandRunAsyncCallback(cmd, test31Callback, &data) < 0) {
+            fprintf(stderr, "Cannot run child %s\n", virGetLastErrorMessage());
+            break;
+        }
+
+        started++;
+    }
+
+    /* the callbacks refer to @data, wait for all of them */
+    while (g_atomic_int_get(&data.done) < started) {
+        if (virEventRunDefaultImpl() < 0)
+            goto cleanup;
+    }
+
+    if (started < G_N_ELEMENTS(data.out) || data.ret < 0)
+        goto cleanup;
+
+    for (i = 0; i < G_N_ELEMENTS(data.out); i++) {
+        g_autofree char *expect = g_strdup_printf("%zu\n", i);
+
+        if (virTestCompareToString(expect, data.out[i]) < 0)
+            goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virEventRemoveTimeout(timer);
+    for (i = 0; i < G_N_ELEMENTS(data.out); i++)
+        g_free(data.out[i]);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -1333,6 +1481,8 @@ mymain(void)
     DO_TEST(test27);
     DO_TEST(test28);
     DO_TEST(test29);
+    DO_TEST(test30);
+    DO_TEST(test31);
 
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
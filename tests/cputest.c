@@ -613,6 +613,148 @@ cpuTestCPUIDBaseline(const void *arg)
 }
 
 
+/* Number of simulated hosts used for testing incremental baseline. */
+#define BASELINE_HOSTS 1000
+
+static int
+cpuTestCPUIDBaselineIncremental(const void *arg)
+{
+    const struct data *data = arg;
+    int ret = -1;
+    virCPUDef **cpus = NULL;
+    g_autoptr(virCPUBaselineState) state = NULL;
+    g_autoptr(virCPUDef) baseline = NULL;
+    g_autoptr(virCPUDef) expected = NULL;
+    g_autofree char *result = NULL;
+    g_autofree char *actualXML = NULL;
+    g_autofree char *expectedXML = NULL;
+    unsigned long long start;
+    size_t i;
+
+    cpus = g_new0(virCPUDef *, data->ncpus);
+    for (i = 0; i < data->ncpus; i++) {
+        g_autofree char *name = NULL;
+
+        name = g_strdup_printf("cpuid-%s-json", data->cpus[i]);
+        if (!(cpus[i] = cpuTestLoadXML(data->arch, name)))
+            goto cleanup;
+    }
+
+    if (!(state = virCPUBaselineStateNew(data->arch)))
+        goto cleanup;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < BASELINE_HOSTS; i++) {
+        if (virCPUBaselineStateAdd(state, &cpus[i % data->ncpus], 1) < 0)
+            goto cleanup;
+    }
+
+    if (!(baseline = virCPUBaselineStateCompute(state, NULL, NULL, false)))
+        goto cleanup;
+
+    VIR_TEST_DEBUG("\nbaseline of %zu hosts computed in %llu us",
+                   virCPUBaselineStateGetCount(state),
+                   g_get_monotonic_time() - start);
+
+    result = g_strdup_printf("cpuid-baseline-%s", data->name);
+
+    if (cpuTestCompareXML(data->arch, baseline, result) < 0)
+        goto cleanup;
+
+    /* Removing all but the first CPU has to result in the same baseline as
+     * computing it from the first CPU only. */
+    for (i = 0; i < BASELINE_HOSTS; i++) {
+        if (i % data->ncpus == 0)
+            continue;
+
+        if (virCPUBaselineStateRemove(state, &cpus[i % data->ncpus], 1) < 0)
+            goto cleanup;
+    }
+
+    g_clear_pointer(&baseline, virCPUDefFree);
+    if (!(baseline = virCPUBaselineStateCompute(state, NULL, NULL, false)) ||
+        !(expected = virCPUBaseline(data->arch, cpus, 1, NULL, NULL, false)))
+        goto cleanup;
+
+    actualXML = virCPUDefFormat(baseline, NULL);
+    expectedXML = virCPUDefFormat(expected, NULL);
+
+    if (virTestCompareToString(expectedXML, actualXML) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (cpus) {
+        for (i = 0; i < data->ncpus; i++)
+            virCPUDefFree(cpus[i]);
+        VIR_FREE(cpus);
+    }
+    return ret;
+}
+
+
+/* Number of times CPU data is decoded by cpuTestCPUIDDecodeRepeat. */
+#define DECODE_ROUNDS 10
+#define DECODE_ROUNDS_EXPENSIVE 1000
+
+/*
+ * Decodes the same CPU data repeatedly, which must neither change the data
+ * nor the result, and reports how long decoding takes.
+ */
+static int
+cpuTestCPUIDDecodeRepeat(const void *arg)
+{
+    const struct data *data = arg;
+    g_autoptr(virCPUData) hostData = NULL;
+    g_autofree char *hostFile = NULL;
+    g_autofree char *host = NULL;
+    g_autofree char *dataBefore = NULL;
+    g_autofree char *dataAfter = NULL;
+    g_autofree char *expected = NULL;
+    size_t rounds = DECODE_ROUNDS;
+    unsigned long long start;
+    size_t i;
+
+    hostFile = g_strdup_printf("%s/cputestdata/%s-cpuid-%s.xml", abs_srcdir,
+                               virArchToString(data->arch), data->host);
+
+    if (virTestLoadFile(hostFile, &host) < 0 ||
+        !(hostData = virCPUDataParse(host)) ||
+        !(dataBefore = virCPUDataFormat(hostData)))
+        return -1;
+
+    if (virTestGetExpensive())
+        rounds = DECODE_ROUNDS_EXPENSIVE;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < rounds; i++) {
+        g_autoptr(virCPUDef) cpu = virCPUDefNew();
+        g_autofree char *actual = NULL;
+
+        cpu->arch = hostData->arch;
+        cpu->type = VIR_CPU_TYPE_HOST;
+
+        if (cpuDecode(cpu, hostData, NULL) < 0 ||
+            !(actual = virCPUDefFormat(cpu, NULL)))
+            return -1;
+
+        if (!expected)
+            expected = g_steal_pointer(&actual);
+        else if (virTestCompareToString(expected, actual) < 0)
+            return -1;
+    }
+
+    VIR_TEST_DEBUG("\n%zu decodes took %llu us", rounds,
+                   g_get_monotonic_time() - start);
+
+    if (!(dataAfter = virCPUDataFormat(hostData)))
+        return -1;
+
+    return virTestCompareToString(dataBefore, dataAfter);
+}
+
+
 static int
 cpuTestHostCPUID(const void *arg)
 {
@@ -1012,6 +1154,8 @@ mymain(void)
                 NULL, NULL, 0, NULL, json, 0); \
         DO_TEST(arch, cpuTestCPUIDSignature, host, host, \
                 NULL, NULL, 0, NULL, 0, 0); \
+        DO_TEST(arch, cpuTestCPUIDDecodeRepeat, host, host, \
+                NULL, NULL, 0, NULL, 0, 0); \
         DO_TEST_JSON(arch, host, json); \
         if (json != JSON_NONE) { \
             DO_TEST(arch, cpuTestUpdateLive, host, host, \
@@ -1025,6 +1169,9 @@ mymain(void)
         DO_TEST(arch, cpuTestCPUIDBaseline, \
                 label " (" cpu1 ", " cpu2 ")", \
                 NULL, label, cpus, 2, NULL, 0, 0); \
+        DO_TEST(arch, cpuTestCPUIDBaselineIncremental, \
+                label " incremental (" cpu1 ", " cpu2 ")", \
+                NULL, label, cpus, 2, NULL, 0, 0); \
     } while (0)
 
     /* host to host comparison */
@@ -0,0 +1,187 @@
+/*
+ * domaincopytest.c: Test copying of domain definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+#include "virfile.h"
+
+#include "domain_conf.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+static virDomainXMLOption *xmlopt;
+
+static const unsigned int parseFlags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
+                                       VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
+static const unsigned int formatFlags = VIR_DOMAIN_DEF_FORMAT_SECURE;
+
+struct testCopyData {
+    const char *path;
+    unsigned int flags; /* how to parse the original definition */
+    bool status;
+    bool optional; /* skip files the generic parser can't handle */
+};
+
+
+static virDomainDef *
+testDomainDefCopyParse(const struct testCopyData *data)
+{
+    g_autoptr(virDomainObj) vm = NULL;
+
+    if (!data->status)
+        return virDomainDefParseFile(data->path, xmlopt, NULL, data->flags);
+
+    if (!(vm = virDomainObjParseFile(data->path, xmlopt, data->flags)))
+        return NULL;
+
+    return g_steal_pointer(&vm->def);
+}
+
+
+/*
+ * Checks that virDomainDefCopy gives the same result as the round-trip
+ * through inactive XML it replaces, also for live and status definitions
+ * whose runtime state has to be dropped, and that the copy doesn't share
+ * any data with the original definition.
+ */
+static int
+testDomainDefCopy(const void *opaque)
+{
+    const struct testCopyData *data = opaque;
+    g_autoptr(virDomainDef) def = NULL;
+    g_autoptr(virDomainDef) roundtrip = NULL;
+    g_autoptr(virDomainDef) copy = NULL;
+    g_autofree char *xml = NULL;
+    g_autofree char *roundtripXML = NULL;
+    g_autofree char *copyXML = NULL;
+
+    if (!(def = testDomainDefCopyParse(data)) ||
+        !(xml = virDomainDefFormat(def, xmlopt, formatFlags))) {
+        if (!data->optional)
+            return -1;
+
+        virResetLastError();
+        return EXIT_AM_SKIP;
+    }
+
+    if (!(roundtrip = virDomainDefParseString(xml, xmlopt, NULL, parseFlags)) ||
+        !(roundtripXML = virDomainDefFormat(roundtrip, xmlopt, formatFlags)))
+        return -1;
+
+    if (!(copy = virDomainDefCopy(def, xmlopt, NULL, false)))
+        return -1;
+
+    g_clear_pointer(&def, virDomainDefFree);
+
+    if (!(copyXML = virDomainDefFormat(copy, xmlopt, formatFlags)))
+        return -1;
+
+    if (STRNEQ(roundtripXML, copyXML)) {
+        virTestDifference(stderr, roundtripXML, copyXML);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testDomainDefCopyDir(const char *subdir,
+                     const char *suffix,
+                     unsigned int flags,
+                     bool status)
+{
+    g_autofree char *dirname = g_strdup_printf("%s/%s", abs_srcdir, subdir);
+    g_autoptr(DIR) dir = NULL;
+    struct dirent *ent;
+    int ret = 0;
+    int rc;
+
+    if (virDirOpen(&dir, dirname) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, dirname)) > 0) {
+        g_autofree char *path = NULL;
+        g_autofree char *name = NULL;
+        struct testCopyData data = { .flags = flags, .status = status,
+                                     .optional = true };
+
+        if (!virStringHasSuffix(ent->d_name, suffix))
+            continue;
+
+        path = g_strdup_printf("%s/%s", dirname, ent->d_name);
+        name = g_strdup_printf("copy %s/%s", subdir, ent->d_name);
+        data.path = path;
+
+        if (virTestRun(name, testDomainDefCopy, &data) < 0)
+            ret = -1;
+    }
+
+    if (rc < 0)
+        return -1;
+
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (!(xmlopt = virTestGenericDomainXMLConfInit()))
+        return EXIT_FAILURE;
+
+#define DO_TEST_LIVE(name) \
+    do { \
+        struct testCopyData data = { \
+            .path = abs_srcdir "/domaincopydata/" name ".xml", \
+            .flags = VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE, \
+        }; \
+        if (virTestRun("copy " name, testDomainDefCopy, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    if (testDomainDefCopyDir("genericxml2xmlindata", ".xml",
+                             parseFlags, false) < 0)
+        ret = -1;
+
+    if (testDomainDefCopyDir("qemuxmlconfdata", ".xml",
+                             parseFlags, false) < 0)
+        ret = -1;
+
+    if (testDomainDefCopyDir("qemuhotplugtestdomains", ".xml",
+                             VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE, false) < 0)
+        ret = -1;
+
+    if (testDomainDefCopyDir("qemustatusxml2xmldata", "-in.xml",
+                             VIR_DOMAIN_DEF_PARSE_STATUS |
+                             VIR_DOMAIN_DEF_PARSE_ACTUAL_NET |
+                             VIR_DOMAIN_DEF_PARSE_PCI_ORIG_STATES |
+                             VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE, true) < 0)
+        ret = -1;
+
+    DO_TEST_LIVE("live");
+
+    virObjectUnref(xmlopt);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -0,0 +1,118 @@
+/*
+ * domaindifftest.c: Test structural diff of domain definitions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "domain_diff.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+static virDomainXMLOption *xmlopt;
+
+struct testDiffData {
+    const char *name;
+    virDomainDeviceType changed;
+    virDomainDeviceType unchanged;
+};
+
+
+static int
+testDomainDefDiff(const void *opaque)
+{
+    const struct testDiffData *data = opaque;
+    g_autofree char *oldFile = NULL;
+    g_autofree char *newFile = NULL;
+    g_autofree char *outFile = NULL;
+    g_autoptr(virDomainDef) oldDef = NULL;
+    g_autoptr(virDomainDef) newDef = NULL;
+    g_autoptr(virDomainDefDiff) diff = NULL;
+    g_autofree char *actual = NULL;
+    unsigned int flags = VIR_DOMAIN_DEF_DIFF_INACTIVE |
+                         VIR_DOMAIN_DEF_DIFF_SECURE;
+
+    oldFile = g_strdup_printf("%s/domaindiffdata/%s-old.xml", abs_srcdir, data->name);
+    newFile = g_strdup_printf("%s/domaindiffdata/%s-new.xml", abs_srcdir, data->name);
+    outFile = g_strdup_printf("%s/domaindiffdata/%s.txt", abs_srcdir, data->name);
+
+    if (!(oldDef = virDomainDefParseFile(oldFile, xmlopt, NULL,
+                                         VIR_DOMAIN_DEF_PARSE_INACTIVE)) ||
+        !(newDef = virDomainDefParseFile(newFile, xmlopt, NULL,
+                                         VIR_DOMAIN_DEF_PARSE_INACTIVE)))
+        return -1;
+
+    if (!(diff = virDomainDefDiffCompute(oldDef, newDef, xmlopt, flags)))
+        return -1;
+
+    actual = virDomainDefDiffFormat(diff);
+
+    if (virTestCompareToFile(actual, outFile) < 0)
+        return -1;
+
+    if (data->changed != VIR_DOMAIN_DEVICE_NONE &&
+        !virDomainDefDiffHasDeviceChanges(diff, data->changed)) {
+        VIR_TEST_DEBUG("expected changes of device type '%s'",
+                       virDomainDeviceTypeToString(data->changed));
+        return -1;
+    }
+
+    if (data->unchanged != VIR_DOMAIN_DEVICE_NONE &&
+        virDomainDefDiffHasDeviceChanges(diff, data->unchanged)) {
+        VIR_TEST_DEBUG("unexpected changes of device type '%s'",
+                       virDomainDeviceTypeToString(data->unchanged));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (!(xmlopt = virTestGenericDomainXMLConfInit()))
+        return EXIT_FAILURE;
+
+#define DO_TEST_FULL(name, changed, unchanged) \
+    do { \
+        const struct testDiffData data = { name, changed, unchanged }; \
+        if (virTestRun("diff " name, testDomainDefDiff, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+#define DO_TEST(name) \
+    DO_TEST_FULL(name, VIR_DOMAIN_DEVICE_NONE, VIR_DOMAIN_DEVICE_NONE)
+
+    DO_TEST("identical");
+    DO_TEST_FULL("properties", VIR_DOMAIN_DEVICE_DISK, VIR_DOMAIN_DEVICE_NET);
+    DO_TEST_FULL("devices", VIR_DOMAIN_DEVICE_NET, VIR_DOMAIN_DEVICE_VIDEO);
+    DO_TEST("reorder");
+    DO_TEST_FULL("position", VIR_DOMAIN_DEVICE_RNG, VIR_DOMAIN_DEVICE_DISK);
+    DO_TEST("cpu");
+    DO_TEST("features");
+    DO_TEST("numatune");
+
+    virObjectUnref(xmlopt);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
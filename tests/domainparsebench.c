@@ -0,0 +1,169 @@
+/*
+ * domainparsebench.c: Measure domain XML parsing throughput
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Parses every domain XML document of tests/qemuxmlconfdata repeatedly and
+ * reports the throughput, the time spent freeing the definitions and the
+ * peak RSS. It is not part of the test suite, run it by hand:
+ *
+ *   VIR_BENCH_ITERATIONS=50 ./build/tests/domainparsebench
+ *
+ * Documents the generic XML options can't parse are left out.
+ */
+
+#include <config.h>
+
+#ifndef WIN32
+# include <sys/resource.h>
+#endif
+
+#include "testutils.h"
+#include "virfile.h"
+
+#include "domain_conf.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+#define DEFAULT_ITERATIONS 10
+
+static const unsigned int parseFlags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
+                                       VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
+
+
+static int
+benchLoadCorpus(const char *dirname,
+                virDomainXMLOption *xmlopt,
+                GPtrArray *docs,
+                size_t *nskipped,
+                unsigned long long *nbytes)
+{
+    g_autoptr(DIR) dir = NULL;
+    struct dirent *ent;
+    int rc;
+
+    if (virDirOpen(&dir, dirname) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, dirname)) > 0) {
+        g_autofree char *path = NULL;
+        g_autofree char *xml = NULL;
+        g_autoptr(virDomainDef) def = NULL;
+
+        if (!virStringHasSuffix(ent->d_name, ".xml"))
+            continue;
+
+        path = g_strdup_printf("%s/%s", dirname, ent->d_name);
+
+        if (virTestLoadFile(path, &xml) < 0)
+            return -1;
+
+        if (!(def = virDomainDefParseString(xml, xmlopt, NULL, parseFlags))) {
+            virResetLastError();
+            (*nskipped)++;
+            continue;
+        }
+
+        *nbytes += strlen(xml);
+        g_ptr_array_add(docs, g_steal_pointer(&xml));
+    }
+
+    return rc;
+}
+
+
+static long
+benchPeakRSS(void)
+{
+#ifndef WIN32
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+
+    return -1;
+}
+
+
+static int
+mymain(void)
+{
+    g_autoptr(virDomainXMLOption) xmlopt = NULL;
+    g_autoptr(GPtrArray) docs = g_ptr_array_new_with_free_func(g_free);
+    g_autofree char *dirname = g_strdup_printf("%s/qemuxmlconfdata", abs_srcdir);
+    const char *env = getenv("VIR_BENCH_ITERATIONS");
+    unsigned int iterations = DEFAULT_ITERATIONS;
+    unsigned long long nbytes = 0;
+    size_t nskipped = 0;
+    gint64 start;
+    gint64 freeStart;
+    gint64 freeTime = 0;
+    double elapsed;
+    unsigned int i;
+    size_t j;
+
+    if (env && (virStrToLong_ui(env, NULL, 10, &iterations) < 0 ||
+                iterations == 0)) {
+        fprintf(stderr, "Invalid VIR_BENCH_ITERATIONS '%s'\n", env);
+        return EXIT_FAILURE;
+    }
+
+    if (!(xmlopt = virTestGenericDomainXMLConfInit()))
+        return EXIT_FAILURE;
+
+    if (benchLoadCorpus(dirname, xmlopt, docs, &nskipped, &nbytes) < 0)
+        return EXIT_FAILURE;
+
+    start = g_get_monotonic_time();
+
+    /* Keep the definitions of a whole pass alive like a bulk define would
+     * and free them separately to measure both parts. */
+    for (i = 0; i < iterations; i++) {
+        g_autoptr(GPtrArray) defs = g_ptr_array_new_full(docs->len,
+                                                         (GDestroyNotify) virDomainDefFree);
+
+        for (j = 0; j < docs->len; j++) {
+            virDomainDef *def;
+
+            if (!(def = virDomainDefParseString(g_ptr_array_index(docs, j),
+                                                xmlopt, NULL, parseFlags)))
+                return EXIT_FAILURE;
+
+            g_ptr_array_add(defs, def);
+        }
+
+        freeStart = g_get_monotonic_time();
+        g_clear_pointer(&defs, g_ptr_array_unref);
+        freeTime += g_get_monotonic_time() - freeStart;
+    }
+
+    elapsed = (g_get_monotonic_time() - start - freeTime) / (double) G_USEC_PER_SEC;
+
+    printf("Parsed %u documents (%zu skipped), %llu bytes, %u times in %.3f s\n",
+           docs->len, nskipped, nbytes, iterations, elapsed);
+    printf("%.1f documents/s, %.2f MiB/s\n",
+           docs->len * iterations / elapsed,
+           nbytes * iterations / elapsed / (1024 * 1024));
+    printf("Freed the definitions in %.3f s\n",
+           freeTime / (double) G_USEC_PER_SEC);
+    printf("Peak RSS %ld KiB\n", benchPeakRSS());
+
+    return EXIT_SUCCESS;
+}
+
+VIR_TEST_MAIN(mymain)
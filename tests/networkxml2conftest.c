@@ -117,10 +117,12 @@ buildCapsCallback(const char *const*args,
                   char **output,
                   char **error G_GNUC_UNUSED,
                   int *status,
-                  void *opaque G_GNUC_UNUSED)
+                  void *opaque)
 {
+    const char *version = opaque ? opaque : "Dnsmasq version 2.67\n";
+
     if (STREQ(args[0], "/usr/sbin/dnsmasq") && STREQ(args[1], "--version")) {
-        *output = g_strdup("Dnsmasq version 2.67\n");
+        *output = g_strdup(version);
         *status = EXIT_SUCCESS;
     } else {
         *status = EXIT_FAILURE;
@@ -141,6 +143,38 @@ buildCaps(void)
 }
 
 
+static int
+testCapsRefresh(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(dnsmasqCaps) caps = NULL;
+    g_autoptr(virCommandDryRunToken) dryRunToken = NULL;
+
+    if (!(caps = buildCaps()))
+        return -1;
+
+    /* in dry run mode the check finishes before the refresh returns */
+    dryRunToken = virCommandDryRunTokenNew();
+    virCommandSetDryRun(dryRunToken, NULL, true, true, buildCapsCallback,
+                        (void *) "Dnsmasq version 2.10\n");
+
+    dnsmasqCapsRefreshAsync(caps);
+    if (dnsmasqCapsIsUsable(caps)) {
+        VIR_TEST_VERBOSE("too old dnsmasq is usable");
+        return -1;
+    }
+
+    virCommandSetDryRun(dryRunToken, NULL, true, true, buildCapsCallback, NULL);
+
+    dnsmasqCapsRefreshAsync(caps);
+    if (!dnsmasqCapsIsUsable(caps)) {
+        VIR_TEST_VERBOSE("dnsmasq is not usable after an upgrade");
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 mymain(void)
 {
@@ -193,6 +227,9 @@ mymain(void)
     DO_TEST("leasetime-hours", full);
     DO_TEST("leasetime-infinite", full);
 
+    if (virTestRun("dnsmasq caps refresh", testCapsRefresh, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
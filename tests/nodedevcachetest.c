@@ -0,0 +1,219 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "internal.h"
+#include "testutils.h"
+#include "virfile.h"
+#include "node_device/node_device_cache.h"
+
+#define VIR_FROM_THIS VIR_FROM_NODEDEV
+
+/*
+ * The tests play sysfs in a temporary directory and change the
+ * attribute of the device behind the back of the cache to tell whether
+ * the copy or the device was read.
+ */
+
+static char *cachedir;
+static char *devpath;
+
+
+static int
+testDeviceSetVPD(const char *content)
+{
+    g_autofree char *path = g_build_filename(devpath, "vpd", NULL);
+
+    if (virFileWriteStr(path, content, S_IRUSR | S_IWUSR) < 0) {
+        fprintf(stderr, "cannot write '%s'\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCacheExpect(nodeDeviceCache *cache,
+                const char *generation,
+                const char *expect)
+{
+    g_autofree char *data = NULL;
+    VIR_AUTOCLOSE fd = -1;
+
+    if ((fd = nodeDeviceCacheOpen(cache, devpath, "vpd", generation, 1024)) < 0 ||
+        virFileReadLimFD(fd, 1024, &data) < 0)
+        return -1;
+
+    if (STRNEQ(data, expect)) {
+        VIR_TEST_VERBOSE("read '%s' for generation '%s', expected '%s'",
+                         data, NULLSTR(generation), expect);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static nodeDeviceCache *
+testCacheNew(void)
+{
+    if (virFileDeleteTree(cachedir) < 0)
+        return NULL;
+
+    return nodeDeviceCacheNew(cachedir);
+}
+
+
+static int
+testCacheHit(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(nodeDeviceCache) cache = NULL;
+
+    if (!(cache = testCacheNew()) ||
+        testDeviceSetVPD("first") < 0 ||
+        testCacheExpect(cache, "100", "first") < 0 ||
+        testDeviceSetVPD("second") < 0)
+        return -1;
+
+    if (testCacheExpect(cache, "100", "first") < 0)
+        return -1;
+
+    /* the copy survives restarts of the daemon */
+    g_clear_pointer(&cache, nodeDeviceCacheFree);
+    if (!(cache = nodeDeviceCacheNew(cachedir)))
+        return -1;
+
+    return testCacheExpect(cache, "100", "first");
+}
+
+
+static int
+testCacheGenerationMismatch(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(nodeDeviceCache) cache = NULL;
+
+    if (!(cache = testCacheNew()) ||
+        testDeviceSetVPD("first") < 0 ||
+        testCacheExpect(cache, "100", "first") < 0 ||
+        testDeviceSetVPD("second") < 0)
+        return -1;
+
+    /* the device was re-added, its VPD is read again and cached */
+    if (testCacheExpect(cache, "200", "second") < 0 ||
+        testDeviceSetVPD("third") < 0 ||
+        testCacheExpect(cache, "200", "second") < 0)
+        return -1;
+
+    /* only the latest instance is kept */
+    return testCacheExpect(cache, "100", "third");
+}
+
+
+static int
+testCacheNoGeneration(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(nodeDeviceCache) cache = NULL;
+
+    if (!(cache = testCacheNew()) ||
+        testDeviceSetVPD("first") < 0 ||
+        testCacheExpect(cache, NULL, "first") < 0 ||
+        testDeviceSetVPD("second") < 0 ||
+        testCacheExpect(cache, NULL, "second") < 0)
+        return -1;
+
+    if (virDirIsEmpty(cachedir, true) != 1) {
+        VIR_TEST_VERBOSE("something was cached without a generation");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCacheRemove(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(nodeDeviceCache) cache = NULL;
+
+    if (!(cache = testCacheNew()) ||
+        testDeviceSetVPD("first") < 0 ||
+        testCacheExpect(cache, "100", "first") < 0 ||
+        testDeviceSetVPD("second") < 0)
+        return -1;
+
+    nodeDeviceCacheRemove(cache, devpath);
+
+    if (virDirIsEmpty(cachedir, true) != 1) {
+        VIR_TEST_VERBOSE("the copy was not removed");
+        return -1;
+    }
+
+    /* removing a device which has nothing cached is fine too */
+    nodeDeviceCacheRemove(cache, devpath);
+
+    return testCacheExpect(cache, "100", "second");
+}
+
+
+static int
+mymain(void)
+{
+    g_autofree char *dir = g_strdup("/tmp/nodedevcachetest-XXXXXX");
+    int ret = 0;
+
+    if (!g_mkdtemp(dir)) {
+        fprintf(stderr, "Cannot create temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    cachedir = g_build_filename(dir, "cache", NULL);
+    devpath = g_build_filename(dir, "sys", "devices", "pci0000:00",
+                               "0000:00:01.0", NULL);
+
+    if (g_mkdir_with_parents(devpath, S_IRWXU) < 0) {
+        fprintf(stderr, "Cannot create '%s'\n", devpath);
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (virTestRun("Cache hit", testCacheHit, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache generation mismatch",
+                   testCacheGenerationMismatch, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache without generation", testCacheNoGeneration, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache remove", testCacheRemove, NULL) < 0)
+        ret = -1;
+
+ cleanup:
+    if (getenv("LIBVIRT_SKIP_CLEANUP") == NULL)
+        virFileDeleteTree(dir);
+    g_free(cachedir);
+    g_free(devpath);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
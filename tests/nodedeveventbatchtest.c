@@ -0,0 +1,159 @@
+#include <config.h>
+
+#include "internal.h"
+#include "testutils.h"
+#include "node_device/node_device_event_batch.h"
+
+#define VIR_FROM_THIS VIR_FROM_NODEDEV
+
+/* how often a recording is replayed by the benchmark */
+#define BENCH_ROUNDS 1000
+
+
+/*
+ * Feeds the events recorded by 'udevadm monitor --udev' in @log to
+ * @batch, as the udev driver would.
+ */
+static void
+testReplay(nodeDeviceEventBatch *batch,
+           const char *log)
+{
+    g_auto(GStrv) lines = g_strsplit(log, "\n", 0);
+    GStrv line;
+
+    for (line = lines; *line; line++) {
+        g_auto(GStrv) tokens = NULL;
+        g_autofree char *syspath = NULL;
+        const char *fields[4] = { 0 };
+        size_t nfields = 0;
+        GStrv token;
+
+        /* UDEV  [5123.000731] change   /devices/... (scsi_host) */
+        if (!STRPREFIX(*line, "UDEV "))
+            continue;
+
+        tokens = g_strsplit(*line, " ", 0);
+        for (token = tokens; *token && nfields < G_N_ELEMENTS(fields); token++) {
+            if (**token)
+                fields[nfields++] = *token;
+        }
+
+        if (nfields < G_N_ELEMENTS(fields))
+            continue;
+
+        syspath = g_strdup_printf("/sys%s", fields[3]);
+        nodeDeviceEventBatchAdd(batch, syspath, fields[2], NULL, NULL);
+    }
+}
+
+
+static int
+testEventBatch(const void *opaque)
+{
+    const char *name = opaque;
+    g_autofree char *logfile = NULL;
+    g_autofree char *outfile = NULL;
+    g_autofree char *log = NULL;
+    g_autofree char *actual = NULL;
+    g_autoptr(nodeDeviceEventBatch) batch = nodeDeviceEventBatchNew();
+    g_autoptr(GPtrArray) events = NULL;
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    size_t i;
+
+    logfile = g_strdup_printf("%s/nodedeveventbatchdata/%s.log", abs_srcdir, name);
+    outfile = g_strdup_printf("%s/nodedeveventbatchdata/%s.out", abs_srcdir, name);
+
+    if (virTestLoadFile(logfile, &log) < 0)
+        return -1;
+
+    testReplay(batch, log);
+    events = nodeDeviceEventBatchSteal(batch);
+
+    if (nodeDeviceEventBatchLen(batch) != 0 ||
+        nodeDeviceEventBatchReceived(batch) != 0) {
+        VIR_TEST_DEBUG("batch not empty after stealing its events");
+        return -1;
+    }
+
+    for (i = 0; i < events->len; i++) {
+        nodeDeviceEvent *event = g_ptr_array_index(events, i);
+
+        virBufferAsprintf(&buf, "%s %s\n",
+                          nodeDeviceEventActionTypeToString(event->action),
+                          event->syspath);
+    }
+
+    actual = virBufferContentAndReset(&buf);
+
+    return virTestCompareToFile(actual, outfile);
+}
+
+
+/*
+ * Replays the recording @opaque BENCH_ROUNDS times, one batch per
+ * replay, and reports how many events would have to be processed.
+ */
+static int
+testEventBatchBench(const void *opaque)
+{
+    const char *name = opaque;
+    g_autofree char *logfile = NULL;
+    g_autofree char *log = NULL;
+    g_autoptr(nodeDeviceEventBatch) batch = nodeDeviceEventBatchNew();
+    size_t received = 0;
+    size_t processed = 0;
+    gint64 start;
+    gint64 elapsed;
+    size_t i;
+
+    logfile = g_strdup_printf("%s/nodedeveventbatchdata/%s.log", abs_srcdir, name);
+
+    if (virTestLoadFile(logfile, &log) < 0)
+        return -1;
+
+    start = g_get_monotonic_time();
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        g_autoptr(GPtrArray) events = NULL;
+
+        testReplay(batch, log);
+        received += nodeDeviceEventBatchReceived(batch);
+        events = nodeDeviceEventBatchSteal(batch);
+        processed += events->len;
+    }
+
+    elapsed = g_get_monotonic_time() - start;
+
+    VIR_TEST_DEBUG("%s: %zu events received, %zu to process, %.2f us per event",
+                   name, received, processed, (double) elapsed / received);
+
+    if (processed >= received)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+#define DO_TEST(name) \
+    do { \
+        if (virTestRun("Event batch " name, testEventBatch, name) < 0) \
+            ret = -1; \
+        if (virTestGetExpensive() && \
+            virTestRun("Event batch benchmark " name, \
+                       testEventBatchBench, name) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST("scsi-rescan");
+    DO_TEST("sriov-vfs");
+    DO_TEST("usb-replug");
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
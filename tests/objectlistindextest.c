@@ -0,0 +1,811 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+#include "virnodedeviceobj.h"
+#include "virsecretobj.h"
+#include "virstorageobj.h"
+#include "virnetworkobj.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+/*
+ * The object lists keep secondary indexes which have to follow every
+ * definition that is assigned, replaced and removed. After each such
+ * step, every indexed lookup is compared against a full scan of the
+ * list for the same key.
+ */
+
+#define TEST_PCI_DEV(name, slot) \
+    "<device>" \
+    "  <name>" name "</name>" \
+    "  <path>/sys/devices/pci0000:00/0000:00:" slot ".0</path>" \
+    "  <capability type='pci'>" \
+    "    <domain>0</domain><bus>0</bus>" \
+    "    <slot>0x" slot "</slot><function>0</function>" \
+    "    <product id='0x10c9'/><vendor id='0x8086'/>" \
+    "  </capability>" \
+    "</device>"
+
+#define TEST_SCSI_HOST(name, host, wwnn, wwpn) \
+    "<device>" \
+    "  <name>" name "</name>" \
+    "  <path>/sys/devices/pci0000:00/0000:00:03.0/" name "</path>" \
+    "  <capability type='scsi_host'>" \
+    "    <host>" host "</host>" \
+    "    <capability type='fc_host'>" \
+    "      <wwnn>" wwnn "</wwnn><wwpn>" wwpn "</wwpn>" \
+    "    </capability>" \
+    "    <capability type='vport_ops'>" \
+    "      <max_vports>254</max_vports><vports>0</vports>" \
+    "    </capability>" \
+    "  </capability>" \
+    "</device>"
+
+#define TEST_MDEV(name, uuid) \
+    "<device>" \
+    "  <name>" name "</name>" \
+    "  <path>/sys/devices/virtual/mdev/" uuid "</path>" \
+    "  <capability type='mdev'>" \
+    "    <type id='i915-GVTg_V5_8'/>" \
+    "    <uuid>" uuid "</uuid>" \
+    "  </capability>" \
+    "</device>"
+
+#define TEST_UUID1 "d069d019-36ea-4111-8f0a-8c9a70e21366"
+#define TEST_UUID2 "3627463d-b7f0-4fea-b468-f1da537d301b"
+
+static const char *testNodeDevSysfsPaths[] = {
+    "/sys/devices/pci0000:00/0000:00:02.0",
+    "/sys/devices/pci0000:00/0000:00:04.0",
+    "/sys/devices/pci0000:00/0000:00:05.0",
+    "/sys/devices/pci0000:00/0000:00:03.0/scsi_host12",
+    "/sys/devices/virtual/mdev/" TEST_UUID1,
+    "/sys/devices/virtual/mdev/" TEST_UUID2,
+    "/sys/devices/nonexistent",
+};
+
+static const char *testNodeDevAddresses[] = {
+    "0000:00:02.0", "0000:00:04.0", "0000:00:05.0", "0000:00:06.0",
+};
+
+static const char *testNodeDevWWNs[][2] = {
+    { "2000f4e9d4eb02c9", "2001f4e9d4eb02c9" },
+    { "2000f4e9d4eb02ca", "2001f4e9d4eb02ca" },
+};
+
+static const char *testNodeDevMdevs[][2] = {
+    { TEST_UUID1, "0000:00:02.0" },
+    { TEST_UUID1, "0000:00:04.0" },
+    { TEST_UUID2, "0000:00:02.0" },
+};
+
+
+static int
+testNodeDevAssign(virNodeDeviceObjList *devs,
+                  const char *xml,
+                  const char *parent_addr)
+{
+    virNodeDeviceDef *def;
+    virNodeDevCapsDef *cap;
+    virNodeDeviceObj *obj;
+
+    if (!(def = virNodeDeviceDefParse(xml, NULL, EXISTING_DEVICE, NULL,
+                                      NULL, NULL, false)))
+        return -1;
+
+    /* not part of the XML, filled in from sysfs or mdevctl */
+    for (cap = def->caps; cap; cap = cap->next) {
+        if (cap->data.type == VIR_NODE_DEV_CAP_MDEV)
+            cap->data.mdev.parent_addr = g_strdup(parent_addr);
+    }
+
+    if (!(obj = virNodeDeviceObjListAssignDef(devs, def))) {
+        virNodeDeviceDefFree(def);
+        return -1;
+    }
+
+    virNodeDeviceObjEndAPI(&obj);
+    return 0;
+}
+
+
+static int
+testNodeDevRemove(virNodeDeviceObjList *devs,
+                  const char *name)
+{
+    virNodeDeviceObj *obj;
+
+    if (!(obj = virNodeDeviceObjListFindByName(devs, name)))
+        return -1;
+
+    virNodeDeviceObjListRemove(devs, obj);
+    virNodeDeviceObjEndAPI(&obj);
+    return 0;
+}
+
+
+static bool
+testNodeDevMatchSysfsPath(virNodeDeviceObj *obj,
+                          const void *opaque)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+
+    return STREQ_NULLABLE(virNodeDeviceObjGetDef(obj)->sysfs_path, opaque);
+}
+
+
+static bool
+testNodeDevMatchAddress(virNodeDeviceObj *obj,
+                        const void *opaque)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+    g_autofree char *addr = virNodeDeviceDefFormatAddress(virNodeDeviceObjGetDef(obj));
+
+    return STREQ_NULLABLE(addr, opaque);
+}
+
+
+static bool
+testNodeDevMatchMdev(virNodeDeviceObj *obj,
+                     const void *opaque)
+{
+    const char *const *mdev = opaque;
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+    virNodeDevCapsDef *cap;
+
+    for (cap = virNodeDeviceObjGetDef(obj)->caps; cap; cap = cap->next) {
+        if (cap->data.type == VIR_NODE_DEV_CAP_MDEV &&
+            STREQ(cap->data.mdev.uuid, mdev[0]) &&
+            STREQ(cap->data.mdev.parent_addr, mdev[1]))
+            return true;
+    }
+
+    return false;
+}
+
+
+static bool
+testNodeDevMatchWWNs(virNodeDeviceObj *obj,
+                     const void *opaque)
+{
+    const char *const *wwns = opaque;
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+    virNodeDevCapsDef *cap;
+
+    for (cap = virNodeDeviceObjGetDef(obj)->caps; cap; cap = cap->next) {
+        if (cap->data.type == VIR_NODE_DEV_CAP_SCSI_HOST &&
+            STREQ_NULLABLE(cap->data.scsi_host.wwnn, wwns[0]) &&
+            STREQ_NULLABLE(cap->data.scsi_host.wwpn, wwns[1]))
+            return true;
+    }
+
+    return false;
+}
+
+
+static bool
+testNodeDevIsMdev(virNodeDeviceObj *obj,
+                  const void *opaque G_GNUC_UNUSED)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+
+    return virNodeDeviceObjHasCap(obj, VIR_NODE_DEV_CAP_MDEV);
+}
+
+
+static int
+testNodeDevCompare(const char *what,
+                   const char *key,
+                   virNodeDeviceObj *indexed,
+                   virNodeDeviceObj *scanned)
+{
+    int ret = 0;
+
+    if (indexed != scanned) {
+        VIR_TEST_VERBOSE("%s '%s': index found '%s', scan found '%s'",
+                         what, key,
+                         indexed ? virNodeDeviceObjGetDef(indexed)->name : "",
+                         scanned ? virNodeDeviceObjGetDef(scanned)->name : "");
+        ret = -1;
+    }
+
+    virObjectUnref(indexed);
+    virObjectUnref(scanned);
+    return ret;
+}
+
+
+/* Both the scan and the indexed lookups return the object locked,
+ * the first one has to be unlocked before running the other. */
+static virNodeDeviceObj *
+testNodeDevScan(virNodeDeviceObjList *devs,
+                virNodeDeviceObjListPredicate predicate,
+                const void *opaque)
+{
+    virNodeDeviceObj *obj = virNodeDeviceObjListFind(devs, predicate,
+                                                     (void *) opaque);
+
+    if (obj)
+        virObjectUnlock(obj);
+    return obj;
+}
+
+
+static int
+testNodeDevCheck(virNodeDeviceObjList *devs)
+{
+    virNodeDeviceObj *indexed;
+    virNodeDeviceObj *scanned;
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(testNodeDevSysfsPaths); i++) {
+        const char *path = testNodeDevSysfsPaths[i];
+
+        scanned = testNodeDevScan(devs, testNodeDevMatchSysfsPath, path);
+        indexed = virNodeDeviceObjListFindBySysfsPath(devs, path);
+        if (indexed)
+            virObjectUnlock(indexed);
+        if (testNodeDevCompare("sysfs path", path, indexed, scanned) < 0)
+            ret = -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(testNodeDevAddresses); i++) {
+        const char *addr = testNodeDevAddresses[i];
+
+        scanned = testNodeDevScan(devs, testNodeDevMatchAddress, addr);
+        indexed = virNodeDeviceObjListFindByAddress(devs, addr);
+        if (indexed)
+            virObjectUnlock(indexed);
+        if (testNodeDevCompare("address", addr, indexed, scanned) < 0)
+            ret = -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(testNodeDevMdevs); i++) {
+        const char *uuid = testNodeDevMdevs[i][0];
+        const char *parent_addr = testNodeDevMdevs[i][1];
+
+        scanned = testNodeDevScan(devs, testNodeDevMatchMdev, testNodeDevMdevs[i]);
+        indexed = virNodeDeviceObjListFindMediatedDeviceByUUID(devs, uuid,
+                                                               parent_addr);
+        if (indexed)
+            virObjectUnlock(indexed);
+        if (testNodeDevCompare("mdev", uuid, indexed, scanned) < 0)
+            ret = -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(testNodeDevWWNs); i++) {
+        g_autoptr(virNodeDeviceDef) def = g_new0(virNodeDeviceDef, 1);
+        int expect = -1;
+        int actual;
+
+        def->name = g_strdup("vhba");
+        def->parent_wwnn = g_strdup(testNodeDevWWNs[i][0]);
+        def->parent_wwpn = g_strdup(testNodeDevWWNs[i][1]);
+
+        if ((scanned = testNodeDevScan(devs, testNodeDevMatchWWNs,
+                                       testNodeDevWWNs[i]))) {
+            virNodeDevCapsDef *cap = virNodeDeviceObjGetDef(scanned)->caps;
+
+            expect = cap->data.scsi_host.host;
+            virObjectUnref(scanned);
+        }
+
+        actual = virNodeDeviceObjListGetParentHost(devs, def);
+        virResetLastError();
+
+        if (actual != expect) {
+            VIR_TEST_VERBOSE("WWNs '%s': index found host %d, scan found host %d",
+                             def->parent_wwnn, actual, expect);
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
+
+static int
+testNodeDevIndex(const void *opaque G_GNUC_UNUSED)
+{
+    virNodeDeviceObjList *devs = virNodeDeviceObjListNew();
+    int ret = -1;
+
+    if (testNodeDevAssign(devs, TEST_PCI_DEV("pci_0000_00_02_0", "02"), NULL) < 0 ||
+        testNodeDevAssign(devs, TEST_PCI_DEV("pci_0000_00_04_0", "04"), NULL) < 0 ||
+        testNodeDevAssign(devs, TEST_SCSI_HOST("scsi_host12", "12",
+                                               "2000f4e9d4eb02c9",
+                                               "2001f4e9d4eb02c9"), NULL) < 0 ||
+        testNodeDevAssign(devs, TEST_MDEV("mdev_1", TEST_UUID1),
+                          "0000:00:02.0") < 0 ||
+        testNodeDevAssign(devs, TEST_MDEV("mdev_2", TEST_UUID2),
+                          "0000:00:02.0") < 0)
+        goto cleanup;
+
+    if (testNodeDevCheck(devs) < 0)
+        goto cleanup;
+
+    /* redefine with different keys, the old ones must not match anymore */
+    if (testNodeDevAssign(devs, TEST_PCI_DEV("pci_0000_00_04_0", "05"), NULL) < 0 ||
+        testNodeDevAssign(devs, TEST_SCSI_HOST("scsi_host12", "12",
+                                               "2000f4e9d4eb02ca",
+                                               "2001f4e9d4eb02ca"), NULL) < 0 ||
+        testNodeDevAssign(devs, TEST_MDEV("mdev_1", TEST_UUID1),
+                          "0000:00:04.0") < 0)
+        goto cleanup;
+
+    if (testNodeDevCheck(devs) < 0)
+        goto cleanup;
+
+    if (testNodeDevRemove(devs, "pci_0000_00_02_0") < 0 ||
+        testNodeDevRemove(devs, "scsi_host12") < 0)
+        goto cleanup;
+
+    if (testNodeDevCheck(devs) < 0)
+        goto cleanup;
+
+    virNodeDeviceObjListForEachRemove(devs, testNodeDevIsMdev, NULL);
+
+    if (testNodeDevCheck(devs) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virNodeDeviceObjListFree(devs);
+    return ret;
+}
+
+
+#define TEST_SECRET(uuid, volume) \
+    "<secret ephemeral='no' private='no'>" \
+    "  <uuid>" uuid "</uuid>" \
+    "  <usage type='volume'><volume>" volume "</volume></usage>" \
+    "</secret>"
+
+static const char *testSecretUsages[] = {
+    "/var/lib/libvirt/images/a.img",
+    "/var/lib/libvirt/images/b.img",
+    "/var/lib/libvirt/images/c.img",
+};
+
+
+static int
+testSecretAdd(virSecretObjList *secrets,
+              const char *xml)
+{
+    g_autoptr(virSecretDef) def = NULL;
+    virSecretObj *obj;
+
+    if (!(def = virSecretDefParse(xml, NULL, 0)) ||
+        !(obj = virSecretObjListAdd(secrets, &def, "/nonexistent", NULL)))
+        return -1;
+
+    virSecretObjEndAPI(&obj);
+    return 0;
+}
+
+
+static int
+testSecretRemove(virSecretObjList *secrets,
+                 const char *uuidstr)
+{
+    virSecretObj *obj;
+
+    if (!(obj = virSecretObjListFindByUUID(secrets, uuidstr)))
+        return -1;
+
+    virSecretObjListRemove(secrets, obj);
+    virSecretObjEndAPI(&obj);
+    return 0;
+}
+
+
+static virSecretObj *
+testSecretScan(virSecretObjList *secrets,
+               const char *usageID)
+{
+    g_autofree char **uuids = NULL;
+    virSecretObj *ret = NULL;
+    int nuuids;
+    int i;
+
+    uuids = g_new0(char *, 64);
+    if ((nuuids = virSecretObjListGetUUIDs(secrets, uuids, 64, NULL, NULL)) < 0)
+        return NULL;
+
+    for (i = 0; i < nuuids; i++) {
+        virSecretObj *obj;
+
+        if (!ret &&
+            (obj = virSecretObjListFindByUUID(secrets, uuids[i]))) {
+            if (STREQ_NULLABLE(virSecretObjGetDef(obj)->usage_id, usageID))
+                ret = virObjectRef(obj);
+            virSecretObjEndAPI(&obj);
+        }
+        g_free(uuids[i]);
+    }
+
+    return ret;
+}
+
+
+static int
+testSecretCheck(virSecretObjList *secrets)
+{
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(testSecretUsages); i++) {
+        virSecretObj *scanned = testSecretScan(secrets, testSecretUsages[i]);
+        virSecretObj *indexed;
+
+        indexed = virSecretObjListFindByUsage(secrets,
+                                              VIR_SECRET_USAGE_TYPE_VOLUME,
+                                              testSecretUsages[i]);
+
+        if (indexed != scanned) {
+            VIR_TEST_VERBOSE("usage '%s': index and scan found different secrets",
+                             testSecretUsages[i]);
+            ret = -1;
+        }
+
+        virSecretObjEndAPI(&indexed);
+        virObjectUnref(scanned);
+    }
+
+    return ret;
+}
+
+
+static int
+testSecretIndex(const void *opaque G_GNUC_UNUSED)
+{
+    virSecretObjList *secrets = virSecretObjListNew();
+    int ret = -1;
+
+    if (testSecretAdd(secrets, TEST_SECRET(TEST_UUID1, "/var/lib/libvirt/images/a.img")) < 0 ||
+        testSecretAdd(secrets, TEST_SECRET(TEST_UUID2, "/var/lib/libvirt/images/b.img")) < 0)
+        goto cleanup;
+
+    if (testSecretCheck(secrets) < 0)
+        goto cleanup;
+
+    /* redefining a secret keeps its usage */
+    if (testSecretAdd(secrets, TEST_SECRET(TEST_UUID1, "/var/lib/libvirt/images/a.img")) < 0)
+        goto cleanup;
+
+    if (testSecretAdd(secrets, TEST_SECRET(TEST_UUID1, "/var/lib/libvirt/images/c.img")) == 0) {
+        VIR_TEST_VERBOSE("changing the usage of a secret succeeded");
+        goto cleanup;
+    }
+    virResetLastError();
+
+    if (testSecretCheck(secrets) < 0)
+        goto cleanup;
+
+    if (testSecretRemove(secrets, TEST_UUID1) < 0)
+        goto cleanup;
+
+    if (testSecretCheck(secrets) < 0)
+        goto cleanup;
+
+    /* the usage of a removed secret is free again */
+    if (testSecretAdd(secrets, TEST_SECRET(TEST_UUID1, "/var/lib/libvirt/images/c.img")) < 0)
+        goto cleanup;
+
+    if (testSecretCheck(secrets) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnref(secrets);
+    return ret;
+}
+
+
+#define TEST_POOL(name, uuid, path) \
+    "<pool type='dir'>" \
+    "  <name>" name "</name>" \
+    "  <uuid>" uuid "</uuid>" \
+    "  <target><path>" path "</path></target>" \
+    "</pool>"
+
+static const char *testPoolPaths[] = {
+    "/var/lib/libvirt/images/a",
+    "/var/lib/libvirt/images/b",
+    "/var/lib/libvirt/images/c",
+    "/var/lib/libvirt/images/d",
+};
+
+
+static virStoragePoolObj *
+testPoolAdd(virStoragePoolObjList *pools,
+            const char *xml)
+{
+    g_autoptr(virStoragePoolDef) def = NULL;
+
+    if (!(def = virStoragePoolDefParse(xml, NULL, 0)))
+        return NULL;
+
+    return virStoragePoolObjListAdd(pools, &def, 0);
+}
+
+
+static bool
+testPoolMatchTargetPath(virStoragePoolObj *obj,
+                        const void *opaque)
+{
+    return virStoragePoolObjIsActive(obj) &&
+        STREQ_NULLABLE(virStoragePoolObjGetDef(obj)->target.path, opaque);
+}
+
+
+static int
+testPoolCheck(virStoragePoolObjList *pools)
+{
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(testPoolPaths); i++) {
+        virStoragePoolObj *scanned;
+        virStoragePoolObj *indexed;
+
+        scanned = virStoragePoolObjListSearch(pools, testPoolMatchTargetPath,
+                                              testPoolPaths[i]);
+        if (scanned)
+            virObjectUnlock(scanned);
+
+        indexed = virStoragePoolObjListFindByTargetPath(pools, testPoolPaths[i]);
+
+        if (indexed != scanned) {
+            VIR_TEST_VERBOSE("target path '%s': index and scan found different pools",
+                             testPoolPaths[i]);
+            ret = -1;
+        }
+
+        virStoragePoolObjEndAPI(&indexed);
+        virObjectUnref(scanned);
+    }
+
+    return ret;
+}
+
+
+static int
+testPoolIndex(const void *opaque G_GNUC_UNUSED)
+{
+    virStoragePoolObjList *pools = virStoragePoolObjListNew();
+    virStoragePoolObj *obj = NULL;
+    int ret = -1;
+
+    if (!(obj = testPoolAdd(pools, TEST_POOL("a", TEST_UUID1,
+                                             "/var/lib/libvirt/images/a"))))
+        goto cleanup;
+    virStoragePoolObjSetActive(obj, true);
+    virStoragePoolObjEndAPI(&obj);
+
+    if (!(obj = testPoolAdd(pools, TEST_POOL("b", TEST_UUID2,
+                                             "/var/lib/libvirt/images/b"))))
+        goto cleanup;
+    virStoragePoolObjEndAPI(&obj);
+
+    if (testPoolCheck(pools) < 0)
+        goto cleanup;
+
+    /* redefining an active pool only takes effect once it is restarted */
+    if (!(obj = testPoolAdd(pools, TEST_POOL("a", TEST_UUID1,
+                                             "/var/lib/libvirt/images/c"))))
+        goto cleanup;
+    virStoragePoolObjEndAPI(&obj);
+
+    if (testPoolCheck(pools) < 0)
+        goto cleanup;
+
+    if (!(obj = virStoragePoolObjListSearch(pools, testPoolMatchTargetPath,
+                                            "/var/lib/libvirt/images/a")))
+        goto cleanup;
+    virStoragePoolObjDefUseNewDef(obj);
+    virStoragePoolObjEndAPI(&obj);
+
+    if (testPoolCheck(pools) < 0)
+        goto cleanup;
+
+    /* an inactive pool is redefined right away */
+    if (!(obj = testPoolAdd(pools, TEST_POOL("b", TEST_UUID2,
+                                             "/var/lib/libvirt/images/d"))))
+        goto cleanup;
+    virStoragePoolObjSetActive(obj, true);
+    virStoragePoolObjEndAPI(&obj);
+
+    if (testPoolCheck(pools) < 0)
+        goto cleanup;
+
+    if (!(obj = virStoragePoolObjListSearch(pools, testPoolMatchTargetPath,
+                                            "/var/lib/libvirt/images/c")))
+        goto cleanup;
+    virStoragePoolObjRemove(pools, obj);
+    virStoragePoolObjEndAPI(&obj);
+
+    if (testPoolCheck(pools) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virStoragePoolObjEndAPI(&obj);
+    virObjectUnref(pools);
+    return ret;
+}
+
+
+#define TEST_NETWORK(name, uuid) \
+    "<network>" \
+    "  <name>" name "</name>" \
+    "  <uuid>" uuid "</uuid>" \
+    "</network>"
+
+static const char *testNetworkNames[] = {
+    "default", "isolated", "routed",
+};
+
+
+static int
+testNetworkAssign(virNetworkObjList *nets,
+                  const char *xml,
+                  bool active)
+{
+    g_autoptr(virNetworkDef) def = NULL;
+    virNetworkObj *obj;
+
+    if (!(def = virNetworkDefParse(xml, NULL, NULL, false)) ||
+        !(obj = virNetworkObjAssignDef(nets, def, 0)))
+        return -1;
+
+    def = NULL;
+    virNetworkObjSetActive(obj, active);
+    virNetworkObjEndAPI(&obj);
+    return 0;
+}
+
+
+struct testNetworkScanData {
+    const char *name;
+    virNetworkObj *obj;
+};
+
+static int
+testNetworkScanCallback(virNetworkObj *obj,
+                        void *opaque)
+{
+    struct testNetworkScanData *data = opaque;
+    VIR_LOCK_GUARD lock = virObjectLockGuard(obj);
+
+    if (!data->obj && STREQ(virNetworkObjGetDef(obj)->name, data->name))
+        data->obj = virObjectRef(obj);
+
+    return 0;
+}
+
+
+static int
+testNetworkCheck(virNetworkObjList *nets)
+{
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(testNetworkNames); i++) {
+        struct testNetworkScanData data = { .name = testNetworkNames[i] };
+        virNetworkObj *indexed;
+
+        if (virNetworkObjListForEach(nets, testNetworkScanCallback, &data) < 0)
+            return -1;
+
+        indexed = virNetworkObjFindByName(nets, testNetworkNames[i]);
+
+        if (indexed != data.obj) {
+            VIR_TEST_VERBOSE("name '%s': index and scan found different networks",
+                             testNetworkNames[i]);
+            ret = -1;
+        }
+
+        virNetworkObjEndAPI(&indexed);
+        virObjectUnref(data.obj);
+    }
+
+    return ret;
+}
+
+
+static int
+testNetworkIndex(const void *opaque G_GNUC_UNUSED)
+{
+    virNetworkObjList *nets = virNetworkObjListNew();
+    virNetworkObj *obj = NULL;
+    int ret = -1;
+
+    if (testNetworkAssign(nets, TEST_NETWORK("default", TEST_UUID1), true) < 0 ||
+        testNetworkAssign(nets, TEST_NETWORK("isolated", TEST_UUID2), false) < 0)
+        goto cleanup;
+
+    if (testNetworkCheck(nets) < 0)
+        goto cleanup;
+
+    if (testNetworkAssign(nets, TEST_NETWORK("isolated", TEST_UUID2), false) < 0)
+        goto cleanup;
+
+    if (testNetworkCheck(nets) < 0)
+        goto cleanup;
+
+    if (!(obj = virNetworkObjFindByName(nets, "isolated")))
+        goto cleanup;
+    virNetworkObjRemoveInactive(nets, obj);
+    virNetworkObjEndAPI(&obj);
+
+    if (testNetworkCheck(nets) < 0)
+        goto cleanup;
+
+    /* the name of a removed network can be reused */
+    if (testNetworkAssign(nets, TEST_NETWORK("isolated",
+                                             "c60cc60c-c60c-c60c-c60c-c60cc60cc60c"),
+                          false) < 0 ||
+        testNetworkAssign(nets, TEST_NETWORK("routed",
+                                             "ee0b88c4-f554-4dc1-809d-b2a01e8e48ad"),
+                          false) < 0)
+        goto cleanup;
+
+    if (testNetworkCheck(nets) < 0)
+        goto cleanup;
+
+    virNetworkObjListPrune(nets, VIR_CONNECT_LIST_NETWORKS_INACTIVE);
+
+    if (testNetworkCheck(nets) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    virNetworkObjEndAPI(&obj);
+    virObjectUnref(nets);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (virTestRun("Node device list indexes", testNodeDevIndex, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Secret list indexes", testSecretIndex, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Storage pool list indexes", testPoolIndex, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Network list indexes", testNetworkIndex, NULL) < 0)
+        ret = -1;
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -0,0 +1,262 @@
+/*
+ * qemudomainstatstest.c: Test gathering stats of a list of domains
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+#include "testutilsqemu.h"
+#include "datatypes.h"
+#include "qemu/qemu_domain.h"
+
+#define LIBVIRT_QEMU_DRIVERPRIV_H_ALLOW
+#include "qemu/qemu_driverpriv.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+/* enough domains for qemuDomainGetStatsList to use the pool */
+#define TEST_DOMAINS 16
+
+static virQEMUDriver driver;
+
+struct testStatsData {
+    virConnectPtr conn;
+    virDomainObj *vms[TEST_DOMAINS];
+};
+
+
+static virDomainObj *
+testStatsCreateDomain(size_t idx,
+                      virQEMUCaps *qemuCaps)
+{
+    g_autoptr(virDomainObj) vm = NULL;
+    qemuDomainObjPrivate *priv;
+    g_autofree char *xml = NULL;
+
+    xml = g_strdup_printf("<domain type='qemu'>\n"
+                          "  <name>stats%zu</name>\n"
+                          "  <uuid>c7a5fdbd-edaf-9455-926a-d65c16db18%02zx</uuid>\n"
+                          "  <memory unit='KiB'>%zu</memory>\n"
+                          "  <vcpu>1</vcpu>\n"
+                          "  <os>\n"
+                          "    <type arch='x86_64' machine='pc'>hvm</type>\n"
+                          "  </os>\n"
+                          "  <devices>\n"
+                          "    <emulator>%s</emulator>\n"
+                          "  </devices>\n"
+                          "</domain>\n",
+                          idx, idx, 219136 + idx * 1024,
+                          virQEMUCapsGetBinary(qemuCaps));
+
+    if (!(vm = virDomainObjNew(driver.xmlopt)))
+        return NULL;
+
+    priv = vm->privateData;
+    priv->qemuCaps = virObjectRef(qemuCaps);
+
+    if (!(vm->def = virDomainDefParseString(xml, driver.xmlopt, NULL, 0)))
+        return NULL;
+
+    return g_steal_pointer(&vm);
+}
+
+
+static int
+testStatsGather(struct testStatsData *data,
+                bool parallel,
+                unsigned int stats,
+                unsigned int flags,
+                virDomainStatsRecordPtr **records)
+{
+    int rc;
+
+    if (parallel && !(driver.statsPool = qemuDomainGetStatsPoolNew(NULL)))
+        return -1;
+
+    *records = g_new0(virDomainStatsRecordPtr, TEST_DOMAINS + 1);
+
+    rc = qemuDomainGetStatsList(data->conn, data->vms, TEST_DOMAINS,
+                                stats, *records, flags);
+
+    g_clear_pointer(&driver.statsPool, virThreadPoolFree);
+
+    return rc;
+}
+
+
+static int
+testStatsCompare(virDomainStatsRecordPtr *serial,
+                 virDomainStatsRecordPtr *parallel)
+{
+    size_t i;
+
+    for (i = 0; i < TEST_DOMAINS; i++) {
+        g_autofree char *name = g_strdup_printf("stats%zu", i);
+        const char *sxml = NULL;
+        const char *pxml = NULL;
+        int sstate = -1;
+        int pstate = -1;
+
+        if (!serial[i] || !parallel[i]) {
+            VIR_TEST_VERBOSE("missing record %zu", i);
+            return -1;
+        }
+
+        if (STRNEQ(serial[i]->dom->name, parallel[i]->dom->name) ||
+            STRNEQ(serial[i]->dom->name, name)) {
+            VIR_TEST_VERBOSE("record %zu is of '%s' and '%s'", i,
+                             serial[i]->dom->name, parallel[i]->dom->name);
+            return -1;
+        }
+
+        if (virTypedParamsGetString(serial[i]->params, serial[i]->nparams,
+                                    "xml", &sxml) != 1 ||
+            virTypedParamsGetString(parallel[i]->params, parallel[i]->nparams,
+                                    "xml", &pxml) != 1 ||
+            virTypedParamsGetInt(serial[i]->params, serial[i]->nparams,
+                                 "state.state", &sstate) != 1 ||
+            virTypedParamsGetInt(parallel[i]->params, parallel[i]->nparams,
+                                 "state.state", &pstate) != 1) {
+            VIR_TEST_VERBOSE("record %zu lacks 'xml' or 'state.state'", i);
+            return -1;
+        }
+
+        if (serial[i]->nparams != parallel[i]->nparams ||
+            sstate != pstate ||
+            sstate != VIR_DOMAIN_SHUTOFF) {
+            VIR_TEST_VERBOSE("record %zu differs", i);
+            return -1;
+        }
+
+        if (virTestCompareToString(sxml, pxml) < 0)
+            return -1;
+    }
+
+    if (serial[TEST_DOMAINS] || parallel[TEST_DOMAINS]) {
+        VIR_TEST_VERBOSE("records aren't NULL terminated");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testStatsList(const void *opaque)
+{
+    struct testStatsData *data = (struct testStatsData *) opaque;
+    virDomainStatsRecordPtr *serial = NULL;
+    virDomainStatsRecordPtr *parallel = NULL;
+    unsigned int stats = VIR_DOMAIN_STATS_STATE | VIR_DOMAIN_STATS_XML;
+    int ret = -1;
+
+    if (testStatsGather(data, false, stats, 0, &serial) < 0 ||
+        testStatsGather(data, true, stats, 0, &parallel) < 0)
+        goto cleanup;
+
+    ret = testStatsCompare(serial, parallel);
+
+ cleanup:
+    virDomainStatsRecordListFree(serial);
+    virDomainStatsRecordListFree(parallel);
+    return ret;
+}
+
+
+static int
+testStatsListEnforce(const void *opaque)
+{
+    struct testStatsData *data = (struct testStatsData *) opaque;
+    unsigned int flags = VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS;
+    bool parallel;
+    int ret = 0;
+
+    for (parallel = false; ; parallel = true) {
+        virDomainStatsRecordPtr *records = NULL;
+
+        if (testStatsGather(data, parallel, 1U << 30, flags, &records) == 0) {
+            VIR_TEST_VERBOSE("unsupported stats group accepted, parallel=%d",
+                             parallel);
+            ret = -1;
+        } else if (records[0]) {
+            VIR_TEST_VERBOSE("records returned on error, parallel=%d",
+                             parallel);
+            ret = -1;
+        }
+
+        virDomainStatsRecordListFree(records);
+        virResetLastError();
+
+        if (parallel)
+            break;
+    }
+
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    g_autoptr(GHashTable) capsLatestFiles = testQemuGetLatestCaps();
+    g_autoptr(GHashTable) capsCache = virHashNew(virObjectUnref);
+    struct testStatsData data = { 0 };
+    g_autoptr(virQEMUCaps) qemuCaps = NULL;
+    int ret = 0;
+    size_t i;
+
+    if (qemuTestDriverInit(&driver) < 0)
+        return EXIT_FAILURE;
+
+    if (!(qemuCaps = testQemuGetRealCaps("x86_64", "latest", "",
+                                         capsLatestFiles, capsCache,
+                                         NULL, NULL)) ||
+        qemuTestCapsCacheInsert(driver.qemuCapsCache, qemuCaps) < 0) {
+        ret = -1;
+        goto cleanup;
+    }
+
+    for (i = 0; i < TEST_DOMAINS; i++) {
+        if (!(data.vms[i] = testStatsCreateDomain(i, qemuCaps))) {
+            ret = -1;
+            goto cleanup;
+        }
+    }
+
+    if (!(data.conn = virGetConnect())) {
+        ret = -1;
+        goto cleanup;
+    }
+    data.conn->privateData = &driver;
+
+    if (virTestRun("stats list serial and parallel", testStatsList, &data) < 0)
+        ret = -1;
+
+    if (virTestRun("stats list enforce", testStatsListEnforce, &data) < 0)
+        ret = -1;
+
+ cleanup:
+    for (i = 0; i < TEST_DOMAINS; i++)
+        virObjectUnref(data.vms[i]);
+    virObjectUnref(data.conn);
+    qemuTestDriverFree(&driver);
+
+    return (ret == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN_PRELOAD(mymain,
+                      VIR_TEST_MOCK("domaincaps"))
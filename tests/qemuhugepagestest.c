@@ -0,0 +1,319 @@
+/*
+ * qemuhugepagestest.c: Test huge page reservations of domains being started
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "qemu/qemu_hugepages.h"
+# include "virfilewrapper.h"
+# include "virnuma.h"
+
+# include "testutilsqemu.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+/*
+ * The host has two NUMA nodes with 1 and 2 GiB of memory, see
+ * virNumaGetNodeMemory() in virnumamock.c. Their pools of 2 MiB huge
+ * pages initially hold 128 and 256 free pages, see qemuhugepagesdata.
+ * The pools the test grows are reset by testHugepagesSetup().
+ */
+
+# define PAGE_SIZE 2048
+
+static virQEMUDriver driver;
+
+static const char *domainXML =
+    "<domain type='kvm'>"
+    "  <name>%s</name>"
+    "  <uuid>%s</uuid>"
+    "  <memory unit='KiB'>%llu</memory>"
+    "  <memoryBacking>"
+    "    <hugepages>"
+    "      <page size='2048' unit='KiB'/>"
+    "    </hugepages>"
+    "  </memoryBacking>"
+    "  <vcpu placement='static'>1</vcpu>"
+    "  %s"
+    "  <os>"
+    "    <type arch='x86_64' machine='pc'>hvm</type>"
+    "  </os>"
+    "  <devices>"
+    "    <emulator>/usr/bin/qemu-system-x86_64</emulator>"
+    "  </devices>"
+    "</domain>";
+
+static const char *numatuneNode0 =
+    "<numatune><memory mode='strict' nodeset='0'/></numatune>";
+
+
+static virDomainObj *
+testHugepagesNewDomain(const char *name,
+                       const char *uuid,
+                       unsigned long long npages,
+                       const char *numatune)
+{
+    g_autoptr(virDomainObj) vm = NULL;
+    g_autofree char *xml = NULL;
+
+    xml = g_strdup_printf(domainXML, name, uuid, npages * PAGE_SIZE,
+                          NULLSTR_EMPTY(numatune));
+
+    if (!(vm = virDomainObjNew(driver.xmlopt)))
+        return NULL;
+
+    if (!(vm->def = virDomainDefParseString(xml, driver.xmlopt, NULL,
+                                            VIR_DOMAIN_DEF_PARSE_INACTIVE)))
+        return NULL;
+
+    return g_steal_pointer(&vm);
+}
+
+
+static int
+testHugepagesSetup(unsigned int percent)
+{
+    g_clear_pointer(&driver.hugepageLedger, virObjectUnref);
+
+    if (!(driver.hugepageLedger = qemuHugepageLedgerNew()))
+        return -1;
+
+    driver.config->hugepagePoolMaxPercent = percent;
+
+    if (virNumaSetPagePoolSize(0, PAGE_SIZE, 128, false) < 0 ||
+        virNumaSetPagePoolSize(1, PAGE_SIZE, 256, false) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testHugepagesCheck(unsigned long long reserved,
+                   unsigned int reservations,
+                   unsigned long long grown,
+                   unsigned long long node0Total)
+{
+    virTypedParameter params[QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM] = { 0 };
+    unsigned long long total;
+
+    if (qemuHugepagesGetParameters(&driver, params,
+                                   QEMU_HUGEPAGE_LEDGER_PARAMETERS_NUM) < 0)
+        return -1;
+
+    if (virNumaGetPageInfo(0, PAGE_SIZE, 0, &total, NULL) < 0)
+        return -1;
+
+    if (params[0].value.ul != reserved * PAGE_SIZE ||
+        params[1].value.ui != reservations ||
+        params[2].value.ul != grown * PAGE_SIZE ||
+        total != node0Total) {
+        VIR_TEST_VERBOSE("reserved=%llu reservations=%u grown=%llu node0=%llu, "
+                         "expected %llu %u %llu %llu",
+                         params[0].value.ul / PAGE_SIZE, params[1].value.ui,
+                         params[2].value.ul / PAGE_SIZE, total,
+                         reserved, reservations, grown, node0Total);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testHugepagesReserveFail(virDomainObj *vm)
+{
+    if (qemuHugepagesReserve(&driver, vm) == 0) {
+        VIR_TEST_VERBOSE("reservation for '%s' succeeded unexpectedly",
+                         vm->def->name);
+        return -1;
+    }
+
+    VIR_TEST_DEBUG("expected failure: %s", virGetLastErrorMessage());
+    virResetLastError();
+    return 0;
+}
+
+
+/* Two domains starting at the same time can't count on the same free
+ * huge pages. */
+static int
+testHugepagesConcurrent(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virDomainObj) vm1 = NULL;
+    g_autoptr(virDomainObj) vm2 = NULL;
+
+    if (testHugepagesSetup(0) < 0)
+        return -1;
+
+    if (!(vm1 = testHugepagesNewDomain("vm1", "c7a5fdbd-edaf-9455-926a-d65c16db1801",
+                                       96, numatuneNode0)) ||
+        !(vm2 = testHugepagesNewDomain("vm2", "c7a5fdbd-edaf-9455-926a-d65c16db1802",
+                                       96, numatuneNode0)))
+        return -1;
+
+    if (qemuHugepagesReserve(&driver, vm1) < 0 ||
+        testHugepagesCheck(96, 1, 0, 128) < 0)
+        return -1;
+
+    /* only 32 of the 128 free pages are left for vm2 */
+    if (testHugepagesReserveFail(vm2) < 0 ||
+        testHugepagesCheck(96, 1, 0, 128) < 0)
+        return -1;
+
+    /* once QEMU of vm1 has allocated its memory, vm2 can go on */
+    qemuHugepagesRelease(&driver, vm1);
+    if (testHugepagesCheck(0, 0, 0, 128) < 0)
+        return -1;
+
+    if (qemuHugepagesReserve(&driver, vm2) < 0 ||
+        testHugepagesCheck(96, 1, 0, 128) < 0)
+        return -1;
+
+    qemuHugepagesRelease(&driver, vm2);
+    return testHugepagesCheck(0, 0, 0, 128);
+}
+
+
+/* The pool of node 0 may be grown to 50% of its 1 GiB, i.e. 256 pages. */
+static int
+testHugepagesGrow(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virDomainObj) vm1 = NULL;
+    g_autoptr(virDomainObj) vm2 = NULL;
+
+    if (testHugepagesSetup(50) < 0)
+        return -1;
+
+    if (!(vm1 = testHugepagesNewDomain("vm1", "c7a5fdbd-edaf-9455-926a-d65c16db1801",
+                                       192, numatuneNode0)) ||
+        !(vm2 = testHugepagesNewDomain("vm2", "c7a5fdbd-edaf-9455-926a-d65c16db1802",
+                                       192, numatuneNode0)))
+        return -1;
+
+    /* the pool grows by the 64 missing pages */
+    if (qemuHugepagesReserve(&driver, vm1) < 0 ||
+        testHugepagesCheck(192, 1, 64, 192) < 0)
+        return -1;
+
+    /* the pool grows up to the limit, which is still 128 pages short */
+    if (testHugepagesReserveFail(vm2) < 0 ||
+        testHugepagesCheck(192, 1, 128, 256) < 0)
+        return -1;
+
+    /* and not any further */
+    if (testHugepagesReserveFail(vm2) < 0 ||
+        testHugepagesCheck(192, 1, 128, 256) < 0)
+        return -1;
+
+    /* the pages vm1 no longer holds are enough for vm2 */
+    qemuHugepagesRelease(&driver, vm1);
+    if (qemuHugepagesReserve(&driver, vm2) < 0 ||
+        testHugepagesCheck(192, 1, 128, 256) < 0)
+        return -1;
+
+    qemuHugepagesRelease(&driver, vm2);
+    return testHugepagesCheck(0, 0, 128, 256);
+}
+
+
+/* Without numatune, the pages may come from any node. */
+static int
+testHugepagesSpread(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virDomainObj) vm1 = NULL;
+    g_autoptr(virDomainObj) vm2 = NULL;
+
+    if (testHugepagesSetup(0) < 0)
+        return -1;
+
+    if (!(vm1 = testHugepagesNewDomain("vm1", "c7a5fdbd-edaf-9455-926a-d65c16db1801",
+                                       320, NULL)) ||
+        !(vm2 = testHugepagesNewDomain("vm2", "c7a5fdbd-edaf-9455-926a-d65c16db1802",
+                                       96, numatuneNode0)))
+        return -1;
+
+    if (qemuHugepagesReserve(&driver, vm1) < 0 ||
+        testHugepagesCheck(320, 1, 0, 128) < 0)
+        return -1;
+
+    /* vm1 took all pages of node 0 */
+    if (testHugepagesReserveFail(vm2) < 0)
+        return -1;
+
+    qemuHugepagesRelease(&driver, vm1);
+    if (qemuHugepagesReserve(&driver, vm2) < 0)
+        return -1;
+
+    qemuHugepagesRelease(&driver, vm2);
+    return testHugepagesCheck(0, 0, 0, 128);
+}
+
+
+static int
+mymain(void)
+{
+    g_autoptr(GHashTable) capslatest = testQemuGetLatestCaps();
+    g_autoptr(GHashTable) capscache = virHashNew(virObjectUnref);
+    int ret = 0;
+
+    virFileWrapperAddPrefix("/sys/devices/system",
+                            abs_srcdir "/qemuhugepagesdata");
+
+    if (qemuTestDriverInit(&driver) < 0)
+        return EXIT_FAILURE;
+
+    qemuTestSetHostArch(&driver, VIR_ARCH_X86_64);
+
+    if (testQemuInsertRealCaps(driver.qemuCapsCache, "x86_64", "latest", "",
+                               capslatest, capscache, NULL, NULL) < 0) {
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (virTestRun("concurrent reservations", testHugepagesConcurrent, NULL) < 0)
+        ret = -1;
+    if (virTestRun("pool growth", testHugepagesGrow, NULL) < 0)
+        ret = -1;
+    if (virTestRun("reservation across nodes", testHugepagesSpread, NULL) < 0)
+        ret = -1;
+
+ cleanup:
+    g_clear_pointer(&driver.hugepageLedger, virObjectUnref);
+    qemuTestDriverFree(&driver);
+    virFileWrapperClearPrefixes();
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN_PRELOAD(mymain,
+                      VIR_TEST_MOCK("virnuma"),
+                      VIR_TEST_MOCK("domaincaps"))
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
@@ -0,0 +1,148 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+#include "remote/remote_cache.h"
+
+#define VIR_FROM_THIS VIR_FROM_REMOTE
+
+
+static int
+testCacheLookupExpect(remoteCache *cache,
+                      const char *key,
+                      const char *expect,
+                      int *generation)
+{
+    g_autofree char *value = remoteCacheLookupString(cache, key, generation);
+
+    if (STRNEQ_NULLABLE(value, expect)) {
+        VIR_TEST_VERBOSE("'%s' is '%s', expected '%s'",
+                         key, NULLSTR(value), NULLSTR(expect));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCacheHit(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(remoteCache) cache = remoteCacheNew(3600 * 1000);
+    g_autoptr(GBytes) data = NULL;
+    virNodeInfo info = { .model = "x86_64", .memory = 1024, .cpus = 4 };
+    int generation;
+
+    if (testCacheLookupExpect(cache, "hostname", NULL, &generation) < 0)
+        return -1;
+
+    remoteCacheStoreString(cache, "hostname", generation, "host.example.com");
+    remoteCacheStore(cache, "nodeinfo", generation, &info, sizeof(info));
+
+    if (testCacheLookupExpect(cache, "hostname", "host.example.com",
+                              &generation) < 0 ||
+        testCacheLookupExpect(cache, "capabilities", NULL, &generation) < 0)
+        return -1;
+
+    if (!(data = remoteCacheLookup(cache, "nodeinfo", &generation)) ||
+        g_bytes_get_size(data) != sizeof(info) ||
+        memcmp(g_bytes_get_data(data, NULL), &info, sizeof(info)) != 0) {
+        VIR_TEST_VERBOSE("cached node info doesn't match");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testCacheExpire(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(remoteCache) cache = remoteCacheNew(10);
+    int generation;
+
+    ignore_value(testCacheLookupExpect(cache, "hostname", NULL, &generation));
+    remoteCacheStoreString(cache, "hostname", generation, "host.example.com");
+
+    g_usleep(20 * 1000);
+
+    return testCacheLookupExpect(cache, "hostname", NULL, &generation);
+}
+
+
+static int
+testCacheInvalidate(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(remoteCache) cache = remoteCacheNew(3600 * 1000);
+    int generation;
+
+    ignore_value(testCacheLookupExpect(cache, "hostname", NULL, &generation));
+    remoteCacheStoreString(cache, "hostname", generation, "host.example.com");
+
+    remoteCacheInvalidate(cache);
+
+    if (testCacheLookupExpect(cache, "hostname", NULL, &generation) < 0)
+        return -1;
+
+    /* data fetched before an invalidation is not stored */
+    remoteCacheInvalidate(cache);
+    remoteCacheStoreString(cache, "hostname", generation, "stale.example.com");
+
+    if (testCacheLookupExpect(cache, "hostname", NULL, &generation) < 0)
+        return -1;
+
+    remoteCacheStoreString(cache, "hostname", generation, "new.example.com");
+
+    return testCacheLookupExpect(cache, "hostname", "new.example.com",
+                                 &generation);
+}
+
+
+static int
+testCacheDisabled(const void *opaque G_GNUC_UNUSED)
+{
+    int generation;
+
+    remoteCacheStoreString(NULL, "hostname", 0, "host.example.com");
+    remoteCacheInvalidate(NULL);
+
+    return testCacheLookupExpect(NULL, "hostname", NULL, &generation);
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+    if (virTestRun("Cache hit", testCacheHit, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache expire", testCacheExpire, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache invalidate", testCacheInvalidate, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cache disabled", testCacheDisabled, NULL) < 0)
+        ret = -1;
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -307,6 +307,62 @@ testInsertArray(const void *opaque G_GNUC_UNUSED)
 }
 
 
+static int
+testArena(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virArena) arena = virArenaNew(64);
+    const char *big = "this string is too long to fit into a single chunk of the arena";
+    char *small;
+    char *copy;
+    char *part;
+    size_t i;
+
+    for (i = 0; i < 32; i++) {
+        unsigned char *p = virArenaAlloc(arena, i + 1);
+        size_t j;
+
+        if ((uintptr_t) p % sizeof(void *) != 0) {
+            fprintf(stderr, "Allocation %zu is not aligned: %p\n", i, p);
+            return -1;
+        }
+
+        for (j = 0; j <= i; j++) {
+            if (p[j] != 0) {
+                fprintf(stderr, "Allocation %zu is not zeroed\n", i);
+                return -1;
+            }
+        }
+
+        memset(p, 0xff, i + 1);
+    }
+
+    small = virArenaStrdup(arena, "small");
+    copy = virArenaStrdup(arena, big);
+    part = virArenaStrndup(arena, big, 4);
+
+    if (STRNEQ(small, "small") || STRNEQ(copy, big) || STRNEQ(part, "this")) {
+        fprintf(stderr, "Unexpected copies '%s', '%s', '%s'\n",
+                small, copy, part);
+        return -1;
+    }
+
+    if (virArenaStrdup(arena, NULL) != NULL) {
+        fprintf(stderr, "Expecting copy of NULL to be NULL\n");
+        return -1;
+    }
+
+    virArenaReset(arena);
+
+    small = virArenaStrdup(arena, "again");
+    if (STRNEQ(small, "again")) {
+        fprintf(stderr, "Unexpected copy '%s' after reset\n", small);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 mymain(void)
 {
@@ -320,6 +376,8 @@ mymain(void)
         ret = -1;
     if (virTestRun("insert array", testInsertArray, NULL) < 0)
         ret = -1;
+    if (virTestRun("arena", testArena, NULL) < 0)
+        ret = -1;
 
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
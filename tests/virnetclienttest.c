@@ -0,0 +1,352 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <signal.h>
+#include <unistd.h>
+#ifndef WIN32
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#include "testutils.h"
+
+#ifdef WIN32
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#else
+
+# include "virfile.h"
+# include "virlog.h"
+# include "rpc/virnetclient.h"
+
+# define VIR_FROM_THIS VIR_FROM_RPC
+
+VIR_LOG_INIT("tests.netclienttest");
+
+# define TEST_PROGRAM 0x11223344
+# define TEST_VERSION 1
+# define TEST_PROC 7
+
+static char *sockpath;
+
+
+/*
+ * Connects a client to a listening socket the test plays the server
+ * on. The server never reads the calls, it just writes the replies
+ * with the serials the test expects the client to use.
+ */
+static int
+testClientOpen(virNetClient **client,
+               int *serverfd)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    VIR_AUTOCLOSE listenfd = -1;
+
+    unlink(sockpath);
+
+    if (virStrcpyStatic(addr.sun_path, sockpath) < 0 ||
+        (listenfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenfd, 1) < 0)
+        return -1;
+
+    if (!(*client = virNetClientNewUNIX(sockpath, NULL)))
+        return -1;
+
+    if ((*serverfd = accept(listenfd, NULL, NULL)) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static virNetMessage *
+testMessageNew(int type,
+               unsigned int serial)
+{
+    virNetMessage *msg = virNetMessageNew(false);
+
+    msg->header.prog = TEST_PROGRAM;
+    msg->header.vers = TEST_VERSION;
+    msg->header.proc = TEST_PROC;
+    msg->header.type = type;
+    msg->header.serial = serial;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0 ||
+        virNetMessageEncodePayload(msg, (xdrproc_t) xdr_void, NULL) < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
+
+static virNetClientCall *
+testCallSend(virNetClient *client,
+             unsigned int serial)
+{
+    virNetMessage *msg;
+    virNetClientCall *call = NULL;
+
+    if (!(msg = testMessageNew(VIR_NET_CALL, serial)))
+        return NULL;
+
+    if (virNetClientSendWithReplyPipelined(client, msg, &call) < 0) {
+        virNetMessageFree(msg);
+        return NULL;
+    }
+
+    return call;
+}
+
+
+static int
+testReplySend(int serverfd,
+              unsigned int serial)
+{
+    virNetMessage *msg;
+    int ret = 0;
+
+    if (!(msg = testMessageNew(VIR_NET_REPLY, serial)))
+        return -1;
+
+    if (safewrite(serverfd, msg->buffer, msg->bufferLength) < 0)
+        ret = -1;
+
+    virNetMessageFree(msg);
+    return ret;
+}
+
+
+static int
+testCallWait(virNetClient *client,
+             virNetClientCall *call,
+             unsigned int serial)
+{
+    virNetMessage *msg;
+    int ret = 0;
+
+    if (!(msg = virNetClientCallWait(client, call))) {
+        VIR_TEST_VERBOSE("no reply to call %u", serial);
+        return -1;
+    }
+
+    if (msg->header.type != VIR_NET_REPLY ||
+        msg->header.serial != serial) {
+        VIR_TEST_VERBOSE("call %u got reply %u of type %d",
+                         serial, msg->header.serial, msg->header.type);
+        ret = -1;
+    }
+
+    virNetMessageFree(msg);
+    return ret;
+}
+
+
+static void
+testClientClose(virNetClient *client,
+                int serverfd)
+{
+    if (client) {
+        virNetClientClose(client);
+        virObjectUnref(client);
+    }
+    VIR_FORCE_CLOSE(serverfd);
+}
+
+
+/*
+ * The reply to the first call is received while waiting for the second
+ * one. It has to be kept until the first call is waited for, which then
+ * works even with the connection gone.
+ */
+static int
+testReplyBeforeWait(const void *opaque G_GNUC_UNUSED)
+{
+    virNetClient *client = NULL;
+    virNetClientCall *first = NULL;
+    virNetClientCall *second = NULL;
+    int serverfd = -1;
+    int ret = -1;
+
+    if (testClientOpen(&client, &serverfd) < 0 ||
+        !(first = testCallSend(client, 1)) ||
+        !(second = testCallSend(client, 2)))
+        goto cleanup;
+
+    if (testReplySend(serverfd, 1) < 0 ||
+        testReplySend(serverfd, 2) < 0)
+        goto cleanup;
+
+    if (testCallWait(client, g_steal_pointer(&second), 2) < 0)
+        goto cleanup;
+
+    VIR_FORCE_CLOSE(serverfd);
+
+    if (testCallWait(client, g_steal_pointer(&first), 1) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (first)
+        virNetClientCallCancel(client, first);
+    if (second)
+        virNetClientCallCancel(client, second);
+    testClientClose(client, serverfd);
+    return ret;
+}
+
+
+/*
+ * The reply to a cancelled call is consumed and dropped without
+ * disturbing the other calls.
+ */
+static int
+testCancelBeforeReply(const void *opaque G_GNUC_UNUSED)
+{
+    virNetClient *client = NULL;
+    virNetClientCall *first = NULL;
+    virNetClientCall *second = NULL;
+    int serverfd = -1;
+    int ret = -1;
+
+    if (testClientOpen(&client, &serverfd) < 0 ||
+        !(first = testCallSend(client, 1)))
+        goto cleanup;
+
+    virNetClientCallCancel(client, g_steal_pointer(&first));
+
+    if (!(second = testCallSend(client, 2)))
+        goto cleanup;
+
+    if (testReplySend(serverfd, 1) < 0 ||
+        testReplySend(serverfd, 2) < 0)
+        goto cleanup;
+
+    if (testCallWait(client, g_steal_pointer(&second), 2) < 0)
+        goto cleanup;
+
+    /* the connection is still usable */
+    if (!(second = testCallSend(client, 3)) ||
+        testReplySend(serverfd, 3) < 0 ||
+        testCallWait(client, g_steal_pointer(&second), 3) < 0)
+        goto cleanup;
+
+    ret = 0;
+
+ cleanup:
+    if (second)
+        virNetClientCallCancel(client, second);
+    testClientClose(client, serverfd);
+    return ret;
+}
+
+
+/*
+ * Calls pending when the connection is closed are dropped from the
+ * queue, but stay around for their owner to wait for or cancel them.
+ */
+static int
+testCloseWithPending(const void *opaque G_GNUC_UNUSED)
+{
+    virNetClient *client = NULL;
+    virNetClientCall *calls[3] = { NULL };
+    int serverfd = -1;
+    int ret = -1;
+    size_t i;
+
+    if (testClientOpen(&client, &serverfd) < 0)
+        goto cleanup;
+
+    for (i = 0; i < G_N_ELEMENTS(calls); i++) {
+        if (!(calls[i] = testCallSend(client, i + 1)))
+            goto cleanup;
+    }
+
+    VIR_FORCE_CLOSE(serverfd);
+
+    if (virNetClientCallWait(client, g_steal_pointer(&calls[1]))) {
+        VIR_TEST_VERBOSE("got a reply from a closed connection");
+        goto cleanup;
+    }
+
+    if (virNetClientCallWait(client, g_steal_pointer(&calls[0]))) {
+        VIR_TEST_VERBOSE("got a reply to a dropped call");
+        goto cleanup;
+    }
+
+    if (testCallSend(client, 4)) {
+        VIR_TEST_VERBOSE("sent a call over a closed connection");
+        goto cleanup;
+    }
+
+    virResetLastError();
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < G_N_ELEMENTS(calls); i++) {
+        if (calls[i])
+            virNetClientCallCancel(client, calls[i]);
+    }
+    testClientClose(client, serverfd);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    g_autofree char *dir = g_strdup("/tmp/virnetclienttest-XXXXXX");
+    int ret = 0;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!g_mkdtemp(dir)) {
+        fprintf(stderr, "Cannot create temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    sockpath = g_strdup_printf("%s/test.sock", dir);
+
+    if (virTestRun("Reply before wait", testReplyBeforeWait, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Cancel before reply", testCancelBeforeReply, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Close with pending calls", testCloseWithPending, NULL) < 0)
+        ret = -1;
+
+    unlink(sockpath);
+    rmdir(dir);
+    g_free(sockpath);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#endif /* WIN32 */
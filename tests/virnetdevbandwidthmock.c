@@ -19,6 +19,23 @@
 #include <config.h>
 #include <unistd.h>
 #include <sys/types.h>
+#ifdef WITH_NET_IF_H
+# include <net/if.h>
+#endif
+#if WITH_LIBNL
+# include <arpa/inet.h>
+# include <linux/pkt_cls.h>
+# include <linux/pkt_sched.h>
+# include <linux/rtnetlink.h>
+#endif
+
+#include "vircommand.h"
+#include "virerror.h"
+#include "virnetlink.h"
+#include "virovsdb.h"
+#include "virstring.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
 
 uid_t geteuid(void)
 {
@@ -29,3 +46,279 @@ uid_t getuid(void)
 {
     return 0;
 }
+
+/* The kernel rejects every netlink message for "eth1", see
+ * virNetlinkCommandBatch() below. */
+#define MOCK_IFINDEX_REJECT 2
+
+unsigned int if_nametoindex(const char *ifname)
+{
+    if (STREQ(ifname, "eth1"))
+        return MOCK_IFINDEX_REJECT;
+
+    return 1;
+}
+
+
+#if WITH_LIBNL
+
+static void
+mockFormatHandle(virCommand *cmd,
+                 const char *name,
+                 uint32_t handle)
+{
+    if (handle == TC_H_ROOT)
+        virCommandAddArgFormat(cmd, "%s=root", name);
+    else if (handle == TC_H_INGRESS)
+        virCommandAddArgFormat(cmd, "%s=ingress", name);
+    else
+        virCommandAddArgFormat(cmd, "%s=%x:%x", name,
+                               TC_H_MAJ(handle) >> 16, TC_H_MIN(handle));
+}
+
+
+static void
+mockFormatHTB(virCommand *cmd,
+              struct nlattr *options)
+{
+    struct nlattr *tb[TCA_HTB_MAX + 1] = { NULL };
+
+    if (nla_parse_nested(tb, TCA_HTB_MAX, options, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed-htb-options");
+        return;
+    }
+
+    if (tb[TCA_HTB_INIT]) {
+        struct tc_htb_glob *glob = nla_data(tb[TCA_HTB_INIT]);
+
+        virCommandAddArgFormat(cmd, "init=version:%u,r2q:%u,defcls:%x",
+                               glob->version, glob->rate2quantum, glob->defcls);
+    }
+
+    /* buffer sizes and rate tables depend on the packet scheduler
+     * clock of the host, only their presence is checked */
+    if (tb[TCA_HTB_PARMS]) {
+        struct tc_htb_opt *opt = nla_data(tb[TCA_HTB_PARMS]);
+
+        virCommandAddArgFormat(cmd, "parms=rate:%u,ceil:%u,quantum:%u",
+                               opt->rate.rate, opt->ceil.rate, opt->quantum);
+    }
+    if (tb[TCA_HTB_RATE64])
+        virCommandAddArgFormat(cmd, "rate64=%llu",
+                               (unsigned long long) nla_get_u64(tb[TCA_HTB_RATE64]));
+    if (tb[TCA_HTB_CEIL64])
+        virCommandAddArgFormat(cmd, "ceil64=%llu",
+                               (unsigned long long) nla_get_u64(tb[TCA_HTB_CEIL64]));
+    if (tb[TCA_HTB_RTAB])
+        virCommandAddArgFormat(cmd, "rtab=%d", nla_len(tb[TCA_HTB_RTAB]));
+    if (tb[TCA_HTB_CTAB])
+        virCommandAddArgFormat(cmd, "ctab=%d", nla_len(tb[TCA_HTB_CTAB]));
+}
+
+
+static void
+mockFormatSFQ(virCommand *cmd,
+              struct nlattr *options)
+{
+    struct tc_sfq_qopt *opt = nla_data(options);
+
+    if (nla_len(options) < (int) sizeof(*opt)) {
+        virCommandAddArg(cmd, "malformed-sfq-options");
+        return;
+    }
+
+    virCommandAddArgFormat(cmd, "perturb=%d", opt->perturb_period);
+}
+
+
+static void
+mockFormatFw(virCommand *cmd,
+             struct nlattr *options)
+{
+    struct nlattr *tb[TCA_FW_MAX + 1] = { NULL };
+
+    if (nla_parse_nested(tb, TCA_FW_MAX, options, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed-fw-options");
+        return;
+    }
+
+    if (tb[TCA_FW_CLASSID])
+        mockFormatHandle(cmd, "classid", nla_get_u32(tb[TCA_FW_CLASSID]));
+}
+
+
+static void
+mockFormatPolice(virCommand *cmd,
+                 struct nlattr *options)
+{
+    struct nlattr *tb[TCA_POLICE_MAX + 1] = { NULL };
+
+    if (nla_parse_nested(tb, TCA_POLICE_MAX, options, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed-police-options");
+        return;
+    }
+
+    /* like with HTB, the burst and the rate table depend on the
+     * packet scheduler clock */
+    if (tb[TCA_POLICE_TBF]) {
+        struct tc_police *police = nla_data(tb[TCA_POLICE_TBF]);
+
+        virCommandAddArgFormat(cmd, "police=action:%d,rate:%u,mtu:%u",
+                               police->action, police->rate.rate, police->mtu);
+    }
+    if (tb[TCA_POLICE_RATE64])
+        virCommandAddArgFormat(cmd, "rate64=%llu",
+                               (unsigned long long) nla_get_u64(tb[TCA_POLICE_RATE64]));
+    if (tb[TCA_POLICE_RATE])
+        virCommandAddArgFormat(cmd, "rtab=%d", nla_len(tb[TCA_POLICE_RATE]));
+}
+
+
+static void
+mockFormatU32(virCommand *cmd,
+              struct nlattr *options)
+{
+    struct nlattr *tb[TCA_U32_MAX + 1] = { NULL };
+
+    if (nla_parse_nested(tb, TCA_U32_MAX, options, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed-u32-options");
+        return;
+    }
+
+    if (tb[TCA_U32_CLASSID])
+        mockFormatHandle(cmd, "classid", nla_get_u32(tb[TCA_U32_CLASSID]));
+
+    if (tb[TCA_U32_SEL]) {
+        struct tc_u32_sel *sel = nla_data(tb[TCA_U32_SEL]);
+        size_t i;
+
+        virCommandAddArgFormat(cmd, "sel=flags:%x", sel->flags);
+        for (i = 0; i < sel->nkeys; i++) {
+            virCommandAddArgFormat(cmd, "key=%08x/%08x@%d",
+                                   ntohl(sel->keys[i].val),
+                                   ntohl(sel->keys[i].mask),
+                                   sel->keys[i].off);
+        }
+    }
+
+    if (tb[TCA_U32_POLICE])
+        mockFormatPolice(cmd, tb[TCA_U32_POLICE]);
+}
+
+
+/*
+ * Each message is turned into a "netlink" command line and run, so
+ * that it shows up in the dry run output of the test, in order with
+ * the tc commands.
+ */
+static void
+mockFormatMessage(struct nl_msg *msg)
+{
+    struct nlmsghdr *hdr = nlmsg_hdr(msg);
+    struct tcmsg *tcm = nlmsg_data(hdr);
+    struct nlattr *tb[TCA_MAX + 1] = { NULL };
+    g_autoptr(virCommand) cmd = virCommandNew("netlink");
+    const char *kind = NULL;
+
+    switch (hdr->nlmsg_type) {
+    case RTM_NEWQDISC:
+        virCommandAddArgList(cmd, "qdisc", "new", NULL);
+        break;
+    case RTM_DELQDISC:
+        virCommandAddArgList(cmd, "qdisc", "del", NULL);
+        break;
+    case RTM_NEWTCLASS:
+        virCommandAddArgList(cmd, "class", "new", NULL);
+        break;
+    case RTM_DELTCLASS:
+        virCommandAddArgList(cmd, "class", "del", NULL);
+        break;
+    case RTM_NEWTFILTER:
+        virCommandAddArgList(cmd, "filter", "new", NULL);
+        break;
+    case RTM_DELTFILTER:
+        virCommandAddArgList(cmd, "filter", "del", NULL);
+        break;
+    default:
+        virCommandAddArgFormat(cmd, "type=%u", hdr->nlmsg_type);
+        break;
+    }
+
+    if (hdr->nlmsg_flags & NLM_F_CREATE)
+        virCommandAddArg(cmd, "create");
+    if (hdr->nlmsg_flags & NLM_F_EXCL)
+        virCommandAddArg(cmd, "excl");
+
+    virCommandAddArgFormat(cmd, "ifindex=%d", tcm->tcm_ifindex);
+    mockFormatHandle(cmd, "parent", tcm->tcm_parent);
+    mockFormatHandle(cmd, "handle", tcm->tcm_handle);
+
+    if (hdr->nlmsg_type == RTM_NEWTFILTER || hdr->nlmsg_type == RTM_DELTFILTER)
+        virCommandAddArgFormat(cmd, "prio=%u,protocol=%04x",
+                               TC_H_MAJ(tcm->tcm_info) >> 16,
+                               ntohs(TC_H_MIN(tcm->tcm_info)));
+
+    if (nlmsg_parse(hdr, sizeof(*tcm), tb, TCA_MAX, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed");
+    } else {
+        if (tb[TCA_KIND]) {
+            kind = nla_get_string(tb[TCA_KIND]);
+            virCommandAddArgFormat(cmd, "kind=%s", kind);
+        }
+
+        if (tb[TCA_OPTIONS]) {
+            if (STREQ_NULLABLE(kind, "htb"))
+                mockFormatHTB(cmd, tb[TCA_OPTIONS]);
+            else if (STREQ_NULLABLE(kind, "sfq"))
+                mockFormatSFQ(cmd, tb[TCA_OPTIONS]);
+            else if (STREQ_NULLABLE(kind, "fw"))
+                mockFormatFw(cmd, tb[TCA_OPTIONS]);
+            else if (STREQ_NULLABLE(kind, "u32"))
+                mockFormatU32(cmd, tb[TCA_OPTIONS]);
+            else
+                virCommandAddArg(cmd, "options");
+        }
+    }
+
+    ignore_value(virCommandRun(cmd, NULL));
+}
+
+
+int virNetlinkCommandBatch(struct nl_msg **msgs,
+                           size_t nmsgs,
+                           const bool *ignore G_GNUC_UNUSED,
+                           unsigned int protocol G_GNUC_UNUSED,
+                           int *errors)
+{
+    bool reject = false;
+    size_t i;
+
+    for (i = 0; i < nmsgs; i++) {
+        struct tcmsg *tcm = nlmsg_data(nlmsg_hdr(msgs[i]));
+
+        mockFormatMessage(msgs[i]);
+
+        if (tcm->tcm_ifindex == MOCK_IFINDEX_REJECT)
+            reject = true;
+
+        if (errors)
+            errors[i] = reject ? -EOPNOTSUPP : 0;
+    }
+
+    if (reject) {
+        virReportSystemError(EOPNOTSUPP, "%s", "netlink message rejected");
+        return -1;
+    }
+
+    return 0;
+}
+
+#endif /* WITH_LIBNL */
+
+/* Likewise, make virNetDevOpenvswitch*() use ovs-vsctl instead of
+ * talking to a real ovsdb-server. */
+virOVSDBClient *
+virOVSDBGetDefault(void)
+{
+    return NULL;
+}
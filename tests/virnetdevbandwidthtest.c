@@ -27,6 +27,12 @@
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
+/*
+ * With libnl, the mock renders every netlink message as a "netlink"
+ * command line, so they show up in the dry run output. It rejects all
+ * messages for eth1, which makes them fall back to tc.
+ */
+
 struct testSetStruct {
     const char *band;
     const char *exp_cmd_tc;
@@ -69,6 +75,11 @@ testVirNetDevBandwidthSet(const void *data)
     g_autofree char *actual_cmd = NULL;
     g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
 
+#if !WITH_LIBNL
+    if (!info->ovs)
+        return EXIT_AM_SKIP;
+#endif
+
     if (testVirNetDevBandwidthParse(&band, info->band) < 0)
         return -1;
 
@@ -99,6 +110,43 @@ testVirNetDevBandwidthSet(const void *data)
     return 0;
 }
 
+struct testPlugStruct {
+    const char *net_band;
+    const char *band;
+    const char *exp_cmd;
+};
+
+static int
+testVirNetDevBandwidthPlug(const void *data)
+{
+    const struct testPlugStruct *info = data;
+    g_autoptr(virNetDevBandwidth) net_band = NULL;
+    g_autoptr(virNetDevBandwidth) band = NULL;
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autofree char *actual_cmd = NULL;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+    virMacAddr mac;
+
+    if (testVirNetDevBandwidthParse(&net_band, info->net_band) < 0 ||
+        testVirNetDevBandwidthParse(&band, info->band) < 0 ||
+        virMacAddrParse("52:54:00:12:34:56", &mac) < 0)
+        return -1;
+
+    virCommandSetDryRun(dryRunToken, &buf, false, false, NULL, NULL);
+
+    if (band) {
+        if (virNetDevBandwidthPlug("br0", net_band, &mac, band, 3) < 0)
+            return -1;
+    } else {
+        if (virNetDevBandwidthUnplug("br0", 3) < 0)
+            return -1;
+    }
+
+    actual_cmd = virBufferContentAndReset(&buf);
+
+    return virTestCompareToString(info->exp_cmd, actual_cmd);
+}
+
 static int
 mymain(void)
 {
@@ -110,6 +158,27 @@ mymain(void)
     if (virUUIDParse(VMUUID, uuid) < 0)
         return -1;
 
+#define NL_DEL_ROOT(ifindex) \
+    "netlink qdisc del ifindex=" ifindex " parent=root handle=0:0\n"
+#define NL_DEL_INGRESS(ifindex) \
+    "netlink qdisc del ifindex=" ifindex " parent=ingress handle=ffff:0 kind=ingress\n"
+#define NL_HTB(ifindex) \
+    "netlink qdisc new create excl ifindex=" ifindex " parent=root handle=1:0" \
+      " kind=htb init=version:3,r2q:10,defcls:1\n"
+#define NL_INGRESS(ifindex) \
+    "netlink qdisc new create excl ifindex=" ifindex " parent=ingress handle=ffff:0" \
+      " kind=ingress\n"
+#define NL_SFQ(ifindex) \
+    "netlink qdisc new create excl ifindex=" ifindex " parent=1:1 handle=2:0" \
+      " kind=sfq perturb=10\n"
+#define NL_FW(ifindex) \
+    "netlink filter new create excl ifindex=" ifindex " parent=1:0 handle=0:1" \
+      " prio=1,protocol=0003 kind=fw classid=0:1\n"
+#define NL_POLICE(ifindex, police) \
+    "netlink filter new create excl ifindex=" ifindex " parent=ffff:0 handle=0:0" \
+      " prio=0,protocol=0003 kind=u32 classid=0:1 sel=flags:1" \
+      " key=00000000/00000000@0 " police " rtab=1024\n"
+
 #define DO_TEST_SET(Band, Exp_cmd_tc, Exp_cmd_ovs, ...) \
     do { \
         struct testSetStruct data = {.band = Band, \
@@ -138,12 +207,13 @@ mymain(void)
     DO_TEST_SET("<bandwidth>"
                 "  <inbound average='1024'/>"
                 "</bandwidth>",
-                TC " qdisc del dev eth0 root\n"
-                TC " qdisc del dev eth0 ingress\n"
-                TC " qdisc add dev eth0 root handle 1: htb default 1\n"
-                TC " class add dev eth0 parent 1: classid 1:1 htb rate 1024kbps quantum 87\n"
-                TC " qdisc add dev eth0 parent 1:1 handle 2: sfq perturb 10\n"
-                TC " filter add dev eth0 parent 1:0 protocol all prio 1 handle 1 fw flowid 1\n",
+                NL_DEL_ROOT("1")
+                NL_DEL_INGRESS("1")
+                NL_HTB("1")
+                "netlink class new create excl ifindex=1 parent=1:0 handle=1:1 kind=htb"
+                  " parms=rate:1024000,ceil:1024000,quantum:87 rtab=1024 ctab=1024\n"
+                NL_SFQ("1")
+                NL_FW("1"),
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find queue 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find qos 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 set port eth0 qos=@qos1 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"' --"
@@ -155,11 +225,10 @@ mymain(void)
     DO_TEST_SET("<bandwidth>"
                 "  <outbound average='1024'/>"
                 "</bandwidth>",
-                TC " qdisc del dev eth0 root\n"
-                TC " qdisc del dev eth0 ingress\n"
-                TC " qdisc add dev eth0 ingress\n"
-                TC " filter add dev eth0 parent ffff: protocol all u32 match u32 0 0"
-                   " police rate 1024kbps burst 1024kb mtu 64kb drop flowid :1\n",
+                NL_DEL_ROOT("1")
+                NL_DEL_INGRESS("1")
+                NL_INGRESS("1")
+                NL_POLICE("1", "police=action:2,rate:1024000,mtu:65536"),
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find queue 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find qos 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 set Interface eth0 ingress_policing_rate=8192\n");
@@ -168,15 +237,15 @@ mymain(void)
                 "  <inbound average='1' peak='2' floor='3' burst='4'/>"
                 "  <outbound average='5' peak='6' burst='7'/>"
                 "</bandwidth>",
-                TC " qdisc del dev eth0 root\n"
-                TC " qdisc del dev eth0 ingress\n"
-                TC " qdisc add dev eth0 root handle 1: htb default 1\n"
-                TC " class add dev eth0 parent 1: classid 1:1 htb rate 1kbps ceil 2kbps burst 4kb quantum 1\n"
-                TC " qdisc add dev eth0 parent 1:1 handle 2: sfq perturb 10\n"
-                TC " filter add dev eth0 parent 1:0 protocol all prio 1 handle 1 fw flowid 1\n"
-                TC " qdisc add dev eth0 ingress\n"
-                TC " filter add dev eth0 parent ffff: protocol all u32 match u32 0 0"
-                   " police rate 5kbps burst 7kb mtu 64kb drop flowid :1\n",
+                NL_DEL_ROOT("1")
+                NL_DEL_INGRESS("1")
+                NL_HTB("1")
+                "netlink class new create excl ifindex=1 parent=1:0 handle=1:1 kind=htb"
+                  " parms=rate:1000,ceil:2000,quantum:1 rtab=1024 ctab=1024\n"
+                NL_SFQ("1")
+                NL_FW("1")
+                NL_INGRESS("1")
+                NL_POLICE("1", "police=action:2,rate:5000,mtu:65536"),
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find queue 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find qos 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 set port eth0 qos=@qos1 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"' --"
@@ -190,16 +259,17 @@ mymain(void)
                 "  <inbound average='4294967295'/>"
                 "  <outbound average='4294967295'/>"
                 "</bandwidth>",
-                TC " qdisc del dev eth0 root\n"
-                TC " qdisc del dev eth0 ingress\n"
-                TC " qdisc add dev eth0 root handle 1: htb default 1\n"
-                TC " class add dev eth0 parent 1: classid 1:1 htb rate 4294967295kbps quantum 366503875\n"
-                TC " qdisc add dev eth0 parent 1:1 handle 2: sfq perturb 10\n"
-                TC " filter add dev eth0 parent 1:0 protocol all prio 1 handle 1 fw flowid 1\n"
-                TC " qdisc add dev eth0 ingress\n"
-                TC " filter add dev eth0 parent ffff: protocol all u32 match"
-                   " u32 0 0 police rate 4294967295kbps burst 4194303kb mtu 64kb"
-                   " drop flowid :1\n",
+                NL_DEL_ROOT("1")
+                NL_DEL_INGRESS("1")
+                NL_HTB("1")
+                "netlink class new create excl ifindex=1 parent=1:0 handle=1:1 kind=htb"
+                  " parms=rate:4294967295,ceil:4294967295,quantum:366503875"
+                  " rate64=4294967295000 ceil64=4294967295000 rtab=1024 ctab=1024\n"
+                NL_SFQ("1")
+                NL_FW("1")
+                NL_INGRESS("1")
+                NL_POLICE("1", "police=action:2,rate:4294967295,mtu:65536"
+                               " rate64=4294967295000"),
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find queue 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find qos 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 set port eth0 qos=@qos1 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth0\"' --"
@@ -209,6 +279,60 @@ mymain(void)
                             " 'external-ids:ifname=\"eth0\"'\n"
                 OVS_VSCTL " --timeout=5 set Interface eth0 ingress_policing_rate=34359738360\n");
 
+    /* The kernel rejects the messages, the ones whose failure
+     * is not ignored are retried with tc */
+    DO_TEST_SET("<bandwidth>"
+                "  <inbound average='1024'/>"
+                "</bandwidth>",
+                NL_DEL_ROOT("2")
+                NL_DEL_INGRESS("2")
+                NL_HTB("2")
+                "netlink class new create excl ifindex=2 parent=1:0 handle=1:1 kind=htb"
+                  " parms=rate:1024000,ceil:1024000,quantum:87 rtab=1024 ctab=1024\n"
+                NL_SFQ("2")
+                NL_FW("2")
+                TC " qdisc add dev eth1 root handle 1: htb default 1\n"
+                TC " class add dev eth1 parent 1: classid 1:1 htb rate 1024kbps quantum 87\n"
+                TC " qdisc add dev eth1 parent 1:1 handle 2: sfq perturb 10\n"
+                TC " filter add dev eth1 parent 1:0 protocol all prio 1 handle 1 fw flowid 1\n",
+                OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find queue 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth1\"'\n"
+                OVS_VSCTL " --timeout=5 --no-heading --columns=_uuid find qos 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth1\"'\n"
+                OVS_VSCTL " --timeout=5 set port eth1 qos=@qos1 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth1\"' --"
+                          " --id=@qos1 create qos type=linux-htb other_config:min-rate=8192000 queues:0=@queue0 'external-ids:vm-id=\"" VMUUID "\"'"
+                            " 'external-ids:ifname=\"eth1\"' --"
+                          " --id=@queue0 create queue other_config:min-rate=8192000 'external-ids:vm-id=\"" VMUUID "\"' 'external-ids:ifname=\"eth1\"'\n"
+                OVS_VSCTL " --timeout=5 set Interface eth1 ingress_policing_rate=0 ingress_policing_burst=0\n",
+                .iface = "eth1");
+
+#if WITH_LIBNL
+# define DO_TEST_PLUG(Name, Net_band, Band, Exp_cmd) \
+    do { \
+        struct testPlugStruct data = {.net_band = Net_band, \
+                                      .band = Band, \
+                                      .exp_cmd = Exp_cmd}; \
+        if (virTestRun(Name, testVirNetDevBandwidthPlug, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST_PLUG("virNetDevBandwidthPlug",
+                 "<bandwidth><inbound average='1000'/></bandwidth>",
+                 "<bandwidth><inbound average='1000' floor='200'/></bandwidth>",
+                 "netlink class new create excl ifindex=1 parent=1:1 handle=1:3 kind=htb"
+                   " parms=rate:200000,ceil:1000000,quantum:85 rtab=1024 ctab=1024\n"
+                 "netlink qdisc new create excl ifindex=1 parent=1:3 handle=3:0"
+                   " kind=sfq perturb=10\n"
+                 "netlink filter new create excl ifindex=1 parent=0:0 handle=8000:803"
+                   " prio=2,protocol=0800 kind=u32 classid=1:3 sel=flags:1"
+                   " key=00000800/0000ffff@-4 key=00123456/ffffffff@-12"
+                   " key=00005254/0000ffff@-16\n");
+
+    DO_TEST_PLUG("virNetDevBandwidthUnplug", NULL, NULL,
+                 "netlink qdisc del ifindex=1 parent=1:3 handle=3:0\n"
+                 "netlink filter del ifindex=1 parent=0:0 handle=8000:803"
+                   " prio=2,protocol=0000 kind=u32\n"
+                 "netlink class del ifindex=1 parent=0:0 handle=1:3\n");
+#endif /* WITH_LIBNL */
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -0,0 +1,169 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#if WITH_LIBNL
+# include <net/if.h>
+# include <linux/rtnetlink.h>
+#endif
+
+#include "vircommand.h"
+#include "virerror.h"
+#include "virmacaddr.h"
+#include "virnetdev.h"
+#include "virnetdevbridge.h"
+#include "virnetdevtap.h"
+#include "virnetlink.h"
+#include "virstring.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+#define MOCK_BRIDGE_IFINDEX 10
+#define MOCK_BRIDGE_MTU 9000
+
+/*
+ * Every change made to a device is turned into a command line and run,
+ * so that the test can check the steps and their order in the dry run
+ * output.
+ */
+
+int
+virNetDevTapCreate(char **ifname,
+                   const char *tunpath G_GNUC_UNUSED,
+                   int *tapfd G_GNUC_UNUSED,
+                   size_t tapfdSize G_GNUC_UNUSED,
+                   unsigned int flags G_GNUC_UNUSED)
+{
+    if (strstr(*ifname, "%d")) {
+        g_free(*ifname);
+        *ifname = g_strdup("vnet0");
+    }
+
+    return 0;
+}
+
+
+int
+virNetDevGetIndex(const char *ifname,
+                  int *ifindex)
+{
+    if (STRNEQ(ifname, "br0")) {
+        virReportSystemError(ENODEV,
+                             "Unable to get index for interface %s", ifname);
+        return -1;
+    }
+
+    *ifindex = MOCK_BRIDGE_IFINDEX;
+    return 0;
+}
+
+
+int
+virNetDevGetMTU(const char *ifname G_GNUC_UNUSED)
+{
+    return MOCK_BRIDGE_MTU;
+}
+
+
+int
+virNetDevBridgePortSetIsolated(const char *brname,
+                               const char *ifname,
+                               bool enable)
+{
+    g_autoptr(virCommand) cmd = virCommandNew("isolated");
+
+    virCommandAddArgList(cmd, brname, ifname, enable ? "on" : "off", NULL);
+    return virCommandRun(cmd, NULL);
+}
+
+
+int
+virNetDevSetOnline(const char *ifname,
+                   bool online)
+{
+    g_autoptr(virCommand) cmd = virCommandNew("ioctl");
+
+    virCommandAddArgList(cmd, ifname, online ? "up" : "down", NULL);
+    return virCommandRun(cmd, NULL);
+}
+
+
+#if WITH_LIBNL
+
+static void
+mockFormatMessage(struct nl_msg *msg)
+{
+    struct nlmsghdr *hdr = nlmsg_hdr(msg);
+    struct ifinfomsg *ifinfo = nlmsg_data(hdr);
+    struct nlattr *tb[IFLA_MAX + 1] = { NULL };
+    g_autoptr(virCommand) cmd = virCommandNew("netlink");
+
+    if (hdr->nlmsg_type == RTM_SETLINK)
+        virCommandAddArgList(cmd, "link", "set", NULL);
+    else
+        virCommandAddArgFormat(cmd, "type=%u", hdr->nlmsg_type);
+
+    if (nlmsg_parse(hdr, sizeof(*ifinfo), tb, IFLA_MAX, NULL) < 0) {
+        virCommandAddArg(cmd, "malformed");
+        ignore_value(virCommandRun(cmd, NULL));
+        return;
+    }
+
+    if (tb[IFLA_IFNAME])
+        virCommandAddArgFormat(cmd, "ifname=%s", nla_get_string(tb[IFLA_IFNAME]));
+
+    if (tb[IFLA_ADDRESS] && nla_len(tb[IFLA_ADDRESS]) == VIR_MAC_BUFLEN) {
+        char macstr[VIR_MAC_STRING_BUFLEN];
+        virMacAddr mac;
+
+        virMacAddrSetRaw(&mac, nla_data(tb[IFLA_ADDRESS]));
+        virCommandAddArgFormat(cmd, "address=%s", virMacAddrFormat(&mac, macstr));
+    }
+
+    if (tb[IFLA_MTU])
+        virCommandAddArgFormat(cmd, "mtu=%u", nla_get_u32(tb[IFLA_MTU]));
+
+    if (tb[IFLA_MASTER])
+        virCommandAddArgFormat(cmd, "master=%u", nla_get_u32(tb[IFLA_MASTER]));
+
+    if (ifinfo->ifi_change & IFF_UP)
+        virCommandAddArg(cmd, ifinfo->ifi_flags & IFF_UP ? "up" : "down");
+
+    ignore_value(virCommandRun(cmd, NULL));
+}
+
+
+int
+virNetlinkCommandBatch(struct nl_msg **msgs,
+                       size_t nmsgs,
+                       const bool *ignore G_GNUC_UNUSED,
+                       unsigned int protocol G_GNUC_UNUSED,
+                       int *errors)
+{
+    size_t i;
+
+    for (i = 0; i < nmsgs; i++) {
+        mockFormatMessage(msgs[i]);
+
+        if (errors)
+            errors[i] = 0;
+    }
+
+    return 0;
+}
+
+#endif /* WITH_LIBNL */
@@ -0,0 +1,203 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#if WITH_LIBNL
+
+# define LIBVIRT_VIRCOMMANDPRIV_H_ALLOW
+# include "vircommandpriv.h"
+# include "virnetdev.h"
+# include "virnetdevtap.h"
+
+# define VIR_FROM_THIS VIR_FROM_NONE
+
+/*
+ * The mock renders every netlink message as a "netlink" command line
+ * and the ioctl and sysfs based helpers the batch has to be followed
+ * by as commands of their own, so that the dry run output shows all
+ * the steps of setting up a device in order. The bridge "br0" has
+ * ifindex 10 and an MTU of 9000.
+ */
+
+static int
+testLinkBatch(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virNetDevLinkBatch) batch = virNetDevLinkBatchNew();
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autofree char *actual = NULL;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+    virNetDevLinkBatchStats before;
+    virNetDevLinkBatchStats after;
+    const char *expected =
+        "netlink link set ifname=eth0 mtu=1400\n"
+        "netlink link set ifname=eth0 master=10\n"
+        "netlink link set ifname=eth0 down\n";
+
+    virCommandSetDryRun(dryRunToken, &buf, false, false, NULL, NULL);
+    virNetDevLinkBatchGetStats(&before);
+
+    /* an empty batch is not sent at all */
+    if (virNetDevLinkBatchRun(batch) < 0)
+        return -1;
+
+    if (virNetDevLinkBatchSetMTU(batch, "eth0", 1400) < 0 ||
+        virNetDevLinkBatchSetMaster(batch, "eth0", "br0") < 0 ||
+        virNetDevLinkBatchSetOnline(batch, "eth0", false) < 0)
+        return -1;
+
+    /* a master which doesn't exist fails right away */
+    if (virNetDevLinkBatchSetMaster(batch, "eth0", "br1") == 0) {
+        VIR_TEST_VERBOSE("queued a missing master device");
+        return -1;
+    }
+    virResetLastError();
+
+    if (virNetDevLinkBatchRun(batch) < 0)
+        return -1;
+
+    actual = virBufferContentAndReset(&buf);
+    if (virTestCompareToString(expected, actual) < 0)
+        return -1;
+
+    /* only the batch which was sent is accounted for */
+    virNetDevLinkBatchGetStats(&after);
+    if (after.batches - before.batches != 1 ||
+        after.messages - before.messages != 3 ||
+        after.failed != before.failed ||
+        after.maxUs < before.maxUs ||
+        after.totalUs < before.totalUs) {
+        VIR_TEST_VERBOSE("unexpected statistics: batches=%llu messages=%llu failed=%llu",
+                         after.batches - before.batches,
+                         after.messages - before.messages,
+                         after.failed - before.failed);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+struct testTapData {
+    virTristateBool isolated;
+    unsigned int mtu;
+    unsigned int flags;
+    unsigned int expectMTU;
+    const char *expected;
+};
+
+
+static int
+testTapCreateInBridgePort(const void *opaque)
+{
+    const struct testTapData *data = opaque;
+    g_autofree char *ifname = g_strdup("vnet%d");
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autofree char *actual = NULL;
+    g_autoptr(virCommandDryRunToken) dryRunToken = virCommandDryRunTokenNew();
+    unsigned int actualMTU = 0;
+    virMacAddr mac;
+
+    if (virMacAddrParse("52:54:00:12:34:56", &mac) < 0)
+        return -1;
+
+    virCommandSetDryRun(dryRunToken, &buf, false, false, NULL, NULL);
+
+    if (virNetDevTapCreateInBridgePort("br0", &ifname, &mac, NULL, NULL,
+                                       NULL, 0, NULL, NULL, data->isolated,
+                                       NULL, data->mtu, &actualMTU,
+                                       data->flags) < 0)
+        return -1;
+
+    if (actualMTU != data->expectMTU) {
+        VIR_TEST_VERBOSE("MTU is %u, expected %u", actualMTU, data->expectMTU);
+        return -1;
+    }
+
+    actual = virBufferContentAndReset(&buf);
+    return virTestCompareToString(data->expected, actual);
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+# define DO_TEST_TAP(name, isolated, mtu, flags, expectMTU, expected) \
+    do { \
+        struct testTapData data = { isolated, mtu, flags, expectMTU, expected }; \
+        if (virTestRun("tap " name, testTapCreateInBridgePort, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    if (virTestRun("link batch", testLinkBatch, NULL) < 0)
+        ret = -1;
+
+    /* the MAC address has to be set before joining the bridge */
+    DO_TEST_TAP("up", VIR_TRISTATE_BOOL_ABSENT, 1500,
+                VIR_NETDEV_TAP_CREATE_IFUP, 1500,
+                "netlink link set ifname=vnet0 address=fe:54:00:12:34:56\n"
+                "netlink link set ifname=vnet0 mtu=1500\n"
+                "netlink link set ifname=vnet0 master=10\n"
+                "netlink link set ifname=vnet0 up\n");
+
+    DO_TEST_TAP("down", VIR_TRISTATE_BOOL_NO, 1500, 0, 1500,
+                "netlink link set ifname=vnet0 address=fe:54:00:12:34:56\n"
+                "netlink link set ifname=vnet0 mtu=1500\n"
+                "netlink link set ifname=vnet0 master=10\n"
+                "netlink link set ifname=vnet0 down\n");
+
+    DO_TEST_TAP("bridge MTU", VIR_TRISTATE_BOOL_ABSENT, 0,
+                VIR_NETDEV_TAP_CREATE_IFUP, 9000,
+                "netlink link set ifname=vnet0 address=fe:54:00:12:34:56\n"
+                "netlink link set ifname=vnet0 mtu=9000\n"
+                "netlink link set ifname=vnet0 master=10\n"
+                "netlink link set ifname=vnet0 up\n");
+
+    /* an isolated port must not come up before it's isolated */
+    DO_TEST_TAP("isolated", VIR_TRISTATE_BOOL_YES, 1500,
+                VIR_NETDEV_TAP_CREATE_IFUP, 1500,
+                "netlink link set ifname=vnet0 address=fe:54:00:12:34:56\n"
+                "netlink link set ifname=vnet0 mtu=1500\n"
+                "netlink link set ifname=vnet0 master=10\n"
+                "isolated br0 vnet0 on\n"
+                "ioctl vnet0 up\n");
+
+    DO_TEST_TAP("use MAC for bridge", VIR_TRISTATE_BOOL_ABSENT, 1500,
+                VIR_NETDEV_TAP_CREATE_IFUP |
+                VIR_NETDEV_TAP_CREATE_USE_MAC_FOR_BRIDGE, 1500,
+                "netlink link set ifname=vnet0 address=52:54:00:12:34:56\n"
+                "netlink link set ifname=vnet0 mtu=1500\n"
+                "netlink link set ifname=vnet0 master=10\n"
+                "netlink link set ifname=vnet0 up\n");
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN_PRELOAD(mymain, VIR_TEST_MOCK("virnetdevtap"))
+
+#else /* !WITH_LIBNL */
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* !WITH_LIBNL */
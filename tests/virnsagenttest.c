@@ -0,0 +1,229 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "internal.h"
+#include "testutils.h"
+#include "virfile.h"
+
+#define LIBVIRT_VIRNSAGENTPRIV_H_ALLOW
+#include "virnsagentpriv.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+/*
+ * The agent is started for the mount namespace of the test itself, which
+ * it doesn't have to enter. Without privileges only symlinks can be
+ * created, device nodes need CAP_MKNOD and the bind mounts of regular
+ * files and directories can't be moved.
+ */
+
+static char *testdir;
+
+
+static int
+testAgentMknodSymlink(virNSAgent *agent,
+                      const char *file,
+                      mode_t mode)
+{
+    g_autoptr(virJSONValue) item = NULL;
+    g_autoptr(virJSONValue) items = virJSONValueNewArray();
+    g_autoptr(virJSONValue) args = NULL;
+
+    if (virJSONValueObjectAdd(&item,
+                              "s:file", file,
+                              "s:target", "target",
+                              "u:mode", (unsigned int) mode,
+                              "U:rdev", 0ULL,
+                              "u:uid", (unsigned int) getuid(),
+                              "u:gid", (unsigned int) getgid(),
+                              NULL) < 0 ||
+        virJSONValueArrayAppend(items, &item) < 0 ||
+        virJSONValueObjectAdd(&args, "a:items", &items, NULL) < 0)
+        return -1;
+
+    return virNSAgentRun(agent, "mknod", &args);
+}
+
+
+static int
+testAgentUnlink(virNSAgent *agent,
+                const char *path)
+{
+    g_autoptr(virJSONValue) paths = virJSONValueNewArray();
+    g_autoptr(virJSONValue) args = NULL;
+
+    if (virJSONValueArrayAppendString(paths, path) < 0 ||
+        virJSONValueObjectAdd(&args, "a:paths", &paths, NULL) < 0)
+        return -1;
+
+    return virNSAgentRun(agent, "unlink", &args);
+}
+
+
+static int
+testMknodUnlink(const void *opaque)
+{
+    virNSAgent *agent = (virNSAgent *) opaque;
+    g_autofree char *file = g_build_filename(testdir, "dev", "link", NULL);
+    g_autofree char *target = NULL;
+    int rc;
+
+    if ((rc = testAgentMknodSymlink(agent, file, S_IFLNK | 0777)) != 0) {
+        VIR_TEST_VERBOSE("creating '%s' returned %d", file, rc);
+        return -1;
+    }
+
+    if (!(target = g_file_read_link(file, NULL)) ||
+        STRNEQ(target, "target")) {
+        VIR_TEST_VERBOSE("'%s' points to '%s'", file, NULLSTR(target));
+        return -1;
+    }
+
+    /* the caller is told that the file existed already */
+    if ((rc = testAgentMknodSymlink(agent, file, S_IFLNK | 0777)) != 1) {
+        VIR_TEST_VERBOSE("creating '%s' again returned %d", file, rc);
+        return -1;
+    }
+
+    if (testAgentUnlink(agent, file) < 0)
+        return -1;
+
+    if (virFileIsLink(file) || virFileExists(file)) {
+        VIR_TEST_VERBOSE("'%s' was not removed", file);
+        return -1;
+    }
+
+    /* paths which don't exist are fine */
+    return testAgentUnlink(agent, file);
+}
+
+
+static int
+testErrors(const void *opaque)
+{
+    virNSAgent *agent = (virNSAgent *) opaque;
+    g_autofree char *file = g_build_filename(testdir, "dev", "unknown", NULL);
+    g_autoptr(virJSONValue) args = NULL;
+
+    if (testAgentMknodSymlink(agent, file, 0) == 0) {
+        VIR_TEST_VERBOSE("created a file of unknown type");
+        return -1;
+    }
+
+    /* the error is passed from the agent */
+    if (virGetLastErrorCode() != VIR_ERR_OPERATION_UNSUPPORTED) {
+        VIR_TEST_VERBOSE("unexpected error: %s", virGetLastErrorMessage());
+        return -1;
+    }
+    virResetLastError();
+
+    if (virNSAgentRun(agent, "mkfifo", &args) == 0) {
+        VIR_TEST_VERBOSE("ran an unknown command");
+        return -1;
+    }
+    virResetLastError();
+
+    /* failed commands leave the agent usable */
+    if (virNSAgentIsBroken(agent)) {
+        VIR_TEST_VERBOSE("agent is broken after a failed command");
+        return -1;
+    }
+
+    return testAgentUnlink(agent, file);
+}
+
+
+static int
+testTimeout(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virNSAgent) agent = NULL;
+    g_autofree char *file = g_build_filename(testdir, "dev", "stopped", NULL);
+
+    if (!(agent = virNSAgentNew(getpid())))
+        return -1;
+
+    virNSAgentSetTimeout(agent, 100);
+
+    if (kill(virNSAgentGetPid(agent), SIGSTOP) < 0) {
+        VIR_TEST_VERBOSE("cannot stop the agent: %s", g_strerror(errno));
+        return -1;
+    }
+
+    if (testAgentUnlink(agent, file) == 0) {
+        VIR_TEST_VERBOSE("stopped agent replied");
+        return -1;
+    }
+
+    if (virGetLastErrorCode() != VIR_ERR_OPERATION_TIMEOUT) {
+        VIR_TEST_VERBOSE("unexpected error: %s", virGetLastErrorMessage());
+        return -1;
+    }
+    virResetLastError();
+
+    if (!virNSAgentIsBroken(agent)) {
+        VIR_TEST_VERBOSE("agent is usable after a timeout");
+        return -1;
+    }
+
+    /* freeing the agent kills it */
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    g_autofree char *dir = g_strdup("/tmp/virnsagenttest-XXXXXX");
+    g_autoptr(virNSAgent) agent = NULL;
+    int ret = 0;
+
+    if (!g_mkdtemp(dir)) {
+        fprintf(stderr, "Cannot create temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    testdir = dir;
+
+    if (!(agent = virNSAgentNew(getpid()))) {
+        fprintf(stderr, "Cannot start the agent: %s\n",
+                virGetLastErrorMessage());
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (virTestRun("mknod and unlink", testMknodUnlink, agent) < 0)
+        ret = -1;
+
+    if (virTestRun("errors", testErrors, agent) < 0)
+        ret = -1;
+
+    if (virTestRun("timeout", testTimeout, NULL) < 0)
+        ret = -1;
+
+ cleanup:
+    if (getenv("LIBVIRT_SKIP_CLEANUP") == NULL)
+        virFileDeleteTree(dir);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -19,6 +19,7 @@
 #include <config.h>
 
 #include "internal.h"
+#include "viralloc.h"
 #include "virnuma.h"
 #include "virfile.h"
 #include "virstring.h"
@@ -151,6 +152,95 @@ virNumaGetPages(int node,
     return 0;
 }
 
+/*
+ * Huge pages added to the pools by virNumaSetPagePoolSize(), on top of the
+ * ones the pools have in sysfs, so that tests can watch a pool grow.
+ */
+typedef struct {
+    int node;
+    unsigned int page_size;
+    long long added;
+} virNumaMockPool;
+
+static virNumaMockPool *pools;
+static size_t npools;
+
+static virNumaMockPool *
+virNumaMockGetPool(int node,
+                   unsigned int page_size)
+{
+    virNumaMockPool pool = { .node = node, .page_size = page_size };
+    size_t i;
+
+    for (i = 0; i < npools; i++) {
+        if (pools[i].node == node && pools[i].page_size == page_size)
+            return &pools[i];
+    }
+
+    VIR_APPEND_ELEMENT(pools, npools, pool);
+    return &pools[npools - 1];
+}
+
+static int
+virNumaMockReadPool(int node,
+                    unsigned int page_size,
+                    unsigned long long *nr,
+                    unsigned long long *nfree)
+{
+    const char *fmt = "%s/node/node%d/hugepages/hugepages-%ukB/%s";
+
+    if (virFileReadValueUllong(nr, fmt, SYSFS_SYSTEM_PATH, node,
+                               page_size, "nr_hugepages") < 0 ||
+        virFileReadValueUllong(nfree, fmt, SYSFS_SYSTEM_PATH, node,
+                               page_size, "free_hugepages") < 0)
+        return -1;
+
+    return 0;
+}
+
+int
+virNumaGetPageInfo(int node,
+                   unsigned int page_size,
+                   unsigned long long huge_page_sum G_GNUC_UNUSED,
+                   unsigned long long *page_avail,
+                   unsigned long long *page_free)
+{
+    virNumaMockPool *pool = virNumaMockGetPool(node, page_size);
+    unsigned long long nr;
+    unsigned long long nfree;
+
+    if (virNumaMockReadPool(node, page_size, &nr, &nfree) < 0)
+        return -1;
+
+    if (page_avail)
+        *page_avail = nr + pool->added;
+    if (page_free)
+        *page_free = nfree + pool->added;
+
+    return 0;
+}
+
+int
+virNumaSetPagePoolSize(int node,
+                       unsigned int page_size,
+                       unsigned long long page_count,
+                       bool add)
+{
+    virNumaMockPool *pool = virNumaMockGetPool(node, page_size);
+    unsigned long long nr;
+    unsigned long long nfree;
+
+    if (virNumaMockReadPool(node, page_size, &nr, &nfree) < 0)
+        return -1;
+
+    if (add)
+        pool->added += page_count;
+    else
+        pool->added = (long long) page_count - nr;
+
+    return 0;
+}
+
 int
 virNumaGetNodeCPUs(int node, virBitmap **cpus)
 {
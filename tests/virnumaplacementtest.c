@@ -0,0 +1,249 @@
+/*
+ * virnumaplacementtest.c: Test the built-in NUMA placement engine
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "capabilities.h"
+#include "virnuma.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+#define MAX_NODES 8
+#define GiB (1024ULL * 1024)
+
+typedef struct {
+    size_t nnodes;
+    unsigned int cpus[MAX_NODES];
+    unsigned int distances[MAX_NODES][MAX_NODES];
+    unsigned long long memFree[MAX_NODES]; /* GiB */
+    unsigned int load[MAX_NODES];
+
+    unsigned int vcpus;
+    unsigned long long memory; /* GiB */
+
+    const char *expected;
+} testNUMAPlacementData;
+
+
+static virCapsHostNUMA *
+testBuildTopology(const testNUMAPlacementData *data)
+{
+    g_autoptr(virCapsHostNUMA) caps = virCapabilitiesHostNUMANew();
+    unsigned int id = 0;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < data->nnodes; i++) {
+        virCapsHostNUMACellCPU *cpus = g_new0(virCapsHostNUMACellCPU, data->cpus[i]);
+        virNumaDistance *distances = g_new0(virNumaDistance, data->nnodes);
+
+        for (j = 0; j < data->cpus[i]; j++) {
+            cpus[j].id = id++;
+            cpus[j].socket_id = i;
+            cpus[j].core_id = j;
+        }
+
+        for (j = 0; j < data->nnodes; j++) {
+            distances[j].cellid = j;
+            distances[j].value = data->distances[i][j];
+        }
+
+        virCapabilitiesHostNUMAAddCell(caps, i, data->memFree[i] * GiB,
+                                       data->cpus[i], &cpus,
+                                       data->nnodes, &distances,
+                                       0, NULL, NULL);
+    }
+
+    return g_steal_pointer(&caps);
+}
+
+
+static int
+testNUMAPlacement(const void *opaque)
+{
+    const testNUMAPlacementData *data = opaque;
+    g_autoptr(virCapsHostNUMA) caps = testBuildTopology(data);
+    g_autofree virCapsHostNUMANodeStatus *status = NULL;
+    g_autoptr(virBitmap) nodeset = NULL;
+    g_autofree char *actual = NULL;
+    size_t i;
+
+    status = g_new0(virCapsHostNUMANodeStatus, data->nnodes);
+    for (i = 0; i < data->nnodes; i++) {
+        status[i].memFree = data->memFree[i] * GiB;
+        status[i].vcpus = data->load[i];
+    }
+
+    if (!(nodeset = virCapabilitiesHostNUMAPlace(caps, status, data->nnodes,
+                                                 data->vcpus,
+                                                 data->memory * GiB)))
+        return -1;
+
+    actual = virBitmapFormat(nodeset);
+
+    if (STRNEQ(actual, data->expected)) {
+        VIR_TEST_DEBUG("Expected nodeset '%s', got '%s'",
+                       data->expected, actual);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static const char *testNumaMaps =
+    "55d3c8a00000 default file=/usr/bin/qemu-system-x86_64 mapped=512 N0=512 kernelpagesize_kB=4\n"
+    "7f2a40000000 default anon=262144 dirty=262144 active=0 N0=131072 N1=131072 kernelpagesize_kB=4\n"
+    "7f2b00000000 bind:1 file=/dev/hugepages/libvirt/qemu/1-guest huge dirty=4 N1=3 N3=1 kernelpagesize_kB=2048\n"
+    "7f2c00000000 default stack:1234 anon=8 dirty=8 N1=8 kernelpagesize_kB=4\n"
+    "7ffd4e5fe000 default\n";
+
+
+static int
+testNumaMapsParse(const void *opaque G_GNUC_UNUSED)
+{
+    g_autofree unsigned long long *memory = NULL;
+    size_t nmemory = 0;
+    const unsigned long long expected[] = { 526336, 530464, 0, 2048 };
+    size_t i;
+
+    if (virNumaParseNumaMaps(testNumaMaps, &memory, &nmemory) < 0)
+        return -1;
+
+    if (nmemory != G_N_ELEMENTS(expected)) {
+        VIR_TEST_DEBUG("Expected %zu nodes, got %zu",
+                       G_N_ELEMENTS(expected), nmemory);
+        return -1;
+    }
+
+    for (i = 0; i < nmemory; i++) {
+        if (memory[i] != expected[i]) {
+            VIR_TEST_DEBUG("Expected %llu KiB on node %zu, got %llu KiB",
+                           expected[i], i, memory[i]);
+            return -1;
+        }
+    }
+
+    g_clear_pointer(&memory, g_free);
+
+    if (virNumaParseNumaMaps("7f2a40000000 default N0=abc kernelpagesize_kB=4",
+                             &memory, &nmemory) == 0) {
+        VIR_TEST_DEBUG("Parsing malformed numa_maps succeeded");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+#define TWO_NODES \
+    .nnodes = 2, \
+    .cpus = { 8, 8 }, \
+    .distances = { { 10, 21 }, \
+                   { 21, 10 } }
+
+#define TWO_SOCKETS \
+    .nnodes = 4, \
+    .cpus = { 8, 8, 8, 8 }, \
+    .distances = { { 10, 12, 32, 32 }, \
+                   { 12, 10, 32, 32 }, \
+                   { 32, 32, 10, 12 }, \
+                   { 32, 32, 12, 10 } }
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+#define DO_TEST(name, ...) \
+    do { \
+        testNUMAPlacementData data = { __VA_ARGS__ }; \
+        if (virTestRun("NUMA placement " name, \
+                       testNUMAPlacement, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST("least loaded node",
+            TWO_NODES,
+            .memFree = { 16, 16 }, .load = { 8, 0 },
+            .vcpus = 4, .memory = 4, .expected = "1");
+
+    DO_TEST("most free memory",
+            TWO_NODES,
+            .memFree = { 8, 12 },
+            .vcpus = 4, .memory = 4, .expected = "1");
+
+    DO_TEST("memory spans nodes",
+            TWO_NODES,
+            .memFree = { 16, 16 },
+            .vcpus = 4, .memory = 20, .expected = "0-1");
+
+    DO_TEST("vCPUs span nodes",
+            TWO_NODES,
+            .memFree = { 16, 16 },
+            .vcpus = 12, .memory = 4, .expected = "0-1");
+
+    DO_TEST("vCPU overcommit",
+            TWO_NODES,
+            .memFree = { 16, 16 },
+            .vcpus = 24, .memory = 4, .expected = "0");
+
+    DO_TEST("not enough memory",
+            TWO_NODES,
+            .memFree = { 4, 4 },
+            .vcpus = 4, .memory = 16, .expected = "0-1");
+
+    DO_TEST("stay within socket",
+            TWO_SOCKETS,
+            .memFree = { 4, 4, 3, 3 },
+            .vcpus = 4, .memory = 6, .expected = "0-1");
+
+    DO_TEST("stay within less loaded socket",
+            TWO_SOCKETS,
+            .memFree = { 4, 4, 3, 3 }, .load = { 16, 0, 0, 0 },
+            .vcpus = 4, .memory = 6, .expected = "2-3");
+
+    DO_TEST("single node preferred over socket",
+            TWO_SOCKETS,
+            .memFree = { 4, 4, 3, 8 }, .load = { 0, 0, 0, 24 },
+            .vcpus = 4, .memory = 6, .expected = "3");
+
+    DO_TEST("cross socket",
+            TWO_SOCKETS,
+            .memFree = { 8, 8, 8, 8 },
+            .vcpus = 4, .memory = 20, .expected = "0-2");
+
+    DO_TEST("memoryless node",
+            .nnodes = 3,
+            .cpus = { 8, 8, 8 },
+            .distances = { { 10, 21, 11 },
+                           { 21, 10, 21 },
+                           { 11, 21, 10 } },
+            .memFree = { 16, 16, 0 }, .load = { 0, 8, 0 },
+            .vcpus = 12, .memory = 4, .expected = "0,2");
+
+    if (virTestRun("numa_maps parsing", testNumaMapsParse, NULL) < 0)
+        ret = -1;
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
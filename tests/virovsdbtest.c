@@ -0,0 +1,837 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <unistd.h>
+#ifndef WIN32
+# include <poll.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
+
+#include "testutils.h"
+
+#ifdef WIN32
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#else
+
+# include "virovsdb.h"
+# include "virnetdevopenvswitch.h"
+# include "virbuffer.h"
+# include "virfile.h"
+# include "virthread.h"
+# include "viruuid.h"
+
+# define VIR_FROM_THIS VIR_FROM_NONE
+
+# define TEST_MAX_CONNS 8
+
+/* What every transaction submitted with VIR_OVSDB_TRANSACT_WAIT ends with */
+# define WAIT_OPS \
+    "{\"op\":\"mutate\",\"table\":\"Open_vSwitch\",\"where\":[]," \
+    "\"mutations\":[[\"next_cfg\",\"+=\",1]]}," \
+    "{\"op\":\"select\",\"table\":\"Open_vSwitch\",\"where\":[]," \
+    "\"columns\":[\"next_cfg\"]}"
+
+/*
+ * A minimal ovsdb-server stand-in. It knows a single bridge "br0" and
+ * keeps track of the ports added to or removed from it. Inserting an
+ * interface called "fail0" makes the transaction fail.
+ */
+typedef struct _testServer testServer;
+struct _testServer {
+    virMutex lock;
+    int listenfd;
+    int fds[TEST_MAX_CONNS];
+    GString *bufs[TEST_MAX_CONNS];
+
+    GHashTable *ports; /* port name -> NULL */
+    long long cfg;
+    bool echoed;
+    unsigned int ntransact;
+    char *last; /* params of the last transaction */
+};
+
+static testServer server;
+static char *sockpath;
+
+
+static int
+testServerSend(int fd,
+               const char *str)
+{
+    if (safewrite(fd, str, strlen(str)) < 0)
+        return -1;
+    return 0;
+}
+
+
+static void
+testServerFormatPort(virBuffer *buf,
+                     const char *name,
+                     bool deleted)
+{
+    virBufferAsprintf(buf, "\"Port-%s\":{\"%s\":{\"name\":\"%s\","
+                      "\"interfaces\":[\"uuid\",\"Interface-%s\"]}},",
+                      name, deleted ? "old" : "new", name, name);
+}
+
+
+static void
+testServerFormatBridge(virBuffer *buf)
+{
+    GHashTableIter iter;
+    const char *name;
+
+    virBufferAddLit(buf, "\"Bridge\":{\"Bridge-br0\":{\"new\":{\"name\":\"br0\","
+                    "\"ports\":[\"set\",[");
+
+    g_hash_table_iter_init(&iter, server.ports);
+    while (g_hash_table_iter_next(&iter, (void **) &name, NULL))
+        virBufferAsprintf(buf, "[\"uuid\",\"Port-%s\"],", name);
+    virBufferTrim(buf, ",");
+
+    virBufferAddLit(buf, "]]}}},");
+}
+
+
+/* Formats the contents of all monitored tables, or just the changes of
+ * a transaction if @added or @removed are given. */
+static char *
+testServerFormatUpdates(const char *added,
+                        const char *removed)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    GHashTableIter iter;
+    const char *name;
+
+    virBufferAddLit(&buf, "{");
+    testServerFormatBridge(&buf);
+
+    virBufferAddLit(&buf, "\"Port\":{");
+    if (added) {
+        testServerFormatPort(&buf, added, false);
+    } else if (removed) {
+        testServerFormatPort(&buf, removed, true);
+    } else {
+        g_hash_table_iter_init(&iter, server.ports);
+        while (g_hash_table_iter_next(&iter, (void **) &name, NULL))
+            testServerFormatPort(&buf, name, false);
+    }
+    virBufferTrim(&buf, ",");
+    virBufferAddLit(&buf, "},");
+
+    virBufferAddLit(&buf, "\"Interface\":{");
+    if (added) {
+        virBufferAsprintf(&buf, "\"Interface-%s\":{\"new\":{\"name\":\"%s\"}}",
+                          added, added);
+    } else if (removed) {
+        virBufferAsprintf(&buf, "\"Interface-%s\":{\"old\":{\"name\":\"%s\"}}",
+                          removed, removed);
+    } else {
+        g_hash_table_iter_init(&iter, server.ports);
+        while (g_hash_table_iter_next(&iter, (void **) &name, NULL))
+            virBufferAsprintf(&buf, "\"Interface-%s\":{\"new\":{\"name\":\"%s\"}},",
+                              name, name);
+        virBufferTrim(&buf, ",");
+    }
+    virBufferAddLit(&buf, "},");
+
+    virBufferAsprintf(&buf, "\"Open_vSwitch\":{\"ovs\":{\"new\":{\"cur_cfg\":%lld}}}}",
+                      server.cfg);
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+static const char *
+testServerOpName(virJSONValue *op)
+{
+    virJSONValue *where = virJSONValueObjectGetArray(op, "where");
+    virJSONValue *cond;
+    virJSONValue *row;
+
+    if (where && (cond = virJSONValueArrayGet(where, 0)))
+        return virJSONValueGetString(virJSONValueArrayGet(cond, 2));
+
+    if ((row = virJSONValueObjectGetObject(op, "row")))
+        return virJSONValueObjectGetString(row, "name");
+
+    return NULL;
+}
+
+
+static char *
+testServerTransact(int fd,
+                   virJSONValue *params)
+{
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_autofree char *inserted = NULL;
+    g_autofree char *added = NULL;
+    g_autofree char *removed = NULL;
+    bool failed = false;
+    bool bump = false;
+    size_t i;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&server.lock) {
+        g_free(server.last);
+        server.last = virJSONValueToString(params, false);
+        server.ntransact++;
+    }
+
+    virBufferAddLit(&buf, "[");
+
+    for (i = 1; i < virJSONValueArraySize(params); i++) {
+        virJSONValue *op = virJSONValueArrayGet(params, i);
+        const char *type = virJSONValueObjectGetString(op, "op");
+        const char *table = virJSONValueObjectGetString(op, "table");
+        const char *name = testServerOpName(op);
+
+        if (failed) {
+            virBufferAddLit(&buf, "null,");
+            continue;
+        }
+
+        if (STREQ(type, "insert")) {
+            if (STREQ(name, "fail0")) {
+                virBufferAddLit(&buf, "{\"error\":\"constraint violation\","
+                                "\"details\":\"duplicate name\"},");
+                failed = true;
+                continue;
+            }
+
+            if (STREQ(table, "Port")) {
+                g_free(inserted);
+                inserted = g_strdup(name);
+            }
+
+            virBufferAsprintf(&buf, "{\"uuid\":[\"uuid\",\"%s-%s\"]},",
+                              table, name);
+        } else if (STREQ(type, "mutate")) {
+            virJSONValue *mutation;
+            const char *mutator;
+            const char *uuid;
+
+            if (STREQ(table, "Open_vSwitch")) {
+                bump = true;
+                virBufferAddLit(&buf, "{\"count\":1},");
+                continue;
+            }
+
+            if (STRNEQ(table, "Bridge") || STRNEQ(name, "br0")) {
+                virBufferAddLit(&buf, "{\"count\":0},");
+                continue;
+            }
+
+            mutation = virJSONValueArrayGet(virJSONValueObjectGetArray(op, "mutations"), 0);
+            mutator = virJSONValueGetString(virJSONValueArrayGet(mutation, 1));
+            uuid = virJSONValueGetString(virJSONValueArrayGet(virJSONValueArrayGet(virJSONValueArrayGet(virJSONValueArrayGet(mutation, 2), 1), 0), 1));
+
+            /* ports not referenced by a bridge are garbage collected */
+            if (STREQ(mutator, "insert"))
+                added = g_steal_pointer(&inserted);
+            else if (STREQ(mutator, "delete") && STRPREFIX(uuid, "Port-"))
+                removed = g_strdup(uuid + strlen("Port-"));
+
+            virBufferAddLit(&buf, "{\"count\":1},");
+        } else if (STREQ(type, "select")) {
+            if (STREQ(table, "Open_vSwitch")) {
+                virBufferAsprintf(&buf, "{\"rows\":[{\"next_cfg\":%lld}]},",
+                                  server.cfg + (bump ? 1 : 0));
+            } else if (STREQ_NULLABLE(name, "vnet0")) {
+                virBufferAddLit(&buf, "{\"rows\":[{\"statistics\":[\"map\","
+                                "[[\"rx_bytes\",10],[\"rx_packets\",1],"
+                                "[\"tx_bytes\",20],[\"tx_packets\",2]]]}]},");
+            } else {
+                virBufferAddLit(&buf, "{\"rows\":[]},");
+            }
+        } else if (STREQ(type, "update")) {
+            virBufferAsprintf(&buf, "{\"count\":%d},",
+                              g_hash_table_contains(server.ports, name));
+        } else {
+            virBufferAddLit(&buf, "{},");
+        }
+    }
+
+    virBufferTrim(&buf, ",");
+    virBufferAddLit(&buf, "]");
+
+    if (failed)
+        return virBufferContentAndReset(&buf);
+
+    if (added)
+        g_hash_table_add(server.ports, g_strdup(added));
+    if (removed)
+        g_hash_table_remove(server.ports, removed);
+    if (bump)
+        server.cfg++;
+
+    /* Like a real ovsdb-server, tell the client about the changes. Do so
+     * before replying so that the tests don't depend on timing. */
+    if (added || removed || bump) {
+        g_autofree char *updates = testServerFormatUpdates(added, removed);
+        g_autofree char *msg = NULL;
+
+        msg = g_strdup_printf("{\"method\":\"update\",\"params\":[null,%s],\"id\":null}",
+                              updates);
+        if (testServerSend(fd, msg) < 0)
+            return NULL;
+    }
+
+    return virBufferContentAndReset(&buf);
+}
+
+
+static int
+testServerHandle(int fd,
+                 virJSONValue *msg)
+{
+    const char *method = virJSONValueObjectGetString(msg, "method");
+    virJSONValue *params = virJSONValueObjectGetArray(msg, "params");
+    g_autofree char *id = NULL;
+    g_autofree char *result = NULL;
+    g_autofree char *reply = NULL;
+
+    if (!method) {
+        if (STREQ_NULLABLE(virJSONValueObjectGetString(msg, "id"), "echo")) {
+            VIR_WITH_MUTEX_LOCK_GUARD(&server.lock) {
+                server.echoed = true;
+            }
+        }
+        return 0;
+    }
+
+    if (!(id = virJSONValueToString(virJSONValueObjectGet(msg, "id"), false)))
+        return -1;
+
+    if (STREQ(method, "monitor"))
+        result = testServerFormatUpdates(NULL, NULL);
+    else if (STREQ(method, "transact"))
+        result = testServerTransact(fd, params);
+
+    if (!result)
+        return -1;
+
+    reply = g_strdup_printf("{\"id\":%s,\"result\":%s,\"error\":null}", id, result);
+    if (testServerSend(fd, reply) < 0)
+        return -1;
+
+    /* make sure the client answers keepalive probes */
+    if (STREQ(method, "monitor") &&
+        testServerSend(fd, "{\"method\":\"echo\",\"params\":[],\"id\":\"echo\"}") < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static void
+testServerClose(size_t i)
+{
+    VIR_FORCE_CLOSE(server.fds[i]);
+    g_string_truncate(server.bufs[i], 0);
+}
+
+
+static void
+testServerMain(void *opaque G_GNUC_UNUSED)
+{
+    while (true) {
+        struct pollfd pfds[TEST_MAX_CONNS + 1] = { 0 };
+        size_t i;
+
+        pfds[0].fd = server.listenfd;
+        pfds[0].events = POLLIN;
+        for (i = 0; i < TEST_MAX_CONNS; i++) {
+            pfds[i + 1].fd = server.fds[i];
+            pfds[i + 1].events = POLLIN;
+        }
+
+        if (poll(pfds, G_N_ELEMENTS(pfds), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(server.listenfd, NULL, NULL);
+
+            for (i = 0; fd >= 0 && i < TEST_MAX_CONNS; i++) {
+                if (server.fds[i] < 0) {
+                    server.fds[i] = fd;
+                    fd = -1;
+                }
+            }
+            VIR_FORCE_CLOSE(fd);
+        }
+
+        for (i = 0; i < TEST_MAX_CONNS; i++) {
+            char buf[4096];
+            ssize_t got;
+            size_t len;
+
+            if (server.fds[i] < 0 || !pfds[i + 1].revents)
+                continue;
+
+            if ((got = read(server.fds[i], buf, sizeof(buf))) <= 0) {
+                testServerClose(i);
+                continue;
+            }
+
+            g_string_append_len(server.bufs[i], buf, got);
+
+            while ((len = virOVSDBSplitMessage(server.bufs[i]->str,
+                                               server.bufs[i]->len)) > 0) {
+                g_autofree char *str = g_strndup(server.bufs[i]->str, len);
+                g_autoptr(virJSONValue) msg = NULL;
+
+                g_string_erase(server.bufs[i], 0, len);
+
+                if (!(msg = virJSONValueFromString(str)) ||
+                    testServerHandle(server.fds[i], msg) < 0) {
+                    testServerClose(i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+static int
+testServerStart(const char *dir)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    virThread thread;
+    size_t i;
+
+    sockpath = g_strdup_printf("%s/db.sock", dir);
+
+    if (virMutexInit(&server.lock) < 0)
+        return -1;
+
+    server.ports = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    g_hash_table_add(server.ports, g_strdup("vnet0"));
+    server.cfg = 1;
+
+    for (i = 0; i < TEST_MAX_CONNS; i++) {
+        server.fds[i] = -1;
+        server.bufs[i] = g_string_new(NULL);
+    }
+
+    if (virStrcpyStatic(addr.sun_path, sockpath) < 0 ||
+        (server.listenfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(server.listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server.listenfd, TEST_MAX_CONNS) < 0)
+        return -1;
+
+    /* the server lives until the test exits */
+    if (virThreadCreate(&thread, false, testServerMain, NULL) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testCheckLast(const char *expect)
+{
+    g_autofree char *last = NULL;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&server.lock) {
+        last = g_strdup(server.last);
+    }
+
+    if (STRNEQ_NULLABLE(last, expect)) {
+        virTestDifference(stderr, expect, NULLSTR(last));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+struct testSplitData {
+    const char *buf;
+    size_t len;
+};
+
+static int
+testSplit(const void *opaque)
+{
+    const struct testSplitData *data = opaque;
+    size_t len = virOVSDBSplitMessage(data->buf, strlen(data->buf));
+
+    if (len != data->len) {
+        fprintf(stderr, "'%s': expected %zu, got %zu\n",
+                data->buf, data->len, len);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testUnreachable(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virOVSDBClient) client = NULL;
+    g_autoptr(virJSONValue) ops = virJSONValueNewArray();
+    g_autofree char *brname = NULL;
+
+    if (!(client = virOVSDBClientNew("/nonexistent/db.sock")))
+        return -1;
+
+    if (virOVSDBGetPort(client, "vnet0", NULL, &brname) != -2 ||
+        virOVSDBTransact(client, &ops, 0, NULL) != -2)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testLookup(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virOVSDBClient) client = NULL;
+    g_autofree char *portuuid = NULL;
+    g_autofree char *brname = NULL;
+    g_autofree char *master = NULL;
+
+    if (!(client = virOVSDBClientNew(sockpath)))
+        return -1;
+
+    if (virOVSDBGetPort(client, "vnet0", &portuuid, &brname) != 1 ||
+        STRNEQ(portuuid, "Port-vnet0") ||
+        STRNEQ(brname, "br0"))
+        return -1;
+
+    if (virOVSDBGetInterfaceBridge(client, "vnet0", &master) != 1 ||
+        STRNEQ(master, "br0"))
+        return -1;
+
+    g_clear_pointer(&master, g_free);
+    if (virOVSDBGetPort(client, "vnet9", NULL, NULL) != 0 ||
+        virOVSDBGetInterfaceBridge(client, "vnet9", &master) != 0 ||
+        master)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testEcho(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virOVSDBClient) client = NULL;
+    bool echoed = false;
+    size_t i;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&server.lock) {
+        server.echoed = false;
+    }
+
+    if (!(client = virOVSDBClientNew(sockpath)))
+        return -1;
+
+    /* the first lookup connects, the second one answers the probe */
+    for (i = 0; i < 50 && !echoed; i++) {
+        if (virOVSDBGetPort(client, "vnet0", NULL, NULL) != 1)
+            return -1;
+
+        g_usleep(10 * 1000);
+
+        VIR_WITH_MUTEX_LOCK_GUARD(&server.lock) {
+            echoed = server.echoed;
+        }
+    }
+
+    return echoed ? 0 : -1;
+}
+
+
+static int
+testAddRemovePort(const void *opaque G_GNUC_UNUSED)
+{
+    virNetDevVPortProfile ovsport = { 0 };
+    virMacAddr mac;
+    unsigned char vmuuid[VIR_UUID_BUFLEN];
+    g_autofree char *master = NULL;
+    const char *expectAdd =
+        "[\"Open_vSwitch\","
+        "{\"op\":\"insert\",\"table\":\"Interface\","
+        "\"row\":{\"name\":\"vnet1\",\"external_ids\":[\"map\",["
+        "[\"attached-mac\",\"52:54:00:11:22:33\"],"
+        "[\"iface-id\",\"e8b6f3e4-8a85-4dd1-9b35-0d4d4dbb4b28\"],"
+        "[\"vm-id\",\"c7a5fdbd-cdaf-9455-926a-d65c16db1809\"],"
+        "[\"iface-status\",\"active\"]]]},"
+        "\"uuid-name\":\"libvirt_row0\"},"
+        "{\"op\":\"insert\",\"table\":\"Port\","
+        "\"row\":{\"name\":\"vnet1\",\"interfaces\":[\"named-uuid\",\"libvirt_row0\"],"
+        "\"tag\":42},"
+        "\"uuid-name\":\"libvirt_row1\"},"
+        "{\"op\":\"mutate\",\"table\":\"Bridge\",\"where\":[[\"name\",\"==\",\"br0\"]],"
+        "\"mutations\":[[\"ports\",\"insert\",[\"set\",[[\"named-uuid\",\"libvirt_row1\"]]]]]},"
+        WAIT_OPS "]";
+    const char *expectRemove =
+        "[\"Open_vSwitch\","
+        "{\"op\":\"mutate\",\"table\":\"Bridge\",\"where\":[[\"name\",\"==\",\"br0\"]],"
+        "\"mutations\":[[\"ports\",\"delete\",[\"set\",[[\"uuid\",\"Port-vnet1\"]]]]]},"
+        WAIT_OPS "]";
+    unsigned int tags[] = { 42 };
+    virNetDevVlan vlan = { .nTags = 1, .tag = tags };
+
+    if (virMacAddrParse("52:54:00:11:22:33", &mac) < 0 ||
+        virUUIDParse("c7a5fdbd-cdaf-9455-926a-d65c16db1809", vmuuid) < 0 ||
+        virUUIDParse("e8b6f3e4-8a85-4dd1-9b35-0d4d4dbb4b28", ovsport.interfaceID) < 0)
+        return -1;
+
+    if (virNetDevOpenvswitchAddPort("br0", "vnet1", &mac, vmuuid,
+                                    &ovsport, &vlan) < 0 ||
+        testCheckLast(expectAdd) < 0)
+        return -1;
+
+    if (virNetDevOpenvswitchInterfaceGetMaster("vnet1", &master) < 0 ||
+        STRNEQ_NULLABLE(master, "br0"))
+        return -1;
+
+    g_clear_pointer(&master, g_free);
+
+    if (virNetDevOpenvswitchRemovePort("br0", "vnet1") < 0 ||
+        testCheckLast(expectRemove) < 0)
+        return -1;
+
+    if (virNetDevOpenvswitchInterfaceGetMaster("vnet1", &master) < 0 ||
+        master)
+        return -1;
+
+    /* --if-exists */
+    if (virNetDevOpenvswitchRemovePort("br0", "vnet1") < 0 ||
+        testCheckLast(expectRemove) < 0)
+        return -1;
+
+    if (virNetDevOpenvswitchAddPort("br9", "vnet1", &mac, vmuuid,
+                                    &ovsport, NULL) == 0) {
+        fprintf(stderr, "adding port to a missing bridge succeeded\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testUpdateVlan(const void *opaque G_GNUC_UNUSED)
+{
+    unsigned int tags[] = { 10, 20 };
+    virNetDevVlan vlan = {
+        .trunk = true,
+        .nTags = 2,
+        .tag = tags,
+        .nativeMode = VIR_NATIVE_VLAN_MODE_TAGGED,
+        .nativeTag = 10,
+    };
+    const char *expectTrunk =
+        "[\"Open_vSwitch\","
+        "{\"op\":\"update\",\"table\":\"Port\",\"where\":[[\"name\",\"==\",\"vnet0\"]],"
+        "\"row\":{\"vlan_mode\":\"native-tagged\",\"tag\":10,\"trunks\":[\"set\",[10,20]]}},"
+        WAIT_OPS "]";
+    const char *expectClear =
+        "[\"Open_vSwitch\","
+        "{\"op\":\"update\",\"table\":\"Port\",\"where\":[[\"name\",\"==\",\"vnet0\"]],"
+        "\"row\":{\"tag\":[\"set\",[]],\"trunks\":[\"set\",[]],\"vlan_mode\":[\"set\",[]]}},"
+        WAIT_OPS "]";
+
+    if (virNetDevOpenvswitchUpdateVlan("vnet0", &vlan) < 0 ||
+        testCheckLast(expectTrunk) < 0)
+        return -1;
+
+    if (virNetDevOpenvswitchUpdateVlan("vnet0", NULL) < 0 ||
+        testCheckLast(expectClear) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testInterfaceStats(const void *opaque G_GNUC_UNUSED)
+{
+    virDomainInterfaceStatsStruct stats = { 0 };
+
+    if (virNetDevOpenvswitchInterfaceStats("vnet0", &stats) < 0)
+        return -1;
+
+    /* RX and TX are swapped because these are the host's view */
+    if (stats.rx_bytes != 20 || stats.rx_packets != 2 ||
+        stats.tx_bytes != 10 || stats.tx_packets != 1 ||
+        stats.rx_errs != -1 || stats.tx_drop != -1) {
+        fprintf(stderr, "unexpected statistics\n");
+        return -1;
+    }
+
+    if (virNetDevOpenvswitchInterfaceStats("vnet9", &stats) == 0) {
+        fprintf(stderr, "got statistics of a missing interface\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+struct testConcurrentData {
+    virOVSDBClient *client;
+    char *name;
+    int ret;
+};
+
+static void
+testConcurrentWorker(void *opaque)
+{
+    struct testConcurrentData *data = opaque;
+    g_autoptr(virJSONValue) ops = NULL;
+    g_autoptr(virJSONValue) results = NULL;
+    g_autofree char *str = NULL;
+    g_autofree char *expect = NULL;
+
+    str = g_strdup_printf("[{\"op\":\"insert\",\"table\":\"Interface\","
+                          "\"row\":{\"name\":\"%s\"}}]", data->name);
+
+    data->ret = -1;
+
+    if (!(ops = virJSONValueFromString(str)) ||
+        virOVSDBTransact(data->client, &ops, VIR_OVSDB_TRANSACT_WAIT,
+                         &results) < 0)
+        return;
+
+    g_free(str);
+    expect = g_strdup_printf("[{\"uuid\":[\"uuid\",\"Interface-%s\"]}]", data->name);
+
+    if (!(str = virJSONValueToString(results, false)) ||
+        STRNEQ(str, expect)) {
+        fprintf(stderr, "%s: expected %s, got %s\n",
+                data->name, expect, NULLSTR(str));
+        return;
+    }
+
+    data->ret = 0;
+}
+
+
+/* A failing request must not fail others it was merged with, and each
+ * caller must get back the results of its own operations. */
+static int
+testConcurrent(const void *opaque G_GNUC_UNUSED)
+{
+    g_autoptr(virOVSDBClient) client = NULL;
+    struct testConcurrentData data[16] = { 0 };
+    virThread threads[16];
+    int ret = 0;
+    size_t i;
+
+    if (!(client = virOVSDBClientNew(sockpath)))
+        return -1;
+
+    for (i = 0; i < G_N_ELEMENTS(data); i++) {
+        data[i].client = client;
+        data[i].name = i == 5 ? g_strdup("fail0") : g_strdup_printf("if%zu", i);
+
+        if (virThreadCreate(&threads[i], true, testConcurrentWorker, &data[i]) < 0)
+            return -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(data); i++) {
+        virThreadJoin(&threads[i]);
+
+        if ((i == 5) != (data[i].ret < 0)) {
+            fprintf(stderr, "%s: unexpected result %d\n", data[i].name, data[i].ret);
+            ret = -1;
+        }
+
+        g_free(data[i].name);
+    }
+
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+    g_autofree char *dir = g_strdup("/tmp/virovsdbtest-XXXXXX");
+
+    if (!g_mkdtemp(dir)) {
+        fprintf(stderr, "Cannot create temporary directory\n");
+        return EXIT_FAILURE;
+    }
+
+    /* picked up by virOVSDBGetDefault() */
+    g_setenv("OVS_RUNDIR", dir, TRUE);
+
+    if (testServerStart(dir) < 0) {
+        fprintf(stderr, "Cannot start fake ovsdb-server\n");
+        ret = -1;
+        goto cleanup;
+    }
+
+# define DO_TEST_SPLIT(buf, len) \
+    do { \
+        struct testSplitData data = { buf, len }; \
+        if (virTestRun("Split " buf, testSplit, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST_SPLIT("{}", 2);
+    DO_TEST_SPLIT("  {} ", 4);
+    DO_TEST_SPLIT("{\"a\":[1,{\"b\":2}]}{\"c\":3}", 17);
+    DO_TEST_SPLIT("{\"a\":\"}\"}{", 9);
+    DO_TEST_SPLIT("{\"a\":\"\\\"}\"}", 11);
+    DO_TEST_SPLIT("{\"a\":[1,2", 0);
+    DO_TEST_SPLIT("{\"a\":\"}", 0);
+
+# define DO_TEST(name, func) \
+    if (virTestRun(name, func, NULL) < 0) \
+        ret = -1;
+
+    DO_TEST("Unreachable server", testUnreachable);
+    DO_TEST("Lookup", testLookup);
+    DO_TEST("Echo", testEcho);
+    /* these depend on the order uuid-names are handed out in */
+    DO_TEST("Add and remove port", testAddRemovePort);
+    DO_TEST("Update VLAN", testUpdateVlan);
+    DO_TEST("Interface stats", testInterfaceStats);
+    DO_TEST("Concurrent transactions", testConcurrent);
+
+ cleanup:
+    if (sockpath)
+        unlink(sockpath);
+    rmdir(dir);
+    g_free(sockpath);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#endif /* WIN32 */
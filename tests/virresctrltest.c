@@ -65,6 +65,67 @@ test_virResctrlGetUnused(const void *opaque)
 }
 
 
+static virResctrlMonitorStats *
+testResctrlMonitorStatsNew(unsigned int id,
+                           unsigned long long occupancy,
+                           unsigned long long total)
+{
+    virResctrlMonitorStats *stat = g_new0(virResctrlMonitorStats, 1);
+    const char *features[] = { "llc_occupancy", "mbm_total_bytes", NULL };
+
+    stat->id = id;
+    stat->features = g_strdupv((char **) features);
+    stat->nvals = 2;
+    stat->vals = g_new0(unsigned long long, stat->nvals);
+    stat->vals[0] = occupancy;
+    stat->vals[1] = total;
+
+    return stat;
+}
+
+
+static int
+test_virResctrlMonitorRates(const void *opaque G_GNUC_UNUSED)
+{
+    virResctrlMonitorStats *prev[2] = { NULL };
+    virResctrlMonitorStats *cur[3] = { NULL };
+    const unsigned long long expected[][2] = {
+        { 0, 2000 },  /* 4000 bytes in 2 seconds */
+        { 0, 0 },     /* counter reset */
+        { 0, 0 },     /* no previous record */
+    };
+    int ret = -1;
+    size_t i;
+
+    prev[0] = testResctrlMonitorStatsNew(0, 1000, 1000);
+    prev[1] = testResctrlMonitorStatsNew(1, 1000, 9000);
+
+    cur[0] = testResctrlMonitorStatsNew(0, 5000, 5000);
+    cur[1] = testResctrlMonitorStatsNew(1, 2000, 100);
+    cur[2] = testResctrlMonitorStatsNew(2, 3000, 3000);
+
+    virResctrlMonitorStatsComputeRates(prev, G_N_ELEMENTS(prev),
+                                       cur, G_N_ELEMENTS(cur), 2000);
+
+    for (i = 0; i < G_N_ELEMENTS(cur); i++) {
+        if (!cur[i]->rates ||
+            cur[i]->rates[0] != expected[i][0] ||
+            cur[i]->rates[1] != expected[i][1]) {
+            VIR_TEST_DEBUG("Unexpected rates for record %zu", i);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+ cleanup:
+    for (i = 0; i < G_N_ELEMENTS(prev); i++)
+        virResctrlMonitorStatsFree(prev[i]);
+    for (i = 0; i < G_N_ELEMENTS(cur); i++)
+        virResctrlMonitorStatsFree(cur[i]);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -83,6 +144,9 @@ mymain(void)
     DO_TEST_UNUSED("resctrl-skx");
     DO_TEST_UNUSED("resctrl-skx-twocaches");
 
+    if (virTestRun("Monitor rates", test_virResctrlMonitorRates, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
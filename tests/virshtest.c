@@ -407,6 +407,41 @@ Domain: 'fc4'\n\
     return testCompareOutputLit(exp, NULL, argv);
 }
 
+static int testDomstatsXML(const void *data G_GNUC_UNUSED)
+{
+    const char *const dumpxml[] = { VIRSH_CUSTOM, "dumpxml", "fc4", NULL };
+    const char *const argv[] = { VIRSH_CUSTOM, "domstats --xml --state fc4;\
+                                 domstats fc4", NULL };
+    g_autoptr(virCommand) cmd = virCommandNewArgs(dumpxml);
+    g_autofree char *xml = NULL;
+    g_autofree char *exp = NULL;
+
+    virCommandAddEnvString(cmd, "LANG=C");
+    virCommandSetOutputBuffer(cmd, &xml);
+
+    if (virCommandRun(cmd, NULL) < 0)
+        return -1;
+
+    /* the XML is only reported if asked for */
+    exp = g_strdup_printf("\
+Domain: 'fc4'\n\
+  state.state" EQUAL "1\n\
+  state.reason" EQUAL "0\n\
+  xml" EQUAL "%s\n\
+Domain: 'fc4'\n\
+  state.state" EQUAL "1\n\
+  state.reason" EQUAL "0\n\
+  iothread.count" EQUAL "2\n\
+  iothread.2.poll-max-ns" EQUAL "32768\n\
+  iothread.2.poll-grow" EQUAL "0\n\
+  iothread.2.poll-shrink" EQUAL "0\n\
+  iothread.4.poll-max-ns" EQUAL "32768\n\
+  iothread.4.poll-grow" EQUAL "0\n\
+  iothread.4.poll-shrink" EQUAL "0\n\n", xml);
+
+    return testCompareOutputLit(exp, NULL, argv);
+}
+
 static int testIOThreadPin(const void *data G_GNUC_UNUSED)
 {
     const char *const argv[] = { VIRSH_CUSTOM,
@@ -544,6 +579,10 @@ mymain(void)
                    testIOThreadPin, NULL) != 0)
         ret = -1;
 
+    if (virTestRun("virsh domstats --xml",
+                   testDomstatsXML, NULL) != 0)
+        ret = -1;
+
     /* It's a bit awkward listing result before argument, but that's a
      * limitation of C99 vararg macros.  */
 # define DO_TEST(i, result, ...) \
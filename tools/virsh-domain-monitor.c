@@ -2002,6 +2002,10 @@ static const vshCmdOptDef opts_domstats[] = {
      .type = VSH_OT_BOOL,
      .help = N_("report hypervisor-specific statistics"),
     },
+    {.name = "xml",
+     .type = VSH_OT_BOOL,
+     .help = N_("report domain XML description"),
+    },
     {.name = "list-active",
      .type = VSH_OT_BOOL,
      .help = N_("list only active domains"),
@@ -2131,6 +2135,9 @@ cmdDomstats(vshControl *ctl, const vshCmd *cmd)
     if (vshCommandOptBool(cmd, "vm"))
         stats |= VIR_DOMAIN_STATS_VM;
 
+    if (vshCommandOptBool(cmd, "xml"))
+        stats |= VIR_DOMAIN_STATS_XML;
+
     if (vshCommandOptBool(cmd, "list-active"))
         flags |= VIR_CONNECT_GET_ALL_DOMAINS_STATS_ACTIVE;
 
@@ -1496,14 +1496,34 @@ cmdNodeMemoryTune(vshControl *ctl, const vshCmd *cmd)
             goto cleanup;
         }
 
-        /* XXX: Need to sort the returned params once new parameter
-         * fields not of shared memory are added.
-         */
         vshPrint(ctl, _("Shared memory:\n"));
         for (i = 0; i < nparams; i++) {
-            g_autofree char *str = vshGetTypedParamValue(ctl, &params[i]);
+            g_autofree char *str = NULL;
+
+            if (!STRPREFIX(params[i].field, "shm_"))
+                continue;
+
+            str = vshGetTypedParamValue(ctl, &params[i]);
             vshPrint(ctl, "\t%-15s %s\n", params[i].field, str);
         }
+
+        for (i = 0; i < nparams; i++) {
+            if (STRPREFIX(params[i].field, "hugepages_"))
+                break;
+        }
+
+        if (i < nparams) {
+            vshPrint(ctl, _("Huge pages:\n"));
+            for (; i < nparams; i++) {
+                g_autofree char *str = NULL;
+
+                if (!STRPREFIX(params[i].field, "hugepages_"))
+                    continue;
+
+                str = vshGetTypedParamValue(ctl, &params[i]);
+                vshPrint(ctl, "\t%-22s %s\n", params[i].field, str);
+            }
+        }
     } else {
         if (virNodeSetMemoryParameters(priv->conn, params, nparams, flags) != 0)
             goto error;